@@ -1,6 +1,32 @@
 --- u-boot-2013.07/net/tftp.c	2013-12-13 13:49:25.236958498 -0500
 +++ uboot.new/net/tftp.c	2013-12-05 12:17:54.975503948 -0500
-@@ -165,10 +165,14 @@
+@@ -130,6 +130,25 @@
+ static unsigned short TftpBlkSize = TFTP_BLOCK_SIZE;
+ static unsigned short TftpBlkSizeOption = TFTP_MTU_BLOCKSIZE;
+ 
++/* windowsize option (RFC 7440): the server sends this many blocks per ACK */
++#ifdef CONFIG_TFTP_WINDOWSIZE
++#define TFTP_WINDOWSIZE CONFIG_TFTP_WINDOWSIZE
++#else
++#define TFTP_WINDOWSIZE 1
++#endif
++
++static unsigned short TftpWindowSize = 1;
++static unsigned short TftpWindowSizeOption = TFTP_WINDOWSIZE;
++/* blocks received since the last ACK */
++static unsigned short TftpWindowCount;
++/* a gap was ACKed, wait for the server to resend from TftpLastBlock */
++static int TftpWindowGap;
++
++/* CRC32 of the image, folded in by store_block while blocks arrive in order */
++ulong TftpCrc32;
++ulong TftpCrcSize;
++int TftpCrcValid;
++
+ #ifdef CONFIG_MCAST_TFTP
+ #include <malloc.h>
+ #define MTFTP_BITMAPSIZE	0x1000
+@@ -165,10 +184,14 @@
  	int i, rc = 0;
  
  	for (i = 0; i < CONFIG_SYS_MAX_FLASH_BANKS; i++) {
@@ -16,7 +42,32 @@
  			rc = 1;
  			break;
  		}
-@@ -303,8 +307,9 @@
+@@ -191,6 +214,12 @@
+ 		ext2_set_bit(block, Bitmap);
+ #endif
+ 
++	if (TftpCrcValid && offset == TftpCrcSize) {
++		TftpCrc32 = crc32(TftpCrc32, src, len);
++		TftpCrcSize += len;
++	} else
++		TftpCrcValid = 0;
++
+ 	if (NetBootFileXferSize < newsize)
+ 		NetBootFileXferSize = newsize;
+ }
+@@ -201,6 +230,11 @@
+ 	TftpLastBlock = 0;
+ 	TftpBlockWrap = 0;
+ 	TftpBlockWrapOffset = 0;
++	TftpWindowCount = 0;
++	TftpWindowGap = 0;
++	TftpCrc32 = 0;
++	TftpCrcSize = 0;
++	TftpCrcValid = 1;
+ #ifdef CONFIG_CMD_TFTPPUT
+ 	TftpFinalBlock = 0;
+ #endif
+@@ -303,9 +337,15 @@
  	time_start = get_timer(time_start);
  	if (time_start > 0) {
  		puts("\n\t ");	/* Line up with "Loading: " */
@@ -25,6 +76,111 @@
 +//		print_size(NetBootFileXferSize /
 +//			time_start * 1000, "/s");
 +		print_size(NetBootFileXferSize, "");
++		printf(" in %lu ms, %lu KiB/s, %d byte blocks, window %d",
++			time_start, (NetBootFileXferSize / time_start) * 1000 / 1024,
++			TftpBlkSize, TftpWindowSize);
  	}
++	if (TftpCrcValid && TftpCrcSize)
++		printf("\n\t CRC32 0x%08lx", TftpCrc32);
  	puts("\ndone\n");
  	net_set_state(NETLOOP_SUCCESS);
+ }
+@@ -359,6 +399,10 @@
+ 		/* try for more effic. blk size */
+ 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
+ 				0, TftpBlkSizeOption, 0);
++		/* ask for a window of blocks per ACK; reads only */
++		if (TftpState == STATE_SEND_RRQ && TftpWindowSizeOption > 1)
++			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
++					0, TftpWindowSizeOption, 0);
+ #ifdef CONFIG_MCAST_TFTP
+ 		/* Check all preconditions before even trying the option */
+ 		if (!ProhibitMcast) {
+@@ -390,6 +434,7 @@
+ 		s[0] = htons(TFTP_ACK);
+ 		s[1] = htons(TftpBlock);
+ 		pkt = (uchar *)(s + 2);
++		TftpWindowCount = 0;
+ #ifdef CONFIG_CMD_TFTPPUT
+ 		if (TftpWriting) {
+ 			int toload = TftpBlkSize;
+@@ -528,6 +573,18 @@
+ 				debug("Blocksize ack: %s, %d\n",
+ 					(char *)pkt+i+8, TftpBlkSize);
+ 			}
++			if (i+11 < len &&
++			    strcmp((char *)pkt+i, "windowsize") == 0) {
++				TftpWindowSize = (unsigned short)
++					simple_strtoul((char *)pkt+i+11, NULL,
++						       10);
++				/* the server may shrink the window, not grow it */
++				if (TftpWindowSize < 1 ||
++				    TftpWindowSize > TftpWindowSizeOption)
++					TftpWindowSize = 1;
++				debug("Windowsize ack: %s, %d\n",
++					(char *)pkt+i+11, TftpWindowSize);
++			}
+ #ifdef CONFIG_TFTP_TSIZE
+ 			if (strcmp((char *)pkt+i, "tsize") == 0) {
+ 				TftpTsize = simple_strtoul((char *)pkt+i+6,
+@@ -558,6 +615,29 @@
+ 		len -= 2;
+ 		TftpBlock = ntohs(*(__be16 *)pkt);
+ 
++		/*
++		 * A block out of sequence inside a window means the ones
++		 * before it were lost: ACK the last block we have so the
++		 * server resends from there (RFC 7440), once per gap.
++		 */
++		if (TftpWindowSize > 1 &&
++		    (TftpState == STATE_OACK || TftpState == STATE_DATA)) {
++			ulong expect = 1;
++
++			if (TftpState == STATE_DATA)
++				expect = (TftpLastBlock + 1) & 0xffff;
++			if (TftpBlock != expect &&
++			    TftpBlock != ((expect - 1) & 0xffff)) {
++				TftpBlock = (expect - 1) & 0xffff;
++				if (!TftpWindowGap) {
++					TftpWindowGap = 1;
++					TftpSend();
++				}
++				break;
++			}
++		}
++		TftpWindowGap = 0;
++
+ 		update_block_number();
+ 
+ 		if (TftpState == STATE_SEND_RRQ)
+@@ -627,7 +707,9 @@
+ 			}
+ 		}
+ #endif
+-		TftpSend();
++		/* one ACK per window, and always for the last block */
++		if (++TftpWindowCount >= TftpWindowSize || len < TftpBlkSize)
++			TftpSend();
+ 
+ #ifdef CONFIG_MCAST_TFTP
+ 		if (Multicast) {
+@@ -697,6 +779,10 @@
+ 	if (ep != NULL)
+ 		TftpBlkSizeOption = simple_strtol(ep, NULL, 10);
+ 
++	ep = getenv("tftpwindowsize");
++	if (ep != NULL)
++		TftpWindowSizeOption = simple_strtol(ep, NULL, 10);
++
+ 	ep = getenv("tftptimeout");
+ 	if (ep != NULL)
+ 		TftpTimeoutMSecs = simple_strtol(ep, NULL, 10);
+@@ -809,6 +895,8 @@
+ 	memset(NetServerEther, 0, 6);
+ 	/* Revert TftpBlkSize to dflt */
+ 	TftpBlkSize = TFTP_BLOCK_SIZE;
++	TftpWindowSize = 1;
++	TftpWindowGap = 0;
+ #ifdef CONFIG_MCAST_TFTP
+ 	mcast_cleanup();
+ #endif
@@ -1,6 +1,6 @@
 --- uboot_old/oem/ami/fwupdate/fwupdate.c	1970-01-01 05:30:00.000000000 +0530
 +++ uboot/oem/ami/fwupdate/fwupdate.c	2017-08-16 15:11:53.769027601 +0530
-@@ -0,0 +1,685 @@
+@@ -0,0 +1,763 @@
 +/*****************************************************************
 + *****************************************************************
 + ***                                                            **
@@ -187,15 +187,16 @@
 +    FMH     *pFMH = NULL;
 +    MODULE_INFO *pmod = NULL;
 +    char        sectionname[10] = {0}, conffound = 0;
-+    unsigned char   *TempBuf = (unsigned char *)YAFU_TEMP_SECTOR_BUFFER;
++    unsigned char   *SectorBuf;
 +    int i,ret = -1;
 +
 +    for(i = 0; i < (CONFIG_SPX_FEATURE_GLOBAL_USED_FLASH_SIZE/CONFIG_SPX_FEATURE_GLOBAL_ERASE_BLOCK_SIZE); i++)
 +    {
-+        memcpy(TempBuf, (unsigned char *)(YAFU_IMAGE_UPLOAD_LOCATION + (i * CONFIG_SPX_FEATURE_GLOBAL_ERASE_BLOCK_SIZE)),CONFIG_SPX_FEATURE_GLOBAL_ERASE_BLOCK_SIZE);
++        /*The image is in RAM already, scan it in place*/
++        SectorBuf = (unsigned char *)(YAFU_IMAGE_UPLOAD_LOCATION + (i * CONFIG_SPX_FEATURE_GLOBAL_ERASE_BLOCK_SIZE));
 +
 +        /*Locate the FMH Section*/
-+        pFMH = ScanforFMH_RAM(TempBuf,CONFIG_SPX_FEATURE_GLOBAL_ERASE_BLOCK_SIZE);
++        pFMH = ScanforFMH_RAM(SectorBuf,CONFIG_SPX_FEATURE_GLOBAL_ERASE_BLOCK_SIZE);
 +        if(pFMH != NULL)
 +        {
 +            /*Get the Module Information*/
@@ -223,6 +224,19 @@
 +    return ret;
 +}
 +
++/* Returns 1 if the whole buffer reads as erased flash */
++static int IsErasedBlock(unsigned char *Buf, unsigned long Size)
++{
++    unsigned long *p = (unsigned long *)Buf;
++
++    for(; Size >= sizeof(unsigned long); Size -= sizeof(unsigned long), p++)
++    {
++        if(*p != ~0UL)
++            return 0;
++    }
++    return 1;
++}
++
 +int VerifyandFlash (void)
 +{
 +    flash_info_t    *pFlashInfo;
@@ -231,6 +245,8 @@
 +    unsigned char   *pRamAddr;
 +    unsigned long   cnt,confstartaddr = 0,confsize = 0, FlashAddr= 0;
 +    char        *argv[4];
++    unsigned long   Unchanged = 0, Written = 0, EraseSkipped = 0, WriteSkipped = 0;
++    ulong           StartTime;
 +
 +    /*TODO: Flash Info need to be get properly based on the bank (i.e Dual Image)*/
 +    pFlashInfo = &flash_info[bank];
@@ -264,6 +280,7 @@
 +        return -1;
 +    }
 +
++    StartTime = get_timer(0);
 +    for(sector = 0; sector < pFlashInfo->sector_count; sector++)
 +    {
 +        pRamAddr = (unsigned char *) (YAFU_IMAGE_UPLOAD_LOCATION + (sector * CONFIG_SPX_FEATURE_GLOBAL_ERASE_BLOCK_SIZE));
@@ -303,12 +320,15 @@
 +        /*Skip the sector if there is no change*/
 +        if(0 == memcmp((unsigned char*)TempBuf,(unsigned char*)pRamAddr,CONFIG_SPX_FEATURE_GLOBAL_ERASE_BLOCK_SIZE))
 +        {
-+            printf("sector %d did not change\n",sector);
++            Unchanged++;
 +            continue;
 +        }
 +
++        /*No need to erase a sector that is blank already*/
 +        retries = 3;
-+        while(retries)
++        if(IsErasedBlock(TempBuf,CONFIG_SPX_FEATURE_GLOBAL_ERASE_BLOCK_SIZE))
++            EraseSkipped++;
++        else while(retries)
 +        {
 +            /*Erase the sector*/
 +            if(0 != flash_erase(pFlashInfo, sector, sector))
@@ -322,6 +342,13 @@
 +        if(retries == 0)
 +            return -1;
 +
++        /*Nothing to write if the new sector is blank*/
++        if(IsErasedBlock(pRamAddr,CONFIG_SPX_FEATURE_GLOBAL_ERASE_BLOCK_SIZE))
++        {
++            WriteSkipped++;
++            continue;
++        }
++
 +        FlashAddr = pFlashInfo->start[sector];
 +        cnt = CONFIG_SPX_FEATURE_GLOBAL_ERASE_BLOCK_SIZE;
 +        retries = 3;
@@ -339,12 +366,57 @@
 +
 +        if(retries == 0)
 +            return -1;
-+        
++
++        Written++;
 +    }
++
++    printf("Flash update: %lu sectors unchanged, %lu written, %lu erased only (%lu already blank) in %lu ms\n",
++           Unchanged, Written, WriteSkipped, EraseSkipped, get_timer(StartTime));
 +    
 +    return 0;
 +}
 +
++/* From net/tftp.c */
++extern ulong 			TftpCrc32;
++extern ulong 			TftpCrcSize;
++extern int 				TftpCrcValid;
++
++/*
++ * Check the downloaded image against the "recoverycrc" env (hex CRC32 of the
++ * whole image). tftp.c folds the CRC in as the blocks arrive, so RAM is only
++ * read again if the transfer did not store the blocks in order.
++ */
++static int CheckTFTPImageCRC(void)
++{
++    char    *s;
++    ulong   expected, crc;
++
++    s = getenv("recoverycrc");
++    if(s == NULL)
++    {
++        return 0;
++    }
++
++    expected = simple_strtoul(s, NULL, 16);
++    if(TftpCrcValid && (TftpCrcSize == NetBootFileXferSize))
++    {
++        crc = TftpCrc32;
++    }
++    else
++    {
++        crc = crc32(0, (unsigned char *)YAFU_IMAGE_UPLOAD_LOCATION, NetBootFileXferSize);
++    }
++
++    printf("Recovery Image CRC32 : 0x%08lx\n", crc);
++    if(crc != expected)
++    {
++        printf("CRC32 mismatch, expected 0x%08lx\n", expected);
++        return -1;
++    }
++
++    return 0;
++}
++
 +int TFTPRecoveryBoot(void)
 +{
 +    char    *s, tmp[22] = {0};
@@ -395,6 +467,12 @@
 +        return -1;
 +    }
 +
++    /*Check the image CRC before anything is erased*/
++    if(0 != CheckTFTPImageCRC())
++    {
++        return -1;
++    }
++
 +    /*Verify the recovery Image and flash it to SPI*/
 +    if(0 != VerifyandFlash())
 +    {
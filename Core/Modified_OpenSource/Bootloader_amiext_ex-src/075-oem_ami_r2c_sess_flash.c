@@ -1,6 +1,6 @@
 --- u-boot-2013.07/oem/ami/r2c/sess_flash.c	1969-12-31 19:00:00.000000000 -0500
 +++ uboot.new/oem/ami/r2c/sess_flash.c	2013-12-05 12:17:54.975503948 -0500
-@@ -0,0 +1,436 @@
+@@ -0,0 +1,463 @@
 +# include <common.h>
 +# include <config.h>
 +#ifdef CONFIG_CMD_NET
@@ -351,6 +351,10 @@
 +	unsigned long StartBlockNo,EndBlockNo,AlignedSize;
 +	unsigned long Count;
 +	unsigned char *bSrcAddr,*bDestAddr;		
++	unsigned char *BlockAddr;
++	unsigned long CopyStart,CopyEnd;
++	unsigned long Skipped = 0,Written = 0;
++	ulong StartTime;
 +	
 +
 +	/* Get Erase Block Size of the Flash */
@@ -401,18 +405,41 @@
 +#endif			
 +	}
 +
-+	/* Erase the Required Blocks */	
-+	if (flash_erase(flinfo,StartBlockNo,EndBlockNo) != 0)
-+		Copied = 0;			
-+	else
++	/*
++	 * Erase and Copy block by block. A block that the request covers
++	 * completely and that already holds the same data is left alone,
++	 * so unchanged parts of an image are neither erased nor rewritten.
++	 */
++	StartTime = get_timer(0);
++	Copied = 0;
++	for (BlockNo = StartBlockNo; BlockNo <= EndBlockNo; BlockNo++)
 +	{
-+		/* Copy the Data to Flash */
-+		for(Copied=0;Copied<Count;Copied++)
++		BlockAddr = (unsigned char *)(flinfo->start[0] + (BlockNo * EraseSize));
++		CopyStart = (BlockAddr > bDestAddr) ? (BlockAddr - bDestAddr) : 0;
++		CopyEnd   = (unsigned long)(BlockAddr + EraseSize - bDestAddr);
++		if (CopyEnd > Count)
++			CopyEnd = Count;
++
++		if ((BlockAddr >= bDestAddr) && (CopyEnd - CopyStart == EraseSize) &&
++			(memcmp(BlockAddr, &bSrcAddr[CopyStart], EraseSize) == 0))
 +		{
-+			if (Write2MemByte(&bDestAddr[Copied], bSrcAddr[Copied]) == 0)
-+			break;
++			Skipped++;
++			Copied = CopyEnd;
++			continue;
 +		}
++
++		if (flash_erase(flinfo,BlockNo,BlockNo) != 0)
++			break;
++		if (write_buff(flinfo,&bSrcAddr[CopyStart],
++					(ulong)&bDestAddr[CopyStart],CopyEnd - CopyStart) != 0)
++			break;
++		if (memcmp(&bDestAddr[CopyStart],&bSrcAddr[CopyStart],CopyEnd - CopyStart) != 0)
++			break;
++		Written++;
++		Copied = CopyEnd;
 +	}
++	printf("EraseCopy: %lu blocks unchanged, %lu erased and written in %lu ms\n",
++				Skipped, Written, get_timer(StartTime));
 +			
 +RetEraseCopyFlash:
 +	
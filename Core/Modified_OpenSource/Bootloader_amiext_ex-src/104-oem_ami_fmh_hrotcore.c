@@ -1,6 +1,6 @@
 --- uboot/oem/ami/fmh/hrotcore.c	2019-11-08 16:48:38.385022055 +0800
 +++ uboot_new/oem/ami/fmh/hrotcore.c	2019-11-08 16:46:54.279512779 +0800
-@@ -0,0 +1,173 @@
+@@ -0,0 +1,199 @@
 +# include <common.h>
 +# include <config.h>
 +# include <command.h>
@@ -27,9 +27,19 @@
 +static UINT32 boot_fmh_location,product_info_offset=0;
 +static char placeToHash[HASH_BLK_SIZE];
 +
++/* Boot time spent reading and hashing, in ms (CONFIG_SYS_HZ ticks) */
++static ulong total_read_ms, total_hash_ms, total_bytes;
++
++static ulong
++hrot_kbps(ulong bytes, ulong ms)
++{
++	return (ms == 0) ? 0 : (bytes / 1024) * CONFIG_SYS_HZ / ms;
++}
++
 +void
 +hrot_start(){
 +	sha256_starts(&ctx);
++	total_read_ms = total_hash_ms = total_bytes = 0;
 +	return;
 +}
 +
@@ -41,6 +51,7 @@
 +        unsigned char *hash_data;
 +        int rc = 0;
 +	UINT32 hash_start, size_to_hash;
++	ulong ts, read_ms = 0, hash_ms = 0;
 +
 +	if((ModType == MODULE_BOOTLOADER) && (strncmp((char *)ModName,"boot",sizeof("boot")) == 0)){
 +		boot_fmh_location = fmhLocation;
@@ -69,7 +80,9 @@
 +                                hs_size = stopHash - hash_start;
 +                        }
 +
-+                        flash_read(hash_start, hs_size, placeToHash);
++                        ts = get_timer(0);
++                        rc = flash_read(hash_start, hs_size, placeToHash);
++                        read_ms += get_timer(ts);
 +                        hash_data = (rc == ERR_OK) ? (unsigned char*)placeToHash : NULL;
 +
 +                        if(hash_data == NULL){
@@ -85,10 +98,19 @@
 +							memset(&hash_data[50], 0, 4);
 +						}
 +
++                        ts = get_timer(0);
 +                        sha256_update(&ctx, hash_data, hs_size);
++                        hash_ms += get_timer(ts);
 +                        hash_start += hs_size;
 +                }
 +
++		printf("HROT: %-8.8s %6lu KB, read %4lu ms (%lu KB/s), hash %4lu ms (%lu KB/s)\n",
++			(char *)ModName, (ulong)size_to_hash / 1024,
++			read_ms, hrot_kbps(size_to_hash, read_ms),
++			hash_ms, hrot_kbps(size_to_hash, hash_ms));
++		total_read_ms += read_ms;
++		total_hash_ms += hash_ms;
++		total_bytes += size_to_hash;
 +	}
 +        return 0;
 +}
@@ -113,6 +135,10 @@
 +		char identifier[8];
 +
 +        sha256_finish(&ctx, output);
++        printf("HROT: total    %6lu KB in %lu ms (read %lu ms, hash %lu ms, %lu KB/s)\n",
++                total_bytes / 1024, total_read_ms + total_hash_ms,
++                total_read_ms, total_hash_ms,
++                hrot_kbps(total_bytes, total_read_ms + total_hash_ms));
 +
 +        rc = flash_read(keyInfo, KEY_INFO_LENGTH*4, linebuf);
 +        buf = (rc == ERR_OK) ? linebuf : (void*)keyInfo;
@@ -0,0 +1,337 @@
+--- uboot.org/tools/tftp_window_time.py	1970-01-01 00:00:00.000000000 +0000
++++ uboot.new/tools/tftp_window_time.py	2026-10-19 06:40:12.000000000 +0000
+@@ -0,0 +1,334 @@
++#!/usr/bin/env python3
++#
++# Time TFTP downloads with the RFC 7440 windowsize option.
++#
++#   serve DIR    read-only TFTP server for timing the board itself, e.g.
++#                "setenv tftpwindowsize 8; tftp 0x83000000 rom.ima"; each
++#                transfer is logged with its window, rate and CRC32
++#   bench        fetch an image from a local server once per window size,
++#                using the same window/ACK rules as net/tftp.c
++#   crc FILE     print the CRC32 U-Boot expects in the recoverycrc env
++#
++# --rtt and --loss add per-window latency and random DATA loss on the
++# server side, so a lossy or slow link can be reproduced on one host.
++#
++
++import argparse
++import os
++import random
++import socket
++import struct
++import sys
++import threading
++import time
++import zlib
++
++RRQ, WRQ, DATA, ACK, ERROR, OACK = 1, 2, 3, 4, 5, 6
++
++
++def crc32(data, crc=0):
++	return zlib.crc32(data, crc) & 0xffffffff
++
++
++def parse_opts(fields):
++	opts = {}
++	for i in range(0, len(fields) - 1, 2):
++		opts[fields[i].decode().lower()] = fields[i + 1].decode()
++	return opts
++
++
++def pack_opts(opts):
++	return b''.join(b'%s\0%s\0' % (k.encode(), str(v).encode())
++			for k, v in opts.items())
++
++
++class Server(threading.Thread):
++	def __init__(self, addr, lookup, rtt=0.0, loss=0.0, timeout=1.0,
++		     retries=5, log=print):
++		threading.Thread.__init__(self, daemon=True)
++		self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
++		self.sock.bind(addr)
++		self.addr = self.sock.getsockname()
++		self.lookup = lookup
++		self.rtt = rtt
++		self.loss = loss
++		self.timeout = timeout
++		self.retries = retries
++		self.log = log
++		self.rand = random.Random(7440)
++
++	def run(self):
++		while True:
++			pkt, peer = self.sock.recvfrom(2048)
++			if len(pkt) < 4 or struct.unpack('!H', pkt[:2])[0] != RRQ:
++				continue
++			threading.Thread(target=self.transfer, args=(pkt, peer),
++					 daemon=True).start()
++
++	def transfer(self, pkt, peer):
++		fields = pkt[2:].split(b'\0')
++		name = fields[0].decode()
++		opts = parse_opts(fields[2:-1])
++		sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
++		sock.bind((self.addr[0], 0))
++		sock.settimeout(self.timeout)
++
++		data = self.lookup(name)
++		if data is None:
++			sock.sendto(struct.pack('!HH', ERROR, 1) +
++				    b'File not found\0', peer)
++			return
++
++		blksize, window, reply = 512, 1, {}
++		if 'blksize' in opts:
++			blksize = max(8, min(int(opts['blksize']), 65464))
++			reply['blksize'] = blksize
++		if 'windowsize' in opts:
++			window = max(1, min(int(opts['windowsize']), 65535))
++			reply['windowsize'] = window
++		if 'tsize' in opts:
++			reply['tsize'] = len(data)
++		if 'timeout' in opts:
++			reply['timeout'] = opts['timeout']
++
++		nblk = len(data) // blksize + 1
++		start = time.monotonic()
++		base, resent, sent = 0, 0, 0
++		ack = self.handshake(sock, peer, reply) if reply else 0
++		while ack is not None and base < nblk:
++			if self.rtt:
++				time.sleep(self.rtt)
++			for blk in range(base + 1, min(base + window, nblk) + 1):
++				sent += 1
++				if self.rand.random() < self.loss:
++					continue
++				off = (blk - 1) * blksize
++				sock.sendto(struct.pack('!HH', DATA, blk & 0xffff) +
++					    data[off:off + blksize], peer)
++			ack = self.wait_ack(sock, peer, base, window)
++			if ack is None:
++				break
++			if ack == base:
++				resent += 1
++			base = ack
++
++		secs = time.monotonic() - start
++		if base < nblk:
++			self.log('%s %s:%d: gave up at block %d of %d'
++				 % (name, peer[0], peer[1], base, nblk))
++			return
++		self.log('%s %s:%d blksize %d window %d: %d bytes in %.3f s, '
++			 '%.2f MB/s, %d blocks sent for %d, %d windows resent, '
++			 'crc32 0x%08x'
++			 % (name, peer[0], peer[1], blksize, window, len(data),
++			    secs, len(data) / secs / 1e6, sent, nblk, resent,
++			    crc32(data)))
++
++	def handshake(self, sock, peer, reply):
++		for _ in range(self.retries):
++			sock.sendto(struct.pack('!H', OACK) + pack_opts(reply), peer)
++			ack = self.wait_ack(sock, peer, 0, 0)
++			if ack is not None:
++				return ack
++		return None
++
++	def wait_ack(self, sock, peer, base, window):
++		"""Return the absolute block the client ACKed, or base on timeout
++		(resend the window), or None once the retries run out."""
++		for _ in range(self.retries):
++			try:
++				pkt, src = sock.recvfrom(2048)
++			except socket.timeout:
++				return base
++			if src != peer or len(pkt) < 4:
++				continue
++			op, blk = struct.unpack('!HH', pkt[:4])
++			if op == ERROR:
++				return None
++			if op != ACK:
++				continue
++			ack = base + ((blk - base) & 0xffff)
++			if ack <= base + window:
++				return ack
++		return None
++
++
++class Client:
++	"""The receive side of net/tftp.c: one ACK per window or on the last
++	block, a single re-ACK of the last in-order block when a gap shows
++	up, and a re-ACK of it on timeout."""
++
++	def __init__(self, server, timeout=0.2, retries=10):
++		self.server = server
++		self.timeout = timeout
++		self.retries = retries
++
++	def fetch(self, name, blksize=1468, window=1):
++		sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
++		sock.settimeout(self.timeout)
++		opts = {'timeout': 1, 'tsize': 0, 'blksize': blksize}
++		if window > 1:
++			opts['windowsize'] = window
++		rrq = (struct.pack('!H', RRQ) + name.encode() + b'\0octet\0' +
++		       pack_opts(opts))
++		stats = {'acks': 0, 'gaps': 0, 'timeouts': 0}
++
++		def send_ack(peer, blk):
++			sock.sendto(struct.pack('!HH', ACK, blk & 0xffff), peer)
++			stats['acks'] += 1
++
++		start = time.monotonic()
++		sock.sendto(rrq, self.server)
++		peer, last, count, gap, tries = None, 0, 0, False, 0
++		blksize_used, window_used, crc, out = 512, 1, 0, []
++		while True:
++			try:
++				pkt, src = sock.recvfrom(65536)
++			except socket.timeout:
++				tries += 1
++				stats['timeouts'] += 1
++				if tries > self.retries:
++					raise IOError('retry count exceeded')
++				if peer is None:
++					sock.sendto(rrq, self.server)
++				else:
++					send_ack(peer, last)
++					count = 0
++				continue
++			if peer is None:
++				peer = src
++			elif src != peer:
++				continue
++			op = struct.unpack('!H', pkt[:2])[0]
++			if op == ERROR:
++				raise IOError(pkt[4:-1].decode())
++			if op == OACK:
++				o = parse_opts(pkt[2:].split(b'\0')[:-1])
++				blksize_used = int(o.get('blksize', 512))
++				window_used = int(o.get('windowsize', 1))
++				if window_used < 1 or window_used > window:
++					window_used = 1
++				send_ack(peer, 0)
++				continue
++			if op != DATA:
++				continue
++			blk = struct.unpack('!H', pkt[2:4])[0]
++			payload = pkt[4:]
++			expect = (last + 1) & 0xffff
++			if blk != expect:
++				if (window_used > 1 and blk != last & 0xffff and
++				    not gap):
++					gap = True
++					stats['gaps'] += 1
++					send_ack(peer, last)
++					count = 0
++				continue
++			gap = False
++			tries = 0
++			crc = crc32(payload, crc)
++			out.append(payload)
++			last += 1
++			count += 1
++			final = len(payload) < blksize_used
++			if count >= window_used or final:
++				send_ack(peer, last)
++				count = 0
++			if final:
++				break
++
++		stats.update(secs=time.monotonic() - start, crc=crc,
++			     data=b''.join(out), blksize=blksize_used,
++			     window=window_used)
++		return stats
++
++
++def cmd_serve(args):
++	root = os.path.realpath(args.dir)
++
++	def lookup(name):
++		path = os.path.realpath(os.path.join(root, name.lstrip('/')))
++		if not path.startswith(root + os.sep) or not os.path.isfile(path):
++			return None
++		with open(path, 'rb') as f:
++			return f.read()
++
++	srv = Server((args.bind, args.port), lookup, args.rtt / 1000.0,
++		     args.loss)
++	print('serving %s on %s:%d' % (root, srv.addr[0], srv.addr[1]))
++	sys.stdout.flush()
++	srv.run()
++
++
++def cmd_bench(args):
++	if args.image:
++		with open(args.image, 'rb') as f:
++			image = f.read()
++	else:
++		image = random.Random(0).getrandbits(args.size * 8).to_bytes(
++			args.size, 'little')
++	want = crc32(image)
++	srv = Server(('127.0.0.1', 0), lambda name: image, args.rtt / 1000.0,
++		     args.loss, log=lambda msg: None)
++	srv.start()
++	cli = Client(srv.addr)
++
++	print('%d bytes, blksize %d, rtt %.1f ms, loss %.1f%%, crc32 0x%08x'
++	      % (len(image), args.blksize, args.rtt, args.loss * 100, want))
++	print('%6s %9s %8s %7s %6s %8s %8s %6s'
++	      % ('window', 'seconds', 'MB/s', 'speedup', 'acks', 'gap-acks',
++		 'timeouts', 'crc'))
++	base = None
++	ok = True
++	for window in args.windows:
++		r = cli.fetch('image', args.blksize, window)
++		good = r['crc'] == want and r['data'] == image
++		ok &= good
++		base = base or r['secs']
++		print('%6d %9.3f %8.2f %6.2fx %6d %8d %8d %6s'
++		      % (r['window'], r['secs'], len(image) / r['secs'] / 1e6,
++			 base / r['secs'], r['acks'], r['gaps'], r['timeouts'],
++			 'ok' if good else 'BAD'))
++	return 0 if ok else 1
++
++
++def cmd_crc(args):
++	with open(args.file, 'rb') as f:
++		print('setenv recoverycrc %08x' % crc32(f.read()))
++
++
++def main():
++	ap = argparse.ArgumentParser(
++		description='Time TFTP downloads with the RFC 7440 windowsize option')
++	sub = ap.add_subparsers(dest='cmd')
++	sub.required = True
++
++	for name in ('serve', 'bench'):
++		p = sub.add_parser(name)
++		p.add_argument('--rtt', type=float, default=0.0,
++			       help='extra ms before each window is sent')
++		p.add_argument('--loss', type=float, default=0.0,
++			       help='probability of dropping a DATA packet')
++		if name == 'serve':
++			p.add_argument('dir')
++			p.add_argument('--bind', default='0.0.0.0')
++			p.add_argument('--port', type=int, default=69)
++			p.set_defaults(func=cmd_serve)
++		else:
++			p.add_argument('--image', help='file to send (default: '
++				       'random data of --size bytes)')
++			p.add_argument('--size', type=int, default=8 << 20)
++			p.add_argument('--blksize', type=int, default=1468)
++			p.add_argument('--windows', type=int, nargs='+',
++				       default=[1, 2, 4, 8, 16])
++			p.set_defaults(func=cmd_bench)
++
++	p = sub.add_parser('crc')
++	p.add_argument('file')
++	p.set_defaults(func=cmd_crc)
++
++	args = ap.parse_args()
++	return args.func(args) or 0
++
++
++if __name__ == '__main__':
++	sys.exit(main())
@@ -1,6 +1,6 @@
 --- linux/drivers/net/ethernet/aspeed/ast_gmac.c	1970-01-01 05:30:00.000000000 +0530
 +++ linux.new/drivers/net/ethernet/aspeed/ast_gmac.c	2015-08-04 16:41:07.240944353 +0530
-@@ -0,0 +1,2441 @@
+@@ -0,0 +1,2565 @@
 +//-----------------------------------------------------------------------------
 +// Original version by Faraday handled Faraday GMAC and Marvell PHY:
 +//  "Faraday FTGMAC Driver, (Linux Kernel 2.6.14) 06/16/06 - by Faraday\n"
@@ -76,6 +76,9 @@
 +//    Added ethtool support
 +//    Added WOL support
 +//    NAPI support not yet implemented
++//22 NAPI polling with CONFIG_ASTMAC100_NAPI, napi_budget frames per poll
++//    Interrupt coalescing (ITC) through ethtool -C
++//    RX buffers are halves of pages that are mapped once and recycled
 +//-----------------------------------------------------------------------------
 +
 +#include <linux/module.h>
@@ -217,7 +220,16 @@
 +
 +static int ftgmac100_wait_to_send_packet(struct sk_buff * skb, struct net_device * dev);
 +
++#ifdef CONFIG_ASTMAC100_NAPI
++/* RX and TX completions are handled in the poll, and masked while it is pending */
++#define AST_NAPI_INT_MASK	(RPKT2B_bit | RXBUF_UNAVA_bit | TPKT2E_bit | TPKT_LOST_bit)
++
++static int napi_budget = 64;
++module_param(napi_budget, int, 0444);
++MODULE_PARM_DESC(napi_budget, "Frames received per NAPI poll (1-64)");
++#else
 +static volatile int trans_busy = 0;
++#endif
 +
 +
 +void ftgmac100_phy_rw_waiting(unsigned int ioaddr)
@@ -527,6 +539,44 @@
 +	outl( 0, dev->base_addr + IER_REG );			/* Disable all interrupts */
 +}
 +
++/*
++ . The ITC timer counts 128 cycles of the MII/GMII clock, or 16 times that
++ . with TIME_SEL, so its unit depends on the link speed.
++ */
++static unsigned int ast_gmac_itc_unit_ns(struct ftgmac100_priv *priv)
++{
++	if (priv->maccr_val & GMAC_MODE_bit)
++		return 1024;
++	if (priv->maccr_val & SPEED_100_bit)
++		return 5120;
++	return 51200;
++}
++
++static u32 ast_gmac_itc_field(unsigned int unit_ns, u32 usecs, u32 frames)
++{
++	u32 val = ITC_THR(frames);
++	u32 cnt;
++
++	cnt = DIV_ROUND_UP(min_t(u32, usecs, 1000000) * 1000, unit_ns);
++	if (cnt > ITC_CNT_MAX)
++	{
++		cnt = DIV_ROUND_UP(cnt, 16);
++		val |= ITC_TIME_SEL_bit;
++	}
++	if (cnt > ITC_CNT_MAX)
++		cnt = ITC_CNT_MAX;
++	return val | ITC_CNT(cnt);
++}
++
++/* ITC_REG for the ethtool coalescing settings at the current speed */
++static u32 ast_gmac_itc(struct ftgmac100_priv *priv)
++{
++	unsigned int unit_ns = ast_gmac_itc_unit_ns(priv);
++
++	return ast_gmac_itc_field(unit_ns, priv->rx_coalesce_usecs, priv->rx_max_coalesced_frames) |
++		(ast_gmac_itc_field(unit_ns, priv->tx_coalesce_usecs, priv->tx_max_coalesced_frames) << ITC_TX_SHIFT);
++}
++
 +static void ftgmac100_enable( struct net_device *dev )
 +{
 +	int i;
@@ -558,7 +608,7 @@
 +
 +	outl( priv->rx_descs_dma, dev->base_addr + RXR_BADR_REG);
 +	outl( priv->tx_descs_dma, dev->base_addr + TXR_BADR_REG);
-+	outl( 0x00001010, dev->base_addr + ITC_REG);
++	outl( ast_gmac_itc(priv), dev->base_addr + ITC_REG);
 +
 +	outl( (0UL<<TXPOLL_CNT)|(0x1<<RXPOLL_CNT), dev->base_addr + APTC_REG);
 +	outl( 0x44f97, dev->base_addr + DBLAC_REG );
@@ -596,71 +646,66 @@
 +    enable_wol_magicpkt_detection(dev->base_addr);
 +
 +    if ((priv->ids.miiPhyId & PHYID_VENDOR_MODEL_MASK) == PHYID_KSZ9031) {
-+        outl(
++        priv->int_mask = (
 +// no link PHY link status pin            PHYSTS_CHG_bit      |
 +            AHB_ERR_bit         |
 +            TPKT_LOST_bit       |
 +            TPKT2E_bit          |
 +            RXBUF_UNAVA_bit     |
 +            RPKT2B_bit
-+            ,dev->base_addr + IER_REG
 +            );
 +    }   
 +    else if (priv->ids.miiPhyId == PHYID_RTL8211FD) { 
-+        outl(
++        priv->int_mask = (
 +// no link PHY link status pin            PHYSTS_CHG_bit      |
 +            AHB_ERR_bit         |
 +            TPKT_LOST_bit       |
 +            TPKT2E_bit          |
 +            RXBUF_UNAVA_bit     |
 +            RPKT2B_bit
-+            ,dev->base_addr + IER_REG
 +            );
 +    }
 +    else if (((priv->ids.miiPhyId & PHYID_VENDOR_MASK)       == PHYID_VENDOR_MARVELL) ||
 +	    ((priv->ids.miiPhyId & PHYID_VENDOR_MODEL_MASK) == PHYID_RTL8211)) {
-+		outl(
++		priv->int_mask = (
 +			PHYSTS_CHG_bit		|
 +			AHB_ERR_bit			|
 +			TPKT_LOST_bit		|
 +			TPKT2E_bit			|
 +			RXBUF_UNAVA_bit		|
 +			RPKT2B_bit
-+        	,dev->base_addr + IER_REG
 +       	 	);
 +	}
 +	else if (((priv->ids.miiPhyId & PHYID_VENDOR_MASK) == PHYID_VENDOR_BROADCOM) ||
 +		 ((priv->ids.miiPhyId & PHYID_VENDOR_MODEL_MASK) == PHYID_RTL8201EL)) {
-+		outl(
++		priv->int_mask = (
 +			AHB_ERR_bit			|
 +			TPKT_LOST_bit		|
 +			TPKT2E_bit			|
 +			RXBUF_UNAVA_bit		|
 +			RPKT2B_bit
-+        	,dev->base_addr + IER_REG
 +       	 	);
 +	}
 +	else if (priv->ids.miiPhyId == PHYID_BCM54612E) { 
-+        outl(
++        priv->int_mask = (
 +// no link PHY link status pin            PHYSTS_CHG_bit      |
 +            AHB_ERR_bit         |
 +            TPKT_LOST_bit       |
 +            TPKT2E_bit          |
 +            RXBUF_UNAVA_bit     |
 +            RPKT2B_bit
-+            ,dev->base_addr + IER_REG
 +            );
 +    } else {
-+		outl(
++		priv->int_mask = (
 +// no link PHY link status pin			  PHYSTS_CHG_bit	  |
 +			AHB_ERR_bit 		|
 +			TPKT_LOST_bit		|
 +			TPKT2E_bit			|
 +			RXBUF_UNAVA_bit 	|
 +			RPKT2B_bit
-+			,dev->base_addr + IER_REG
 +			);    
 +    }
++	outl(priv->int_mask, dev->base_addr + IER_REG);
 +}
 +
 +static void aspeed_mac_timer(unsigned long data)
@@ -967,7 +1012,6 @@
 +static int ftgmac100_ringbuf_alloc(struct ftgmac100_priv *priv)
 +{
 +	int i;
-+	struct sk_buff *skb;
 +
 +    priv->rx_descs = dma_alloc_coherent(priv->dev, 
 +								sizeof(RX_DESC)*RXDES_NUM, 
@@ -980,19 +1024,24 @@
 +	priv->rx_descs[RXDES_NUM-1].EDORR = 1;
 +
 +	for (i=0; i<RXDES_NUM; i++) {
-+		dma_addr_t mapping;	
-+		skb = dev_alloc_skb(RX_BUF_SIZE + NET_IP_ALIGN);
-+		skb_reserve(skb, NET_IP_ALIGN);
++		dma_addr_t mapping;
++		struct page *page;
 +
-+		priv->rx_skbuff[i] = skb;
-+		if (skb == NULL) {
++		page = alloc_page(GFP_KERNEL);
++		if (page == NULL) {
 +			printk ("alloc_list: allocate Rx buffer error! ");
-+			break;
++			return -ENOMEM;
++		}
++		mapping = dma_map_page(priv->dev, page, 0, RX_BUF_SIZE, DMA_FROM_DEVICE);
++		if (dma_mapping_error(priv->dev, mapping)) {
++			__free_page(page);
++			return -ENOMEM;
 +		}
-+		mapping = dma_map_single(priv->dev, skb->data, skb->len, DMA_FROM_DEVICE);
-+		skb->dev = priv->netdev;	/* Mark as being used by this device. */
++		priv->rx_page[i] = page;
++		priv->rx_page_dma[i] = mapping;
++		priv->rx_page_offset[i] = 0;
 +		priv->rx_descs[i].RXBUF_BADR = mapping;
-+		priv->rx_descs[i].VIR_RXBUF_BADR = (u32)skb->data;
++		priv->rx_descs[i].VIR_RXBUF_BADR = (u32)page_address(page);
 +	}
 +
 +	priv->tx_descs = dma_alloc_coherent(priv->dev, 
@@ -1008,6 +1057,29 @@
 +	return 0;
 +}
 +
++static void ftgmac100_ringbuf_free(struct ftgmac100_priv *priv)
++{
++	int i;
++
++	for (i=0; i<RXDES_NUM; i++) {
++		if (priv->rx_page[i] == NULL)
++			continue;
++		dma_unmap_page(priv->dev, priv->rx_page_dma[i], RX_BUF_SIZE, DMA_FROM_DEVICE);
++		put_page(priv->rx_page[i]);
++		priv->rx_page[i] = NULL;
++	}
++
++	if (priv->rx_descs)
++			dma_free_coherent( NULL, sizeof(RX_DESC)*RXDES_NUM, (void*)priv->rx_descs, (dma_addr_t)priv->rx_descs_dma );
++	if (priv->tx_descs)
++			dma_free_coherent( NULL, sizeof(TX_DESC)*TXDES_NUM, (void*)priv->tx_descs, (dma_addr_t)priv->tx_descs_dma );
++	if (priv->tx_buf)
++			dma_free_coherent( NULL, TX_BUF_SIZE*TXDES_NUM, (void*)priv->tx_buf, (dma_addr_t)priv->tx_buf_dma );
++	priv->rx_descs = NULL; priv->rx_descs_dma = 0;
++	priv->tx_descs = NULL; priv->tx_descs_dma = 0;
++	priv->tx_buf   = NULL; priv->tx_buf_dma   = 0;
++}
++
 +#ifdef FTMAC100_DEBUG
 +#if FTMAC100_DEBUG > 2
 +static void print_packet( u8 * buf, int length )
@@ -1179,275 +1251,261 @@
 +}
 +
 +
++/* Gives receive descriptor idx back to the MAC, with the buffer the slot now holds */
++static void ast_gmac_rx_give(struct ftgmac100_priv *priv, int idx)
++{
++	volatile RX_DESC *cur_desc = &priv->rx_descs[idx];
++
++	cur_desc->RXBUF_BADR = priv->rx_page_dma[idx];
++	cur_desc->VIR_RXBUF_BADR = (u32)page_address(priv->rx_page[idx]) + priv->rx_page_offset[idx];
++	wmb();
++	cur_desc->RXPKT_RDY = RX_OWNBY_FTGMAC100;
++}
++
++/* Gives receive descriptor idx back to the MAC with the buffer it had */
++static void ast_gmac_rx_recycle(struct ftgmac100_priv *priv, int idx)
++{
++	dma_sync_single_for_device(priv->dev, priv->rx_page_dma[idx], RX_BUF_SIZE, DMA_FROM_DEVICE);
++	ast_gmac_rx_give(priv, idx);
++}
++
 +/*-------------------------------------------------------------
 + .
-+ . ftgmac100_rcv -  receive a packet from the card
++ . ast_gmac_rx_skb - builds the skb for a frame of len bytes in ring
++ . slot idx, and leaves the slot with a buffer the MAC can fill again.
 + .
-+ . There is ( at least ) a packet waiting to be read from
-+ . chip-memory.
++ . Short frames are copied and the buffer stays in the slot. Longer ones
++ . go up in the page itself: the slot moves on to the other half of the
++ . page if the stack is done with that, or to a new page otherwise, so a
++ . page is mapped once and reused for as long as the traffic allows.
++ .
++ . Returns NULL if the frame has to be dropped, the slot keeps its buffer.
++ --------------------------------------------------------------
++*/
++static struct sk_buff *ast_gmac_rx_skb(struct net_device *dev, int idx, int len)
++{
++	struct ftgmac100_priv *priv = (struct ftgmac100_priv *)dev->ml_priv;
++	struct page *page = priv->rx_page[idx];
++	unsigned int offset = priv->rx_page_offset[idx];
++	u8 *data = page_address(page) + offset;
++	struct page *new_page;
++	unsigned int new_offset;
++	dma_addr_t mapping;
++	struct sk_buff *skb;
++
++	skb = netdev_alloc_skb_ip_align(dev, RX_COPYBREAK);
++	if (skb == NULL)
++		goto drop;
++
++	if (len <= RX_COPYBREAK)
++	{
++		memcpy(skb_put(skb, len), data, len);
++		dma_sync_single_for_device(priv->dev, priv->rx_page_dma[idx], RX_BUF_SIZE, DMA_FROM_DEVICE);
++		return skb;
++	}
++
++	if (page_count(page) == 1)
++	{
++		/* Nobody holds the other half any more */
++		new_page = page;
++		new_offset = offset ^ RX_PAGE_HALF;
++	}
++	else
++	{
++		new_page = alloc_page(GFP_ATOMIC);
++		if (new_page == NULL)
++			goto drop;
++		new_offset = 0;
++	}
++
++	mapping = dma_map_page(priv->dev, new_page, new_offset, RX_BUF_SIZE, DMA_FROM_DEVICE);
++	if (dma_mapping_error(priv->dev, mapping))
++	{
++		if (new_page != page)
++			__free_page(new_page);
++		goto drop;
++	}
++	dma_unmap_page(priv->dev, priv->rx_page_dma[idx], RX_BUF_SIZE, DMA_FROM_DEVICE);
++
++	/* If the slot keeps the page, the skb needs a reference of its own */
++	if (new_page == page)
++		get_page(page);
++
++	memcpy(skb_put(skb, RX_PULL_LEN), data, RX_PULL_LEN);
++	skb_add_rx_frag(skb, 0, page, offset + RX_PULL_LEN, len - RX_PULL_LEN, RX_PAGE_HALF);
++
++	priv->rx_page[idx] = new_page;
++	priv->rx_page_dma[idx] = mapping;
++	priv->rx_page_offset[idx] = new_offset;
++	return skb;
++
++drop:
++	if (skb)
++		dev_kfree_skb_any(skb);
++	dma_sync_single_for_device(priv->dev, priv->rx_page_dma[idx], RX_BUF_SIZE, DMA_FROM_DEVICE);
++	return NULL;
++}
++
++/*-------------------------------------------------------------
++ .
++ . ast_gmac_rx -  receive packets from the card
++ .
++ . Takes at most budget frames off the receive ring, from the NAPI
++ . poll or, without CONFIG_ASTMAC100_NAPI, from the interrupt.
 + .
 + . o Read the status
 + . o If an error, record it
-+ . o otherwise, read in the packet
++ . o otherwise, pass the packet up
++ . o give the descriptor back
++ .
++ . Returns the number of descriptors taken.
 + --------------------------------------------------------------
 +*/
-+// extern dce_dcache_invalidate_range(unsigned int start, unsigned int end);
-+
-+static void ftgmac100_rcv(struct net_device *dev)
++static int ast_gmac_rx(struct net_device *dev, int budget)
 +{
 +	struct ftgmac100_priv *priv = (struct ftgmac100_priv *)dev->ml_priv;
-+	unsigned long ioaddr 	= dev->base_addr;
-+	int 	packet_length;
-+	int 	rcv_cnt;
 +	volatile RX_DESC *cur_desc;
++	struct sk_buff *skb;
 +	int		cur_idx;
-+	int		have_package;
-+	int		have_frs;
-+	int	 	start_idx;
-+        int             count = 0;
-+        int             packet_full = 0;
-+	int		data_not_fragment = 1;
++	int		packet_length;
++	int		csum_ok;
++	int		rcv_cnt = 0;
 +
-+	start_idx = priv->rx_idx;
-+
-+	for (rcv_cnt=0; rcv_cnt<RXDES_NUM ; ++rcv_cnt)
++	while (rcv_cnt < budget)
 +	{
-+		packet_length = 0;
 +		cur_idx = priv->rx_idx;
++		cur_desc = &priv->rx_descs[cur_idx];
++		if (cur_desc->RXPKT_RDY != RX_OWNBY_SOFTWARE)
++			break;
++		rmb();
 +
-+		have_package = 0;
-+		have_frs = 0;
++		priv->rx_idx = (cur_idx + 1) % RXDES_NUM;
++		rcv_cnt++;
 +
-+		for (; (cur_desc = &priv->rx_descs[priv->rx_idx])->RXPKT_RDY==RX_OWNBY_SOFTWARE; )
++		/* With RBSR at RX_BUF_SIZE a frame never spans descriptors */
++		if (!cur_desc->FRS || !cur_desc->LRS)
 +		{
-+			have_package = 1;
-+			priv->rx_idx = (priv->rx_idx+1)%RXDES_NUM;
-+                        count++;
-+                        if (count == RXDES_NUM) {
-+                            packet_full = 1;
-+                        }
-+//DF_support
-+                            if (data_not_fragment == 1) {
-+                                if (!(cur_desc->DF)) {
-+                                    data_not_fragment = 0;
-+                                }
-+                            }
++			DO_PRINT("error, loss first\n");
++			priv->stats.rx_over_errors++;
++			ast_gmac_rx_recycle(priv, cur_idx);
++			continue;
++		}
 +
-+			if (cur_desc->FRS)
++		if ( cur_desc->FIFO_FULL )
++		{
++			DO_PRINT("info: RX_FIFO full\n");
++		}
++		else if (cur_desc->RX_ERR || cur_desc->CRC_ERR || cur_desc->FTL ||
++			 cur_desc->RUNT || cur_desc->RX_ODD_NB)
++		{
++			if (cur_desc->RX_ERR)
 +			{
-+				have_frs = 1;
-+                if ( cur_desc->FIFO_FULL )
-+                {
-+                    DO_PRINT("info: RX_FIFO full\n");                    
-+                }
-+                else
-+                {
-+				if (cur_desc->RX_ERR || cur_desc->CRC_ERR || cur_desc->FTL ||
-+				    cur_desc->RUNT || cur_desc->RX_ODD_NB
-+				    // cur_desc->IPCS_FAIL || cur_desc->UDPCS_FAIL || cur_desc->TCPCS_FAIL
-+				    )
-+				{
-+				//	#ifdef not_complete_yet
-+					if (cur_desc->RX_ERR)
-+					{
-+						DO_PRINT("err: RX_ERR\n");
-+					}
-+					if (cur_desc->CRC_ERR)
-+					{
-+				//		DO_PRINT("err: CRC_ERR\n");
-+					}
-+					if (cur_desc->FTL)
-+					{
-+						DO_PRINT("err: FTL\n");
-+					}
-+					if (cur_desc->RX_ODD_NB)
-+					{
-+				//		DO_PRINT("err: RX_ODD_NB\n");
-+				        }
-+//				        if (cur_desc->IPCS_FAIL || cur_desc->UDPCS_FAIL || cur_desc->TCPCS_FAIL)
-+//				        {
-+//				        	DO_PRINT("err: CS FAIL\n");
-+//				        }
-+				//	#endif /* end_of_not */
-+					priv->stats.rx_errors++;			// error frame....
-+					break;
-+                    }
-+				}
-+//DF_support
-+                                    if (cur_desc->DF) {
-+				        if (cur_desc->IPCS_FAIL || cur_desc->UDPCS_FAIL || cur_desc->TCPCS_FAIL)
-+				        {
-+				        	DO_PRINT("err: CS FAIL\n");
-+					        priv->stats.rx_errors++;			// error frame....
-+                                                break;
-+				        }
-+                                    }
-+
-+				if (cur_desc->MULTICAST)
-+				{
-+					priv->stats.multicast++;
-+				}
-+                if ((priv->NCSI_support == 1) || (priv->INTEL_NCSI_EVA_support == 1)) {
-+                    if (cur_desc->BROADCAST) {
-+                        if (*(unsigned short *)(cur_desc->VIR_RXBUF_BADR + 12) == NCSI_HEADER) {
-+                            printk ("AEN PACKET ARRIVED\n");
-+                            ftgmac100_reset(dev);
-+                            ftgmac100_enable(dev);
-+                            return;
-+                        }
-+                    }
-+                }
++				DO_PRINT("err: RX_ERR\n");
 +			}
-+
-+			packet_length += cur_desc->VDBC;
-+
-+//			if ( cur_desc->LRS )		// packet's last frame
-+//			{
-+				break;
-+//			}
++			if (cur_desc->FTL)
++			{
++				DO_PRINT("err: FTL\n");
++			}
++			priv->stats.rx_errors++;			// error frame....
++			ast_gmac_rx_recycle(priv, cur_idx);
++			continue;
 +		}
-+		if (have_package==0)
++
++//DF_support
++		csum_ok = cur_desc->DF;
++		if (csum_ok && (cur_desc->IPCS_FAIL || cur_desc->UDPCS_FAIL || cur_desc->TCPCS_FAIL))
 +		{
-+			goto done;
++			DO_PRINT("err: CS FAIL\n");
++			priv->stats.rx_errors++;			// error frame....
++			ast_gmac_rx_recycle(priv, cur_idx);
++			continue;
 +		}
-+		if (!have_frs)
++
++		if (cur_desc->MULTICAST)
 +		{
-+			DO_PRINT("error, loss first\n");
-+			priv->stats.rx_over_errors++;
++			priv->stats.multicast++;
 +		}
 +
-+		if (packet_length > 0)
++		packet_length = cur_desc->VDBC - 4;		// without the CRC
++		if (packet_length <= 0)
 +		{
-+			struct sk_buff  * skb;
-+			u8		* data = 0;  if (data) { }
-+
-+			packet_length -= 4;
++			priv->stats.rx_length_errors++;
++			ast_gmac_rx_recycle(priv, cur_idx);
++			continue;
++		}
++		dma_sync_single_for_cpu(priv->dev, priv->rx_page_dma[cur_idx], cur_desc->VDBC, DMA_FROM_DEVICE);
++
++		if ((priv->NCSI_support == 1) || (priv->INTEL_NCSI_EVA_support == 1)) {
++			if (cur_desc->BROADCAST) {
++				if (*(unsigned short *)(cur_desc->VIR_RXBUF_BADR + 12) == NCSI_HEADER) {
++					printk ("AEN PACKET ARRIVED\n");
++					ast_gmac_rx_recycle(priv, cur_idx);
++					ftgmac100_reset(dev);
++					ftgmac100_enable(dev);
++					return rcv_cnt;
++				}
++			}
++		}
 +
-+			skb_put (skb = priv->rx_skbuff[cur_idx], packet_length);
++		/* The descriptor belongs to the MAC again after this */
++		skb = ast_gmac_rx_skb(dev, cur_idx, packet_length);
++		ast_gmac_rx_give(priv, cur_idx);
++		if (skb == NULL)
++		{
++			priv->stats.rx_dropped++;
++			continue;
++		}
 +
 +// Rx Offload DF_support
-+
-+			    if (data_not_fragment) {
-+				skb->ip_summed = CHECKSUM_UNNECESSARY;
-+                                data_not_fragment = 1;
-+                            }
++		if (csum_ok)
++			skb->ip_summed = CHECKSUM_UNNECESSARY;
 +
 +#ifdef FTMAC100_DEBUG
 +#if FTMAC100_DEBUG > 2
-+			DO_PRINT("Receiving Packet at 0x%x, packet len = %x\n",(unsigned int)data, packet_length);
-+			print_packet( data, packet_length );
++		DO_PRINT("Receiving Packet at 0x%x, packet len = %x\n",(unsigned int)skb->data, packet_length);
++		print_packet( skb->data, skb_headlen(skb) );
 +#endif
 +#endif
 +
-+			skb->protocol = eth_type_trans(skb, dev );
-+			netif_rx(skb);
-+			priv->stats.rx_packets++;
-+			priv->rx_skbuff[cur_idx] = NULL;
-+		}
-+                if (packet_full) {
-+//                  DO_PRINT ("RX Buffer full before driver entered ISR\n");
-+                    goto done;
-+                }
++		skb->protocol = eth_type_trans(skb, dev );
++		priv->stats.rx_packets++;
++		priv->stats.rx_bytes += packet_length;
++#ifdef CONFIG_ASTMAC100_NAPI
++		napi_gro_receive(&priv->napi, skb);
++#else
++		netif_rx(skb);
++#endif
 +	}
 +
-+done:
-+
-+        if (packet_full) {
-+
-+		struct sk_buff *skb;
-+
-+		for (cur_idx = 0; cur_idx < RXDES_NUM; cur_idx++)
-+		{
-+			if (priv->rx_skbuff[cur_idx] == NULL) {
-+				dma_addr_t mapping; 
-+				skb = dev_alloc_skb(RX_BUF_SIZE + NET_IP_ALIGN);
-+				if (skb == NULL) {
-+					printk (KERN_INFO
-+						"%s: receive_packet: "
-+						"Unable to re-allocate Rx skbuff.#%d\n",
-+						dev->name, cur_idx);
-+				}
-+				
-+				skb_reserve(skb, NET_IP_ALIGN);
-+				
-+				priv->rx_skbuff[cur_idx] = skb;
-+				skb->dev = dev;
-+				// ASPEED: See earlier skb_reserve() cache alignment
-+				
-+				mapping = dma_map_single(priv->dev, skb->data, skb->len, DMA_FROM_DEVICE);
-+				priv->rx_descs[cur_idx].RXBUF_BADR = cpu_to_le32(virt_to_phys(skb->tail));
-+				priv->rx_descs[cur_idx].VIR_RXBUF_BADR = cpu_to_le32((u32)skb->tail);
-+			}
-+		        priv->rx_descs[cur_idx].RXPKT_RDY = RX_OWNBY_FTGMAC100;
-+                }
-+                packet_full = 0;
-+
-+        }
-+	else {
-+            if (start_idx != priv->rx_idx) {
-+		struct sk_buff *skb;
-+
-+		for (cur_idx = (start_idx+1)%RXDES_NUM; cur_idx != priv->rx_idx; cur_idx = (cur_idx+1)%RXDES_NUM)
-+		{
-+
-+
-+			//struct sk_buff *skb;
-+			/* Dropped packets don't need to re-allocate */
-+			if (priv->rx_skbuff[cur_idx] == NULL) {
-+				dma_addr_t mapping; 
-+				skb = dev_alloc_skb(RX_BUF_SIZE + NET_IP_ALIGN);
-+				if (skb == NULL) {
-+					printk (KERN_INFO
-+						"%s: receive_packet: "
-+						"Unable to re-allocate Rx skbuff.#%d\n",
-+						dev->name, cur_idx);
-+				}
-+				
-+				skb_reserve(skb, NET_IP_ALIGN);
-+
-+				priv->rx_skbuff[cur_idx] = skb;
-+				skb->dev = dev;
-+				mapping = dma_map_single(priv->dev, skb->data, skb->len, DMA_FROM_DEVICE);
-+				priv->rx_descs[cur_idx].RXBUF_BADR = cpu_to_le32(virt_to_phys(skb->tail));
-+				priv->rx_descs[cur_idx].VIR_RXBUF_BADR = cpu_to_le32((u32)skb->tail);
-+			}
++	return rcv_cnt;
++}
 +
-+			priv->rx_descs[cur_idx].RXPKT_RDY = RX_OWNBY_FTGMAC100;
-+		}
++#ifdef CONFIG_ASTMAC100_NAPI
++static int ast_gmac_napi_poll(struct napi_struct *napi, int budget)
++{
++	struct ftgmac100_priv *priv = container_of(napi, struct ftgmac100_priv, napi);
++	struct net_device *dev = priv->netdev;
++	unsigned long ioaddr = dev->base_addr;
++	int work_done;
 +
++	ftgmac100_free_tx(dev);
++	work_done = ast_gmac_rx(dev, budget);
 +
-+			//struct sk_buff *skb;
-+			/* Dropped packets don't need to re-allocate */
-+			if (priv->rx_skbuff[start_idx] == NULL) {
-+				dma_addr_t mapping; 
-+				skb = dev_alloc_skb(RX_BUF_SIZE + NET_IP_ALIGN);
-+				if (skb == NULL) {
-+					printk (KERN_INFO
-+						"%s: receive_packet: "
-+						"Unable to re-allocate Rx skbuff.#%d\n",
-+						dev->name, cur_idx);
-+				}
-+				
-+				skb_reserve(skb, NET_IP_ALIGN);
-+				priv->rx_skbuff[start_idx] = skb;
-+				skb->dev = dev;
-+				mapping = dma_map_single(priv->dev, skb->data, skb->len, DMA_FROM_DEVICE);
-+				priv->rx_descs[start_idx].RXBUF_BADR = cpu_to_le32(virt_to_phys(skb->tail));
-+				priv->rx_descs[start_idx].VIR_RXBUF_BADR = cpu_to_le32((u32)skb->tail);
-+			}
-+
++	if (priv->rx_unava)
++	{
++		/* The MAC ran dry, tell it there are descriptors again */
++		priv->rx_unava = 0;
++		outl( 0xffffffff, ioaddr + RXPD_REG);
++	}
 +
-+		priv->rx_descs[start_idx].RXPKT_RDY = RX_OWNBY_FTGMAC100;
-+	    }
-+    }
-+	if (trans_busy == 1)
++	if (work_done < budget)
 +	{
-+		/// priv->maccr_val |= RXMAC_EN_bit;
-+		outl( priv->maccr_val, ioaddr + MACCR_REG );
-+		outl( inl(ioaddr + IER_REG) | RXBUF_UNAVA_bit, ioaddr + IER_REG);
++		napi_complete(napi);
++		outl( priv->int_mask, ioaddr + IER_REG);
 +	}
-+	return;
++	return work_done;
 +}
++#endif
 +
 +/*--------------------------------------------------------------------
 + .
@@ -1578,13 +1636,6 @@
 +
 +//		PRINTK3(KERN_WARNING "%s: Handling interrupt status %x \n",	dev->name, status);
 +
-+		if ( status & (TPKT2E_bit|TPKT_LOST_bit))
-+		{
-+			//free tx skb buf
-+			ftgmac100_free_tx(dev);
-+
-+		}
-+
 +		if ( status & RPKT2B_bit )
 +		{
 +            /* check WOL status register for magic packet */
@@ -1598,22 +1649,43 @@
 +                 * wakeup sequence via common kernel queue */
 +                schedule_work(&(priv->wol_wakeup_work_queue));
 +            }
-+		
-+		
-+			ftgmac100_rcv(dev); //Richard
++		}
++
++#ifdef CONFIG_ASTMAC100_NAPI
++		if ( status & AST_NAPI_INT_MASK )
++		{
++			if (status & RXBUF_UNAVA_bit)
++				priv->rx_unava = 1;
++			/* Unmasked again by the poll once it has caught up */
++			outl( priv->int_mask & ~AST_NAPI_INT_MASK, ioaddr + IER_REG);
++			napi_schedule(&priv->napi);
++		}
++#else
++		if ( status & (TPKT2E_bit|TPKT_LOST_bit))
++		{
++			//free tx skb buf
++			ftgmac100_free_tx(dev);
++
++		}
++
++		if ( status & RPKT2B_bit )
++		{
++			ast_gmac_rx(dev, RXDES_NUM); //Richard
++			if (trans_busy == 1)
++			{
++				/// priv->maccr_val |= RXMAC_EN_bit;
++				outl( priv->maccr_val, ioaddr + MACCR_REG );
++				outl( inl(ioaddr + IER_REG) | RXBUF_UNAVA_bit, ioaddr + IER_REG);
++			}
 +		}
 +		else if (status & RXBUF_UNAVA_bit)
 +		{
 +			outl( mask & ~RXBUF_UNAVA_bit, ioaddr + IER_REG);
 +			trans_busy = 1;
-+		/*
-+			rcv_tq.sync = 0;
-+			rcv_tq.routine = ftgmac100_rcv;
-+			rcv_tq.data = dev;
-+			queue_task(&rcv_tq, &tq_timer);
-+		*/
-+
-+		} else if (status & AHB_ERR_bit)
++		}
++#endif
++
++		if (status & AHB_ERR_bit)
 +		{
 +			DO_PRINT("AHB ERR \n");
 +		}
@@ -1787,20 +1859,15 @@
 +	ftgmac100_shutdown(dev->base_addr);
 +	free_irq(dev->irq, dev);
 +
++#ifdef CONFIG_ASTMAC100_NAPI
++	napi_disable(&priv->napi);
++#endif
++
 +	if (priv->timer.function != NULL) {
 +	    del_timer_sync(&priv->timer);
 +	}
 +
-+	if (priv->rx_descs)
-+			dma_free_coherent( NULL, sizeof(RX_DESC)*RXDES_NUM, (void*)priv->rx_descs, (dma_addr_t)priv->rx_descs_dma );
-+	if (priv->tx_descs)
-+			dma_free_coherent( NULL, sizeof(TX_DESC)*TXDES_NUM, (void*)priv->tx_descs, (dma_addr_t)priv->tx_descs_dma );
-+	if (priv->tx_buf)
-+			dma_free_coherent( NULL, TX_BUF_SIZE*TXDES_NUM, (void*)priv->tx_buf, (dma_addr_t)priv->tx_buf_dma );
-+	priv->rx_descs = NULL; priv->rx_descs_dma = 0;
-+	priv->tx_descs = NULL; priv->tx_descs_dma = 0;
-+	priv->tx_buf   = NULL; priv->tx_buf_dma   = 0;
-+	
++	ftgmac100_ringbuf_free(priv);
 +
 +	return 0;
 +}
@@ -1841,8 +1908,16 @@
 +	priv->maccr_val = (CRC_APD_bit | RXMAC_EN_bit | TXMAC_EN_bit  | RXDMA_EN_bit | RX_MULTIPKT_bit
 +			 | TXDMA_EN_bit | CRC_CHK_bit | RX_BROADPKT_bit | SPEED_100_bit | FULLDUP_bit);
 +
-+	ftgmac100_ringbuf_alloc(priv);
++	err = ftgmac100_ringbuf_alloc(priv);
++	if (err)
++	{
++		ftgmac100_ringbuf_free(priv);
++		return err;
++	}
 +
++#ifdef CONFIG_ASTMAC100_NAPI
++	napi_enable(&priv->napi);
++#endif
 +
 +	/* Grab the IRQ next.  Beyond this, we will free the IRQ. */
 +	err = request_irq(netdev->irq, (void *)&ftgmac100_interrupt,
@@ -1851,8 +1926,10 @@
 +	{
 +		DO_PRINT("%s: unable to get IRQ %d (retval=%d).\n",
 +			 netdev->name, netdev->irq, err);
-+		kfree(netdev->ml_priv);
-+		netdev->ml_priv = NULL;
++#ifdef CONFIG_ASTMAC100_NAPI
++		napi_disable(&priv->napi);
++#endif
++		ftgmac100_ringbuf_free(priv);
 +		return err;
 +	}
 +
@@ -1882,10 +1959,10 @@
 +}
 +
 +#ifdef CONFIG_NET_POLL_CONTROLLER
-+static void ftgmac100_poll(struct net_device *dev)
++static void ftgmac100_poll_controller(struct net_device *dev)
 +{
 +    disable_irq(dev->irq);
-+    ftgmac100_interrupt(dev->irq, dev);
++    ftgmac100_interrupt(dev->irq, dev, NULL);
 +    enable_irq(dev->irq);
 +}
 +#endif
@@ -1901,7 +1978,7 @@
 +        ndo_set_multicast_list: ftgmac100_set_multicast_list,
 +#endif
 +#ifdef CONFIG_NET_POLL_CONTROLLER
-+    ndo_poll_controller:  ftgmac100_poll,
++    ndo_poll_controller:  ftgmac100_poll_controller,
 +#endif
 +	ndo_set_mac_address:	 eth_mac_addr,
 +};
@@ -2194,6 +2271,45 @@
 +	return 0;			
 +}	
 +
++static int ast_ether_get_coalesce(struct net_device *dev, struct ethtool_coalesce *ec)
++{
++	struct ftgmac100_priv *lp = netdev_priv(dev);
++
++	ec->rx_coalesce_usecs = lp->rx_coalesce_usecs;
++	ec->rx_max_coalesced_frames = lp->rx_max_coalesced_frames;
++	ec->tx_coalesce_usecs = lp->tx_coalesce_usecs;
++	ec->tx_max_coalesced_frames = lp->tx_max_coalesced_frames;
++	return 0;
++}
++
++/*
++ . The MAC interrupts after max_coalesced_frames frames, or coalesce_usecs
++ . after the first one. The timer is rounded up to its unit at the link
++ . speed and saturates at 15 units of 16.
++ */
++static int ast_ether_set_coalesce(struct net_device *dev, struct ethtool_coalesce *ec)
++{
++	struct ftgmac100_priv *lp = netdev_priv(dev);
++
++	if (ec->rx_max_coalesced_frames < 1 || ec->rx_max_coalesced_frames > ITC_THR_MAX ||
++	    ec->tx_max_coalesced_frames < 1 || ec->tx_max_coalesced_frames > ITC_THR_MAX)
++		return -EINVAL;
++
++	/* Without the timer a lone frame would wait for company */
++	if ((ec->rx_max_coalesced_frames > 1 && ec->rx_coalesce_usecs == 0) ||
++	    (ec->tx_max_coalesced_frames > 1 && ec->tx_coalesce_usecs == 0))
++		return -EINVAL;
++
++	lp->rx_coalesce_usecs = ec->rx_coalesce_usecs;
++	lp->rx_max_coalesced_frames = ec->rx_max_coalesced_frames;
++	lp->tx_coalesce_usecs = ec->tx_coalesce_usecs;
++	lp->tx_max_coalesced_frames = ec->tx_max_coalesced_frames;
++
++	if (netif_running(dev))
++		outl(ast_gmac_itc(lp), dev->base_addr + ITC_REG);
++	return 0;
++}
++
 +static const struct ethtool_ops ast_ether_ethtool_ops = {
 +       .get_settings = ast_ether_get_settings,
 +       .set_settings = ast_ether_set_settings,
@@ -2202,6 +2318,8 @@
 +       .set_wol = ast_ether_set_wol,
 +       .set_pauseparam = ast_ether_set_pauseparam,
 +       .get_pauseparam = ast_ether_get_pauseparam,
++       .get_coalesce = ast_ether_get_coalesce,
++       .set_coalesce = ast_ether_set_coalesce,
 +};
 +
 +
@@ -2258,8 +2376,8 @@
 +#endif
 +	
 +
-+#ifdef CONFIG_AST_NPAI
-+//	netdev->features = NETIF_F_GRO;
++#ifdef CONFIG_ASTMAC100_NAPI
++	netdev->features |= NETIF_F_GRO;
 +//	netdev->features = NETIF_F_IP_CSUM | NETIF_F_GRO;
 +#endif
 +
@@ -2277,9 +2395,15 @@
 +
 +	spin_lock_init(&priv->tx_lock);
 +
-+#ifdef USE_NAPI
++	/* One interrupt per frame until ethtool -C says otherwise */
++	priv->rx_max_coalesced_frames = 1;
++	priv->tx_max_coalesced_frames = 1;
++
++#ifdef CONFIG_ASTMAC100_NAPI
 + 	/*initialize NAPI */
-+	netif_napi_add(netdev, &priv->napi, ftgmac100_poll, 64);
++	if (napi_budget < 1 || napi_budget > 64)
++		napi_budget = 64;
++	netif_napi_add(netdev, &priv->napi, ast_gmac_napi_poll, napi_budget);
 +#endif
 +	/* map io memory */
 +	res = request_mem_region(res->start, resource_size(res),
@@ -2377,7 +2501,7 @@
 +err_ioremap:
 +	release_resource(res);
 +err_req_mem:
-+#ifdef USE_NAPI
++#ifdef CONFIG_ASTMAC100_NAPI
 +	netif_napi_del(&priv->napi);			
 +#endif
 +	platform_set_drvdata(pdev, NULL);
@@ -2391,7 +2515,7 @@
 +static int  ast_gmac_remove(struct platform_device *pdev)
 +{
 +	struct net_device *dev = platform_get_drvdata(pdev);
-+//	struct ftgmac100_priv *priv = netdev_priv(dev);
++	struct ftgmac100_priv *priv = netdev_priv(dev);
 +
 +//	remove_proc_entry(dev->name, 0);
 +
@@ -2405,7 +2529,7 @@
 +
 +	iounmap((void __iomem *)dev->base_addr);
 +
-+#ifdef CONFIG_AST_NPAI
++#ifdef CONFIG_ASTMAC100_NAPI
 +	netif_napi_del(&priv->napi);
 +#endif
 +
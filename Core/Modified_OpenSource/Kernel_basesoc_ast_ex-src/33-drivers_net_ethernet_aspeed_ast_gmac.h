@@ -1,6 +1,6 @@
 --- linux/drivers/net/ethernet/aspeed/ast_gmac.h	1970-01-01 05:30:00.000000000 +0530
 +++ linux.new/drivers/net/ethernet/aspeed/ast_gmac.h	2015-08-04 16:41:11.576982377 +0530
-@@ -0,0 +1,585 @@
+@@ -0,0 +1,606 @@
 +// --------------------------------------------------------------------
 +
 +#ifndef FTMAC100_H
@@ -82,6 +82,16 @@
 +}FTGMAC100_APTCR_Status;
 +
 +// --------------------------------------------------------------------
++//	ITC_REG, RX fields in bits 0-7, the same TX fields in bits 8-15
++// --------------------------------------------------------------------
++#define ITC_CNT(x)			((x) & 0xf)			// interrupt timer, 0 disables it
++#define ITC_THR(x)			(((x) & 0x7) << 4)	// frames before an interrupt
++#define ITC_TIME_SEL_bit	(1UL<<7)			// timer counts in units of 16
++#define ITC_TX_SHIFT		8
++#define ITC_CNT_MAX			15
++#define ITC_THR_MAX			7
++
++// --------------------------------------------------------------------
 +//		PHYCR_REG
 +// --------------------------------------------------------------------
 +#define PHY_RE_AUTO_bit			(1UL<<9)
@@ -449,6 +459,9 @@
 +#define RXDES_NUM			32
 +
 +#define RX_BUF_SIZE			1536
++#define RX_PAGE_HALF		(PAGE_SIZE / 2)	// each receive page holds two buffers
++#define RX_COPYBREAK		256				// frames up to this size are copied out of the buffer
++#define RX_PULL_LEN			128				// header bytes copied into a frame left in its page
 +
 +#define TXDES_NUM			32
 +#define TX_BUF_SIZE			1536
@@ -505,9 +518,12 @@
 +
 +	//RX ..
 +	volatile RX_DESC *rx_descs;			// receive ring base address
-+	struct sk_buff *rx_skbuff[RXDES_NUM];
++	struct page *rx_page[RXDES_NUM];	// receive buffer pages
++	dma_addr_t rx_page_dma[RXDES_NUM];	// mapping of the half in use
++	unsigned int rx_page_offset[RXDES_NUM];
 +	u32		rx_descs_dma;				// receive ring physical base address
 +	int		rx_idx;						// receive descriptor
++	int		rx_unava;					// ran out of receive descriptors
 +
 +	//TX ..
 +	volatile TX_DESC *tx_descs;
@@ -519,6 +535,11 @@
 +	struct sk_buff *tx_skbuff[TXDES_NUM];
 +	
 +	int     maccr_val;
++	u32		int_mask;					// IER value, RX and TX completions included
++	u32		rx_coalesce_usecs;
++	u32		rx_max_coalesced_frames;
++	u32		tx_coalesce_usecs;
++	u32		tx_max_coalesced_frames;
 +        struct timer_list    timer;
 +	u32		GigaBit_MAHT0;
 +	u32		GigaBit_MAHT1;
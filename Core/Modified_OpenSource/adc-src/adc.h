@@ -23,6 +23,8 @@
 #ifndef __ADC_H__
 #define __ADC_H__
 
+#include "sensor_sampler.h"
+
 #define READ_ADC_CHANNEL            _IOC(_IOC_WRITE,'K',0x100,0x3FFF)
 #define READ_ADC_REF_VOLATGE        _IOC(_IOC_WRITE,'K',0x101,0x3FFF)
 #define READ_ADC_RESOLUTION         _IOC(_IOC_WRITE,'K',0x102,0x3FFF)
@@ -30,6 +32,10 @@
 #define DISABLE_EXT_REF_VOLTAGE     _IOC(_IOC_WRITE,'K',0x104,0x3FFF)
 #define ENABLE_ADC_CHANNEL          _IOC(_IOC_WRITE,'K',0x105,0x3FFF)
 #define DISABLE_ADC_CHANNEL         _IOC(_IOC_WRITE,'K',0x106,0x3FFF)
+#define READ_ADC_CHANNELS           _IOC(_IOC_WRITE,'K',0x107,0x3FFF)
+#define CONFIGURE_ADC_SAMPLER       _IOC(_IOC_WRITE,'K',0x108,0x3FFF)
+
+#define ADC_MAX_CHANNELS            16
 
 #define PACKED __attribute__ ((packed))
 
@@ -40,12 +46,30 @@ typedef struct
 
 } PACKED get_adc_value_t;
 
+/* READ_ADC_CHANNELS: sample[].channel in, value, status and timestamp out */
+typedef struct
+{
+	uint8_t		num_channels;
+	sensor_sample_t	sample[ADC_MAX_CHANNELS];
+
+} get_adc_values_t;
+
+/* CONFIGURE_ADC_SAMPLER: channels read by the helper sampler, none to stop */
+typedef struct
+{
+	uint8_t		num_channels;
+	uint8_t		channel_num[ADC_MAX_CHANNELS];
+
+} PACKED adc_sampler_config_t;
+
 typedef struct
 {
 	int (*adc_read_channel) (uint16_t *adc_value, int channel);
 	int (*adc_get_resolution) (uint16_t *adc_resolution);
 	int (*adc_get_reference_voltage) (uint16_t *adc_ref_volatge);
 	int (*adc_reboot_notifier) (void);
+	/* Optional, reads several channels after a single conversion wait */
+	int (*adc_read_channels) (uint16_t *adc_value, const uint8_t *channel, int count);
 }adc_hal_operations_t;
 
 typedef struct
@@ -56,6 +80,9 @@ typedef struct
 struct adc_hal
 {
 	adc_hal_operations_t *padc_hal_ops;
+#ifdef __KERNEL__
+	struct sensor_sampler_source sampler;
+#endif
 };
 
 struct adc_dev
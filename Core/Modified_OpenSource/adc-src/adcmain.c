@@ -36,6 +36,7 @@
 #include <linux/reboot.h>
 #include <linux/version.h>
 #include <linux/cdev.h>
+#include <linux/ktime.h>
 
 #include "helper.h"
 #include "driver_hal.h"
@@ -66,6 +67,8 @@ static int adc_module_ioctl(struct inode *inode, struct file *file, uint cmd, ul
 static int 	adc_driver_sys_reboot_notify(struct notifier_block *this, unsigned long code, void *unused);
 static int adc_open(struct inode *inode, struct file *file);
 static int adc_release(struct inode *inode, struct file *file);
+static int adc_read_batch(struct adc_hal *padc_hal, sensor_sample_t *sample, int count);
+static int adc_sampler_read(void *priv, sensor_sample_t *sample, int count);
 
 
 
@@ -127,6 +130,13 @@ register_adc_hal_module (unsigned char num_instances, void *phal_ops, void **phw
 	phw_hal->padc_hal_ops = ( adc_hal_operations_t *) phal_ops;
 	*phw_data = (void *) phw_hal;
 
+	/* Channels are added to the sampler with CONFIGURE_ADC_SAMPLER */
+	phw_hal->sampler.name = ADC_DEV_NAME;
+	phw_hal->sampler.type = SENSOR_SOURCE_ADC;
+	phw_hal->sampler.read = adc_sampler_read;
+	phw_hal->sampler.priv = phw_hal;
+	sensor_sampler_register (&phw_hal->sampler);
+
 	return 0;
 }
 
@@ -135,6 +145,7 @@ unregister_adc_hal_module (void *phw_data)
 {
 	struct adc_hal *padc_hal = (struct adc_hal*) phw_data;
 
+	sensor_sampler_unregister (&padc_hal->sampler);
 	kfree (padc_hal);
 
 	return 0;
@@ -292,11 +303,73 @@ adc_release(struct inode *inode, struct file *file)
 }
 
 
+/*
+ * Reads sample[].channel into sample[].value, stamping each sample with
+ * the time it was read. Used by READ_ADC_CHANNELS and by the sampler.
+ */
+static int
+adc_read_batch(struct adc_hal *padc_hal, sensor_sample_t *sample, int count)
+{
+	adc_hal_operations_t *ops = padc_hal->padc_hal_ops;
+	uint8_t  channel[ADC_MAX_CHANNELS];
+	uint16_t value[ADC_MAX_CHANNELS];
+	u64 now;
+	int i, ret;
+
+	if (count > ADC_MAX_CHANNELS)
+		return -EINVAL;
+
+	for (i = 0; i < count; i++)
+	{
+		if (sample[i].channel >= ADC_MAX_CHANNELS)
+			return -EINVAL;
+		channel[i] = sample[i].channel;
+		sample[i].source = SENSOR_SOURCE_ADC;
+	}
+
+	if (ops->adc_read_channels)
+	{
+		/* The values are latched together, one timestamp for all */
+		ret = ops->adc_read_channels (value, channel, count);
+		now = ktime_get_ns ();
+		for (i = 0; i < count; i++)
+		{
+			sample[i].value = value[i];
+			sample[i].status = (ret < 0) ? ret : 0;
+			sample[i].timestamp = now;
+		}
+	}
+	else if (ops->adc_read_channel)
+	{
+		for (i = 0; i < count; i++)
+		{
+			value[i] = 0;
+			ret = ops->adc_read_channel (&value[i], channel[i]);
+			sample[i].timestamp = ktime_get_ns ();
+			sample[i].value = value[i];
+			sample[i].status = (ret < 0) ? ret : 0;
+		}
+	}
+	else
+		return -ENXIO;
+
+	return 0;
+}
+
+static int
+adc_sampler_read(void *priv, sensor_sample_t *sample, int count)
+{
+	return adc_read_batch ((struct adc_hal *)priv, sample, count);
+}
+
 static long
 adc_module_ioctlUnlocked(struct file *file, uint cmd, ulong arg)
 {
 	get_adc_value_t	get_adc_value;
+	get_adc_values_t	get_adc_values;
+	adc_sampler_config_t	sampler_config;
 	uint16_t		ref_voltage, resolution;
+	int			i, ret;
 
 	struct adc_dev *pdev = (struct adc_dev*) file->private_data;
 
@@ -344,6 +417,42 @@ adc_module_ioctlUnlocked(struct file *file, uint cmd, ulong arg)
         		        return -EFAULT;
 			}
 			break;
+
+		case READ_ADC_CHANNELS:
+
+			if (copy_from_user ((void*)&get_adc_values, (void *)arg, sizeof (get_adc_values_t)))
+			{
+				printk("READ_ADC_CHANNELS: Error copying data from user \n");
+				return -EFAULT;
+			}
+
+			if ((ret = adc_read_batch (pdev->padc_hal, get_adc_values.sample, get_adc_values.num_channels)) < 0)
+				return ret;
+
+			if (copy_to_user ((void*)arg, (void*)&get_adc_values, sizeof (get_adc_values_t)))
+			{
+				printk("READ_ADC_CHANNELS: Error copying data to user \n");
+				return -EFAULT;
+			}
+			break;
+
+		case CONFIGURE_ADC_SAMPLER:
+
+			if (copy_from_user ((void*)&sampler_config, (void *)arg, sizeof (adc_sampler_config_t)))
+			{
+				printk("CONFIGURE_ADC_SAMPLER: Error copying data from user \n");
+				return -EFAULT;
+			}
+
+			if (sampler_config.num_channels > ADC_MAX_CHANNELS)
+				return -EINVAL;
+			for (i = 0; i < sampler_config.num_channels; i++)
+			{
+				if (sampler_config.channel_num[i] >= ADC_MAX_CHANNELS)
+					return -EINVAL;
+			}
+
+			return sensor_sampler_set_channels (&pdev->padc_hal->sampler, sampler_config.channel_num, sampler_config.num_channels);
 			
 		default:
 			printk("ERROR: ADC: Invalid IOCTL \n");
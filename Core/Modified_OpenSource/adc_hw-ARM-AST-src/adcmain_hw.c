@@ -55,6 +55,7 @@ static	int adc_read_channel (uint16_t *adc_value, int channel);
 static	int adc_get_resolution (uint16_t *adc_resolution);
 static	int adc_get_reference_voltage (uint16_t *adc_ref_volatge);
 static	int adc_reboot_notifier (void);
+static	int adc_read_channels (uint16_t *adc_value, const uint8_t *channel, int count);
 
 extern int register_adc_hw_module (ADC_HW* AdcHw);
 
@@ -65,6 +66,7 @@ static adc_hal_operations_t adc_hw_ops = {
 	adc_get_resolution,
 	adc_get_reference_voltage,
 	adc_reboot_notifier,
+	adc_read_channels,
 };
 
 static hw_hal_t hw_hal = {
@@ -228,6 +230,24 @@ adc_read_channel(uint16_t *adc_value, int channel)
 	return 0;
 }
 
+/*
+ * adc_read_channels
+ * As adc_read_channel for several channels, waiting once for all of them
+ */
+int
+adc_read_channels(uint16_t *adc_value, const uint8_t *channel, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		enable_adc_channel(channel[i]);
+	msleep(1);
+	for (i = 0; i < count; i++)
+		adc_value[i] = adc_measure(channel[i]);
+
+	return 0;
+}
+
 /*
  * adc_get_resolution
  */
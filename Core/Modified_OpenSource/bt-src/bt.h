@@ -19,6 +19,14 @@
 
 #define MSG_PAYLOAD_SIZE	(33*1024)
 
+/* A BT request is a length byte followed by up to 255 bytes */
+#define BT_MAX_PKT_LEN		256
+
+/* Requests received on a channel and not yet read by the IPMI stack */
+#ifndef BT_REQ_QUEUE_LEN
+#define BT_REQ_QUEUE_LEN	8
+#endif
+
 typedef struct
 {
     /*Only add members at the end of structure to keep structure align*/
@@ -60,6 +68,20 @@ typedef struct
 
 } __attribute__((packed)) BTReq_T;
 
+/* Per channel queue of received requests, kept out of the packed BTBuf_T
+   for the alignment of the lock */
+typedef struct
+{
+	spinlock_t	Lock;
+	u8			Pkt [BT_REQ_QUEUE_LEN][BT_MAX_PKT_LEN];
+	u32			Len [BT_REQ_QUEUE_LEN];
+	u8			Head;		/* Oldest queued request */
+	u8			Count;		/* Requests queued */
+	u8			Reading;	/* Head is being copied to user */
+	u32			Dropped;	/* Requests dropped on a full queue */
+
+} BTReqQueue_T;
+
 typedef struct
 {
 	unsigned char (*num_bt_ch) (void);
@@ -31,6 +31,7 @@
 #include <linux/cdev.h>
 #include <linux/delay.h>
 #include <linux/uaccess.h>
+#include <linux/poll.h>
 #include "bt.h"
 #include "btifc.h"
 #include "driver_hal.h"
@@ -68,6 +69,7 @@ struct bt_hal
 	BTBuf_T *pbt_buf;
 	IPMICmdMsg_T* pipmi_cmd_msg;
 	bt_hal_operations_t *pbt_hal_ops;
+	BTReqQueue_T *preq_queue;
 };
 
 struct bt_dev
@@ -122,12 +124,14 @@ static int bt_ioctl (struct inode *inode, struct file *filp, unsigned int cmd, u
 
 static ssize_t bt_read (struct file *filp, char __user *buf, size_t count, loff_t *offset);
 static ssize_t bt_write (struct file *filp, const char __user *buf, size_t count, loff_t *offset);
+static unsigned int bt_poll (struct file *filp, poll_table *wait);
 
 static struct file_operations bt_fops = 
 {
     .owner 		= THIS_MODULE,
     .read  		= bt_read,
     .write 		= bt_write,
+    .poll 		= bt_poll,
 #ifdef USE_UNLOCKED_IOCTL 
     .unlocked_ioctl	=	bt_ioctlUnlocked, 
 #else 
@@ -187,12 +191,25 @@ register_bt_hal_module (unsigned char num_instances, void *phal_ops, void **phw_
 		return -ENOMEM;
 	}
 
+	pbt_hal->preq_queue = (BTReqQueue_T*) kzalloc (num_instances * sizeof(BTReqQueue_T), GFP_KERNEL);
+	if (!pbt_hal->preq_queue)
+	{
+		TCRIT ("register_bt_hal_module(): kzalloc failed for pbt_hal->preq_queue\n");
+		vfree (pbt_hal->pipmi_cmd_msg);
+		kfree (pbt_hal->pbt_buf);
+		kfree (pbt_hal);
+		return -ENOMEM;
+	}
+
 	for (i = 0; i < num_instances; ++i)
 	{
 		dbgprint ("%d, bt_buf addr : %p\n", i, &pbt_hal->pbt_buf[i]);						
 		pbt_hal->pbt_buf[i].pBTRcvPkt = pbt_hal->pipmi_cmd_msg[i].Request;
 		pbt_hal->pbt_buf[i].BtWakeup = 0;
 		pbt_hal->pbt_buf[i].FirstTime = 1;
+		/* Initialized here rather than on the first read, poll() may wait on it first */
+		Bt_OsInitSleepStruct(&(pbt_hal->pbt_buf[i].BtReqWait));
+		spin_lock_init (&pbt_hal->preq_queue[i].Lock);
 	}
 
 	pbt_hal->pbt_hal_ops = (bt_hal_operations_t *) phal_ops;
@@ -209,6 +226,7 @@ unregister_bt_hal_module (void *phw_data)
 	struct bt_hal *pbt_hal = (struct bt_hal *)phw_data;
 
 	dbgprint ("unregister hal addr : %p\n", pbt_hal);
+	kfree (pbt_hal->preq_queue);
 	vfree (pbt_hal->pipmi_cmd_msg);
 	kfree (pbt_hal->pbt_buf);
 	kfree (pbt_hal);
@@ -249,11 +267,19 @@ bt_open(struct inode *inode, struct file *file)
 	dbgprint ("%d, bt_open bufffer addr : %p\n", minor, pBTBuffer);				
 	if (open_count == 1) // On open descriptors, the initialization would have been done in the first open. Hence skip initialization
 	{
+		BTReqQueue_T *pQueue = &pbt_hal->preq_queue [bt_hw_info.inst_num];
+		unsigned long flags;
+
 		pBTBuffer->BTRcvPktLen = 0;
 		pBTBuffer->BTSendPktLen = 0;
-	    pBTBuffer->BtWakeup       = 0;
 	    pBTBuffer->BtReqWaiting = 0;
-		Bt_OsInitSleepStruct(&(pBTBuffer->BtReqWait));
+		/* Requests received while the device was closed are discarded */
+		spin_lock_irqsave (&pQueue->Lock, flags);
+		pQueue->Head = 0;
+		pQueue->Count = 0;
+		pQueue->Reading = 0;
+	    pBTBuffer->BtWakeup       = 0;
+		spin_unlock_irqrestore (&pQueue->Lock, flags);
 	}
 
 	pdev->pbt_hal = pbt_hal;
@@ -351,31 +377,60 @@ bt_ioctl (struct inode *inode, struct file *file, unsigned int cmd, unsigned lon
 }
 #endif
 static int 
-bt_request (struct bt_dev *pdev, char *pbuf)
+bt_request (struct bt_dev *pdev, char *pbuf, int nonblock)
 {
 	BTBuf_T *pBTBuffer = &pdev->pbt_hal->pbt_buf [pdev->ch_num];
+	BTReqQueue_T *pQueue = &pdev->pbt_hal->preq_queue [pdev->ch_num];
+	unsigned long flags;
+	u8 *pReq;
+	u32 Len;
+	int ret;
 
 	dbgprint ("bt_request ch num: %d, bt_buf addr : %p\n", pdev->ch_num, pBTBuffer);
 
-	/* Initialize Sleep Structure for the First Time */
-	if (pBTBuffer->FirstTime)
+	pBTBuffer->FirstTime = 0;
+
+	spin_lock_irqsave (&pQueue->Lock, flags);
+	while (0 == pQueue->Count)
 	{
-		Bt_OsInitSleepStruct(&(pBTBuffer->BtReqWait));
-		pBTBuffer->FirstTime = 0;
+		spin_unlock_irqrestore (&pQueue->Lock, flags);
+		if (nonblock)
+			return -EAGAIN;
+
+		pBTBuffer->BtReqWaiting = 1;
+		dbgprint ("sleeping in bt_request for ch num: %d\n", pdev->ch_num);
+		Bt_OsSleepOnTimeout(&(pBTBuffer->BtReqWait), &(pBTBuffer->BtWakeup), 0);
+		pBTBuffer->BtReqWaiting = 0;
+		dbgprint ("out of sleep in bt_request for ch num: %d\n", pdev->ch_num);
+
+		spin_lock_irqsave (&pQueue->Lock, flags);
+		if (0 == pQueue->Count && signal_pending (current))
+		{
+			spin_unlock_irqrestore (&pQueue->Lock, flags);
+			return -ERESTARTSYS;
+		}
 	}
-	pBTBuffer->BtReqWaiting = 1;
-	dbgprint ("sleeping in bt_request for ch num: %d\n", pdev->ch_num);
-	Bt_OsSleepOnTimeout(&(pBTBuffer->BtReqWait), &(pBTBuffer->BtWakeup), 0);
-	pBTBuffer->BtWakeup       = 0;
-	pBTBuffer->BtReqWaiting = 0;
-	dbgprint ("out of sleep in bt_request for ch num: %d\n", pdev->ch_num);
-
-	if (__copy_to_user( (void *)pbuf, (void *)pBTBuffer->pBTRcvPkt,  pBTBuffer->BTRcvPktLen ))
+	/* The slot is not reused until Reading is cleared */
+	pReq = pQueue->Pkt [pQueue->Head];
+	Len = pQueue->Len [pQueue->Head];
+	pQueue->Reading = 1;
+	spin_unlock_irqrestore (&pQueue->Lock, flags);
+
+	ret = Len;
+	if (__copy_to_user( (void *)pbuf, (void *)pReq, Len ))
 	{
 		TCRIT ("bt_request(): copy to user failed\n");
-		return -EFAULT;
+		ret = -EFAULT;
 	}
-	return pBTBuffer->BTRcvPktLen;
+
+	spin_lock_irqsave (&pQueue->Lock, flags);
+	pQueue->Head = (pQueue->Head + 1) % BT_REQ_QUEUE_LEN;
+	pQueue->Count--;
+	pQueue->Reading = 0;
+	pBTBuffer->BtWakeup = (0 != pQueue->Count);
+	spin_unlock_irqrestore (&pQueue->Lock, flags);
+
+	return ret;
 }
 
 static ssize_t
@@ -383,7 +438,30 @@ bt_read (struct file *file, char __user *buf, size_t count, loff_t *ppos)
 {
 	struct bt_dev *pdev = (struct bt_dev*) file->private_data;
 	dbgprint ("bt_read: ch num: %d, priv data addr : %p\n", pdev->ch_num, file->private_data);		
-	return bt_request (pdev, buf);
+	return bt_request (pdev, buf, file->f_flags & O_NONBLOCK);
+}
+
+/**
+ * @brief Readable when a request is queued. Responses are handed to the
+ *        hardware from the write call, so the device is always writable.
+ **/
+static unsigned int
+bt_poll (struct file *file, poll_table *wait)
+{
+	struct bt_dev *pdev = (struct bt_dev*) file->private_data;
+	BTBuf_T *pBTBuffer = &pdev->pbt_hal->pbt_buf [pdev->ch_num];
+	BTReqQueue_T *pQueue = &pdev->pbt_hal->preq_queue [pdev->ch_num];
+	unsigned int mask = POLLOUT | POLLWRNORM;
+	unsigned long flags;
+
+	poll_wait (file, &(pBTBuffer->BtReqWait.queue), wait);
+
+	spin_lock_irqsave (&pQueue->Lock, flags);
+	if (0 != pQueue->Count)
+		mask |= POLLIN | POLLRDNORM;
+	spin_unlock_irqrestore (&pQueue->Lock, flags);
+
+	return mask;
 }
 
 static void 
@@ -432,6 +510,9 @@ process_bt_intr (int dev_id, unsigned char ch_num, int Error)
 {
 	struct bt_hal *pbt_hal = NULL;	
 	BTBuf_T *pBTBuffer = NULL;
+	BTReqQueue_T *pQueue = NULL;
+	unsigned long flags;
+	u8 Tail;
 
 	dbgprint ("dev_id in process_bt_intr = %d\n", dev_id);
 	pbt_hal = hw_intr (EDEV_TYPE_BT, dev_id);
@@ -441,6 +522,7 @@ process_bt_intr (int dev_id, unsigned char ch_num, int Error)
 		return -ENXIO;
 	}
 	pBTBuffer = &pbt_hal->pbt_buf [ch_num];
+	pQueue = &pbt_hal->preq_queue [ch_num];
 
 
 	if (Error == 0)
@@ -454,8 +536,30 @@ process_bt_intr (int dev_id, unsigned char ch_num, int Error)
 		pBTBuffer->pBTRcvPkt[0] = 0xFF;
 	}
 
+	/* Queue the request, on a full queue drop the oldest one, or this one
+	   if the oldest is being copied to the user */
+	spin_lock_irqsave (&pQueue->Lock, flags);
+	if (BT_REQ_QUEUE_LEN == pQueue->Count)
+	{
+		pQueue->Dropped++;
+		if (pQueue->Reading)
+		{
+			spin_unlock_irqrestore (&pQueue->Lock, flags);
+			dbgprint ("BT request queue full, dropping the new request\n");
+			return 0;
+		}
+		dbgprint ("BT request queue full, dropping the oldest request\n");
+		pQueue->Head = (pQueue->Head + 1) % BT_REQ_QUEUE_LEN;
+		pQueue->Count--;
+	}
+	Tail = (pQueue->Head + pQueue->Count) % BT_REQ_QUEUE_LEN;
+	memcpy (pQueue->Pkt [Tail], pBTBuffer->pBTRcvPkt, pBTBuffer->BTRcvPktLen);
+	pQueue->Len [Tail] = pBTBuffer->BTRcvPktLen;
+	pQueue->Count++;
+
 	/* Process BT Intr */
 	pBTBuffer->BtWakeup = 1;
+	spin_unlock_irqrestore (&pQueue->Lock, flags);
 	Bt_OsWakeupOnTimeout(&(pBTBuffer->BtReqWait));
 
 	return 0;
@@ -53,6 +53,7 @@ TDBG_DECLARE_DBGVAR(CDROM);
 /* Function Prototypes */
 static int CreateCdromDescriptor(uint8 DevNo);
 static int CdromIoctl (unsigned int cmd,unsigned long arg, int* RetVal);
+static int CdromMmap (unsigned long PgOff, struct vm_area_struct *vma, int* RetVal);
 static int FillDevInfo (IUSB_DEVICE_INFO* iUSBDevInfo);
 static int RemoteScsiCall(uint8 DevNo, uint8 ifnum, BOT_IF_DATA *MassData, uint8 LunNo);
 static int SetInterfaceAuthKey (uint8 DevNo, uint8 IfNum, uint32 Key);
@@ -68,6 +69,7 @@ static USB_DEV	UsbDev = {
 	.DevUsbFillDevInfo 			= FillDevInfo,
 	.DevUsbSetInterfaceAuthKey	= SetInterfaceAuthKey,
 	.DevUsbClearInterfaceAuthKey	= ClearInterfaceAuthKey,
+	.DevUsbMmap					= CdromMmap,
 						};
 static USB_CORE UsbCore;
 static USB_IUSB iUSB;
@@ -193,6 +195,7 @@ CdromIoctl (unsigned int cmd,unsigned long arg, int* RetVal)
 #endif
 	uint8 Instance;
 	IUSB_IOCTL_DATA IoctlData;
+	IUSB_RING_SLOT_REQ SlotReq;
 
 	switch (cmd)
 	{
@@ -224,6 +227,40 @@ CdromIoctl (unsigned int cmd,unsigned long arg, int* RetVal)
 		*RetVal = iUSB.iUSBScsiSendResponse((IUSB_SCSI_PACKET *)arg);
 		return 0;
 
+	case USB_CDROM_RES_SLOT:
+		TDBG_FLAGGED(CDROM, DEBUG_CDROM,"USB_CDROM_RES_SLOT IOCTL...\n");
+		if (AuthenticateIOCTLCaller (arg, RetVal, 1))
+		{
+			TWARN ("CdromIoctl(): Invalid Auth Key in USB_CDROM_RES_SLOT IOCTL\n");
+			return 0;
+		}
+		if (__copy_from_user((void *)(&SlotReq), (void*)arg, sizeof(IUSB_RING_SLOT_REQ)))
+		{
+			TWARN ("CdromIoctl(): __copy_from_user failed in USB_CDROM_RES_SLOT IOCTL\n");
+			*RetVal = -1;
+			return 0;
+		}
+		*RetVal = iUSB.iUSBScsiSlotResponse(IUSB_DEVICE_CDROM,
+						CDInstannceAssignment[SlotReq.Header.Instance], SlotReq.Slot);
+		return 0;
+
+	case USB_CDROM_QUEUE_SLOT:
+		TDBG_FLAGGED(CDROM, DEBUG_CDROM,"USB_CDROM_QUEUE_SLOT IOCTL...\n");
+		if (AuthenticateIOCTLCaller (arg, RetVal, 1))
+		{
+			TWARN ("CdromIoctl(): Invalid Auth Key in USB_CDROM_QUEUE_SLOT IOCTL\n");
+			return 0;
+		}
+		if (__copy_from_user((void *)(&SlotReq), (void*)arg, sizeof(IUSB_RING_SLOT_REQ)))
+		{
+			TWARN ("CdromIoctl(): __copy_from_user failed in USB_CDROM_QUEUE_SLOT IOCTL\n");
+			*RetVal = -1;
+			return 0;
+		}
+		*RetVal = iUSB.iUSBScsiQueueSlot(IUSB_DEVICE_CDROM,
+						CDInstannceAssignment[SlotReq.Header.Instance], SlotReq.Slot);
+		return 0;
+
 	case USB_CDROM_ACTIVATE:
 		TDBG_FLAGGED(CDROM, DEBUG_CDROM,"USB_CDROM_ACTIVATE IOCTL...\n");
 		if (AuthenticateIOCTLCaller (arg, RetVal, 0))
@@ -467,6 +504,29 @@ CdromIoctl (unsigned int cmd,unsigned long arg, int* RetVal)
 
 }
 
+/* Maps the response ring of an instance, see USB_CDROM_RING_PGOFF() */
+static int
+CdromMmap (unsigned long PgOff, struct vm_area_struct *vma, int* RetVal)
+{
+	uint8 Instance;
+
+	if ((PgOff < USB_CDROM_RING_PGOFF(0)) || (PgOff >= USB_CDROM_RING_PGOFF(MAX_LUN_SUPPORT)))
+		return -1;
+	Instance = (PgOff - USB_CDROM_RING_PGOFF(0)) >> USB_RING_PGOFF_SHIFT;
+	if (PgOff != USB_CDROM_RING_PGOFF(Instance))
+		return -1;
+
+	TDBG_FLAGGED(CDROM, DEBUG_CDROM,"CdromMmap(): Instance %d\n", Instance);
+	if ((CDInstannceAssignment[Instance] == 0xFF) || (0 == IfaceAuthKeys[0]))
+	{
+		TWARN ("CdromMmap(): Instance %d is not in use\n", Instance);
+		*RetVal = -EINVAL;
+		return 0;
+	}
+	*RetVal = iUSB.iUSBScsiRingMmap (IUSB_DEVICE_CDROM, CDInstannceAssignment[Instance], vma);
+	return 0;
+}
+
 static int
 CreateCdromDescriptor(uint8 DevNo)
 {
@@ -503,6 +563,7 @@ CreateCdromDescriptor(uint8 DevNo)
 	IfData->NoMediumRetries = MAX_NOMEDIUM_RETRIES;
 	IfData->ScsiDataOutLen		= 0;
 	IfData->LastSeqNo		= 0;	/* Invalid Seq No */
+	memset(&IfData->Stats, 0, sizeof(BOT_STATS));
     inquiry_data = sizeof(SCSI_INQUIRY_PACKET) * (MAX_LUN_SUPPORT + 1);
 
 	IfData->Inquiry = (SCSI_INQUIRY_PACKET*) vmalloc (inquiry_data);
@@ -96,6 +96,8 @@ uint32_t hw_device_ctl(unsigned int cmd ,unsigned int *buf,unsigned long data_si
 	int i;
   
   // These commands can be used without device id check.
+  if(cmd == IOCTL_JTAG_RUN_VECTORS)
+    return jtag_run_vectors(buf, data_size);
   
   for(i = 0; i<sizeof(device_list)/sizeof(device_list[0]); i++){
   	pDevice =(struct DEVICE_INFO *)&device_list[i];
@@ -12,21 +12,16 @@
 
 #include "jtag.h"
 #include "jtag_ioctl.h"
+#include "jed.h"
 
-
-#define assert(test,...) do{if(!(test)) printk(__VA_ARGS__);}while(0)
 //--------------------------------------------------
-// Change the string to hex.
+// JEDEC fuse file decoder.
+// The file is walked front to back once. The fuses of the L field at
+// address 0 (the configuration data) are decoded into the jtag write
+// buffer a row at a time, so the device code can program a row while the
+// next one is decoded. The fuse checksum is summed on the way.
 //--------------------------------------------------
-#define BITS_FSM_NONE     0
-#define BITS_FSM_READ     1
-#define BITS_FSM_RESET    2
-#define BITS_FSM_BITS     3
-#define BITS_FSM_PUSH_HighBIT '1'
-#define BITS_FSM_PUSH_ZeroBIT '0'
-#define BITS_FSM_END_MARK '*'
-
-#define FILE_STORE_BLOCK_SIZE (4096) //4K byte for one store block.
+#define FILE_STORE_BLOCK_SIZE (4096) //ETX is searched for in the last 4K byte.
 #define STX (0x02)
 #define ETX (0x03)
 
@@ -41,10 +36,35 @@ struct jed_head{
   unsigned int checksum;
   unsigned int user_data;
   //--------------------
-  char DeviceName[64];  
+  char DeviceName[64];
 };
 //-----------------------------------------------------
 struct jed_head jed_info={0};
+struct jed_timing jed_timing;
+
+//-----------------------------------------------------
+// decoder state
+//-----------------------------------------------------
+struct jed_stream{
+  const char *pos;            // next character to parse
+  const char *end;            // the ETX
+  unsigned int *cfg;          // configuration fuses, fuse n is bit n%32 of word n/32
+  unsigned int cfg_bits;      // configuration fuses decoded so far
+  int active;                 // the device code decodes the rows
+  int in_cfg;                 // inside the L field at address 0
+  int cfg_done;               // its '*' has been seen
+  int end_config;             // 1: NOTE END CONFIG DATA seen, 2: and the field after it
+  int have_checksum;
+  int have_usercode;
+  int xmit_checked;           // the transmission checksum after the ETX matched
+  // fuse checksum: 16 bit sum of the QF fuses as bytes, fuse 0 is bit 0 of
+  // byte 0, fuses not in any L field take the F field value
+  unsigned int fuse_next;     // next fuse address
+  unsigned int fuse_byte;     // fuses (fuse_next & ~7) .. fuse_next-1
+  unsigned int fuse_sum;
+  unsigned int fuse_default;
+};
+static struct jed_stream jed_stream;
 
 void init_jed_info(void){
   jed_info.QF = 0;
@@ -56,362 +76,513 @@ void init_jed_info(void){
 
 
 /*
- * get_ProgramUsercode 
+ * get_ProgramUsercode
  */
 uint32_t get_ProgramUsercode(void){
     return jed_info.user_data;
 }
 
 
+static inline int jed_is_space(char c){
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+
 /*
- * bitStr2hex_fsm 
+ * jed_fuse_add
+ * Add the next fuse to the fuse checksum.
  */
-static unsigned int bitStr2hex_fsm(unsigned int cmd){
-  static unsigned int data =0;
-  static unsigned int bits =0;
-  unsigned int ret = 0;
-
-  switch(cmd){
-  	
-    case BITS_FSM_BITS:
-    	ret = bits;
-      break;
-      
-    case BITS_FSM_RESET:
-      data = 0;
-      bits = 0;
+static inline void jed_fuse_add(struct jed_stream *s, unsigned int bit){
+  s->fuse_byte |= bit << (s->fuse_next & 7);
+  if((s->fuse_next & 7) == 7){
+    s->fuse_sum += s->fuse_byte;
+    s->fuse_byte = 0;
+  }
+  s->fuse_next++;
+}
+
+
+/*
+ * jed_fuse_fill
+ * Fuses up to 'to' are not listed, they take the default value.
+ */
+static void jed_fuse_fill(struct jed_stream *s, unsigned int to){
+  while(s->fuse_next < to && (s->fuse_next & 7) != 0)
+    jed_fuse_add(s, s->fuse_default);
+  if(to - s->fuse_next >= 8){
+    unsigned int bytes = (to - s->fuse_next) / 8;
+    if(s->fuse_default)
+      s->fuse_sum += 0xff * bytes;
+    s->fuse_next += bytes * 8;
+  }
+  while(s->fuse_next < to)
+    jed_fuse_add(s, s->fuse_default);
+}
+
+
+/*
+ * jed_number
+ * Read a decimal or hex number, return the number of digits.
+ */
+static int jed_number(struct jed_stream *s, int hex, unsigned int *value){
+  int digits = 0;
+  unsigned int v = 0;
+  char c;
+
+  while(s->pos < s->end){
+    c = *s->pos;
+    if(c >= '0' && c <= '9')
+      v = v * (hex ? 16 : 10) + (c - '0');
+    else if(hex && c >= 'A' && c <= 'F')
+      v = v * 16 + (c - 'A' + 10);
+    else if(hex && c >= 'a' && c <= 'f')
+      v = v * 16 + (c - 'a' + 10);
+    else
       break;
-      
-    case BITS_FSM_PUSH_HighBIT:
-      if(bits < 32){
-      	data |= 1 << bits;
-        bits++;
-      }
-      break;      
-      
-    case BITS_FSM_PUSH_ZeroBIT:
-      if(bits < 32){
-      	bits++;
+    s->pos++;
+    digits++;
+  }
+  *value = v;
+  return digits;
+}
+
+
+/*
+ * jed_match
+ * Consume 'str' if the input continues with it.
+ */
+static int jed_match(struct jed_stream *s, const char *str){
+  int len = strlen(str);
+
+  if(s->end - s->pos < len || strncmp(s->pos, str, len) != 0)
+    return 0;
+  s->pos += len;
+  return 1;
+}
+
+
+/*
+ * jed_skip_field
+ * Move past the '*' that ends the field.
+ */
+static int jed_skip_field(struct jed_stream *s){
+  while(s->pos < s->end && *s->pos != '*')
+    s->pos++;
+  if(s->pos >= s->end){
+    printk("Error!! field not terminated before the ETX\n");
+    return 1;
+  }
+  s->pos++;
+  return 0;
+}
+
+
+/*
+ * jed_decode_cfg
+ * Decode configuration fuses until 'target' fuses are in the buffer or the
+ * field ends.
+ */
+static int jed_decode_cfg(struct jed_stream *s, unsigned int target){
+  const char *p = s->pos;
+  const char *end = s->end;
+  unsigned int *cfg = s->cfg;
+  unsigned int n = s->cfg_bits;
+  unsigned int bit;
+  char c;
+
+  while(n < target && p < end){
+    c = *p++;
+    if(c == '0' || c == '1'){
+      if(n >= jed_info.QF){
+        printk("Error!! more fuses than QF%d\n", jed_info.QF);
+        return 1;
       }
+      bit = c - '0';
+      if((n & 31) == 0)
+        cfg[n >> 5] = 0;
+      cfg[n >> 5] |= bit << (n & 31);
+      jed_fuse_add(s, bit);
+      n++;
+    }
+    else if(c == '*'){
+      s->in_cfg = 0;
+      s->cfg_done = 1;
       break;
+    }
+    else if(!jed_is_space(c)){
+      printk("Error!! bad character 0x%02x in fuse data\n", (unsigned char)c);
+      return 1;
+    }
+  }
+  s->pos = p;
+  s->cfg_bits = n;
+  if(s->in_cfg && p >= end){
+    printk("Error!! fuse data not terminated before the ETX\n");
+    return 1;
+  }
+  return 0;
+}
 
-    case BITS_FSM_READ:
-      ret = data;
-      break;
-      
-    case '\n':
-    case '\r':
-      break;
-      
-    default://'*', '\0' or others.
-      ret = -1;
-      break;
+
+/*
+ * jed_skip_fuses
+ * Fuses outside the configuration data only go into the checksum.
+ */
+static int jed_skip_fuses(struct jed_stream *s){
+  char c;
+
+  while(s->pos < s->end){
+    c = *s->pos++;
+    if(c == '0' || c == '1'){
+      if(s->fuse_next >= jed_info.QF){
+        printk("Error!! more fuses than QF%d\n", jed_info.QF);
+        return 1;
+      }
+      jed_fuse_add(s, c - '0');
+    }
+    else if(c == '*')
+      return 0;
+    else if(!jed_is_space(c)){
+      printk("Error!! bad character 0x%02x in fuse data\n", (unsigned char)c);
+      return 1;
+    }
   }
-  return ret;
+  printk("Error!! fuse data not terminated before the ETX\n");
+  return 1;
+}
+
+
+/*
+ * jed_device_name
+ * NOTE DEVICE NAME: LCMXO2-1200ZE-1TG144C* keeps the part up to the last '-'.
+ */
+static void jed_device_name(struct jed_stream *s){
+  const char *pt_s = s->pos, *pt_e, *hyphen = 0;
+  int str_len;
+
+  while(pt_s < s->end && jed_is_space(*pt_s))
+    pt_s++;
+  for(pt_e = pt_s; pt_e < s->end && *pt_e != '*'; pt_e++)
+    if(*pt_e == '-')
+      hyphen = pt_e;
+  if(hyphen)
+    pt_e = hyphen;
+  str_len = pt_e - pt_s;
+  if(str_len >= sizeof(jed_info.DeviceName))
+    str_len = sizeof(jed_info.DeviceName) - 1;
+  memcpy(jed_info.DeviceName, pt_s, str_len);
+  jed_info.DeviceName[str_len] = '\0';
+  printk(" DeviceName:%s\n",jed_info.DeviceName);
+}
+
+
+/*
+ * jed_usercode
+ * UH<hex>, UA<ascii> or U<bits, MSB first>
+ */
+static int jed_usercode(struct jed_stream *s){
+  unsigned int user_data = 0;
+  char c;
+
+  if(*s->pos == 'H'){
+    s->pos++;
+    if(jed_number(s, 1, &user_data) == 0){
+      printk("Error!! bad UH field\n");
+      return 1;
+    }
+  }
+  else if(*s->pos == 'A'){
+    s->pos++;
+    while(s->pos < s->end && *s->pos != '*')
+      user_data = (user_data << 8) | (unsigned char)*s->pos++;
+  }
+  else{
+    while(s->pos < s->end && *s->pos != '*'){
+      c = *s->pos++;
+      if(c == '0' || c == '1')
+        user_data = (user_data << 1) | (c - '0');
+    }
+  }
+  jed_info.user_data = user_data;
+  s->have_usercode = 1;
+  printk("User Data read = 0x%08X.\n",user_data);
+  return 0;
 }
 
 
 /*
- * pick_bits 
- * return the get data size, the MSB means redundant bits, the 3 LSB means the number of bytes
- * This function not re-enterable.
+ * jed_parse_field
+ * Parse one field. The L field at address 0 is left open with in_cfg set,
+ * its fuses are decoded by jed_decode_cfg().
  */
-static unsigned int pick_bits(unsigned int hex_buf[],char* str,int range){
-		
-  //char *str = (char *)pt;
-  int i  __attribute__ ((unused)) =0;
-  unsigned int index=0;
-  unsigned int ret=0;
-
-  bitStr2hex_fsm( BITS_FSM_RESET );
-  //read until char is end(* or '\0')
-  while( bitStr2hex_fsm(str[0]) != -1 && range-- >0){
-  	if(bitStr2hex_fsm( BITS_FSM_BITS ) == 32) {
-  		hex_buf[index++] = bitStr2hex_fsm(BITS_FSM_READ);
-      bitStr2hex_fsm(BITS_FSM_RESET);
+static int jed_parse_field(struct jed_stream *s){
+  unsigned int value;
+  char id;
+
+  while(s->pos < s->end && jed_is_space(*s->pos))
+    s->pos++;
+  if(s->pos >= s->end)
+    return 0;
+
+  id = *s->pos++;
+  if(s->end_config == 1){
+    // the configuration data size is the address of an L field right after the note
+    if(id == 'L' && s->pos < s->end && *s->pos >= '0' && *s->pos <= '9'){
+      const char *pos = s->pos;
+      jed_number(s, 0, &value);
+      s->pos = pos;
+      printk(" Config data size read(bits) = %d.\n",value);
+      if(value != s->cfg_bits){
+        printk(" CFG_data_bits reading error.\n");
+        return 1;
       }
-      str++;
+    }
+    s->end_config = 2;
   }
-  ret=index << 2;
-  if(bitStr2hex_fsm( BITS_FSM_BITS ) != 0) {
-  	hex_buf[index++] = bitStr2hex_fsm(BITS_FSM_READ);
-    ret += bitStr2hex_fsm( BITS_FSM_BITS ) >> 3;
-    ret |= (bitStr2hex_fsm( BITS_FSM_BITS ) % 8) << 24;  //move the redundant bits in the MSB of "ret"
-    bitStr2hex_fsm(BITS_FSM_RESET);
+
+  switch(id){
+    case 'N':
+      if(jed_match(s, "OTE DEVICE NAME:"))
+        jed_device_name(s);
+      else if(jed_match(s, "OTE END CONFIG DATA") && s->end_config == 0)
+        s->end_config = 1;
+      break;
+
+    case 'Q':
+      if(*s->pos == 'F'){
+        s->pos++;
+        jed_number(s, 0, &jed_info.QF);
+        printk(" Number of fuses read = %d.\n",jed_info.QF);
+      }
+      break;
+
+    case 'F':
+      if(jed_number(s, 0, &value) == 0 || value > 1){
+        printk("Error!! bad F field\n");
+        return 1;
+      }
+      s->fuse_default = value;
+      break;
+
+    case 'L':
+      if(jed_number(s, 0, &value) == 0){
+        printk("Error!! bad L field\n");
+        return 1;
+      }
+      if(jed_info.QF == 0){
+        printk("QF not found!!!");
+        return 1;
+      }
+      if(value < s->fuse_next || value > jed_info.QF){
+        printk("Error!! L%d out of order\n", value);
+        return 1;
+      }
+      jed_fuse_fill(s, value);
+      if(value == 0){
+        s->in_cfg = 1;
+        return 0;
+      }
+      return jed_skip_fuses(s);
+
+    case 'C':
+      if(jed_number(s, 1, &jed_info.checksum) == 0){
+        printk(" Checksum not found!!!");
+        return 1;
+      }
+      s->have_checksum = 1;
+      printk(" Checksum read = %X.\n",jed_info.checksum);
+      break;
+
+    case 'U':
+      if(jed_usercode(s) != 0)
+        return 1;
+      break;
+
+    default:
+      // G, E, QP, J, X, V ... do not change the configuration
+      break;
   }
-  return ret;
+  return jed_skip_field(s);
 }
 
 
 /*
- * check_jed_mark 
- * check the jed file
- * jed file start code = STX:: 0x02.
- * jed file end code = ETX:: 0x03.
- * store_block_size
+ * jed_stream_begin
+ * Check the STX/ETX marks and the transmission checksum, parse the header
+ * up to the configuration fuses.
  */
-unsigned int check_jed_mark(const char* jed_str, unsigned long size){
-	int i, loop_end;
-  unsigned int ret = 0;
-  //--------------------------------------------------------
+static int jed_stream_begin(const char *jed_str, unsigned long size, unsigned int *out){
+  struct jed_stream *s = &jed_stream;
+  unsigned int xmit = 0, sum = 0;
+  long i, loop_end;
+  int ret = 0;
+  ktime_t start;
 
+  JED_TIME_START(start);
+  memset(s, 0, sizeof(*s));
   do{
-  	if(jed_str[0] != STX) {
-  		printk("Error!! can't found the STX\n");
+    if(size < 2 || jed_str[0] != STX){
+      printk("Error!! can't found the STX\n");
       ret = 1;
       break;
     }
-    
-    loop_end = size - FILE_STORE_BLOCK_SIZE; 
-    
-    for (i=size-1;i>0 && i>loop_end;i--){
-      if((unsigned int)jed_str[i] == ETX )
-      {
-      	//printk("Found the ETX.\n");
+    loop_end = (long)size - FILE_STORE_BLOCK_SIZE;
+    for(i = size - 1; i > 0 && i > loop_end; i--)
+      if(jed_str[i] == ETX)
         break;
-      }
-    }
     if(i <= 0 || i <= loop_end){
-    	printk("Error!! can't found the ETX\n");
+      printk("Error!! can't found the ETX\n");
       ret = 1;
       break;
     }
+    s->pos = jed_str + 1;
+    s->end = jed_str + i;
 
-  } while(0);
-  //------------------------------------------------------------
-  //echo_arry(&jed_str[(i& ~0xff)],SHIFT_BACK_SIZE);
+    // 16 bit sum of STX..ETX, as 4 hex digits after the ETX, 0000 if not computed
+    s->pos = s->end + 1;
+    s->end = jed_str + size;
+    if(jed_number(s, 1, &xmit) == 4 && xmit != 0){
+      for(loop_end = 0; loop_end <= i; loop_end++)
+        sum += (unsigned char)jed_str[loop_end];
+      if((sum & 0xffff) != xmit){
+        printk("Error!! transmission checksum %04X, file has %04X\n", sum & 0xffff, xmit);
+        ret = 1;
+        break;
+      }
+      s->xmit_checked = 1;
+    }
+    s->pos = jed_str + 1;
+    s->end = jed_str + i;
+
+    // the design specification field, then the fields up to L0
+    if(jed_skip_field(s) != 0){
+      ret = 1;
+      break;
+    }
+    s->cfg = out;
+    while(!s->in_cfg){
+      if(s->pos >= s->end){
+        printk("Data string address not found!!!");
+        ret = 1;
+        break;
+      }
+      if(jed_parse_field(s) != 0){
+        ret = 1;
+        break;
+      }
+    }
+  }while(0);
+  s->active = (ret == 0);
+  JED_TIME_ADD(jed_timing.parse, start);
   return ret;
 }
 
 
 /*
- * jed_2_hex 
+ * jed_stream_active
  */
-int jed_2_hex(char* jed_str, unsigned long* size){
-	
-  int ret;
-  unsigned int shift __attribute__ ((unused)) =0;
-  unsigned int checksum;
-  unsigned int QF;
-  unsigned int cfg_data_size;
-  unsigned int user_data;
-  unsigned int checksum_count;
-  unsigned char redunant_bits;
-  int i __attribute__ ((unused)) ;
-  char str_patten[64];
-  char* jed_str_end=jed_str + *size ;
-  char* pt_str;//point the string start.
-	char *data_CFG = (char *)get_jtag_write_buffer();
-  char *pt_s,*pt_e;
-
-  ret = check_jed_mark(jed_str, *size);
-  if(ret != 0) return ret;
-  if(data_CFG == NULL){
-  	return 1;
+int jed_stream_active(void){
+  return jed_stream.active;
+}
+
+
+/*
+ * jed_stream_next_row
+ * Decode the next 'bits' configuration fuses into the write buffer.
+ */
+int jed_stream_next_row(unsigned int bits){
+  struct jed_stream *s = &jed_stream;
+  unsigned int row_start = s->cfg_bits;
+  int ret = 1;
+  ktime_t start;
+
+  JED_TIME_START(start);
+  if(!s->active || bits == 0)
+    ret = -1;
+  else if(s->in_cfg && jed_decode_cfg(s, row_start + bits) != 0)
+    ret = -1;
+  else if(s->cfg_bits == row_start)
+    ret = 0;
+  else if(s->cfg_bits != row_start + bits){
+    printk(" Data size = %d bits, not a whole number of rows\n", s->cfg_bits);
+    ret = -1;
   }
-  
-	do{
-        //--------------------------------------------------------------------------------------
-		//--------------------------------------------------------------------------------------
-		// find patten [NOTE DEVICE NAME:].
-		// and get string to last '-'.
-		//--------------------------------------------------------------------------------------
-		snprintf(str_patten,sizeof(str_patten),"\nNOTE DEVICE NAME:");
-		pt_str = strstr(jed_str,str_patten);
-		if(((unsigned int)pt_str <= 1 )|| ((unsigned int)pt_str > (unsigned int)jed_str_end)){
-			printk("DEVICE NAME not found!!![%p].",pt_str );
-		  break;
-		}
-		else{// find the last hyphen.
-		  int str_len=0;
-		  char tmp;
-		  const int buf_size = sizeof(jed_info.DeviceName);
-		  //------------------------------------------------
-		  pt_s = pt_str +strlen(str_patten)+1;
-		  pt_e = strchr( pt_s,'*');
-		  str_len = pt_e - pt_s;
-		  if (str_len >  buf_size){
-		  	str_len = buf_size;
-		  }
-		  tmp = pt_s [str_len-1];
-		  pt_s [str_len-1] = '\0';
-		  pt_e = strrchr( pt_s,'-');
-		  pt_s [str_len-1] =tmp;
-		  str_len = pt_e - pt_s;
-		  if (str_len >= buf_size ){
-		    str_len = buf_size-1;
-		  }
-		  strncpy(jed_info.DeviceName ,pt_s,str_len);
-		  printk(" DeviceName:%s\n",jed_info.DeviceName);
-		}
-		//--------------------------------------------------------------------------------------
-		// find patten [QF].
-		// Get number of fuses in device.
-		//--------------------------------------------------------------------------------------
-		snprintf(str_patten,sizeof(str_patten),"\nQF");
-		pt_str = strstr(jed_str,str_patten);
-		
-		if(((unsigned int)pt_str <= 1 )|| ((unsigned int)pt_str > (unsigned int)jed_str_end)){
-			assert((unsigned int)pt_str < (unsigned int)jed_str_end,"error pt_str > jed_str_end!!\n%p > %p\n", pt_str, jed_str_end);
-		  printk("QF not found!!!");
-		  break;
-		}
-		else{
-		  pt_s = pt_str +strlen(str_patten)+1;
-		  pt_e = strchr( pt_s,'*');
-		
-		  pt_s = pt_str +strlen(str_patten);
-		  sscanf((char *)pt_s,"%d*",&QF);
-		  printk(" Number of fuses read = %d.\n",QF);
-		  jed_info.QF = QF ;
-		}
-		
-		//--------------------------------------------------------------------------------------
-		// find patten [L00000].
-		// Bit Data string start.
-		//--------------------------------------------------------------------------------------
-		// make PATTEN
-		snprintf(str_patten,sizeof(str_patten),"\nL00000");//block
-		// search PATTEN and get first position in jed_str. return 0 mean PATTEN not found in string.
-		pt_str = strstr(jed_str,str_patten);
-		
-		if(((unsigned int)pt_str <= 1 )|| ((unsigned int)pt_str > (unsigned int)jed_str_end)){
-		  printk("Data string address not found!!!");
-		  ret = -1;
-		  break;
-		}
-		else{
-		  //For pick_bits function, we need modify point position.(Move to end of PATTEN +1, 1 for \r)
-		  pt_s = pt_str +strlen(str_patten)+1;
-		  shift = 0;
-		  shift += pick_bits(((void *) data_CFG)+shift, pt_s,/*size*/(unsigned int)jed_str_end - (unsigned int)pt_s );
-		  redunant_bits= (unsigned char)(shift >> 24);
-		  shift &= 0x00ffffff;
-		  jed_info.CFG_data_bits = shift*8 + redunant_bits;	
-		  
-		  printk(" Data size = %d bits\n",jed_info.CFG_data_bits );
-		}
-		//--------------------------------------------------------------------------------------
-		// find patten [NOTE END CONFIG DATA].
-		// Get config data size(bits).
-		//--------------------------------------------------------------------------------------
-		snprintf(str_patten,sizeof(str_patten),"END CONFIG DATA*");
-		pt_str = strstr(jed_str,str_patten);
-		
-		if(((unsigned int)pt_str <= 1 )|| ((unsigned int)pt_str > (unsigned int)jed_str_end)){
-		  assert((unsigned int)pt_str < (unsigned int)jed_str_end,"error pt_str > jed_str_end!!\n%p > %p\n",pt_str , jed_str_end);
-		  printk("No CONFIG DATA.\n");
-		  if( jed_info.CFG_data_bits != jed_info.QF){
-		  	if((jed_info.QF - jed_info.CFG_data_bits ) < 8){
-				
-			}else{
-		  	printk(" CFG_data_bits reading error.\n");
-		    ret = -1;
-		    break;
-		  }
-		  }
-		  //printk("CONFIG DATA size not found!!!");
-		}
-		else{
-			pt_s = pt_str +strlen(str_patten)+1;
-		
-		  sscanf((char *)pt_s,"\nL%06d*",&cfg_data_size);
-		  printk(" Config data size read(bits) = %d.\n",cfg_data_size);
-		  if( jed_info.CFG_data_bits != cfg_data_size){
-		  	printk(" CFG_data_bits reading error.\n");
-		    ret = -1;
-		    break;
-		  }
-		}
-		
-		//--------------------------------------------------------------------------------------
-		// find patten [C].
-		// Get Checksum.
-		//--------------------------------------------------------------------------------------
-		snprintf(str_patten,sizeof(str_patten),"\nQF");
-		pt_str = strstr(jed_str,str_patten);
-		
-		snprintf(str_patten,sizeof(str_patten),"\nC");
-		pt_str = strstr(pt_str,str_patten);
-		
-		if(((unsigned int)pt_str <= 1 )|| ((unsigned int)pt_str > (unsigned int)jed_str_end)){
-			assert((unsigned int)pt_str < (unsigned int)jed_str_end,"error pt_str > jed_str_end!!\n%d > %d\n",(unsigned int)pt_str , (unsigned int)jed_str_end);
-		  printk(" Checksum not found!!!");
-		  ret = -1;
-		  break;
-		}
-		else{
-		  pt_s = pt_str +strlen(str_patten);
-		  sscanf((char *)pt_s,"%04X*",&checksum);
-		  printk(" Checksum read = %X.\n",checksum);
-		  jed_info.checksum = checksum;
-		}
-		//--------------------------------------------------------------------------------------
-		// find patten [UH].
-		// Get User Data.
-		//--------------------------------------------------------------------------------------
-		snprintf(str_patten,sizeof(str_patten),"\nQF");
-		pt_str = strstr(jed_str,str_patten);
-		
-		snprintf(str_patten,sizeof(str_patten),"\nU");
-		pt_str = strstr(pt_str,str_patten);
-		
-		if(((unsigned int)pt_str <= 1 )|| ((unsigned int)pt_str > (unsigned int)jed_str_end)){
-		  assert((unsigned int)pt_str < (unsigned int)jed_str_end,"error pt_str > jed_str_end!!\n%p > %p\n", pt_str, jed_str_end);
-		  ///printk("User Data not found!!!\n");
-		  ret = -1;
-		  break;
-		}
-		else{
-		  pt_s = pt_str +strlen(str_patten);
-		  //Hex or bits
-		  if(*pt_s == 'H' ){
-		  	pt_s++;
-		    sscanf((char *)pt_s,"%08X*",&user_data);
-		  }
-		  else{
-		    //shift = 0;
-		    //shift += pick_bits(((void *) &user_data)+shift, pt_s,/*size*/32);
-		    //printk(" UserData size = %d\n",shift );
-        user_data = 0;
-        for( i=0; i<32; i++ ){
-          user_data <<=1;
-          if(pt_s[i]=='1') user_data |=1;
-        }
-		  }
-		
-		  printk("User Data read = 0x%08X.\n",user_data);
-		  jed_info.user_data = user_data;
-		}
-		//--------------------------------------------------------------------------------------
-		// checksum_count
-		//--------------------------------------------------------------------------------------
-		{
-			int i=0;
-		  unsigned char* pt=(void*)data_CFG;
-		  int len =jed_info.CFG_data_bits / 8;
-		  checksum_count = 0;
-		
-		  if(jed_info.QF%8 != 0)
-		    len++;
-		  
-		  for (i=0;i<len;i++){
-		  	checksum_count +=*pt++;
-		  }
-		  checksum_count &= 0xffff;
-		  printk(" Checksum count  = %X.\n", checksum_count);
-		
-		  if(checksum_count!=checksum){
-		    printk(" CheckSum Error!!\n");
-		    ret = -1;
-		    break; //ret <0;
-		  }
-		}
-	}while(0);
-        
-	if(data_CFG != (char *)get_jtag_write_buffer() ) kfree(data_CFG);
-
-	return (ret < 0)?1:0;
+  if(ret < 0)
+    s->active = 0;
+  // rows after the first are decoded while the device programs the one before
+  start = ktime_sub(ktime_get(), start);
+  jed_timing.parse = ktime_add(jed_timing.parse, start);
+  if(row_start != 0)
+    jed_timing.overlap = ktime_add(jed_timing.overlap, start);
+  return ret;
+}
+
+
+/*
+ * jed_stream_finish
+ */
+int jed_stream_finish(void){
+  struct jed_stream *s = &jed_stream;
+  unsigned int col = JTAG_device_information.Device_Column_Length;
+  int ret = 0;
+  ktime_t start;
+
+  JED_TIME_START(start);
+  do{
+    if(!s->active){
+      ret = 1;
+      break;
+    }
+    s->active = 0;
+    if(s->in_cfg && jed_decode_cfg(s, ~0U) != 0){
+      ret = 1;
+      break;
+    }
+    while(s->pos < s->end && ret == 0)
+      ret = jed_parse_field(s);
+    if(ret != 0)
+      break;
+
+    jed_info.CFG_data_bits = s->cfg_bits;
+    printk(" Data size = %d bits\n",jed_info.CFG_data_bits );
+    if(s->end_config == 0 && jed_info.QF - jed_info.CFG_data_bits >= 8){
+      printk("No CONFIG DATA.\n");
+      printk(" CFG_data_bits reading error.\n");
+      ret = 1;
+      break;
+    }
+    if(!s->have_checksum){
+      printk(" Checksum not found!!!");
+      ret = 1;
+      break;
+    }
+    if(!s->have_usercode){
+      printk("User Data not found!!!\n");
+      ret = 1;
+      break;
+    }
+
+    jed_fuse_fill(s, jed_info.QF);
+    if(jed_info.QF & 7)
+      s->fuse_sum += s->fuse_byte;
+    s->fuse_sum &= 0xffff;
+    printk(" Checksum count  = %X.\n", s->fuse_sum);
+    if(s->fuse_sum != jed_info.checksum){
+      printk(" CheckSum Error!!\n");
+      ret = 1;
+      break;
+    }
+
+    //Set device row if the fuse number is same.
+    //check CFG_data_bits % col == 0
+    if(col == 0 || (jed_info.CFG_data_bits % col) != 0){
+      ret = 1;
+      break;
+    }
+    JTAG_device_information.Device_Row_Length = jed_info.CFG_data_bits / col;
+  }while(0);
+  JED_TIME_ADD(jed_timing.parse, start);
+  return ret;
 }
 
 
@@ -422,37 +593,46 @@ int jed_2_hex(char* jed_str, unsigned long* size){
 unsigned int jed_program(char* jed_str, unsigned long size){
 	unsigned int ret = 0;
   unsigned int row_num = JTAG_device_information.Device_Row_Length;
-   
+
   init_jed_info();
+  memset(&jed_timing, 0, sizeof(jed_timing));
 
-  ret = jed_2_hex(jed_str, &size);
+  do{
+    ret = jed_stream_begin(jed_str, size, get_jtag_write_buffer());
+    if(ret != 0)
+      break;
+    //Jedec file QF not equal Device fuses.
+    if(JTAG_device_information.Device_Fuses_Length != jed_info.QF){
+      printk("Device Fuses Length not match with Jed file.\n");
+      ret = 1;
+      break;
+    }
+    if(!jed_stream.xmit_checked){
+      // Nothing vouches for the file yet, check all of it before the device
+      // is erased.
+      ret = jed_stream_finish();
+      break;
+    }
+    // Rows are decoded as they are programmed, the file decides how many.
+    JTAG_device_information.Device_Row_Length =
+      JTAG_device_information.Device_All_Bits_Length / JTAG_device_information.Device_Column_Length;
+  }while(0);
   if(ret != 0){
-  	printk("Error in Jed to Hex conver.\n");
-    return ret;
-  }
-  //Jedec file QF not equal Device fuses.
-  if(JTAG_device_information.Device_Fuses_Length != jed_info.QF){
-    printk("Device Fuses Length not match with Jed file.\n");
-    ret = 1;
+    jed_stream.active = 0;
+    printk("Error in Jed to Hex conver.\n");
+    JTAG_device_information.Device_Row_Length = row_num;
     return ret;
   }
-  
-  do{
-  	//Set device row if the fuse number is same.
-		//check CFG_data_bits % col == 0
-		if( (jed_info.CFG_data_bits % JTAG_device_information.Device_Column_Length) == 0){
-			JTAG_device_information.Device_Row_Length = jed_info.CFG_data_bits / JTAG_device_information.Device_Column_Length;
-		}
-		else {
-			ret = 1;
-			break;
-		}
-		//program it!! device function.
-		ret = hw_device_ctl(IOCTL_JTAG_PROGRAM_DEVICE,(void*)get_jtag_write_buffer(), jed_info.CFG_data_bits);
-		
-  }while(0);
+
+  //program it!! device function.
+  ret = hw_device_ctl(IOCTL_JTAG_PROGRAM_DEVICE,(void*)get_jtag_write_buffer(), jed_info.CFG_data_bits);
+  jed_stream.active = 0;
+
   //set device row back;
   JTAG_device_information.Device_Row_Length = row_num;
-  
+
+  printk("JED parse %lu us (%lu us while programming), erase %lu us, program %lu us, verify %lu us\n",
+    JED_TIME_US(jed_timing.parse), JED_TIME_US(jed_timing.overlap), JED_TIME_US(jed_timing.erase),
+    JED_TIME_US(jed_timing.program), JED_TIME_US(jed_timing.verify));
   return ret;
 }
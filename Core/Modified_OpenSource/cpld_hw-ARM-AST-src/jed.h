@@ -0,0 +1,54 @@
+/****************************************************************
+ **                                                            **
+ **    (C)Copyright 2006-2009, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross              **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+****************************************************************/
+
+#ifndef _JED_H_
+#define _JED_H_
+
+#include <linux/ktime.h>
+
+// Time spent in each phase of the last jed_program(). Summed as ktime_t,
+// a row takes well under a microsecond to decode.
+struct jed_timing{
+  ktime_t parse;      // decoding the JEDEC file, overlap included
+  ktime_t overlap;    // decoding rows while the device programmed the previous one
+  ktime_t erase;
+  ktime_t program;    // rows and usercode, overlap included
+  ktime_t verify;
+};
+extern struct jed_timing jed_timing;
+
+#define JED_TIME_START(start)      ((start) = ktime_get())
+#define JED_TIME_ADD(field, start) ((field) = ktime_add((field), ktime_sub(ktime_get(), (start))))
+#define JED_TIME_US(field)         ((unsigned long)ktime_to_us(field))
+
+/*
+ * The fuse rows of an IOCTL_JTAG_UPDATE_DEVICE file are decoded into the
+ * jtag write buffer while the device programs them. When jed_stream_active()
+ * the device code calls jed_stream_next_row() before each row it shifts in
+ * and jed_stream_finish() before it programs the usercode, which needs the
+ * end of the file.
+ *
+ * jed_stream_next_row(): 1 when the next row of 'bits' fuses is in the write
+ *                        buffer, 0 at the end of the configuration data,
+ *                        -1 on a malformed file.
+ * jed_stream_finish():   decodes the rest of the file, checks the fuse
+ *                        checksum and sets Device_Row_Length to the rows of
+ *                        the file. 0 when the file is good.
+ */
+extern int jed_stream_active(void);
+extern int jed_stream_next_row(unsigned int bits);
+extern int jed_stream_finish(void);
+
+extern unsigned int jed_program(char* jed_str, unsigned long size);
+extern uint32_t get_ProgramUsercode(void);
+
+#endif /* _JED_H_ */
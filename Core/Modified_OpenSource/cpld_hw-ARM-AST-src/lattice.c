@@ -21,6 +21,7 @@
 #include "jtag_ioctl.h"
 #include "ast_jtag.h"
 #include "lattice.h"
+#include "jed.h"
 
 #define DEVICE_FAMILY_FUNC(func_id) context->func(func_id, 0, context)
 
@@ -31,8 +32,6 @@
 
 int device_MACHOX(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO * const);
 int device_MACHOX2(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const context);
-extern unsigned int jed_program(char* , unsigned long );
-extern uint32_t get_ProgramUsercode(void);
 
 
 enum device_cmd{
@@ -135,6 +134,11 @@ uint32_t device_data_check(unsigned int* read_buffer, unsigned int* compare_data
 		ret = chksum;
 	}
 	else{
+		/* rows are padded to whole words, same layout as the checksum above */
+		if((JTAG_device_information.Device_Column_Length%32) != 0)
+			leng = (JTAG_device_information.Device_Column_Length/32+1)*JTAG_device_information.Device_Row_Length;
+		else
+			leng = (bits_leng + 31) / 32;
 		for (i = 0; i < leng; i++) {
 			if (read_buffer[i] != compare_data[i]) {
 				printk ("VERIFY ERROR!! ERROR at Index %08x\n", i);
@@ -222,6 +226,7 @@ int device_MACHOX(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const cont
   int ret = 0;
   int i = 0;
 //  uint32_t Tdo_32bits;
+  ktime_t start;
   unsigned int Device_All_Rows=0;
   unsigned int Device_Using_Rows=0;
   //---------------------------------------------------------
@@ -370,6 +375,11 @@ int device_MACHOX(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const cont
 		  break;
 		  
 		case DeviceFamily_Program:
+		  // The row loop below needs the row count up front, decode all of a JEDEC file first
+		  if (jed_stream_active() && jed_stream_finish() != 0) {
+		  	ret = 1;
+		  	break;
+		  }
 		  if(g_program_mode_cnt == 0){
         ast_jtag_reset();
             
@@ -380,6 +390,7 @@ int device_MACHOX(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const cont
 		  
 		  DEVICE_FAMILY_FUNC(DeviceFamily_ProgramMode_Enter);
       
+      JED_TIME_START(start);
       if ( DEVICE_FAMILY_FUNC(DeviceFamily_Erase) != 0 ) {
       	printk ("ERASE CHIP FAILED!! Please Check if the JTAG Device is in the support list and the JTAG connector\n");
         ret = 1; /* Fortify issue :: False Positive */ 
@@ -387,6 +398,8 @@ int device_MACHOX(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const cont
         DEVICE_FAMILY_FUNC(DeviceFamily_ProgramMode_Exit);
         break;
       }
+      JED_TIME_ADD(jed_timing.erase, start);
+      JED_TIME_START(start);
       
       //! Shift in READ STATUS(0xB2) instruction
       SIR(8, READ_STATUS);
@@ -491,8 +504,11 @@ int device_MACHOX(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const cont
       TDI = 0; TDO = 0;
       SDR(1,&TDI,&TDO);
       //-----------------------------------------------
+      JED_TIME_ADD(jed_timing.program, start);
       
+      JED_TIME_START(start);
       ret = context->func(DeviceFamily_Verify, buf, context);
+      JED_TIME_ADD(jed_timing.verify, start);
 
       if(ret != 0){
       	if (g_program_retry_cnt < JTAG_PROGRAM_RETRY_MAX){
@@ -578,6 +594,8 @@ int device_MACHOX2(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const con
   int ret = 0;
   int i = 0;
   uint32_t Tdo_32bits;  
+  uint32_t Feature[2] = { 0xFFFFFFFF, 0xFFFFFFFF };
+  ktime_t start;
   unsigned int Device_All_Rows=0;
   unsigned int Device_Using_Rows=0;
   //---------------------------------------------------------
@@ -645,8 +663,7 @@ int device_MACHOX2(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const con
       //! Shift in LSC_READ_FEATURE (0xE7) instruction
       SIR(8, LSC_READ_FEATURE);
       RUNTEST_IDLE(2, 1);
-      TDI = 0xFFFFFFFF;
-      SDR(64, &TDI, 0);
+      SDR(64, Feature, 0);
       //! Shift in in LSC_READ_FEABITS(0xFB) instruction                
       SIR(8, LSC_READ_FEABITS);
       RUNTEST_IDLE(2, 1);
@@ -731,8 +748,7 @@ int device_MACHOX2(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const con
       //! Shift in LSC_READ_FEATURE (0xE7) instruction
       SIR(8, LSC_READ_FEATURE);
       RUNTEST_IDLE(2, 1);
-      TDI = 0xFFFFFFFF;
-      SDR(64, &TDI, 0);
+      SDR(64, Feature, 0);
       //! Shift in in LSC_READ_FEABITS(0xFB) instruction
       SIR(8, LSC_READ_FEABITS);
       RUNTEST_IDLE(2, 1);
@@ -760,6 +776,7 @@ int device_MACHOX2(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const con
 
 		  DEVICE_FAMILY_FUNC(DeviceFamily_ProgramMode_Enter);
 
+      JED_TIME_START(start);
       if ( DEVICE_FAMILY_FUNC(DeviceFamily_Erase) != 0 ) {
       	printk ("ERASE CHIP FAILED!! Please Check if the JTAG Device is in the support list and the JTAG connector\n");
         ret = 1; 
@@ -767,7 +784,9 @@ int device_MACHOX2(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const con
         DEVICE_FAMILY_FUNC(DeviceFamily_ProgramMode_Exit);
         break;
       }
+      JED_TIME_ADD(jed_timing.erase, start);
       printk ("Starting to Program Device . . . (this will take a few seconds)\n");
+      JED_TIME_START(start);
       //===============================================
       //    Program CFG
       //! Shift in LSC_INIT_ADDRESS(0x46) instruction 
@@ -780,11 +799,18 @@ int device_MACHOX2(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const con
       	uint32_t Row  = 1;
         unsigned long index = 0;
         unsigned long row_count, col_count;
+        int streaming = jed_stream_active();
+        int next_row = 0;
         // initial all variables
         row_count = JTAG_device_information.Device_Row_Length;
         col_count = JTAG_device_information.Device_Column_Length;
+        // Rows of a JEDEC file are decoded into buf one ahead of programming
+        if (streaming)
+        	next_row = jed_stream_next_row(col_count);
 
         while (row_count > 0) {
+          if (streaming && next_row <= 0)
+          	break;
         	//-------------------------------------------------------------------------------
           //Jtag only, check the row is not empty, when empty data, reset address.
           #ifdef JTAG_PROGRAM_DEBUG_NOT_SVF
@@ -810,6 +836,9 @@ int device_MACHOX2(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const con
           	SDR(col_count, (void *)(&(buf[index])),(void*)0);
           	RUNTEST_IDLE(2,0);
           	//-------------------------------------------------------------------------------
+          	//decode the next row while the device programs this one
+          	if (streaming)
+          		next_row = jed_stream_next_row(col_count);
           	//! Shift in LSC_CHECK_BUSY(0xF0) instruction
           	SIR(8, LSC_CHECK_BUSY);
             //LOOP_RUNTEST_IDLE
@@ -826,6 +855,16 @@ int device_MACHOX2(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const con
           Row++;
           row_count--;
         }
+        // The usercode and the fuse checksum follow the rows in the file.
+        // Leave the device erased if the rest of the file is bad.
+        if (streaming && (next_row != 0 || jed_stream_finish() != 0)) {
+        	printk ("JED file error after %d rows, the device is left erased\n", (int)(Row - 1));
+        	DEVICE_FAMILY_FUNC(DeviceFamily_Erase);
+        	ret = 1;
+        	g_program_mode_cnt  = 1;
+        	DEVICE_FAMILY_FUNC(DeviceFamily_ProgramMode_Exit);
+        	break;
+        }
       }
       //===============================================
       ///Program USERCODE
@@ -853,9 +892,12 @@ int device_MACHOX2(uint32_t cmd,unsigned int* buf, struct DEVICE_INFO* const con
       SDR(32, &TDI,&TDO);
 
       if((TDO& 0x00003000) != 0) printk("Program USERCODE status fail![%x]\n",(TDO& 0x00003000));
+      JED_TIME_ADD(jed_timing.program, start);
       
       //Verify
+      JED_TIME_START(start);
       ret = context->func(DeviceFamily_Verify, buf, context);
+      JED_TIME_ADD(jed_timing.verify, start);
             
       if(ret != 0){
       	if (g_program_retry_cnt < JTAG_PROGRAM_RETRY_MAX){
@@ -975,6 +1017,10 @@ uint32_t hw_device_ctl(unsigned int cmd ,unsigned int *buf,unsigned long data_si
   struct DEVICE_INFO *pDevice = 0;
   int i;
 
+  // Vector lists are run on whatever device is on the chain
+  if(cmd == IOCTL_JTAG_RUN_VECTORS)
+    return jtag_run_vectors(buf, data_size);
+
   for(i = 0; i<sizeof(device_list)/sizeof(device_list[0]); i++){
   	pDevice =(struct DEVICE_INFO *)&device_list[i];
     if(pDevice == NULL)
@@ -0,0 +1,301 @@
+/****************************************************************
+ **                                                            **
+ **    (C)Copyright 2006-2009, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross              **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+****************************************************************/
+
+/*
+ * JEDEC programming simulator
+ *
+ * Runs jed.c and the MachXO2 flow of lattice.c on ast_jtag.c against the
+ * TAP simulator of jtag_hw-ARM-AST-src/tools. Each file in tools/samples
+ * is sent through IOCTL_JTAG_UPDATE_DEVICE as the jtag core does. After
+ * each one the flash, usercode and DONE bit of the simulated LCMXO2-1200ZE
+ * are checked. A generated full size file is timed per phase. Reported
+ * times are host time plus the simulated delays.
+ *
+ * Build and run from cpld_hw-ARM-AST-src:
+ *   gcc -O2 -Wall -I../jtag_hw-ARM-AST-src/tools/include -I../jtag_hw-ARM-AST-src/tools \
+ *       -I../jtag_hw-ARM-AST-src -I. -DCONFIG_SPX_FEATURE_LATTICE_LCMXO2_SUPPORT \
+ *       tools/jed_sim.c jed.c lattice.c ../jtag_hw-ARM-AST-src/ast_jtag.c \
+ *       ../jtag_hw-ARM-AST-src/tools/tap_sim.c -o jed_sim
+ *   ./jed_sim [-v] [samples directory]
+ */
+
+#include <unistd.h>
+#include "tap_sim.h"
+#include "driver_hal.h"
+#include "jtag.h"
+#include "jtag_ioctl.h"
+#include "ast_jtag.h"
+#include "lattice.h"
+#include "jed.h"
+
+#define SIM_IDCODE	LATTICE_CPLD_LCMXO2_1200ZE_IDCODE
+#define SIM_ROWS	LATTICE_ROWS_LCMXO2_1200ZE_LENGTH
+#define SIM_QF		LATTICE_FUSES_LCMXO2_1200ZE_LENGTH
+#define OLD_USERCODE	0x11111111
+
+#define FAIL(fmt, args...) \
+	do { fprintf (stderr, "FAIL %s:%d: " fmt "\n", __FUNCTION__, __LINE__, ##args); exit (1); } while (0)
+
+/* ast_jtag.c */
+extern int (*sim_module_init)(void);
+extern int *sim_param_HWShiftMode;
+
+/* lattice.c */
+extern uint32_t hw_device_ctl (unsigned int cmd, unsigned int *buf, unsigned long data_size);
+extern uint32_t get_device_idcode (unsigned long *id_code);
+
+/* jtag core */
+int jtag_core_loaded = 1;
+JTAG_DEVICE_INFO JTAG_device_information;
+static unsigned int read_buffer [0x10000 / 4];
+static unsigned int write_buffer [0x10000 / 4];
+
+unsigned int *get_jtag_read_buffer (void) { return read_buffer; }
+unsigned int *get_jtag_write_buffer (void) { return write_buffer; }
+int register_hw_hal_module (hw_hal_t *phw_hal, void **pcore_funcs) { return 0; }
+int unregister_hw_hal_module (int dev_type, int hal_id) { return 0; }
+
+static const char *samples = "tools/samples";
+
+/* ------------------------------------------------------------------ */
+
+static char *load (const char *name, unsigned long *size)
+{
+	char path [512];
+	FILE *fp;
+	char *data;
+	long len;
+
+	snprintf (path, sizeof (path), "%s/%s", samples, name);
+	fp = fopen (path, "rb");
+	if (fp == NULL)
+		FAIL ("can't open %s", path);
+	fseek (fp, 0, SEEK_END);
+	len = ftell (fp);
+	fseek (fp, 0, SEEK_SET);
+	data = malloc (len + 1);
+	if (fread (data, 1, len, fp) != (size_t)len)
+		FAIL ("can't read %s", path);
+	fclose (fp);
+	data [len] = '\0';
+	*size = len;
+	return data;
+}
+
+/* configuration rows of a file, decoded the simple way */
+static unsigned int reference_rows (const char *file, u32 rows [][TAP_SIM_ROW_WORDS])
+{
+	const char *p = strstr (file, "\nL000000");
+	unsigned int n = 0;
+
+	if (p == NULL)
+		FAIL ("no L000000 field");
+	memset (rows, 0, SIM_ROWS * TAP_SIM_ROW_WORDS * sizeof (u32));
+	for (p += 8; *p != '*'; p++) {
+		if (*p != '0' && *p != '1')
+			continue;
+		if (*p == '1')
+			rows [n / 128][(n % 128) / 32] |= 1u << (n % 32);
+		n++;
+	}
+	return n / 128;
+}
+
+/* a programmed device on the chain, holding an older image */
+static void old_device (void)
+{
+	unsigned long id = 0;		/* SDR() fills the low 32 bits */
+	unsigned int r;
+
+	tap_sim_init (SIM_IDCODE, SIM_ROWS);
+	if (sim_module_init () != 0 || get_device_idcode (&id) != 0 || id != SIM_IDCODE)
+		FAIL ("no device");
+	for (r = 0; r < SIM_ROWS; r++)
+		memset (tap_sim.flash [r], 0xA5, sizeof (tap_sim.flash [r]));
+	tap_sim.usercode = OLD_USERCODE;
+	tap_sim.done = 1;
+	tap_sim_clear_counters ();
+}
+
+static unsigned int update (char *file, unsigned long size)
+{
+	unsigned int ret = hw_device_ctl (IOCTL_JTAG_UPDATE_DEVICE, (unsigned int *)file, size);
+
+	if (JTAG_device_information.Device_Row_Length != SIM_ROWS)
+		FAIL ("Device_Row_Length left at %u", JTAG_device_information.Device_Row_Length);
+	if (tap_sim.protocol_errors != 0)
+		FAIL ("%lu protocol errors", tap_sim.protocol_errors);
+	return ret;
+}
+
+static void check_programmed (const char *file, u32 usercode)
+{
+	static u32 rows [SIM_ROWS][TAP_SIM_ROW_WORDS];
+	unsigned int used = reference_rows (file, rows);
+	unsigned int r;
+
+	for (r = 0; r < SIM_ROWS; r++)
+		if (memcmp (tap_sim.flash [r], rows [r], sizeof (rows [r])) != 0)
+			FAIL ("flash row %u of %u", r, used);
+	if (tap_sim.usercode != usercode || !tap_sim.done || tap_sim.enabled)
+		FAIL ("usercode %08x done %d enabled %d", tap_sim.usercode, tap_sim.done, tap_sim.enabled);
+}
+
+/* a bad file found after erasing must leave the device erased, not half programmed */
+static void check_erased (void)
+{
+	static const u32 zero [TAP_SIM_ROW_WORDS];
+	unsigned int r;
+
+	for (r = 0; r < SIM_ROWS; r++)
+		if (memcmp (tap_sim.flash [r], zero, sizeof (zero)) != 0)
+			FAIL ("flash row %u not erased", r);
+	if (tap_sim.usercode != OLD_USERCODE || tap_sim.done || tap_sim.enabled)
+		FAIL ("usercode %08x done %d enabled %d", tap_sim.usercode, tap_sim.done, tap_sim.enabled);
+}
+
+static void report (const char *what)
+{
+	printf ("  %-30s parse %7lu us (%7lu us while programming)  erase %7lu us  program %8lu us  verify %8lu us\n",
+		what, JED_TIME_US (jed_timing.parse), JED_TIME_US (jed_timing.overlap), JED_TIME_US (jed_timing.erase),
+		JED_TIME_US (jed_timing.program), JED_TIME_US (jed_timing.verify));
+}
+
+/* ------------------------------------------------------------------ */
+/* samples */
+
+static void test_samples (void)
+{
+	unsigned long size;
+	char *file;
+
+	/* CRLF, UFM and tag fuses after the configuration, transmission checksum: streamed */
+	file = load ("lcmxo2_1200ze.jed", &size);
+	old_device ();
+	if (update (file, size) != 0)
+		FAIL ("lcmxo2_1200ze.jed");
+	check_programmed (file, 0x5AC3F00D);
+	report ("lcmxo2_1200ze.jed");
+	free (file);
+
+	/* LF, F1, binary usercode, no transmission checksum: checked in full before erasing */
+	file = load ("lcmxo2_1200ze_noxmit.jed", &size);
+	old_device ();
+	if (update (file, size) != 0)
+		FAIL ("lcmxo2_1200ze_noxmit.jed");
+	check_programmed (file, 0x0BADC0DE);
+	if (jed_timing.overlap != 0)
+		FAIL ("noxmit file was streamed");
+	report ("lcmxo2_1200ze_noxmit.jed");
+	free (file);
+
+	/* fuse checksum mismatch, found after the rows */
+	file = load ("lcmxo2_1200ze_badsum.jed", &size);
+	old_device ();
+	if (update (file, size) == 0)
+		FAIL ("lcmxo2_1200ze_badsum.jed programmed");
+	check_erased ();
+	free (file);
+
+	/* configuration data not a whole number of rows */
+	file = load ("lcmxo2_1200ze_partial_row.jed", &size);
+	old_device ();
+	if (update (file, size) == 0)
+		FAIL ("lcmxo2_1200ze_partial_row.jed programmed");
+	check_erased ();
+	free (file);
+
+	/* no ETX: rejected before the device is touched */
+	file = load ("lcmxo2_1200ze_truncated.jed", &size);
+	old_device ();
+	if (update (file, size) == 0)
+		FAIL ("lcmxo2_1200ze_truncated.jed programmed");
+	if (tap_sim.io_reads + tap_sim.io_writes != 0 || !tap_sim.done || tap_sim.flash [0][0] != 0xA5A5A5A5)
+		FAIL ("device touched by a truncated file");
+	free (file);
+}
+
+/* ------------------------------------------------------------------ */
+/* full size file */
+
+static char *generate (unsigned int rows, int xmit, unsigned long *size)
+{
+	char *file = malloc (rows * 130 + 4096);
+	char *p = file;
+	unsigned int r, i, n, sum = 0;
+	unsigned char byte = 0;
+
+	srand (42);
+	p += sprintf (p, "\002*\r\nNOTE DEVICE NAME:\tLCMXO2-1200ZE-1TG144C*\r\nQF%u*\r\nG0*\r\nF0*\r\nL000000\r\n", SIM_QF);
+	for (r = 0, n = 0; r < rows; r++) {
+		for (i = 0; i < 128; i++, n++) {
+			int bit = (rand () >> 7) & 1;
+
+			*p++ = '0' + bit;
+			byte |= bit << (n % 8);
+			if (n % 8 == 7) {
+				sum += byte;
+				byte = 0;
+			}
+		}
+		p += sprintf (p, "\r\n");
+	}
+	p += sprintf (p, "*\r\nNOTE END CONFIG DATA*\r\nC%04X*\r\nUH%08X*\r\n\003", sum & 0xffff, 0xC0FFEE00 + rows);
+	for (sum = 0, i = 0; file + i < p; i++)
+		sum += (unsigned char)file [i];
+	p += sprintf (p, "%04X", xmit ? sum & 0xffff : 0);
+	*size = p - file;
+	return file;
+}
+
+static void test_full_size (void)
+{
+	unsigned long size;
+	char *file;
+	char name [64];
+	int xmit;
+
+	for (xmit = 1; xmit >= 0; xmit--) {
+		file = generate (SIM_ROWS, xmit, &size);
+		old_device ();
+		if (update (file, size) != 0)
+			FAIL ("full size file, transmission checksum %d", xmit);
+		check_programmed (file, 0xC0FFEE00 + SIM_ROWS);
+		snprintf (name, sizeof (name), "%u rows, %s", SIM_ROWS, xmit ? "streamed" : "checked first");
+		report (name);
+		free (file);
+	}
+}
+
+int main (int argc, char *argv [])
+{
+	int opt;
+
+	while ((opt = getopt (argc, argv, "v")) != -1) {
+		switch (opt) {
+			case 'v': tap_sim_quiet = 0; break;
+			default:
+				fprintf (stderr, "usage: %s [-v] [samples directory]\n", argv [0]);
+				return 2;
+		}
+	}
+	if (optind < argc)
+		samples = argv [optind];
+
+	for (*sim_param_HWShiftMode = 0; *sim_param_HWShiftMode <= 1; (*sim_param_HWShiftMode)++) {
+		printf ("%s mode\n", *sim_param_HWShiftMode ? "hw shift" : "software");
+		test_samples ();
+		test_full_size ();
+	}
+	printf ("all tests OK\n");
+	return 0;
+}
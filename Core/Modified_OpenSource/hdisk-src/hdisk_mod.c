@@ -57,6 +57,7 @@ TDBG_DECLARE_DBGVAR(hdisk);
 /* Function Prototypes */
 static int CreateHdiskDescriptor(uint8 DevNo);
 static int HdiskIoctl (unsigned int cmd,unsigned long arg, int* RetVal);
+static int HdiskMmap (unsigned long PgOff, struct vm_area_struct *vma, int* RetVal);
 static int FillDevInfo (IUSB_DEVICE_INFO* iUSBDevInfo);
 static int RemoteScsiCall(uint8 DevNo, uint8 ifnum, BOT_IF_DATA *MassData, uint8 LunNo);
 static int SetInterfaceAuthKey (uint8 DevNo, uint8 IfNum, uint32 Key);
@@ -73,6 +74,7 @@ static USB_DEV	UsbDev = {
 	.DevUsbFillDevInfo 			= FillDevInfo,
 	.DevUsbSetInterfaceAuthKey	= SetInterfaceAuthKey,
 	.DevUsbClearInterfaceAuthKey	= ClearInterfaceAuthKey,
+	.DevUsbMmap					= HdiskMmap,
 				};
 static USB_CORE UsbCore;
 static USB_IUSB iUSB;
@@ -201,6 +203,7 @@ HdiskIoctl (unsigned int cmd,unsigned long arg, int* RetVal)
 	int i;
 	uint8 Instance;
 	IUSB_IOCTL_DATA IoctlData;
+	IUSB_RING_SLOT_REQ SlotReq;
 	
 	switch (cmd)
 	{
@@ -233,6 +236,40 @@ HdiskIoctl (unsigned int cmd,unsigned long arg, int* RetVal)
 		*RetVal = iUSB.iUSBScsiSendResponse((IUSB_SCSI_PACKET *)arg);
 		return 0;
 
+	case USB_HDISK_RES_SLOT:
+		TDBG_FLAGGED(hdisk, DEBUG_HDISK,"USB_HDISK_RES_SLOT IOCTL...\n");
+		if (AuthenticateIOCTLCaller (arg, RetVal, 1))
+		{
+			TWARN ("HdiskIoctl(): Invalid Auth Key in USB_HDISK_RES_SLOT IOCTL\n");
+			return 0;
+		}
+		if (__copy_from_user((void *)(&SlotReq), (void*)arg, sizeof(IUSB_RING_SLOT_REQ)))
+		{
+			TWARN ("HdiskIoctl(): __copy_from_user failed in USB_HDISK_RES_SLOT IOCTL\n");
+			*RetVal = -1;
+			return 0;
+		}
+		*RetVal = iUSB.iUSBScsiSlotResponse(IUSB_DEVICE_HARDDISK,
+						HDInstannceAssignment[SlotReq.Header.Instance], SlotReq.Slot);
+		return 0;
+
+	case USB_HDISK_QUEUE_SLOT:
+		TDBG_FLAGGED(hdisk, DEBUG_HDISK,"USB_HDISK_QUEUE_SLOT IOCTL...\n");
+		if (AuthenticateIOCTLCaller (arg, RetVal, 1))
+		{
+			TWARN ("HdiskIoctl(): Invalid Auth Key in USB_HDISK_QUEUE_SLOT IOCTL\n");
+			return 0;
+		}
+		if (__copy_from_user((void *)(&SlotReq), (void*)arg, sizeof(IUSB_RING_SLOT_REQ)))
+		{
+			TWARN ("HdiskIoctl(): __copy_from_user failed in USB_HDISK_QUEUE_SLOT IOCTL\n");
+			*RetVal = -1;
+			return 0;
+		}
+		*RetVal = iUSB.iUSBScsiQueueSlot(IUSB_DEVICE_HARDDISK,
+						HDInstannceAssignment[SlotReq.Header.Instance], SlotReq.Slot);
+		return 0;
+
 	case USB_HDISK_ACTIVATE:
 		TDBG_FLAGGED(hdisk, DEBUG_HDISK,"USB_HDISK_ACTIVATE IOCTL...\n");
 		if (AuthenticateIOCTLCaller (arg, RetVal, 0))
@@ -485,6 +522,29 @@ HdiskIoctl (unsigned int cmd,unsigned long arg, int* RetVal)
 
 }
 
+/* Maps the response ring of an instance, see USB_HDISK_RING_PGOFF() */
+static int
+HdiskMmap (unsigned long PgOff, struct vm_area_struct *vma, int* RetVal)
+{
+	uint8 Instance;
+
+	if ((PgOff < USB_HDISK_RING_PGOFF(0)) || (PgOff >= USB_HDISK_RING_PGOFF(MAX_LUN_SUPPORT)))
+		return -1;
+	Instance = (PgOff - USB_HDISK_RING_PGOFF(0)) >> USB_RING_PGOFF_SHIFT;
+	if (PgOff != USB_HDISK_RING_PGOFF(Instance))
+		return -1;
+
+	TDBG_FLAGGED(hdisk, DEBUG_HDISK,"HdiskMmap(): Instance %d\n", Instance);
+	if ((HDInstannceAssignment[Instance] == 0xFF) || (0 == IfaceAuthKeys[0]))
+	{
+		TWARN ("HdiskMmap(): Instance %d is not in use\n", Instance);
+		*RetVal = -EINVAL;
+		return 0;
+	}
+	*RetVal = iUSB.iUSBScsiRingMmap (IUSB_DEVICE_HARDDISK, HDInstannceAssignment[Instance], vma);
+	return 0;
+}
+
 static int
 CreateHdiskDescriptor(uint8 DevNo)
 {
@@ -522,6 +582,7 @@ CreateHdiskDescriptor(uint8 DevNo)
 	IfData->NoMediumRetries = MAX_NOMEDIUM_RETRIES;
 	IfData->ScsiDataOutLen		= 0;
 	IfData->LastSeqNo		= 0;	/* Invalid Seq No */
+	memset(&IfData->Stats, 0, sizeof(BOT_STATS));
     inquiry_data = sizeof(SCSI_INQUIRY_PACKET) * (MAX_LUN_SUPPORT + 1);
 	
 	IfData->Inquiry = (SCSI_INQUIRY_PACKET*) vmalloc (inquiry_data);
@@ -0,0 +1,185 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+
+#ifdef __KERNEL__
+	#include <linux/kernel.h>
+	#include <linux/string.h>
+#else
+	#include <stdio.h>
+	#include <string.h>
+#endif
+#include "fmh.h"
+#include "fmhindex.h"
+
+typedef struct
+{
+	unsigned long	ImageStart;
+	int		NumModules;	/* 0 if unused or stale */
+	FMH_INDEX_ENTRY	Module[FMH_INDEX_MAX_MODULES];
+} FMH_INDEX;
+
+static FMH_INDEX fmh_index[FMH_INDEX_MAX_IMAGES];
+
+static void
+FillIndexEntry(FMH_INDEX_ENTRY *entry, FMH *fmh, unsigned long FlashStartOffset,
+				unsigned long SectorOffset)
+{
+	MODULE_INFO *mod = &(fmh->Module_Info);
+
+	/* Entries are compared with memcmp(), so clear the padding too */
+	memset(entry,0,sizeof(FMH_INDEX_ENTRY));
+	memcpy(entry->Name,mod->Module_Name,sizeof(mod->Module_Name));
+	entry->Name[sizeof(mod->Module_Name)] = 0;
+	entry->Type = le16_to_host(mod->Module_Type);
+	entry->FmhSector = SectorOffset;
+	if(fmh->FMH_Ver_Major == 1 && fmh->FMH_Ver_Minor >= 8)
+		entry->Location = FlashStartOffset + le32_to_host(mod->Module_Location);
+	else
+		entry->Location = SectorOffset + le32_to_host(mod->Module_Location);
+	entry->Size = le32_to_host(mod->Module_Size);
+	entry->Checksum = le32_to_host(mod->Module_Checksum);
+}
+
+/*
+ * Walk the image once and record every module found, up to and including
+ * MODULE_FMH_FIRMWARE.  Past FMH_INDEX_MAX_MODULES only MODULE_FMH_FIRMWARE
+ * is kept, in the last slot.
+ */
+static int
+BuildFMHIndex(FMH_INDEX *index, unsigned long FlashStartOffset, unsigned long FlashSize,
+				unsigned long SectorSize, FLASH_INFO* flinfo)
+{
+	unsigned long SectorCount = FlashSize/SectorSize;
+	unsigned long i=0,prev_fmh_sec_loc=0;
+	FMH fmh;
+	MODULE_INFO *mod;
+	int fmh_found = 0;
+
+	index->ImageStart = FlashStartOffset;
+	index->NumModules = 0;
+
+	for (i=0;i<SectorCount;)
+	{
+		/* Scan the flash and get FMH*/
+		fmh_found = ScanforFMH_UseReadFn((FlashStartOffset+(i*SectorSize)),SectorSize,flinfo,&fmh);
+		if (fmh_found == 0)
+		{
+			i++;
+			continue;
+		}
+
+		mod = &(fmh.Module_Info);
+
+		if (index->NumModules < FMH_INDEX_MAX_MODULES)
+		{
+			FillIndexEntry(&index->Module[index->NumModules],&fmh,
+							FlashStartOffset,FlashStartOffset+(i*SectorSize));
+			index->NumModules++;
+		}
+		else if (le16_to_host(mod->Module_Type) == MODULE_FMH_FIRMWARE)
+		{
+			/* Table full: give up the last module rather than the firmware FMH the FwInfo files need */
+			FillIndexEntry(&index->Module[FMH_INDEX_MAX_MODULES-1],&fmh,
+							FlashStartOffset,FlashStartOffset+(i*SectorSize));
+		}
+
+		/* Nothing after MODULE_FMH_FIRMWARE is of interest */
+		if (le16_to_host(mod->Module_Type) == MODULE_FMH_FIRMWARE)
+			break;
+
+		if(le16_to_host(mod->Module_Type) == MODULE_BOOTLOADER && (strncmp(mod->Module_Name,"pfm",sizeof("pfm")) != 0))
+		{
+			i = prev_fmh_sec_loc + (le32_to_host(fmh.FMH_AllocatedSize)/SectorSize);
+			prev_fmh_sec_loc = i;   
+		}
+		else if(strncmp(mod->Module_Name,"pfm",sizeof("pfm")) == 0)
+		{
+			i+=1;
+		}
+		else
+		{
+			i+=(le32_to_host(fmh.FMH_AllocatedSize)/SectorSize);
+			prev_fmh_sec_loc = i;
+		}
+		memset(&fmh,0,sizeof(FMH));
+	}
+
+	return index->NumModules;
+}
+
+/* Re-read the FMH an entry came from and check that it still matches */
+static int
+ValidateIndexEntry(FMH_INDEX_ENTRY *entry, unsigned long FlashStartOffset,
+				unsigned long SectorSize, FLASH_INFO* flinfo)
+{
+	FMH fmh;
+	FMH_INDEX_ENTRY now;
+
+	if (ScanforFMH_UseReadFn(entry->FmhSector,SectorSize,flinfo,&fmh) == 0)
+		return 0;
+
+	FillIndexEntry(&now,&fmh,FlashStartOffset,entry->FmhSector);
+	return (memcmp(&now,entry,sizeof(now)) == 0);
+}
+
+/* Find a module of the given type in the image, (re)building the index if needed */
+int
+FindIndexedModule(unsigned long FlashStartOffset, unsigned long FlashSize,
+				unsigned long SectorSize, FLASH_INFO* flinfo,
+				unsigned short Type, FMH_INDEX_ENTRY *found)
+{
+	FMH_INDEX *index = NULL;
+	int i, pass;
+
+	for (i=0;i<FMH_INDEX_MAX_IMAGES;i++)
+	{
+		if (fmh_index[i].NumModules != 0 && fmh_index[i].ImageStart == FlashStartOffset)
+		{
+			index = &fmh_index[i];
+			break;
+		}
+		if (index == NULL && fmh_index[i].NumModules == 0)
+			index = &fmh_index[i];
+	}
+	if (index == NULL)
+		index = &fmh_index[0];
+
+	/* First try the index as it is, then once more after rescanning the image */
+	for (pass=0;pass<2;pass++)
+	{
+		if (pass == 1 || index->NumModules == 0 || index->ImageStart != FlashStartOffset)
+		{
+			if (BuildFMHIndex(index,FlashStartOffset,FlashSize,SectorSize,flinfo) == 0)
+				return -1;
+		}
+
+		for (i=0;i<index->NumModules;i++)
+		{
+			if (index->Module[i].Type == Type)
+				break;
+		}
+		if (i >= index->NumModules)
+			continue;
+
+		if (ValidateIndexEntry(&index->Module[i],FlashStartOffset,SectorSize,flinfo))
+		{
+			memcpy(found,&index->Module[i],sizeof(FMH_INDEX_ENTRY));
+			return 0;
+		}
+	}
+
+	index->NumModules = 0;
+	return -1;
+}
+
@@ -0,0 +1,45 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+
+#ifndef AMI_FMHINDEX_H
+#define AMI_FMHINDEX_H
+
+#include "fmh.h"
+
+/*
+ * Module index of each image, built by one walk over its FMHs the first
+ * time the image is looked at and kept in RAM.  The FwInfo files then
+ * only re-read the one FMH they need to check that the entry still
+ * describes what is in flash (the image may have been updated since),
+ * instead of scanning the image sector by sector on every read.
+ */
+#define FMH_INDEX_MAX_IMAGES	2
+#define FMH_INDEX_MAX_MODULES	32
+
+typedef struct
+{
+	char		Name[9];
+	unsigned short	Type;
+	unsigned long	FmhSector;	/* Offset of the sector holding the FMH */
+	unsigned long	Location;	/* Offset of the module itself */
+	unsigned long	Size;
+	unsigned long	Checksum;
+} FMH_INDEX_ENTRY;
+
+/* Not locked, callers serialize the lookups */
+int FindIndexedModule(unsigned long FlashStartOffset, unsigned long FlashSize,
+				unsigned long SectorSize, FLASH_INFO* flinfo,
+				unsigned short Type, FMH_INDEX_ENTRY *found);
+
+#endif
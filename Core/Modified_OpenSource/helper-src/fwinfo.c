@@ -28,6 +28,7 @@
 #include <asm/io.h>
 #include "fmh.h"
 #include "helper.h"
+#include "fmhindex.h"
 
 #include <linux/mtd/mtd.h>
 //#include <linux/mtd/map.h>
@@ -71,83 +72,37 @@ unsigned int g_MTDSupport = 1;
 extern unsigned char broken_spi_banks;// specify the number of broken SPI flash bank
 #endif
 
+/* Serializes FindIndexedModule(), the FMH index is shared by both images */
+static DEFINE_MUTEX(fmh_index_mlock);
+
 /*this returns offset not address*/
 static long
 ScanFirmwareModule(unsigned long FlashStartOffset, unsigned long FlashSize,
 				unsigned long SectorSize, unsigned char* buf,FLASH_INFO* flinfo)
 {
-	unsigned long SectorCount = FlashSize/SectorSize;
-	unsigned long i=0,prev_fmh_sec_loc=0;
-	FMH fmh;
-	MODULE_INFO *mod = NULL;
-	unsigned long ModuleOffset;
-	unsigned long Size, Location;
-	int fmh_found = 0;
+	FMH_INDEX_ENTRY mod;
 	size_t NumBytesRead;
+	int ret;
 
-	for (i=0;i<SectorCount;)
-	{
-		/* Scan the flash and get FMH*/
-		fmh_found = ScanforFMH_UseReadFn((FlashStartOffset+(i*SectorSize)),SectorSize,flinfo,&fmh);
-		if (fmh_found == 0)
-		{
-			i++;
-			continue;
-		}
-
-		mod = &(fmh.Module_Info);
-
-		/* Check if module type is FIRMWARE */
-		if (le16_to_host(mod->Module_Type) == MODULE_FMH_FIRMWARE)
-			break;
-
-		if(le16_to_host(mod->Module_Type) == MODULE_BOOTLOADER && (strncmp(mod->Module_Name,"pfm",sizeof("pfm")) != 0))
-		{
-			i = prev_fmh_sec_loc + (le32_to_host(fmh.FMH_AllocatedSize)/SectorSize);
-			prev_fmh_sec_loc = i;   
-		}
-		else if(strncmp(mod->Module_Name,"pfm",sizeof("pfm")) == 0)
-		{
-			i+=1;
-		}
-		else
-		{
-			i+=(le32_to_host(fmh.FMH_AllocatedSize)/SectorSize);
-			prev_fmh_sec_loc = i;
-		}
-		memset(&fmh,0,sizeof(FMH));
-	}
+	mutex_lock(&fmh_index_mlock);
+	ret = FindIndexedModule(FlashStartOffset,FlashSize,SectorSize,flinfo,
+							MODULE_FMH_FIRMWARE,&mod);
+	mutex_unlock(&fmh_index_mlock);
 
-	if (i >= SectorCount)
+	if (ret != 0)
 	{
 		printk(KERN_DEBUG "Unable to Locate MODULE_FMH_FIRMWARE\n");
 		return -1;
 	}
 
-	if(mod != NULL)
-	{
-		Size = le32_to_host(mod->Module_Size);
-		Location = le32_to_host(mod->Module_Location);
-	}
-	else
-	{
-		printk(KERN_ERR "Error: dereferencing null pointer\n");
-		return -1;
-	}
-
-	if(fmh.FMH_Ver_Major == 1 && fmh.FMH_Ver_Minor >= 8)
-		ModuleOffset = FlashStartOffset + Location;
-	else
-		ModuleOffset = FlashStartOffset +(i*SectorSize) + Location;
-
 	//copy here
-	if( flinfo->read_flash(ModuleOffset,Size,&NumBytesRead,buf) != 0)
+	if( flinfo->read_flash(mod.Location,mod.Size,&NumBytesRead,buf) != 0)
 	{
 		printk(KERN_ERR "Error reading flash in order to copy MODULE_FMH_FIRMWARE info\n");
 		return -1;
 	}
 
-	return Size;
+	return mod.Size;
 	
 }
 
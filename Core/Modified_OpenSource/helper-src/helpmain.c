@@ -26,6 +26,7 @@
 //#include <mach/platform.h>
 //`#endif
 #include "helper.h"
+#include "sensor_sampler.h"
 
 /* Debug Level for the driver - Controlled by sysctl */
 static int DebugLevel = 0;		
@@ -176,6 +177,15 @@ static struct ctl_table HelperTable[] =
                 .extra1         = NULL,
                 .extra2         = NULL,
         },
+        {
+                .procname       = "SamplerPeriod",
+                .data           = &SamplerPeriod,
+                .maxlen         = sizeof(int),
+                .mode           = 0644,
+                .proc_handler   = &proc_dointvec,
+                .extra1         = NULL,
+                .extra2         = NULL,
+        },
 
 		{}
 #endif
@@ -361,6 +371,11 @@ init_helper(void)
 #endif
 
     fbinfo_proc = AddProcEntry(moduledir,"FbInfo",flashbanksize_read,NULL,NULL);	
+
+	/* Periodic ADC/tach/PECI sampler, mapped from /proc/ractrends/Helper/SensorSampler */
+	if (init_sensor_sampler(moduledir) != 0)
+		printk(KERN_ERR "Helper: sensor sampler not available\n");
+
 	/* Add sysctl to access the DebugLevel */
 	helper_sys  = AddSysctlTable("Helper",&HelperTable[0]);
 	return 0;
@@ -414,6 +429,8 @@ exit_helper(void)
 	
 #endif
 
+	exit_sensor_sampler(moduledir);
+
 	/* Remove the driver's proc entries */
 	remove_proc_entry("Helper",rootdir);
 	
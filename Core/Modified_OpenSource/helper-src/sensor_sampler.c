@@ -0,0 +1,300 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+
+/*
+ * Periodic sensor sampler, see sensor_sampler.h
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/version.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+#include <linux/fs.h>
+#include <linux/kthread.h>
+#include <linux/wait.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/uaccess.h>
+#include "helper.h"
+#include "sensor_sampler.h"
+
+#define SAMPLER_MIN_PERIOD	10	/* ms */
+#define SAMPLER_IDLE_WAIT	1000	/* ms, polls SamplerPeriod while paused */
+
+/* Sampling period in ms, 0 pauses the sampler - Controlled by sysctl */
+int SamplerPeriod = 1000;
+
+static sensor_sampler_ring_t *ring;
+static unsigned long ring_size;
+static LIST_HEAD(sampler_sources);
+static DEFINE_MUTEX(sampler_lock);
+static DECLARE_WAIT_QUEUE_HEAD(sampler_wait);
+static struct task_struct *sampler_task;
+static int sampler_kick;
+static int sampler_channels;
+static unsigned long sampler_sweeps;
+static u64 sampler_last_sweep;		/* ns */
+
+
+/* ----- Sources ----------------------------------------------------------- */
+
+int
+sensor_sampler_register (struct sensor_sampler_source *src)
+{
+	if (!src->read)
+		return -EINVAL;
+
+	src->count = 0;
+	mutex_lock (&sampler_lock);
+	list_add_tail (&src->list, &sampler_sources);
+	mutex_unlock (&sampler_lock);
+	return 0;
+}
+
+void
+sensor_sampler_unregister (struct sensor_sampler_source *src)
+{
+	/* Holding the lock also waits for a sweep that is reading this source */
+	mutex_lock (&sampler_lock);
+	list_del (&src->list);
+	sampler_channels -= src->count;
+	src->count = 0;
+	mutex_unlock (&sampler_lock);
+}
+
+/*
+ * Replaces the channels sampled from src. A count of 0 stops sampling it.
+ * All sources share SENSOR_SAMPLER_MAX_SAMPLES samples per sweep.
+ */
+int
+sensor_sampler_set_channels (struct sensor_sampler_source *src, const uint8_t *channel, int count)
+{
+	if (count < 0)
+		return -EINVAL;
+
+	mutex_lock (&sampler_lock);
+	if (sampler_channels - src->count + count > SENSOR_SAMPLER_MAX_SAMPLES)
+	{
+		mutex_unlock (&sampler_lock);
+		return -ENOSPC;
+	}
+	memcpy (src->channel, channel, count);
+	sampler_channels += count - src->count;
+	src->count = count;
+	mutex_unlock (&sampler_lock);
+
+	/* Take the first sweep now rather than at the end of the current period */
+	sampler_kick = 1;
+	wake_up_interruptible (&sampler_wait);
+	return 0;
+}
+
+/* ----- Sampler thread ---------------------------------------------------- */
+
+static void
+sampler_sweep (unsigned int period)
+{
+	struct sensor_sampler_source *src;
+	sensor_sampler_slot_t *slot;
+	uint32_t seq = ring->seq + 1;
+	int n = 0;
+	int i, ret;
+
+	if (seq == 0)
+		seq = 1;
+	slot = &ring->slot[seq % SENSOR_SAMPLER_SLOTS];
+
+	/* Readers that copied this slot before now see it change */
+	slot->seq = 0;
+	smp_wmb ();
+
+	slot->start = ktime_get_ns ();
+	mutex_lock (&sampler_lock);
+	list_for_each_entry (src, &sampler_sources, list)
+	{
+		sensor_sample_t *sample = &slot->sample[n];
+
+		if (src->count == 0)
+			continue;
+		for (i = 0; i < src->count; i++)
+		{
+			sample[i].source = src->type;
+			sample[i].channel = src->channel[i];
+			sample[i].status = 0;
+			sample[i].value = 0;
+			sample[i].timestamp = 0;
+		}
+		ret = src->read (src->priv, sample, src->count);
+		if (ret < 0)
+		{
+			/* The whole batch failed, e.g. the hardware module is not loaded */
+			for (i = 0; i < src->count; i++)
+			{
+				if (sample[i].timestamp == 0)
+					sample[i].status = ret;
+			}
+		}
+		n += src->count;
+	}
+	mutex_unlock (&sampler_lock);
+	slot->end = ktime_get_ns ();
+	slot->count = n;
+
+	sampler_last_sweep = slot->end - slot->start;
+	sampler_sweeps++;
+	if (sampler_last_sweep > (u64)period * NSEC_PER_MSEC)
+		ring->overruns++;
+	ring->period = period;
+
+	smp_wmb ();
+	slot->seq = seq;
+	smp_wmb ();
+	ring->seq = seq;
+}
+
+static int
+sampler_thread (void *unused)
+{
+	unsigned long next = jiffies;
+	long wait;
+	int period;
+
+	while (!kthread_should_stop ())
+	{
+		period = SamplerPeriod;
+		if (period <= 0)
+		{
+			wait = msecs_to_jiffies (SAMPLER_IDLE_WAIT);
+		}
+		else
+		{
+			if (period < SAMPLER_MIN_PERIOD)
+				period = SAMPLER_MIN_PERIOD;
+
+			if (sampler_kick || time_after_eq (jiffies, next))
+			{
+				sampler_kick = 0;
+				if (sampler_channels > 0)
+					sampler_sweep (period);
+				/* Keep the period steady, but don't catch up on missed sweeps */
+				next += msecs_to_jiffies (period);
+				if (time_before_eq (next, jiffies))
+					next = jiffies + msecs_to_jiffies (period);
+			}
+			wait = (long)(next - jiffies);
+			if (wait <= 0)
+				continue;
+		}
+
+		wait_event_interruptible_timeout (sampler_wait, sampler_kick || kthread_should_stop (), wait);
+	}
+	return 0;
+}
+
+/* ----- /proc/ractrends/Helper/SensorSampler ------------------------------ */
+
+static ssize_t
+sampler_proc_read (struct file *file, char __user *buffer, size_t count, loff_t *ppos)
+{
+	struct sensor_sampler_source *src;
+	char *buf;
+	int len;
+	ssize_t ret;
+
+	buf = kmalloc (PAGE_SIZE, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	len = scnprintf (buf, PAGE_SIZE, "period %d ms, %lu sweeps, %u overruns, last sweep %llu us\n",
+			SamplerPeriod, sampler_sweeps, ring->overruns, (unsigned long long)(sampler_last_sweep / NSEC_PER_USEC));
+	mutex_lock (&sampler_lock);
+	list_for_each_entry (src, &sampler_sources, list)
+		len += scnprintf (buf + len, PAGE_SIZE - len, "%-8s %d channels\n", src->name, src->count);
+	mutex_unlock (&sampler_lock);
+
+	ret = simple_read_from_buffer (buffer, count, ppos, buf, len);
+	kfree (buf);
+	return ret;
+}
+
+static int
+sampler_proc_mmap (struct file *file, struct vm_area_struct *vma)
+{
+	/* The ring is written by the sampler only */
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_vmalloc_range (vma, ring, vma->vm_pgoff);
+}
+
+static const struct file_operations sampler_proc_fops = {
+	.owner		= THIS_MODULE,
+	.read		= sampler_proc_read,
+	.mmap		= sampler_proc_mmap,
+	.llseek		= default_llseek,
+};
+
+/* ----- Init / Exit ------------------------------------------------------- */
+
+int
+init_sensor_sampler (struct proc_dir_entry *moduledir)
+{
+	ring_size = PAGE_ALIGN (sizeof (sensor_sampler_ring_t));
+	ring = vmalloc_user (ring_size);
+	if (!ring)
+		return -ENOMEM;
+
+	ring->magic = SENSOR_SAMPLER_MAGIC;
+	ring->version = SENSOR_SAMPLER_VERSION;
+	ring->slots = SENSOR_SAMPLER_SLOTS;
+	ring->period = SamplerPeriod;
+
+	if (!proc_create ("SensorSampler", S_IRUGO, moduledir, &sampler_proc_fops))
+	{
+		printk (KERN_ERR "Helper: failed to create the SensorSampler proc entry\n");
+		vfree (ring);
+		ring = NULL;
+		return -ENOMEM;
+	}
+
+	sampler_task = kthread_run (sampler_thread, NULL, "sensorsampler");
+	if (IS_ERR (sampler_task))
+	{
+		printk (KERN_ERR "Helper: failed to start the sensor sampler thread\n");
+		remove_proc_entry ("SensorSampler", moduledir);
+		vfree (ring);
+		ring = NULL;
+		return PTR_ERR (sampler_task);
+	}
+	return 0;
+}
+
+void
+exit_sensor_sampler (struct proc_dir_entry *moduledir)
+{
+	if (!ring)
+		return;
+
+	kthread_stop (sampler_task);
+	remove_proc_entry ("SensorSampler", moduledir);
+	vfree (ring);
+	ring = NULL;
+}
+
+EXPORT_SYMBOL(sensor_sampler_register);
+EXPORT_SYMBOL(sensor_sampler_unregister);
+EXPORT_SYMBOL(sensor_sampler_set_channels);
@@ -0,0 +1,140 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+
+/*
+ * Periodic sensor sampler
+ *
+ * The ADC, PWMTACH and PECI drivers register a source with the sampler.
+ * A helper thread reads every configured channel of every source once per
+ * SamplerPeriod (ms, /proc/sys/ractrends/Helper) and publishes the sweep
+ * in a ring that user space maps read only from
+ * /proc/ractrends/Helper/SensorSampler. The latest values are then read
+ * without a system call, see sensor_sampler_latest().
+ *
+ * The same sample layout is returned by the batch read ioctls of the
+ * drivers.
+ */
+
+#ifndef AMI_SENSOR_SAMPLER_H
+#define AMI_SENSOR_SAMPLER_H
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#include <linux/list.h>
+#else
+#include <stdint.h>
+#include <string.h>
+#endif
+
+#define SENSOR_SOURCE_ADC		1
+#define SENSOR_SOURCE_TACH		2
+#define SENSOR_SOURCE_PECI		3
+
+/* The structures below have no padding and are not packed, so seq can be read atomically */
+
+typedef struct
+{
+	uint8_t  source;	/* SENSOR_SOURCE_xxx */
+	uint8_t  channel;	/* ADC channel, tach number or PECI command index */
+	int16_t  status;	/* 0 or -errno of the read */
+	uint32_t value;		/* raw reading */
+	uint64_t timestamp;	/* CLOCK_MONOTONIC ns at which the value was read */
+} sensor_sample_t;
+
+#define SENSOR_SAMPLER_PROC		"/proc/ractrends/Helper/SensorSampler"
+#define SENSOR_SAMPLER_MAGIC		0x534D504C	/* "SMPL" */
+#define SENSOR_SAMPLER_VERSION		1
+#define SENSOR_SAMPLER_SLOTS		4
+#define SENSOR_SAMPLER_MAX_SAMPLES	120
+
+/* One sweep over all configured channels */
+typedef struct
+{
+	uint32_t seq;		/* sweep number, 0 while the slot is rewritten */
+	uint32_t count;
+	uint64_t start;		/* ns */
+	uint64_t end;		/* ns */
+	sensor_sample_t sample[SENSOR_SAMPLER_MAX_SAMPLES];
+} sensor_sampler_slot_t;
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slots;
+	uint32_t period;	/* ms */
+	uint32_t seq;		/* last complete sweep, in slot[seq % slots] */
+	uint32_t overruns;	/* sweeps that took longer than the period */
+	uint32_t reserved[2];
+	sensor_sampler_slot_t slot[SENSOR_SAMPLER_SLOTS];
+} sensor_sampler_ring_t;
+
+#ifdef __KERNEL__
+
+struct proc_dir_entry;
+
+struct sensor_sampler_source
+{
+	const char *name;
+	uint8_t type;			/* SENSOR_SOURCE_xxx */
+	/* Reads sample[0..count-1].channel into value, status and timestamp. May sleep. */
+	int (*read) (void *priv, sensor_sample_t *sample, int count);
+	void *priv;
+
+	/* Owned by the sampler */
+	struct list_head list;
+	int count;
+	uint8_t channel[SENSOR_SAMPLER_MAX_SAMPLES];
+};
+
+int sensor_sampler_register (struct sensor_sampler_source *src);
+void sensor_sampler_unregister (struct sensor_sampler_source *src);
+int sensor_sampler_set_channels (struct sensor_sampler_source *src, const uint8_t *channel, int count);
+
+int init_sensor_sampler (struct proc_dir_entry *moduledir);
+void exit_sensor_sampler (struct proc_dir_entry *moduledir);
+extern int SamplerPeriod;
+
+#else
+
+/*
+ * Copies the latest complete sweep out of the mapped ring.
+ * Returns 0, or -1 when there is no sweep yet or the sampler kept
+ * overwriting the slot while it was copied.
+ */
+static inline int
+sensor_sampler_latest (const volatile sensor_sampler_ring_t *ring, sensor_sampler_slot_t *out)
+{
+	const volatile sensor_sampler_slot_t *slot;
+	uint32_t seq;
+	int tries;
+
+	for (tries = 0; tries < 4; tries++)
+	{
+		seq = ring->seq;
+		if (seq == 0)
+			return -1;
+		__sync_synchronize ();
+		slot = &ring->slot[seq % SENSOR_SAMPLER_SLOTS];
+		memcpy (out, (const void *)slot, sizeof (*out));
+		__sync_synchronize ();
+		if (out->seq == seq && slot->seq == seq)
+			return 0;
+	}
+	return -1;
+}
+
+#endif
+
+#endif /* AMI_SENSOR_SAMPLER_H */
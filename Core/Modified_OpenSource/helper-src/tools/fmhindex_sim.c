@@ -0,0 +1,191 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+
+/*
+ * FMH index simulator
+ *
+ * Runs FindIndexedModule() on images laid out in a RAM flash, reached
+ * through the same read_flash hook the FwInfo files use. Each image has a
+ * number of one sector modules followed by the MODULE_FMH_FIRMWARE FMH,
+ * from none up to well past FMH_INDEX_MAX_MODULES, and the firmware module
+ * has to be found at its place every time. Also checks that a repeated
+ * lookup only re-reads the firmware FMH, that an image rewritten behind
+ * the index is rescanned, and that an image without firmware FMH fails.
+ *
+ * Build and run from helper-src:
+ *   gcc -O2 -Wall -Itools/include -I. -I${SPXINC}/global -I${SPXINC}/fmh tools/fmhindex_sim.c fmhindex.c fmhcore.c -o fmhindex_sim
+ *   ./fmhindex_sim
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fmh.h"
+#include "fmhindex.h"
+
+#define SIM_SECTOR_SIZE		4096
+#define SIM_IMAGE_SECTORS	256
+#define SIM_IMAGE_SIZE		(SIM_SECTOR_SIZE * SIM_IMAGE_SECTORS)
+#define SIM_IMAGES		3	/* One more than the index holds */
+#define SIM_MODULE_TYPE		0x10	/* Anything but boot loader and firmware */
+
+static unsigned char flash [SIM_IMAGE_SIZE * SIM_IMAGES];
+static unsigned long reads;
+
+#define FAIL(fmt, args...) \
+	do { fprintf (stderr, "FAIL %s:%d: " fmt "\n", __FUNCTION__, __LINE__, ##args); exit (1); } while (0)
+
+static int
+sim_read_flash (unsigned long Offset, unsigned long NumBytes, size_t *NumBytesRead, unsigned char *Buffer)
+{
+	reads++;
+	if (Offset > sizeof (flash) || NumBytes > sizeof (flash) - Offset)
+		FAIL ("read of %lu bytes at 0x%lx is past the flash", NumBytes, Offset);
+	memcpy (Buffer, flash + Offset, NumBytes);
+	*NumBytesRead = NumBytes;
+	return 0;
+}
+
+static FLASH_INFO flinfo = { .read_flash = sim_read_flash };
+
+static unsigned long
+image_start (int image)
+{
+	return (unsigned long)image * SIM_IMAGE_SIZE;
+}
+
+static void
+put_fmh (unsigned long ImageStart, int sector, const char *name, unsigned short type,
+		unsigned long size)
+{
+	MODULE_INFO mod;
+	FMH fmh;
+	unsigned long offset = sector * SIM_SECTOR_SIZE;
+
+	memset (&mod, 0, sizeof (mod));
+	memcpy (mod.Module_Name, name, strlen (name));	/* Names are under 8 characters */
+	mod.Module_Type = host_to_le16 (type);
+	mod.Module_Location = host_to_le32 (offset + FMH_SIZE);	/* From the image start, FMH 1.8 */
+	mod.Module_Size = host_to_le32 (size);
+	CreateFMH (&fmh, SIM_SECTOR_SIZE, &mod);
+	memcpy (flash + ImageStart + offset, &fmh, sizeof (fmh));
+}
+
+/* Lay out "modules" one sector modules, then the firmware FMH if asked for */
+static int
+build_image (int image, int modules, int firmware)
+{
+	unsigned long start = image_start (image);
+	char name [16];
+	int i;
+
+	memset (flash + start, 0xFF, SIM_IMAGE_SIZE);
+	for (i = 0; i < modules; i++)
+	{
+		snprintf (name, sizeof (name), "mod%d", i);
+		put_fmh (start, i, name, SIM_MODULE_TYPE, 100 + i);
+	}
+	if (firmware)
+	{
+		put_fmh (start, modules, "fwinfo", MODULE_FMH_FIRMWARE, 200 + modules);
+		memset (flash + start + modules * SIM_SECTOR_SIZE + FMH_SIZE, 'a' + modules % 26, 200 + modules);
+	}
+	return modules;
+}
+
+static unsigned long
+lookup (int image, int modules)
+{
+	unsigned long start = image_start (image);
+	unsigned long sector = start + modules * SIM_SECTOR_SIZE;
+	unsigned char buf [512];
+	FMH_INDEX_ENTRY mod;
+	size_t len;
+
+	reads = 0;
+	if (FindIndexedModule (start, SIM_IMAGE_SIZE, SIM_SECTOR_SIZE, &flinfo, MODULE_FMH_FIRMWARE, &mod) != 0)
+		FAIL ("image %d with %d modules: MODULE_FMH_FIRMWARE not found", image, modules);
+	if (mod.Type != MODULE_FMH_FIRMWARE || strcmp (mod.Name, "fwinfo") != 0)
+		FAIL ("image %d with %d modules: found %s, type %u", image, modules, mod.Name, mod.Type);
+	if (mod.FmhSector != sector || mod.Location != sector + FMH_SIZE || mod.Size != 200UL + modules)
+		FAIL ("image %d with %d modules: FMH 0x%lx location 0x%lx size %lu, expected 0x%lx 0x%lx %d",
+			image, modules, mod.FmhSector, mod.Location, mod.Size, sector, sector + FMH_SIZE, 200 + modules);
+
+	sim_read_flash (mod.Location, mod.Size, &len, buf);
+	if (buf [0] != 'a' + modules % 26 || buf [mod.Size - 1] != 'a' + modules % 26)
+		FAIL ("image %d with %d modules: wrong module data", image, modules);
+	return reads - 1;
+}
+
+/* Module counts around FMH_INDEX_MAX_MODULES, each on a fresh layout */
+static void
+test_module_counts (void)
+{
+	static const int counts [] = { 0, 5, FMH_INDEX_MAX_MODULES - 1, FMH_INDEX_MAX_MODULES,
+			FMH_INDEX_MAX_MODULES + 1, FMH_INDEX_MAX_MODULES + 8, 200 };
+	unsigned long scan, cached;
+	unsigned int i;
+
+	printf ("%8s %12s %12s\n", "modules", "scan reads", "cached reads");
+	for (i = 0; i < sizeof (counts) / sizeof (counts [0]); i++)
+	{
+		build_image (0, counts [i], 1);
+		scan = lookup (0, counts [i]);
+		cached = lookup (0, counts [i]);
+		printf ("%8d %12lu %12lu\n", counts [i], scan, cached);
+		if (cached > 2)
+			FAIL ("%d modules: a cached lookup took %lu reads", counts [i], cached);
+		if (scan <= cached)
+			FAIL ("%d modules: the image was not rescanned after the rewrite", counts [i]);
+	}
+}
+
+/* More images than index slots, each rewritten behind the index in turn */
+static void
+test_images (void)
+{
+	int image, round;
+
+	for (round = 0; round < 3; round++)
+	{
+		for (image = 0; image < SIM_IMAGES; image++)
+			build_image (image, 10 + 20 * image + round, 1);
+		for (image = 0; image < SIM_IMAGES; image++)
+			lookup (image, 10 + 20 * image + round);
+	}
+}
+
+static void
+test_no_firmware (void)
+{
+	FMH_INDEX_ENTRY mod;
+
+	build_image (0, FMH_INDEX_MAX_MODULES + 3, 0);
+	if (FindIndexedModule (0, SIM_IMAGE_SIZE, SIM_SECTOR_SIZE, &flinfo, MODULE_FMH_FIRMWARE, &mod) == 0)
+		FAIL ("found MODULE_FMH_FIRMWARE in an image without one");
+
+	memset (flash, 0xFF, SIM_IMAGE_SIZE);
+	if (FindIndexedModule (0, SIM_IMAGE_SIZE, SIM_SECTOR_SIZE, &flinfo, MODULE_FMH_FIRMWARE, &mod) == 0)
+		FAIL ("found MODULE_FMH_FIRMWARE in an erased image");
+}
+
+int
+main (int argc, char *argv[])
+{
+	test_module_counts ();
+	test_images ();
+	test_no_firmware ();
+	printf ("all FMH index checks passed\n");
+	return 0;
+}
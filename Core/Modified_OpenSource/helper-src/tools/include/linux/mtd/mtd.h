@@ -0,0 +1 @@
+/* fmhcore.c includes this unconditionally; the simulator needs none of it */
@@ -0,0 +1,326 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/list.h>
+#include <linux/jiffies.h>
+#include <linux/ktime.h>
+#include <linux/eventfd.h>
+#include <linux/workqueue.h>
+#include <linux/i2c.h>
+
+#include "i2c-data.h"
+#include "i2c-async.h"
+#include "i2c-stats.h"
+
+extern struct i2c_as_data as_data_ptr[BUS_COUNT];
+
+struct i2c_async_req
+{
+	struct list_head list;		/* pending or done list of the bus */
+	struct list_head followers;	/* requests coalesced into this one */
+	struct eventfd_ctx *eventfd;
+	ktime_t submitted;
+	unsigned long expires;		/* jiffies, once done */
+	i2c_async_req_t req;
+	i2c_async_done_t done;
+};
+
+static struct workqueue_struct *async_wq;
+
+static void free_req_list(struct list_head *head)
+{
+	struct i2c_async_req *r, *tmp;
+
+	list_for_each_entry_safe(r, tmp, head, list)
+	{
+		list_del(&r->list);
+		free_req_list(&r->followers);
+		eventfd_ctx_put(r->eventfd);
+		kfree(r);
+	}
+}
+
+static int can_coalesce(const i2c_async_req_t *req)
+{
+	return !(req->flags & I2C_ASYNC_NO_COALESCE) && req->rlen != 0 &&
+		req->wlen <= I2C_ASYNC_COALESCE_WLEN;
+}
+
+static int same_read(const i2c_async_req_t *a, const i2c_async_req_t *b)
+{
+	return a->addr == b->addr && a->wlen == b->wlen && a->rlen == b->rlen &&
+		memcmp(a->wbuf, b->wbuf, a->wlen) == 0;
+}
+
+/* Moves results nobody reaped in time to expired. Called with the queue lock held */
+static int expire_done(struct i2c_async_queue *q, struct list_head *expired)
+{
+	struct i2c_async_req *r, *tmp;
+	int count = 0;
+
+	list_for_each_entry_safe(r, tmp, &q->done, list)
+	{
+		/* The done list is in completion order */
+		if (time_before(jiffies, r->expires))
+			break;
+		list_move_tail(&r->list, expired);
+		q->depth--;
+		count++;
+	}
+	return count;
+}
+
+static void i2c_async_run(struct i2c_adapter *i2c_adap, struct i2c_async_req *r)
+{
+	struct i2c_msg msgs[2];
+	ktime_t start;
+	int num = 0;
+	int ret;
+
+	if (r->req.wlen)
+	{
+		msgs[num].addr = r->req.addr;
+		msgs[num].flags = 0;
+		msgs[num].len = r->req.wlen;
+		msgs[num].buf = r->req.wbuf;
+		num++;
+	}
+	if (r->req.rlen)
+	{
+		msgs[num].addr = r->req.addr;
+		msgs[num].flags = I2C_M_RD;
+		msgs[num].len = r->req.rlen;
+		msgs[num].buf = r->done.rbuf;
+		num++;
+	}
+
+	start = ktime_get();
+	r->done.queued_us = (u32)ktime_us_delta(start, r->submitted);
+	i2c_stats_async_start(i2c_adap->nr, r->done.queued_us);
+
+	/* Takes the adapter lock, so synchronous callers get the bus in between */
+	ret = i2c_transfer(i2c_adap, msgs, num);
+
+	r->done.xfer_us = (u32)ktime_us_delta(ktime_get(), start);
+	if (ret == num)
+		r->done.status = 0;
+	else
+		r->done.status = (ret < 0) ? ret : -EIO;
+}
+
+static void i2c_async_work(struct work_struct *work)
+{
+	struct i2c_async_queue *q = container_of(work, struct i2c_async_queue, work);
+	struct i2c_async_req *r, *f;
+	ktime_t start;
+	unsigned long expires;
+
+	for (;;)
+	{
+		spin_lock(&q->lock);
+		if (q->stopped || list_empty(&q->pending))
+		{
+			spin_unlock(&q->lock);
+			break;
+		}
+		r = list_first_entry(&q->pending, struct i2c_async_req, list);
+		list_del(&r->list);
+		spin_unlock(&q->lock);
+
+		start = ktime_get();
+		i2c_async_run(q->i2c_adap, r);
+		expires = jiffies + msecs_to_jiffies(I2C_ASYNC_EXPIRE);
+
+		/* Signalled under the lock so a reaper woken by it finds the result */
+		spin_lock(&q->lock);
+		r->expires = expires;
+		list_add_tail(&r->list, &q->done);
+		eventfd_signal(r->eventfd, 1);
+		list_for_each_entry(f, &r->followers, list)
+		{
+			f->done.status = r->done.status;
+			f->done.queued_us = (u32)ktime_us_delta(start, f->submitted);
+			f->done.xfer_us = r->done.xfer_us;
+			f->done.flags = I2C_ASYNC_COALESCED;
+			memcpy(f->done.rbuf, r->done.rbuf, r->done.rlen);
+			f->expires = expires;
+			eventfd_signal(f->eventfd, 1);
+		}
+		list_splice_tail_init(&r->followers, &q->done);
+		spin_unlock(&q->lock);
+	}
+}
+
+int i2c_async_submit(struct i2c_adapter *i2c_adap, const i2c_async_req_t *req)
+{
+	struct i2c_async_queue *q = &as_data_ptr[i2c_adap->nr].async;
+	struct i2c_async_req *r, *p;
+	LIST_HEAD(expired);
+	int coalesced = 0;
+	int depth, count;
+	int retval = 0;
+
+	if (req->addr > 0x7F || req->wlen > I2C_ASYNC_MAX_LEN || req->rlen > I2C_ASYNC_MAX_LEN ||
+	    (req->wlen == 0 && req->rlen == 0))
+		return -EINVAL;
+
+	r = kzalloc(sizeof(*r), GFP_KERNEL);
+	if (!r)
+		return -ENOMEM;
+	r->eventfd = eventfd_ctx_fdget(req->eventfd);
+	if (IS_ERR(r->eventfd))
+	{
+		retval = PTR_ERR(r->eventfd);
+		kfree(r);
+		return retval;
+	}
+	INIT_LIST_HEAD(&r->followers);
+	r->req = *req;
+	r->done.cookie = req->cookie;
+	r->done.rlen = req->rlen;
+	r->submitted = ktime_get();
+
+	spin_lock(&q->lock);
+	count = expire_done(q, &expired);
+	if (q->stopped)
+		retval = -ENODEV;
+	else if (q->depth >= I2C_ASYNC_DEPTH)
+		retval = -EAGAIN;
+	else
+	{
+		if (can_coalesce(req))
+		{
+			list_for_each_entry(p, &q->pending, list)
+			{
+				if (can_coalesce(&p->req) && same_read(&p->req, req))
+				{
+					list_add_tail(&r->list, &p->followers);
+					coalesced = 1;
+					break;
+				}
+			}
+		}
+		if (!coalesced)
+			list_add_tail(&r->list, &q->pending);
+		depth = ++q->depth;
+	}
+	spin_unlock(&q->lock);
+
+	if (count)
+	{
+		free_req_list(&expired);
+		i2c_stats_async_expired(i2c_adap->nr, count);
+	}
+	if (retval != 0)
+	{
+		eventfd_ctx_put(r->eventfd);
+		kfree(r);
+		return retval;
+	}
+
+	if (!coalesced)
+		queue_work(async_wq, &q->work);
+	i2c_stats_async_submit(i2c_adap->nr, coalesced, depth);
+	return 0;
+}
+
+/* Returns the number of results copied to reap->done */
+int i2c_async_reap(struct i2c_adapter *i2c_adap, i2c_async_reap_t *reap)
+{
+	struct i2c_async_queue *q = &as_data_ptr[i2c_adap->nr].async;
+	struct i2c_async_req *r, *tmp;
+	struct eventfd_ctx *ctx;
+	LIST_HEAD(reaped);
+	LIST_HEAD(expired);
+	unsigned int max = min_t(unsigned int, reap->count, I2C_ASYNC_MAX_REAP);
+	unsigned int n = 0;
+	int count;
+
+	ctx = eventfd_ctx_fdget(reap->eventfd);
+	if (IS_ERR(ctx))
+		return PTR_ERR(ctx);
+
+	spin_lock(&q->lock);
+	count = expire_done(q, &expired);
+	list_for_each_entry_safe(r, tmp, &q->done, list)
+	{
+		if (n >= max)
+			break;
+		if (r->eventfd != ctx)
+			continue;
+		reap->done[n++] = r->done;
+		list_move_tail(&r->list, &reaped);
+		q->depth--;
+	}
+	spin_unlock(&q->lock);
+
+	free_req_list(&reaped);
+	if (count)
+	{
+		free_req_list(&expired);
+		i2c_stats_async_expired(i2c_adap->nr, count);
+	}
+	eventfd_ctx_put(ctx);
+
+	reap->count = n;
+	return n;
+}
+
+void i2c_async_bus_init(struct i2c_adapter *i2c_adap)
+{
+	struct i2c_async_queue *q = &as_data_ptr[i2c_adap->nr].async;
+
+	spin_lock_init(&q->lock);
+	INIT_LIST_HEAD(&q->pending);
+	INIT_LIST_HEAD(&q->done);
+	q->depth = 0;
+	q->stopped = 0;
+	INIT_WORK(&q->work, i2c_async_work);
+	q->i2c_adap = i2c_adap;
+}
+
+void i2c_async_bus_exit(struct i2c_adapter *i2c_adap)
+{
+	struct i2c_async_queue *q = &as_data_ptr[i2c_adap->nr].async;
+	LIST_HEAD(drop);
+
+	spin_lock(&q->lock);
+	q->stopped = 1;
+	spin_unlock(&q->lock);
+
+	/* Waits for the transfer in flight, which then goes to the done list */
+	cancel_work_sync(&q->work);
+
+	list_splice_init(&q->pending, &drop);
+	list_splice_init(&q->done, &drop);
+	q->depth = 0;
+	free_req_list(&drop);
+}
+
+int i2c_async_init(void)
+{
+	/* Unbound, so that each bus works through its queue on its own */
+	async_wq = alloc_workqueue("i2c_async", WQ_UNBOUND, BUS_COUNT);
+	if (!async_wq)
+		return -ENOMEM;
+	return 0;
+}
+
+void i2c_async_exit(void)
+{
+	destroy_workqueue(async_wq);
+}
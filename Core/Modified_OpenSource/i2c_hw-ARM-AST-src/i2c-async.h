@@ -0,0 +1,101 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+#ifndef _I2C_ASYNC_H
+#define _I2C_ASYNC_H
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#endif
+
+/*
+ * Asynchronous master transfers
+ *
+ * Extended ioctls on /dev/i2c-N, next to ENABLE_SSIF. I2C_ASYNC_SUBMIT
+ * queues a transaction on the bus and returns at once. Each bus runs its
+ * queue in its own work item, so a device that stretches the clock on one
+ * bus holds up that bus only, and synchronous I2C_RDWR callers are still
+ * served between queued transactions.
+ *
+ * When a transaction is done the eventfd given with it is signalled, and
+ * I2C_ASYNC_REAP on the same bus returns the results of the transactions
+ * submitted with that eventfd. One eventfd can be shared by several buses,
+ * in which case each of them has to be reaped. Results not reaped within
+ * I2C_ASYNC_EXPIRE ms are dropped.
+ *
+ * A transaction is a write of wlen bytes, a read of rlen bytes, or a write
+ * followed by a read after a repeated start. A read with a register pointer
+ * of at most I2C_ASYNC_COALESCE_WLEN bytes that is identical to one still
+ * waiting in the queue is not queued again: both get the result of the
+ * same transfer, unless I2C_ASYNC_NO_COALESCE is set.
+ */
+#define I2C_ASYNC_SUBMIT	0x0853
+#define I2C_ASYNC_REAP		0x0854
+
+#define I2C_ASYNC_MAX_LEN	64
+#define I2C_ASYNC_MAX_REAP	8
+#define I2C_ASYNC_DEPTH		64	/* queued and unreaped transactions per bus */
+#define I2C_ASYNC_EXPIRE	10000	/* ms */
+#define I2C_ASYNC_COALESCE_WLEN	2
+
+/* i2c_async_req_t flags */
+#define I2C_ASYNC_NO_COALESCE	0x0001
+
+/* i2c_async_done_t flags */
+#define I2C_ASYNC_COALESCED	0x0001	/* served by the transfer of another request */
+
+typedef struct
+{
+	uint64_t cookie;	/* returned with the result */
+	int32_t  eventfd;
+	uint16_t flags;
+	uint16_t addr;		/* 7 bit */
+	uint8_t  wlen;
+	uint8_t  rlen;
+	uint8_t  reserved[2];
+	uint8_t  wbuf[I2C_ASYNC_MAX_LEN];
+} __attribute__((packed)) i2c_async_req_t;
+
+typedef struct
+{
+	uint64_t cookie;
+	int32_t  status;	/* 0, or what I2C_RDWR would have returned */
+	uint32_t queued_us;	/* from submission to the start of the transfer */
+	uint32_t xfer_us;	/* on the bus */
+	uint16_t flags;
+	uint8_t  rlen;
+	uint8_t  reserved;
+	uint8_t  rbuf[I2C_ASYNC_MAX_LEN];
+} __attribute__((packed)) i2c_async_done_t;
+
+typedef struct
+{
+	int32_t  eventfd;	/* in */
+	uint32_t count;		/* in: max entries, out: entries filled */
+	i2c_async_done_t done[I2C_ASYNC_MAX_REAP];
+} __attribute__((packed)) i2c_async_reap_t;
+
+#ifdef __KERNEL__
+#include <linux/i2c.h>
+
+int i2c_async_init(void);
+void i2c_async_exit(void);
+void i2c_async_bus_init(struct i2c_adapter *i2c_adap);
+void i2c_async_bus_exit(struct i2c_adapter *i2c_adap);
+int i2c_async_submit(struct i2c_adapter *i2c_adap, const i2c_async_req_t *req);
+int i2c_async_reap(struct i2c_adapter *i2c_adap, i2c_async_reap_t *reap);
+#endif
+
+#endif // _I2C_ASYNC_H
@@ -25,6 +25,7 @@
 
 #include "i2c-data.h"
 #include "i2c-hardware.h"
+#include "i2c-stats.h"
 
 
 
@@ -132,6 +133,7 @@ void i2c_init_internal_data(int bus)
     init_waitqueue_head( &(as_data_ptr[bus].as_wait)); 
     init_waitqueue_head( &(as_data_ptr[bus].as_slave_data_wait)); 
     init_waitqueue_head( &(as_data_ptr[bus].as_mctp_data_wait));
+    i2c_stats_init(bus);
 	as_data_ptr[bus].op_status = 0;
 	as_data_ptr[bus].abort_status = 0;
 
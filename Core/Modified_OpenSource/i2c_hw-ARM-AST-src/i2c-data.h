@@ -15,6 +15,7 @@
 #define _I2C_DATA_H
 
 #include <linux/i2c.h>
+#include <linux/workqueue.h>
 
 #define TRANSFERSIZE 1024
 #define MAX_FIFO_LEN 16
@@ -131,6 +132,42 @@ struct log_i2c_conf
 };
 #endif // CONFIG_SPX_FEATURE_ENABLE_I2C_LOG
 
+/* Transfer time buckets of /proc/stats-i2cN, in us */
+#define I2C_STATS_BUCKETS	8
+#define I2C_STATS_BUCKET_LIMITS	{ 100, 500, 1000, 5000, 10000, 50000, 100000 }
+
+struct i2c_bus_stats
+{
+	spinlock_t lock;	/* recoveries are also counted from the interrupt */
+	u32 xfers;
+	u32 errors;		/* all failed transfers */
+	u32 nacks;
+	u32 arb_lost;
+	u32 bus_errors;		/* timeouts and SCL low timeouts */
+	u32 recoveries;
+	u32 recovery_failures;
+	u64 xfer_us;
+	u32 xfer_max_us;
+	u32 xfer_hist[I2C_STATS_BUCKETS];
+	u32 async_submitted;
+	u32 async_coalesced;
+	u32 async_expired;
+	u32 async_max_depth;
+	u64 queued_us;
+	u32 queued_max_us;
+};
+
+struct i2c_async_queue
+{
+	spinlock_t lock;
+	struct list_head pending;
+	struct list_head done;
+	int depth;		/* pending, in flight and done */
+	int stopped;
+	struct work_struct work;
+	struct i2c_adapter *i2c_adap;
+};
+
 struct i2c_as_data
 {
     int i2c_dma_mode;
@@ -213,6 +250,8 @@ struct i2c_as_data
 #ifdef CONFIG_SPX_FEATURE_ENABLE_I2C_LOG
         struct log_i2c_conf log_conf;
 #endif
+	struct i2c_bus_stats stats;
+	struct i2c_async_queue async;
 
 };
 
@@ -32,6 +32,8 @@
 #include "i2c-data.h"
 #include "i2c-hardware.h"
 #include "i2c-log.h"
+#include "i2c-stats.h"
+#include "i2c-async.h"
 
 #define I2C_ID              ( 1 )
 
@@ -57,6 +59,12 @@ i2c_as_init( void )
     for( i = 0; i < bus_count; i++ )
 		i2c_init_internal_data(i);
 
+	if (i2c_async_init() != 0)
+	{
+		printk( KERN_ERR "Cannot allocate the I2C async workqueue\n" );
+		return( -ENOMEM );
+	}
+
 	for( i = 0; i < bus_count; i++ )
 	{
 		if (CONFIG_SPX_FEATURE_I2C_BUS_DISABLE_MASK & (1 << i)) continue;
@@ -206,6 +214,7 @@ i2c_as_exit( void )
 #endif /* CONFIG_SPX_FEATURE_NUM_BMC_COMPANION_DEVICES >= 2 */
 #endif
 
+	i2c_async_exit();
 
 	return;
 }
@@ -226,6 +235,8 @@ as_control( struct i2c_adapter *i2c_adap, unsigned long cmd,
 	bus_recovery_info_T	bus_recovery_info;
 	i2c_bus_test_T testData;
 	i2c_link_state_T linkData;
+	i2c_async_req_t asyncReq;
+	i2c_async_reap_t *asyncReap;
     char *tmp;
 
     switch( cmd )
@@ -300,6 +311,28 @@ as_control( struct i2c_adapter *i2c_adap, unsigned long cmd,
     	    i2c_as_slave_xfer_enable(i2c_adap->nr); 
 		    break; 
 
+		case I2C_ASYNC_SUBMIT:
+			if (copy_from_user(&asyncReq, (void*)arg, sizeof(i2c_async_req_t)))
+				return -EFAULT;
+			retval = i2c_async_submit(i2c_adap, &asyncReq);
+			break;
+
+		case I2C_ASYNC_REAP:
+			asyncReap = kmalloc(sizeof(i2c_async_reap_t), GFP_KERNEL);
+			if (!asyncReap)
+				return -ENOMEM;
+			if (copy_from_user(asyncReap, (void*)arg, offsetof(i2c_async_reap_t, done)))
+			{
+				kfree(asyncReap);
+				return -EFAULT;
+			}
+			retval = i2c_async_reap(i2c_adap, asyncReap);
+			if (retval >= 0 && copy_to_user((void*)arg, asyncReap,
+					offsetof(i2c_async_reap_t, done) + retval * sizeof(i2c_async_done_t)))
+				retval = -EFAULT;
+			kfree(asyncReap);
+			break;
+
         default:
             dev_err( &i2c_adap->dev, "as_control: Unknown ioctl command\n" );
             retval = -ENOTTY;
@@ -330,9 +363,11 @@ i2c_as_add_bus( struct i2c_adapter *i2c_adap )
     i2c_adap->timeout = DEFAULT_TIMEOUT;
     i2c_adap->retries = DEFAULT_RETRIES;
 
+    i2c_async_bus_init( i2c_adap );
     i2c_add_adapter( i2c_adap );
     //printk("I2C%d: Hardware routines registered\n",i2c_adap->nr);
     log_i2c_proc_open( i2c_adap );
+    i2c_stats_proc_open( i2c_adap );
     
     return(0);
 }
@@ -340,7 +375,9 @@ i2c_as_add_bus( struct i2c_adapter *i2c_adap )
 int 
 i2c_as_del_bus( struct i2c_adapter *i2c_adap )
 {	
+	i2c_stats_proc_release( i2c_adap );
 	log_i2c_proc_release( i2c_adap );
+	i2c_async_bus_exit( i2c_adap );
     i2c_del_adapter( i2c_adap );
 	return 0;
 }
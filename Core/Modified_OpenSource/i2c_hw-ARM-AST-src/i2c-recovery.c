@@ -25,6 +25,7 @@
 
 #include "i2c-data.h"
 #include "i2c-hardware.h"
+#include "i2c-stats.h"
 
 
 
@@ -298,6 +299,7 @@ int i2c_bus_recovery(int bus)
 		if(bus_status == 0)
 		{
 			//printk("I2C%d: Slave recovery succeed\n",bus);
+			i2c_stats_recovery(bus, 0);
 			return 0;
 		}
 		
@@ -306,10 +308,12 @@ int i2c_bus_recovery(int bus)
 		if(bus_status == 0)
 		{
 			//printk("I2C%d: AST recovery succeed\n",bus);
+			i2c_stats_recovery(bus, 0);
 			return 0;
 		}
 		
 		printk("ERROR: I2C%d: BUS recovery did not succeed\n",bus);
+		i2c_stats_recovery(bus, -EIO);
 		return -EIO;
 	}
 	else
@@ -0,0 +1,201 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/proc_fs.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
+
+#include "i2c-data.h"
+#include "i2c-stats.h"
+
+extern struct i2c_as_data as_data_ptr[BUS_COUNT];
+
+static const u32 bucket_limit[I2C_STATS_BUCKETS - 1] = I2C_STATS_BUCKET_LIMITS;
+
+// /proc/stats-i2cN holds the master transfer statistics of I2C bus N, both
+// synchronous and I2C_ASYNC_SUBMIT transfers. Writing anything to it clears
+// them.
+
+static void stats_clear(struct i2c_bus_stats *stats)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	memset(&stats->xfers, 0, sizeof(*stats) - offsetof(struct i2c_bus_stats, xfers));
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+void i2c_stats_init(int bus)
+{
+	spin_lock_init(&as_data_ptr[bus].stats.lock);
+	stats_clear(&as_data_ptr[bus].stats);
+}
+
+/* Called with the result of as_master_xfer(), num messages on success */
+void i2c_stats_xfer(int bus, int ret, int num, u32 us)
+{
+	struct i2c_bus_stats *stats = &as_data_ptr[bus].stats;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->xfers++;
+	if (ret != num)
+	{
+		stats->errors++;
+		if (ret == (int)NACKONWR)
+			stats->nacks++;
+		else if (ret == (int)ARBLOST)
+			stats->arb_lost++;
+		else if (ret == (int)BUSERR)
+			stats->bus_errors++;
+	}
+
+	stats->xfer_us += us;
+	if (us > stats->xfer_max_us)
+		stats->xfer_max_us = us;
+	for (i = 0; i < I2C_STATS_BUCKETS - 1; i++)
+	{
+		if (us < bucket_limit[i])
+			break;
+	}
+	stats->xfer_hist[i]++;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+void i2c_stats_recovery(int bus, int ret)
+{
+	struct i2c_bus_stats *stats = &as_data_ptr[bus].stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->recoveries++;
+	if (ret != 0)
+		stats->recovery_failures++;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+void i2c_stats_async_submit(int bus, int coalesced, int depth)
+{
+	struct i2c_bus_stats *stats = &as_data_ptr[bus].stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->async_submitted++;
+	if (coalesced)
+		stats->async_coalesced++;
+	if (depth > stats->async_max_depth)
+		stats->async_max_depth = depth;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+void i2c_stats_async_start(int bus, u32 queued_us)
+{
+	struct i2c_bus_stats *stats = &as_data_ptr[bus].stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->queued_us += queued_us;
+	if (queued_us > stats->queued_max_us)
+		stats->queued_max_us = queued_us;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+void i2c_stats_async_expired(int bus, int count)
+{
+	struct i2c_bus_stats *stats = &as_data_ptr[bus].stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->async_expired += count;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+static ssize_t i2c_stats_proc_read(struct file *file, char __user *buffer, size_t count, loff_t *ppos)
+{
+	struct i2c_bus_stats *stats = PDE_DATA(file_inode(file));
+	struct i2c_bus_stats snap;
+	unsigned long flags;
+	u32 started;
+	char *buf;
+	int len, i;
+	ssize_t ret;
+
+	buf = kmalloc(PAGE_SIZE, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	snap = *stats;
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	len = scnprintf(buf, PAGE_SIZE, "xfers: %u\n", snap.xfers);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "errors: %u (nack %u, arblost %u, buserr %u)\n",
+		snap.errors, snap.nacks, snap.arb_lost, snap.bus_errors);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "recoveries: %u (failed %u)\n",
+		snap.recoveries, snap.recovery_failures);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "xfer time: avg %llu us, max %u us\n",
+		snap.xfers ? (unsigned long long)div_u64(snap.xfer_us, snap.xfers) : 0ULL, snap.xfer_max_us);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "xfer time histogram:");
+	for (i = 0; i < I2C_STATS_BUCKETS - 1; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, " <%uus %u", bucket_limit[i], snap.xfer_hist[i]);
+	len += scnprintf(buf + len, PAGE_SIZE - len, " more %u\n", snap.xfer_hist[i]);
+
+	started = snap.async_submitted - snap.async_coalesced;
+	len += scnprintf(buf + len, PAGE_SIZE - len, "async: submitted %u, coalesced %u, expired %u, max depth %u\n",
+		snap.async_submitted, snap.async_coalesced, snap.async_expired, snap.async_max_depth);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "async queue time: avg %llu us, max %u us\n",
+		started ? (unsigned long long)div_u64(snap.queued_us, started) : 0ULL, snap.queued_max_us);
+
+	ret = simple_read_from_buffer(buffer, count, ppos, buf, len);
+	kfree(buf);
+	return ret;
+}
+
+static ssize_t i2c_stats_proc_write(struct file *file, const char __user *buffer, size_t count, loff_t *ppos)
+{
+	stats_clear(PDE_DATA(file_inode(file)));
+	return count;
+}
+
+static const struct file_operations i2c_stats_proc_fops = {
+	.owner  = THIS_MODULE,
+	.read   = i2c_stats_proc_read,
+	.write  = i2c_stats_proc_write,
+	.llseek = default_llseek,
+};
+
+static void get_proc_name(int bus, char *buf, size_t size)
+{
+	snprintf(buf, size, "stats-i2c%d", bus);
+}
+
+void i2c_stats_proc_open(struct i2c_adapter *pdev)
+{
+	char name[32];
+
+	get_proc_name(pdev->nr, name, sizeof(name));
+	if (!proc_create_data(name, 0644, NULL, &i2c_stats_proc_fops, &as_data_ptr[pdev->nr].stats))
+		printk(KERN_ERR "Could not initialize /proc/%s\n", name);
+}
+
+void i2c_stats_proc_release(struct i2c_adapter *pdev)
+{
+	char name[32];
+
+	get_proc_name(pdev->nr, name, sizeof(name));
+	remove_proc_entry(name, NULL);
+}
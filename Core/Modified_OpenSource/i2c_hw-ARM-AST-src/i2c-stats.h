@@ -0,0 +1,28 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+#ifndef _I2C_STATS_H
+#define _I2C_STATS_H
+
+#include <linux/i2c.h>
+
+void i2c_stats_init(int bus);
+void i2c_stats_proc_open(struct i2c_adapter *pdev);
+void i2c_stats_proc_release(struct i2c_adapter *pdev);
+void i2c_stats_xfer(int bus, int ret, int num, u32 us);
+void i2c_stats_recovery(int bus, int ret);
+void i2c_stats_async_submit(int bus, int coalesced, int depth);
+void i2c_stats_async_start(int bus, u32 queued_us);
+void i2c_stats_async_expired(int bus, int count);
+
+#endif // _I2C_STATS_H
@@ -18,6 +18,7 @@
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/wait.h>
+#include <linux/ktime.h>
 #include <mach/platform.h>
 #include <asm/io.h>
 #include <asm/irq.h>
@@ -25,6 +26,7 @@
 #include "i2c-data.h"
 #include "i2c-hardware.h"
 #include "i2c-log.h"
+#include "i2c-stats.h"
 
 #include <linux/i2c.h>
 #include <linux/semaphore.h>
@@ -394,7 +396,7 @@ send_slave_addr( struct i2c_adapter *i2c_adap, int addr, int flags )
 }
 
 
-int as_master_xfer(struct i2c_adapter *i2c_adap,
+static int as_do_master_xfer(struct i2c_adapter *i2c_adap,
                     struct i2c_msg *msgs, int num )
 {
   	int i = 0;
@@ -636,6 +638,17 @@ int as_master_xfer(struct i2c_adapter *i2c_adap,
 #endif
 }	
 
+int as_master_xfer(struct i2c_adapter *i2c_adap,
+                    struct i2c_msg *msgs, int num )
+{
+	ktime_t start = ktime_get();
+	int retval;
+
+	retval = as_do_master_xfer(i2c_adap, msgs, num);
+	i2c_stats_xfer(i2c_adap->nr, retval, num, (u32)ktime_us_delta(ktime_get(), start));
+	return retval;
+}
+
 int as_smb_xfer( struct i2c_adapter *i2c_adap, u16 addr, unsigned short flags,
 							char read_write, u8 command, int size, union i2c_smbus_data * data)
                     
@@ -15,6 +15,8 @@
 #include "bot.h"
 #include "scsi.h"
 #include "iusb-scsi.h"
+#include "iusb-cdrom.h"
+#include "iusb-ring.h"
 
 #define MAX_CDROM_INSTANCE	4
 
@@ -62,6 +64,7 @@ ReleaseCdromInstanceIndex (uint8 Instance)
 	if (FirstTime == 0)
 	{
 		iUsbCdromInstance [Instance] = 0;
+		iUsbRingDrop(IUSB_DEVICE_CDROM, Instance);
 		if (iUsbCdromActive[Instance])
 		{
 			iUsbCdromActive[Instance] = 0; 
@@ -162,6 +165,14 @@ CdromRemoteCall(IUSB_SCSI_PACKET *iUsbScsiPkt,uint32 PktLen, uint8 Instance)
 	return 0;
 }
 
+/* Wakes up the request waiter of the instance so that it sees freed ring slots */
+void
+CdromRingNotify(uint8 Instance)
+{
+	if (Instance < MAX_CDROM_INSTANCE)
+		wake_up(&cd_req_wait[Instance]);
+}
+
 
 int CdromRemoteActivate(uint8 Instance)
 {
@@ -194,6 +205,7 @@ int CdromRemoteDeactivate(uint8 Instance)
 	iUsbCdromActive[Instance] = 0; 
     wake_up(&cd_req_wait[Instance]);
 	iUsbCdromReqPkt[Instance] = NULL;
+	iUsbRingDrop(IUSB_DEVICE_CDROM, Instance);
 	return 1;
 }
                               
@@ -218,13 +230,18 @@ CdromRemoteWaitRequest(IUSB_SCSI_PACKET *UserModePkt, uint8 Instance)
 	TDBG_FLAGGED(iusb, DEBUG_IUSB_CDROM,
 		"CdromRequest:Sleep Entering for Instance %d\n", Instance);
 
-    retval = wait_event_interruptible(cd_req_wait[Instance],(iUsbCdromWakeup[Instance] || !iUsbCdromActive[Instance]));
+    retval = wait_event_interruptible(cd_req_wait[Instance],(iUsbCdromWakeup[Instance] || !iUsbCdromActive[Instance] ||
+					iUsbRingFreed(IUSB_DEVICE_CDROM, Instance)));
     if(retval)
     {
         TWARN("wait for cdrom request was disturbed by an interrupt please restart system call for Instance %d\n", Instance);
         return  -EINTR;
     }
 
+	/* Read-ahead slots were used up or dropped, the server refills them even without a request */
+	if (iUsbRingClearFreed(IUSB_DEVICE_CDROM, Instance) && !iUsbCdromWakeup[Instance] && iUsbCdromActive[Instance])
+		return IUSB_RING_REFILL;
+
 	iUsbCdromWakeup[Instance] = 0; //reset wakeup to 0 so that someone can wake us up again when we wait.
 							 //no contention problems here because we are under cli
     if(!iUsbCdromActive[Instance])
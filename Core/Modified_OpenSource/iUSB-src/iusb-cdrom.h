@@ -25,6 +25,7 @@ extern int CdromRemoteDeactivate(uint8 Instance);
 extern int CdromRemoteCall(IUSB_SCSI_PACKET *iUsbScsiPkt,uint32 PktLen, uint8 Instance);
 extern int CdromCheckSupportedCmd(uint8 DevNo,uint8 ifnum,uint8 Command, BOT_IF_DATA *MassData, uint8 Instance);
 extern IUSB_SCSI_PACKET* CdromGetiUsbPacket(uint8 DevNo,uint8 ifnum, uint8 Instance);
+extern void CdromRingNotify(uint8 Instance);
 
 #define MAX_CD_INSTANCES		4
 
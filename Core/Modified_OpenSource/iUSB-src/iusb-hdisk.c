@@ -16,6 +16,7 @@
 #include "scsi.h"
 #include "iusb-scsi.h"
 #include "iusb-hdisk.h" 
+#include "iusb-ring.h"
 
 #define MAX_HDISK_INSTANCE		(MAX_HD_INSTANCES + MAX_SD_INSTANCES)
 
@@ -65,6 +66,7 @@ ReleaseHdiskInstanceIndex (uint8 Instance)
 	if (FirstTime == 0)
 	{
 		iUsbHdiskInstance [Instance] = 0;
+		iUsbRingDrop(IUSB_DEVICE_HARDDISK, Instance);
 		if (iUsbHdiskActive [Instance])
 		{
 			iUsbHdiskActive [Instance] = 0; 
@@ -159,6 +161,14 @@ HdiskRemoteCall(IUSB_SCSI_PACKET *iUsbScsiPkt,uint32 PktLen, uint8 Instance)
 	return 0;
 }
 
+/* Wakes up the request waiter of the instance so that it sees freed ring slots */
+void
+HdiskRingNotify(uint8 Instance)
+{
+	if (Instance < MAX_HDISK_INSTANCE)
+		wake_up(&hd_req_wait[Instance]);
+}
+
 int
 HdiskRemoteActivate(uint8 Instance)
 {
@@ -193,6 +203,7 @@ HdiskRemoteDeactivate(uint8 Instance)
 	iUsbHdiskActive [Instance] = 0; 
 	wake_up(&hd_req_wait[Instance]);
 	iUsbHdiskReqPkt[Instance] = NULL;
+	iUsbRingDrop(IUSB_DEVICE_HARDDISK, Instance);
 	return 1;
 }
                               
@@ -218,13 +229,18 @@ HdiskRemoteWaitRequest(IUSB_SCSI_PACKET *UserModePkt, uint8 Instance)
 		"HdiskRequest:Sleep Entering for Instance %d\n", Instance);
 
     retval = wait_event_interruptible(hd_req_wait[Instance],
-					(iUsbHdiskWakeup[Instance] || !iUsbHdiskActive[Instance]));
+					(iUsbHdiskWakeup[Instance] || !iUsbHdiskActive[Instance] ||
+					 iUsbRingFreed(IUSB_DEVICE_HARDDISK, Instance)));
     if(retval)
     {
         TWARN("wait for Hdisk request was disturbed by an interrupt please restart system call for Instance %d\n", Instance);
         return  -EINTR;
     }
 
+	/* Read-ahead slots were used up or dropped, the server refills them even without a request */
+	if (iUsbRingClearFreed(IUSB_DEVICE_HARDDISK, Instance) && !iUsbHdiskWakeup[Instance] && iUsbHdiskActive[Instance])
+		return IUSB_RING_REFILL;
+
 	iUsbHdiskWakeup[Instance] = 0;
 							 
     if(!iUsbHdiskActive[Instance])
@@ -25,6 +25,7 @@ extern int HdiskRemoteDeactivate(uint8 Instance);
 extern int HdiskCheckSupportedCmd(uint8 DevNo,uint8 ifnum,uint8 Command, BOT_IF_DATA *MassData, uint8 Instance);
 extern int HdiskRemoteCall(IUSB_SCSI_PACKET *iUsbScsiPkt,uint32 PktLen, uint8 Instance);
 extern IUSB_SCSI_PACKET* HdiskGetiUsbPacket(uint8 DevNo,uint8 ifnum, uint8 Instance);
+extern void HdiskRingNotify(uint8 Instance);
 
 #define MAX_HD_INSTANCES		4
 #define MAX_SD_INSTANCES		1
@@ -0,0 +1,350 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <coreTypes.h>
+#include "bot.h"
+#include "scsi.h"
+#include "iusb-scsi.h"
+#include "iusb-cdrom.h"
+#include "iusb-hdisk.h"
+#include "iusb-ring.h"
+
+extern video_callback	g_video_callback;
+
+typedef struct
+{
+	uint8	*Area;					/* vmalloc_user, the header page then the slots */
+	uint8	SlotState [IUSB_RING_SLOTS];	/* The server can write the mapping, so this is what counts */
+	BOT_IF_DATA *MassData;			/* Interface of the last command for this instance */
+	uint8	QueuedCdb [IUSB_RING_SLOTS][10];	/* READ(10) of a queued slot, as it was queued */
+	uint32	QueuedLen [IUSB_RING_SLOTS];
+	uint8	Freed;					/* Queued slots were consumed or dropped */
+} IUSB_RING;
+
+static IUSB_RING CdRing [MAX_CD_INSTANCES];
+static IUSB_RING HdRing [MAX_HD_INSTANCES + MAX_SD_INSTANCES];
+static DEFINE_SPINLOCK(RingLock);		/* Slot states, Freed and the queue counters */
+static DEFINE_MUTEX(RingAllocLock);
+
+#define RING_HDR(Ring)			((IUSB_RING_HEADER *)((Ring)->Area))
+#define RING_SLOT(Ring, Slot)	((IUSB_SCSI_PACKET *)((Ring)->Area + PAGE_SIZE + (Slot) * IUSB_RING_SLOT_SIZE))
+
+/* Called with RingLock held. The header only gets a copy that is never read back */
+static void
+SetSlotState(IUSB_RING *Ring, int Slot, uint8 State)
+{
+	Ring->SlotState[Slot] = State;
+	RING_HDR(Ring)->SlotState[Slot] = State;
+}
+
+static IUSB_RING *
+GetRing(uint8 DeviceType, uint8 Instance)
+{
+	switch (DeviceType & 0x7F)
+	{
+		case IUSB_DEVICE_CDROM:
+			if (Instance < MAX_CD_INSTANCES)
+				return &CdRing[Instance];
+			break;
+		case IUSB_DEVICE_HARDDISK:
+			if (Instance < MAX_HD_INSTANCES + MAX_SD_INSTANCES)
+				return &HdRing[Instance];
+			break;
+	}
+	return NULL;
+}
+
+/* Called with RingLock held */
+static void
+DropQueued(IUSB_RING *Ring)
+{
+	int Slot;
+	int Count = 0;
+
+	for (Slot = 0; Slot < IUSB_RING_SLOTS; Slot++)
+	{
+		if (Ring->SlotState[Slot] != IUSB_SLOT_QUEUED)
+			continue;
+		SetSlotState(Ring, Slot, IUSB_SLOT_FREE);
+		Count++;
+	}
+	if (Count == 0)
+		return;
+
+	Ring->Freed = 1;
+	if (Ring->MassData->Stats.QueueDepth > Count)
+		Ring->MassData->Stats.QueueDepth -= Count;
+	else
+		Ring->MassData->Stats.QueueDepth = 0;
+	Ring->MassData->Stats.QueueDrops += Count;
+}
+
+int
+iUsbRingMmap(uint8 DeviceType, uint8 Instance, struct vm_area_struct *vma)
+{
+	IUSB_RING *Ring;
+	IUSB_RING_HEADER *Hdr;
+
+	Ring = GetRing(DeviceType, Instance);
+	if (Ring == NULL)
+		return -EINVAL;
+
+	/* Allocated on first use and kept until the module goes away */
+	mutex_lock(&RingAllocLock);
+	if (Ring->Area == NULL)
+	{
+		Hdr = (IUSB_RING_HEADER *)vmalloc_user(IUSB_RING_SIZE);
+		if (Hdr == NULL)
+		{
+			mutex_unlock(&RingAllocLock);
+			TWARN ("iUsbRingMmap(): Unable to allocate the ring for Instance %d\n", Instance);
+			return -ENOMEM;
+		}
+		Hdr->NumSlots	= IUSB_RING_SLOTS;
+		Hdr->SlotSize	= IUSB_RING_SLOT_SIZE;
+		Hdr->SlotOffset	= PAGE_SIZE;
+		Hdr->Magic		= IUSB_RING_MAGIC;
+		Ring->Area = (uint8 *)Hdr;
+	}
+	mutex_unlock(&RingAllocLock);
+
+	/* The page offset only selected the ring, which is mapped from its start */
+	return remap_vmalloc_range(vma, Ring->Area, 0);
+}
+
+IUSB_SCSI_PACKET *
+iUsbRingGetSlot(uint8 DeviceType, uint8 Instance, uint8 Slot)
+{
+	IUSB_RING *Ring;
+	IUSB_SCSI_PACKET *Pkt = NULL;
+
+	Ring = GetRing(DeviceType, Instance);
+	if ((Ring == NULL) || (Ring->Area == NULL) || (Slot >= IUSB_RING_SLOTS))
+		return NULL;
+
+	spin_lock(&RingLock);
+	if (Ring->SlotState[Slot] == IUSB_SLOT_FREE)
+	{
+		SetSlotState(Ring, Slot, IUSB_SLOT_BUSY);
+		Pkt = RING_SLOT(Ring, Slot);
+	}
+	spin_unlock(&RingLock);
+	return Pkt;
+}
+
+void
+iUsbRingPutSlot(uint8 DeviceType, uint8 Instance, uint8 Slot)
+{
+	IUSB_RING *Ring;
+
+	Ring = GetRing(DeviceType, Instance);
+	if ((Ring == NULL) || (Ring->Area == NULL) || (Slot >= IUSB_RING_SLOTS))
+		return;
+
+	spin_lock(&RingLock);
+	if (Ring->SlotState[Slot] == IUSB_SLOT_BUSY)
+		SetSlotState(Ring, Slot, IUSB_SLOT_FREE);
+	spin_unlock(&RingLock);
+}
+
+int
+iUsbRingQueueSlot(uint8 DeviceType, uint8 Instance, uint8 Slot)
+{
+	IUSB_RING *Ring;
+	IUSB_SCSI_PACKET *Pkt;
+	BOT_STATS *Stats;
+	uint8 Cdb[10];
+	uint32 Len;
+	int RetVal = 0;
+
+	Ring = GetRing(DeviceType, Instance);
+	if ((Ring == NULL) || (Ring->Area == NULL) || (Slot >= IUSB_RING_SLOTS))
+		return -EINVAL;
+
+	/* Take what will be matched against the host's READ(10) out of the shared slot once */
+	Pkt = RING_SLOT(Ring, Slot);
+	memcpy(Cdb, &(Pkt->CommandPkt), sizeof(Cdb));
+	Len = usb_long(Pkt->DataLen);
+	if ((Cdb[0] != SCSI_READ_10) || (Pkt->StatusPkt.OverallStatus != 0) ||
+		(Len == 0) || (Len > MAX_SCSI_DATA))
+	{
+		TDBG_FLAGGED(iusb, DEBUG_IUSB_SCSI,
+			"iUsbRingQueueSlot(): Slot %d of Instance %d is not a READ(10) response\n", Slot, Instance);
+		return -EINVAL;
+	}
+
+	spin_lock(&RingLock);
+	if ((Ring->SlotState[Slot] != IUSB_SLOT_FREE) || (Ring->MassData == NULL))
+		RetVal = -EBUSY;
+	else
+	{
+		memcpy(Ring->QueuedCdb[Slot], Cdb, sizeof(Cdb));
+		Ring->QueuedLen[Slot] = Len;
+		SetSlotState(Ring, Slot, IUSB_SLOT_QUEUED);
+		Stats = &Ring->MassData->Stats;
+		Stats->QueueDepth++;
+		if (Stats->QueueDepth > Stats->MaxQueueDepth)
+			Stats->MaxQueueDepth = Stats->QueueDepth;
+	}
+	spin_unlock(&RingLock);
+	return RetVal;
+}
+
+/*
+ * Answers the host's READ(10) from a queued read-ahead slot. Returns 0 if the command
+ * has been completed (CSW sent), 1 if it has to go to the media server as usual.
+ */
+int
+iUsbRingServeRead(uint8 DevNo, uint8 ifnum, BOT_IF_DATA *MassData, uint8 DeviceType, uint8 Instance)
+{
+	IUSB_RING *Ring;
+	COMMAND_BLOCK_WRAPPER *cbw;
+	uint8 *Cdb;
+	uint32 TransferLen;
+	uint32 RemainLen;
+	int Slot = -1;
+	int i;
+	int SendVal = 0;
+
+	Ring = GetRing(DeviceType, Instance);
+	if ((Ring == NULL) || (Ring->Area == NULL))
+		return 1;
+
+	cbw	= (COMMAND_BLOCK_WRAPPER *)(&(MassData->CBW[0]));
+	Cdb = (uint8 *)(&(cbw->CBWCB));
+	TransferLen = usb_long(cbw->dCBWDataTransferLength);
+
+	spin_lock(&RingLock);
+	Ring->MassData = MassData;
+	if ((Cdb[0] == SCSI_READ_10) && (cbw->bmCBWFlags & 0x80))
+	{
+		/* Same LBA and block count, byte 1 only carries caching hints */
+		for (i = 0; i < IUSB_RING_SLOTS; i++)
+		{
+			if ((Ring->SlotState[i] == IUSB_SLOT_QUEUED) &&
+				(Ring->QueuedLen[i] == TransferLen) &&
+				(memcmp(&Ring->QueuedCdb[i][2], &Cdb[2], 4) == 0) &&
+				(Ring->QueuedCdb[i][7] == Cdb[7]) && (Ring->QueuedCdb[i][8] == Cdb[8]))
+			{
+				Slot = i;
+				SetSlotState(Ring, Slot, IUSB_SLOT_BUSY);
+				if (MassData->Stats.QueueDepth)
+					MassData->Stats.QueueDepth--;
+				break;
+			}
+		}
+	}
+	/* The host read elsewhere or writes to the medium, what was read ahead is stale */
+	if ((Slot < 0) && ((Cdb[0] == SCSI_READ_10) || (Cdb[0] == SCSI_READ_12) ||
+		(!(cbw->bmCBWFlags & 0x80) && TransferLen)))
+		DropQueued(Ring);
+	spin_unlock(&RingLock);
+
+	if (Slot < 0)
+		return 1;
+
+	TDBG_FLAGGED(iusb, DEBUG_IUSB_SCSI,"iUsbRingServeRead(): Slot %d answers READ(10) for Instance %d\n",
+					Slot, Instance);
+
+	UsbCore.CoreUsbBotSetScsiErrorCode (DevNo,ifnum,0,0,0);
+	if (g_video_callback.CallBackHandler != NULL)
+		g_video_callback.CallBackHandler (1);
+
+	RemainLen = TransferLen;
+	if (UsbCore.CoreUsbBotSendData(DevNo,ifnum,(uint8 *)&(RING_SLOT(Ring, Slot)->Data),
+							TransferLen,&RemainLen) == 1)
+	{
+		TCRIT("Error in Sending Read-ahead Data for Instance %d\n", Instance);
+		SendVal = 1;
+	}
+	UsbCore.CoreUsbBotSendCSW(DevNo,ifnum,cbw->dCBWTag,CSW_PASSED,RemainLen);
+
+	if (g_video_callback.CallBackHandler != NULL)
+		g_video_callback.CallBackHandler (0);
+
+	spin_lock(&RingLock);
+	SetSlotState(Ring, Slot, IUSB_SLOT_FREE);
+	Ring->Freed = 1;
+	if (!SendVal)
+		MassData->Stats.QueueHits++;
+	spin_unlock(&RingLock);
+
+	/* Let the server refill the slot while the host processes this data */
+	if ((DeviceType & 0x7F) == IUSB_DEVICE_CDROM)
+		CdromRingNotify(Instance);
+	else
+		HdiskRingNotify(Instance);
+	return 0;
+}
+
+void
+iUsbRingDrop(uint8 DeviceType, uint8 Instance)
+{
+	IUSB_RING *Ring;
+
+	Ring = GetRing(DeviceType, Instance);
+	if ((Ring == NULL) || (Ring->Area == NULL))
+		return;
+
+	spin_lock(&RingLock);
+	DropQueued(Ring);
+	spin_unlock(&RingLock);
+}
+
+int
+iUsbRingFreed(uint8 DeviceType, uint8 Instance)
+{
+	IUSB_RING *Ring;
+
+	Ring = GetRing(DeviceType, Instance);
+	return (Ring != NULL) && Ring->Freed;
+}
+
+int
+iUsbRingClearFreed(uint8 DeviceType, uint8 Instance)
+{
+	IUSB_RING *Ring;
+	int Freed;
+
+	Ring = GetRing(DeviceType, Instance);
+	if (Ring == NULL)
+		return 0;
+
+	spin_lock(&RingLock);
+	Freed = Ring->Freed;
+	Ring->Freed = 0;
+	spin_unlock(&RingLock);
+	return Freed;
+}
+
+void
+iUsbRingExit(void)
+{
+	int Instance;
+
+	for (Instance = 0; Instance < MAX_CD_INSTANCES; Instance++)
+	{
+		vfree(CdRing[Instance].Area);
+		CdRing[Instance].Area = NULL;
+	}
+	for (Instance = 0; Instance < MAX_HD_INSTANCES + MAX_SD_INSTANCES; Instance++)
+	{
+		vfree(HdRing[Instance].Area);
+		HdRing[Instance].Area = NULL;
+	}
+}
+
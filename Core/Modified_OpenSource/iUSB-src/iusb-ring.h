@@ -0,0 +1,37 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+#ifndef _IUSB_RING_H_
+#define _IUSB_RING_H_
+
+#include <linux/mm.h>
+#include <coreTypes.h>
+#include "bot.h"
+#include "iusb.h"
+
+/* A slot holds one IUSB_SCSI_PACKET with up to MAX_SCSI_DATA, the header takes the first page */
+#define IUSB_RING_SLOT_SIZE		PAGE_ALIGN(sizeof(IUSB_SCSI_PACKET) + MAX_SCSI_DATA)
+#define IUSB_RING_SIZE			(PAGE_SIZE + IUSB_RING_SLOTS * IUSB_RING_SLOT_SIZE)
+
+extern int iUsbRingMmap(uint8 DeviceType, uint8 Instance, struct vm_area_struct *vma);
+extern IUSB_SCSI_PACKET *iUsbRingGetSlot(uint8 DeviceType, uint8 Instance, uint8 Slot);
+extern void iUsbRingPutSlot(uint8 DeviceType, uint8 Instance, uint8 Slot);
+extern int iUsbRingQueueSlot(uint8 DeviceType, uint8 Instance, uint8 Slot);
+extern int iUsbRingServeRead(uint8 DevNo, uint8 ifnum, BOT_IF_DATA *MassData, uint8 DeviceType, uint8 Instance);
+extern void iUsbRingDrop(uint8 DeviceType, uint8 Instance);
+extern int iUsbRingFreed(uint8 DeviceType, uint8 Instance);
+extern int iUsbRingClearFreed(uint8 DeviceType, uint8 Instance);
+extern void iUsbRingExit(void);
+
+#endif /* _IUSB_RING_H_ */
+
@@ -29,6 +29,7 @@
 #include "iusb-hdisk.h"
 #include "iusb-vendor.h"
 #include "iusb-hid.h"
+#include "iusb-ring.h"
 #include "mod_reg.h"
 
 
@@ -62,6 +63,7 @@ TDBG_DECLARE_DBGVAR(iusb);
 static int 	iusb_notify_sys(struct notifier_block *this, unsigned long code, void *unused);
 static int RemoteScsiCall(uint8 DevNo, uint8 ifnum, BOT_IF_DATA *MassData, uint8 LunNo, uint8 Instance);
 static int ScsiSendResponse(IUSB_SCSI_PACKET *UserModePkt);
+static int ScsiSendSlotResponse(uint8 DeviceType, uint8 Instance, uint8 Slot);
 
 /* Static Variables */
 static struct notifier_block iusb_notifier =
@@ -102,6 +104,9 @@ static USB_IUSB iUSB = {
 				.iUSBGetCdromInstanceIndex  = GetCdromInstanceIndex,
 				.iUSBReleaseHdiskInstanceIndex = ReleaseHdiskInstanceIndex,
 				.iUSBReleaseCdromInstanceIndex = ReleaseCdromInstanceIndex,
+				.iUSBScsiSlotResponse		= ScsiSendSlotResponse,
+				.iUSBScsiQueueSlot			= iUsbRingQueueSlot,
+				.iUSBScsiRingMmap			= iUsbRingMmap,
 				
 				};
 
@@ -313,41 +318,14 @@ DumpData(char *Title, uint8 ep, uint8 *Data, uint32 Len)
  * which may cause USB errors. Another way is keep seperate buffers for each BOT 
  * device or a pool of buffers for all BOT devices
  */
-int
-ScsiSendResponse(IUSB_SCSI_PACKET *UserModePkt)
+static int
+SendScsiResponse(IUSB_SCSI_PACKET *Pkt, uint8 *DataPkt, uint32 SendSize)
 {
 	uint8 OverallStatus; 
-	uint8 *DataPkt;
-	uint32 SendSize;
 	uint32 RemainLen;
 	int RetVal;
-	int err;
 	int SendVal=0;
 	BOT_IF_DATA *MassData;
-	
-	IUSB_SCSI_PACKET *Pkt;
-	
-	TDBG_FLAGGED(iusb, DEBUG_IUSB_SCSI,"ScsiSendResponse: Entering\n");
-	
-	/* Copy from user data area to kernel data area*/
-	if((UserModePkt->Header.DeviceType & 0x7F) ==   IUSB_DEVICE_CDROM)
-	{
-		
-		Pkt = (IUSB_SCSI_PACKET*) &gKernelModePktCD[0];
-	}
-	else
-	{
-		
-		Pkt = (IUSB_SCSI_PACKET*)&gKernelModePktHD[0];
-	}
-	
-	err=__copy_from_user((void *)(Pkt),(void *)UserModePkt,sizeof(IUSB_SCSI_PACKET));
-	if(err != 0)
-		TWARN("Copy data from user error\n");
-	SendSize		= usb_long(Pkt->DataLen);
-	err=__copy_from_user((void *)(&(Pkt->Data)),(void *)&(UserModePkt->Data),SendSize);
-	if(err != 0)
-		TWARN("Copy data from user error\n");
 
 /*	MaintainMediaInserted(Pkt);*/
 	MassData =(BOT_IF_DATA *)UsbCore.CoreUsbGetInterfaceData(Pkt->Header.DeviceNo,
@@ -416,9 +394,6 @@ ScsiSendResponse(IUSB_SCSI_PACKET *UserModePkt)
 
 	/* At this point, we know some Data might have been Received from Remote */
 	
-	/* Get Data Size and Buffer to be Sent to Host*/
-	SendSize		= usb_long(Pkt->DataLen);
-	DataPkt			= &(Pkt->Data); 
 	RemainLen		= usb_long(Pkt->ReadLen);  
 
 	/* Send the SCSI response packet, if any */
@@ -434,7 +409,7 @@ ScsiSendResponse(IUSB_SCSI_PACKET *UserModePkt)
 		}
 		/* Send the Packet */		
 		if (UsbCore.CoreUsbBotSendData(Pkt->Header.DeviceNo,Pkt->Header.InterfaceNo,
-								(uint8 *)&Pkt->Data,SendSize,&RemainLen) == 1)
+								DataPkt,SendSize,&RemainLen) == 1)
 		{
 			TCRIT("Error in Sending Data for 0x%x\n",Pkt->CommandPkt.OpCode);
 			SendVal = 1;  /* return 1; */
@@ -470,9 +445,81 @@ ScsiSendResponse(IUSB_SCSI_PACKET *UserModePkt)
 		if (g_video_callback.CallBackHandler != NULL)
 			g_video_callback.CallBackHandler (0);
 	}
+	return (RetVal|SendVal);	/* Return Combined Error Status */
+}
+
+int
+ScsiSendResponse(IUSB_SCSI_PACKET *UserModePkt)
+{
+	uint32 SendSize;
+	int RetVal;
+	int err;
+	IUSB_SCSI_PACKET *Pkt;
+	
+	TDBG_FLAGGED(iusb, DEBUG_IUSB_SCSI,"ScsiSendResponse: Entering\n");
+	
+	/* Copy from user data area to kernel data area*/
+	if((UserModePkt->Header.DeviceType & 0x7F) ==   IUSB_DEVICE_CDROM)
+	{
+		
+		Pkt = (IUSB_SCSI_PACKET*) &gKernelModePktCD[0];
+	}
+	else
+	{
+		
+		Pkt = (IUSB_SCSI_PACKET*)&gKernelModePktHD[0];
+	}
+	
+	err=__copy_from_user((void *)(Pkt),(void *)UserModePkt,sizeof(IUSB_SCSI_PACKET));
+	if(err != 0)
+		TWARN("Copy data from user error\n");
+	SendSize		= usb_long(Pkt->DataLen);
+	if (SendSize > MAX_SCSI_DATA)
+	{
+		TWARN("ScsiSendResponse(): Response of %d bytes is larger than %d\n", SendSize, MAX_SCSI_DATA);
+		return 1;
+	}
+	err=__copy_from_user((void *)(&(Pkt->Data)),(void *)&(UserModePkt->Data),SendSize);
+	if(err != 0)
+		TWARN("Copy data from user error\n");
+
+	RetVal = SendScsiResponse(Pkt, &(Pkt->Data), SendSize);
 	TDBG_FLAGGED(iusb, DEBUG_IUSB_SCSI,"ScsiSendResponse: Leaving \n");
+	return RetVal;
+}
 
-	return (RetVal|SendVal);	/* Return Combined Error Status */
+/* As ScsiSendResponse(), for a response the server built in a slot of the mmap'd ring */
+static int
+ScsiSendSlotResponse(uint8 DeviceType, uint8 Instance, uint8 Slot)
+{
+	uint32 SendSize;
+	int RetVal;
+	IUSB_SCSI_PACKET *SlotPkt;
+	IUSB_SCSI_PACKET Pkt;
+
+	SlotPkt = iUsbRingGetSlot(DeviceType, Instance, Slot);
+	if (SlotPkt == NULL)
+	{
+		TWARN("ScsiSendSlotResponse(): Slot %d of Instance %d is not available\n", Slot, Instance);
+		return -EINVAL;
+	}
+
+	/*
+	 * The server can still write the slot, so the packet header is taken once and
+	 * only that copy is used. Just the data is sent to the host straight from the slot.
+	 */
+	memcpy(&Pkt, SlotPkt, sizeof(IUSB_SCSI_PACKET));
+	SendSize		= usb_long(Pkt.DataLen);
+	if (SendSize > MAX_SCSI_DATA)
+	{
+		TWARN("ScsiSendSlotResponse(): Response of %d bytes is larger than %d\n", SendSize, MAX_SCSI_DATA);
+		RetVal = -EINVAL;
+	}
+	else
+		RetVal = SendScsiResponse(&Pkt, &(SlotPkt->Data), SendSize);
+
+	iUsbRingPutSlot(DeviceType, Instance, Slot);
+	return RetVal;
 }
 
 static int  		
@@ -509,6 +556,10 @@ RemoteScsiCall(uint8 DevNo, uint8 ifnum, BOT_IF_DATA *MassData, uint8 LunNo, uin
 			return ProcessVendorCommands(DevNo,ifnum,MassData,ScsiPkt->Lun);
 		}
 
+		/* Answered from the read-ahead queue without a round trip to the server */
+		if (!iUsbRingServeRead(DevNo,ifnum,MassData,IUSB_DEVICE_CDROM,Instance))
+			return 0;
+
 		/**Non AMI Commands**/
 		/* Get the iUsbScsi Packet Memory */
 		iUsbScsi = CdromGetiUsbPacket(DevNo,ifnum, Instance);
@@ -534,6 +585,10 @@ RemoteScsiCall(uint8 DevNo, uint8 ifnum, BOT_IF_DATA *MassData, uint8 LunNo, uin
 		if (!HdiskCheckSupportedCmd(DevNo,ifnum,ScsiPkt->OpCode,MassData, Instance))
 			return 1;
 
+		/* Answered from the read-ahead queue without a round trip to the server */
+		if (!iUsbRingServeRead(DevNo,ifnum,MassData,IUSB_DEVICE_HARDDISK,Instance))
+			return 0;
+
 		/* Get the iUsbScsi Packet Memory */
 		iUsbScsi = HdiskGetiUsbPacket(DevNo,ifnum, Instance);
 		if (iUsbScsi == NULL)
@@ -594,6 +649,7 @@ exit_iusb_module (void)
 	printk ("Unloading iUSB module...\n");
 	unregister_reboot_notifier (&iusb_notifier);
 	if (my_sys) RemoveSysctlTable(my_sys);
+	iUsbRingExit();
 	return;
 }
 
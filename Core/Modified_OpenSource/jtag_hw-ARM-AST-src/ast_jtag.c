@@ -15,9 +15,12 @@
  * JTAG hardware driver is implemented in software mode instead of hardware mode.
  * Driver controlls TCK, TMS, and TDIO by software directly when software mode is enable.
  * The CLK is 12KHz.
+ * With HWShiftMode=1 SIR and SDR are shifted by the engine 32 bits at a time,
+ * reset, Run-Test/Idle and Pause-DR stay in software mode.
  */
 
 #include <linux/module.h>
+#include <linux/moduleparam.h>
 #include <linux/pci.h>
 #include <linux/fs.h>
 #include <asm/io.h>
@@ -43,6 +46,10 @@ static jtag_core_funcs_t *jtag_core_ops;
 
 int g_is_Support_LoopFunc=0;
 
+static int HWShiftMode = 0;
+module_param (HWShiftMode, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC (HWShiftMode, "Shift SIR/SDR with the JTAG engine instead of software mode");
+
 // jtag pin set for ALTERA
 #define TDI_PIN 0 
 #define TDO_PIN	1 
@@ -121,10 +128,10 @@ int jtag_io(int pin, int act){
 }
 
 /*
- * jtag_sir
+ * ast_jtag_sw_sir
  * Send Jtag instruction
  */
-void jtag_sir(unsigned short bits, unsigned int tdi){
+static void ast_jtag_sw_sir(unsigned short bits, unsigned int tdi){
 	
 	int i = 0;
 	//uint32_t tdo;
@@ -198,15 +205,16 @@ void jtag_sir(unsigned short bits, unsigned int tdi){
 
 
 /*
- * jtag_sdr
- * Read data back and send instruction
+ * ast_jtag_sw_sdr
+ * Shift TDI out and read TDO back, zeros are shifted when tdi is NULL
  * Note: Connect a GPIO(G5) to replace TDO, and read it to get data back from device. A workaround for AST2300/AST1050.
  */
-void jtag_sdr(unsigned short bits, unsigned int *TDI,unsigned int *TDO){
+static void ast_jtag_sw_sdr(unsigned int bits, const unsigned int *tdi, unsigned int *tdo){
 	
 	unsigned int index = 0;
 	u32 shift_bits =0;
 	u32 dr_data;
+	u32 tms;
 
 	//go to DR Scan
 	iowrite32(SOFTWARE_MODE_ENABLE | SOFTWARE_TMS_BIT | SOFTWARE_TDIO_BIT, (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
@@ -226,56 +234,28 @@ void jtag_sdr(unsigned short bits, unsigned int *TDI,unsigned int *TDO){
 	bit_delay();
 	
 	while (bits) {
-		if( !(TDO) ) {
-			//Write
-			dr_data = (TDI[index] >> (shift_bits % 32)) & (0x1);
-			if(bits == 1) {
-				// go to Exit1DR
-				iowrite32(SOFTWARE_MODE_ENABLE | SOFTWARE_TMS_BIT | (dr_data << 16), (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
-				bit_delay();
-				iowrite32(SOFTWARE_MODE_ENABLE | SOFTWARE_TCK_BIT | SOFTWARE_TMS_BIT | (dr_data << 16), (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
-				bit_delay();
-			}
-			else {
-				iowrite32(SOFTWARE_MODE_ENABLE | (dr_data << 16), (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
-				bit_delay();
-				iowrite32(SOFTWARE_MODE_ENABLE | SOFTWARE_TCK_BIT | (dr_data << 16), (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
-				bit_delay();
-			}
-		}
-		else {
-			//Read
-			if(bits == 1) {
-				// go to Exit1DR
-				iowrite32(SOFTWARE_MODE_ENABLE | SOFTWARE_TMS_BIT, (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
-				bit_delay();
-				iowrite32(SOFTWARE_MODE_ENABLE | SOFTWARE_TCK_BIT | SOFTWARE_TMS_BIT, (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
-				bit_delay();
-			}
-			else {
-				iowrite32(SOFTWARE_MODE_ENABLE, (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
-				bit_delay();
-				iowrite32(SOFTWARE_MODE_ENABLE | SOFTWARE_TCK_BIT, (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
-				bit_delay();
-			}
-			#ifdef SOC_AST2300
-			 if(ioread32((void * __iomem)ast_gpio_v_add + GPIO_DATA_VALUE) & GPIO_G5_BIT) {
-			#else
-			 if(ioread32((void * __iomem)ast_jtag_v_add + JTAG_STATUS) & SOFTWARE_TDIO_BIT) {
-			#endif
-				dr_data = 1;
-				TDO[index] |= (0x1 << (shift_bits % 32));
-			}
-			else {
-				dr_data = 0;
-				TDO[index] &= ~(0x1 << (shift_bits % 32));
-			}
+		dr_data = tdi ? (tdi[index] >> (shift_bits % 32)) & (0x1) : 0;
+		// the last bit goes to Exit1DR
+		tms = (bits == 1) ? SOFTWARE_TMS_BIT : 0;
+		iowrite32(SOFTWARE_MODE_ENABLE | tms | (dr_data << 16), (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
+		bit_delay();
+		iowrite32(SOFTWARE_MODE_ENABLE | SOFTWARE_TCK_BIT | tms | (dr_data << 16), (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
+		bit_delay();
+		if (tdo) {
+			if (ast_tdo_pin())
+				tdo[index] |= (0x1U << (shift_bits % 32));
+			else
+				tdo[index] &= ~(0x1U << (shift_bits % 32));
 		}
 		shift_bits++;
 		bits--;
 		if((shift_bits % 32) == 0)
 			index ++;
 	}
+	// no stale bits above the scan length in the last TDO word
+	if (tdo && (shift_bits % 32) != 0)
+		tdo[index] &= (0x1U << (shift_bits % 32)) - 1;
+
 	// go to UpdateDR
 	iowrite32(SOFTWARE_MODE_ENABLE | SOFTWARE_TMS_BIT | SOFTWARE_TDIO_BIT, (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
 	bit_delay();
@@ -292,6 +272,128 @@ void jtag_sdr(unsigned short bits, unsigned int *TDI,unsigned int *TDO){
 }
 
 
+#ifndef SOC_AST2300
+/*
+ * ast_jtag_hw_wait
+ * Poll the engine for a pause/complete event, the interrupts stay disabled
+ */
+static int ast_jtag_hw_wait(u32 event){
+	u32 status;
+	int i;
+
+	for (i = 0; i < AST_JTAG_HW_TIMEOUT_US; i++) {
+		status = ioread32((void * __iomem)ast_jtag_v_add + JTAG_INTERRUPT);
+		if (status & event) {
+			// status bits are write 1 to clear
+			iowrite32((status & AST_JTAG_INTR_ENABLE_MASK) | event, (void * __iomem)ast_jtag_v_add + JTAG_INTERRUPT);
+			return 0;
+		}
+		udelay(1);
+	}
+	printk(KERN_WARNING "%s: engine timeout, status %08x\n", AST_JTAG_DRIVER_NAME, status);
+	iowrite32(AST_JTAG_CTRL_ENABLE, (void * __iomem)ast_jtag_v_add + JTAG_CONTROL);
+	ast_jtag_reset();
+	return -ETIMEDOUT;
+}
+
+/*
+ * ast_jtag_hw_sir
+ * Shift the instruction with the engine, from Run-Test/Idle back to Run-Test/Idle
+ */
+static int ast_jtag_hw_sir(unsigned short bits, unsigned int tdi){
+	u32 ctrl = AST_JTAG_CTRL_ENABLE | AST_JTAG_CTRL_INST_LAST_TRANS | (bits << AST_JTAG_CTRL_INST_LEN_OFFSET);
+	int ret;
+
+	// leave software mode, the engine drives the pins
+	iowrite32(0, (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
+	iowrite32(tdi, (void * __iomem)ast_jtag_v_add + JTAG_INSTRUCTION);
+	iowrite32(ctrl, (void * __iomem)ast_jtag_v_add + JTAG_CONTROL);
+	iowrite32(ctrl | AST_JTAG_CTRL_INST_ENABLE, (void * __iomem)ast_jtag_v_add + JTAG_CONTROL);
+	ret = ast_jtag_hw_wait(AST_JTAG_INTR_INST_COMPLETE);
+	iowrite32(AST_JTAG_CTRL_ENABLE, (void * __iomem)ast_jtag_v_add + JTAG_CONTROL);
+	return ret;
+}
+
+/*
+ * ast_jtag_hw_sdr
+ * Shift the data 32 bits at a time, the engine waits in Pause-DR between the words.
+ * The TDO bits come in from the top of the data register.
+ */
+static int ast_jtag_hw_sdr(unsigned int bits, const unsigned int *tdi, unsigned int *tdo){
+	unsigned int index = 0;
+	unsigned int len;
+	u32 ctrl, data;
+	int ret = 0;
+
+	iowrite32(0, (void * __iomem)ast_jtag_v_add + JTAG_STATUS);
+	while (bits) {
+		len = (bits > AST_JTAG_CTRL_MAX_DATA_LENGTH) ? AST_JTAG_CTRL_MAX_DATA_LENGTH : bits;
+		ctrl = AST_JTAG_CTRL_ENABLE | (len << AST_JTAG_CTRL_DATA_LEN_OFFSET);
+		if (len == bits)
+			ctrl |= AST_JTAG_CTRL_DATA_LAST_TRANS;
+
+		iowrite32(tdi ? tdi[index] : 0, (void * __iomem)ast_jtag_v_add + JTAG_DATA);
+		iowrite32(ctrl, (void * __iomem)ast_jtag_v_add + JTAG_CONTROL);
+		iowrite32(ctrl | AST_JTAG_CTRL_DATA_ENABLE, (void * __iomem)ast_jtag_v_add + JTAG_CONTROL);
+		ret = ast_jtag_hw_wait((len == bits) ? AST_JTAG_INTR_DATA_COMPLETE : AST_JTAG_INTR_DATA_PAUSE);
+		if (ret != 0)
+			break;
+
+		if (tdo) {
+			data = ioread32((void * __iomem)ast_jtag_v_add + JTAG_DATA);
+			tdo[index] = (len < 32) ? (data >> (32 - len)) : data;
+		}
+		bits -= len;
+		index++;
+	}
+	iowrite32(AST_JTAG_CTRL_ENABLE, (void * __iomem)ast_jtag_v_add + JTAG_CONTROL);
+	return ret;
+}
+#endif
+
+
+/*
+ * ast_jtag_xfer_ir / ast_jtag_xfer_dr
+ * Scan in the selected mode, the TAP starts and ends in Run-Test/Idle
+ */
+static int ast_jtag_xfer_ir(unsigned short bits, unsigned int tdi){
+	#ifndef SOC_AST2300
+	if (HWShiftMode)
+		return ast_jtag_hw_sir(bits, tdi);
+	#endif
+	ast_jtag_sw_sir(bits, tdi);
+	return 0;
+}
+
+static int ast_jtag_xfer_dr(unsigned int bits, const unsigned int *tdi, unsigned int *tdo){
+	#ifndef SOC_AST2300
+	if (HWShiftMode)
+		return ast_jtag_hw_sdr(bits, tdi, tdo);
+	#endif
+	ast_jtag_sw_sdr(bits, tdi, tdo);
+	return 0;
+}
+
+
+/*
+ * jtag_sir
+ * Send Jtag instruction
+ */
+void jtag_sir(unsigned short bits, unsigned int tdi){
+	ast_jtag_xfer_ir(bits, tdi);
+}
+
+
+/*
+ * jtag_sdr
+ * Read data back and send instruction
+ * When TDO is given zeros are shifted, callers pass a single TDI word for long reads
+ */
+void jtag_sdr(unsigned short bits, unsigned int *TDI,unsigned int *TDO){
+	ast_jtag_xfer_dr(bits, TDO ? NULL : TDI, TDO);
+}
+
+
 /*
  * ast_jtag_reset
  * Generate at least 9 TMS high and 1 TMS low to force devices into Run-Test/Idle State
@@ -399,6 +501,92 @@ void jtag_runtest_idle(unsigned int tcks, unsigned int min_mSec)
 }
 
 
+/*
+ * jtag_run_vectors
+ * Run a jtag_vector_t list in one call, see ast_jtag.h for the layout.
+ * Stops at the first error, a POLL that runs out of attempts returns -ETIMEDOUT.
+ */
+int jtag_run_vectors(void *list, unsigned long size)
+{
+	unsigned char *pos = (unsigned char *)list;
+	unsigned char *end = pos + size;
+	jtag_vector_t *vec;
+	unsigned int *data;
+	unsigned int words, tries, n = 0;
+	u32 tdi;
+	int ret = 0;
+
+	while (pos < end) {
+		if ((unsigned long)(end - pos) < sizeof(jtag_vector_t))
+			return -EINVAL;
+		vec = (jtag_vector_t *)pos;
+		data = (unsigned int *)(vec + 1);
+
+		switch (vec->op) {
+			case JTAG_VEC_SIR:
+			case JTAG_VEC_POLL:
+				if (vec->bits == 0 || vec->bits > 32)
+					return -EINVAL;
+				//fallthrough
+			case JTAG_VEC_SDR:
+			case JTAG_VEC_SDR_TDO:
+				words = (vec->bits + 31) / 32;
+				break;
+			default:
+				words = 0;
+				break;
+		}
+		if ((unsigned long)(end - (unsigned char *)data) < words * sizeof(unsigned int))
+			return -EINVAL;
+
+		switch (vec->op) {
+			case JTAG_VEC_RESET:
+				ast_jtag_reset();
+				break;
+			case JTAG_VEC_SIR:
+				ret = ast_jtag_xfer_ir(vec->bits, data[0]);
+				break;
+			case JTAG_VEC_SDR:
+				ret = ast_jtag_xfer_dr(vec->bits, data, NULL);
+				break;
+			case JTAG_VEC_SDR_TDO:
+				ret = ast_jtag_xfer_dr(vec->bits, data, data);
+				break;
+			case JTAG_VEC_RUNTEST:
+				jtag_runtest_idle(vec->tcks, vec->msec);
+				break;
+			case JTAG_VEC_DR_PAUSE:
+				jtag_dr_pause(vec->msec);
+				break;
+			case JTAG_VEC_POLL:
+				tdi = data[0];
+				for (tries = 0; tries < vec->count; ) {
+					jtag_runtest_idle(vec->tcks, vec->msec);
+					data[0] = tdi;
+					ret = ast_jtag_xfer_dr(vec->bits, data, data);
+					tries++;
+					if (ret != 0 || (data[0] & vec->mask) == vec->value)
+						break;
+				}
+				if (ret == 0 && (tries == 0 || (data[0] & vec->mask) != vec->value))
+					ret = -ETIMEDOUT;
+				vec->count = tries;
+				break;
+			default:
+				ret = -EINVAL;
+				break;
+		}
+		if (ret != 0) {
+			printk(KERN_WARNING "%s: vector %u (op %u) failed %d\n", AST_JTAG_DRIVER_NAME, n, vec->op, ret);
+			return ret;
+		}
+		pos = (unsigned char *)(data + words);
+		n++;
+	}
+	return 0;
+}
+
+
 /* -------------------------------------------------- */
 static jtag_hal_operations_t ast_jtag_hw_ops = {
 	.reset_jtag = ast_jtag_reset,
@@ -436,6 +624,11 @@ int ast_jtag_init(void)
 	}
 	
 	#ifdef SOC_AST2300
+	if (HWShiftMode) {
+		// TDO comes from a GPIO, the engine can not read it
+		printk(KERN_WARNING "%s: HWShiftMode not supported, using software mode\n", AST_JTAG_DRIVER_NAME);
+		HWShiftMode = 0;
+	}
 	ast_gpio_v_add = ioremap_nocache(AST_GPIO_REG_BASE, 0x40);
 	if (!ast_gpio_v_add) {
 		printk(KERN_WARNING "%s: AST_GPIO_REG_BASE ioremap failed\n", AST_JTAG_DRIVER_NAME);
@@ -500,6 +693,7 @@ EXPORT_SYMBOL(jtag_sir);
 EXPORT_SYMBOL(jtag_runtest_idle);
 EXPORT_SYMBOL(jtag_dr_pause);
 EXPORT_SYMBOL(jtag_io);
+EXPORT_SYMBOL(jtag_run_vectors);
 
 module_init (ast_jtag_init);
 module_exit (ast_jtag_exit);
@@ -87,6 +87,39 @@
 #define SOFTWARE_TDIO_BIT       0x00010000
 
 
+// Hardware mode wait for the engine, in microseconds
+#define AST_JTAG_HW_TIMEOUT_US	10000
+
+/* -------------------------------------------------- */
+/*
+ * Vector list of IOCTL_JTAG_RUN_VECTORS, run by jtag_run_vectors().
+ * Every vector starts and ends in Run-Test/Idle. SIR, SDR, SDR_TDO and POLL
+ * vectors are followed by (bits + 31) / 32 data words, bit 0 of the first
+ * word is shifted first. SDR_TDO and POLL return the TDO bits in the data
+ * words.
+ */
+#ifndef IOCTL_JTAG_RUN_VECTORS
+#define IOCTL_JTAG_RUN_VECTORS	_IOC(_IOC_WRITE|_IOC_READ,'t',0x40,0x3FFF)
+#endif
+
+#define JTAG_VEC_RESET		0	// Test-Logic-Reset, then Run-Test/Idle
+#define JTAG_VEC_SIR		1	// shift up to 32 bits into IR
+#define JTAG_VEC_SDR		2	// shift into DR
+#define JTAG_VEC_SDR_TDO	3	// shift into DR, TDO back into the data words
+#define JTAG_VEC_RUNTEST	4	// tcks clocks in Run-Test/Idle, then wait msec
+#define JTAG_VEC_DR_PAUSE	5	// through Pause-DR without shifting, wait msec there
+#define JTAG_VEC_POLL		6	// RUNTEST then SDR_TDO of up to 32 bits, until (TDO & mask) == value
+
+typedef struct {
+	unsigned short op;
+	unsigned short bits;	// SIR, SDR, SDR_TDO, POLL scan length
+	unsigned short tcks;	// RUNTEST, POLL
+	unsigned short count;	// POLL attempts, on return the attempts made
+	unsigned int msec;		// RUNTEST, DR_PAUSE, POLL
+	unsigned int mask;		// POLL
+	unsigned int value;		// POLL
+} jtag_vector_t;
+
 /* -------------------------------------------------- */
 extern int g_is_Support_LoopFunc;
 extern void ast_jtag_reset (void);
@@ -96,6 +129,7 @@ extern void jtag_runtest_idle(unsigned int tcks, unsigned int min_mSec);
 extern void jtag_dr_pause(unsigned int min_mSec);
 
 extern int jtag_io(int pin,int act);
+extern int jtag_run_vectors(void *list, unsigned long size);
 
 /* -------------------------------------------------- */
 //#define JTAG_PROGRAM_DEBUG_NOT_SVF
@@ -0,0 +1 @@
+#include "jtag_sim_kernel.h"
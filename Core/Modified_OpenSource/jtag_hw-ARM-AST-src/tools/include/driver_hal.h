@@ -0,0 +1,16 @@
+/* HAL registration of the driver core, only what ast_jtag.c uses */
+#include "jtag_sim_kernel.h"
+
+#define EDEV_TYPE_JTAG	1
+
+typedef struct
+{
+	int dev_type;
+	void *owner;
+	char *devname;
+	unsigned int num_instances;
+	void *phal_ops;
+} hw_hal_t;
+
+extern int register_hw_hal_module (hw_hal_t *phw_hal, void **pcore_funcs);
+extern int unregister_hw_hal_module (int dev_type, int hal_id);
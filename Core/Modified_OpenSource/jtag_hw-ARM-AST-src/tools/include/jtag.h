@@ -0,0 +1,32 @@
+/* Interface of the jtag core module, only what the hardware drivers use */
+#include "jtag_sim_kernel.h"
+
+#ifndef JTAG_SIM_JTAG_H
+#define JTAG_SIM_JTAG_H
+
+typedef struct
+{
+	void (*reset_jtag) (void);
+} jtag_hal_operations_t;
+
+typedef struct
+{
+	int dummy;
+} jtag_core_funcs_t;
+
+typedef struct
+{
+	char Device_Name [64];
+	unsigned int Device_ID;
+	unsigned int Device_Column_Length;
+	unsigned int Device_Row_Length;
+	unsigned int Device_All_Bits_Length;
+	unsigned int Device_Bscan_Length;
+	unsigned int Device_Fuses_Length;
+} JTAG_DEVICE_INFO;
+
+extern JTAG_DEVICE_INFO JTAG_device_information;
+extern unsigned int *get_jtag_read_buffer (void);
+extern unsigned int *get_jtag_write_buffer (void);
+
+#endif
@@ -0,0 +1,14 @@
+/* Commands of the jtag core passed on to hw_device_ctl() */
+#ifndef JTAG_SIM_JTAG_IOCTL_H
+#define JTAG_SIM_JTAG_IOCTL_H
+
+#define IOCTL_JTAG_UPDATE_DEVICE	1
+#define IOCTL_JTAG_IDCODE_READ		2
+#define IOCTL_JTAG_ERASE_DEVICE		3
+#define IOCTL_JTAG_PROGRAM_DEVICE	4
+#define IOCTL_JTAG_VERIFY_DEVICE	5
+#define IOCTL_JTAG_DEVICE_CHECKSUM	6
+#define IOCTL_JTAG_DEVICE_TFR		7
+#define IOCTL_JTAG_READ_USERCODE	8
+
+#endif
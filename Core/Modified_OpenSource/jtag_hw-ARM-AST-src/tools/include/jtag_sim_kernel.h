@@ -0,0 +1,74 @@
+/*
+ * Minimal kernel definitions for building ast_jtag.c and the CPLD drivers
+ * in userspace with jtag_sim.c. Register accesses and delays go to the
+ * TAP simulator in tap_sim.c, module parameters are reachable through
+ * sim_param_<name> pointers.
+ */
+
+#ifndef JTAG_SIM_KERNEL_H
+#define JTAG_SIM_KERNEL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <linux/ioctl.h>
+
+typedef unsigned char		u8;
+typedef unsigned short		u16;
+typedef unsigned int		u32;
+
+#define __iomem
+#define barrier()		__asm__ __volatile__ ("" : : : "memory")
+
+#define KERN_INFO
+#define KERN_WARNING
+#define KERN_ERR
+#define printk			sim_printk
+
+#define THIS_MODULE		NULL
+#define EXPORT_SYMBOL(sym)
+#define module_init(fn)		int (*sim_module_init)(void) = fn;
+#define module_exit(fn)		void (*sim_module_exit)(void) = fn;
+#define MODULE_AUTHOR(s)
+#define MODULE_DESCRIPTION(s)
+#define MODULE_LICENSE(s)
+#define MODULE_PARM_DESC(name, s)
+#define module_param(name, type, perm)	type *sim_param_##name = &name;
+
+#define GFP_KERNEL		0
+#define GFP_DMA			0
+#define kmalloc(size, flags)	malloc (size)
+#define kfree(p)		free (p)
+
+/* host monotonic time plus the simulated delays, in ns */
+typedef long long		ktime_t;
+#define ktime_get()		sim_ktime_get ()
+#define ktime_add(a, b)		((a) + (b))
+#define ktime_sub(a, b)		((a) - (b))
+#define ktime_to_us(t)		((t) / 1000)
+
+/* tap_sim.c */
+extern int sim_printk (const char *fmt, ...);
+extern u32 sim_ioread32 (const volatile void *addr);
+extern void sim_iowrite32 (u32 val, volatile void *addr);
+extern void *sim_ioremap (unsigned long phys, unsigned long size);
+extern volatile u32 *sim_scu (unsigned long phys);
+extern void sim_delay_ns (unsigned long long ns);
+extern void sim_sleep_ms (unsigned int ms);
+extern ktime_t sim_ktime_get (void);
+
+#define ioread32(addr)		sim_ioread32 (addr)
+#define iowrite32(val, addr)	sim_iowrite32 ((val), (addr))
+#define ioremap_nocache(phys, size)	sim_ioremap ((phys), (size))
+#define iounmap(addr)		((void)(addr))
+#define IO_ADDRESS(phys)	sim_scu (phys)
+
+#define ndelay(n)		sim_delay_ns (n)
+#define udelay(n)		sim_delay_ns ((n) * 1000ULL)
+#define mdelay(n)		sim_delay_ns ((n) * 1000000ULL)
+#define msleep(n)		sim_sleep_ms (n)
+
+#endif /* JTAG_SIM_KERNEL_H */
@@ -0,0 +1,387 @@
+/****************************************************************
+ **                                                            **
+ **    (C)Copyright 2006-2009, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross              **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+****************************************************************/
+
+/*
+ * JTAG driver simulator
+ *
+ * Runs ast_jtag.c and the Lattice MachXO2 flows of lattice.c against the
+ * TAP simulator in tap_sim.c, in software mode and in HWShiftMode. Checks
+ * scans of every length through the bypass register, vector lists and the
+ * program/verify/checksum flows, then reports the register accesses,
+ * TCKs and delays of each flow with an estimate of the time on target.
+ *
+ * Build and run from jtag_hw-ARM-AST-src:
+ *   gcc -O2 -Wall -Itools/include -I. -I../cpld_hw-ARM-AST-src \
+ *       -DCONFIG_SPX_FEATURE_LATTICE_LCMXO2_SUPPORT \
+ *       tools/jtag_sim.c tools/tap_sim.c ast_jtag.c ../cpld_hw-ARM-AST-src/lattice.c -o jtag_sim
+ *   ./jtag_sim [-v] [-a ns per register access] [-t engine TCK ns]
+ */
+
+#include <unistd.h>
+#include "tap_sim.h"
+#include "driver_hal.h"
+#include "jtag.h"
+#include "jtag_ioctl.h"
+#include "ast_jtag.h"
+#include "lattice.h"
+#include "jed.h"
+
+#define SIM_IDCODE	LATTICE_CPLD_LCMXO2_1200ZE_IDCODE
+#define SIM_ROWS	LATTICE_ROWS_LCMXO2_1200ZE_LENGTH
+#define SIM_USERCODE	0x5AC3F00D
+
+#define FAIL(fmt, args...) \
+	do { fprintf (stderr, "FAIL %s:%d: " fmt "\n", __FUNCTION__, __LINE__, ##args); exit (1); } while (0)
+
+/* ast_jtag.c */
+extern int (*sim_module_init)(void);
+extern int *sim_param_HWShiftMode;
+
+/* lattice.c */
+extern uint32_t hw_device_ctl (unsigned int cmd, unsigned int *buf, unsigned long data_size);
+extern uint32_t get_device_idcode (unsigned long *id_code);
+
+/* jtag core */
+int jtag_core_loaded = 1;
+JTAG_DEVICE_INFO JTAG_device_information;
+static unsigned int read_buffer [0x10000 / 4];
+static unsigned int write_buffer [0x10000 / 4];
+
+unsigned int *get_jtag_read_buffer (void) { return read_buffer; }
+unsigned int *get_jtag_write_buffer (void) { return write_buffer; }
+int register_hw_hal_module (hw_hal_t *phw_hal, void **pcore_funcs) { return 0; }
+int unregister_hw_hal_module (int dev_type, int hal_id) { return 0; }
+
+/* jed.c, JEDEC files are tested by cpld_hw-ARM-AST-src/tools/jed_sim.c */
+struct jed_timing jed_timing;
+uint32_t get_ProgramUsercode (void) { return SIM_USERCODE; }
+unsigned int jed_program (char *jed_str, unsigned long size) { return 1; }
+int jed_stream_active (void) { return 0; }
+int jed_stream_next_row (unsigned int bits) { return -1; }
+int jed_stream_finish (void) { return 1; }
+
+static unsigned int io_ns = 150;
+static unsigned int tck_ns = 100;
+
+static const char *mode_name (void)
+{
+	return *sim_param_HWShiftMode ? "hw shift" : "software";
+}
+
+static void report (const char *what)
+{
+	printf ("  %-9s %-22s %9lu io %9lu tck %9.1f ms delay  ~%7.2f s\n", mode_name (), what,
+		tap_sim.io_reads + tap_sim.io_writes, tap_sim.sw_tcks + tap_sim.hw_tcks,
+		tap_sim.delay_ns / 1e6, tap_sim_seconds (io_ns, tck_ns));
+}
+
+/* ------------------------------------------------------------------ */
+/* vector lists */
+
+static unsigned int vec_buf [0x20000];
+static unsigned int vec_len;		/* in words */
+
+static jtag_vector_t *vec_add (unsigned short op, unsigned short bits, const unsigned int *data)
+{
+	jtag_vector_t *vec = (jtag_vector_t *)&vec_buf [vec_len];
+	unsigned int words = 0;
+
+	memset (vec, 0, sizeof (*vec));
+	vec->op = op;
+	vec->bits = bits;
+	if (op == JTAG_VEC_SIR || op == JTAG_VEC_SDR || op == JTAG_VEC_SDR_TDO || op == JTAG_VEC_POLL)
+		words = (bits + 31) / 32;
+	vec_len += sizeof (*vec) / sizeof (unsigned int);
+	if (words)
+		memcpy (&vec_buf [vec_len], data, words * sizeof (unsigned int));
+	vec_len += words;
+	return vec;
+}
+
+static void vec_sir (unsigned int ir)
+{
+	vec_add (JTAG_VEC_SIR, 8, &ir);
+}
+
+static void vec_sdr (unsigned short bits, unsigned int value)
+{
+	vec_add (JTAG_VEC_SDR, bits, &value);
+}
+
+static void vec_runtest (unsigned short tcks, unsigned int msec)
+{
+	jtag_vector_t *vec = vec_add (JTAG_VEC_RUNTEST, 0, NULL);
+
+	vec->tcks = tcks;
+	vec->msec = msec;
+}
+
+static jtag_vector_t *vec_poll (unsigned short count, unsigned int msec)
+{
+	unsigned int tdi = 0;
+	jtag_vector_t *vec = vec_add (JTAG_VEC_POLL, 1, &tdi);
+
+	vec->tcks = 0;
+	vec->msec = msec;
+	vec->count = count;
+	vec->mask = 1;
+	vec->value = 0;
+	return vec;
+}
+
+static int vec_run (void)
+{
+	return jtag_run_vectors (vec_buf, vec_len * sizeof (unsigned int));
+}
+
+/* ------------------------------------------------------------------ */
+/* tests */
+
+static void test_idcode (void)
+{
+	unsigned long id = 0;
+
+	if (get_device_idcode (&id) != 0 || id != SIM_IDCODE)
+		FAIL ("%s: idcode %08lx", mode_name (), id);
+	if (JTAG_device_information.Device_Row_Length != SIM_ROWS)
+		FAIL ("%s: device info not loaded", mode_name ());
+	if (tap_sim.state != TAP_IDLE)
+		FAIL ("%s: TAP in state %d after scan", mode_name (), tap_sim.state);
+}
+
+/* every scan length through the 1 bit bypass register: TDO is TDI one bit late */
+static void test_bypass_scans (void)
+{
+	unsigned int tdi [TAP_SIM_MAX_SCAN / 32];
+	unsigned int *tdo;
+	unsigned int bits, i, words;
+	jtag_vector_t *vec;
+
+	for (bits = 1; bits <= 300; bits++) {
+		words = (bits + 31) / 32;
+		for (i = 0; i < words; i++)
+			tdi [i] = (unsigned int)rand () ^ ((unsigned int)rand () << 16);
+		vec_len = 0;
+		vec_sir (BYPASS);
+		vec = vec_add (JTAG_VEC_SDR_TDO, bits, tdi);
+		tdo = (unsigned int *)(vec + 1);
+		if (vec_run () != 0)
+			FAIL ("%s: %u bit scan failed", mode_name (), bits);
+		for (i = 0; i < bits; i++) {
+			unsigned int expect = i == 0 ? 0 : (tdi [(i - 1) / 32] >> ((i - 1) % 32)) & 1;
+			if (((tdo [i / 32] >> (i % 32)) & 1) != expect)
+				FAIL ("%s: %u bit scan, TDO bit %u", mode_name (), bits, i);
+		}
+		if (bits % 32 && (tdo [words - 1] >> (bits % 32)) != 0)
+			FAIL ("%s: %u bit scan, stale TDO bits", mode_name (), bits);
+		if (tap_sim.state != TAP_IDLE || tap_sim.ir != BYPASS)
+			FAIL ("%s: TAP state %d ir %02x", mode_name (), tap_sim.state, tap_sim.ir);
+	}
+}
+
+static void fill_image (unsigned int *image, unsigned int rows, unsigned int seed)
+{
+	unsigned int i;
+
+	srand (seed);
+	for (i = 0; i < rows * TAP_SIM_ROW_WORDS; i++)
+		image [i] = (unsigned int)rand () ^ ((unsigned int)rand () << 16);
+}
+
+static void check_flash (const unsigned int *image, unsigned int rows)
+{
+	unsigned int r;
+
+	for (r = 0; r < rows; r++)
+		if (memcmp (tap_sim.flash [r], &image [r * TAP_SIM_ROW_WORDS], TAP_SIM_ROW_WORDS * sizeof (u32)) != 0)
+			FAIL ("%s: flash row %u", mode_name (), r);
+	if (tap_sim.protocol_errors != 0)
+		FAIL ("%s: %lu protocol errors", mode_name (), tap_sim.protocol_errors);
+}
+
+/* the MachXO2 program sequence of lattice.c as one vector list */
+static void test_vector_program (void)
+{
+	static unsigned int image [SIM_ROWS * TAP_SIM_ROW_WORDS];
+	unsigned int rows = 64, r;
+	jtag_vector_t *vec;
+
+	fill_image (image, rows, 1);
+	vec_len = 0;
+	vec_add (JTAG_VEC_RESET, 0, NULL);
+	vec_sir (ISC_ENABLE_X); vec_sdr (8, 0x08); vec_runtest (2, 10);
+	vec_sir (ISC_ERASE); vec_sdr (8, 0x04); vec_runtest (2, 0);
+	vec_sir (LSC_CHECK_BUSY); vec_poll (350, 10);
+	vec_sir (LSC_INIT_ADDRESS); vec_sdr (8, 0x04); vec_runtest (2, 10);
+	for (r = 0; r < rows; r++) {
+		vec_sir (LSC_PROG_INCR_NV);
+		vec_add (JTAG_VEC_SDR, 128, &image [r * TAP_SIM_ROW_WORDS]);
+		vec_runtest (2, 0);
+		vec_sir (LSC_CHECK_BUSY);
+		vec_poll (10, 1);
+	}
+	vec_sir (ISC_DISABLE); vec_runtest (2, 1000);
+	vec_sir (BYPASS);
+
+	tap_sim_clear_counters ();
+	if (vec_run () != 0)
+		FAIL ("%s: program vectors", mode_name ());
+	check_flash (image, rows);
+	if (tap_sim.enabled)
+		FAIL ("%s: left in programming mode", mode_name ());
+	report ("vectors, 64 rows");
+
+	/* read back in place */
+	vec_len = 0;
+	vec_sir (LSC_INIT_ADDRESS); vec_sdr (8, 0x04); vec_runtest (2, 1);
+	vec_sir (LSC_READ_INCR_NV); vec_runtest (2, 1);
+	for (r = 0; r < rows; r++) {
+		unsigned int zero [TAP_SIM_ROW_WORDS] = { 0 };
+
+		vec_add (JTAG_VEC_SDR_TDO, 128, zero);
+		vec_runtest (2, 1);
+	}
+	if (vec_run () != 0)
+		FAIL ("%s: read vectors", mode_name ());
+	for (r = 0, vec = (jtag_vector_t *)&vec_buf [0]; (unsigned int *)vec < &vec_buf [vec_len]; ) {
+		unsigned int words = (vec->op == JTAG_VEC_SIR || vec->op == JTAG_VEC_SDR ||
+				      vec->op == JTAG_VEC_SDR_TDO) ? (vec->bits + 31) / 32 : 0;
+
+		if (vec->op == JTAG_VEC_SDR_TDO) {
+			if (memcmp (vec + 1, &image [r * TAP_SIM_ROW_WORDS], 16) != 0)
+				FAIL ("%s: read back row %u", mode_name (), r);
+			r++;
+		}
+		vec = (jtag_vector_t *)((unsigned int *)(vec + 1) + words);
+	}
+	if (r != rows)
+		FAIL ("%s: read back %u rows", mode_name (), r);
+}
+
+static void test_vector_errors (void)
+{
+	jtag_vector_t *vec;
+	int ret;
+
+	/* busy for longer than the poll allows */
+	vec_len = 0;
+	tap_sim.busy = 100;
+	vec_sir (LSC_CHECK_BUSY);
+	vec = vec_poll (5, 1);
+	ret = vec_run ();
+	if (ret != -ETIMEDOUT || vec->count != 5 || *(unsigned int *)(vec + 1) != 1)
+		FAIL ("%s: poll timeout returned %d after %u", mode_name (), ret, vec->count);
+	tap_sim.busy = 0;
+
+	/* poll stops as soon as the device is ready */
+	vec_len = 0;
+	tap_sim.busy = 2;
+	vec_sir (LSC_CHECK_BUSY);
+	vec = vec_poll (10, 1);
+	if (vec_run () != 0 || vec->count != 3)
+		FAIL ("%s: poll took %u attempts", mode_name (), vec->count);
+
+	/* truncated data words, bad lengths and opcodes */
+	vec_len = 0;
+	vec_add (JTAG_VEC_SDR, 64, (unsigned int [2]){ 0, 0 });
+	if (jtag_run_vectors (vec_buf, vec_len * sizeof (unsigned int) - 4) != -EINVAL)
+		FAIL ("%s: truncated list accepted", mode_name ());
+	vec_len = 0;
+	vec_add (JTAG_VEC_SIR, 33, (unsigned int [2]){ 0, 0 });
+	if (vec_run () != -EINVAL)
+		FAIL ("%s: 33 bit SIR accepted", mode_name ());
+	vec_len = 0;
+	vec_add (99, 0, NULL);
+	if (vec_run () != -EINVAL)
+		FAIL ("%s: bad opcode accepted", mode_name ());
+	if (tap_sim.state != TAP_IDLE)
+		FAIL ("%s: TAP in state %d", mode_name (), tap_sim.state);
+}
+
+/* program, verify and checksum through hw_device_ctl() as the jtag core does */
+static unsigned int test_lattice_flows (void)
+{
+	unsigned int *image = get_jtag_write_buffer ();
+	unsigned int checksum = 0;
+	unsigned long id;
+
+	get_device_idcode (&id);
+	memset (image, 0, sizeof (write_buffer));
+	fill_image (image, SIM_ROWS, 2);
+
+	tap_sim_clear_counters ();
+	if (hw_device_ctl (IOCTL_JTAG_PROGRAM_DEVICE, image, SIM_ROWS * 128) != 0)
+		FAIL ("%s: program failed", mode_name ());
+	check_flash (image, SIM_ROWS);
+	if (tap_sim.usercode != SIM_USERCODE || !tap_sim.done || tap_sim.enabled)
+		FAIL ("%s: usercode %08x done %d enabled %d", mode_name (), tap_sim.usercode, tap_sim.done, tap_sim.enabled);
+	report ("lattice program+verify");
+
+	tap_sim_clear_counters ();
+	if (hw_device_ctl (IOCTL_JTAG_VERIFY_DEVICE, image, SIM_ROWS * 128) != 0)
+		FAIL ("%s: verify failed", mode_name ());
+	report ("lattice verify");
+
+	tap_sim.flash [SIM_ROWS / 2][1] ^= 0x100;
+	if (hw_device_ctl (IOCTL_JTAG_VERIFY_DEVICE, image, SIM_ROWS * 128) == 0)
+		FAIL ("%s: verify passed with a flipped fuse", mode_name ());
+	tap_sim.flash [SIM_ROWS / 2][1] ^= 0x100;
+
+	if (hw_device_ctl (IOCTL_JTAG_DEVICE_CHECKSUM, &checksum, 0) != 0)
+		FAIL ("%s: checksum failed", mode_name ());
+	return checksum;
+}
+
+static void run_mode (int hw)
+{
+	unsigned int checksum;
+	static unsigned int first_checksum;
+
+	*sim_param_HWShiftMode = hw;
+	tap_sim_init (SIM_IDCODE, SIM_ROWS);
+	if (sim_module_init () != 0 || tap_sim.state != TAP_IDLE)
+		FAIL ("%s: init, TAP in state %d", mode_name (), tap_sim.state);
+
+	test_idcode ();
+	test_bypass_scans ();
+	test_vector_program ();
+	test_vector_errors ();
+	checksum = test_lattice_flows ();
+	if (hw && checksum != first_checksum)
+		FAIL ("checksum %04x in hw shift mode, %04x in software mode", checksum, first_checksum);
+	first_checksum = checksum;
+	if (tap_sim.protocol_errors != 0)
+		FAIL ("%s: %lu protocol errors", mode_name (), tap_sim.protocol_errors);
+}
+
+int main (int argc, char *argv [])
+{
+	int opt;
+
+	while ((opt = getopt (argc, argv, "va:t:")) != -1) {
+		switch (opt) {
+			case 'v': tap_sim_quiet = 0; break;
+			case 'a': io_ns = atoi (optarg); break;
+			case 't': tck_ns = atoi (optarg); break;
+			default:
+				fprintf (stderr, "usage: %s [-v] [-a ns per register access] [-t engine TCK ns]\n", argv [0]);
+				return 2;
+		}
+	}
+
+	printf ("estimates at %u ns per register access, %u ns per engine TCK, msleep() of one 10 ms jiffy\n",
+		io_ns, tck_ns);
+	run_mode (0);
+	run_mode (1);
+	printf ("all tests OK\n");
+	return 0;
+}
@@ -0,0 +1,441 @@
+/****************************************************************
+ **                                                            **
+ **    (C)Copyright 2006-2009, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross              **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+****************************************************************/
+
+/*
+ * TAP simulator backend, see tap_sim.h
+ *
+ * Software mode: a write to JTAG_STATUS with SOFTWARE_MODE_ENABLE sets the
+ * TCK, TMS and TDI pins, TCK edges clock the TAP. TDO is updated on the
+ * falling edge and read back from the TDIO bit of JTAG_STATUS.
+ *
+ * Hardware mode: setting the instruction/data enable bit of JTAG_CONTROL
+ * shifts the length field bits of JTAG_INSTRUCTION/JTAG_DATA from
+ * Run-Test/Idle or Pause, the TDO bits enter the register at bit 31. The
+ * scan ends in Pause with a pause status, or in Run-Test/Idle with a
+ * complete status on the last transfer.
+ */
+
+#include <stdarg.h>
+#include <time.h>
+#include "tap_sim.h"
+#include "ast_jtag.h"
+#include "lattice.h"
+
+tap_sim_t tap_sim;
+int tap_sim_quiet = 1;
+
+static u32 regs [0x40 / 4];
+static u32 scu [0x100 / 4];
+static int tck;			/* software mode TCK pin level */
+static int tdo;			/* TDO pin, updated on TCK falling edges */
+static unsigned long long delay_total_ns;	/* never cleared, for ktime_get() */
+
+/* current scan: captured bits, shifted in bits */
+static unsigned int scan_len;
+static unsigned int scan_count;
+static unsigned char scan_cap [TAP_SIM_MAX_SCAN];
+static unsigned char scan_in [TAP_SIM_MAX_SCAN];
+
+static const unsigned char tap_next [16][2] = {
+	[TAP_RESET]      = { TAP_IDLE,       TAP_RESET },
+	[TAP_IDLE]       = { TAP_IDLE,       TAP_SELECT_DR },
+	[TAP_SELECT_DR]  = { TAP_CAPTURE_DR, TAP_SELECT_IR },
+	[TAP_CAPTURE_DR] = { TAP_SHIFT_DR,   TAP_EXIT1_DR },
+	[TAP_SHIFT_DR]   = { TAP_SHIFT_DR,   TAP_EXIT1_DR },
+	[TAP_EXIT1_DR]   = { TAP_PAUSE_DR,   TAP_UPDATE_DR },
+	[TAP_PAUSE_DR]   = { TAP_PAUSE_DR,   TAP_EXIT2_DR },
+	[TAP_EXIT2_DR]   = { TAP_SHIFT_DR,   TAP_UPDATE_DR },
+	[TAP_UPDATE_DR]  = { TAP_IDLE,       TAP_SELECT_DR },
+	[TAP_SELECT_IR]  = { TAP_CAPTURE_IR, TAP_RESET },
+	[TAP_CAPTURE_IR] = { TAP_SHIFT_IR,   TAP_EXIT1_IR },
+	[TAP_SHIFT_IR]   = { TAP_SHIFT_IR,   TAP_EXIT1_IR },
+	[TAP_EXIT1_IR]   = { TAP_PAUSE_IR,   TAP_UPDATE_IR },
+	[TAP_PAUSE_IR]   = { TAP_PAUSE_IR,   TAP_EXIT2_IR },
+	[TAP_EXIT2_IR]   = { TAP_SHIFT_IR,   TAP_UPDATE_IR },
+	[TAP_UPDATE_IR]  = { TAP_IDLE,       TAP_SELECT_DR },
+};
+
+int sim_printk (const char *fmt, ...)
+{
+	va_list ap;
+	int n = 0;
+
+	if (!tap_sim_quiet) {
+		va_start (ap, fmt);
+		n = vprintf (fmt, ap);
+		va_end (ap);
+	}
+	return n;
+}
+
+void tap_sim_init (u32 idcode, unsigned int rows)
+{
+	memset (&tap_sim, 0, sizeof (tap_sim));
+	memset (regs, 0, sizeof (regs));
+	tap_sim.state = TAP_RESET;
+	tap_sim.ir = IDCODE_PUB;
+	tap_sim.idcode = idcode;
+	tap_sim.rows = rows;
+	tap_sim.busy_after_erase = 3;
+	tap_sim.busy_after_program = 1;
+	tck = 0;
+	tdo = 0;
+}
+
+void tap_sim_clear_counters (void)
+{
+	tap_sim.io_reads = 0;
+	tap_sim.io_writes = 0;
+	tap_sim.sw_tcks = 0;
+	tap_sim.hw_tcks = 0;
+	tap_sim.delay_ns = 0;
+}
+
+double tap_sim_seconds (unsigned int io_ns, unsigned int tck_ns)
+{
+	return ((double)(tap_sim.io_reads + tap_sim.io_writes) * io_ns +
+		(double)tap_sim.hw_tcks * tck_ns + (double)tap_sim.delay_ns) / 1e9;
+}
+
+/* ------------------------------------------------------------------ */
+/* MachXO2 model */
+
+static unsigned int dr_length (void)
+{
+	switch (tap_sim.ir) {
+		case IDCODE:		/* legacy opcode get_device_idcode() uses */
+		case IDCODE_PUB:
+		case LSC_READ_STATUS:
+		case LSC_WRITE_ADDRESS:
+		case USERCODE:
+			return 32;
+		case ISC_ENABLE_X:
+		case ISC_ENABLE:
+		case ISC_ERASE:
+		case LSC_INIT_ADDRESS:
+			return 8;
+		case LSC_PROG_INCR_NV:
+		case LSC_READ_INCR_NV:
+			return TAP_SIM_ROW_WORDS * 32;
+		case LSC_READ_FEATURE:
+			return 64;
+		case LSC_READ_FEABITS:
+			return 16;
+		default:	/* LSC_CHECK_BUSY, BYPASS and the rest */
+			return 1;
+	}
+}
+
+static void capture_bits (const u32 *words, unsigned int len)
+{
+	unsigned int i;
+
+	scan_len = len;
+	scan_count = 0;
+	for (i = 0; i < len; i++)
+		scan_cap [i] = words ? (words [i / 32] >> (i % 32)) & 1 : 0;
+}
+
+/* register content after the shifts so far */
+static void scan_content (u32 *words)
+{
+	unsigned int i, k;
+
+	memset (words, 0, ((scan_len + 31) / 32) * sizeof (u32));
+	for (i = 0; i < scan_len; i++) {
+		k = i + scan_count;
+		if ((k < scan_len ? scan_cap [k] : scan_in [k - scan_len]) != 0)
+			words [i / 32] |= 1u << (i % 32);
+	}
+}
+
+static void capture_dr (void)
+{
+	u32 value [TAP_SIM_ROW_WORDS] = { 0 };
+
+	switch (tap_sim.ir) {
+		case IDCODE:
+		case IDCODE_PUB:
+			value [0] = tap_sim.idcode;
+			break;
+		case LSC_READ_STATUS:
+			value [0] = tap_sim.busy > 0 ? 0x00001000 : 0;
+			break;
+		case LSC_CHECK_BUSY:
+			if (tap_sim.busy > 0) {
+				value [0] = 1;
+				tap_sim.busy--;
+			}
+			break;
+		case USERCODE:
+			value [0] = tap_sim.usercode;
+			break;
+		case LSC_READ_INCR_NV:
+			if (tap_sim.address < tap_sim.rows)
+				memcpy (value, tap_sim.flash [tap_sim.address], sizeof (value));
+			break;
+	}
+	capture_bits (value, dr_length ());
+}
+
+static void update_dr (void)
+{
+	u32 value [TAP_SIM_MAX_SCAN / 32];
+
+	scan_content (value);
+	switch (tap_sim.ir) {
+		case ISC_ENABLE_X:
+		case ISC_ENABLE:
+			tap_sim.enabled = 1;
+			break;
+		case ISC_ERASE:
+			if (!tap_sim.enabled) {
+				tap_sim.protocol_errors++;
+				break;
+			}
+			if (value [0] & 0x04) {
+				memset (tap_sim.flash, 0, sizeof (tap_sim.flash));
+				tap_sim.done = 0;
+			}
+			tap_sim.busy = tap_sim.busy_after_erase;
+			break;
+		case LSC_INIT_ADDRESS:
+			tap_sim.address = 0;
+			break;
+		case LSC_WRITE_ADDRESS:
+			tap_sim.address = value [0] & 0xFFFF;
+			break;
+		case LSC_PROG_INCR_NV:
+			if (!tap_sim.enabled || tap_sim.address >= tap_sim.rows) {
+				tap_sim.protocol_errors++;
+				break;
+			}
+			memcpy (tap_sim.flash [tap_sim.address++], value, TAP_SIM_ROW_WORDS * sizeof (u32));
+			tap_sim.busy = tap_sim.busy_after_program;
+			break;
+		case LSC_READ_INCR_NV:
+			tap_sim.address++;
+			break;
+		case USERCODE:
+			/* held until ISC_PROGRAM_USERCODE */
+			tap_sim.usercode_shift = value [0];
+			break;
+	}
+}
+
+static void update_ir (void)
+{
+	u32 value [1];
+
+	scan_content (value);
+	tap_sim.ir = value [0] & 0xFF;
+	switch (tap_sim.ir) {
+		case ISC_PROGRAM_USERCODE:
+			if (tap_sim.enabled)
+				tap_sim.usercode = tap_sim.usercode_shift;
+			else
+				tap_sim.protocol_errors++;
+			break;
+		case ISC_PROGRAM_DONE:
+			tap_sim.done = 1;
+			break;
+		case ISC_DISABLE:
+			tap_sim.enabled = 0;
+			break;
+	}
+}
+
+/* ------------------------------------------------------------------ */
+/* TAP */
+
+static void tck_falling (void)
+{
+	if (tap_sim.state == TAP_SHIFT_DR || tap_sim.state == TAP_SHIFT_IR)
+		tdo = scan_count < scan_len ? scan_cap [scan_count] : scan_in [scan_count - scan_len];
+}
+
+static void tck_rising (int tms, int tdi)
+{
+	switch (tap_sim.state) {
+		case TAP_CAPTURE_DR:
+			capture_dr ();
+			break;
+		case TAP_CAPTURE_IR:
+			capture_bits (NULL, 8);
+			scan_cap [0] = 1;
+			break;
+		case TAP_SHIFT_DR:
+		case TAP_SHIFT_IR:
+			if (scan_count >= TAP_SIM_MAX_SCAN) {
+				tap_sim.protocol_errors++;
+				break;
+			}
+			scan_in [scan_count++] = tdi;
+			break;
+		default:
+			break;
+	}
+
+	tap_sim.state = tap_next [tap_sim.state][tms ? 1 : 0];
+
+	switch (tap_sim.state) {
+		case TAP_RESET:
+			tap_sim.ir = IDCODE_PUB;
+			break;
+		case TAP_UPDATE_DR:
+			update_dr ();
+			break;
+		case TAP_UPDATE_IR:
+			update_ir ();
+			break;
+		default:
+			break;
+	}
+}
+
+/* one engine TCK, returns the TDO bit sampled on the rising edge */
+static int hw_clock (int tms, int tdi)
+{
+	int bit;
+
+	tck_falling ();
+	bit = tdo;
+	tck_rising (tms, tdi);
+	tap_sim.hw_tcks++;
+	return bit;
+}
+
+static void hw_shift (int ir, u32 ctrl)
+{
+	unsigned int len = (ctrl >> (ir ? AST_JTAG_CTRL_INST_LEN_OFFSET : AST_JTAG_CTRL_DATA_LEN_OFFSET)) & 0x3F;
+	int last = (ctrl & (ir ? AST_JTAG_CTRL_INST_LAST_TRANS : AST_JTAG_CTRL_DATA_LAST_TRANS)) != 0;
+	u32 *reg = &regs [(ir ? JTAG_INSTRUCTION : JTAG_DATA) / 4];
+	enum tap_state pause = ir ? TAP_PAUSE_IR : TAP_PAUSE_DR;
+	unsigned int i;
+
+	if ((regs [JTAG_STATUS / 4] & SOFTWARE_MODE_ENABLE) || (ctrl & AST_JTAG_CTRL_ENABLE) != AST_JTAG_CTRL_ENABLE ||
+	    len == 0 || len > AST_JTAG_CTRL_MAX_DATA_LENGTH) {
+		tap_sim.protocol_errors++;
+		return;
+	}
+
+	if (tap_sim.state == TAP_IDLE) {
+		hw_clock (1, 0);		/* Select-DR */
+		if (ir)
+			hw_clock (1, 0);	/* Select-IR */
+		hw_clock (0, 0);		/* Capture */
+		hw_clock (0, 0);		/* Shift */
+	} else if (tap_sim.state == pause) {
+		hw_clock (1, 0);		/* Exit2 */
+		hw_clock (0, 0);		/* Shift */
+	} else {
+		tap_sim.protocol_errors++;
+		return;
+	}
+
+	for (i = 0; i < len; i++) {
+		int bit = hw_clock (i == len - 1, *reg & 1);
+		*reg = (*reg >> 1) | ((u32)bit << 31);
+	}
+
+	if (last) {
+		hw_clock (1, 0);		/* Update */
+		hw_clock (0, 0);		/* Run-Test/Idle */
+		regs [JTAG_INTERRUPT / 4] |= ir ? AST_JTAG_INTR_INST_COMPLETE : AST_JTAG_INTR_DATA_COMPLETE;
+	} else {
+		hw_clock (0, 0);		/* Pause */
+		regs [JTAG_INTERRUPT / 4] |= ir ? AST_JTAG_INTR_INST_PAUSE : AST_JTAG_INTR_DATA_PAUSE;
+	}
+}
+
+/* ------------------------------------------------------------------ */
+/* registers */
+
+void *sim_ioremap (unsigned long phys, unsigned long size)
+{
+	return (phys == AST_JTAG_REG_BASE && size <= sizeof (regs)) ? (void *)regs : NULL;
+}
+
+volatile u32 *sim_scu (unsigned long phys)
+{
+	return &scu [(phys & 0xFF) / 4];
+}
+
+u32 sim_ioread32 (const volatile void *addr)
+{
+	unsigned long off = (const volatile u8 *)addr - (const volatile u8 *)regs;
+
+	tap_sim.io_reads++;
+	if (off == JTAG_STATUS)
+		return (regs [off / 4] & SOFTWARE_MODE_ENABLE) | (tdo ? SOFTWARE_TDIO_BIT : 0);
+	return regs [off / 4];
+}
+
+void sim_iowrite32 (u32 val, volatile void *addr)
+{
+	unsigned long off = (volatile u8 *)addr - (volatile u8 *)regs;
+	u32 old = regs [off / 4];
+	int new_tck;
+
+	tap_sim.io_writes++;
+	switch (off) {
+		case JTAG_STATUS:
+			regs [off / 4] = val;
+			if (!(val & SOFTWARE_MODE_ENABLE))
+				break;
+			new_tck = (val & SOFTWARE_TCK_BIT) != 0;
+			if (tck && !new_tck) {
+				tck_falling ();
+			} else if (!tck && new_tck) {
+				tck_rising ((val & SOFTWARE_TMS_BIT) != 0, (val & SOFTWARE_TDIO_BIT) != 0);
+				tap_sim.sw_tcks++;
+			}
+			tck = new_tck;
+			break;
+		case JTAG_INTERRUPT:
+			/* enables are written, status bits are write 1 to clear */
+			regs [off / 4] = (old & ~val & AST_JTAG_INTR_STATUS_MASK) | (val & AST_JTAG_INTR_ENABLE_MASK);
+			break;
+		case JTAG_CONTROL:
+			regs [off / 4] = val;
+			if ((val & AST_JTAG_CTRL_INST_ENABLE) && !(old & AST_JTAG_CTRL_INST_ENABLE))
+				hw_shift (1, val);
+			if ((val & AST_JTAG_CTRL_DATA_ENABLE) && !(old & AST_JTAG_CTRL_DATA_ENABLE))
+				hw_shift (0, val);
+			/* the engine leaves TCK low */
+			tck = 0;
+			break;
+		default:
+			regs [off / 4] = val;
+			break;
+	}
+}
+
+void sim_delay_ns (unsigned long long ns)
+{
+	tap_sim.delay_ns += ns;
+	delay_total_ns += ns;
+}
+
+/* msleep() sleeps at least one jiffy, HZ=100 */
+void sim_sleep_ms (unsigned int ms)
+{
+	sim_delay_ns ((ms < 10 ? 10 : ms) * 1000000ULL);
+}
+
+ktime_t sim_ktime_get (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (ktime_t)ts.tv_sec * 1000000000LL + ts.tv_nsec + (ktime_t)delay_total_ns;
+}
@@ -0,0 +1,61 @@
+/*
+ * TAP simulator for the AST JTAG master
+ *
+ * Models the JTAG controller registers of ast_jtag.c, software mode pins
+ * and the hardware shift engine, driving the IEEE 1149.1 TAP state
+ * machine of one MachXO2-like CPLD on the chain. Counts register
+ * accesses, TCKs and delays so flows can be timed off-target.
+ */
+
+#ifndef TAP_SIM_H
+#define TAP_SIM_H
+
+#include "jtag_sim_kernel.h"
+
+#define TAP_SIM_MAX_ROWS	4096
+#define TAP_SIM_ROW_WORDS	4		/* 128 bit MachXO2 rows */
+#define TAP_SIM_MAX_SCAN	8192
+
+enum tap_state {
+	TAP_RESET, TAP_IDLE,
+	TAP_SELECT_DR, TAP_CAPTURE_DR, TAP_SHIFT_DR, TAP_EXIT1_DR, TAP_PAUSE_DR, TAP_EXIT2_DR, TAP_UPDATE_DR,
+	TAP_SELECT_IR, TAP_CAPTURE_IR, TAP_SHIFT_IR, TAP_EXIT1_IR, TAP_PAUSE_IR, TAP_EXIT2_IR, TAP_UPDATE_IR
+};
+
+typedef struct
+{
+	/* TAP */
+	enum tap_state state;
+	u32 ir;
+
+	/* device */
+	u32 idcode;
+	unsigned int rows;
+	u32 flash [TAP_SIM_MAX_ROWS][TAP_SIM_ROW_WORDS];
+	unsigned int address;
+	u32 usercode;
+	u32 usercode_shift;
+	int enabled;			/* ISC_ENABLE_X seen */
+	int done;			/* ISC_PROGRAM_DONE seen */
+	int busy;			/* LSC_CHECK_BUSY reads left reporting busy */
+	int busy_after_erase;
+	int busy_after_program;
+	unsigned long protocol_errors;	/* engine misuse, programming while disabled */
+
+	/* cost */
+	unsigned long io_reads;
+	unsigned long io_writes;
+	unsigned long sw_tcks;
+	unsigned long hw_tcks;
+	unsigned long long delay_ns;
+} tap_sim_t;
+
+extern tap_sim_t tap_sim;
+extern int tap_sim_quiet;		/* drop printk output */
+
+extern void tap_sim_init (u32 idcode, unsigned int rows);
+extern void tap_sim_clear_counters (void);
+/* estimated target time of the counted work, io_ns per register access, tck_ns per engine TCK */
+extern double tap_sim_seconds (unsigned int io_ns, unsigned int tck_ns);
+
+#endif /* TAP_SIM_H */
@@ -22,6 +22,19 @@
 #define INT_ENABLE  0x1E
 #define POLL_MSEC HZ
 
+/* Requests received on a channel and not yet read by the IPMI stack. One
+   slot is always receiving, so up to KCS_REQ_QUEUE_LEN - 1 are queued. */
+#ifndef KCS_REQ_QUEUE_LEN
+#define KCS_REQ_QUEUE_LEN	4
+#endif
+#define KCS_REQ_SLOT_SIZE	(MAX_KCS_PKT_LEN + 1)
+
+#define IS_IBF_SET(STATUS)     (0 != ((STATUS) & 0x02))
+#define IS_WRITE_TO_CMD_REG(STATUS)    (0 != ((STATUS) & 0x08))
+#define CHK_STATE_IDLE(STATUS)     (0 == ((STATUS) & 0xC0))
+
+#define MAX_SEQ_NO		250		/*< Maximum sequence number and it will repeat again from 0 >*/
+
 /* Different Phases of the KCS Module */
 #define KCS_PHASE_IDLE			    0x00
 #define KCS_PHASE_WRITE			    0x01
@@ -90,6 +103,13 @@ typedef struct
 	spinlock_t 			kcs_lock;
 //	Event_T		    		KCSRcvPktReady;
 	u8				KCSSeqNo;
+	u8*				pReqSlot [KCS_REQ_QUEUE_LEN];	/* pKCSRcvPkt is pReqSlot [ReqTail] */
+	u32				ReqLen [KCS_REQ_QUEUE_LEN];
+	u8				ReqHead;		/* Oldest queued request */
+	u8				ReqTail;		/* Slot being received */
+	u8				ReqCount;		/* Requests queued */
+	u8				ReqReading;		/* ReqHead is being copied to user */
+	u32				ReqDropped;		/* Requests dropped on a full queue */
 }KCSBuf_T;
 
 
@@ -143,4 +163,19 @@ typedef struct
 	int (*is_hw_test_mode) (void);
 } kcs_core_funcs_t;
 
+struct kcs_hal
+{
+	KCSBuf_T *pkcs_buf;
+	IPMICmdMsg_T* pipmi_cmd_msg;
+	kcs_hal_operations_t *pkcs_hal_ops;
+	u8 *preq_slots;
+};
+
+/* kcs_recv.c, the kcs_lock of the channel must be held for the queue calls */
+void kcs_recv_byte (struct kcs_hal *pkcs_hal, unsigned char ch_num);
+int kcs_send_response (struct kcs_hal *pkcs_hal, unsigned char ch_num);
+void kcs_reset_req_queue (KCSBuf_T *pKCSBuffer);
+int kcs_get_request (KCSBuf_T *pKCSBuffer, u8 **ppReq, u32 *pLen);
+void kcs_put_request (KCSBuf_T *pKCSBuffer);
+
 #endif /* KCS_H */
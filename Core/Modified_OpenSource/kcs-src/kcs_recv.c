@@ -0,0 +1,409 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+
+/*
+ * KCS host interface state machine and request queue.
+ *
+ * kcs_recv_byte() runs from the IBF interrupt of a channel and moves the
+ * channel through the KCS write/read/abort phases. Complete requests are
+ * queued in per-channel slots until the IPMI stack reads them, so a request
+ * arriving while the previous one is being processed is not overwritten.
+ * Only uses the HAL operations and the kcs_lock, so it can also be built
+ * against the simulated HAL in tools/.
+ */
+
+#include <linux/kernel.h>
+#include <linux/sched.h>
+#include <linux/spinlock.h>
+#include "kcs.h"
+
+#ifdef DEBUG
+#define dbgprint(fmt, args...)       printk (KERN_INFO fmt, ##args) 
+#else
+#define dbgprint(fmt, args...)       
+#endif
+
+extern void Kcs_OsWakeupOnTimeout(Kcs_OsSleepStruct *Sleep);
+
+/**
+ * @brief Empty the request queue, receive into the first slot.
+ **/
+void
+kcs_reset_req_queue (KCSBuf_T *pKCSBuffer)
+{
+	pKCSBuffer->ReqHead = 0;
+	pKCSBuffer->ReqTail = 0;
+	pKCSBuffer->ReqCount = 0;
+	pKCSBuffer->ReqReading = 0;
+	pKCSBuffer->KcsWakeup = 0;
+	pKCSBuffer->pKCSRcvPkt = pKCSBuffer->pReqSlot [0];
+}
+
+/**
+ * @brief Queue the request just received and receive the next one into a
+ *        free slot. On a full queue the oldest request is dropped, or the
+ *        new one if the oldest is being copied to the user.
+ **/
+static void
+kcs_queue_request (KCSBuf_T *pKCSBuffer)
+{
+	pKCSBuffer->ReqLen [pKCSBuffer->ReqTail] = pKCSBuffer->KCSRcvPktIx;
+
+	if (pKCSBuffer->ReqCount == KCS_REQ_QUEUE_LEN - 1)
+	{
+		pKCSBuffer->ReqDropped++;
+		if (pKCSBuffer->ReqReading)
+		{
+			dbgprint ("KCS request queue full, dropping the new request\n");
+			return;
+		}
+		dbgprint ("KCS request queue full, dropping the oldest request\n");
+		pKCSBuffer->ReqHead = (pKCSBuffer->ReqHead + 1) % KCS_REQ_QUEUE_LEN;
+		pKCSBuffer->ReqCount--;
+	}
+
+	pKCSBuffer->ReqCount++;
+	pKCSBuffer->ReqTail = (pKCSBuffer->ReqTail + 1) % KCS_REQ_QUEUE_LEN;
+	pKCSBuffer->pKCSRcvPkt = pKCSBuffer->pReqSlot [pKCSBuffer->ReqTail];
+	pKCSBuffer->KcsWakeup = 1;
+}
+
+/**
+ * @brief Get the oldest queued request. It stays valid, and is not dropped,
+ *        until kcs_put_request() is called.
+ * @return 0 on success, -1 if the queue is empty.
+ **/
+int
+kcs_get_request (KCSBuf_T *pKCSBuffer, u8 **ppReq, u32 *pLen)
+{
+	if (0 == pKCSBuffer->ReqCount)
+		return -1;
+
+	*ppReq = pKCSBuffer->pReqSlot [pKCSBuffer->ReqHead];
+	*pLen = pKCSBuffer->ReqLen [pKCSBuffer->ReqHead];
+	pKCSBuffer->ReqReading = 1;
+	return 0;
+}
+
+/**
+ * @brief Remove the request returned by kcs_get_request() from the queue.
+ **/
+void
+kcs_put_request (KCSBuf_T *pKCSBuffer)
+{
+	pKCSBuffer->ReqHead = (pKCSBuffer->ReqHead + 1) % KCS_REQ_QUEUE_LEN;
+	pKCSBuffer->ReqCount--;
+	pKCSBuffer->ReqReading = 0;
+	pKCSBuffer->KcsWakeup = (0 != pKCSBuffer->ReqCount);
+}
+
+/**
+ * @brief Start sending the response in the channel's IPMICmdMsg_T, the rest
+ *        of it is sent from the IBF interrupt handler.
+ * @return 0 if sent, -1 if it does not belong to the current request.
+ **/
+int
+kcs_send_response (struct kcs_hal *pkcs_hal, unsigned char ch_num)
+{
+	IPMICmdMsg_T *pKCSCmdMsg = &pkcs_hal->pipmi_cmd_msg [ch_num];	
+	KCSBuf_T *pKCSBuffer = &pkcs_hal->pkcs_buf [ch_num];
+	
+    /* If we are responding to an aborted request skip sending data */ 
+	if (pKCSBuffer->PrevCmdAborted)
+	{
+		pKCSBuffer->PrevCmdAborted = 0;
+		return -1; 
+	}
+
+	dbgprint ("Sequence Number : %d %d, NetFn : %x, Cmd : %x\n", 
+			pKCSBuffer->KCSSeqNo, pKCSCmdMsg->SessionID, 
+			pKCSCmdMsg->Response[0], pKCSCmdMsg->Response[1]);
+	
+	if (pKCSBuffer->KCSSeqNo != pKCSCmdMsg->SessionID)
+	{
+		//! The response is not belong to the current request, so ignore the response.
+		dbgprint ("Session ID mismatch, so ignoring the response Request : %d, Response : %d\n", 
+				pKCSBuffer->KCSSeqNo, pKCSCmdMsg->SessionID);
+		return -1;
+	}
+	
+	/* Update the send buffer and associated indexes */
+	pKCSBuffer->pKCSSendPkt = pKCSCmdMsg->Response;
+	pKCSBuffer->KCSSendPktLen   = pKCSCmdMsg->ResponseSize;
+	pKCSBuffer->KCSSendPktIx   = 0;
+
+	/* Send the first byte */
+	pKCSBuffer->KCSSendPktIx++;
+	pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, pKCSBuffer->pKCSSendPkt[0]);
+	//SA Set OBF Byte
+	pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
+
+	/* From now onwords the data is sent from the IBF Interrupt handler */
+	return 0;
+}
+
+static void 
+set_kcs_state (struct kcs_hal *pkcs_hal, unsigned char ch_num, u8 state_value)
+{
+        u8 status_val = 0;
+        pkcs_hal->pkcs_hal_ops->read_kcs_status (ch_num, &status_val);
+        status_val = ((status_val & (~0xC0)) | (state_value));
+        pkcs_hal->pkcs_hal_ops->write_kcs_status (ch_num, status_val);
+}
+
+void 
+kcs_recv_byte (struct kcs_hal *pkcs_hal, unsigned char ch_num)
+{
+	u8      Status;
+	u8          DummyByte=0;
+	int         i;
+	u8      Cmd;
+	unsigned long flags;
+	u8     b;
+	KCSBuf_T *pKCSBuffer = &pkcs_hal->pkcs_buf [ch_num];
+	dbgprint ("kcs_recv_byte: ch_num:  %d, kcs_hal addr : %p\n", ch_num, pkcs_hal);
+	dbgprint ("kcs_recv_byte: ch_num:  %d, kcs_buf is : %p\n", ch_num, pKCSBuffer);
+	Status = 0; 
+
+	/* Read the Present Status of KCS Port */
+	pkcs_hal->pkcs_hal_ops->read_kcs_status (ch_num, &Status);
+	
+	dbgprint ("KCS status reg = %x\n", Status);
+	/* If write to command register */
+	if (IS_WRITE_TO_CMD_REG(Status))
+	{
+		dbgprint ("WRITE_TO_CMD reg\n");
+		Cmd = 0;
+
+		/* Set the status to WRITE_STATE */
+		set_kcs_state (pkcs_hal, ch_num, KCS_WRITE_STATE);
+		/* Read the command */
+		pkcs_hal->pkcs_hal_ops->read_kcs_command (ch_num, &Cmd);
+
+		switch (Cmd)
+		{
+			case KCS_WRITE_START :
+				dbgprint ("KCS_WRITE_START\n");
+				/* Set the Index to 0 */
+				pKCSBuffer->KCSRcvPktIx = 0;
+				/* Clearing Abort flag at the start of transaction */
+				pKCSBuffer->PrevCmdAborted = 0;
+				/*! Set the sequence number for validating the response */
+				pKCSBuffer->KCSSeqNo = (pKCSBuffer->KCSSeqNo + 1) % MAX_SEQ_NO;
+				pKCSBuffer->pKCSRcvPkt[pKCSBuffer->KCSRcvPktIx] = pKCSBuffer->KCSSeqNo;
+				pKCSBuffer->KCSRcvPktIx++;
+				/* Set the phase to WRITE */
+				pKCSBuffer->KCSPhase = KCS_PHASE_WRITE;
+
+				break;
+
+			case KCS_WRITE_END :
+				dbgprint ("KCS_WRITE_END\n");
+				/* Set the phase to write end */
+				pKCSBuffer->KCSPhase = KCS_PHASE_WRITE_END;
+				break;
+
+			case KCS_ABORT : 
+				dbgprint ("KCS_ABORT\n");
+				spin_lock_irqsave(&pKCSBuffer->kcs_lock, flags);
+				if (!pKCSBuffer->KcsIFActive && !pKCSBuffer->FirstTime)	/* Don't set if driver has not yet processed a request */
+				{ 
+					/* Set flag to avoid sending response*/ 
+					pKCSBuffer->PrevCmdAborted = 1; 
+				}
+				spin_unlock_irqrestore(&pKCSBuffer->kcs_lock, flags); 
+				/* Set the error code */
+				if (KCS_NO_ERROR == pKCSBuffer->KCSError)
+				{
+					pKCSBuffer->KCSError = KCS_ABORTED_BY_COMMAND;
+				}
+				/* Set the phase to write end */
+				pKCSBuffer->KCSPhase = KCS_PHASE_ABORT;
+				/* Set the abort phase to be error1 */
+				pKCSBuffer->AbortPhase = ABORT_PHASE_ERROR1;
+
+				/* Send the dummy byte  */
+				pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, 0);
+				//SA Set OBF Byte
+				pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
+
+				break;
+
+			default :
+				dbgprint ("wrong value in CMD reg\n");
+				/* Set the error code */
+				pKCSBuffer->KCSError = KCS_ILLEGAL_CONTROL_CODE;
+				/* Invalid command code - Set an error state */
+				set_kcs_state (pkcs_hal, ch_num, KCS_ERROR_STATE);
+				/* Set the phase to error phase */
+				pKCSBuffer->KCSPhase = KCS_PHASE_ERROR;
+				break;
+		}
+	}
+	else
+	{
+		switch (pKCSBuffer->KCSPhase)
+		{
+			case KCS_PHASE_WRITE :
+				dbgprint ("KCS_PHASE_WRITE\n");
+				/* Set the state to write state */
+				set_kcs_state (pkcs_hal, ch_num, KCS_WRITE_STATE);
+				/* Read the BYTE from the data register */
+				pkcs_hal->pkcs_hal_ops->read_kcs_data_in (ch_num, &(pKCSBuffer->pKCSRcvPkt [pKCSBuffer->KCSRcvPktIx]));
+
+				if (pKCSBuffer->KCSRcvPktIx < MAX_KCS_PKT_LEN)
+				{
+					pKCSBuffer->KCSRcvPktIx++;
+				}
+				break;
+
+			case KCS_PHASE_WRITE_END :
+				dbgprint ("KCS_PHASE_WRITE_END\n");
+				/* Set the state to READ_STATE */
+				set_kcs_state (pkcs_hal, ch_num, KCS_READ_STATE);
+
+				/* Read the BYTE from the data register */
+				pkcs_hal->pkcs_hal_ops->read_kcs_data_in (ch_num, &(pKCSBuffer->pKCSRcvPkt [pKCSBuffer->KCSRcvPktIx]));
+
+				pKCSBuffer->KCSRcvPktIx++;
+
+				//SA lets print all data received from SMS
+
+				dbgprint ("Total bytes received 0x%x\n", pKCSBuffer->KCSRcvPktIx );
+				for(i=0;i < pKCSBuffer->KCSRcvPktIx ; i++)
+				{
+					dbgprint("0x%x ", pKCSBuffer->pKCSRcvPkt [i]);
+				}
+				dbgprint ("\npKCSBuffer->KcsIFActive:%x\n",pKCSBuffer->KcsIFActive);
+
+
+				/* Signal receive data ready */
+				/* Move to READ Phase */
+				pKCSBuffer->KCSPhase = KCS_PHASE_READ;
+
+
+				/* SA Wakeup KcsRequest to notify Request Packet is ready*/
+				/* Queue and wakeup only if KCS device is opened and is being used,
+				   readers sleep on KcsReqWait in read() and poll() */
+				spin_lock_irqsave(&pKCSBuffer->kcs_lock, flags); 
+				if ( pKCSBuffer->KcsINuse)
+				{
+					kcs_queue_request (pKCSBuffer);
+					spin_unlock_irqrestore(&pKCSBuffer->kcs_lock, flags); 
+					dbgprint ("Request received successfully\n");
+					Kcs_OsWakeupOnTimeout(&(pKCSBuffer->KcsReqWait));
+				}
+				else {
+					spin_unlock_irqrestore(&pKCSBuffer->kcs_lock, flags); 
+				}
+				break;
+
+			case KCS_PHASE_READ :
+				dbgprint ("KCS_PHASE_READ\n");
+				/* If we have reached the end of the packet move to idle state */
+				if (pKCSBuffer->KCSSendPktIx == pKCSBuffer->KCSSendPktLen)
+				{
+					set_kcs_state (pkcs_hal, ch_num, KCS_IDLE_STATE);
+				}
+				/* Read the byte returned by the SMS */
+				{ 
+					b = 0;
+					pkcs_hal->pkcs_hal_ops->read_kcs_data_in (ch_num, &b); 
+					//SA Need to clear IBF
+					//sa_0111 clear_IBF_status(ch_num);
+
+					if (b != KCS_READ)
+					{
+						set_kcs_state (pkcs_hal, ch_num, KCS_ERROR_STATE);
+						pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, 0);
+						//SA Set OBF Byte
+						pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
+						break;
+					}
+				}
+				/* If we are finished transmitting, send the dummy byte */
+				if (pKCSBuffer->KCSSendPktIx == pKCSBuffer->KCSSendPktLen) 
+				{
+					pKCSBuffer->KCSPhase = KCS_PHASE_IDLE;
+					pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, 0);
+					//SA Set OBF Byte
+					pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
+
+					/* Set Transmission Complete */
+					pKCSBuffer->TxReady     = 1;
+					/* Wakeup Sleeping Process */
+					//if(pKCSBuffer->KcsWtIFActive)
+					//  Kcs_OsWakeupOnTimeout(&(pKCSBuffer->KcsResWait));
+					break;
+				}
+				/* Transmit the next byte from the send buffer */
+				pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, pKCSBuffer->pKCSSendPkt [pKCSBuffer->KCSSendPktIx]);
+				//SA Set OBF Byte
+				pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
+				pKCSBuffer->KCSSendPktIx++;
+				break;
+
+			case KCS_PHASE_ABORT :
+				dbgprint ("KCS_PHASE_ABORT\n");
+				switch (pKCSBuffer->AbortPhase) 
+				{
+					case ABORT_PHASE_ERROR1 :
+						/* Set the KCS State to READ_STATE */
+						set_kcs_state (pkcs_hal, ch_num, KCS_READ_STATE);
+						/* Read the Dummy byte  */
+						pkcs_hal->pkcs_hal_ops->read_kcs_data_in (ch_num, &DummyByte); 
+						//SA Need to clear IBF
+						//sa_0111 clear_IBF_status(ch_num);
+						/* Write the error code to Data out register */
+						pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, pKCSBuffer->KCSError);
+						//SA Set OBF Byte
+						pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
+						/* Set the abort phase to be error2 */
+						pKCSBuffer->AbortPhase = ABORT_PHASE_ERROR2;
+
+						break;
+
+					case ABORT_PHASE_ERROR2 :
+
+						/**
+						 * The system software has read the error code. Go to idle
+						 * state.
+						 **/
+						set_kcs_state (pkcs_hal, ch_num, KCS_IDLE_STATE);
+
+						/* Read the Dummy byte  */
+						pkcs_hal->pkcs_hal_ops->read_kcs_data_in (ch_num, &DummyByte); 
+
+						pKCSBuffer->KCSPhase = KCS_PHASE_IDLE;
+						pKCSBuffer->AbortPhase = 0;
+
+						/* Send the dummy byte  */
+						pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, 0);
+						//SA Set OBF Byte
+						pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
+
+				}
+				break;
+
+			default:
+				dbgprint ("incorrect Phase value\n");
+				/* Read the Dummy byte  */
+				pkcs_hal->pkcs_hal_ops->read_kcs_data_in (ch_num, &DummyByte); 
+				set_kcs_state (pkcs_hal, ch_num, KCS_ERROR_STATE);
+				pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, 0);
+				//SA Set OBF Byte
+				pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
+        }
+    }
+}
@@ -41,6 +41,7 @@
 #include <linux/delay.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
+#include <linux/poll.h>
 #include "kcs.h"
 #include "kcsifc.h"
 #include "driver_hal.h"
@@ -80,22 +81,9 @@ MODULE_LICENSE ( DRIVER_LICENSE );
 #define KCS_DEV_NAME        "kcs"
 
 
-#define IS_IBF_SET(STATUS)     (0 != ((STATUS) & 0x02))
-#define IS_WRITE_TO_CMD_REG(STATUS)    (0 != ((STATUS) & 0x08))
-#define CHK_STATE_IDLE(STATUS)     (0 == ((STATUS) & 0xC0))
-
-#define MAX_SEQ_NO		250		/*< Maximum sequence number and it will repeat again from 0 >*/
-
 unsigned int m_kcs_ch_count = 0;
 int m_dev_id = 1;
 
-struct kcs_hal
-{
-	KCSBuf_T *pkcs_buf;
-	IPMICmdMsg_T* pipmi_cmd_msg;
-	kcs_hal_operations_t *pkcs_hal_ops;
-};
-
 struct kcs_dev
 {
 	struct kcs_hal *pkcs_hal;
@@ -154,6 +142,7 @@ static int kcs_ioctl (struct inode *inode, struct file *filp, unsigned int cmd,
 
 static ssize_t kcs_read (struct file *filp, char __user *buf, size_t count, loff_t *offset);
 static ssize_t kcs_write (struct file *filp, const char __user *buf, size_t count, loff_t *offset);
+static unsigned int kcs_poll (struct file *filp, poll_table *wait);
 
 static int kcs_interrupt_enable(struct kcs_dev *pdev,unsigned long arg);
 static int kcs_interrupt_disable(struct kcs_dev *pdev,unsigned long arg);
@@ -169,12 +158,9 @@ static int read_kcs_data (struct kcs_dev *pdev, unsigned long arg);
 static int write_kcs_data (struct kcs_dev *pdev, unsigned long arg);
 static int Write_kcs_status_data (struct kcs_dev *pdev, unsigned long arg);
 
-static int kcs_request (struct kcs_dev *pdev, char *pbuf);
+static int kcs_request (struct kcs_dev *pdev, char *pbuf, int nonblock);
 static size_t kcs_write_request (struct kcs_dev *pdev, const char* buf, size_t count);
 static void send_kcs_response (struct kcs_dev *pdev);
-static void kcs_recv_byte (struct kcs_hal *pkcs_hal, unsigned char ch_num);
-
-static void set_kcs_state (struct kcs_hal *pkcs_hal, unsigned char ch_num, u8 state_value);
 
 
 extern unsigned int m_kcs_hw_test_enable;
@@ -190,6 +176,7 @@ static struct file_operations kcs_fops = {
         owner:      THIS_MODULE,
         read:       kcs_read,
         write:      kcs_write,
+        poll:       kcs_poll,
 #ifdef USE_UNLOCKED_IOCTL 
         unlocked_ioctl:	kcs_ioctlUnlocked, 
 #else 
@@ -248,7 +235,7 @@ static void __exit kcs_exit(void)
 int
 register_kcs_hal_module (unsigned char num_instances, void *phal_ops, void **phw_data)
 {
-	int i;
+	int i, j;
 	struct kcs_hal *pkcs_hal;
 
 	pkcs_hal = (struct kcs_hal*) kmalloc (sizeof(struct kcs_hal), GFP_KERNEL);
@@ -272,10 +259,26 @@ register_kcs_hal_module (unsigned char num_instances, void *phal_ops, void **phw
 		return -ENOMEM;
 	}
 
+	/* Request queue slots, the first slot of a channel is its Request buffer */
+	pkcs_hal->preq_slots = (u8*) vmalloc (num_instances * (KCS_REQ_QUEUE_LEN - 1) * KCS_REQ_SLOT_SIZE);
+	if (!pkcs_hal->preq_slots)
+	{
+		vfree (pkcs_hal->pipmi_cmd_msg);
+		kfree (pkcs_hal->pkcs_buf);
+		kfree (pkcs_hal);
+		return -ENOMEM;
+	}
+
 	for (i = 0; i < num_instances; ++i)
 	{
 		dbgprint ("%d, kcs_buf addr : %p\n", i, &pkcs_hal->pkcs_buf[i]);						
-		pkcs_hal->pkcs_buf[i].pKCSRcvPkt = pkcs_hal->pipmi_cmd_msg[i].Request;
+		pkcs_hal->pkcs_buf[i].pReqSlot[0] = pkcs_hal->pipmi_cmd_msg[i].Request;
+		for (j = 1; j < KCS_REQ_QUEUE_LEN; ++j)
+			pkcs_hal->pkcs_buf[i].pReqSlot[j] = pkcs_hal->preq_slots + (i * (KCS_REQ_QUEUE_LEN - 1) + j - 1) * KCS_REQ_SLOT_SIZE;
+		kcs_reset_req_queue (&pkcs_hal->pkcs_buf[i]);
+		pkcs_hal->pkcs_buf[i].ReqDropped = 0;
+		/* Initialized here rather than on the first read, poll() may wait on it first */
+		Kcs_OsInitSleepStruct(&(pkcs_hal->pkcs_buf[i].KcsReqWait));
 		pkcs_hal->pkcs_buf[i].KcsWakeup = 0;
 		pkcs_hal->pkcs_buf[i].TxReady = 0;
 		pkcs_hal->pkcs_buf[i].KcsIFActive = 0;
@@ -307,6 +310,7 @@ unregister_kcs_hal_module (void *phw_data)
 
 	dbgprint ("unregister hal addr : %p\n", pkcs_hal);
 
+	vfree (pkcs_hal->preq_slots);
 	vfree (pkcs_hal->pipmi_cmd_msg);
 	kfree (pkcs_hal->pkcs_buf);
 	kfree (pkcs_hal);
@@ -352,11 +356,16 @@ kcs_open(struct inode *inode, struct file *file)
 	
 	if (open_count == 1) // On open descriptors, the initialization would have been done in the first open. Hence skip initialization
 	{
+		unsigned long flags;
+
 		pKCSBuffer->KCSRcvPktIx = 0;
 		pKCSBuffer->KCSSendPktIx = 0;
 		pKCSBuffer->KCSSendPktLen = 0;
 		pKCSBuffer->KCSPhase = KCS_PHASE_IDLE;
+		spin_lock_irqsave(&pKCSBuffer->kcs_lock, flags);
+		kcs_reset_req_queue (pKCSBuffer);
 		pKCSBuffer->KcsINuse = 1;
+		spin_unlock_irqrestore(&pKCSBuffer->kcs_lock, flags);
 	}
 
 	return nonseekable_open (inode, file);	
@@ -757,44 +766,84 @@ kcs_read (struct file *file, char __user *buf, size_t count, loff_t *ppos)
 {
 	struct kcs_dev *pdev = (struct kcs_dev*) file->private_data;
 	dbgprint ("kcs_read: ch num: %d, priv data addr : %p\n", pdev->ch_num, file->private_data);		
-	return kcs_request (pdev, buf);
+	return kcs_request (pdev, buf, file->f_flags & O_NONBLOCK);
 }
 
 int 
-kcs_request (struct kcs_dev *pdev, char *pbuf)
+kcs_request (struct kcs_dev *pdev, char *pbuf, int nonblock)
 {
 	KCSBuf_T *pKCSBuffer = &pdev->pkcs_hal->pkcs_buf [pdev->ch_num];
 	unsigned long flags;
+	u8 *pReq;
+	u32 Len;
+	int ret;
 
 	dbgprint ("kcs_request ch num: %d, kcs_buf addr : %p\n", pdev->ch_num, pKCSBuffer);
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(3,4,11))
 	GlobalKCSBuffer = &pdev->pkcs_hal->pkcs_buf [pdev->ch_num];
 #endif
-	/* Initialize Sleep Structure for the First Time */
-	if (pKCSBuffer->FirstTime)
+	pKCSBuffer->FirstTime = 0;
+
+	spin_lock_irqsave(&pKCSBuffer->kcs_lock, flags);
+	while (0 != kcs_get_request (pKCSBuffer, &pReq, &Len))
 	{
-		Kcs_OsInitSleepStruct(&(pKCSBuffer->KcsReqWait));
-		pKCSBuffer->FirstTime = 0;
+		if (nonblock)
+		{
+			spin_unlock_irqrestore(&pKCSBuffer->kcs_lock, flags);
+			return -EAGAIN;
+		}
+
+		dbgprint ("sleeping in kcs_request for ch num: %d\n", pdev->ch_num);
+		pKCSBuffer->KcsIFActive     = 1;
+		spin_unlock_irqrestore(&pKCSBuffer->kcs_lock, flags);
+
+		Kcs_OsSleepOnTimeout(&(pKCSBuffer->KcsReqWait),&(pKCSBuffer->KcsWakeup),0);
+
+		spin_lock_irqsave(&pKCSBuffer->kcs_lock, flags);
+		pKCSBuffer->KcsIFActive     = 0;
+		if (0 == pKCSBuffer->ReqCount && signal_pending (current))
+		{
+			spin_unlock_irqrestore(&pKCSBuffer->kcs_lock, flags);
+			return -ERESTARTSYS;
+		}
 	}
+	spin_unlock_irqrestore(&pKCSBuffer->kcs_lock, flags);
+
+	dbgprint ("out of sleep in kcs_request for ch num: %d\n", pdev->ch_num);
+
+	/* The slot is not reused until it is put back */
+	ret = Len;
+	if (__copy_to_user( (void *)pbuf, (void *)pReq, Len ))
+		ret = -EFAULT;
+	else
+		log_kcs(pdev->ch_num, Len, pReq);
 
-	dbgprint ("sleeping in kcs_request for ch num: %d\n", pdev->ch_num);
 	spin_lock_irqsave(&pKCSBuffer->kcs_lock, flags);
-	pKCSBuffer->KcsIFActive     = 1;
+	kcs_put_request (pKCSBuffer);
 	spin_unlock_irqrestore(&pKCSBuffer->kcs_lock, flags);
-	
-	Kcs_OsSleepOnTimeout(&(pKCSBuffer->KcsReqWait),&(pKCSBuffer->KcsWakeup),0);
-	
+	return ret;
+}
+
+/**
+ * @brief Readable when a request is queued. Responses are sent from the
+ *        write call without blocking, so the device is always writable.
+ **/
+static unsigned int
+kcs_poll (struct file *file, poll_table *wait)
+{
+	struct kcs_dev *pdev = (struct kcs_dev*) file->private_data;
+	KCSBuf_T *pKCSBuffer = &pdev->pkcs_hal->pkcs_buf [pdev->ch_num];
+	unsigned int mask = POLLOUT | POLLWRNORM;
+	unsigned long flags;
+
+	poll_wait (file, &(pKCSBuffer->KcsReqWait.queue), wait);
+
 	spin_lock_irqsave(&pKCSBuffer->kcs_lock, flags);
-	pKCSBuffer->KcsWakeup       = 0;
-	pKCSBuffer->KcsIFActive     = 0;
+	if (0 != pKCSBuffer->ReqCount)
+		mask |= POLLIN | POLLRDNORM;
 	spin_unlock_irqrestore(&pKCSBuffer->kcs_lock, flags);
 
-	dbgprint ("out of sleep in kcs_request for ch num: %d\n", pdev->ch_num);
-
-	if (__copy_to_user( (void *)pbuf, (void *)pKCSBuffer->pKCSRcvPkt,  pKCSBuffer->KCSRcvPktIx ))
-		return -EFAULT;
-	log_kcs(pdev->ch_num, pKCSBuffer->KCSRcvPktIx, pKCSBuffer->pKCSRcvPkt);
-	return pKCSBuffer->KCSRcvPktIx;
+	return mask;
 }
 
 static ssize_t
@@ -850,51 +899,9 @@ void
 send_kcs_response (struct kcs_dev *pdev)
 {
 	IPMICmdMsg_T *pKCSCmdMsg = &pdev->pkcs_hal->pipmi_cmd_msg [pdev->ch_num];	
-	KCSBuf_T *pKCSBuffer = &pdev->pkcs_hal->pkcs_buf [pdev->ch_num];
-	
-    /* If we are responding to an aborted request skip sending data */ 
-	if (pKCSBuffer->PrevCmdAborted)
-	{
-		pKCSBuffer->PrevCmdAborted = 0;
-		return; 
-	}
 
-	dbgprint ("Sequence Number : %d %d, NetFn : %x, Cmd : %x\n", 
-			pKCSBuffer->KCSSeqNo, pKCSCmdMsg->SessionID, 
-			pKCSCmdMsg->Response[0], pKCSCmdMsg->Response[1]);
-	
-	if (pKCSBuffer->KCSSeqNo != pKCSCmdMsg->SessionID)
-	{
-		//! The response is not belong to the current request, so ignore the response.
-		dbgprint ("Session ID mismatch, so ignoring the response Request : %d, Response : %d\n", 
-				pKCSBuffer->KCSSeqNo, pKCSCmdMsg->SessionID);
-		return;
-	}
-	
-	log_kcs(pdev->ch_num, 	pKCSCmdMsg->ResponseSize, pKCSCmdMsg->Response);
-	
-	/* Update the send buffer and associated indexes */
-	pKCSBuffer->pKCSSendPkt = pKCSCmdMsg->Response;
-	pKCSBuffer->KCSSendPktLen   = pKCSCmdMsg->ResponseSize;
-	pKCSBuffer->KCSSendPktIx   = 0;
-
-	/* Send the first byte */
-	pKCSBuffer->KCSSendPktIx++;
-	pdev->pkcs_hal->pkcs_hal_ops->write_kcs_data_out (pdev->ch_num, pKCSBuffer->pKCSSendPkt[0]);
-	//SA Set OBF Byte
-	pdev->pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (pdev->ch_num);
-
-	/* From now onwords the data is sent from the IBF Interrupt handler */
-	return;
-}
-
-static void 
-set_kcs_state (struct kcs_hal *pkcs_hal, unsigned char ch_num, u8 state_value)
-{
-        u8 status_val = 0;
-        pkcs_hal->pkcs_hal_ops->read_kcs_status (ch_num, &status_val);
-        status_val = ((status_val & (~0xC0)) | (state_value));
-        pkcs_hal->pkcs_hal_ops->write_kcs_status (ch_num, status_val);
+	if (0 == kcs_send_response (pdev->pkcs_hal, pdev->ch_num))
+		log_kcs(pdev->ch_num, 	pKCSCmdMsg->ResponseSize, pKCSCmdMsg->Response);
 }
 
 int 
@@ -920,252 +927,6 @@ is_hw_test_mode ( void )
 		return 0;
 }
 
-void 
-kcs_recv_byte (struct kcs_hal *pkcs_hal, unsigned char ch_num)
-{
-	u8      Status;
-	u8          DummyByte=0;
-	int         i;
-	u8      Cmd;
-	unsigned long flags;
-	u8     b;
-	KCSBuf_T *pKCSBuffer = &pkcs_hal->pkcs_buf [ch_num];
-	dbgprint ("kcs_recv_byte: ch_num:  %d, kcs_hal addr : %p\n", ch_num, pkcs_hal);
-	dbgprint ("kcs_recv_byte: ch_num:  %d, kcs_buf is : %p\n", ch_num, pKCSBuffer);
-	Status = 0; 
-
-	/* Read the Present Status of KCS Port */
-	pkcs_hal->pkcs_hal_ops->read_kcs_status (ch_num, &Status);
-	
-	dbgprint ("KCS status reg = %x\n", Status);
-	/* If write to command register */
-	if (IS_WRITE_TO_CMD_REG(Status))
-	{
-		dbgprint ("WRITE_TO_CMD reg\n");
-		Cmd = 0;
-
-		/* Set the status to WRITE_STATE */
-		set_kcs_state (pkcs_hal, ch_num, KCS_WRITE_STATE);
-		/* Read the command */
-		pkcs_hal->pkcs_hal_ops->read_kcs_command (ch_num, &Cmd);
-
-		switch (Cmd)
-		{
-			case KCS_WRITE_START :
-				dbgprint ("KCS_WRITE_START\n");
-				/* Set the Index to 0 */
-				pKCSBuffer->KCSRcvPktIx = 0;
-				/* Clearing Abort flag at the start of transaction */
-				pKCSBuffer->PrevCmdAborted = 0;
-				/*! Set the sequence number for validating the response */
-				pKCSBuffer->KCSSeqNo = (pKCSBuffer->KCSSeqNo + 1) % MAX_SEQ_NO;
-				pKCSBuffer->pKCSRcvPkt[pKCSBuffer->KCSRcvPktIx] = pKCSBuffer->KCSSeqNo;
-				pKCSBuffer->KCSRcvPktIx++;
-				/* Set the phase to WRITE */
-				pKCSBuffer->KCSPhase = KCS_PHASE_WRITE;
-
-				break;
-
-			case KCS_WRITE_END :
-				dbgprint ("KCS_WRITE_END\n");
-				/* Set the phase to write end */
-				pKCSBuffer->KCSPhase = KCS_PHASE_WRITE_END;
-				break;
-
-			case KCS_ABORT : 
-				dbgprint ("KCS_ABORT\n");
-				spin_lock_irqsave(&pKCSBuffer->kcs_lock, flags);
-				if (!pKCSBuffer->KcsIFActive && !pKCSBuffer->FirstTime)	/* Don't set if driver has not yet processed a request */
-				{ 
-					/* Set flag to avoid sending response*/ 
-					pKCSBuffer->PrevCmdAborted = 1; 
-				}
-				spin_unlock_irqrestore(&pKCSBuffer->kcs_lock, flags); 
-				/* Set the error code */
-				if (KCS_NO_ERROR == pKCSBuffer->KCSError)
-				{
-					pKCSBuffer->KCSError = KCS_ABORTED_BY_COMMAND;
-				}
-				/* Set the phase to write end */
-				pKCSBuffer->KCSPhase = KCS_PHASE_ABORT;
-				/* Set the abort phase to be error1 */
-				pKCSBuffer->AbortPhase = ABORT_PHASE_ERROR1;
-
-				/* Send the dummy byte  */
-				pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, 0);
-				//SA Set OBF Byte
-				pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
-
-				break;
-
-			default :
-				dbgprint ("wrong value in CMD reg\n");
-				/* Set the error code */
-				pKCSBuffer->KCSError = KCS_ILLEGAL_CONTROL_CODE;
-				/* Invalid command code - Set an error state */
-				set_kcs_state (pkcs_hal, ch_num, KCS_ERROR_STATE);
-				/* Set the phase to error phase */
-				pKCSBuffer->KCSPhase = KCS_PHASE_ERROR;
-				break;
-		}
-	}
-	else
-	{
-		switch (pKCSBuffer->KCSPhase)
-		{
-			case KCS_PHASE_WRITE :
-				dbgprint ("KCS_PHASE_WRITE\n");
-				/* Set the state to write state */
-				set_kcs_state (pkcs_hal, ch_num, KCS_WRITE_STATE);
-				/* Read the BYTE from the data register */
-				pkcs_hal->pkcs_hal_ops->read_kcs_data_in (ch_num, &(pKCSBuffer->pKCSRcvPkt [pKCSBuffer->KCSRcvPktIx]));
-
-				if (pKCSBuffer->KCSRcvPktIx < MAX_KCS_PKT_LEN)
-				{
-					pKCSBuffer->KCSRcvPktIx++;
-				}
-				break;
-
-			case KCS_PHASE_WRITE_END :
-				dbgprint ("KCS_PHASE_WRITE_END\n");
-				/* Set the state to READ_STATE */
-				set_kcs_state (pkcs_hal, ch_num, KCS_READ_STATE);
-
-				/* Read the BYTE from the data register */
-				pkcs_hal->pkcs_hal_ops->read_kcs_data_in (ch_num, &(pKCSBuffer->pKCSRcvPkt [pKCSBuffer->KCSRcvPktIx]));
-
-				pKCSBuffer->KCSRcvPktIx++;
-
-				//SA lets print all data received from SMS
-
-				dbgprint ("Total bytes received 0x%x\n", pKCSBuffer->KCSRcvPktIx );
-				for(i=0;i < pKCSBuffer->KCSRcvPktIx ; i++)
-				{
-					dbgprint("0x%x ", pKCSBuffer->pKCSRcvPkt [i]);
-				}
-				dbgprint ("\npKCSBuffer->KcsIFActive:%x\n",pKCSBuffer->KcsIFActive);
-
-
-				/* Signal receive data ready */
-				/* Move to READ Phase */
-				pKCSBuffer->KCSPhase = KCS_PHASE_READ;
-
-
-				/* SA Wakeup KcsRequest to notify Request Packet is ready*/
-				/* Wakeup only if KCS device is opened and is being used */
-				spin_lock_irqsave(&pKCSBuffer->kcs_lock, flags); 
-				if ( pKCSBuffer->KcsINuse)
-					pKCSBuffer->KcsWakeup = 1;
-				if (pKCSBuffer->KcsIFActive)
-				{
-					spin_unlock_irqrestore(&pKCSBuffer->kcs_lock, flags); 
-					dbgprint ("Request received successfully\n");
-					Kcs_OsWakeupOnTimeout(&(pKCSBuffer->KcsReqWait));
-				}
-				else {
-					spin_unlock_irqrestore(&pKCSBuffer->kcs_lock, flags); 
-				}
-				//else some error...
-				break;
-
-			case KCS_PHASE_READ :
-				dbgprint ("KCS_PHASE_READ\n");
-				/* If we have reached the end of the packet move to idle state */
-				if (pKCSBuffer->KCSSendPktIx == pKCSBuffer->KCSSendPktLen)
-				{
-					set_kcs_state (pkcs_hal, ch_num, KCS_IDLE_STATE);
-				}
-				/* Read the byte returned by the SMS */
-				{ 
-					b = 0;
-					pkcs_hal->pkcs_hal_ops->read_kcs_data_in (ch_num, &b); 
-					//SA Need to clear IBF
-					//sa_0111 clear_IBF_status(ch_num);
-
-					if (b != KCS_READ)
-					{
-						set_kcs_state (pkcs_hal, ch_num, KCS_ERROR_STATE);
-						pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, 0);
-						//SA Set OBF Byte
-						pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
-						break;
-					}
-				}
-				/* If we are finished transmitting, send the dummy byte */
-				if (pKCSBuffer->KCSSendPktIx == pKCSBuffer->KCSSendPktLen) 
-				{
-					pKCSBuffer->KCSPhase = KCS_PHASE_IDLE;
-					pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, 0);
-					//SA Set OBF Byte
-					pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
-
-					/* Set Transmission Complete */
-					pKCSBuffer->TxReady     = 1;
-					/* Wakeup Sleeping Process */
-					//if(pKCSBuffer->KcsWtIFActive)
-					//  Kcs_OsWakeupOnTimeout(&(pKCSBuffer->KcsResWait));
-					break;
-				}
-				/* Transmit the next byte from the send buffer */
-				pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, pKCSBuffer->pKCSSendPkt [pKCSBuffer->KCSSendPktIx]);
-				//SA Set OBF Byte
-				pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
-				pKCSBuffer->KCSSendPktIx++;
-				break;
-
-			case KCS_PHASE_ABORT :
-				dbgprint ("KCS_PHASE_ABORT\n");
-				switch (pKCSBuffer->AbortPhase) 
-				{
-					case ABORT_PHASE_ERROR1 :
-						/* Set the KCS State to READ_STATE */
-						set_kcs_state (pkcs_hal, ch_num, KCS_READ_STATE);
-						/* Read the Dummy byte  */
-						pkcs_hal->pkcs_hal_ops->read_kcs_data_in (ch_num, &DummyByte); 
-						//SA Need to clear IBF
-						//sa_0111 clear_IBF_status(ch_num);
-						/* Write the error code to Data out register */
-						pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, pKCSBuffer->KCSError);
-						//SA Set OBF Byte
-						pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
-						/* Set the abort phase to be error2 */
-						pKCSBuffer->AbortPhase = ABORT_PHASE_ERROR2;
-
-						break;
-
-					case ABORT_PHASE_ERROR2 :
-
-						/**
-						 * The system software has read the error code. Go to idle
-						 * state.
-						 **/
-						set_kcs_state (pkcs_hal, ch_num, KCS_IDLE_STATE);
-
-						/* Read the Dummy byte  */
-						pkcs_hal->pkcs_hal_ops->read_kcs_data_in (ch_num, &DummyByte); 
-
-						pKCSBuffer->KCSPhase = KCS_PHASE_IDLE;
-						pKCSBuffer->AbortPhase = 0;
-
-						/* Send the dummy byte  */
-						pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, 0);
-						//SA Set OBF Byte
-						pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
-
-				}
-				break;
-
-			default:
-				dbgprint ("incorrect Phase value\n");
-				/* Read the Dummy byte  */
-				pkcs_hal->pkcs_hal_ops->read_kcs_data_in (ch_num, &DummyByte); 
-				set_kcs_state (pkcs_hal, ch_num, KCS_ERROR_STATE);
-				pkcs_hal->pkcs_hal_ops->write_kcs_data_out (ch_num, 0);
-				//SA Set OBF Byte
-				pkcs_hal->pkcs_hal_ops->kcs_set_obf_status (ch_num);
-        }
-    }
-}
 #ifdef CONFIG_SPX_FEATURE_ENABLE_KCS_LOG
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,4,11))
 	static int kcs_log_proc_read(struct file *file,char __user *buffer, size_t buffer_length,loff_t *offset)
@@ -0,0 +1,27 @@
+/*
+ * Minimal kernel definitions for building kcs_recv.c in userspace with
+ * kcs_sim.c. Interrupts are simulated synchronously from one thread, so
+ * the locks only need to exist.
+ */
+
+#ifndef KCS_SIM_KERNEL_H
+#define KCS_SIM_KERNEL_H
+
+#include <stdio.h>
+#include <string.h>
+
+typedef unsigned char		u8;
+typedef unsigned short		u16;
+typedef unsigned int		u32;
+
+typedef struct { int locked; } spinlock_t;
+typedef struct { int waiters; } wait_queue_head_t;
+struct timer_list { int pending; };
+
+#define spin_lock_irqsave(lock, flags)		do { (flags) = 0; (lock)->locked++; } while (0)
+#define spin_unlock_irqrestore(lock, flags)	do { (void)(flags); (lock)->locked--; } while (0)
+
+#define KERN_INFO
+#define printk		printf
+
+#endif /* KCS_SIM_KERNEL_H */
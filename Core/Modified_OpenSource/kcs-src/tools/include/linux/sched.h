@@ -0,0 +1 @@
+#include "../kcs_sim_kernel.h"
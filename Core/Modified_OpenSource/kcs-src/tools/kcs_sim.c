@@ -0,0 +1,443 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+
+/*
+ * KCS state machine simulator
+ *
+ * Drives kcs_recv_byte() through a simulated HAL. The host side runs the
+ * KCS write/read/abort transfers of the IPMI specification on the status,
+ * data in and data out registers of each channel, raising the IBF
+ * interrupt on every write. The IPMI stack side serves the request queues
+ * of all channels the way a poll() loop on the kcs devices does. Checks
+ * the transfers, the request queue and the abort path, then reports the
+ * driver cost of a request/response round trip.
+ *
+ * Build and run from kcs-src:
+ *   gcc -O2 -Wall -Itools/include -I. tools/kcs_sim.c kcs_recv.c -o kcs_sim
+ *   ./kcs_sim [round trips per test]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "kcs.h"
+
+#define SIM_CHANNELS	4
+
+#define STATUS_OBF	0x01
+#define STATUS_IBF	0x02
+#define STATUS_CD	0x08
+#define STATUS_HW	(STATUS_OBF | STATUS_IBF | STATUS_CD)	/* Only changed by the hardware */
+#define KCS_STATE(STATUS)	((STATUS) & 0xC0)
+
+typedef struct
+{
+	u8	status;
+	u8	idr;		/* Host to BMC */
+	u8	odr;		/* BMC to host */
+} SimRegs_T;
+
+static SimRegs_T regs [SIM_CHANNELS];
+static KCSBuf_T kcs_buf [SIM_CHANNELS];
+static struct kcs_hal hal;
+static unsigned long interrupts;
+static unsigned long wakeups;
+
+#define FAIL(fmt, args...) \
+	do { fprintf (stderr, "FAIL %s:%d: " fmt "\n", __FUNCTION__, __LINE__, ##args); exit (1); } while (0)
+
+/* ----- BMC side of the registers, the HAL operations --------------------- */
+
+static unsigned char sim_num_ch (void) { return SIM_CHANNELS; }
+static void sim_read_status (u8 ch, u8 *status) { *status = regs[ch].status; }
+static void sim_write_status (u8 ch, u8 status) { regs[ch].status = (regs[ch].status & STATUS_HW) | (status & ~STATUS_HW); }
+static void sim_read_data_in (u8 ch, u8 *data) { *data = regs[ch].idr; regs[ch].status &= ~STATUS_IBF; }
+static void sim_write_data_out (u8 ch, u8 data) { regs[ch].odr = data; regs[ch].status |= STATUS_OBF; }
+static void sim_set_obf_status (u8 ch) { (void)ch; }
+
+static kcs_hal_operations_t sim_hal_ops = {
+	.num_kcs_ch = sim_num_ch,
+	.read_kcs_status = sim_read_status,
+	.write_kcs_status = sim_write_status,
+	.read_kcs_command = sim_read_data_in,
+	.read_kcs_data_in = sim_read_data_in,
+	.write_kcs_data_out = sim_write_data_out,
+	.kcs_set_obf_status = sim_set_obf_status
+};
+
+void
+Kcs_OsWakeupOnTimeout (Kcs_OsSleepStruct *Sleep)
+{
+	(void)Sleep;
+	wakeups++;
+}
+
+static void
+sim_init (void)
+{
+	int ch, j;
+
+	memset (regs, 0, sizeof(regs));
+	memset (kcs_buf, 0, sizeof(kcs_buf));
+	hal.pkcs_buf = kcs_buf;
+	hal.pkcs_hal_ops = &sim_hal_ops;
+	if (!hal.pipmi_cmd_msg)
+	{
+		hal.pipmi_cmd_msg = calloc (SIM_CHANNELS, sizeof(IPMICmdMsg_T));
+		hal.preq_slots = calloc (SIM_CHANNELS * (KCS_REQ_QUEUE_LEN - 1), KCS_REQ_SLOT_SIZE);
+		if (!hal.pipmi_cmd_msg || !hal.preq_slots)
+			FAIL ("out of memory");
+	}
+
+	/* As register_kcs_hal_module() and the first kcs_open() */
+	for (ch = 0; ch < SIM_CHANNELS; ch++)
+	{
+		kcs_buf[ch].pReqSlot[0] = hal.pipmi_cmd_msg[ch].Request;
+		for (j = 1; j < KCS_REQ_QUEUE_LEN; ++j)
+			kcs_buf[ch].pReqSlot[j] = hal.preq_slots + (ch * (KCS_REQ_QUEUE_LEN - 1) + j - 1) * KCS_REQ_SLOT_SIZE;
+		kcs_reset_req_queue (&kcs_buf[ch]);
+		kcs_buf[ch].FirstTime = 1;
+		kcs_buf[ch].KcsINuse = 1;
+	}
+}
+
+/* ----- Host side ---------------------------------------------------------- */
+
+static void
+host_write (u8 ch, u8 value, int cmd)
+{
+	if (regs[ch].status & STATUS_IBF)
+		FAIL ("ch %d: IBF set on host write", ch);
+	regs[ch].idr = value;
+	regs[ch].status |= STATUS_IBF;
+	if (cmd)
+		regs[ch].status |= STATUS_CD;
+	else
+		regs[ch].status &= ~STATUS_CD;
+
+	/* IBF interrupt */
+	interrupts++;
+	kcs_recv_byte (&hal, ch);
+	if (regs[ch].status & STATUS_IBF)
+		FAIL ("ch %d: IBF not cleared by the driver", ch);
+}
+
+static u8
+host_read (u8 ch)
+{
+	if (!(regs[ch].status & STATUS_OBF))
+		FAIL ("ch %d: OBF not set on host read", ch);
+	regs[ch].status &= ~STATUS_OBF;
+	return regs[ch].odr;
+}
+
+static void
+host_expect_state (u8 ch, u8 state)
+{
+	if (KCS_STATE(regs[ch].status) != state)
+		FAIL ("ch %d: state 0x%02x, expected 0x%02x", ch, KCS_STATE(regs[ch].status), state);
+}
+
+static void
+host_send_request (u8 ch, const u8 *req, u32 len)
+{
+	u32 i;
+
+	regs[ch].status &= ~STATUS_OBF;
+	host_write (ch, KCS_WRITE_START, 1);
+	host_expect_state (ch, KCS_WRITE_STATE);
+	for (i = 0; i < len - 1; i++)
+	{
+		regs[ch].status &= ~STATUS_OBF;
+		host_write (ch, req[i], 0);
+		host_expect_state (ch, KCS_WRITE_STATE);
+	}
+	regs[ch].status &= ~STATUS_OBF;
+	host_write (ch, KCS_WRITE_END, 1);
+	host_expect_state (ch, KCS_WRITE_STATE);
+	regs[ch].status &= ~STATUS_OBF;
+	host_write (ch, req[len - 1], 0);
+	host_expect_state (ch, KCS_READ_STATE);
+}
+
+static u32
+host_recv_response (u8 ch, u8 *rsp, u32 max)
+{
+	u32 n = 0;
+	u8 b;
+
+	while (KCS_STATE(regs[ch].status) == KCS_READ_STATE)
+	{
+		b = host_read (ch);
+		if (n < max)
+			rsp[n++] = b;
+		host_write (ch, KCS_READ, 0);
+	}
+	host_expect_state (ch, KCS_IDLE_STATE);
+	host_read (ch);		/* Dummy byte */
+	return n;
+}
+
+static u8
+host_abort (u8 ch)
+{
+	u8 error;
+
+	host_write (ch, KCS_ABORT, 1);
+	regs[ch].status &= ~STATUS_OBF;
+	host_write (ch, 0x00, 0);
+	host_expect_state (ch, KCS_READ_STATE);
+	error = host_read (ch);
+	host_write (ch, KCS_READ, 0);
+	host_expect_state (ch, KCS_IDLE_STATE);
+	host_read (ch);		/* Dummy byte */
+	return error;
+}
+
+/* ----- IPMI stack side ---------------------------------------------------- */
+
+/*
+ * Serve the oldest request of a channel the way kcs_read() and kcs_write()
+ * do: copy it out, answer with NetFn + 1, Cmd, completion code 0 and the
+ * request data, prefixed by the sequence number of the request.
+ * @return 1 if a request was served, 0 if the queue is empty.
+ */
+static int
+stack_serve (u8 ch)
+{
+	IPMICmdMsg_T *msg = &hal.pipmi_cmd_msg [ch];
+	static u8 req [KCS_REQ_SLOT_SIZE];
+	unsigned long flags;
+	u8 *pReq;
+	u32 len;
+
+	kcs_buf[ch].FirstTime = 0;
+	spin_lock_irqsave(&kcs_buf[ch].kcs_lock, flags);
+	if (0 != kcs_get_request (&kcs_buf[ch], &pReq, &len))
+	{
+		spin_unlock_irqrestore(&kcs_buf[ch].kcs_lock, flags);
+		return 0;
+	}
+	spin_unlock_irqrestore(&kcs_buf[ch].kcs_lock, flags);
+	memcpy (req, pReq, len);
+	spin_lock_irqsave(&kcs_buf[ch].kcs_lock, flags);
+	kcs_put_request (&kcs_buf[ch]);
+	spin_unlock_irqrestore(&kcs_buf[ch].kcs_lock, flags);
+
+	if (len < 3)
+		FAIL ("ch %d: short request, %u bytes", ch, len);
+	msg->SessionID = req[0];
+	msg->Response[0] = req[1] + 0x04;
+	msg->Response[1] = req[2];
+	msg->Response[2] = CC_NORMAL;
+	memcpy (&msg->Response[3], &req[3], len - 3);
+	msg->ResponseSize = len;
+	kcs_send_response (&hal, ch);
+	return 1;
+}
+
+/* ----- Tests -------------------------------------------------------------- */
+
+static u8 req_buf [MAX_KCS_PKT_LEN];
+static u8 rsp_buf [MAX_KCS_PKT_LEN];
+
+static u32
+make_request (u8 *req, u32 len, u8 tag)
+{
+	u32 i;
+
+	req[0] = 0x18;		/* NetFn App */
+	req[1] = tag;
+	for (i = 2; i < len; i++)
+		req[i] = (u8)(tag + i);
+	return len;
+}
+
+static void
+check_response (u8 ch, const u8 *req, u32 len)
+{
+	u32 n = host_recv_response (ch, rsp_buf, sizeof(rsp_buf));
+
+	if (n != len + 1 || rsp_buf[0] != req[0] + 0x04 || rsp_buf[1] != req[1] ||
+	    rsp_buf[2] != CC_NORMAL || memcmp (&rsp_buf[3], &req[2], len - 2) != 0)
+		FAIL ("ch %d: bad response to request %02x, %u bytes", ch, req[1], n);
+}
+
+static void
+test_round_trip (void)
+{
+	static const u32 sizes[] = { 2, 3, 32, 255, 4096, MAX_KCS_PKT_LEN - 1 };
+	u32 i, len;
+	u8 ch;
+
+	sim_init ();
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		for (ch = 0; ch < SIM_CHANNELS; ch++)
+		{
+			len = make_request (req_buf, sizes[i], (u8)(i + ch));
+			host_send_request (ch, req_buf, len);
+			if (stack_serve (ch) != 1 || stack_serve (ch) != 0)
+				FAIL ("ch %d: expected exactly one request", ch);
+			check_response (ch, req_buf, len);
+		}
+	}
+	printf ("round trip on %d channels               OK\n", SIM_CHANNELS);
+}
+
+static void
+test_multiplex (void)
+{
+	static u8 reqs [SIM_CHANNELS][64];
+	int served;
+	u8 ch;
+
+	sim_init ();
+	/* A request in flight on every channel before the stack wakes up */
+	for (ch = 0; ch < SIM_CHANNELS; ch++)
+	{
+		make_request (reqs[ch], sizeof(reqs[ch]), 0x40 + ch);
+		host_send_request (ch, reqs[ch], sizeof(reqs[ch]));
+	}
+	served = 0;
+	for (ch = 0; ch < SIM_CHANNELS; ch++)
+		served += stack_serve (ch);
+	if (served != SIM_CHANNELS)
+		FAIL ("served %d requests", served);
+	for (ch = 0; ch < SIM_CHANNELS; ch++)
+		check_response (ch, reqs[ch], sizeof(reqs[ch]));
+	printf ("requests on all channels, one pass     OK\n");
+}
+
+static void
+test_queue (void)
+{
+	static u8 reqs [KCS_REQ_QUEUE_LEN + 1][16];
+	int i;
+
+	/* The host gives up on A and sends B before the stack has read A */
+	sim_init ();
+	make_request (reqs[0], 16, 0xA0);
+	make_request (reqs[1], 16, 0xB0);
+	host_send_request (0, reqs[0], 16);
+	host_send_request (0, reqs[1], 16);
+	if (kcs_buf[0].ReqCount != 2)
+		FAIL ("%d requests queued, expected 2", kcs_buf[0].ReqCount);
+	stack_serve (0);
+	if (regs[0].status & STATUS_OBF)
+		FAIL ("response to the stale request sent");
+	stack_serve (0);
+	check_response (0, reqs[1], 16);
+	printf ("request queued behind a stale one      OK\n");
+
+	/* More requests than slots, the oldest are dropped */
+	sim_init ();
+	for (i = 0; i <= KCS_REQ_QUEUE_LEN; i++)
+	{
+		make_request (reqs[i], 16, 0xC0 + i);
+		host_send_request (0, reqs[i], 16);
+	}
+	if (kcs_buf[0].ReqCount != KCS_REQ_QUEUE_LEN - 1 || kcs_buf[0].ReqDropped != 2)
+		FAIL ("%d queued, %u dropped", kcs_buf[0].ReqCount, kcs_buf[0].ReqDropped);
+	for (i = 0; i < KCS_REQ_QUEUE_LEN - 2; i++)
+	{
+		stack_serve (0);
+		if (regs[0].status & STATUS_OBF)
+			FAIL ("response to a stale request sent");
+	}
+	stack_serve (0);
+	check_response (0, reqs[KCS_REQ_QUEUE_LEN], 16);
+	printf ("full queue drops the oldest requests   OK\n");
+}
+
+static void
+test_abort (void)
+{
+	u8 error;
+
+	sim_init ();
+	make_request (req_buf, 8, 0xD0);
+	host_send_request (1, req_buf, 8);
+	stack_serve (1);
+	check_response (1, req_buf, 8);
+
+	/* Abort while the stack is processing the next request */
+	make_request (req_buf, 8, 0xD1);
+	host_send_request (1, req_buf, 8);
+	error = host_abort (1);
+	if (error != KCS_ABORTED_BY_COMMAND)
+		FAIL ("abort status 0x%02x", error);
+	stack_serve (1);
+	if (regs[1].status & STATUS_OBF)
+		FAIL ("response to the aborted request sent");
+
+	make_request (req_buf, 8, 0xD2);
+	host_send_request (1, req_buf, 8);
+	stack_serve (1);
+	check_response (1, req_buf, 8);
+	printf ("abort                                  OK\n");
+}
+
+static double
+now_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void
+bench (long count)
+{
+	static const u32 sizes[] = { 2, 32, 1024 };
+	double start, ns;
+	unsigned long irqs;
+	u32 i, len;
+	long n;
+	u8 ch;
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		sim_init ();
+		len = make_request (req_buf, sizes[i], 0x01);
+		irqs = interrupts;
+		start = now_ns ();
+		for (n = 0; n < count; n++)
+		{
+			ch = (u8)(n % SIM_CHANNELS);
+			host_send_request (ch, req_buf, len);
+			stack_serve (ch);
+			host_recv_response (ch, rsp_buf, sizeof(rsp_buf));
+		}
+		ns = now_ns () - start;
+		printf ("%5u byte requests: %8.0f ns per round trip, %6.1f ns per interrupt\n",
+			len, ns / count, ns / (interrupts - irqs));
+	}
+}
+
+int
+main (int argc, char *argv[])
+{
+	long count = argc > 1 ? atol (argv[1]) : 100000;
+
+	test_round_trip ();
+	test_multiplex ();
+	test_queue ();
+	test_abort ();
+	bench (count);
+	printf ("%lu interrupts, %lu wakeups\n", interrupts, wakeups);
+	return 0;
+}
@@ -66,8 +66,10 @@
 #define DEFAULT_DECODE_MAX_DEPTH 1000
 #define DEFAULT_ENCODE_INVALID_NUMBERS 0
 #define DEFAULT_DECODE_INVALID_NUMBERS 1
+#define DEFAULT_DECODE_LAZY 0
 #define DEFAULT_ENCODE_KEEP_BUFFER 1
 #define DEFAULT_ENCODE_NUMBER_PRECISION 14
+#define DEFAULT_ENCODE_STREAM_CHUNK 8192
 
 #ifdef DISABLE_INVALID_NUMBERS
 #undef DEFAULT_DECODE_INVALID_NUMBERS
@@ -125,18 +127,35 @@ typedef struct {
     int encode_number_precision;
     int encode_keep_buffer;
 
+    /* Only set while encode_stream() is running: Lua stack index of the
+     * writer function (0 if none) and the size of chunks passed to it */
+    int encode_writer;
+    int encode_chunk_size;
+
     int decode_invalid_numbers;
     int decode_max_depth;
+    int decode_lazy;
 } json_config_t;
 
 typedef struct {
     const char *data;
     const char *ptr;
+    const char *end;  /* data + length, *end is always '\0' */
     strbuf_t *tmp;    /* Temporary storage for strings */
     json_config_t *cfg;
     int current_depth;
+    int lazy;         /* Return nested objects as lazy proxies */
+    int doc_index;    /* Lua stack index of the JSON text */
 } json_parse_t;
 
+/* Lazy decoding returns nested objects as empty proxy tables sharing the
+ * metatable held in upvalue 2 of the module functions. The metatable
+ * maps each proxy to the JSON text it came from (JSON_LAZY_DOC) and to
+ * the offset of the object in it (JSON_LAZY_POS) through weak keyed
+ * tables. The object is decoded into the proxy on first access. */
+#define JSON_LAZY_DOC   1
+#define JSON_LAZY_POS   2
+
 typedef struct {
     json_token_type_t type;
     int index;
@@ -356,6 +375,14 @@ static int json_cfg_decode_invalid_numbers(lua_State *l)
     return 1;
 }
 
+/* Configures whether nested objects are decoded on first access */
+static int json_cfg_decode_lazy(lua_State *l)
+{
+    json_config_t *cfg = json_arg_init(l, 1);
+
+    return json_enum_option(l, 1, &cfg->decode_lazy, NULL, 1);
+}
+
 static int json_destroy_config(lua_State *l)
 {
     json_config_t *cfg;
@@ -388,8 +415,11 @@ static void json_create_config(lua_State *l)
     cfg->decode_max_depth = DEFAULT_DECODE_MAX_DEPTH;
     cfg->encode_invalid_numbers = DEFAULT_ENCODE_INVALID_NUMBERS;
     cfg->decode_invalid_numbers = DEFAULT_DECODE_INVALID_NUMBERS;
+    cfg->decode_lazy = DEFAULT_DECODE_LAZY;
     cfg->encode_keep_buffer = DEFAULT_ENCODE_KEEP_BUFFER;
     cfg->encode_number_precision = DEFAULT_ENCODE_NUMBER_PRECISION;
+    cfg->encode_writer = 0;
+    cfg->encode_chunk_size = DEFAULT_ENCODE_STREAM_CHUNK;
 
 #if DEFAULT_ENCODE_KEEP_BUFFER > 0
     strbuf_init(&cfg->encode_buf, 0);
@@ -452,6 +482,35 @@ static void json_encode_exception(lua_State *l, json_config_t *cfg, strbuf_t *js
                   lua_typename(l, lua_type(l, lindex)), reason);
 }
 
+/* Word-at-a-time tests used to skip over bytes which don't need escaping.
+ * Only used to decide whether any byte in a word matches; the exact
+ * position is found with char2escape. */
+#define JSON_WORD_ONES          ((unsigned long)-1 / 0xff)
+#define JSON_WORD_HIGHS         (JSON_WORD_ONES * 0x80)
+#define JSON_WORD_HASLESS(w, n) (((w) - JSON_WORD_ONES * (n)) & ~(w) & JSON_WORD_HIGHS)
+#define JSON_WORD_HASBYTE(w, c) JSON_WORD_HASLESS((w) ^ (JSON_WORD_ONES * (c)), 1)
+
+/* Returns the number of leading bytes in str which can be copied
+ * verbatim, ie. the length of the run before the first byte with a
+ * char2escape entry (control characters, '"', '/', '\\' and DEL). */
+static size_t json_escape_free_len(const char *str, size_t len)
+{
+    unsigned long w;
+    size_t i = 0;
+
+    for (; i + sizeof(w) <= len; i += sizeof(w)) {
+        memcpy(&w, str + i, sizeof(w));
+        if (JSON_WORD_HASLESS(w, 0x20) | JSON_WORD_HASBYTE(w, '"') |
+            JSON_WORD_HASBYTE(w, '/') | JSON_WORD_HASBYTE(w, '\\') |
+            JSON_WORD_HASBYTE(w, 0x7f))
+            break;
+    }
+    while (i < len && !char2escape[(unsigned char)str[i]])
+        i++;
+
+    return i;
+}
+
 /* json_append_string args:
  * - lua_State
  * - JSON strbuf
@@ -461,7 +520,7 @@ static void json_encode_exception(lua_State *l, json_config_t *cfg, strbuf_t *js
 static void json_append_string(lua_State *l, strbuf_t *json, int lindex)
 {
     const char *escstr;
-    int i;
+    size_t i, run;
     const char *str;
     size_t len;
 
@@ -475,11 +534,16 @@ static void json_append_string(lua_State *l, strbuf_t *json, int lindex)
 
     strbuf_append_char_unsafe(json, '\"');
     for (i = 0; i < len; i++) {
+        /* Copy runs of safe bytes in bulk */
+        run = json_escape_free_len(str + i, len - i);
+        strbuf_append_mem_unsafe(json, str + i, run);
+        i += run;
+        if (i == len)
+            break;
+
+        /* Escapes are either "\\c" or "\\uXXXX" */
         escstr = char2escape[(unsigned char)str[i]];
-        if (escstr)
-            strbuf_append_string(json, escstr);
-        else
-            strbuf_append_char_unsafe(json, str[i]);
+        strbuf_append_mem_unsafe(json, escstr, escstr[1] == 'u' ? 6 : 2);
     }
     strbuf_append_char_unsafe(json, '\"');
 }
@@ -554,8 +618,66 @@ static void json_check_encode_depth(lua_State *l, json_config_t *cfg,
                current_depth);
 }
 
+/* Pass the JSON text encoded so far to the encode_stream() writer once a
+ * chunk has accumulated (or unconditionally when "force" is set). The
+ * buffer is reset so encoding continues into the same memory. */
+static void json_encode_flush(lua_State *l, json_config_t *cfg,
+                              strbuf_t *json, int force)
+{
+    int writer = cfg->encode_writer;
+    int err;
+
+    if (!writer || strbuf_length(json) == 0 ||
+        (!force && strbuf_length(json) < cfg->encode_chunk_size))
+        return;
+
+    /* Stack slots were reserved by json_check_encode_depth() */
+    lua_pushvalue(l, writer);
+    lua_pushlstring(l, json->buf, json->length);
+    strbuf_reset(json);
+
+    /* The writer may encode with this module itself (reusing the same
+     * persistent buffer), so detach it for the duration of the call */
+    cfg->encode_writer = 0;
+    err = lua_pcall(l, 1, 0, 0);
+    strbuf_reset(json);
+    if (err) {
+        if (!cfg->encode_keep_buffer)
+            strbuf_free(json);
+        lua_error(l);
+    }
+    cfg->encode_writer = writer;
+}
+
 static void json_append_data(lua_State *l, json_config_t *cfg,
                              int current_depth, strbuf_t *json);
+static int json_materialize(lua_State *l);
+
+/* Decode the table at the top of the stack first if it is a decode_lazy
+ * proxy. Parse errors are rethrown once the buffer has been released. */
+static void json_encode_materialize(lua_State *l, json_config_t *cfg,
+                                    strbuf_t *json)
+{
+    int lazy;
+
+    if (!lua_getmetatable(l, -1))
+        return;
+    lazy = lua_rawequal(l, -1, lua_upvalueindex(2));
+    lua_pop(l, 1);
+    if (!lazy)
+        return;
+
+    /* Stack slots were reserved by json_check_encode_depth() */
+    lua_pushvalue(l, lua_upvalueindex(1));
+    lua_pushvalue(l, lua_upvalueindex(2));
+    lua_pushcclosure(l, json_materialize, 2);
+    lua_pushvalue(l, -2);
+    if (lua_pcall(l, 1, 0, 0)) {
+        if (!cfg->encode_keep_buffer)
+            strbuf_free(json);
+        lua_error(l);
+    }
+}
 
 /* json_append_array args:
  * - lua_State
@@ -578,6 +700,9 @@ static void json_append_array(lua_State *l, json_config_t *cfg, int current_dept
         lua_rawgeti(l, -1, i);
         json_append_data(l, cfg, current_depth, json);
         lua_pop(l, 1);
+
+        if (cfg->encode_writer)
+            json_encode_flush(l, cfg, json, 0);
     }
 
     strbuf_append_char(json, ']');
@@ -649,6 +774,9 @@ static void json_append_object(lua_State *l, json_config_t *cfg,
         json_append_data(l, cfg, current_depth, json);
         lua_pop(l, 1);
         /* table, key */
+
+        if (cfg->encode_writer)
+            json_encode_flush(l, cfg, json, 0);
     }
 
     strbuf_append_char(json, '}');
@@ -676,6 +804,7 @@ static void json_append_data(lua_State *l, json_config_t *cfg,
     case LUA_TTABLE:
         current_depth++;
         json_check_encode_depth(l, cfg, current_depth, json);
+        json_encode_materialize(l, cfg, json);
         len = lua_array_length(l, cfg, json);
         if (len > 0)
             json_append_array(l, cfg, current_depth, json, len);
@@ -718,6 +847,9 @@ static int json_encode(lua_State *l)
         strbuf_reset(encode_buf);
     }
 
+    /* Not streaming (an earlier encode_stream() may have thrown) */
+    cfg->encode_writer = 0;
+
     json_append_data(l, cfg, 0, encode_buf);
     json = strbuf_string(encode_buf, &len);
 
@@ -729,6 +861,52 @@ static int json_encode(lua_State *l)
     return 1;
 }
 
+/* encode_stream(value, writer[, chunk_size])
+ *
+ * Serialise Lua data into JSON, calling writer(text) with pieces of
+ * roughly chunk_size bytes instead of returning a single string. Large
+ * documents are never held in memory as a whole. */
+static int json_encode_stream(lua_State *l)
+{
+    json_config_t *cfg = json_fetch_config(l);
+    strbuf_t local_encode_buf;
+    strbuf_t *encode_buf;
+    int chunk_size;
+
+    luaL_argcheck(l, lua_gettop(l) >= 2 && lua_gettop(l) <= 3, 1,
+                  "expected 2 or 3 arguments");
+    luaL_checktype(l, 2, LUA_TFUNCTION);
+    chunk_size = luaL_optinteger(l, 3, DEFAULT_ENCODE_STREAM_CHUNK);
+    luaL_argcheck(l, chunk_size > 0, 3, "expected a positive chunk size");
+
+    /* value, writer, value */
+    lua_settop(l, 2);
+    lua_pushvalue(l, 1);
+
+    if (!cfg->encode_keep_buffer) {
+        /* Use private buffer */
+        encode_buf = &local_encode_buf;
+        strbuf_init(encode_buf, chunk_size);
+    } else {
+        /* Reuse existing buffer */
+        encode_buf = &cfg->encode_buf;
+        strbuf_reset(encode_buf);
+    }
+
+    cfg->encode_writer = 2;
+    cfg->encode_chunk_size = chunk_size;
+
+    json_append_data(l, cfg, 0, encode_buf);
+    json_encode_flush(l, cfg, encode_buf, 1);
+
+    cfg->encode_writer = 0;
+
+    if (!cfg->encode_keep_buffer)
+        strbuf_free(encode_buf);
+
+    return 0;
+}
+
 /* ===== DECODING ===== */
 
 static void json_process_value(lua_State *l, json_parse_t *json,
@@ -880,9 +1058,51 @@ static void json_set_token_error(json_token_t *token, json_parse_t *json,
     token->value.string = errtype;
 }
 
+/* Returns the number of leading bytes in str before the first '"', '\\'
+ * or '\0', ie. the part of a string token which needs no decoding.
+ * end must point at the '\0' terminating the JSON text. */
+static size_t json_string_run_len(const char *str, const char *end)
+{
+    const char *p = str;
+    unsigned long w;
+
+    for (; p + sizeof(w) <= end; p += sizeof(w)) {
+        memcpy(&w, p, sizeof(w));
+        if (JSON_WORD_HASBYTE(w, '"') | JSON_WORD_HASBYTE(w, '\\') |
+            JSON_WORD_HASLESS(w, 1))
+            break;
+    }
+    while (*p && *p != '"' && *p != '\\')
+        p++;
+
+    return p - str;
+}
+
+/* Returns the number of leading bytes in str before the first '{', '}',
+ * '[', ']', '"' or '\0'. Setting bit 5 maps '[' and ']' onto '{' and
+ * '}' (and no other byte onto them), so a word needs 4 tests. */
+static size_t json_structural_run_len(const char *str, const char *end)
+{
+    const char *p = str;
+    unsigned long w, b;
+
+    for (; p + sizeof(w) <= end; p += sizeof(w)) {
+        memcpy(&w, p, sizeof(w));
+        b = w | JSON_WORD_ONES * 0x20;
+        if (JSON_WORD_HASBYTE(b, '{') | JSON_WORD_HASBYTE(b, '}') |
+            JSON_WORD_HASBYTE(w, '"') | JSON_WORD_HASLESS(w, 1))
+            break;
+    }
+    while (*p && *p != '"' && (*p | 0x20) != '{' && (*p | 0x20) != '}')
+        p++;
+
+    return p - str;
+}
+
 static void json_next_string_token(json_parse_t *json, json_token_t *token)
 {
     char *escape2char = json->cfg->escape2char;
+    size_t run;
     char ch;
 
     /* Caller must ensure a string is next */
@@ -891,46 +1111,57 @@ static void json_next_string_token(json_parse_t *json, json_token_t *token)
     /* Skip " */
     json->ptr++;
 
+    /* Strings without escapes are returned in place */
+    run = json_string_run_len(json->ptr, json->end);
+    if (json->ptr[run] == '"') {
+        token->type = T_STRING;
+        token->value.string = json->ptr;
+        token->string_len = run;
+        json->ptr += run + 1;
+        return;
+    }
+
     /* json->tmp is the temporary strbuf used to accumulate the
      * decoded string value.
      * json->tmp is sized to handle JSON containing only a string value.
      */
     strbuf_reset(json->tmp);
 
-    while ((ch = *json->ptr) != '"') {
+    while (1) {
+        strbuf_append_mem_unsafe(json->tmp, json->ptr, run);
+        json->ptr += run;
+
+        ch = *json->ptr;
+        if (ch == '"')
+            break;
+
         if (!ch) {
             /* Premature end of the string */
             json_set_token_error(token, json, "unexpected end of string");
             return;
         }
 
-        /* Handle escapes */
-        if (ch == '\\') {
-            /* Fetch escape character */
-            ch = *(json->ptr + 1);
-
-            /* Translate escape code and append to tmp string */
-            ch = escape2char[(unsigned char)ch];
-            if (ch == 'u') {
-                if (json_append_unicode_escape(json) == 0)
-                    continue;
+        /* Handle escapes: fetch escape character */
+        ch = *(json->ptr + 1);
 
+        /* Translate escape code and append to tmp string */
+        ch = escape2char[(unsigned char)ch];
+        if (ch == 'u') {
+            if (json_append_unicode_escape(json)) {
                 json_set_token_error(token, json,
                                      "invalid unicode escape code");
                 return;
             }
-            if (!ch) {
-                json_set_token_error(token, json, "invalid escape code");
-                return;
-            }
-
-            /* Skip '\' */
-            json->ptr++;
+        } else if (!ch) {
+            json_set_token_error(token, json, "invalid escape code");
+            return;
+        } else {
+            /* Append translated single character, skip the escape */
+            strbuf_append_char_unsafe(json->tmp, ch);
+            json->ptr += 2;
         }
-        /* Append normal character or translated single character
-         * Unicode escapes are handled above */
-        strbuf_append_char_unsafe(json->tmp, ch);
-        json->ptr++;
+
+        run = json_string_run_len(json->ptr, json->end);
     }
     json->ptr++;    /* Eat final quote (") */
 
@@ -993,9 +1224,27 @@ static int json_is_invalid_number(json_parse_t *json)
 
 static void json_next_number_token(json_parse_t *json, json_token_t *token)
 {
+    const char *p = json->ptr;
     char *endptr;
+    double value = 0;
+    int digits;
 
     token->type = T_NUMBER;
+
+    /* Integers of up to 15 digits are exact as doubles and are by far
+     * the most common numbers: convert those without fpconv_strtod() */
+    if (*p == '-')
+        p++;
+    for (digits = 0; digits <= 15 && '0' <= p[digits] && p[digits] <= '9';
+         digits++)
+        value = value * 10 + (p[digits] - '0');
+    if (digits > 0 && digits <= 15 && p[digits] != '.' &&
+        (p[digits] | 0x20) != 'e' && (p[digits] | 0x20) != 'x') {
+        token->value.number = *json->ptr == '-' ? -value : value;
+        json->ptr = p + digits;
+        return;
+    }
+
     token->value.number = fpconv_strtod(json->ptr, &endptr);
     if (json->ptr == endptr)
         json_set_token_error(token, json, "invalid number");
@@ -1130,16 +1379,12 @@ static void json_decode_descend(lua_State *l, json_parse_t *json, int slots)
         json->current_depth, json->ptr - json->data);
 }
 
-static void json_parse_object_context(lua_State *l, json_parse_t *json)
+/* Decode the members of the object whose '{' was just consumed into the
+ * table at the top of the stack. The caller has already descended. */
+static void json_parse_object_members(lua_State *l, json_parse_t *json)
 {
     json_token_t token;
 
-    /* 3 slots required:
-     * .., table, key, value */
-    json_decode_descend(l, json, 3);
-
-    lua_newtable(l);
-
     json_next_token(json, &token);
 
     /* Handle empty objects */
@@ -1180,6 +1425,17 @@ static void json_parse_object_context(lua_State *l, json_parse_t *json)
     }
 }
 
+static void json_parse_object_context(lua_State *l, json_parse_t *json)
+{
+    /* 3 slots required:
+     * .., table, key, value */
+    json_decode_descend(l, json, 3);
+
+    lua_newtable(l);
+
+    json_parse_object_members(l, json);
+}
+
 /* Handle the array context */
 static void json_parse_array_context(lua_State *l, json_parse_t *json)
 {
@@ -1218,6 +1474,79 @@ static void json_parse_array_context(lua_State *l, json_parse_t *json)
     }
 }
 
+/* Move json->ptr past the object whose '{' was just consumed without
+ * decoding it. Only strings and nesting are tracked (including the
+ * decode_max_depth limit); syntax errors inside the object are reported
+ * once it is materialised. */
+static void json_skip_object(lua_State *l, json_parse_t *json)
+{
+    int depth = json->current_depth;
+    json_token_t token;
+
+    while (json->current_depth >= depth) {
+        json->ptr += json_structural_run_len(json->ptr, json->end);
+        switch (*json->ptr) {
+        case '\0':
+            token.type = T_END;
+            token.index = json->ptr - json->data;
+            json_throw_parse_error(l, json, "object end", &token);
+            break;
+        case '"':
+            /* Skip the string, stepping over escaped characters */
+            json->ptr++;
+            while (1) {
+                json->ptr += json_string_run_len(json->ptr, json->end);
+                if (*json->ptr == '"')
+                    break;
+                if (!*json->ptr || !*(json->ptr + 1)) {
+                    json_set_token_error(&token, json,
+                                         "unexpected end of string");
+                    json_throw_parse_error(l, json, "object end", &token);
+                }
+                json->ptr += 2;
+            }
+            break;
+        case '{':
+        case '[':
+            json->ptr++;
+            json_decode_descend(l, json, 0);
+            continue;
+        case '}':
+        case ']':
+            json_decode_ascend(json);
+            break;
+        }
+        json->ptr++;
+    }
+}
+
+/* Push an empty proxy table standing in for the object whose '{' is at
+ * token->index. It is decoded by json_lazy_materialize() on first use. */
+static void json_lazy_object(lua_State *l, json_parse_t *json,
+                             json_token_t *token)
+{
+    /* 4 slots required:
+     * .., proxy, weak table, proxy, value */
+    json_decode_descend(l, json, 4);
+    json_skip_object(l, json);
+
+    lua_newtable(l);
+    lua_pushvalue(l, lua_upvalueindex(2));
+    lua_setmetatable(l, -2);
+
+    lua_rawgeti(l, lua_upvalueindex(2), JSON_LAZY_DOC);
+    lua_pushvalue(l, -2);
+    lua_pushvalue(l, json->doc_index);
+    lua_rawset(l, -3);
+    lua_pop(l, 1);
+
+    lua_rawgeti(l, lua_upvalueindex(2), JSON_LAZY_POS);
+    lua_pushvalue(l, -2);
+    lua_pushinteger(l, token->index);
+    lua_rawset(l, -3);
+    lua_pop(l, 1);
+}
+
 /* Handle the "value" context */
 static void json_process_value(lua_State *l, json_parse_t *json,
                                json_token_t *token)
@@ -1233,7 +1562,11 @@ static void json_process_value(lua_State *l, json_parse_t *json,
         lua_pushboolean(l, token->value.boolean);
         break;;
     case T_OBJ_BEGIN:
-        json_parse_object_context(l, json);
+        /* The top level object is always decoded */
+        if (json->lazy && json->current_depth > 0)
+            json_lazy_object(l, json, token);
+        else
+            json_parse_object_context(l, json);
         break;;
     case T_ARR_BEGIN:
         json_parse_array_context(l, json);
@@ -1258,8 +1591,11 @@ static int json_decode(lua_State *l)
 
     json.cfg = json_fetch_config(l);
     json.data = luaL_checklstring(l, 1, &json_len);
+    json.end = json.data + json_len;
     json.current_depth = 0;
     json.ptr = json.data;
+    json.lazy = json.cfg->decode_lazy;
+    json.doc_index = 1;
 
     /* Detect Unicode other than UTF-8 (see RFC 4627, Sec 3)
      *
@@ -1288,6 +1624,127 @@ static int json_decode(lua_State *l)
     return 1;
 }
 
+/* Decode the lazy object proxy at (absolute) stack index "proxy" into
+ * the proxy itself, then detach it from the lazy metatable. Nested
+ * objects become proxies in turn. Nothing is done for other tables. */
+static void json_lazy_materialize(lua_State *l, int proxy)
+{
+    json_parse_t json;
+    json_token_t token;
+    size_t json_len;
+    int pos, i;
+
+    lua_rawgeti(l, lua_upvalueindex(2), JSON_LAZY_POS);
+    lua_pushvalue(l, proxy);
+    lua_rawget(l, -2);
+    if (lua_isnil(l, -1)) {
+        lua_pop(l, 2);
+        return;
+    }
+    pos = lua_tointeger(l, -1);
+    lua_pop(l, 2);
+
+    lua_rawgeti(l, lua_upvalueindex(2), JSON_LAZY_DOC);
+    lua_pushvalue(l, proxy);
+    lua_rawget(l, -2);
+    lua_remove(l, -2);
+
+    json.cfg = json_fetch_config(l);
+    json.data = lua_tolstring(l, -1, &json_len);
+    json.end = json.data + json_len;
+    json.ptr = json.data + pos;
+    json.current_depth = 0;
+    json.lazy = 1;
+    json.doc_index = lua_gettop(l);
+    json.tmp = strbuf_new(json.end - json.ptr);
+
+    /* json_lazy_object() recorded the position of the '{' */
+    json_next_token(&json, &token);
+    assert(token.type == T_OBJ_BEGIN);
+
+    json_decode_descend(l, &json, 3);
+    lua_pushvalue(l, proxy);
+    json_parse_object_members(l, &json);
+
+    strbuf_free(json.tmp);
+    lua_pop(l, 2);
+
+    /* Only forget the proxy once it decoded successfully, errors are
+     * raised again on the next access */
+    for (i = JSON_LAZY_DOC; i <= JSON_LAZY_POS; i++) {
+        lua_rawgeti(l, lua_upvalueindex(2), i);
+        lua_pushvalue(l, proxy);
+        lua_pushnil(l);
+        lua_rawset(l, -3);
+        lua_pop(l, 1);
+    }
+    lua_pushnil(l);
+    lua_setmetatable(l, proxy);
+}
+
+/* Lazy proxy __index metamethod */
+static int json_lazy_index(lua_State *l)
+{
+    json_lazy_materialize(l, 1);
+    lua_settop(l, 2);
+    lua_rawget(l, 1);
+
+    return 1;
+}
+
+/* Lazy proxy __newindex metamethod */
+static int json_lazy_newindex(lua_State *l)
+{
+    json_lazy_materialize(l, 1);
+    lua_settop(l, 3);
+    lua_rawset(l, 1);
+
+    return 0;
+}
+
+/* materialize(value)
+ *
+ * Decode a proxy returned by decode() with decode_lazy enabled so it can
+ * be traversed with pairs()/next(). Returns the argument. */
+static int json_materialize(lua_State *l)
+{
+    luaL_argcheck(l, lua_gettop(l) == 1, 1, "expected 1 argument");
+
+    if (lua_istable(l, 1))
+        json_lazy_materialize(l, 1);
+
+    return 1;
+}
+
+/* Push the metatable shared by all lazy proxies. Expects the config
+ * userdata at the top of the stack. */
+static void json_create_lazy_meta(lua_State *l)
+{
+    int i;
+
+    lua_newtable(l);
+
+    /* Proxy => JSON text and proxy => offset, not keeping proxies alive */
+    for (i = JSON_LAZY_DOC; i <= JSON_LAZY_POS; i++) {
+        lua_newtable(l);
+        lua_newtable(l);
+        lua_pushliteral(l, "k");
+        lua_setfield(l, -2, "__mode");
+        lua_setmetatable(l, -2);
+        lua_rawseti(l, -2, i);
+    }
+
+    lua_pushvalue(l, -2);
+    lua_pushvalue(l, -2);
+    lua_pushcclosure(l, json_lazy_index, 2);
+    lua_setfield(l, -2, "__index");
+
+    lua_pushvalue(l, -2);
+    lua_pushvalue(l, -2);
+    lua_pushcclosure(l, json_lazy_newindex, 2);
+    lua_setfield(l, -2, "__newindex");
+}
+
 /* ===== INITIALISATION ===== */
 
 #if !defined(LUA_VERSION_NUM) || LUA_VERSION_NUM < 502
@@ -1343,6 +1800,7 @@ static int lua_cjson_new(lua_State *l)
 {
     luaL_Reg reg[] = {
         { "encode", json_encode },
+        { "encode_stream", json_encode_stream },
         { "decode", json_decode },
         { "encode_sparse_array", json_cfg_encode_sparse_array },
         { "encode_max_depth", json_cfg_encode_max_depth },
@@ -1351,6 +1809,8 @@ static int lua_cjson_new(lua_State *l)
         { "encode_keep_buffer", json_cfg_encode_keep_buffer },
         { "encode_invalid_numbers", json_cfg_encode_invalid_numbers },
         { "decode_invalid_numbers", json_cfg_decode_invalid_numbers },
+        { "decode_lazy", json_cfg_decode_lazy },
+        { "materialize", json_materialize },
         { "new", lua_cjson_new },
         { NULL, NULL }
     };
@@ -1361,9 +1821,11 @@ static int lua_cjson_new(lua_State *l)
     /* cjson module table */
     lua_newtable(l);
 
-    /* Register functions with config data as upvalue */
+    /* Register functions with config data and the lazy proxy metatable
+     * as upvalues */
     json_create_config(l);
-    luaL_setfuncs(l, reg, 1);
+    json_create_lazy_meta(l);
+    luaL_setfuncs(l, reg, 2);
 
     /* Set cjson.null */
     lua_pushlightuserdata(l, NULL);
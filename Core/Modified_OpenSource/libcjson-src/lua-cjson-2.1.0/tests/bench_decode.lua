@@ -0,0 +1,134 @@
+#!/usr/bin/env lua
+
+-- Decode throughput (MB/s) for ~1 MB sensor and SEL collections, both
+-- compact and pretty-printed, with and without decode_lazy. "scan" reads
+-- one field of every member, "peek" only the first member's.
+--
+-- Usage: bench_decode.lua [seconds per test]
+
+local json = require "cjson"
+
+local seconds = tonumber(arg and arg[1]) or 1
+
+local function gen_sensors(count)
+    local members = {}
+    for i = 1, count do
+        members[i] = {
+            ["@odata.id"] = "/redfish/v1/Chassis/Self/Sensors/Sensor_" .. i,
+            Name = "CPU" .. (i % 4) .. "_VR_Temp_" .. i,
+            Reading = 20 + (i % 600) / 10,
+            ReadingUnits = "Cel",
+            Status = { State = "Enabled", Health = (i % 50 == 0) and "Warning" or "OK" },
+            Thresholds = {
+                UpperCritical = { Reading = 95 },
+                UpperCaution = { Reading = 85.5 },
+                LowerCritical = { Reading = 5 }
+            }
+        }
+    end
+    return { Name = "Sensors", ["Members@odata.count"] = count, Members = members }
+end
+
+local function gen_sel(count)
+    local entries = {}
+    for i = 1, count do
+        entries[i] = {
+            Id = tostring(i),
+            Created = "2021-09-10T12:" .. ("%02d:%02d"):format(i % 60, (i * 7) % 60) .. "+00:00",
+            EntryType = "SEL",
+            Severity = (i % 10 == 0) and "Critical" or "OK",
+            Message = "Sensor \"PSU" .. (i % 2) .. "_Status\" asserted: Power Supply AC lost\n" ..
+                      "Record " .. i .. " of /var/log/sel/" .. (i % 8),
+            SensorNumber = i % 256,
+            EventData = { i % 256, (i * 3) % 256, 255 }
+        }
+    end
+    return { Name = "Log Service Collection", Members = entries }
+end
+
+-- Simple pretty printer, cjson only produces compact output
+local function pretty(text)
+    local out, indent, instr, esc = {}, 0, false, false
+    for c in text:gmatch(".") do
+        if instr then
+            out[#out + 1] = c
+            if esc then esc = false
+            elseif c == "\\" then esc = true
+            elseif c == '"' then instr = false end
+        elseif c == '"' then
+            instr = true
+            out[#out + 1] = c
+        elseif c == "{" or c == "[" then
+            indent = indent + 1
+            out[#out + 1] = c .. "\n" .. ("    "):rep(indent)
+        elseif c == "}" or c == "]" then
+            indent = indent - 1
+            out[#out + 1] = "\n" .. ("    "):rep(indent) .. c
+        elseif c == "," then
+            out[#out + 1] = ",\n" .. ("    "):rep(indent)
+        elseif c == ":" then
+            out[#out + 1] = ": "
+        else
+            out[#out + 1] = c
+        end
+    end
+    return table.concat(out)
+end
+
+-- Grow the collection until it encodes to roughly 1 MB
+local function sized(gen)
+    local count = 64
+    local text = json.encode(gen(count))
+    while #text < 1024 * 1024 do
+        count = math.ceil(count * 1024 * 1024 / #text)
+        text = json.encode(gen(count))
+    end
+    return text
+end
+
+local function rate(func, bytes)
+    local iter, t = 0, os.clock()
+    repeat
+        func()
+        iter = iter + 1
+    until os.clock() - t >= seconds
+    return bytes * iter / (os.clock() - t) / (1024 * 1024)
+end
+
+-- Read one field of every member, as a collection handler would
+local function scan(doc)
+    local n = 0
+    for _, member in ipairs(doc.Members) do
+        if member.Name or member.Id then
+            n = n + 1
+        end
+    end
+    return n
+end
+
+local function peek(doc)
+    return doc.Members[1].Name or doc.Members[1].Id
+end
+
+for _, payload in ipairs({ { "sensors", gen_sensors }, { "sel", gen_sel } }) do
+    local compact = sized(payload[2])
+    for _, text in ipairs({ compact, pretty(compact) }) do
+        local label = ("%s%s (%d bytes)"):format(payload[1],
+                          text == compact and "" or " pretty", #text)
+        local results = {}
+
+        for _, lazy in ipairs({ false, true }) do
+            local name = lazy and "decode_lazy" or "decode"
+            json.decode_lazy(lazy)
+            results[#results + 1] = { name .. " + scan", rate(function () scan(json.decode(text)) end, #text) }
+            results[#results + 1] = { name .. " + peek", rate(function () peek(json.decode(text)) end, #text) }
+        end
+        json.decode_lazy(false)
+
+        for _, r in ipairs(results) do
+            print(("%-32s\t%-20s\t%.1f MB/s"):format(label, r[1], r[2]))
+        end
+    end
+end
+
+-- vi:ai et sw=4 ts=4:
@@ -0,0 +1,90 @@
+#!/usr/bin/env lua
+
+-- Encode throughput (MB/s) for ~1 MB payloads shaped like the REST
+-- layer's sensor and SEL collections, using cjson.encode with and
+-- without the persistent buffer, and cjson.encode_stream.
+--
+-- Usage: bench_encode.lua [seconds per test]
+
+local json = require "cjson"
+
+local seconds = tonumber(arg and arg[1]) or 1
+
+local function gen_sensors(count)
+    local members = {}
+    for i = 1, count do
+        members[i] = {
+            ["@odata.id"] = "/redfish/v1/Chassis/Self/Sensors/Sensor_" .. i,
+            Name = "CPU" .. (i % 4) .. "_VR_Temp_" .. i,
+            Reading = 20 + (i % 600) / 10,
+            ReadingUnits = "Cel",
+            Status = { State = "Enabled", Health = (i % 50 == 0) and "Warning" or "OK" },
+            Thresholds = {
+                UpperCritical = { Reading = 95 },
+                UpperCaution = { Reading = 85.5 },
+                LowerCritical = { Reading = 5 }
+            }
+        }
+    end
+    return { Name = "Sensors", ["Members@odata.count"] = count, Members = members }
+end
+
+local function gen_sel(count)
+    local entries = {}
+    for i = 1, count do
+        entries[i] = {
+            Id = tostring(i),
+            Created = "2021-09-10T12:" .. ("%02d:%02d"):format(i % 60, (i * 7) % 60) .. "+00:00",
+            EntryType = "SEL",
+            Severity = (i % 10 == 0) and "Critical" or "OK",
+            Message = "Sensor \"PSU" .. (i % 2) .. "_Status\" asserted: Power Supply AC lost\n" ..
+                      "Record " .. i .. " of /var/log/sel/" .. (i % 8),
+            SensorNumber = i % 256,
+            EventData = { i % 256, (i * 3) % 256, 255 }
+        }
+    end
+    return { Name = "Log Service Collection", Members = entries }
+end
+
+-- Grow the collection until it encodes to roughly 1 MB
+local function sized(gen)
+    local count = 64
+    local data = gen(count)
+    local len = #json.encode(data)
+    while len < 1024 * 1024 do
+        count = math.ceil(count * 1024 * 1024 / len)
+        data = gen(count)
+        len = #json.encode(data)
+    end
+    return data, len
+end
+
+local function rate(func, bytes)
+    local iter, t = 0, os.clock()
+    repeat
+        func()
+        iter = iter + 1
+    until os.clock() - t >= seconds
+    return bytes * iter / (os.clock() - t) / (1024 * 1024)
+end
+
+local function null_writer(s) end
+
+for _, payload in ipairs({ { "sensors", gen_sensors }, { "sel", gen_sel } }) do
+    local data, len = sized(payload[2])
+    local results = {}
+
+    json.encode_keep_buffer(true)
+    results[#results + 1] = { "encode", rate(function () json.encode(data) end, len) }
+    json.encode_keep_buffer(false)
+    results[#results + 1] = { "encode (no keep_buffer)", rate(function () json.encode(data) end, len) }
+    json.encode_keep_buffer(true)
+    results[#results + 1] = { "encode_stream 8K", rate(function () json.encode_stream(data, null_writer) end, len) }
+    results[#results + 1] = { "encode_stream 64K", rate(function () json.encode_stream(data, null_writer, 65536) end, len) }
+
+    for _, r in ipairs(results) do
+        print(("%s (%d bytes)\t%-24s\t%.1f MB/s"):format(payload[1], len, r[1], r[2]))
+    end
+end
+
+-- vi:ai et sw=4 ts=4:
@@ -74,6 +74,13 @@ function load_testdata()
     end
     data.deeply_nested_data = big
 
+    local records = {}
+    for i = 1, 200 do
+        records[i] = { Name = "Sensor_" .. i, Reading = i * 1.5,
+                       Status = "ok\n/" .. string.rep("x", i % 17) }
+    end
+    data.stream_data = { Members = records, Count = #records }
+
     return data
 end
 
@@ -306,6 +313,73 @@ local cjson_tests = {
       json.encode, { testdata.octets_raw }, true, { testdata.octets_escaped } },
     { "Decode all escaped octets",
       json.decode, { testdata.octets_escaped }, true, { testdata.octets_raw } },
+
+    -- Test streaming encode
+    { "Encode stream in chunks",
+      function ()
+          local chunks = {}
+          json.encode_stream(testdata.stream_data,
+                             function (s) chunks[#chunks + 1] = s end, 256)
+          return #chunks > 1, table.concat(chunks) == json.encode(testdata.stream_data)
+      end, { }, true, { true, true } },
+    { "Encode stream with writer using encode",
+      function ()
+          local chunks = {}
+          json.encode_stream(testdata.stream_data,
+                             function (s) chunks[#chunks + 1] = json.encode(s) end, 256)
+          for i = 1, #chunks do chunks[i] = json.decode(chunks[i]) end
+          return table.concat(chunks) == json.encode(testdata.stream_data)
+      end, { }, true, { true } },
+    { "Encode stream writer error [throw error]",
+      json.encode_stream, { { 1, 2, 3 }, function () error("writer failed", 0) end },
+      false, { "writer failed" } },
+    { "Encode stream argument validation [throw error]",
+      json.encode_stream, { { 1, 2, 3 } },
+      false, { "bad argument #1 to '?' (expected 2 or 3 arguments)" } },
+    { "Encode after stream error",
+      json.encode, { { 1, 2, 3 } }, true, { "[1,2,3]" } },
+
+    -- Test lazy decoding
+    { "Decode integer and float numbers",
+      function ()
+          local t = json.decode("[-0,123456789012345,-1234567890123456,12e2,0.5]")
+          return 1/t[1], t[2], t[3], t[4], t[5]
+      end, { }, true, { -Inf, 123456789012345, -1234567890123456, 1200, 0.5 } },
+    { "Set decode_lazy(true)",
+      json.decode_lazy, { true }, true, { true } },
+    { "Decode lazy nested objects",
+      function ()
+          local t = json.decode('{"a":{"b":[1,{"c":"x\\"y"}]},"n":1}')
+          return t.n, t.a.b[1], t.a.b[2].c
+      end, { }, true, { 1, 1, 'x"y' } },
+    { "Decode lazy proxy before and after materialize()",
+      function ()
+          local t = json.decode('{"a":{"b":1}}')
+          local empty = next(t.a) == nil
+          return empty, next(json.materialize(t.a))
+      end, { }, true, { true, "b", 1 } },
+    { "Assign to lazy proxy",
+      function ()
+          local t = json.decode('{"a":{"b":1}}')
+          t.a.c = 2
+          return t.a.b, t.a.c
+      end, { }, true, { 1, 2 } },
+    { "Encode lazy proxies",
+      function ()
+          return json.encode(json.decode('{"a":{"b":[{"c":{}}]}}'))
+      end, { }, true, { '{"a":{"b":[{"c":{}}]}}' } },
+    { "Materialize lazy object with invalid member",
+      function ()
+          return pcall(json.materialize, json.decode('{"a":{"b":}}').a)
+      end, { }, true, { false, "Expected value but found T_OBJ_END at character 11" } },
+    { "Decode lazy object with unterminated string [throw error]",
+      json.decode, { '{"a":{"b":"x}}' },
+      false, { "Expected object end but found unexpected end of string at character 15" } },
+    { "Decode lazy object with excessive nesting [throw error]",
+      json.decode, { '{"a":{"b":' .. string.rep("[", 1100) .. string.rep("]", 1100) .. '}}' },
+      false, { "Found too many nested data structures (1001) at character 1009" } },
+    { "Set decode_lazy(false)",
+      json.decode_lazy, { false }, true, { false } },
     { "Decode single UTF-16 escape",
       json.decode, { [["\uF800"]] }, true, { "\239\160\128" } },
     { "Decode all UTF-16 escapes (including surrogate combinations)",
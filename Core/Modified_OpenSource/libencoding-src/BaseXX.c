@@ -0,0 +1,797 @@
+/****************************************************************
+ *
+ * BaseXX.c
+ * Base64/Base32 (RFC 4648) encoding engine. The bulk of the data
+ * goes through a kernel picked once at load time: SSSE3 on x86,
+ * NEON on ARM when built with NEON enabled, scalar otherwise. The
+ * kernels only handle complete groups of valid characters, the
+ * rest (padding, whitespace, errors) is done by the scalar state
+ * machine shared by the one-shot and streaming decoders.
+ *
+ *****************************************************************/
+
+#include "string.h"
+#include "stdint.h"
+
+#include "BaseXX.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASEXX_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BASEXX_NEON
+#include <arm_neon.h>
+#if !defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON  (1 << 12)
+#endif
+#endif
+#endif
+
+#define IS_SPACE( c )   ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+
+/********************************** Tables ***********************************/
+
+static const char B64_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char B32_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+
+/* character to value, 0xFF for anything that is not in the alphabet */
+static unsigned char B64_VALUE[ 256 ];
+static unsigned char B32_VALUE_UPPER[ 256 ];
+static unsigned char B32_VALUE_ANY[ 256 ];
+
+/*********************************** Kernels **********************************/
+
+/*
+ * A kernel encodes or decodes as much of the given complete groups as it
+ * handles efficiently and returns the number of input bytes (characters)
+ * consumed. Decoders stop at the first block with a character outside the
+ * alphabet and never write past the data they decoded.
+ */
+typedef struct
+{
+    const char* name;
+    size_t (*enc64)( char* dest, const unsigned char* src, size_t size );
+    size_t (*dec64)( unsigned char* dest, const char* src, size_t size );
+} BaseXXKernelOps;
+
+static const BaseXXKernelOps kernel_scalar = { "scalar", NULL, NULL };
+
+#ifdef BASEXX_SSSE3
+/* 12 bytes to 16 characters per round, reading 16 bytes */
+__attribute__((target("ssse3")))
+static size_t enc64_ssse3( char* dest, const unsigned char* src, size_t size )
+{
+    const __m128i shuf = _mm_set_epi8( 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1 );
+    const __m128i shift_lut = _mm_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                             '/' - 63, 'A', 0, 0 );
+    size_t i = 0;
+
+    while (size - i >= 16)
+    {
+        __m128i in = _mm_loadu_si128( (const __m128i*)(src + i) );
+        __m128i t0, t1, t2, t3, idx, res, less;
+
+        /* split the 24 bit groups into four 6 bit indices, one per byte */
+        in = _mm_shuffle_epi8( in, shuf );
+        t0 = _mm_and_si128( in, _mm_set1_epi32( 0x0fc0fc00 ) );
+        t1 = _mm_mulhi_epu16( t0, _mm_set1_epi32( 0x04000040 ) );
+        t2 = _mm_and_si128( in, _mm_set1_epi32( 0x003f03f0 ) );
+        t3 = _mm_mullo_epi16( t2, _mm_set1_epi32( 0x01000010 ) );
+        idx = _mm_or_si128( t1, t3 );
+
+        /* index to character: add the offset of its range */
+        res = _mm_subs_epu8( idx, _mm_set1_epi8( 51 ) );
+        less = _mm_cmpgt_epi8( _mm_set1_epi8( 26 ), idx );
+        res = _mm_or_si128( res, _mm_and_si128( less, _mm_set1_epi8( 13 ) ) );
+        res = _mm_add_epi8( _mm_shuffle_epi8( shift_lut, res ), idx );
+
+        _mm_storeu_si128( (__m128i*)dest, res );
+        dest += 16;
+        i += 12;
+    }
+    return i;
+}
+
+/* 16 characters to 12 bytes per round */
+__attribute__((target("ssse3")))
+static size_t dec64_ssse3( unsigned char* dest, const char* src, size_t size )
+{
+    /* a character is valid if its nibble classes do not intersect */
+    const __m128i lut_lo = _mm_setr_epi8( 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                          0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a );
+    const __m128i lut_hi = _mm_setr_epi8( 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                          0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 );
+    const __m128i lut_roll = _mm_setr_epi8( 0, 16, 19, 4, -65, -65, -71, -71,
+                                            0, 0, 0, 0, 0, 0, 0, 0 );
+    const __m128i pack = _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 );
+    const __m128i nibble = _mm_set1_epi8( 0x0f );
+    size_t i = 0;
+
+    while (size - i >= 16)
+    {
+        __m128i in = _mm_loadu_si128( (const __m128i*)(src + i) );
+        __m128i hi = _mm_and_si128( _mm_srli_epi32( in, 4 ), nibble );
+        __m128i lo = _mm_and_si128( in, nibble );
+        __m128i bad = _mm_and_si128( _mm_shuffle_epi8( lut_lo, lo ),
+                                     _mm_shuffle_epi8( lut_hi, hi ) );
+        __m128i roll, val;
+        int tail;
+
+        if (_mm_movemask_epi8( _mm_cmpeq_epi8( bad, _mm_setzero_si128() ) ) != 0xffff)
+            break;
+
+        /* character to value, '/' shares its high nibble with '+' */
+        roll = _mm_shuffle_epi8( lut_roll,
+                                 _mm_add_epi8( _mm_cmpeq_epi8( in, _mm_set1_epi8( '/' ) ), hi ) );
+        val = _mm_add_epi8( in, roll );
+
+        /* join four 6 bit values into 24 bits, then pack the bytes */
+        val = _mm_maddubs_epi16( val, _mm_set1_epi32( 0x01400140 ) );
+        val = _mm_madd_epi16( val, _mm_set1_epi32( 0x00011000 ) );
+        val = _mm_shuffle_epi8( val, pack );
+
+        _mm_storel_epi64( (__m128i*)dest, val );
+        tail = _mm_cvtsi128_si32( _mm_srli_si128( val, 8 ) );
+        memcpy( dest + 8, &tail, 4 );
+        dest += 12;
+        i += 16;
+    }
+    return i;
+}
+
+static const BaseXXKernelOps kernel_ssse3 = { "ssse3", enc64_ssse3, dec64_ssse3 };
+#endif
+
+#ifdef BASEXX_NEON
+static inline uint8x16_t enc64_neon_chars( uint8x16_t idx )
+{
+    /* 'A' + idx, then move each range to its place */
+    uint8x16_t res = vaddq_u8( idx, vdupq_n_u8( 'A' ) );
+    res = vaddq_u8( res, vandq_u8( vcgtq_u8( idx, vdupq_n_u8( 25 ) ), vdupq_n_u8( 6 ) ) );
+    res = vsubq_u8( res, vandq_u8( vcgtq_u8( idx, vdupq_n_u8( 51 ) ), vdupq_n_u8( 75 ) ) );
+    res = vsubq_u8( res, vandq_u8( vceqq_u8( idx, vdupq_n_u8( 62 ) ), vdupq_n_u8( 15 ) ) );
+    res = vsubq_u8( res, vandq_u8( vceqq_u8( idx, vdupq_n_u8( 63 ) ), vdupq_n_u8( 12 ) ) );
+    return res;
+}
+
+/* 48 bytes to 64 characters per round */
+static size_t enc64_neon( char* dest, const unsigned char* src, size_t size )
+{
+    size_t i = 0;
+
+    while (size - i >= 48)
+    {
+        uint8x16x3_t in = vld3q_u8( src + i );
+        uint8x16x4_t out;
+
+        out.val[ 0 ] = vshrq_n_u8( in.val[ 0 ], 2 );
+        out.val[ 1 ] = vorrq_u8( vandq_u8( vshlq_n_u8( in.val[ 0 ], 4 ), vdupq_n_u8( 0x30 ) ),
+                                 vshrq_n_u8( in.val[ 1 ], 4 ) );
+        out.val[ 2 ] = vorrq_u8( vandq_u8( vshlq_n_u8( in.val[ 1 ], 2 ), vdupq_n_u8( 0x3c ) ),
+                                 vshrq_n_u8( in.val[ 2 ], 6 ) );
+        out.val[ 3 ] = vandq_u8( in.val[ 2 ], vdupq_n_u8( 0x3f ) );
+
+        out.val[ 0 ] = enc64_neon_chars( out.val[ 0 ] );
+        out.val[ 1 ] = enc64_neon_chars( out.val[ 1 ] );
+        out.val[ 2 ] = enc64_neon_chars( out.val[ 2 ] );
+        out.val[ 3 ] = enc64_neon_chars( out.val[ 3 ] );
+
+        vst4q_u8( (uint8_t*)dest, out );
+        dest += 64;
+        i += 48;
+    }
+    return i;
+}
+
+static inline uint8x16_t dec64_neon_values( uint8x16_t c, uint8x16_t* bad )
+{
+    uint8x16_t upper = vcltq_u8( vsubq_u8( c, vdupq_n_u8( 'A' ) ), vdupq_n_u8( 26 ) );
+    uint8x16_t lower = vcltq_u8( vsubq_u8( c, vdupq_n_u8( 'a' ) ), vdupq_n_u8( 26 ) );
+    uint8x16_t digit = vcltq_u8( vsubq_u8( c, vdupq_n_u8( '0' ) ), vdupq_n_u8( 10 ) );
+    uint8x16_t plus = vceqq_u8( c, vdupq_n_u8( '+' ) );
+    uint8x16_t slash = vceqq_u8( c, vdupq_n_u8( '/' ) );
+    uint8x16_t val;
+
+    val = vandq_u8( upper, vsubq_u8( c, vdupq_n_u8( 'A' ) ) );
+    val = vorrq_u8( val, vandq_u8( lower, vsubq_u8( c, vdupq_n_u8( 'a' - 26 ) ) ) );
+    val = vorrq_u8( val, vandq_u8( digit, vaddq_u8( c, vdupq_n_u8( 52 - '0' ) ) ) );
+    val = vorrq_u8( val, vandq_u8( plus, vdupq_n_u8( 62 ) ) );
+    val = vorrq_u8( val, vandq_u8( slash, vdupq_n_u8( 63 ) ) );
+
+    *bad = vorrq_u8( *bad, vmvnq_u8( vorrq_u8( vorrq_u8( upper, lower ),
+                                               vorrq_u8( digit, vorrq_u8( plus, slash ) ) ) ) );
+    return val;
+}
+
+/* 64 characters to 48 bytes per round */
+static size_t dec64_neon( unsigned char* dest, const char* src, size_t size )
+{
+    size_t i = 0;
+
+    while (size - i >= 64)
+    {
+        uint8x16x4_t in = vld4q_u8( (const uint8_t*)src + i );
+        uint8x16_t bad = vdupq_n_u8( 0 );
+        uint8x16x3_t out;
+        uint64x2_t any;
+        uint8x16_t v0, v1, v2, v3;
+
+        v0 = dec64_neon_values( in.val[ 0 ], &bad );
+        v1 = dec64_neon_values( in.val[ 1 ], &bad );
+        v2 = dec64_neon_values( in.val[ 2 ], &bad );
+        v3 = dec64_neon_values( in.val[ 3 ], &bad );
+        any = vreinterpretq_u64_u8( bad );
+        if (vgetq_lane_u64( any, 0 ) | vgetq_lane_u64( any, 1 ))
+            break;
+
+        out.val[ 0 ] = vorrq_u8( vshlq_n_u8( v0, 2 ), vshrq_n_u8( v1, 4 ) );
+        out.val[ 1 ] = vorrq_u8( vshlq_n_u8( v1, 4 ), vshrq_n_u8( v2, 2 ) );
+        out.val[ 2 ] = vorrq_u8( vshlq_n_u8( v2, 6 ), v3 );
+
+        vst3q_u8( dest, out );
+        dest += 48;
+        i += 64;
+    }
+    return i;
+}
+
+static const BaseXXKernelOps kernel_neon = { "neon", enc64_neon, dec64_neon };
+#endif
+
+static const BaseXXKernelOps* kernel = &kernel_scalar;
+
+static void init_table( unsigned char* table, const char* chars, int nocase )
+{
+    int i;
+
+    memset( table, 0xFF, 256 );
+    for (i = 0; chars[ i ]; i++)
+    {
+        table[ (unsigned char)chars[ i ] ] = i;
+        if (nocase && chars[ i ] >= 'A' && chars[ i ] <= 'Z')
+            table[ (unsigned char)(chars[ i ] - 'A' + 'a') ] = i;
+    }
+}
+
+__attribute__((constructor))
+static void BaseXXInit( void )
+{
+    init_table( B64_VALUE, B64_CHARS, 0 );
+    init_table( B32_VALUE_UPPER, B32_CHARS, 0 );
+    init_table( B32_VALUE_ANY, B32_CHARS, 1 );
+    BaseXXSelectKernel( NULL );
+}
+
+const char* BaseXXKernel( void )
+{
+    return kernel->name;
+}
+
+int BaseXXSelectKernel( const char* name )
+{
+#ifdef BASEXX_SSSE3
+    int ssse3;
+
+    /* may run from a constructor, before libgcc has probed the CPU */
+    __builtin_cpu_init();
+    ssse3 = __builtin_cpu_supports( "ssse3" );
+#endif
+#ifdef BASEXX_NEON
+#if defined(__aarch64__)
+    int neon = 1;
+#else
+    int neon = (getauxval( AT_HWCAP ) & HWCAP_NEON) != 0;
+#endif
+#endif
+
+    if (name == NULL)
+    {
+        kernel = &kernel_scalar;
+#ifdef BASEXX_SSSE3
+        if (ssse3)
+            kernel = &kernel_ssse3;
+#endif
+#ifdef BASEXX_NEON
+        if (neon)
+            kernel = &kernel_neon;
+#endif
+        return 0;
+    }
+    if (strcmp( name, "scalar" ) == 0)
+    {
+        kernel = &kernel_scalar;
+        return 0;
+    }
+#ifdef BASEXX_SSSE3
+    if (strcmp( name, "ssse3" ) == 0 && ssse3)
+    {
+        kernel = &kernel_ssse3;
+        return 0;
+    }
+#endif
+#ifdef BASEXX_NEON
+    if (strcmp( name, "neon" ) == 0 && neon)
+    {
+        kernel = &kernel_neon;
+        return 0;
+    }
+#endif
+    return -1;
+}
+
+/****************************** Base64 Encoding ******************************/
+
+size_t Base64EncodeLength( size_t size )
+{
+    return ((size + 2) / 3) * 4;
+}
+
+/* encode size bytes, a multiple of 3 */
+static char* b64_encode_groups( char* dest, const unsigned char* src, size_t size )
+{
+    size_t i = 0;
+
+    if (kernel->enc64)
+    {
+        i = kernel->enc64( dest, src, size );
+        dest += (i / 3) * 4;
+    }
+    for (; i < size; i += 3)
+    {
+        uint32_t v = ((uint32_t)src[ i ] << 16) | (src[ i + 1 ] << 8) | src[ i + 2 ];
+
+        dest[ 0 ] = B64_CHARS[ (v >> 18) & 0x3f ];
+        dest[ 1 ] = B64_CHARS[ (v >> 12) & 0x3f ];
+        dest[ 2 ] = B64_CHARS[ (v >> 6) & 0x3f ];
+        dest[ 3 ] = B64_CHARS[ v & 0x3f ];
+        dest += 4;
+    }
+    return dest;
+}
+
+/* encode the last 1 or 2 bytes, with padding */
+static char* b64_encode_tail( char* dest, const unsigned char* src, size_t size )
+{
+    uint32_t v = (uint32_t)src[ 0 ] << 16;
+
+    if (size > 1)
+        v |= src[ 1 ] << 8;
+    dest[ 0 ] = B64_CHARS[ (v >> 18) & 0x3f ];
+    dest[ 1 ] = B64_CHARS[ (v >> 12) & 0x3f ];
+    dest[ 2 ] = size > 1 ? B64_CHARS[ (v >> 6) & 0x3f ] : '=';
+    dest[ 3 ] = '=';
+    return dest + 4;
+}
+
+size_t Base64Encode( char* dest, const void* src, size_t size )
+{
+    const unsigned char* pSrc = (const unsigned char*)src;
+    size_t full = size - size % 3;
+    char* p;
+
+    p = b64_encode_groups( dest, pSrc, full );
+    if (size > full)
+        p = b64_encode_tail( p, pSrc + full, size - full );
+    *p = '\0';
+    return p - dest;
+}
+
+void Base64EncodeInit( BaseXXStream* st )
+{
+    memset( st, 0, sizeof(*st) );
+}
+
+size_t Base64EncodeUpdate( BaseXXStream* st, char* dest, const void* src, size_t size )
+{
+    const unsigned char* pSrc = (const unsigned char*)src;
+    char* p = dest;
+    size_t full;
+
+    /* complete the group left over from the previous call */
+    while (st->len > 0 && st->len < 3 && size > 0)
+    {
+        st->buf[ st->len++ ] = *pSrc++;
+        size--;
+    }
+    if (st->len == 3)
+    {
+        p = b64_encode_groups( p, st->buf, 3 );
+        st->len = 0;
+    }
+
+    full = size - size % 3;
+    p = b64_encode_groups( p, pSrc, full );
+    memcpy( st->buf + st->len, pSrc + full, size - full );
+    st->len += size - full;
+    return p - dest;
+}
+
+size_t Base64EncodeFinal( BaseXXStream* st, char* dest )
+{
+    char* p = dest;
+
+    if (st->len > 0)
+        p = b64_encode_tail( p, st->buf, st->len );
+    *p = '\0';
+    st->len = 0;
+    return p - dest;
+}
+
+/****************************** Base64 Decoding ******************************/
+
+size_t Base64DecodeLength( size_t size )
+{
+    return ((size + 3) / 4) * 3;
+}
+
+size_t Base64DecodeBlocks( void* dest, const char* src, size_t size, size_t* consumed )
+{
+    unsigned char* pDest = (unsigned char*)dest;
+    const unsigned char* s = (const unsigned char*)src;
+    size_t i = 0;
+
+    if (kernel->dec64)
+    {
+        i = kernel->dec64( pDest, src, size );
+        pDest += (i / 4) * 3;
+    }
+    for (; size - i >= 4; i += 4)
+    {
+        unsigned char a = B64_VALUE[ s[ i ] ], b = B64_VALUE[ s[ i + 1 ] ];
+        unsigned char c = B64_VALUE[ s[ i + 2 ] ], d = B64_VALUE[ s[ i + 3 ] ];
+        uint32_t v;
+
+        if ((a | b | c | d) & 0x80)
+            break;
+        v = ((uint32_t)a << 18) | ((uint32_t)b << 12) | (c << 6) | d;
+        pDest[ 0 ] = v >> 16;
+        pDest[ 1 ] = v >> 8;
+        pDest[ 2 ] = v;
+        pDest += 3;
+    }
+    *consumed = i;
+    return pDest - (unsigned char*)dest;
+}
+
+/* write the bytes of a group of n values, 2 to 4, and check unused bits */
+static size_t b64_decode_group( BaseXXStream* st, unsigned char* dest )
+{
+    const unsigned char* g = st->buf;
+    uint32_t v = ((uint32_t)g[ 0 ] << 18) | ((uint32_t)g[ 1 ] << 12);
+    size_t n = st->len - 1;
+
+    if (st->len > 2)
+        v |= g[ 2 ] << 6;
+    if (st->len > 3)
+        v |= g[ 3 ];
+    if (st->mode == BASEXX_STRICT && (v & (0xffffff >> (n * 8))) != 0)
+    {
+        st->error = 1;
+        return 0;
+    }
+    dest[ 0 ] = v >> 16;
+    if (n > 1)
+        dest[ 1 ] = v >> 8;
+    if (n > 2)
+        dest[ 2 ] = v;
+    st->len = 0;
+    return n;
+}
+
+void Base64DecodeInit( BaseXXStream* st, int mode )
+{
+    memset( st, 0, sizeof(*st) );
+    st->mode = mode;
+}
+
+size_t Base64DecodeUpdate( BaseXXStream* st, void* dest, const char* src, size_t size )
+{
+    unsigned char* pDest = (unsigned char*)dest;
+    size_t i = 0;
+
+    if (st->error)
+        return BASEXX_ERROR;
+
+    while (i < size)
+    {
+        unsigned char ch, v;
+
+        if (st->len == 0 && st->pad == 0)
+        {
+            size_t done;
+
+            pDest += Base64DecodeBlocks( pDest, src + i, size - i, &done );
+            i += done;
+            if (i == size)
+                break;
+        }
+
+        ch = src[ i++ ];
+        v = B64_VALUE[ ch ];
+        if (v != 0xFF && st->pad == 0)
+        {
+            st->buf[ st->len++ ] = v;
+            if (st->len == 4)
+                pDest += b64_decode_group( st, pDest );
+        }
+        else if (ch == '=' && st->len >= 2 && st->len + st->pad < 4)
+        {
+            /* the group ends once it is padded to 4 characters */
+            if (st->len + ++st->pad == 4)
+                pDest += b64_decode_group( st, pDest );
+        }
+        else if (!(st->mode == BASEXX_LENIENT && IS_SPACE( ch )))
+            st->error = 1;
+        if (st->error)
+            return BASEXX_ERROR;
+    }
+    return pDest - (unsigned char*)dest;
+}
+
+size_t Base64DecodeFinal( BaseXXStream* st, void* dest )
+{
+    size_t n = 0;
+
+    /* a group of 2 or 3 characters needs padding in strict mode */
+    if (st->len == 1 || (st->len > 0 && st->mode == BASEXX_STRICT))
+        st->error = 1;
+    else if (st->len > 0)
+        n = b64_decode_group( st, (unsigned char*)dest );
+    return st->error ? BASEXX_ERROR : n;
+}
+
+size_t Base64Decode( void* dest, const char* src, size_t size, int mode )
+{
+    BaseXXStream st;
+    size_t n, m;
+
+    Base64DecodeInit( &st, mode );
+    n = Base64DecodeUpdate( &st, dest, src, size );
+    if (n == BASEXX_ERROR)
+        return BASEXX_ERROR;
+    m = Base64DecodeFinal( &st, (unsigned char*)dest + n );
+    return m == BASEXX_ERROR ? BASEXX_ERROR : n + m;
+}
+
+/****************************** Base32 Encoding ******************************/
+
+size_t Base32EncodeLength( size_t size )
+{
+    return ((size + 4) / 5) * 8;
+}
+
+static char* b32_encode_groups( char* dest, const unsigned char* src, size_t size )
+{
+    size_t i;
+
+    for (i = 0; i < size; i += 5)
+    {
+        uint64_t v = ((uint64_t)src[ i ] << 32) | ((uint32_t)src[ i + 1 ] << 24) |
+                     ((uint32_t)src[ i + 2 ] << 16) | ((uint32_t)src[ i + 3 ] << 8) | src[ i + 4 ];
+
+        dest[ 0 ] = B32_CHARS[ (v >> 35) & 0x1f ];
+        dest[ 1 ] = B32_CHARS[ (v >> 30) & 0x1f ];
+        dest[ 2 ] = B32_CHARS[ (v >> 25) & 0x1f ];
+        dest[ 3 ] = B32_CHARS[ (v >> 20) & 0x1f ];
+        dest[ 4 ] = B32_CHARS[ (v >> 15) & 0x1f ];
+        dest[ 5 ] = B32_CHARS[ (v >> 10) & 0x1f ];
+        dest[ 6 ] = B32_CHARS[ (v >> 5) & 0x1f ];
+        dest[ 7 ] = B32_CHARS[ v & 0x1f ];
+        dest += 8;
+    }
+    return dest;
+}
+
+/* characters carrying data for a tail of 1 to 4 bytes */
+static const unsigned char B32_TAIL_CHARS[ 5 ] = { 0, 2, 4, 5, 7 };
+
+static char* b32_encode_tail( char* dest, const unsigned char* src, size_t size )
+{
+    unsigned char group[ 5 ] = { 0, 0, 0, 0, 0 };
+    size_t i;
+
+    memcpy( group, src, size );
+    b32_encode_groups( dest, group, 5 );
+    for (i = B32_TAIL_CHARS[ size ]; i < 8; i++)
+        dest[ i ] = '=';
+    return dest + 8;
+}
+
+size_t Base32Encode( char* dest, const void* src, size_t size )
+{
+    const unsigned char* pSrc = (const unsigned char*)src;
+    size_t full = size - size % 5;
+    char* p;
+
+    p = b32_encode_groups( dest, pSrc, full );
+    if (size > full)
+        p = b32_encode_tail( p, pSrc + full, size - full );
+    *p = '\0';
+    return p - dest;
+}
+
+void Base32EncodeInit( BaseXXStream* st )
+{
+    memset( st, 0, sizeof(*st) );
+}
+
+size_t Base32EncodeUpdate( BaseXXStream* st, char* dest, const void* src, size_t size )
+{
+    const unsigned char* pSrc = (const unsigned char*)src;
+    char* p = dest;
+    size_t full;
+
+    while (st->len > 0 && st->len < 5 && size > 0)
+    {
+        st->buf[ st->len++ ] = *pSrc++;
+        size--;
+    }
+    if (st->len == 5)
+    {
+        p = b32_encode_groups( p, st->buf, 5 );
+        st->len = 0;
+    }
+
+    full = size - size % 5;
+    p = b32_encode_groups( p, pSrc, full );
+    memcpy( st->buf + st->len, pSrc + full, size - full );
+    st->len += size - full;
+    return p - dest;
+}
+
+size_t Base32EncodeFinal( BaseXXStream* st, char* dest )
+{
+    char* p = dest;
+
+    if (st->len > 0)
+        p = b32_encode_tail( p, st->buf, st->len );
+    *p = '\0';
+    st->len = 0;
+    return p - dest;
+}
+
+/****************************** Base32 Decoding ******************************/
+
+size_t Base32DecodeLength( size_t size )
+{
+    return ((size + 7) / 8) * 5;
+}
+
+static size_t b32_decode_blocks( unsigned char* dest, const unsigned char* s, size_t size,
+                                 const unsigned char* table, size_t* consumed )
+{
+    unsigned char* pDest = dest;
+    size_t i;
+
+    for (i = 0; size - i >= 8; i += 8)
+    {
+        unsigned char c0 = table[ s[ i ] ], c1 = table[ s[ i + 1 ] ];
+        unsigned char c2 = table[ s[ i + 2 ] ], c3 = table[ s[ i + 3 ] ];
+        unsigned char c4 = table[ s[ i + 4 ] ], c5 = table[ s[ i + 5 ] ];
+        unsigned char c6 = table[ s[ i + 6 ] ], c7 = table[ s[ i + 7 ] ];
+        uint64_t v;
+
+        if ((c0 | c1 | c2 | c3 | c4 | c5 | c6 | c7) & 0x80)
+            break;
+        v = ((uint64_t)c0 << 35) | ((uint64_t)c1 << 30) | ((uint64_t)c2 << 25) |
+            ((uint64_t)c3 << 20) | ((uint64_t)c4 << 15) | ((uint64_t)c5 << 10) |
+            ((uint64_t)c6 << 5) | c7;
+        pDest[ 0 ] = v >> 32;
+        pDest[ 1 ] = v >> 24;
+        pDest[ 2 ] = v >> 16;
+        pDest[ 3 ] = v >> 8;
+        pDest[ 4 ] = v;
+        pDest += 5;
+    }
+    *consumed = i;
+    return pDest - dest;
+}
+
+size_t Base32DecodeBlocks( void* dest, const char* src, size_t size, size_t* consumed )
+{
+    return b32_decode_blocks( (unsigned char*)dest, (const unsigned char*)src, size,
+                              B32_VALUE_ANY, consumed );
+}
+
+/* bytes decoded from a group of n data characters, 0 if n is not valid */
+static const unsigned char B32_TAIL_BYTES[ 9 ] = { 0, 0, 1, 0, 2, 3, 0, 4, 5 };
+
+static size_t b32_decode_group( BaseXXStream* st, unsigned char* dest )
+{
+    uint64_t v = 0;
+    size_t n = B32_TAIL_BYTES[ st->len ];
+    unsigned int i;
+
+    for (i = 0; i < 8; i++)
+        v = (v << 5) | (i < st->len ? st->buf[ i ] : 0);
+    if (n == 0 || (st->mode == BASEXX_STRICT && (v & ((1ULL << (40 - n * 8)) - 1)) != 0))
+    {
+        st->error = 1;
+        return 0;
+    }
+    for (i = 0; i < n; i++)
+        dest[ i ] = v >> (32 - i * 8);
+    st->len = 0;
+    return n;
+}
+
+void Base32DecodeInit( BaseXXStream* st, int mode )
+{
+    memset( st, 0, sizeof(*st) );
+    st->mode = mode;
+}
+
+size_t Base32DecodeUpdate( BaseXXStream* st, void* dest, const char* src, size_t size )
+{
+    const unsigned char* table = st->mode == BASEXX_STRICT ? B32_VALUE_UPPER : B32_VALUE_ANY;
+    const unsigned char* s = (const unsigned char*)src;
+    unsigned char* pDest = (unsigned char*)dest;
+    size_t i = 0;
+
+    if (st->error)
+        return BASEXX_ERROR;
+
+    while (i < size)
+    {
+        unsigned char ch, v;
+
+        if (st->len == 0 && st->pad == 0)
+        {
+            size_t done;
+
+            pDest += b32_decode_blocks( pDest, s + i, size - i, table, &done );
+            i += done;
+            if (i == size)
+                break;
+        }
+
+        ch = s[ i++ ];
+        v = table[ ch ];
+        if (v != 0xFF && st->pad == 0)
+        {
+            st->buf[ st->len++ ] = v;
+            if (st->len == 8)
+                pDest += b32_decode_group( st, pDest );
+        }
+        else if (ch == '=' && B32_TAIL_BYTES[ st->len ] != 0 && st->len + st->pad < 8)
+        {
+            if (st->len + ++st->pad == 8)
+                pDest += b32_decode_group( st, pDest );
+        }
+        else if (!(st->mode == BASEXX_LENIENT && IS_SPACE( ch )))
+            st->error = 1;
+        if (st->error)
+            return BASEXX_ERROR;
+    }
+    return pDest - (unsigned char*)dest;
+}
+
+size_t Base32DecodeFinal( BaseXXStream* st, void* dest )
+{
+    size_t n = 0;
+
+    if (st->len > 0 && st->mode == BASEXX_STRICT)
+        st->error = 1;
+    else if (st->len > 0)
+        n = b32_decode_group( st, (unsigned char*)dest );
+    return st->error ? BASEXX_ERROR : n;
+}
+
+size_t Base32Decode( void* dest, const char* src, size_t size, int mode )
+{
+    BaseXXStream st;
+    size_t n, m;
+
+    Base32DecodeInit( &st, mode );
+    n = Base32DecodeUpdate( &st, dest, src, size );
+    if (n == BASEXX_ERROR)
+        return BASEXX_ERROR;
+    m = Base32DecodeFinal( &st, (unsigned char*)dest + n );
+    return m == BASEXX_ERROR ? BASEXX_ERROR : n + m;
+}
@@ -0,0 +1,127 @@
+/******************************************************************************
+ *
+ * BaseXX.h
+ * Base64/Base32 (RFC 4648) encoding engine shared by the Cyo and Encode
+ * wrappers: one-shot and streaming encoders/decoders with strict or lenient
+ * validation, running on SIMD kernels (SSSE3, NEON) when available.
+ *
+ *******************************************************************************/
+
+#ifndef __BASEXX_H
+#define __BASEXX_H
+
+#include "stddef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Decoder validation modes */
+#define BASEXX_STRICT   0   /* complete groups, padding only at the end, unused bits zero */
+#define BASEXX_LENIENT  1   /* also skip whitespace, padding optional, any unused bits,
+                               lowercase base32 */
+
+/* Returned by the decoders on invalid input */
+#define BASEXX_ERROR    ((size_t)-1)
+
+/*
+ * State of a streaming encoder or decoder. Data can be passed in chunks of
+ * any size, the state carries an incomplete group over to the next call.
+ */
+typedef struct
+{
+    unsigned char buf[ 8 ];  /* incomplete input group */
+    unsigned int  len;       /* bytes (encode) or characters (decode) in buf */
+    unsigned int  pad;       /* decode: padding characters seen */
+    int           mode;      /* decode: BASEXX_STRICT or BASEXX_LENIENT */
+    int           error;     /* decode: invalid input seen */
+} BaseXXStream;
+
+/*****************************************************************************/
+/*
+ * @brief Length of the encoding of size bytes, without terminator
+ */
+size_t Base64EncodeLength( size_t size );
+size_t Base32EncodeLength( size_t size );
+
+/*
+ * @brief Maximum number of bytes decoded from size characters
+ */
+size_t Base64DecodeLength( size_t size );
+size_t Base32DecodeLength( size_t size );
+
+/*****************************************************************************/
+/*
+ * Encode a buffer into a NULL-terminated, padded string
+ * @param[out] dest Encoded string, EncodeLength( size ) + 1 bytes
+ * @param[in]  src  Data to encode
+ * @param[in]  size Length of the data
+ * @return Length of the encoded string
+ */
+size_t Base64Encode( char* dest, const void* src, size_t size );
+size_t Base32Encode( char* dest, const void* src, size_t size );
+
+/*
+ * Decode a string
+ * @param[out] dest Decoded data, DecodeLength( size ) bytes
+ * @param[in]  src  Encoded string
+ * @param[in]  size Length of the string
+ * @param[in]  mode BASEXX_STRICT or BASEXX_LENIENT
+ * @return Length of the decoded data, BASEXX_ERROR if src is invalid
+ */
+size_t Base64Decode( void* dest, const char* src, size_t size, int mode );
+size_t Base32Decode( void* dest, const char* src, size_t size, int mode );
+
+/*****************************************************************************/
+/*
+ * Streaming encoder. Update writes at most EncodeLength( size + 4 )
+ * characters and Final at most 8 characters plus the terminator. The
+ * number of characters written is returned, the output is the same as
+ * Encode on the concatenated input.
+ */
+void   Base64EncodeInit( BaseXXStream* st );
+size_t Base64EncodeUpdate( BaseXXStream* st, char* dest, const void* src, size_t size );
+size_t Base64EncodeFinal( BaseXXStream* st, char* dest );
+void   Base32EncodeInit( BaseXXStream* st );
+size_t Base32EncodeUpdate( BaseXXStream* st, char* dest, const void* src, size_t size );
+size_t Base32EncodeFinal( BaseXXStream* st, char* dest );
+
+/*
+ * Streaming decoder. Update writes at most DecodeLength( size + 7 ) bytes
+ * and Final at most 5 bytes. The number of bytes written is returned, or
+ * BASEXX_ERROR once invalid input has been seen.
+ */
+void   Base64DecodeInit( BaseXXStream* st, int mode );
+size_t Base64DecodeUpdate( BaseXXStream* st, void* dest, const char* src, size_t size );
+size_t Base64DecodeFinal( BaseXXStream* st, void* dest );
+void   Base32DecodeInit( BaseXXStream* st, int mode );
+size_t Base32DecodeUpdate( BaseXXStream* st, void* dest, const char* src, size_t size );
+size_t Base32DecodeFinal( BaseXXStream* st, void* dest );
+
+/*****************************************************************************/
+/*
+ * Decode the leading complete groups of src that contain no padding and no
+ * invalid characters. Base32 accepts lowercase. Used by the Cyo decoders,
+ * which handle the rest of the string themselves.
+ * @param[out] consumed Number of characters decoded, a multiple of 4 (8)
+ * @return Length of the decoded data
+ */
+size_t Base64DecodeBlocks( void* dest, const char* src, size_t size, size_t* consumed );
+size_t Base32DecodeBlocks( void* dest, const char* src, size_t size, size_t* consumed );
+
+/*
+ * @brief Name of the kernel in use: "scalar", "ssse3" or "neon"
+ */
+const char* BaseXXKernel( void );
+
+/*
+ * Select a kernel by name, NULL selects the best one the CPU supports
+ * @return 0 on success, -1 if the kernel is not available
+ */
+int BaseXXSelectKernel( const char* name );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BASEXX_H */
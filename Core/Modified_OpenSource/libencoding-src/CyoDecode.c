@@ -30,6 +30,7 @@
  */
 
 #include "CyoDecode.h"
+#include "BaseXX.h"
 
 #include "assert.h"
 #include "stdio.h"
@@ -227,8 +228,15 @@ size_t cyoBase32Decode( void* dest, const char* src, size_t size )
         unsigned char* pDest = (unsigned char*)dest;
         size_t dwSrcSize = size;
         size_t dwDestSize = 0;
+        size_t dwDone = 0;
         unsigned char in1, in2, in3, in4, in5, in6, in7, in8;
 
+        /* complete groups without padding go through the BaseXX engine */
+        dwDestSize = Base32DecodeBlocks( pDest, src, size, &dwDone );
+        pDest += dwDestSize;
+        src += dwDone;
+        dwSrcSize -= dwDone;
+
         while (dwSrcSize >= 1)
         {
             /* 8 inputs */
@@ -355,8 +363,15 @@ size_t cyoBase64DecodeBinary(void* dest, const char* src, size_t size )
         unsigned char* pDest = (unsigned char*)dest;
         size_t dwSrcSize = size;
         size_t dwDestSize = 0;
+        size_t dwDone = 0;
         unsigned char in1, in2, in3, in4;
 
+        /* complete groups without padding go through the BaseXX engine */
+        dwDestSize = Base64DecodeBlocks( pDest, src, size, &dwDone );
+        pDest += dwDestSize;
+        src += dwDone;
+        dwSrcSize -= dwDone;
+
         while (dwSrcSize >= 1)
         {
             /* 4 inputs */
@@ -34,6 +34,7 @@
 #include "assert.h"
 #include "string.h"
 #include "Encode.h"
+#include "BaseXX.h"
 
 #if 0
 /********************************** Shared ***********************************/
@@ -93,10 +94,6 @@ size_t cyoBase16Encode( char* dest, const void* src, size_t size )
 
 /****************************** Base32 Encoding ******************************/
 
-static const size_t BASE32_INPUT = 5;
-static const size_t BASE32_OUTPUT = 8;
-static const char* const BASE32_TABLE = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567=";
-
 #if 0
 size_t cyoBase32EncodeGetLength( size_t size )
 {
@@ -140,103 +137,13 @@ size_t cyoBase32Encode( char* dest, const void* src, size_t size )
      */
 
     if (dest && src)
-    {
-        unsigned char* pSrc = (unsigned char*)src;
-        size_t dwSrcSize = size;
-        size_t dwDestSize = 0;
-        size_t dwBlockSize;
-        unsigned char n1, n2, n3, n4, n5, n6, n7, n8;
-
-        while (dwSrcSize >= 1)
-        {
-            /* Encode inputs */
-            dwBlockSize = (dwSrcSize < BASE32_INPUT ? dwSrcSize : BASE32_INPUT);
-            n1 = n2 = n3 = n4 = n5 = n6 = n7 = n8 = 0; /* Fortify issue :: False Positive */
-
-            switch (dwBlockSize)
-            {
-            case 5:
-                n8  =  (pSrc[ 4 ] & 0x1f);
-                n7  = ((pSrc[ 4 ] & 0xe0) >> 5);
-	      // fall through 
-            case 4:
-                n7 |= ((pSrc[ 3 ] & 0x03) << 3);
-                n6  = ((pSrc[ 3 ] & 0x7c) >> 2);
-                n5  = ((pSrc[ 3 ] & 0x80) >> 7);
-	      // fall through  
-            case 3:
-                n5 |= ((pSrc[ 2 ] & 0x0f) << 1);
-                n4  = ((pSrc[ 2 ] & 0xf0) >> 4);
-	      // fall through 
-	    case 2:
-                n4 |= ((pSrc[ 1 ] & 0x01) << 4);
-                n3  = ((pSrc[ 1 ] & 0x3e) >> 1);
-                n2  = ((pSrc[ 1 ] & 0xc0) >> 6);
-	      // fall through 
-            case 1:
-                n2 |= ((pSrc[ 0 ] & 0x07) << 2);
-                n1  = ((pSrc[ 0 ] & 0xf8) >> 3);
-                break;
-
-            default:
-                assert( 0 );
-            }
-            pSrc += dwBlockSize;
-            dwSrcSize -= dwBlockSize;
-
-            /* Validate */
-            assert( n1 <= 31 );
-            assert( n2 <= 31 );
-            assert( n3 <= 31 );
-            assert( n4 <= 31 );
-            assert( n5 <= 31 );
-            assert( n6 <= 31 );
-            assert( n7 <= 31 );
-            assert( n8 <= 31 );
-
-            /* Padding */
-            switch (dwBlockSize)
-            {
-            case 1: n3 = n4 = 32;
-	      // fall through 
-            case 2: n5 = 32;
-	      // fall through 
-            case 3: n6 = n7 = 32;
-	      // fall through 
-            case 4: n8 = 32;
-	      // fall through 
-            case 5:
-                break;
-
-            default:
-                assert( 0 );
-            }
-
-            /* 8 outputs */
-            *dest++ = BASE32_TABLE[ n1 ];
-            *dest++ = BASE32_TABLE[ n2 ];
-            *dest++ = BASE32_TABLE[ n3 ];
-            *dest++ = BASE32_TABLE[ n4 ];
-            *dest++ = BASE32_TABLE[ n5 ];
-            *dest++ = BASE32_TABLE[ n6 ];
-            *dest++ = BASE32_TABLE[ n7 ];
-            *dest++ = BASE32_TABLE[ n8 ];
-            dwDestSize += BASE32_OUTPUT;
-        }
-        *dest++ = '\x0'; /*append terminator*/
-
-        return dwDestSize;
-    }
+        return Base32Encode( dest, src, size );
     else
         return 0; /*ERROR - null pointer*/
 }
 
 /****************************** Base64 Encoding ******************************/
 
-static const size_t BASE64_INPUT = 3;
-static const size_t BASE64_OUTPUT = 4;
-static const char* const BASE64_TABLE = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=";
-
 #if 0 
 size_t cyoBase64EncodeGetLength( size_t size )
 {
@@ -257,70 +164,7 @@ size_t cyoBase64Encode( char* dest, const void* src, size_t size )
      */
 
     if (dest && src)
-    {
-        unsigned char* pSrc = (unsigned char*)src;
-        size_t dwSrcSize = size;
-        size_t dwDestSize = 0;
-        size_t dwBlockSize = 0;
-        unsigned char n1, n2, n3, n4;
-
-        while (dwSrcSize >= 1)
-        {
-            /* Encode inputs */
-            dwBlockSize = (dwSrcSize < BASE64_INPUT ? dwSrcSize : BASE64_INPUT);
-            n1 = n2 = n3 = n4 = 0; /* Fortify issue :: False Positive */
-            switch (dwBlockSize)
-            {
-            case 3:
-                n4  =  (pSrc[ 2 ] & 0x3f);
-                n3  = ((pSrc[ 2 ] & 0xc0) >> 6);
-	      // fall through 
-            case 2:
-                n3 |= ((pSrc[ 1 ] & 0x0f) << 2);
-                n2  = ((pSrc[ 1 ] & 0xf0) >> 4);
-	      // fall through 
-            case 1:
-                n2 |= ((pSrc[ 0 ] & 0x03) << 4);
-                n1  = ((pSrc[ 0 ] & 0xfc) >> 2);
-                break;
-
-            default:
-                assert( 0 );
-            }
-            pSrc += dwBlockSize;
-            dwSrcSize -= dwBlockSize;
-
-            /* Validate */
-            assert( n1 <= 63 );
-            assert( n2 <= 63 );
-            assert( n3 <= 63 );
-            assert( n4 <= 63 );
-
-            /* Padding */
-            switch (dwBlockSize)
-            {
-            case 1: n3 = 64;
-	      // fall through 
-            case 2: n4 = 64;
-	      // fall through 
-	    case 3:
-                break;
-
-            default:
-                assert( 0 );
-            }
-
-            /* 4 outputs */
-            *dest++ = BASE64_TABLE[ n1 ];
-            *dest++ = BASE64_TABLE[ n2 ];
-            *dest++ = BASE64_TABLE[ n3 ];
-            *dest++ = BASE64_TABLE[ n4 ];
-            dwDestSize += BASE64_OUTPUT;
-        }
-        *dest++ = '\x0'; /*append terminator*/
-
-        return dwDestSize;
-    }
+        return Base64Encode( dest, src, size );
     else
         return 0; /*ERROR - null pointer*/
 }
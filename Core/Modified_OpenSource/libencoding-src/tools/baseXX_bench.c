@@ -0,0 +1,88 @@
+/****************************************************************
+ *
+ * baseXX_bench.c
+ * Throughput of the Base64/Base32 encoders and decoders of the
+ * BaseXX engine, in MB/s of binary data, for every kernel the
+ * CPU supports:
+ *   baseXX_bench [milliseconds per test]
+ *
+ *****************************************************************/
+
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "time.h"
+
+#include "BaseXX.h"
+
+static const char* kernels[] = { "scalar", "ssse3", "neon" };
+static const size_t sizes[] = { 32, 1024, 65536 };
+
+static double now( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* op 0: base64 encode, 1: base64 decode, 2: base32 encode, 3: base32 decode */
+static double run( int op, unsigned char* bin, char* str, size_t size, double secs )
+{
+    size_t len = op < 2 ? Base64Encode( str, bin, size ) : Base32Encode( str, bin, size );
+    double start = now(), elapsed;
+    unsigned long n = 0, i;
+
+    do
+    {
+        for (i = 0; i < 64; i++)
+        {
+            switch (op)
+            {
+                case 0: Base64Encode( str, bin, size ); break;
+                case 1: Base64Decode( bin, str, len, BASEXX_STRICT ); break;
+                case 2: Base32Encode( str, bin, size ); break;
+                case 3: Base32Decode( bin, str, len, BASEXX_STRICT ); break;
+            }
+        }
+        n += 64;
+        elapsed = now() - start;
+    } while (elapsed < secs);
+    return (double)n * size / elapsed / (1024 * 1024);
+}
+
+int main( int argc, char* argv[] )
+{
+    static const char* ops[] = { "base64 encode", "base64 decode", "base32 encode", "base32 decode" };
+    double secs = (argc > 1 ? atoi( argv[ 1 ] ) : 200) / 1000.0;
+    size_t max = sizes[ sizeof(sizes) / sizeof(sizes[ 0 ]) - 1 ];
+    unsigned char* bin = malloc( max );
+    char* str = malloc( Base32EncodeLength( max ) + 1 );
+    size_t k, s, i;
+    int op;
+
+    if (bin == NULL || str == NULL)
+        return 1;
+    for (i = 0; i < max; i++)
+        bin[ i ] = (unsigned char)rand();
+
+    printf( "%-8s %-14s", "kernel", "" );
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[ 0 ]); s++)
+        printf( " %9zu B", sizes[ s ] );
+    printf( "\n" );
+    for (k = 0; k < sizeof(kernels) / sizeof(kernels[ 0 ]); k++)
+    {
+        if (BaseXXSelectKernel( kernels[ k ] ) != 0)
+            continue;
+        for (op = 0; op < 4; op++)
+        {
+            printf( "%-8s %-14s", kernels[ k ], ops[ op ] );
+            for (s = 0; s < sizeof(sizes) / sizeof(sizes[ 0 ]); s++)
+                printf( " %6.0f MB/s", run( op, bin, str, sizes[ s ], secs ) );
+            printf( "\n" );
+        }
+    }
+    free( bin );
+    free( str );
+    return 0;
+}
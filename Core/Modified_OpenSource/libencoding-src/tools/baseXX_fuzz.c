@@ -0,0 +1,249 @@
+/****************************************************************
+ *
+ * baseXX_fuzz.c
+ * Cross-checks the Base64/Base32 entry points of libencoding: the
+ * BaseXX engine (one-shot and streaming), the Cyo functions and
+ * the Encode wrappers, on every kernel the CPU supports against
+ * the scalar kernel, and encodings against a bit-by-bit reference.
+ *
+ * Build with -DBASEXX_LIBFUZZER and -fsanitize=fuzzer to run under
+ * libFuzzer, otherwise it runs random inputs:
+ *   baseXX_fuzz [iterations] [seed]
+ * Build with -DNDEBUG, cyoBase32Decode asserts on some invalid input.
+ *
+ *****************************************************************/
+
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "stdint.h"
+
+#include "BaseXX.h"
+#include "CyoEncode.h"
+#include "CyoDecode.h"
+#include "Encode.h"
+
+#define MAX_INPUT   1024
+#define MAX_OUTPUT  (2 * MAX_INPUT + 64)
+
+static const char* kernels[] = { "ssse3", "neon" };
+
+/* outputs of all entry points for one input, compared between kernels */
+typedef struct
+{
+    size_t        len[ 16 ];
+    unsigned char out[ 16 ][ MAX_OUTPUT ];
+} Results;
+
+static Results ref_results, kernel_results;
+
+#define CHECK( cond, what ) \
+    do { if (!(cond)) { fprintf( stderr, "FAIL: %s (input %zu bytes)\n", what, size ); abort(); } } while (0)
+
+static size_t ref_encode( char* dest, const unsigned char* src, size_t size, int bits )
+{
+    const char* chars = bits == 6 ? "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"
+                                  : "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+    size_t group = bits == 6 ? 4 : 8;
+    size_t i, n = 0;
+    unsigned int acc = 0, nbits = 0;
+
+    for (i = 0; i < size; i++)
+    {
+        acc = (acc << 8) | src[ i ];
+        nbits += 8;
+        while (nbits >= (unsigned int)bits)
+        {
+            nbits -= bits;
+            dest[ n++ ] = chars[ (acc >> nbits) & ((1 << bits) - 1) ];
+        }
+    }
+    if (nbits > 0)
+        dest[ n++ ] = chars[ (acc << (bits - nbits)) & ((1 << bits) - 1) ];
+    while (n % group != 0)
+        dest[ n++ ] = '=';
+    dest[ n ] = '\0';
+    return n;
+}
+
+/* split size bytes into random chunks, seeded from the data */
+static size_t next_chunk( unsigned int* seed, size_t left )
+{
+    *seed = *seed * 1103515245 + 12345;
+    return left == 0 ? 0 : ((*seed >> 16) % (left < 21 ? left : 21)) + 1;
+}
+
+static size_t stream_encode( int b64, char* dest, const unsigned char* src, size_t size )
+{
+    BaseXXStream st;
+    unsigned int seed = (unsigned int)size;
+    size_t n = 0, chunk;
+
+    b64 ? Base64EncodeInit( &st ) : Base32EncodeInit( &st );
+    while ((chunk = next_chunk( &seed, size )) > 0)
+    {
+        n += b64 ? Base64EncodeUpdate( &st, dest + n, src, chunk )
+                 : Base32EncodeUpdate( &st, dest + n, src, chunk );
+        src += chunk;
+        size -= chunk;
+    }
+    return n + (b64 ? Base64EncodeFinal( &st, dest + n ) : Base32EncodeFinal( &st, dest + n ));
+}
+
+static size_t stream_decode( int b64, int mode, unsigned char* dest, const char* src, size_t size )
+{
+    BaseXXStream st;
+    unsigned int seed = (unsigned int)size * 7;
+    size_t n = 0, r, chunk;
+
+    b64 ? Base64DecodeInit( &st, mode ) : Base32DecodeInit( &st, mode );
+    while ((chunk = next_chunk( &seed, size )) > 0)
+    {
+        r = b64 ? Base64DecodeUpdate( &st, dest + n, src, chunk )
+                : Base32DecodeUpdate( &st, dest + n, src, chunk );
+        if (r == BASEXX_ERROR)
+            return BASEXX_ERROR;
+        n += r;
+        src += chunk;
+        size -= chunk;
+    }
+    r = b64 ? Base64DecodeFinal( &st, dest + n ) : Base32DecodeFinal( &st, dest + n );
+    return r == BASEXX_ERROR ? BASEXX_ERROR : n + r;
+}
+
+static void run_entry_points( Results* res, const unsigned char* data, size_t size )
+{
+    char str[ MAX_INPUT + 1 ];
+    int i = 0, mode;
+
+    memset( res, 0xA5, sizeof(*res) );
+    memcpy( str, data, size );
+    str[ size ] = '\0';
+
+    /* data as bytes to encode */
+    res->len[ i ] = cyoBase64Encode( (char*)res->out[ i ], data, size ); i++;
+    res->len[ i ] = cyoBase32Encode( (char*)res->out[ i ], data, size ); i++;
+    res->len[ i ] = strlen( str );
+    Encode64nChar( (char*)res->out[ i ], str, MAX_OUTPUT, (int)strlen( str ) ); i++;
+    res->len[ i ] = Encode32( (unsigned char*)data, (int)size, res->out[ i ] ); i++;
+    res->len[ i ] = stream_encode( 1, (char*)res->out[ i ], data, size ); i++;
+    res->len[ i ] = stream_encode( 0, (char*)res->out[ i ], data, size ); i++;
+
+    /* data as a string to decode */
+    res->len[ i ] = cyoBase64Decode( res->out[ i ], str, size ); i++;
+    res->len[ i ] = cyoBase32Decode( res->out[ i ], str, size ); i++;
+    res->len[ i ] = Decode64( (char*)res->out[ i ], str, MAX_OUTPUT ); i++;
+    res->len[ i ] = Decode64Binary( (char*)res->out[ i ], str, MAX_OUTPUT ); i++;
+    if (size <= 248) /* Decode32 pads into a 256 byte buffer */
+        res->len[ i ] = Decode32( (unsigned char*)str, (int)size, res->out[ i ] );
+    i++;
+    for (mode = BASEXX_STRICT; mode <= BASEXX_LENIENT; mode++)
+    {
+        res->len[ i ] = Base64Decode( res->out[ i ], str, size, mode ); i++;
+        res->len[ i ] = Base32Decode( res->out[ i ], str, size, mode ); i++;
+    }
+}
+
+int LLVMFuzzerTestOneInput( const uint8_t* data, size_t size )
+{
+    static char enc[ MAX_OUTPUT ];
+    static char ref[ MAX_OUTPUT ];
+    static unsigned char dec[ MAX_OUTPUT ], sdec[ MAX_OUTPUT ];
+    size_t k, n, m, j;
+    int mode;
+
+    if (size > MAX_INPUT)
+        return 0;
+
+    /* every kernel agrees with scalar on every entry point */
+    BaseXXSelectKernel( "scalar" );
+    run_entry_points( &ref_results, data, size );
+    for (k = 0; k < sizeof(kernels) / sizeof(kernels[ 0 ]); k++)
+    {
+        if (BaseXXSelectKernel( kernels[ k ] ) != 0)
+            continue;
+        run_entry_points( &kernel_results, data, size );
+        for (j = 0; j < 16; j++)
+            CHECK( ref_results.len[ j ] == kernel_results.len[ j ] &&
+                   memcmp( ref_results.out[ j ], kernel_results.out[ j ], MAX_OUTPUT ) == 0,
+                   kernels[ k ] );
+    }
+    BaseXXSelectKernel( NULL );
+
+    /* encodings match the reference and decode back in both modes */
+    n = Base64Encode( enc, data, size );
+    CHECK( n == ref_encode( ref, data, size, 6 ) && strcmp( enc, ref ) == 0, "base64 encode" );
+    CHECK( stream_encode( 1, ref, data, size ) == n && memcmp( enc, ref, n + 1 ) == 0,
+           "base64 stream encode" );
+    for (mode = BASEXX_STRICT; mode <= BASEXX_LENIENT; mode++)
+    {
+        m = Base64Decode( dec, enc, n, mode );
+        CHECK( m == size && memcmp( dec, data, size ) == 0, "base64 round trip" );
+    }
+    m = cyoBase64DecodeBinary( dec, enc, n );
+    CHECK( m == size && memcmp( dec, data, size ) == 0, "cyo base64 round trip" );
+
+    n = Base32Encode( enc, data, size );
+    CHECK( n == ref_encode( ref, data, size, 5 ) && strcmp( enc, ref ) == 0, "base32 encode" );
+    CHECK( stream_encode( 0, ref, data, size ) == n && memcmp( enc, ref, n + 1 ) == 0,
+           "base32 stream encode" );
+    for (mode = BASEXX_STRICT; mode <= BASEXX_LENIENT; mode++)
+    {
+        m = Base32Decode( dec, enc, n, mode );
+        CHECK( m == size && memcmp( dec, data, size ) == 0, "base32 round trip" );
+    }
+    m = cyoBase32Decode( dec, enc, n );
+    CHECK( m == size && memcmp( dec, data, size ) == 0, "cyo base32 round trip" );
+
+    /* streaming decode of the raw data agrees with one-shot decode */
+    for (mode = BASEXX_STRICT; mode <= BASEXX_LENIENT; mode++)
+    {
+        m = Base64Decode( dec, (const char*)data, size, mode );
+        CHECK( stream_decode( 1, mode, sdec, (const char*)data, size ) == m &&
+               (m == BASEXX_ERROR || memcmp( dec, sdec, m ) == 0), "base64 stream decode" );
+        m = Base32Decode( dec, (const char*)data, size, mode );
+        CHECK( stream_decode( 0, mode, sdec, (const char*)data, size ) == m &&
+               (m == BASEXX_ERROR || memcmp( dec, sdec, m ) == 0), "base32 stream decode" );
+    }
+    return 0;
+}
+
+#ifndef BASEXX_LIBFUZZER
+int main( int argc, char* argv[] )
+{
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/234567==== \r\n";
+    unsigned char data[ MAX_INPUT ];
+    long iterations = argc > 1 ? atol( argv[ 1 ] ) : 100000;
+    long it;
+    size_t size, i;
+
+    srand( argc > 2 ? atoi( argv[ 2 ] ) : 1 );
+    for (it = 0; it < iterations; it++)
+    {
+        size = rand() % (it % 16 == 0 ? MAX_INPUT : 80);
+        for (i = 0; i < size; i++)
+        {
+            /* mostly characters of the alphabets, so decoding gets far */
+            if (it % 3 == 0)
+                data[ i ] = rand();
+            else
+                data[ i ] = alphabet[ rand() % (sizeof(alphabet) - 1) ];
+        }
+        /* and some valid encodings, possibly with one character changed */
+        if (it % 3 == 2 && size > 0)
+        {
+            char enc[ MAX_OUTPUT ];
+            size_t n = (it % 2 ? Base64Encode : Base32Encode)( enc, data, size / 2 );
+
+            memcpy( data, enc, n );
+            size = n;
+            if (size > 0 && rand() % 4 == 0)
+                data[ rand() % size ] = alphabet[ rand() % (sizeof(alphabet) - 1) ];
+        }
+        LLVMFuzzerTestOneInput( data, size );
+    }
+    printf( "%ld inputs OK, kernel %s\n", iterations, BaseXXKernel() );
+    return 0;
+}
+#endif
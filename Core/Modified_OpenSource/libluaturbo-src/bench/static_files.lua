@@ -0,0 +1,88 @@
+#!/usr/bin/env luajit
+--- Requests/s of web.StaticFileHandler for files kept in the static cache,
+-- conditional requests answered with 304, files bigger than the cache sent
+-- with sendfile(2) or read through Lua, and precompressed gzip variants.
+-- Server and client share one IOLoop and talk over loopback, one request
+-- at a time, so the numbers are mainly useful relative to each other.
+--
+-- Usage: luajit bench/static_files.lua [requests per test] [port]
+
+local turbo = require "turbo"
+local iostream = require "turbo.iostream"
+
+local requests = tonumber(arg and arg[1]) or 500
+local port = tonumber(arg and arg[2]) or 8888
+local dir = os.tmpname()
+
+turbo.log.disable_all()
+
+local function write_file(path, size)
+    local f = assert(io.open(path, "wb"))
+    local chunk = string.rep("function f() { return 42; }\n", 64)
+    local left = size
+    while left > 0 do
+        f:write(chunk:sub(1, math.min(left, #chunk)))
+        left = left - #chunk
+    end
+    f:close()
+end
+
+-- A typical WebUI: small assets fit in the cache, the bundle does not.
+os.remove(dir)
+os.execute("mkdir -p " .. dir)
+write_file(dir .. "/app.css", 200 * 1024)
+write_file(dir .. "/bundle.js", 4 * 1024 * 1024)
+write_file(dir .. "/bundle.js.gz", 900 * 1024)
+
+local can_sendfile = iostream.IOStream.can_sendfile
+local function no_sendfile() return false end
+
+local tests = {
+    { "cached 200 KB", "/app.css" },
+    { "cached 200 KB, 304", "/app.css", { ["If-None-Match"] = true } },
+    { "4 MB, sendfile", "/bundle.js" },
+    { "4 MB, read through Lua", "/bundle.js", nil, no_sendfile },
+    { "4 MB, 304", "/bundle.js", { ["If-None-Match"] = true } },
+    { "900 KB gzip variant", "/bundle.js", { ["Accept-Encoding"] = "gzip" } }
+}
+
+-- HTTPClient stays busy until its callback has run, so each request
+-- gets its own client.
+local function fetch(url, opts)
+    return coroutine.yield(turbo.async.HTTPClient():fetch(url, opts))
+end
+
+local function run()
+    local url = "http://127.0.0.1:" .. port
+    for _, t in ipairs(tests) do
+        local name, path, headers, sendfile = t[1], t[2], t[3], t[4]
+        iostream.IOStream.can_sendfile = sendfile or can_sendfile
+        -- First request fills the cache and provides the ETag.
+        local res = fetch(url .. path)
+        local etag = res.headers:get("Etag")
+        local opts = { on_headers = function (h)
+            for k, v in pairs(headers or {}) do
+                h:add(k, v == true and etag or v)
+            end
+        end }
+        local bytes, status = 0, res.code
+        local start = turbo.util.gettimemonotonic()
+        for i = 1, requests do
+            res = fetch(url .. path, opts)
+            status = res.code
+            bytes = bytes + (res.body and #res.body or 0)
+        end
+        local secs = (turbo.util.gettimemonotonic() - start) / 1000
+        print(string.format("%-26s %d  %8.0f requests/s %8.1f MB/s",
+            name, status, requests / secs, bytes / secs / (1024 * 1024)))
+    end
+    iostream.IOStream.can_sendfile = can_sendfile
+    os.execute("rm -rf " .. dir)
+    turbo.ioloop.instance():close()
+end
+
+turbo.web.Application({
+    { "^/(.*)$", turbo.web.StaticFileHandler, dir .. "/" }
+}):listen(port)
+turbo.ioloop.instance():add_callback(run)
+turbo.ioloop.instance():start()
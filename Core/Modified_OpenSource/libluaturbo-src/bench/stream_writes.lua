@@ -0,0 +1,78 @@
+#!/usr/bin/env luajit
+--- Streaming responses made of many small writes, the pattern of
+-- long-polling and event stream endpoints. Reports requests/s, the bytes
+-- written per write syscall on the server side and the use of the shared
+-- write chunk pool. Server and client share one IOLoop and talk over
+-- loopback.
+--
+-- Usage: luajit bench/stream_writes.lua [requests per test] [port]
+
+local turbo = require "turbo"
+local chunkbuffer = require "turbo.structs.chunkbuffer"
+
+local requests = tonumber(arg and arg[1]) or 500
+local port = tonumber(arg and arg[2]) or 8888
+
+turbo.log.disable_all()
+
+local event = "data: " .. string.rep("{\"Reading\":42.5,\"Health\":\"OK\"}", 4) ..
+    "\n\n"
+
+-- Each request: `events` events, flushed to the stream every `batch` events.
+local events, batch
+local streams = {}
+
+local EventHandler = class("EventHandler", turbo.web.RequestHandler)
+function EventHandler:get()
+    streams[#streams + 1] = self.request.connection.stream
+    self:set_chunked_write()
+    self:add_header("Content-Type", "text/event-stream")
+    for i = 1, events do
+        self:write(event)
+        if i % batch == 0 then
+            self:flush()
+        end
+    end
+    self:finish()
+end
+
+local tests = {
+    { "10 events, 1 flush", 10, 10 },
+    { "200 events, flush each", 200, 1 },
+    { "2000 events, flush each", 2000, 1 },
+    { "2000 events, flush per 50", 2000, 50 }
+}
+
+local function run()
+    local url = "http://127.0.0.1:" .. port .. "/events"
+    for _, t in ipairs(tests) do
+        events, batch = t[2], t[3]
+        streams = {}
+        local bytes = 0
+        local start = turbo.util.gettimemonotonic()
+        for i = 1, requests do
+            local res = coroutine.yield(turbo.async.HTTPClient():fetch(url))
+            bytes = bytes + #res.body
+        end
+        local secs = (turbo.util.gettimemonotonic() - start) / 1000
+        local written, syscalls = 0, 0
+        for _, stream in ipairs(streams) do
+            local stats = stream:_get_write_stats()
+            written = written + stats.bytes
+            syscalls = syscalls + stats.syscalls
+        end
+        local pool = chunkbuffer.pool_stats()
+        print(string.format(
+            "%-26s %7.0f requests/s %7.1f MB/s %8.0f bytes/syscall " ..
+            "%4d chunks pooled",
+            t[1], requests / secs, bytes / secs / (1024 * 1024),
+            written / syscalls, pool.pooled))
+    end
+    turbo.ioloop.instance():close()
+end
+
+turbo.web.Application({
+    { "^/events$", EventHandler }
+}):listen(port)
+turbo.ioloop.instance():add_callback(run)
+turbo.ioloop.instance():start()
@@ -338,6 +338,12 @@ if platform.__LINUX__ then
         int open(const char *pathname, int flags);
         int close(int fd);
         int fstat(int fd, struct stat *buf);
+        ssize_t sendfile(int out_fd, int in_fd, long *offset, size_t count);
+        struct iovec{
+            void *iov_base;
+            size_t iov_len;
+        };
+        ssize_t writev(int fd, const struct iovec *iov, int iovcnt);
     ]]
 
     -- stat structure is architecture dependent in Linux
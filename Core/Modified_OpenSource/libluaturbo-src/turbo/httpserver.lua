@@ -22,6 +22,7 @@ local ioloop =      require "turbo.ioloop"
 local iostream =    require "turbo.iostream"
 local util =        require "turbo.util"
 local log =         require "turbo.log"
+local ffi =         require "ffi"
 require('turbo.3rdparty.middleclass')
 
 local httpserver = {} -- httpserver namespace
@@ -193,6 +194,29 @@ function httpserver.HTTPConnection:write_zero_copy(buf, callback, arg)
     end
 end
 
+--- Send count bytes of file descriptor fd from offset with sendfile(2),
+-- without reading the file into memory. The same restrictions as for
+-- HTTPConnection:write_zero_copy apply. The stream closes fd when done, see
+-- IOStream:sendfile.
+-- @param fd (Number) File descriptor opened for reading.
+-- @param offset (Number) Offset in file of first byte to send.
+-- @param count (Number) Number of bytes to send.
+-- @param callback (Function) Optional function called when file is sent.
+-- @param arg Optional first argument for callback.
+function httpserver.HTTPConnection:sendfile(fd, offset, count, callback, arg)
+    if not self._request then
+        ffi.C.close(fd)
+        error("Request closed.")
+    end
+    if not self.stream:closed() then
+        self:_set_write_callback(callback, arg)
+        self.stream:sendfile(fd, offset, count, self._on_write_complete, self)
+    else
+        ffi.C.close(fd)
+        log.devel("[httpserver.lua] Trying to do sendfile operation on closed stream.")
+    end
+end
+
 --- Finishes the request.
 function httpserver.HTTPConnection:finish()
     assert(self._request, "Request closed")
@@ -488,6 +512,24 @@ function httpserver.HTTPRequest:write_zero_copy(buf, callback, arg)
     self.connection:write_zero_copy(buf, callback, arg)
 end
 
+--- Send part of a file without reading it into memory. Only possible when
+-- HTTPRequest:can_sendfile returns true, see HTTPConnection:sendfile.
+-- @param fd (Number) File descriptor opened for reading, closed when done.
+-- @param offset (Number) Offset in file of first byte to send.
+-- @param count (Number) Number of bytes to send.
+-- @param callback Optional callback when file is sent.
+-- @param arg Optional first argument for callback.
+function httpserver.HTTPRequest:sendfile(fd, offset, count, callback, arg)
+    self.connection:sendfile(fd, offset, count, callback, arg)
+end
+
+--- Returns true if the request can be answered with HTTPRequest:sendfile,
+-- i.e. it arrived on a plain (non SSL) socket on Linux.
+-- @return (Boolean)
+function httpserver.HTTPRequest:can_sendfile()
+    return self.connection ~= nil and self.connection.stream:can_sendfile()
+end
+
 --- Finish the request. Close connection.
 function httpserver.HTTPRequest:finish()
     self.connection:finish()
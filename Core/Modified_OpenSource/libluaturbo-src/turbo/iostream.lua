@@ -26,6 +26,7 @@ local log =         require "turbo.log"
 local ioloop =      require "turbo.ioloop"
 local deque =       require "turbo.structs.deque"
 local buffer =      require "turbo.structs.buffer"
+local chunkbuffer = require "turbo.structs.chunkbuffer"
 local socket =      require "turbo.socket_ffi"
 local sockutils =   require "turbo.sockutil"
 local util =        require "turbo.util"
@@ -65,9 +66,12 @@ local C = ffi.C
 -- (16384+1024) bytes, which is the default max used by axTLS.
 _G.TURBO_SOCKET_BUFFER_SZ = _G.TURBO_SOCKET_BUFFER_SZ or (16384+1024)
 local TURBO_SOCKET_BUFFER_SZ =  _G.TURBO_SOCKET_BUFFER_SZ
-local buf
+-- Maximum number of write buffer chunks passed to one writev(2) call.
+local TURBO_IOV_MAX = 64
+local buf, iov
 if platform.__LINUX__  and not _G.__TURBO_USE_LUASOCKET__ then
     buf = ffi.new("char[?]", TURBO_SOCKET_BUFFER_SZ)
+    iov = ffi.new("struct iovec[?]", TURBO_IOV_MAX)
 end
 
 local iostream = {} -- iostream namespace
@@ -78,6 +82,9 @@ local iostream = {} -- iostream namespace
 -- its operations. For read operations the class supports methods suchs as
 -- read until delimiter, read n bytes and read until close. The class has
 -- its own write buffer and there is no need to buffer data at any other level.
+-- The write buffer is a list of chunks from a pool shared by all streams,
+-- an idle stream holds no write buffer memory, and it is flushed with one
+-- writev(2) call per write event.
 -- The default maximum write buffer is defined to 100 MB. This can be
 -- defined on class initialization.
 iostream.IOStream = class('IOStream')
@@ -99,9 +106,11 @@ function iostream.IOStream:initialize(fd, io_loop, max_buffer_size)
     self._read_buffer_size = 0
     self._read_buffer_offset = 0
     self._read_scan_offset = 0
-    self._write_buffer = buffer(1024)
+    self._write_buffer = chunkbuffer()
     self._write_buffer_size = 0
     self._write_buffer_offset = 0
+    self._bytes_written = 0
+    self._write_syscalls = 0
     self._pending_callbacks = 0
     self._read_until_close = false
     self._connecting = false
@@ -306,6 +315,10 @@ function iostream.IOStream:write(data, callback, arg)
             tonumber(self._write_buffer_offset),
             tonumber(self._const_write_buffer:len())))
     end
+    if self._sendfile_fd then
+        error("Can not perform write when there is a ongoing sendfile \
+            operation.")
+    end
     self:_check_closed()
     self._write_buffer:append_luastr_right(data)
     self._write_buffer_size = self._write_buffer_size + data:len()
@@ -320,6 +333,18 @@ end
 -- @param callback (Function) Optional callback to call when chunk is flushed.
 -- @param arg Optional argument for callback.
 function iostream.IOStream:write_buffer(buf, callback, arg)
+    local ptr, sz = buf:get()
+    self:write_ptr(ptr, sz, callback, arg)
+end
+
+--- Write sz bytes at the given pointer to the stream. The data is copied
+-- to the write buffer before returning, so this avoids creating a Lua string
+-- for data that is already in C memory, e.g. protocol headers.
+-- @param ptr (char *) Data to write.
+-- @param sz (Number) Number of bytes to write.
+-- @param callback (Function) Optional callback to call when chunk is flushed.
+-- @param arg Optional argument for callback.
+function iostream.IOStream:write_ptr(ptr, sz, callback, arg)
     if self._const_write_buffer then
         error(string.format("\
             Can not perform write when there is a ongoing \
@@ -327,8 +352,11 @@ function iostream.IOStream:write_buffer(buf, callback, arg)
             tonumber(self._write_buffer_offset),
             tonumber(self._const_write_buffer:len())))
     end
+    if self._sendfile_fd then
+        error("Can not perform write when there is a ongoing sendfile \
+            operation.")
+    end
     self:_check_closed()
-    local ptr, sz = buf:get()
     self._write_buffer:append_right(ptr, sz)
     self._write_buffer_size = self._write_buffer_size + sz
     self._write_callback = callback
@@ -366,6 +394,43 @@ if platform.__LINUX__ and not _G.__TURBO_USE_LUASOCKET__ then
         self:_add_io_state(ioloop.WRITE)
         self:_maybe_add_error_listener()
     end
+
+    --- Write count bytes of the open file fd, starting at offset, to the
+    -- stream with sendfile(2), without reading the file into Lua memory.
+    -- As with write_zero_copy, no other writes can be performed until this
+    -- has completed. The stream takes ownership of fd and closes it once the
+    -- file has been sent or the stream is closed. Check
+    -- IOStream:can_sendfile() first, SSL streams do not support this.
+    -- @param fd (Number) File descriptor opened for reading.
+    -- @param offset (Number) Offset in file of first byte to send.
+    -- @param count (Number) Number of bytes to send.
+    -- @param callback (Function) Optional callback to call when file is sent.
+    -- @param arg Optional argument for callback.
+    function iostream.IOStream:sendfile(fd, offset, count, callback, arg)
+        if self._write_buffer_size ~= 0 or self._const_write_buffer or
+            self._sendfile_fd then
+            C.close(fd)
+            error("Can not perform sendfile when there are unfinished \
+                writes in stream.")
+        end
+        if not self.socket then
+            C.close(fd)
+        end
+        self:_check_closed()
+        self._sendfile_fd = fd
+        self._sendfile_offset = ffi.new("long[1]", offset)
+        self._sendfile_remaining = count
+        self._write_callback = callback
+        self._write_callback_arg = arg
+        self:_add_io_state(ioloop.WRITE)
+        self:_maybe_add_error_listener()
+    end
+
+    --- Can IOStream:sendfile() be used on this stream?
+    -- @return (Boolean) true or false
+    function iostream.IOStream:can_sendfile()
+        return true
+    end
 else
     -- write_zero_copy is not supported on LuaSocket. It gives no
     -- benefit as LuaSocket only deals in Lua strings...
@@ -383,6 +448,10 @@ else
         local str = ffi.string(ptr, sz)
         self:write(str, callback, arg)
     end
+
+    function iostream.IOStream:can_sendfile()
+        return false
+    end
 end
 
 --- Are the stream currently being read from?
@@ -394,7 +463,21 @@ end
 --- Are the stream currently being written too.
 -- @return (Boolean) true or false
 function iostream.IOStream:writing()
-    return self._write_buffer_size ~= 0 or self._const_write_buffer
+    return self._write_buffer_size ~= 0 or self._const_write_buffer or
+        self._sendfile_fd ~= nil
+end
+
+--- Internal write statistics for the stream, for diagnostics.
+-- @return table with bytes (written to the socket), syscalls (write
+-- syscalls made, including those that would block), buffered (bytes waiting
+-- in the write buffer) and chunks (write buffer chunks held).
+function iostream.IOStream:_get_write_stats()
+    return {
+        bytes = self._bytes_written,
+        syscalls = self._write_syscalls,
+        buffered = self._write_buffer_size,
+        chunks = self._write_buffer:nchunks()
+    }
 end
 
 --- Set callback to be called when connection is closed.
@@ -446,11 +529,18 @@ function iostream.IOStream:close()
             self._state = nil
         end
         if platform.__LINUX__ and not _G.__TURBO_USE_LUASOCKET__ then
+            if self._sendfile_fd then
+                C.close(self._sendfile_fd)
+                self._sendfile_fd = nil
+            end
             C.close(self.socket)
         else
             self.socket:close()
         end
         self.socket = nil
+        -- Unsent data is dropped, return its chunks to the pool.
+        self._write_buffer:clear()
+        self._write_buffer_size = 0
         if self._close_callback and self._pending_callbacks == 0 then
             local callback = self._close_callback
             local arg = self._close_callback_arg
@@ -858,13 +948,10 @@ end
 if platform.__LINUX__ and not _G.__TURBO_USE_LUASOCKET__ then
     function iostream.IOStream:_handle_write_nonconst()
         local errno, fd
-        local ptr, sz = self._write_buffer:get()
-        local buf = ptr + self._write_buffer_offset
-        local num_bytes = tonumber(C.send(
-            self.socket,
-            buf,
-            self._write_buffer_size,
-            0))
+        -- Hand as many chunks as possible to the kernel in one syscall.
+        local iovcnt = self._write_buffer:fill_iovec(iov, TURBO_IOV_MAX)
+        local num_bytes = tonumber(C.writev(self.socket, iov, iovcnt))
+        self._write_syscalls = self._write_syscalls + 1
         if num_bytes == -1 then
             errno = ffi.errno()
             if errno == EWOULDBLOCK or errno == EAGAIN then
@@ -887,12 +974,11 @@ if platform.__LINUX__ and not _G.__TURBO_USE_LUASOCKET__ then
         if num_bytes == 0 then
             return
         end
-        self._write_buffer_offset = self._write_buffer_offset + num_bytes
+        self._write_buffer:pop_left(num_bytes)
         self._write_buffer_size = self._write_buffer_size - num_bytes
+        self._bytes_written = self._bytes_written + num_bytes
         if self._write_buffer_size == 0 then
-            -- Buffer reached end. Reset offset and size.
-            self._write_buffer:clear()
-            self._write_buffer_offset = 0
+            -- Buffer reached end, its chunks are back in the pool.
             if self._write_callback then
                 -- Current buffer completely flushed.
                 local callback = self._write_callback
@@ -915,6 +1001,7 @@ if platform.__LINUX__ and not _G.__TURBO_USE_LUASOCKET__ then
             ptr,
             _sz,
             0)
+        self._write_syscalls = self._write_syscalls + 1
         if num_bytes == -1 then
             errno = ffi.errno()
             if errno == EWOULDBLOCK or errno == EAGAIN then
@@ -938,6 +1025,7 @@ if platform.__LINUX__ and not _G.__TURBO_USE_LUASOCKET__ then
             return
         end
         self._write_buffer_offset = self._write_buffer_offset + num_bytes
+        self._bytes_written = self._bytes_written + tonumber(num_bytes)
         if sz == self._write_buffer_offset then
             -- Buffer reached end. Remove reference to const write buffer.
             self._write_buffer_offset = 0
@@ -952,14 +1040,68 @@ if platform.__LINUX__ and not _G.__TURBO_USE_LUASOCKET__ then
             end
         end
     end
+
+    function iostream.IOStream:_handle_write_sendfile()
+        local errno, fd
+        if self._sendfile_remaining > 0 then
+            local num_bytes = tonumber(C.sendfile(
+                self.socket,
+                self._sendfile_fd,
+                self._sendfile_offset,
+                min(self._sendfile_remaining, 0x7ffff000)))
+            self._write_syscalls = self._write_syscalls + 1
+            if num_bytes == -1 then
+                errno = ffi.errno()
+                if errno == EWOULDBLOCK or errno == EAGAIN then
+                    return
+                elseif errno == EPIPE or errno == ECONNRESET then
+                    -- Connection reset. Close the socket.
+                    fd = self.socket
+                    self:close()
+                    log.warning(string.format(
+                        "Connection closed on fd %d.",
+                        fd))
+                    return
+                end
+                fd = self.socket
+                self:close()
+                error(string.format("Error when sending file to fd %d, %s",
+                    fd,
+                    socket.strerror(errno)))
+            end
+            if num_bytes == 0 then
+                -- File shrunk since its size was sent to the peer.
+                fd = self.socket
+                self:close()
+                log.warning(string.format(
+                    "File truncated while sending to fd %d.",
+                    fd))
+                return
+            end
+            self._sendfile_remaining = self._sendfile_remaining - num_bytes
+            self._bytes_written = self._bytes_written + num_bytes
+        end
+        if self._sendfile_remaining == 0 then
+            C.close(self._sendfile_fd)
+            self._sendfile_fd = nil
+            self._sendfile_offset = nil
+            if self._write_callback then
+                -- File completely sent.
+                local callback = self._write_callback
+                local arg = self._write_callback_arg
+                self._write_callback = nil
+                self._write_callback_arg = nil
+                self:_run_callback(callback, arg)
+            end
+        end
+    end
 else
     function iostream.IOStream:_handle_write_nonconst()
         local errno, fd
-        local ptr, sz = self._write_buffer:get()
-        local buf = ptr + self._write_buffer_offset
+        local ptr, sz = self._write_buffer:peek()
         -- Not very optimal to create a new string for LuaSocket.
-        local num_bytes, err = self.socket:send(
-            ffi.string(buf, math.min(self._write_buffer_size, 1024*128)))
+        local num_bytes, err = self.socket:send(ffi.string(ptr, sz))
+        self._write_syscalls = self._write_syscalls + 1
         if err then
             if err == "closed" then
                 log.warning(string.format(
@@ -975,12 +1117,11 @@ else
             self:close()
             return
         end
-        self._write_buffer_offset = self._write_buffer_offset + num_bytes
+        self._write_buffer:pop_left(num_bytes)
         self._write_buffer_size = self._write_buffer_size - num_bytes
+        self._bytes_written = self._bytes_written + num_bytes
         if self._write_buffer_size == 0 then
-            -- Buffer reached end. Reset offset and size.
-            self._write_buffer:clear()
-            self._write_buffer_offset = 0
+            -- Buffer reached end, its chunks are back in the pool.
             if self._write_callback then
                 -- Current buffer completely flushed.
                 local callback = self._write_callback
@@ -1004,7 +1145,9 @@ function iostream.IOStream:_handle_write()
     if not self.socket then
         return
     end
-    if self._const_write_buffer then
+    if self._sendfile_fd then
+        self:_handle_write_sendfile()
+    elseif self._const_write_buffer then
         self:_handle_write_const()
     else
         self:_handle_write_nonconst()
@@ -1163,6 +1306,11 @@ if _G.TURBO_SSL and platform.__LINUX__  and not _G.__TURBO_USE_LUASOCKET__ then
     -- must be set.
     iostream.SSLIOStream = class('SSLIOStream', iostream.IOStream)
 
+    -- Data must pass through SSL_write, see IOStream:sendfile().
+    function iostream.SSLIOStream:can_sendfile()
+        return false
+    end
+
     --- Initialize a new SSLIOStream class instance.
     -- @param fd (Number) File descriptor, either open or closed. If closed then,
     -- the IOStream:connect() method can be used to connect.
@@ -1334,9 +1482,11 @@ if _G.TURBO_SSL and platform.__LINUX__  and not _G.__TURBO_USE_LUASOCKET__ then
             return nil
         end
 
-        local ptr = self._write_buffer:get()
-        ptr = ptr + self._write_buffer_offset
-        local n = crypto.SSL_write(self._ssl, ptr, self._write_buffer_size)
+        -- One chunk at a time, chunks do not move so a retried write
+        -- passes the same buffer as the write that would have blocked.
+        local ptr, sz = self._write_buffer:peek()
+        local n = crypto.SSL_write(self._ssl, ptr, sz)
+        self._write_syscalls = self._write_syscalls + 1
         if n == -1 then
             local err = crypto.SSL_get_error(self._ssl, n)
             if err == crypto.SSL_ERROR_SYSCALL then
@@ -1366,12 +1516,11 @@ if _G.TURBO_SSL and platform.__LINUX__  and not _G.__TURBO_USE_LUASOCKET__ then
         if n == 0 then
             return
         end
-        self._write_buffer_offset = self._write_buffer_offset + n
+        self._write_buffer:pop_left(n)
         self._write_buffer_size = self._write_buffer_size - n
+        self._bytes_written = self._bytes_written + n
         if self._write_buffer_size == 0 then
-            -- Buffer reached end. Reset offset and size.
-            self._write_buffer:clear()
-            self._write_buffer_offset = 0
+            -- Buffer reached end, its chunks are back in the pool.
             if self._write_callback then
                 -- Current buffer completely flushed.
                 local callback = self._write_callback
@@ -0,0 +1,218 @@
+-- Turbo.lua Pooled chunk list buffer implementation
+--
+-- Licensed under the Apache License, Version 2.0 (the "License");
+-- you may not use this file except in compliance with the License.
+-- You may obtain a copy of the License at
+--
+-- http://www.apache.org/licenses/LICENSE-2.0
+--
+-- Unless required by applicable law or agreed to in writing, software
+-- distributed under the License is distributed on an "AS IS" BASIS,
+-- WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+-- See the License for the specific language governing permissions and
+-- limitations under the License.
+
+require "turbo.cdef"
+require 'turbo.3rdparty.middleclass'
+local ffi = require "ffi"
+
+local min = math.min
+
+-- __Global value__ _G.TURBO_CHUNK_SZ sets the size of the chunks used by
+-- ChunkBuffer. Defaults to 16384 bytes.
+_G.TURBO_CHUNK_SZ = _G.TURBO_CHUNK_SZ or 16384
+local CHUNK_SZ = _G.TURBO_CHUNK_SZ
+-- __Global value__ _G.TURBO_CHUNK_POOL_MAX sets the maximum number of free
+-- chunks kept for reuse. Defaults to 256, 4 MB with the default chunk size.
+_G.TURBO_CHUNK_POOL_MAX = _G.TURBO_CHUNK_POOL_MAX or 256
+local CHUNK_POOL_MAX = _G.TURBO_CHUNK_POOL_MAX
+
+-- Free chunks, shared by all ChunkBuffer instances. Chunks are garbage
+-- collected C buffers, chunks dropped from a full pool or left in a buffer
+-- that is collected are freed by the GC.
+local pool = {}
+local pool_sz = 0
+local allocated = 0
+
+local function _chunk_free(ptr)
+    allocated = allocated - 1
+    ffi.C.free(ptr)
+end
+
+local function _chunk_get()
+    if pool_sz ~= 0 then
+        local chunk = pool[pool_sz]
+        pool[pool_sz] = nil
+        pool_sz = pool_sz - 1
+        return chunk
+    end
+    local ptr = ffi.C.malloc(CHUNK_SZ)
+    if ptr == nil then
+        error("No memory.")
+    end
+    allocated = allocated + 1
+    return ffi.gc(ffi.cast("char *", ptr), _chunk_free)
+end
+
+local function _chunk_put(chunk)
+    if pool_sz < CHUNK_POOL_MAX then
+        pool_sz = pool_sz + 1
+        pool[pool_sz] = chunk
+    end
+end
+
+--- Low-level buffer made of a list of fixed size C chunks taken from a pool
+-- shared by all instances. Appending never moves data already in the
+-- buffer, and chunks are returned to the pool as soon as they have been
+-- consumed, so an empty buffer holds no memory. Meant for write buffers that
+-- are drained with writev(2).
+local ChunkBuffer = class('ChunkBuffer')
+
+--- Create a new, empty, buffer.
+-- @return ChunkBuffer instance.
+function ChunkBuffer:initialize()
+    self.chunks = {}
+    self.first = 1
+    self.last = 0
+    self.head = 0 -- Bytes consumed of the first chunk.
+    self.tail = 0 -- Bytes used of the last chunk.
+    self.sz = 0
+end
+
+--- Append data to buffer.
+-- @param data The data to append in char * form.
+-- @param len The length of the data in bytes.
+function ChunkBuffer:append_right(data, len)
+    local chunks = self.chunks
+    local src = ffi.cast("const char *", data)
+    self.sz = self.sz + len
+    while len > 0 do
+        if self.last < self.first or self.tail == CHUNK_SZ then
+            self.last = self.last + 1
+            chunks[self.last] = _chunk_get()
+            self.tail = 0
+        end
+        local n = min(len, CHUNK_SZ - self.tail)
+        ffi.copy(chunks[self.last] + self.tail, src, n)
+        self.tail = self.tail + n
+        src = src + n
+        len = len - n
+    end
+    return self
+end
+
+--- Append Lua string to right side of buffer.
+-- @param str Lua string
+function ChunkBuffer:append_luastr_right(str)
+    if not str then
+        error("Appending a nil value, not possible.")
+    end
+    return self:append_right(str, str:len())
+end
+
+--- Pop bytes from left side of buffer, returning chunks that have been
+-- consumed to the pool. If sz exceeds size of buffer then a error is raised.
+function ChunkBuffer:pop_left(sz)
+    if self.sz < sz then
+        error("Trying to pop_left side greater than total size of buffer")
+    end
+    local chunks = self.chunks
+    self.sz = self.sz - sz
+    while sz > 0 do
+        local used = self.first == self.last and self.tail or CHUNK_SZ
+        local n = min(sz, used - self.head)
+        self.head = self.head + n
+        sz = sz - n
+        if self.head == used then
+            _chunk_put(chunks[self.first])
+            chunks[self.first] = nil
+            self.first = self.first + 1
+            self.head = 0
+        end
+    end
+    if self.sz == 0 then
+        self:clear()
+    end
+    return self
+end
+
+--- Clear buffer and return all chunks to the pool.
+function ChunkBuffer:clear()
+    local chunks = self.chunks
+    for i = self.first, self.last do
+        _chunk_put(chunks[i])
+        chunks[i] = nil
+    end
+    self.first = 1
+    self.last = 0
+    self.head = 0
+    self.tail = 0
+    self.sz = 0
+    return self
+end
+
+--- Get the first contiguous part of the buffer. Must be treated as a const
+-- value, and is only valid until the buffer is modified.
+-- @return char * to data, or nil if empty.
+-- @return size of the part, in bytes.
+function ChunkBuffer:peek()
+    if self.sz == 0 then
+        return nil, 0
+    end
+    local used = self.first == self.last and self.tail or CHUNK_SZ
+    return self.chunks[self.first] + self.head, used - self.head
+end
+
+--- Describe the contents of the buffer in a struct iovec array, for
+-- writev(2).
+-- @param iov struct iovec array.
+-- @param max Number of elements in iov.
+-- @return number of elements filled.
+-- @return number of bytes described.
+function ChunkBuffer:fill_iovec(iov, max)
+    local chunks = self.chunks
+    local n = min(self.last - self.first + 1, max)
+    local bytes = 0
+    for i = 0, n - 1 do
+        local idx = self.first + i
+        local off = i == 0 and self.head or 0
+        local used = idx == self.last and self.tail or CHUNK_SZ
+        iov[i].iov_base = chunks[idx] + off
+        iov[i].iov_len = used - off
+        bytes = bytes + used - off
+    end
+    return n, bytes
+end
+
+--- Get current size of the buffer.
+-- @return size of buffer in bytes.
+function ChunkBuffer:len() return self.sz end
+
+--- Get the number of chunks currently held by this instance.
+-- @return number of chunks.
+function ChunkBuffer:nchunks() return self.last - self.first + 1 end
+
+--- Convert to Lua type string using the tostring() builtin or implicit
+-- conversions.
+function ChunkBuffer:__tostring()
+    local parts = {}
+    for i = self.first, self.last do
+        local off = i == self.first and self.head or 0
+        local used = i == self.last and self.tail or CHUNK_SZ
+        parts[#parts + 1] = ffi.string(self.chunks[i] + off, used - off)
+    end
+    return table.concat(parts)
+end
+
+--- Statistics for the chunk pool shared by all instances.
+-- @return table with chunk_sz, allocated (chunks alive, in buffers or in the
+-- pool) and pooled (free chunks).
+function ChunkBuffer.static.pool_stats()
+    return {
+        chunk_sz = CHUNK_SZ,
+        allocated = allocated,
+        pooled = pool_sz
+    }
+end
+
+return ChunkBuffer
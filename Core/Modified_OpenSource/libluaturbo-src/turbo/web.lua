@@ -755,6 +755,7 @@ local SWCT_NOFILE = -1
 web._StaticWebCache = class("_StaticWebCache")
 function web._StaticWebCache:initialize()
     self.files = {}
+    self.gzip = {}
 end
 
 --- Read complete file.
@@ -766,6 +767,7 @@ function web._StaticWebCache:read_file(path)
         return -1, err
     end
     local file = fd:read("*all")
+    fd:close()
     if not file then
         return -1, err
     end
@@ -781,10 +783,23 @@ function web._StaticWebCache:read_file(path)
     return 0, buf, sha1sum
 end
 
+--- Cache validators for a file: a ETag, the SHA1 checksum if available or
+-- else made from modification time and size, and the Last-Modified date.
+local function _static_validators(stat, sha1sum)
+    local mtime = tonumber(stat.st_mtime)
+    local etag = sha1sum or string.format("\"%x-%x\"",
+        mtime,
+        tonumber(stat.st_size))
+    return etag, util.time_format_http_header(mtime * 1000)
+end
+
 --- Get file. If not in cache, it is read and put in the global _StaticWebCache
--- class.
+-- class. Files bigger than the cache limit are not read, the caller should
+-- open and send them itself.
 -- @path (String) Path to file.
--- @return 0 + buffer (String) on success, else -1.
+-- @return SWCRC_CACHE, stat, buffer, mime, etag, last_modified for cached
+-- files, SWCRC_TOO_BIG, stat, nil, mime, etag, last_modified for files not
+-- kept in memory, else SWCRC_NOT_FOUND.
 function web._StaticWebCache:get_file(path)
     local cf = self.files[path]
 
@@ -792,20 +807,14 @@ function web._StaticWebCache:get_file(path)
     if cf then
         -- index 1 = type
         -- index 2 = stat_t
-        -- index 3 = buf or file
+        -- index 3 = buf
         -- index 4 = mime string (optional)
-        -- index 5 = sha1 checksum
+        -- index 5 = etag
+        -- index 6 = last modified date
         if cf[1] == SWCT_CACHE then
-            return SWCRC_CACHE, cf[2], cf[3], cf[4], cf[5]
+            return SWCRC_CACHE, cf[2], cf[3], cf[4], cf[5], cf[6]
         elseif cf[1] == SWCT_FILE then
-            local file = io.open(path, "rb")
-            if not file then
-                log.error(string.format(
-                    "[web.lua] Could not open file for reading; %s.",
-                    err))
-                return SWCRC_NOT_FOUND
-            end
-            return SWCRC_TOO_BIG, cf[2], file, cf[4]
+            return SWCRC_TOO_BIG, cf[2], nil, cf[4], cf[5], cf[6]
         elseif cf[1] == SWCT_NOFILE then
             return SWCRC_NOT_FOUND
         end
@@ -827,41 +836,27 @@ function web._StaticWebCache:get_file(path)
         end
         -- Small rewrite of table to make it compatible with Linux stat.
         stat.st_size = stat.size
+        stat.st_mtime = stat.modification
     end
 
+    local _, mime = self:get_mime(path)
     if stat.st_size > STATICWEBCACHE_MAX then
         -- File will not be cached because of size.
-        -- Open file ptr instead.
-        local rc, mime = self:get_mime(path)
-        if rc == 0 then
-            self.files[path] = {SWCT_FILE, stat, nil, mime}
-        else
-            self.files[path] = {SWCT_FILE, stat}
-        end
-        local file, err = io.open(path, "rb")
-        if not file then
-            log.error(string.format(
-                "[web.lua] Could not open file for reading; %s.",
-                err))
-            return SWCRC_NOT_FOUND
-        end
-        return SWCRC_TOO_BIG, stat, file, mime
+        local etag, last_modified = _static_validators(stat)
+        self.files[path] = {SWCT_FILE, stat, nil, mime, etag, last_modified}
+        return SWCRC_TOO_BIG, stat, nil, mime, etag, last_modified
     end
     -- Small size, relative to STATICWEBCACHE_MAX, load file to
     -- a buffer.
     local rc, buf, sha1sum = self:read_file(path)
     if rc == 0 then
-        local rc, mime = self:get_mime(path)
-        if rc == 0 then
-            self.files[path] = {SWCT_CACHE, stat, buf, mime, sha1sum}
-        else
-            self.files[path] = {SWCT_CACHE, stat, buf, nil, sha1sum}
-        end
+        local etag, last_modified = _static_validators(stat, sha1sum)
+        self.files[path] = {SWCT_CACHE, stat, buf, mime, etag, last_modified}
         log.notice(string.format(
             "[web.lua] Added %s (%d bytes) to static file cache. ",
             path,
             tonumber(buf:len())))
-        return SWCRC_CACHE, stat, buf, mime, sha1sum
+        return SWCRC_CACHE, stat, buf, mime, etag, last_modified
     else
         log.error(string.format(
             "[web.lua] Could not read file; %s.",
@@ -871,6 +866,23 @@ function web._StaticWebCache:get_file(path)
 
 end
 
+--- Check for a precompressed variant of a file, path .. ".gz", which is sent
+-- instead to clients accepting gzip encoding. The result is cached.
+-- @param path (String) Path to uncompressed file.
+-- @return true or false.
+function web._StaticWebCache:has_gzip(path)
+    local gz = self.gzip[path]
+    if gz == nil then
+        local file = io.open(path .. ".gz", "rb")
+        gz = file ~= nil
+        if file then
+            file:close()
+        end
+        self.gzip[path] = gz
+    end
+    return gz
+end
+
 --- Determine MIME type according to file exstension.
 -- @error If no filename is set, a error is raised.
 -- @return 0 + MIME (String) on success, else -1.
@@ -896,9 +908,11 @@ web.STATIC_CACHE = STATIC_CACHE
 
 --- Simple static file handler class.
 -- File system path is provided in the Application class.
--- If you are planning to serve big files, then it is recommended to use a
--- proper static file web server instead. For small files that can be kept
--- in memory it is ok.
+-- Files up to _G.TURBO_STATIC_MAX bytes (1 MB by default) are kept in memory.
+-- Bigger files are sent with sendfile(2) on plain sockets on Linux and read
+-- in chunks otherwise. A precompressed "<file>.gz" next to a file is sent to
+-- clients accepting gzip encoding. Responses carry ETag and Last-Modified
+-- headers and conditional requests are answered with 304.
 web.StaticFileHandler = class("StaticFileHandler", web.RequestHandler)
 function web.StaticFileHandler:prepare()
     if not self.options or type(self.options) ~= "string" then
@@ -956,6 +970,44 @@ function web.StaticFileHandler:_send_from_file(stat, file)
     self:flush(self._send_next_chunk, self)
 end
 
+function web.StaticFileHandler:_sendfile_cb()
+    self.request:sendfile(
+        self._sendfile_fd,
+        0,
+        tonumber(self._file_stat.st_size),
+        self.finish,
+        self)
+    self._sendfile_fd = nil
+end
+
+--- Send a file too big for the cache, with sendfile(2) if the connection
+-- allows it.
+-- @return false if the file could not be opened.
+function web.StaticFileHandler:_send_big_file(full_path, stat)
+    if self.request:can_sendfile() then
+        local fd = ffi.C.open(full_path, socket.O_RDONLY)
+        if fd == -1 then
+            log.error(string.format(
+                "[web.lua] Could not open file for reading; %s.",
+                socket.strerror(ffi.errno())))
+            return false
+        end
+        self._sendfile_fd = fd
+        self._file_stat = stat
+        self:flush(self._sendfile_cb, self)
+        return true
+    end
+    local file, err = io.open(full_path, "rb")
+    if not file then
+        log.error(string.format(
+            "[web.lua] Could not open file for reading; %s.",
+            err))
+        return false
+    end
+    self:_send_from_file(stat, file)
+    return true
+end
+
 --- GET method for static file handling.
 -- @param path The path captured from request.
 function web.StaticFileHandler:get(path)
@@ -975,36 +1027,53 @@ function web.StaticFileHandler:get(path)
         full_path = self.path
     end
 
-    local rc, stat, buf, mime, sha1 = STATIC_CACHE:get_file(full_path)
+    -- Prefer a precompressed variant if the client accepts it.
+    local file_path = full_path
+    if STATIC_CACHE:has_gzip(full_path) then
+        self:add_header("Vary", "Accept-Encoding")
+        local accept = self.request.headers:get("Accept-Encoding")
+        if accept and accept:find("gzip", 1, true) then
+            file_path = full_path .. ".gz"
+        end
+    end
+
+    local rc, stat, buf, mime, etag, last_modified =
+        STATIC_CACHE:get_file(file_path)
+    if rc == SWCRC_NOT_FOUND then
+        error(web.HTTPError(404)) -- Not found
+    end
+    if file_path ~= full_path then
+        local _
+        _, mime = STATIC_CACHE:get_mime(full_path)
+        self:add_header("Content-Encoding", "gzip")
+    end
     if mime then
         self:add_header("Content-Type", mime)
     end
-    if sha1 then
-        -- Etag check.
-        if self.request.headers:get("If-None-Match") == sha1 then
-            -- Client has the most recent file. Do not send :).
-            self:set_status(304)
-            self:add_header("Etag", sha1)
-            self:finish()
-            return
-        end
+    self:add_header("Etag", etag)
+    self:add_header("Last-Modified", last_modified)
+
+    -- If-None-Match takes precedence over If-Modified-Since.
+    local if_none_match = self.request.headers:get("If-None-Match")
+    if if_none_match == etag or (not if_none_match and
+        self.request.headers:get("If-Modified-Since") == last_modified) then
+        -- Client has the most recent file. Do not send :).
+        self:set_status(304)
+        self:finish()
+        return
     end
+
+    self.headers:set_status_code(200)
+    self.headers:set_version("HTTP/1.1")
     if rc == SWCRC_CACHE then
         self._static_buffer = buf
-        self.headers:set_status_code(200)
-        self.headers:set_version("HTTP/1.1")
         self:add_header("Content-Length", tonumber(buf:len()))
-        if sha1 then
-            self:add_header("Etag", sha1)
-        end
         self:flush(web.StaticFileHandler._headers_flushed_cb, self)
-    elseif rc == SWCRC_TOO_BIG then
-        self.headers:set_status_code(200)
-        self.headers:set_version("HTTP/1.1")
+    else
         self:add_header("Content-Length", tonumber(stat.st_size))
-        self:_send_from_file(stat, buf)
-    elseif rc == SWCRC_NOT_FOUND then
-        error(web.HTTPError(404)) -- Not found
+        if not self:_send_big_file(file_path, stat) then
+            error(web.HTTPError(404))
+        end
     end
 end
 
@@ -1020,12 +1089,15 @@ function web.StaticFileHandler:head(path)
     end
     local full_path = string.format("%s%s", self.path,
         escape.unescape(filename))
-    local rc, buf, mime = STATIC_CACHE:get_file(full_path)
-    if rc == 0 then
+    local rc, stat, buf, mime, etag, last_modified =
+        STATIC_CACHE:get_file(full_path)
+    if rc ~= SWCRC_NOT_FOUND then
         if mime then
-            self:add_header("Content-Type", mime_type)
+            self:add_header("Content-Type", mime)
         end
-        self:add_header("Content-Length", tonumber(buf:len()))
+        self:add_header("Content-Length", tonumber(stat.st_size))
+        self:add_header("Etag", etag)
+        self:add_header("Last-Modified", last_modified)
     else
         error(web.HTTPError(404)) -- Not found
     end
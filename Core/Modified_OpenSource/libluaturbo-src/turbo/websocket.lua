@@ -74,6 +74,7 @@ ffi.cdef [[
 
 local _ws_header = ffi.new("struct ws_header")
 local _ws_mask = ffi.new("int32_t[1]")
+local _ws_out_mask = ffi.new("unsigned char[4]")
 
 local _unmask_payload
 if platform.__WINDOWS__ then
@@ -284,33 +285,33 @@ if le then
         if data_sz < 0x7e then
             _ws_header.len = bit.bor(data_sz,
                                      self.mask_outgoing and 0x80 or 0x0)
-            self.stream:write(ffi.string(_ws_header, 2))
+            self.stream:write_ptr(_ws_header, 2)
 
         -- 16 bit
         elseif data_sz <= 0xffff then
             _ws_header.len = bit.bor(126, self.mask_outgoing and 0x80 or 0x0)
             _ws_header.ext_len.sh = data_sz
             _ws_header.ext_len.sh = ffi.C.htons(_ws_header.ext_len.sh)
-            self.stream:write(ffi.string(_ws_header, 4))
+            self.stream:write_ptr(_ws_header, 4)
 
         -- 64 bit
         else
             _ws_header.len = bit.bor(127, self.mask_outgoing and 0x80 or 0x0)
             _ws_header.ext_len.ll = data_sz
             _ws_header.ext_len.ll = ENDIAN_SWAP_U64(_ws_header.ext_len.ll)
-            self.stream:write(ffi.string(_ws_header, 10))
+            self.stream:write_ptr(_ws_header, 10)
         end
 
         if self.mask_outgoing == true then
             -- Create a random mask.
-            ws_mask = ffi.new("unsigned char[4]")
-            ws_mask[0] = math.random(0x0, 0xff)
-            ws_mask[1] = math.random(0x0, 0xff)
-            ws_mask[2] = math.random(0x0, 0xff)
-            ws_mask[3] = math.random(0x0, 0xff)
-            self.stream:write(ffi.string(ws_mask, 4))
+            _ws_out_mask[0] = math.random(0x0, 0xff)
+            _ws_out_mask[1] = math.random(0x0, 0xff)
+            _ws_out_mask[2] = math.random(0x0, 0xff)
+            _ws_out_mask[3] = math.random(0x0, 0xff)
+            self.stream:write_ptr(_ws_out_mask, 4)
             coroutine.yield (async.task(
-                self.stream.write, self.stream, _unmask_payload(ws_mask, data)))
+                self.stream.write, self.stream,
+                _unmask_payload(_ws_out_mask, data)))
             return
         end
 
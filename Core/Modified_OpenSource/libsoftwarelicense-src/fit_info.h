@@ -25,6 +25,7 @@ fit_status_t fit_info( fit_pointer_t *licenseData ); //lint !e759
 
 int license_fit_check(void);
 int license_fit_check_for_specific_feature(uint32_t);
+int license_fit_bench_feature(uint32_t feature_id, uint32_t count);
 int licensefile_fit_check(char *filepath);
 
 #ifdef __cplusplus
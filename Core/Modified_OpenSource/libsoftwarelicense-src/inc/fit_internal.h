@@ -69,6 +69,9 @@
 /* byte 3 and 4 are the minimal required core version */
 #define FIT_SIZEOF_LICENSE_HEADER			4  
 
+/* number of feature lookups kept in the decoded feature index */
+#define FIT_FEATURE_INDEX_SIZE    16
+
 /* Types ********************************************************************/
 
 /*
@@ -82,6 +85,34 @@ typedef struct fit_cache_data {
     uint8_t dm_hash[FIT_DM_HASH_SIZE];
 } fit_cache_data_t;
 
+/*
+ * Decoded result of a successful FIT_FIND_FEATURE_FIRST lookup. Entries are only
+ * added after the license signature was verified and are dropped when a license
+ * is constructed or updated.
+ */
+typedef struct fit_feature_index_entry {
+    /** license data the entry was decoded from; NULL if entry is unused */
+    uint8_t *lic_data;
+    /** length of above license data */
+    uint32_t lic_length;
+    /** feature id that was looked up */
+    uint32_t feature_id;
+    /** product id and license model of the first matching feature */
+    fit_feature_info_t feature_info;
+    /** tree node path to the first matching feature */
+    fit_lic_scope_t lic_scope;
+} fit_feature_index_entry_t;
+
+/* Global structure for caching decoded feature lookups. */
+typedef struct fit_feature_index {
+    /** next entry to be replaced once all entries are in use */
+    uint8_t next;
+    /** number of lookups served from / missed in the index */
+    uint32_t hits;
+    uint32_t misses;
+    fit_feature_index_entry_t entry[FIT_FEATURE_INDEX_SIZE];
+} fit_feature_index_t;
+
 /** Associate a unique string and a tagid for each member of sproto */
 typedef struct fit_sproto_types {
     /** String to be associated with each member of sproto */
@@ -256,6 +287,9 @@ fit_status_t fit_internal_start_consume_feature(fit_feature_ctx_t *context,
 fit_status_t fit_internal_prepare_license_update(fit_license_t* license_old,
                                                  fit_license_t* license_new);
 
+/** Drops all entries of the decoded feature index */
+void fit_feature_index_invalidate(void);
+
 
 #ifdef FIT_USE_SYSTEM_CALLS
 #define fit_memcmp memcmp
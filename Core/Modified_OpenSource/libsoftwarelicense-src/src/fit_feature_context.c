@@ -22,6 +22,9 @@
 #include "fit_mem_read.h"
 #include "fit_internal.h"
 #include "fit_hwdep.h"
+#ifdef FIT_USE_MULTI_THREAD
+#include "fit_mutex.h"
+#endif // #ifdef FIT_USE_MULTI_THREAD
 #include <string.h>
 
 /* Constants ****************************************************************/
@@ -31,10 +34,140 @@
 #define FIT_END_DATE_FIELD                  3u
 #define FIT_CONCURRENCY_FIELD               7u
 
+/* Global Data  *************************************************************/
+
+/* Decoded FIT_FIND_FEATURE_FIRST lookups, see fit_feature_index_lookup */
+fit_feature_index_t fit_feature_index = { 0 }; //lint !e765
+
+#ifdef FIT_USE_MULTI_THREAD
+extern fit_mutex_t fit_mutex;
+#endif // #ifdef FIT_USE_MULTI_THREAD
+
 /* Forward Declarations *****************************************************/
 
 /* Functions ****************************************************************/
 
+/**
+ *
+ * \skip fit_feature_index_invalidate
+ *
+ * Drops all entries of the decoded feature index. Has to be called whenever the
+ * license data behind a fit_license_t may have changed.
+ *
+ */
+void fit_feature_index_invalidate(void)
+{
+#ifdef FIT_USE_MULTI_THREAD
+    (void)FIT_MUTEX_LOCK(&fit_mutex);
+#endif // #ifdef FIT_USE_MULTI_THREAD
+
+    DBG(FIT_TRACE_INFO, "[fit_feature_index_invalidate]: hits=%d misses=%d\n",
+        (unsigned int)fit_feature_index.hits, (unsigned int)fit_feature_index.misses);
+    (void)fit_memset((uint8_t *)&fit_feature_index, 0, (int)sizeof(fit_feature_index_t));
+
+#ifdef FIT_USE_MULTI_THREAD
+    (void)FIT_MUTEX_UNLOCK(&fit_mutex);
+#endif // #ifdef FIT_USE_MULTI_THREAD
+}
+
+/**
+ *
+ * \skip fit_feature_index_lookup
+ *
+ * Looks for a decoded FIT_FIND_FEATURE_FIRST result of feature_id in the license
+ * passed in. On a hit feature_h is filled in as fit_internal_find_feature would
+ * have done by walking the license tree.
+ *
+ * @param IN  \b  license_t \n Pointer to fit_license_t structure containing verified
+ *                             license data.
+ *
+ * @param IN  \b  feature_id    \n  feature id which to be looked in index.
+ *
+ * @param OUT \b  feature_h \n Structure containing the feature context.
+ *
+ */
+static fit_boolean_t fit_feature_index_lookup(const fit_license_t *license_t,
+                                              uint32_t feature_id,
+                                              fit_feature_ctx_t* feature_h)
+{
+    fit_boolean_t found = FIT_FALSE;
+    uint8_t cntr        = 0;
+    fit_feature_index_entry_t *entry = NULL;
+
+#ifdef FIT_USE_MULTI_THREAD
+    (void)FIT_MUTEX_LOCK(&fit_mutex);
+#endif // #ifdef FIT_USE_MULTI_THREAD
+
+    for (cntr = 0; cntr < FIT_FEATURE_INDEX_SIZE; cntr++)
+    {
+        entry = &fit_feature_index.entry[cntr];
+        if (entry->lic_data != NULL && entry->lic_data == license_t->license->data &&
+            entry->lic_length == license_t->license->length &&
+            entry->feature_id == feature_id)
+        {
+            (void)fit_memcpy((uint8_t *)&(feature_h->lic_scope), sizeof(fit_lic_scope_t),
+                (uint8_t *)&(entry->lic_scope), sizeof(fit_lic_scope_t));
+            (void)fit_memcpy((uint8_t *)&(feature_h->feature_info), sizeof(fit_feature_info_t),
+                (uint8_t *)&(entry->feature_info), sizeof(fit_feature_info_t));
+            feature_h->lic_verified_marker = FIT_LIC_VERIFIED_MAGIC_NUM;
+            found = FIT_TRUE;
+            break;
+        }
+    }
+    if (found == FIT_TRUE)
+    {
+        fit_feature_index.hits++;
+    }
+    else
+    {
+        fit_feature_index.misses++;
+    }
+
+#ifdef FIT_USE_MULTI_THREAD
+    (void)FIT_MUTEX_UNLOCK(&fit_mutex);
+#endif // #ifdef FIT_USE_MULTI_THREAD
+
+    return found;
+}
+
+/**
+ *
+ * \skip fit_feature_index_add
+ *
+ * Stores the decoded FIT_FIND_FEATURE_FIRST result held by feature_h in the index,
+ * replacing the oldest entry once all entries are in use.
+ *
+ * @param IN  \b  license_t \n Pointer to fit_license_t structure containing verified
+ *                             license data.
+ *
+ * @param IN  \b  feature_h \n Feature context filled in by fit_internal_find_feature.
+ *
+ */
+static void fit_feature_index_add(const fit_license_t *license_t,
+                                  const fit_feature_ctx_t* feature_h)
+{
+    fit_feature_index_entry_t *entry = NULL;
+
+#ifdef FIT_USE_MULTI_THREAD
+    (void)FIT_MUTEX_LOCK(&fit_mutex);
+#endif // #ifdef FIT_USE_MULTI_THREAD
+
+    entry = &fit_feature_index.entry[fit_feature_index.next];
+    fit_feature_index.next = (uint8_t)((fit_feature_index.next + 1u) % FIT_FEATURE_INDEX_SIZE);
+
+    entry->lic_data = license_t->license->data;
+    entry->lic_length = license_t->license->length;
+    entry->feature_id = feature_h->feature_info.feature_id;
+    (void)fit_memcpy((uint8_t *)&(entry->lic_scope), sizeof(fit_lic_scope_t),
+        (uint8_t *)&(feature_h->lic_scope), sizeof(fit_lic_scope_t));
+    (void)fit_memcpy((uint8_t *)&(entry->feature_info), sizeof(fit_feature_info_t),
+        (uint8_t *)&(feature_h->feature_info), sizeof(fit_feature_info_t));
+
+#ifdef FIT_USE_MULTI_THREAD
+    (void)FIT_MUTEX_UNLOCK(&fit_mutex);
+#endif // #ifdef FIT_USE_MULTI_THREAD
+}
+
 /**
  *
  * \skip fit_get_lic_prop_data
@@ -336,6 +469,16 @@ fit_status_t fit_internal_find_feature(fit_license_t *license_t,
     feature_h->lic_data.license = license_t->license;
     feature_h->lic_data.sig_verified_marker = license_t->sig_verified_marker;
 
+    /*
+     * License is verified at this point; a repeated first lookup of the same feature
+     * can be served from the decoded feature index instead of walking the license.
+     */
+    if ((flags & FIT_FIND_FEATURE_FIRST) &&
+        fit_feature_index_lookup(license_t, feature_id, feature_h) == FIT_TRUE)
+    {
+        return FIT_STATUS_OK;
+    }
+
     /*
      * Parse the license data to look for Feature id that will be used for
      * login type operation. On return fetaure_h will contain the path to feature id
@@ -409,6 +552,11 @@ fit_status_t fit_internal_find_feature(fit_license_t *license_t,
         return FIT_STATUS_INVALID_VALUE;
     }
 
+    if (flags & FIT_FIND_FEATURE_FIRST)
+    {
+        fit_feature_index_add(license_t, feature_h);
+    }
+
     return status;
 }
 
@@ -726,6 +726,9 @@ fit_status_t fit_licenf_construct_license(fit_pointer_t *license,
     license_t->keys = keys;
     license_t->sig_verified_marker = 0;
 
+    /* license data may have been reloaded at the same address */
+    fit_feature_index_invalidate();
+
     return status;
 }
 
@@ -347,6 +347,11 @@ fit_status_t fit_licenf_prepare_license_update(fit_license_t* license_old,
 
     /* call internal prepare license update fn that will do actual api task */
     status = fit_internal_prepare_license_update(license_old, license_new);
+    if (status == FIT_STATUS_OK)
+    {
+        /* features of the old license must not be served from the index anymore */
+        fit_feature_index_invalidate();
+    }
 
 #ifdef FIT_USE_MULTI_THREAD
     /* release read lock on read/write lock */
@@ -44,6 +44,46 @@ extern int InitComplete;
 DECLARE_WAIT_QUEUE_HEAD(NCSI_Response);
 DECLARE_WAIT_QUEUE_HEAD(NCSI_WAIT_IFF_UP);
 
+/* Matches a response against the commands sent by SendNCSICommands() */
+static int
+ProcessPendingNCSI(NCSI_IF_INFO *info, struct sk_buff *skb)
+{
+	NCSI_PENDING_CMD *cmd;
+	NCSI_HDR *hdr;
+	int len, i;
+
+	hdr = (NCSI_HDR *)skb_network_header(skb);
+	for (i = 0; i < info->PendingCount; i++)
+	{
+		cmd = &info->Pending[i];
+		if (!cmd->InUse || cmd->Done)
+			continue;
+		if ((cmd->InstanceID != hdr->I_ID) || ((0x80|cmd->Command) != hdr->Command) ||
+		    (cmd->ChannelID != hdr->CH_ID) || (hdr->MC_ID != NCSI_MC_ID))
+			continue;
+
+#if (LINUX_VERSION_CODE > KERNEL_VERSION(3,14,17))
+		len = skb->len-4;
+#else
+		len = skb->len;
+#endif
+		if (len > NCSI_PENDING_SIZE)
+			len = NCSI_PENDING_SIZE;
+		memcpy(cmd->RecvData, hdr, len);
+		cmd->RecvLen = len;
+
+		if (verbose & DUMP_BUFFER)
+			DumpContents(0,(char *)cmd->RecvData,cmd->RecvLen,FORMAT_BYTE,NULL);
+
+		/* The response must be visible before the sender sees Done */
+		smp_wmb();
+		cmd->Done = 1;
+		wake_up_interruptible(&NCSI_Response);
+		return 1;
+	}
+	return 0;
+}
+
 void
 ProcessNCSI(NCSI_IF_INFO *info, struct sk_buff *skb)
 {
@@ -52,6 +92,9 @@ ProcessNCSI(NCSI_IF_INFO *info, struct sk_buff *skb)
 	/* If it is a AEN return */
 	if (CheckIfAEN(info, skb))
 		return;
+
+	if (info->PendingCount && ProcessPendingNCSI(info, skb))
+		return;
 	
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(3,14,17))
 	info->RecvLen = skb->len-4;
@@ -102,11 +145,40 @@ ProcessNCSI(NCSI_IF_INFO *info, struct sk_buff *skb)
 	return;
 }
 
+static int
+TransmitNCSI(NCSI_IF_INFO *info, UINT8 *Data, int Len)
+{
+	struct sk_buff *skb;
+
+	skb = alloc_skb(Len + LL_RESERVED_SPACE(info->dev),GFP_ATOMIC);
+	if (skb == NULL)
+	{
+		printk("NCSI(%s): ERROR Unable to allocate skb\n",info->dev->name);
+		return NCSI_ERR_NOMEM;
+	}
+	skb_reserve(skb,LL_RESERVED_SPACE(info->dev));
+	skb_put(skb,Len);
+	memcpy(skb->data,Data,Len);
+	skb->dev = info->dev;
+	skb->protocol = htons(ETH_P_NCSI);
+	/* If interface is down and not init complete, then wait 5 second for interface up. */
+	if(!(info->dev->flags&IFF_UP) && (InitComplete == 0)){				
+		wait_event_interruptible_timeout(NCSI_WAIT_IFF_UP, (info->dev->flags&IFF_UP), NCSI_IFF_TIMEOUT);			
+		netif_carrier_on(info->dev);
+	}		
+	if (dev_queue_xmit(skb) < 0)
+	{
+		printk("NCSI(%s): ERROR Unable to send skb\n",info->dev->name);
+		return NCSI_ERR_NETWORK;
+	}
+	return NCSI_ERR_SUCCESS;
+}
+
 int 
 SendNCSICommand (NCSI_IF_INFO *info)
 {
 	int i;
-	struct sk_buff *skb;
+	int retval;
 	NCSI_HDR		*NcsiHdr;
 	for (i = 0; i < NCSI_RETRIES; i++)
 	{
@@ -117,29 +189,10 @@ SendNCSICommand (NCSI_IF_INFO *info)
 		if (verbose & DUMP_BUFFER)
 			DumpContents(0,info->SendData+sizeof(ETH_HDR),info->SendLen-sizeof(ETH_HDR),FORMAT_BYTE,NULL);
 
-
-		skb = alloc_skb(info->SendLen + LL_RESERVED_SPACE(info->dev),GFP_ATOMIC);
-		if (skb == NULL)
-		{
-			printk("NCSI(%s): ERROR Unable to allocate skb\n",info->dev->name);
-			return NCSI_ERR_NOMEM;
-		}
-		skb_reserve(skb,LL_RESERVED_SPACE(info->dev));
-		skb_put(skb,info->SendLen);
-		memcpy(skb->data,info->SendData,info->SendLen);
-		skb->dev = info->dev;
-		skb->protocol = htons(ETH_P_NCSI);
 		info->Timeout = 1;
-		/* If interface is down and not init complete, then wait 5 second for interface up. */
-		if(!(info->dev->flags&IFF_UP) && (InitComplete == 0)){				
-			wait_event_interruptible_timeout(NCSI_WAIT_IFF_UP, (info->dev->flags&IFF_UP), NCSI_IFF_TIMEOUT);			
-			netif_carrier_on(info->dev);
-		}		
-		if (dev_queue_xmit(skb) < 0)
-		{
-			printk("NCSI(%s): ERROR Unable to send skb\n",info->dev->name);
-			return NCSI_ERR_NETWORK;
-		}
+		retval = TransmitNCSI(info, info->SendData, info->SendLen);
+		if (retval != NCSI_ERR_SUCCESS)
+			return retval;
 
 		/* Sleep for response or timeout */
 		NcsiHdr = (NCSI_HDR *)(info->SendData + sizeof(ETH_HDR));
@@ -178,4 +231,75 @@ SendNCSICommand (NCSI_IF_INFO *info)
 	return NCSI_ERR_TIMEOUT;
 }
 
-	
+static int
+PendingNCSIDone(NCSI_IF_INFO *info, int Count)
+{
+	int i;
+
+	for (i = 0; i < Count; i++)
+	{
+		if (info->Pending[i].InUse && !info->Pending[i].Done)
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * Sends the first Count commands of info->Pending back to back and waits for
+ * all of them in one response window. Only the commands that timed out are
+ * resent, with their original instance ID. Returns NCSI_ERR_SUCCESS when all
+ * were answered, NCSI_ERR_TIMEOUT otherwise; Done tells which ones were.
+ * Must be called with ProcessPending held.
+ */
+int
+SendNCSICommands (NCSI_IF_INFO *info, int Count)
+{
+	NCSI_PENDING_CMD *cmd;
+	int i, j;
+	int retval;
+
+	if (Count > NCSI_MAX_OUTSTANDING)
+		return NCSI_ERR_FAILED;
+
+	for (j = 0; j < Count; j++)
+		info->Pending[j].Done = 0;
+	info->PendingCount = Count;
+
+	for (i = 0; i < NCSI_RETRIES; i++)
+	{
+		for (j = 0; j < Count; j++)
+		{
+			cmd = &info->Pending[j];
+			if (!cmd->InUse || cmd->Done)
+				continue;
+
+			if (verbose & SHOW_SEND_COMMANDS)
+				printk("NCSI(%s): Sending Request 0x%x (IID 0x%x) to %x.%x...\n",info->dev->name,
+					cmd->Command, cmd->InstanceID, GET_PACKAGE_ID(cmd->ChannelID), GET_CHANNEL_ID(cmd->ChannelID));
+
+			if (verbose & DUMP_BUFFER)
+				DumpContents(0,cmd->SendData+sizeof(ETH_HDR),cmd->SendLen-sizeof(ETH_HDR),FORMAT_BYTE,NULL);
+
+			retval = TransmitNCSI(info, cmd->SendData, cmd->SendLen);
+			if (retval != NCSI_ERR_SUCCESS)
+			{
+				info->PendingCount = 0;
+				return retval;
+			}
+		}
+
+		wait_event_interruptible_timeout(NCSI_Response, PendingNCSIDone(info, Count), NCSI_RESP_TIMEOUT);
+		if (PendingNCSIDone(info, Count))
+			break;
+
+		/* Some controller needs delay before retry a command. */
+		msleep(NCSI_RETRY_TIMEOUT);
+		if (verbose & SHOW_RETRY_MESSAGES)
+			printk ("NCSI: Resending unanswered Commands (Retry = %d)...\n",i+1);
+	}
+
+	info->PendingCount = 0;
+	/* Pairs with the barrier in ProcessPendingNCSI() */
+	smp_rmb();
+	return PendingNCSIDone(info, Count) ? NCSI_ERR_SUCCESS : NCSI_ERR_TIMEOUT;
+}
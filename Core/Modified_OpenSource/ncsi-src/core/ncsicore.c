@@ -33,6 +33,8 @@
 #include <linux/rtnetlink.h>
 #include <asm/byteorder.h>
 #include <linux/delay.h>
+#include <linux/slab.h>
+#include <linux/ktime.h>
 #include "ncsi.h"
 #include "interfaces.h"
 
@@ -51,6 +53,8 @@ extern int UserInitEnabled;
 #endif
 extern unsigned int UserCommand[NCSI_COMMAND_SIZE];
 extern int EnableSetLink;
+extern int PipelineDepth;
+extern char DetectTiming[NCSI_TIMING_SIZE];
 
 extern char UserInterface[];
 extern struct workqueue_struct *ncsi_wq;
@@ -881,11 +885,45 @@ NCSI_Change_MacAddr(struct net_device *dev)
 	return 0;
 }
 
+static int NCSI_Version_Supported (NCSI_IF_INFO *info, UINT8 PackageID, UINT8 ChannelID, UINT32 Ver1)
+{
+    UINT8 Major;
+
+    Major = (Ver1 >> 24) & 0xFF;
+    if ((Major & 0xF0)== 0xF0)
+        Major = Major & 0x0F;
+    if (Major < 1)
+    {
+        printk(KERN_DEBUG "NCSI(%s):%d.%d Version(0x%08lx) is < 1.0  Not supported\n",
+                info->dev->name,PackageID, ChannelID,Ver1);
+        return 0;
+    }
+    return 1;
+}
+
+/* Returns the ChannelInfo index of PackageID:ChannelID, adding it if not found */
+static int NCSI_Channel_Index (NCSI_IF_INFO *info, UINT8 PackageID, UINT8 ChannelID)
+{
+    int i;
+
+    for(i = 0; i < info->TotalChannels; i++)
+    {
+        if ((PackageID == info->ChannelInfo[i].PackageID) && 
+                (ChannelID == info->ChannelInfo[i].ChannelID))
+        {
+            printk (KERN_DEBUG "NCSI(%s):%d.%d ChannelID and PackageID found in %d\n", 
+                    info->dev->name, PackageID, ChannelID, i);
+            return i;
+        }
+    }
+    
+    return info->TotalChannels++;
+}
+
 void NSCI_Detect_Channel (NCSI_IF_INFO *info, UINT8 PackageID, UINT8 ChannelID)
 {
     int i;
     UINT32 Ver1,Ver2,Ver3;
-    UINT8 Major;
     struct net_device *dev;
     
     dev  = info->dev;
@@ -904,32 +942,10 @@ void NSCI_Detect_Channel (NCSI_IF_INFO *info, UINT8 PackageID, UINT8 ChannelID)
     }
 
     printk("Manufacturer ID :: (0x%08lx)\n", Ver3);	
-    Major = (Ver1 >> 24) & 0xFF;
-    if ((Major & 0xF0)== 0xF0)
-        Major = Major & 0x0F;
-    if (Major < 1)
-    {
-        printk(KERN_DEBUG "NCSI(%s):%d.%d Version(0x%08lx) is < 1.0  Not supported\n",
-                dev->name,PackageID, ChannelID,Ver1);
+    if (!NCSI_Version_Supported(info, PackageID, ChannelID, Ver1))
         return;
-    }
 
-    for(i = 0; i < info->TotalChannels; i++)
-    {
-        if ((PackageID == info->ChannelInfo[i].PackageID) && 
-                (ChannelID == info->ChannelInfo[i].ChannelID))
-        {
-            printk (KERN_DEBUG "NCSI(%s):%d.%d ChannelID and PackageID found in %d\n", 
-                    dev->name, PackageID, ChannelID, i);
-            break;
-        }
-    }
-    
-    if (i == info->TotalChannels)
-    {
-        i = info->TotalChannels;
-        info->TotalChannels++;
-    }
+    i = NCSI_Channel_Index(info, PackageID, ChannelID);
     
     /* Get Capabilities and set ArbitSupport */
     if (NCSI_Issue_GetCapabilities(info,PackageID,ChannelID, 
@@ -953,6 +969,122 @@ void NSCI_Detect_Channel (NCSI_IF_INFO *info, UINT8 PackageID, UINT8 ChannelID)
     return;
 }
 
+/*
+ * Same as NSCI_Detect_Channel() for Count channels of the selected package,
+ * but each of Clear Initial State, Get Version ID and Get Capabilities goes
+ * to all of them at once.
+ */
+static void NCSI_Detect_Channels_Pipelined (NCSI_IF_INFO *info, NCSI_PROBE *Probe, int Count)
+{
+    int i, n;
+    UINT32 Cleared = 0, Versioned = 0;
+    struct net_device *dev;
+
+    dev  = info->dev;
+
+    NCSI_Issue_Pipelined(info, CMD_CLEAR_INITIAL_STATE, Probe, Count, PipelineDepth);
+    for (i = 0; i < Count; i++)
+    {
+        if (Probe[i].Status == NCSI_ERR_SUCCESS)
+            Cleared |= (1 << i);
+    }
+
+    NCSI_Issue_Pipelined(info, CMD_GET_VERSION_ID, Probe, Count, PipelineDepth);
+    for (i = 0; i < Count; i++)
+    {
+        if (!(Cleared & (1 << i)))
+            continue;
+        if (Probe[i].Status != NCSI_ERR_SUCCESS)
+        {
+            printk("NCSI(%s):%d.%d Get Version IDFailed\n",dev->name,Probe[i].PackageID, Probe[i].ChannelID);
+            continue;
+        }
+        printk("Manufacturer ID :: (0x%08lx)\n", Probe[i].Ver3);
+        if (NCSI_Version_Supported(info, Probe[i].PackageID, Probe[i].ChannelID, Probe[i].Ver1))
+            Versioned |= (1 << i);
+        else
+            Probe[i].Status = NCSI_ERR_FAILED;
+    }
+
+    NCSI_Issue_Pipelined(info, CMD_GET_CAPABILITIES, Probe, Count, PipelineDepth);
+    for (i = 0; i < Count; i++)
+    {
+        if (!(Versioned & (1 << i)))
+            continue;
+        if (Probe[i].Status != NCSI_ERR_SUCCESS)
+        {
+            printk(KERN_DEBUG "NCSI(%s):%d.%d Get Capabilities Failed\n", dev->name, Probe[i].PackageID, Probe[i].ChannelID);
+            ChannelCount[Probe[i].PackageID] = MAX_CHANNEL_ID;
+            continue;
+        }
+        ChannelCount[Probe[i].PackageID] = Probe[i].ChannelCount;
+
+        n = NCSI_Channel_Index(info, Probe[i].PackageID, Probe[i].ChannelID);
+        info->ChannelInfo[n].Caps = Probe[i].Caps;
+        info->ChannelInfo[n].AENCaps = Probe[i].AENCaps;
+        info->ChannelInfo[n].ArbitSupport = (Probe[i].Caps & HW_ARBITRATION_SUPPORT) ? 1 : 0;
+        info->ChannelInfo[n].PackageID = Probe[i].PackageID;
+        info->ChannelInfo[n].ChannelID = Probe[i].ChannelID;
+        info->IANA_ManID = Probe[i].Ver3;
+        printk(KERN_DEBUG "NCSI(%s):Found NC-SI at Package:Channel (%d:%d)\n", dev->name,Probe[i].PackageID,Probe[i].ChannelID);
+    }
+}
+
+/*
+ * Detects the channels of the selected package. Channel 0 goes first on its
+ * own to learn the channel count, like the sequential loop in NCSI_Detect_Info.
+ */
+static void NCSI_Detect_Package_Pipelined (NCSI_IF_INFO *info, UINT8 PackageID)
+{
+    NCSI_PROBE *Probe;
+    int ChannelID, Count, i;
+
+    Probe = kmalloc(sizeof(NCSI_PROBE) * MAX_CHANNEL_ID, GFP_KERNEL);
+    if (Probe == NULL)
+    {
+        printk("NCSI(%s): ERROR Unable to allocate probe table\n",info->dev->name);
+        return;
+    }
+
+    for (ChannelID = 0; ChannelID < ChannelCount[PackageID]; ChannelID += Count)
+    {
+        Count = (ChannelID == 0) ? 1 : ChannelCount[PackageID] - ChannelID;
+        if (Count > MAX_CHANNEL_ID - ChannelID)
+            Count = MAX_CHANNEL_ID - ChannelID;
+        if (Count <= 0)
+            break;
+
+        memset(Probe, 0, sizeof(NCSI_PROBE) * Count);
+        for (i = 0; i < Count; i++)
+        {
+            Probe[i].PackageID = PackageID;
+            Probe[i].ChannelID = ChannelID + i;
+            Probe[i].Status = NCSI_ERR_SUCCESS;
+        }
+        NCSI_Detect_Channels_Pipelined(info, Probe, Count);
+    }
+
+    kfree(Probe);
+}
+
+static int TimingLen;
+
+/* Appends a line to the DetectTiming sysctl, and logs it for SHOW_TIMING_INFO */
+static void
+NCSI_Trace_Timing(const char *fmt, ...)
+{
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vscnprintf(&DetectTiming[TimingLen], NCSI_TIMING_SIZE - TimingLen, fmt, args);
+	va_end(args);
+
+	if (verbose & SHOW_TIMING_INFO)
+		printk("NCSI: %s", &DetectTiming[TimingLen]);
+	TimingLen += len;
+}
+
 void NCSI_Configure_Channel (NCSI_IF_INFO *info, UINT8 PackageID, UINT8 ChannelID)
 {
     UINT8 MACAddr[6];
@@ -1183,6 +1315,10 @@ NCSI_Detect_Info(NCSI_IF_INFO *info)
 	int i;
 
 	UINT8   HwArbit = 0;
+	NCSI_PROBE Present[MAX_PACKAGE_ID];
+	int Pipelined = (PipelineDepth > 1);
+	int Found;
+	ktime_t Start, Phase;
 
 #ifdef CONFIG_SPX_FEATURE_NCSI_DISABLE_HW_ARBITRATION
 	HwArbit = 1;
@@ -1210,34 +1346,77 @@ NCSI_Detect_Info(NCSI_IF_INFO *info)
 		return;
 	}
 
+	TimingLen = 0;
+	DetectTiming[0] = 0;
+	if (Pipelined)
+		NCSI_Trace_Timing("%s: pipelined, depth %d\n", dev->name, PipelineDepth);
+	else
+		NCSI_Trace_Timing("%s: sequential\n", dev->name);
+	Start = Phase = ktime_get();
+
 	info->TotalChannels = 0;
-	/* Blindly deselect all  packages, except package ID 0 as it will be selected in the next loop. */
-	for (PackageID = 1; PackageID < MAX_PACKAGE_ID; PackageID++)
-		NCSI_Issue_DeSelectPackage(info,PackageID);
+	if (Pipelined)
+	{
+		/* Deselect all packages at once. The ones that answer are present, so
+		   the absent ones share a single response timeout. */
+		for (PackageID = 0; PackageID < MAX_PACKAGE_ID; PackageID++)
+		{
+			memset(&Present[PackageID], 0, sizeof(NCSI_PROBE));
+			Present[PackageID].PackageID = PackageID;
+			Present[PackageID].Status = NCSI_ERR_SUCCESS;
+		}
+		NCSI_Issue_Pipelined(info, CMD_DESELECT_PACKAGE, Present, MAX_PACKAGE_ID, PipelineDepth);
+	}
+	else
+	{
+		/* Blindly deselect all  packages, except package ID 0 as it will be selected in the next loop. */
+		for (PackageID = 1; PackageID < MAX_PACKAGE_ID; PackageID++)
+			NCSI_Issue_DeSelectPackage(info,PackageID);
+	}
+	NCSI_Trace_Timing("deselect: %lld us\n", ktime_us_delta(ktime_get(), Phase));
 
 	/* Discover Packages and Channels */
 	for (PackageID = 0; PackageID < MAX_PACKAGE_ID; PackageID++)
 	{
 		ChannelCount[PackageID] = MAX_CHANNEL_ID;
 
+		if (Pipelined && (Present[PackageID].Status != NCSI_ERR_SUCCESS))
+			continue;
+
+		Phase = ktime_get();
+		Found = info->TotalChannels;
+
 		/* Issue Select Package with Hw Arbit Disable*/
 		if (NCSI_Issue_SelectPackage(info,PackageID,HwArbit) != 0)
+		{
+			NCSI_Trace_Timing("package %d: not selected, %lld us\n", PackageID, ktime_us_delta(ktime_get(), Phase));
 			continue;
+		}
 		
 		/* Find the number of channels support by this packages */
-		for (ChannelID = 0; ChannelID < ChannelCount[PackageID]; ChannelID++)
+		if (Pipelined)
 		{
-			NSCI_Detect_Channel (info, PackageID, ChannelID);
+			NCSI_Detect_Package_Pipelined (info, PackageID);
+		}
+		else
+		{
+			for (ChannelID = 0; ChannelID < ChannelCount[PackageID]; ChannelID++)
+			{
+				NSCI_Detect_Channel (info, PackageID, ChannelID);
+			}
 		}
 		
 		/* Deselect previusly selected package */
 		NCSI_Issue_DeSelectPackage(info,PackageID);
+		NCSI_Trace_Timing("package %d: %d channels, %lld us\n", PackageID, info->TotalChannels - Found,
+							ktime_us_delta(ktime_get(), Phase));
 	}
 
 	if (info->TotalChannels == 0)
 		printk(KERN_DEBUG "NCSI(%s): No NCSI Interfaces detected\n", dev->name);
 
 
+	Phase = ktime_get();
 	PrevPackageID = -1;
 	/* Configure the detected channels */
 	for(i=0;i<info->TotalChannels;i++)
@@ -1278,6 +1457,9 @@ NCSI_Detect_Info(NCSI_IF_INFO *info)
 		}
 	}
 
+	NCSI_Trace_Timing("configure: %d packages, %lld us\n", ValidPackages, ktime_us_delta(ktime_get(), Phase));
+	NCSI_Trace_Timing("total: %lld us\n", ktime_us_delta(ktime_get(), Start));
+
 	if ((info->TotalChannels) && (ValidPackages))
 		 NCSI_Net_Driver_Register(info);
 
@@ -535,7 +535,7 @@ ProcessResponseCode(NCSI_IF_INFO *info,UINT16 ResponseCode, UINT16 ReasonCode)
 
 static
 void
-FormNCSIPacket(NCSI_IF_INFO *info,UINT8 Command,UINT8 Channel,UINT8 *PayLoad, int cs_offset)
+BuildNCSIPacket(UINT8 *SendData,int Size,UINT8 InstanceID,UINT8 Command,UINT8 Channel,UINT8 *PayLoad, int cs_offset)
 {
 	ETH_HDR  		*EthHdr;
 	NCSI_HDR		*NcsiHdr;
@@ -543,12 +543,12 @@ FormNCSIPacket(NCSI_IF_INFO *info,UINT8 Command,UINT8 Channel,UINT8 *PayLoad, in
 	UINT32			*CheckSum;
 	UINT32			PayLoadLen;
 
-	memset(info->SendData,0,BUFFER_SIZE);
+	memset(SendData,0,Size);
 	/* Get the locations of various fields */
-	EthHdr  	= (ETH_HDR *)(info->SendData);
-	NcsiPkt		=  info->SendData + sizeof(ETH_HDR);
+	EthHdr  	= (ETH_HDR *)(SendData);
+	NcsiPkt		=  SendData + sizeof(ETH_HDR);
 	NcsiHdr 	= (NCSI_HDR *)NcsiPkt;
-	NcsiPayLoad     =  info->SendData + sizeof(ETH_HDR) + sizeof(NCSI_HDR);
+	NcsiPayLoad     =  SendData + sizeof(ETH_HDR) + sizeof(NCSI_HDR);
 	CheckSum	= (UINT32 *)(NcsiPkt+cs_offset);
 	PayLoadLen	=  (UINT32)CheckSum - (UINT32)NcsiPayLoad;
 
@@ -561,19 +561,11 @@ FormNCSIPacket(NCSI_IF_INFO *info,UINT8 Command,UINT8 Channel,UINT8 *PayLoad, in
 	memset(NcsiHdr,0, sizeof(NCSI_HDR));
 	NcsiHdr->MC_ID 		= NCSI_MC_ID;
 	NcsiHdr->HdrRev 	= NCSI_HDR_REV;
-	info->LastInstanceID++;
-	/* Instance ID  = 1 to 0xFF . 0 is invalid */
-	info->LastInstanceID= (UINT8)((info->LastInstanceID == 0)?1:info->LastInstanceID);	
-	NcsiHdr->I_ID		= info->LastInstanceID;
+	NcsiHdr->I_ID		= InstanceID;
 	NcsiHdr->Command 	= Command;
 	NcsiHdr->CH_ID		= Channel;
 	NcsiHdr->PayloadLen = cpu_to_be16(PayLoadLen);
 
-	/* Save some info */
-	info->LastCommand      = Command;
-	info->LastChannelID    = Channel;
-	info->LastManagementID = NCSI_MC_ID;
-
 	/* Copy the PayLoad */
 	memcpy(NcsiPayLoad,PayLoad,PayLoadLen);
 
@@ -582,6 +574,29 @@ FormNCSIPacket(NCSI_IF_INFO *info,UINT8 Command,UINT8 Channel,UINT8 *PayLoad, in
 	return;
 }
 
+static
+UINT8
+NextInstanceID(NCSI_IF_INFO *info)
+{
+	info->LastInstanceID++;
+	/* Instance ID  = 1 to 0xFF . 0 is invalid */
+	info->LastInstanceID= (UINT8)((info->LastInstanceID == 0)?1:info->LastInstanceID);	
+	return info->LastInstanceID;
+}
+
+static
+void
+FormNCSIPacket(NCSI_IF_INFO *info,UINT8 Command,UINT8 Channel,UINT8 *PayLoad, int cs_offset)
+{
+	BuildNCSIPacket(info->SendData,BUFFER_SIZE,NextInstanceID(info),Command,Channel,PayLoad,cs_offset);
+
+	/* Save some info */
+	info->LastCommand      = Command;
+	info->LastChannelID    = Channel;
+	info->LastManagementID = NCSI_MC_ID;
+	return;
+}
+
 int Check_PackageID(NCSI_IF_INFO *info, UINT8 PackageID)
 {
 	int HwArbit = 0;
@@ -1079,6 +1094,160 @@ NCSI_Issue_GetCapabilities(NCSI_IF_INFO *info,UINT8 PackageID, UINT8 ChannelID,U
 	return retval;
 }
 
+static
+int
+ValidatePipelinedResponse(NCSI_IF_INFO *info, NCSI_PENDING_CMD *cmd, NCSI_PROBE *Probe, int ResSize, int cs_offset)
+{
+	NCSI_DEFAULT_RES_PKT *ResPkt;
+	GET_VERSION_ID_RES_PKT *VerPkt;
+	GET_CAPABILITIES_RES_PKT *CapPkt;
+	int retval;
+
+	if (cmd->RecvLen != ResSize)
+	{
+		printk("NCSI(%s): Expected Response Size = %d Got %d\n",info->dev->name,
+			ResSize,cmd->RecvLen);
+		return NCSI_ERR_RESPONSE;
+	}
+
+	retval = NCSIValidateCheckSum(info,(UINT16*)cmd->RecvData,cs_offset);
+	if (retval != NCSI_ERR_SUCCESS)
+		return retval;
+
+	/* ProcessResponseCode() names the command from these */
+	info->LastCommand   = cmd->Command;
+	info->LastChannelID = cmd->ChannelID;
+
+	ResPkt = (NCSI_DEFAULT_RES_PKT *)cmd->RecvData;
+	retval = ProcessResponseCode(info,ResPkt->ResponseCode,ResPkt->ReasonCode);
+	if (retval != NCSI_ERR_SUCCESS)
+		return retval;
+
+	switch (cmd->Command)
+	{
+		case CMD_DESELECT_PACKAGE:
+			if (selected_pkg == Probe->PackageID)
+				selected_pkg = MAX_PACKAGE_ID + 1;
+			break;
+		case CMD_GET_VERSION_ID:
+			VerPkt = (GET_VERSION_ID_RES_PKT *)cmd->RecvData;
+			Probe->Ver1  = VerPkt->NCSIVerMajor << 24;
+			Probe->Ver1 |= VerPkt->NCSIVerMinor << 16;
+			Probe->Ver1 |= VerPkt->NCSIVerUpdate<< 8;
+			Probe->Ver1 |= VerPkt->NCSIVerAlpha1<< 0;
+			Probe->Ver2  = VerPkt->NCSIVerAlpha2;
+			Probe->Ver3  = VerPkt->IANA_ManID;
+			break;
+		case CMD_GET_CAPABILITIES:
+			CapPkt = (GET_CAPABILITIES_RES_PKT *)cmd->RecvData;
+			Probe->Caps = be32_to_cpu(CapPkt->CapFlags);
+			Probe->AENCaps = be32_to_cpu(CapPkt->AENControlSupport);
+			Probe->ChannelCount = CapPkt->ChannelCount;
+			break;
+	}
+	return NCSI_ERR_SUCCESS;
+}
+
+/*
+ * Issues Command to every entry of Probe whose Status is still NCSI_ERR_SUCCESS,
+ * keeping up to Depth commands in flight, so that the entries which do not answer
+ * share one response timeout. Only the discovery commands (Deselect Package,
+ * Clear Initial State, Get Version ID and Get Capabilities) are supported. For
+ * the channel commands, all entries must be on the same package.
+ * Returns the number of entries that completed.
+ */
+int
+NCSI_Issue_Pipelined(NCSI_IF_INFO *info,UINT8 Command,NCSI_PROBE *Probe,int Count,int Depth)
+{
+	NCSI_DEFAULT_REQ_PKT Pkt;
+	NCSI_PENDING_CMD *cmd;
+	UINT8 *PayLoad;
+	int Index[NCSI_MAX_OUTSTANDING];
+	int ResSize, res_cs_offset;
+	int cs_offset;
+	int i, n, next;
+	int completed = 0;
+
+	switch (Command)
+	{
+		case CMD_DESELECT_PACKAGE:
+		case CMD_CLEAR_INITIAL_STATE:
+			ResSize = sizeof(NCSI_DEFAULT_RES_PKT);
+			res_cs_offset = offsetof(NCSI_DEFAULT_RES_PKT, CheckSum);
+			break;
+		case CMD_GET_VERSION_ID:
+			ResSize = sizeof(GET_VERSION_ID_RES_PKT);
+			res_cs_offset = offsetof(GET_VERSION_ID_RES_PKT, CheckSum);
+			break;
+		case CMD_GET_CAPABILITIES:
+			ResSize = sizeof(GET_CAPABILITIES_RES_PKT);
+			res_cs_offset = offsetof(GET_CAPABILITIES_RES_PKT, CheckSum);
+			break;
+		default:
+			return 0;
+	}
+
+	if (Depth > NCSI_MAX_OUTSTANDING)
+		Depth = NCSI_MAX_OUTSTANDING;
+	if (Depth < 1)
+		Depth = 1;
+
+	if ((Command != CMD_DESELECT_PACKAGE) && (Count > 0))
+		Check_PackageID(info,Probe[0].PackageID);
+
+	/* Sleep for response or timeout */
+	wait_event_interruptible_timeout(NCSI_Process, (info->ProcessPending == 0), NCSI_TIMEOUT);
+	info->ProcessPending = 1;
+	/* Basic Initialization */
+	memset(&Pkt ,0, sizeof(Pkt));
+	PayLoad = ((UINT8 *)&Pkt) + sizeof(NCSI_HDR);
+	cs_offset = offsetof(NCSI_DEFAULT_REQ_PKT, CheckSum);
+
+	next = 0;
+	while (next < Count)
+	{
+		/* Queue the next Depth entries that have not failed yet */
+		for (n = 0; (next < Count) && (n < Depth); next++)
+		{
+			if (Probe[next].Status != NCSI_ERR_SUCCESS)
+				continue;
+
+			cmd = &info->Pending[n];
+			cmd->InUse = 1;
+			cmd->Command = Command;
+			if (Command == CMD_DESELECT_PACKAGE)
+				cmd->ChannelID = MK_CH_ID(Probe[next].PackageID,0x1F);
+			else
+				cmd->ChannelID = MK_CH_ID(Probe[next].PackageID,Probe[next].ChannelID);
+			cmd->InstanceID = NextInstanceID(info);
+			BuildNCSIPacket(cmd->SendData,NCSI_PENDING_SIZE,cmd->InstanceID,Command,cmd->ChannelID,
+																PayLoad,cs_offset);
+			cmd->SendLen = sizeof(Pkt);
+			Index[n++] = next;
+		}
+		if (n == 0)
+			break;
+
+		SendNCSICommands(info,n);
+
+		for (i = 0; i < n; i++)
+		{
+			cmd = &info->Pending[i];
+			if (cmd->Done)
+				Probe[Index[i]].Status = ValidatePipelinedResponse(info,cmd,&Probe[Index[i]],ResSize,res_cs_offset);
+			else
+				Probe[Index[i]].Status = NCSI_ERR_TIMEOUT;
+			if (Probe[Index[i]].Status == NCSI_ERR_SUCCESS)
+				completed++;
+			cmd->InUse = 0;
+		}
+	}
+
+	info->ProcessPending = 0;
+	wake_up_interruptible(&NCSI_Process);
+	return completed;
+}
+
 int 
 NCSI_Issue_SetMacAddress(NCSI_IF_INFO *info,UINT8 PackageID, UINT8 ChannelID, UINT8 *MacAddr,
 					UINT8 MacFilterNo,UINT8 MacType)
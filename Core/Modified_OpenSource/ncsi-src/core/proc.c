@@ -111,6 +111,8 @@ unsigned int UserLastResponse[NCSI_COMMAND_SIZE] = {0};
 UINT32 ChannelList[MAX_PACKAGE_ID * MAX_CHANNEL_ID * 2] = {0};
 int ReEnable = 0;
 int UserSetMAC = 0;
+int PipelineDepth = NCSI_MAX_OUTSTANDING;	/* Discovery commands in flight, 1 = one at a time */
+char DetectTiming[NCSI_TIMING_SIZE] = "";
 
 static struct ctl_table SysNcsiTable[] = 
 {
@@ -140,6 +142,8 @@ static struct ctl_table SysNcsiTable[] =
     {.procname="UserInitEnabled" ,  .data=&UserInitEnabled,   	.maxlen=sizeof(int), .mode=0644, .proc_handler=&proc_dointvec },
 #endif
     {.procname="ChannelList"   ,  	.data=ChannelList,    		.maxlen=sizeof(ChannelList), .mode=0644, .proc_handler=&proc_channellist },
+    {.procname="PipelineDepth" ,  	.data=&PipelineDepth,  		.maxlen=sizeof(int), .mode=0644, .proc_handler=&proc_dointvec },
+    {.procname="DetectTiming"  ,  	.data=DetectTiming,    		.maxlen=sizeof(DetectTiming), .mode=0444, .proc_handler=&proc_dostring },
     {  }
 #else	
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,0,0))
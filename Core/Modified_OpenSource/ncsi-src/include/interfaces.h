@@ -37,6 +37,9 @@
 #define MAX_NET_IF 	(CONFIG_SPX_FEATURE_GLOBAL_NIC_COUNT)
 #define MAX_IF_NAME_LEN 8
 #define NCSI_COMMAND_SIZE	64
+#define NCSI_MAX_OUTSTANDING	8		/* Max commands in flight per interface */
+#define NCSI_PENDING_SIZE	128		/* Fits the discovery requests and responses */
+#define NCSI_TIMING_SIZE	512		/* Text size of the discovery timing trace */
 
 typedef struct
 {	
@@ -52,6 +55,20 @@ typedef struct
 	/* Add Vlan if needed */
 } CHANNEL_INFO;
 
+/* A command sent with SendNCSICommands(), matched to its response by instance ID */
+typedef struct
+{
+	UINT8 InUse;
+	UINT8 Done;
+	UINT8 Command;
+	UINT8 InstanceID;
+	UINT8 ChannelID;
+	int   SendLen;
+	int   RecvLen;
+	UINT8 SendData[NCSI_PENDING_SIZE];
+	UINT8 RecvData[NCSI_PENDING_SIZE];
+} NCSI_PENDING_CMD;
+
 
 typedef struct ncsi_if_info
 {
@@ -81,6 +98,8 @@ typedef struct ncsi_if_info
 	int VetoBit;	
 	UINT32 IANA_ManID;
 	UINT8 ProcessPending;
+	NCSI_PENDING_CMD Pending[NCSI_MAX_OUTSTANDING];
+	int PendingCount;	/* Non zero while SendNCSICommands() waits */
 	UINT8 AENEnabled;
 	int EnabledChannelID;
 	int EnabledPackageID;
@@ -854,6 +854,21 @@ typedef struct
 
 
 
+/*---------------------- Pipelined Discovery Target ------------------------*/
+/* Result of the last command NCSI_Issue_Pipelined() sent to a package/channel */
+typedef struct
+{
+	UINT8	PackageID;
+	UINT8	ChannelID;
+	int	Status;			/* NCSI_ERR_*, entries that failed are skipped */
+	UINT32	Ver1;
+	UINT32	Ver2;
+	UINT32	Ver3;
+	UINT32	Caps;
+	UINT32	AENCaps;
+	UINT8	ChannelCount;
+} NCSI_PROBE;
+
 /*------------------------------- NCSI Functions ----------------------------*/
 int NCSI_Issue_SelectPackage		(NCSI_IF_INFO *info,UINT8 PackageID,UINT8 HwArbitDisable);
 int NCSI_Issue_DeSelectPackage		(NCSI_IF_INFO *info,UINT8 PackageID);
@@ -867,6 +882,8 @@ int NCSI_Issue_GetVersionID			(NCSI_IF_INFO *info,UINT8 PackageID,UINT8 ChannelI
 											UINT32 *Ver1,UINT32 *Ver2,UINT32 *Ver3);
 int NCSI_Issue_GetCapabilities		(NCSI_IF_INFO *info,UINT8 PackageID,UINT8 ChannelID,
 											UINT32 *Caps, UINT32 *AENCaps, UINT8 *ChannelCount);
+int NCSI_Issue_Pipelined			(NCSI_IF_INFO *info,UINT8 Command,NCSI_PROBE *Probe,
+											int Count,int Depth);
 int NCSI_Issue_SetMacAddress		(NCSI_IF_INFO *info,UINT8 PackageID,UINT8 ChannelID,
 											UINT8 *MacAddr,UINT8 MacFilterNo,UINT8 MacType);
 int NCSI_Issue_EnableBcastFilter	(NCSI_IF_INFO *info,UINT8 PackageID,UINT8 ChannelID, 
@@ -888,6 +905,7 @@ int NCSI_Issue_OEM_SetIntelManagementControlCommand(NCSI_IF_INFO *info,UINT8 Pac
 
 void ProcessNCSI(NCSI_IF_INFO *info, struct sk_buff *skb);
 int SendNCSICommand(NCSI_IF_INFO *info);
+int SendNCSICommands(NCSI_IF_INFO *info, int Count);
 int CheckIfAEN(NCSI_IF_INFO *info, struct sk_buff *skb);
 #if defined(CONFIG_SPX_FEATURE_NCSI_GET_LINK_STATUS_FOR_NON_AEN_SUPPORTED_CONTROLLERS)
 int CheckAENSupport(NCSI_IF_INFO *info, UINT8 PackageID, UINT8 ChannelID);
@@ -908,6 +926,7 @@ int NCSI_Issue_UserCommand (NCSI_IF_INFO *info,UINT8 PackageID, UINT8 ChannelID,
 #define SHOW_SEND_COMMANDS	0x0020
 #define SHOW_LINK_INFO		0x0040
 #define SHOW_AEN_INFO		0x0080
+#define SHOW_TIMING_INFO	0x0100
 
 int SetUserSettings(int ID);
 int SetUserLink(void);
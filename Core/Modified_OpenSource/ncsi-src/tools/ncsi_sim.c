@@ -0,0 +1,514 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+
+/*
+ * NC-SI responder simulator
+ *
+ * Answers NC-SI commands on a raw socket as a set of network controller
+ * packages would, so that package/channel discovery and configuration can
+ * be run without a NIC. Packages not in the package mask stay silent, as an
+ * empty slot does, and every response can be delayed and randomly dropped to
+ * exercise the timeouts and retries of the driver.
+ *
+ * Channels start in the Initial State and refuse everything but Clear
+ * Initial State with "Initialization Required", so a driver that reorders
+ * the discovery commands of a channel gets caught. Commands the simulator
+ * does not model are answered "Unsupported".
+ *
+ * The driver only binds to ethN, so give it one end of a veth pair named
+ * that way, on a test kernel with ncsi.ko built with NCSI_DEFER_DETECT or
+ * with eth1 in CONFIG_SPX_FEATURE_NCSI_INTERFACE_NAMES:
+ *   ip link add eth1 type veth peer name ncsi-nic
+ *   ip link set ncsi-nic up
+ *   gcc -O2 -Wall tools/ncsi_sim.c -o ncsi_sim
+ *   ./ncsi_sim -i ncsi-nic -p 0x03 -c 2 -d 5 &
+ *   insmod ncsi.ko
+ *   cat /proc/sys/ractrends/ncsi/DetectTiming
+ * Compare with echo 1 > /proc/sys/ractrends/ncsi/PipelineDepth and
+ * echo 1 > /proc/sys/ractrends/ncsi/Detect. The simulator prints its
+ * counters on SIGINT.
+ *
+ * Responses carry 4 extra bytes in place of the FCS that the AST MAC hands
+ * up with the frame and the driver strips.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+
+#define NCSI_ETHER_TYPE		0x88F8
+#define NCSI_HDR_LEN		16
+#define NCSI_MIN_FRAME		60		/* without FCS */
+#define NCSI_FCS_LEN		4
+#define MAX_FRAME		1536
+
+#define MAX_PACKAGES		8
+#define MAX_CHANNELS		31
+#define PACKAGE_CHANNEL		0x1F		/* channel ID of the package commands */
+#define MAX_QUEUED		64
+
+#define CMD_CLEAR_INITIAL_STATE	0x00
+#define CMD_SELECT_PACKAGE	0x01
+#define CMD_DESELECT_PACKAGE	0x02
+#define CMD_GET_LINK_STATUS	0x0A
+#define CMD_GET_VERSION_ID	0x15
+#define CMD_GET_CAPABILITIES	0x16
+#define CMD_MAX			0x1A
+
+#define RESP_COMPLETED		0x0000
+#define RESP_FAILED		0x0001
+#define RESP_UNSUPPORTED	0x0003
+#define REASON_NONE		0x0000
+#define REASON_INIT_REQUIRED	0x0001
+#define REASON_UNKNOWN_CMD	0x7FFF
+
+#define FAIL(fmt, args...) \
+	do { fprintf (stderr, "FAIL %s:%d: " fmt "\n", __FUNCTION__, __LINE__, ##args); exit (1); } while (0)
+
+struct ncsi_hdr
+{
+	unsigned char mc_id;
+	unsigned char hdr_rev;
+	unsigned char reserved1;
+	unsigned char iid;
+	unsigned char command;
+	unsigned char channel;
+	unsigned short payload_len;	/* big endian, 12 bits */
+	unsigned short reserved2[4];
+} __attribute__ ((packed));
+
+struct response
+{
+	struct timespec due;
+	int len;
+	unsigned char frame[MAX_FRAME];
+};
+
+struct channel
+{
+	int initial;			/* in the Initial State */
+};
+
+struct package
+{
+	int selected;
+	struct channel channel[MAX_CHANNELS];
+};
+
+static int verbose;
+static int channels = 2;
+static int delay_ms;
+static int drop_pct;
+static int hw_arbitration = 1;
+static unsigned int package_mask = 0x01;
+
+static struct package packages[MAX_PACKAGES];
+static struct response queue[MAX_QUEUED];
+static int queued;
+
+static volatile sig_atomic_t stop;
+
+static unsigned long received, answered, ignored, dropped, bad_checksum;
+static unsigned long per_command[CMD_MAX + 1];
+
+/* Response payload length, response/reason code included, per NC-SI 1.1 */
+static int payload_len (unsigned char command)
+{
+	switch (command)
+	{
+		case CMD_GET_LINK_STATUS:	return 16;
+		case CMD_GET_VERSION_ID:	return 40;
+		case CMD_GET_CAPABILITIES:	return 32;
+		default:			return 4;
+	}
+}
+
+static unsigned int checksum (const unsigned char *p, int len)
+{
+	unsigned int sum = 0;
+	int i;
+
+	for (i = 0; i + 1 < len; i += 2)
+		sum += (p[i] << 8) | p[i + 1];
+	return ~sum + 1;
+}
+
+static void put16 (unsigned char *p, unsigned int v)
+{
+	p[0] = v >> 8;
+	p[1] = v;
+}
+
+static void put32 (unsigned char *p, unsigned int v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static void timespec_add_ms (struct timespec *t, int ms)
+{
+	t->tv_sec += ms / 1000;
+	t->tv_nsec += (long)(ms % 1000) * 1000000L;
+	if (t->tv_nsec >= 1000000000L)
+	{
+		t->tv_sec++;
+		t->tv_nsec -= 1000000000L;
+	}
+}
+
+static long ms_until (const struct timespec *t)
+{
+	struct timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	return (t->tv_sec - now.tv_sec) * 1000 + (t->tv_nsec - now.tv_nsec) / 1000000;
+}
+
+/* Fills the command specific part of a completed response */
+static void fill_payload (unsigned char command, int package, int channel, unsigned char *data)
+{
+	switch (command)
+	{
+		case CMD_GET_VERSION_ID:
+			data[0] = 0xF1;			/* NC-SI 1.1, BCD */
+			data[1] = 0xF1;
+			data[2] = 0xFF;
+			data[3] = 0x00;
+			memcpy (data + 8, "ncsi_sim", 8);
+			put32 (data + 20, 0x01000000 | (package << 8) | channel);	/* firmware version */
+			put16 (data + 24, 0x1533);	/* PCI DID */
+			put16 (data + 26, 0x8086);	/* PCI VID */
+			put32 (data + 32, 0x00000157);	/* IANA */
+			break;
+
+		case CMD_GET_CAPABILITIES:
+			put32 (data + 0, hw_arbitration ? 0x0000000D : 0x0000000C);	/* capabilities */
+			put32 (data + 4, 0x0000000F);	/* broadcast filters */
+			put32 (data + 8, 0x00000007);	/* multicast filters */
+			put32 (data + 16, 0x00000007);	/* AEN control */
+			data[20] = 8;			/* VLAN filters */
+			data[22] = 2;			/* multicast filters */
+			data[23] = 2;			/* unicast filters */
+			data[26] = 0x07;		/* VLAN modes */
+			data[27] = channels;
+			break;
+
+		case CMD_GET_LINK_STATUS:
+			put32 (data + 0, 0x0000006F);	/* up, 1000BASE-T full duplex, autonegotiated */
+			break;
+	}
+}
+
+static void queue_response (const unsigned char *req, int package, int channel, unsigned int code, unsigned int reason)
+{
+	const struct ncsi_hdr *rhdr = (const struct ncsi_hdr *)(req + ETH_HLEN);
+	struct response *r;
+	struct ncsi_hdr *hdr;
+	unsigned char *ncsi;
+	int len;
+
+	if (queued == MAX_QUEUED)
+	{
+		dropped++;
+		return;
+	}
+	r = &queue[queued++];
+	memset (r->frame, 0, sizeof (r->frame));
+
+	/* Controllers answer from the broadcast address */
+	memcpy (r->frame, req + ETH_ALEN, ETH_ALEN);
+	memset (r->frame + ETH_ALEN, 0xFF, ETH_ALEN);
+	put16 (r->frame + 2 * ETH_ALEN, NCSI_ETHER_TYPE);
+
+	ncsi = r->frame + ETH_HLEN;
+	hdr = (struct ncsi_hdr *)ncsi;
+	hdr->mc_id = rhdr->mc_id;
+	hdr->hdr_rev = 0x01;
+	hdr->iid = rhdr->iid;
+	hdr->command = rhdr->command | 0x80;
+	hdr->channel = rhdr->channel;
+	len = (code == RESP_COMPLETED) ? payload_len (rhdr->command) : 4;
+	hdr->payload_len = htons (len);
+
+	put16 (ncsi + NCSI_HDR_LEN, code);
+	put16 (ncsi + NCSI_HDR_LEN + 2, reason);
+	if (code == RESP_COMPLETED)
+		fill_payload (rhdr->command, package, channel, ncsi + NCSI_HDR_LEN + 4);
+	put32 (ncsi + NCSI_HDR_LEN + len, checksum (ncsi, NCSI_HDR_LEN + len));
+
+	r->len = ETH_HLEN + NCSI_HDR_LEN + len + 4;
+	if (r->len < NCSI_MIN_FRAME)
+		r->len = NCSI_MIN_FRAME;
+	r->len += NCSI_FCS_LEN;
+
+	clock_gettime (CLOCK_MONOTONIC, &r->due);
+	timespec_add_ms (&r->due, delay_ms);
+}
+
+static void handle_request (const unsigned char *frame, int len)
+{
+	const struct ncsi_hdr *hdr;
+	const unsigned char *ncsi = frame + ETH_HLEN;
+	struct package *pkg;
+	struct channel *ch = NULL;
+	unsigned int plen;
+	int package, channel, i;
+
+	if (len < ETH_HLEN + NCSI_HDR_LEN + 4)
+		return;
+	hdr = (const struct ncsi_hdr *)ncsi;
+	if (hdr->command & 0x80)
+		return;			/* our own response on a shared segment */
+
+	plen = ntohs (hdr->payload_len) & 0xFFF;
+	if (ETH_HLEN + NCSI_HDR_LEN + (int)plen + 4 > len)
+		return;
+	received++;
+
+	package = hdr->channel >> 5;
+	channel = hdr->channel & 0x1F;
+	if (!(package_mask & (1 << package)) || (channel != PACKAGE_CHANNEL && channel >= channels))
+	{
+		ignored++;
+		return;
+	}
+	pkg = &packages[package];
+	if (channel != PACKAGE_CHANNEL)
+		ch = &pkg->channel[channel];
+
+	{
+		const unsigned char *cs = ncsi + NCSI_HDR_LEN + plen;
+		unsigned int got = (cs[0] << 24) | (cs[1] << 16) | (cs[2] << 8) | cs[3];
+
+		if (got != 0 && got != checksum (ncsi, NCSI_HDR_LEN + plen))
+		{
+			bad_checksum++;
+			return;
+		}
+	}
+
+	if (hdr->command <= CMD_MAX)
+		per_command[hdr->command]++;
+
+	if (drop_pct && (rand () % 100) < drop_pct)
+	{
+		dropped++;
+		return;
+	}
+
+	if (verbose)
+		printf ("cmd 0x%02x iid 0x%02x to %d.%d\n", hdr->command, hdr->iid, package,
+			channel == PACKAGE_CHANNEL ? -1 : channel);
+
+	switch (hdr->command)
+	{
+		case CMD_SELECT_PACKAGE:
+			for (i = 0; i < MAX_PACKAGES; i++)
+			{
+				if (i != package && packages[i].selected && !hw_arbitration)
+					printf ("package %d selected while package %d is: RBT collision without arbitration\n",
+						package, i);
+			}
+			pkg->selected = 1;
+			queue_response (frame, package, channel, RESP_COMPLETED, REASON_NONE);
+			return;
+
+		case CMD_DESELECT_PACKAGE:
+			pkg->selected = 0;
+			queue_response (frame, package, channel, RESP_COMPLETED, REASON_NONE);
+			return;
+	}
+
+	/* Any other command implicitly selects the package */
+	pkg->selected = 1;
+
+	if (ch == NULL)
+	{
+		queue_response (frame, package, channel, RESP_UNSUPPORTED, REASON_UNKNOWN_CMD);
+		return;
+	}
+
+	if (hdr->command == CMD_CLEAR_INITIAL_STATE)
+	{
+		ch->initial = 0;
+		queue_response (frame, package, channel, RESP_COMPLETED, REASON_NONE);
+		return;
+	}
+
+	if (ch->initial)
+	{
+		queue_response (frame, package, channel, RESP_FAILED, REASON_INIT_REQUIRED);
+		return;
+	}
+
+	if (hdr->command <= CMD_MAX && hdr->command != 0x0F)
+		queue_response (frame, package, channel, RESP_COMPLETED, REASON_NONE);
+	else
+		queue_response (frame, package, channel, RESP_UNSUPPORTED, REASON_UNKNOWN_CMD);
+}
+
+/* Sends the responses that are due, returns the poll timeout to the next one */
+static int send_due (int fd, const struct sockaddr_ll *addr)
+{
+	int timeout = -1;
+	long left;
+	int i;
+
+	for (i = 0; i < queued; )
+	{
+		left = ms_until (&queue[i].due);
+		if (left > 0)
+		{
+			if (timeout < 0 || left < timeout)
+				timeout = left;
+			i++;
+			continue;
+		}
+
+		if (sendto (fd, queue[i].frame, queue[i].len, 0, (const struct sockaddr *)addr, sizeof (*addr)) < 0)
+			perror ("sendto");
+		else
+			answered++;
+		/* Keeps the send order of responses due at the same time */
+		memmove (&queue[i], &queue[i + 1], (queued - i - 1) * sizeof (queue[0]));
+		queued--;
+	}
+	return timeout;
+}
+
+static void print_stats (void)
+{
+	int i;
+
+	printf ("received %lu, answered %lu, ignored %lu, dropped %lu, bad checksum %lu\n",
+		received, answered, ignored, dropped, bad_checksum);
+	for (i = 0; i <= CMD_MAX; i++)
+	{
+		if (per_command[i])
+			printf ("  command 0x%02x: %lu\n", i, per_command[i]);
+	}
+}
+
+static void reset_state (void)
+{
+	int p, c;
+
+	for (p = 0; p < MAX_PACKAGES; p++)
+	{
+		packages[p].selected = 0;
+		for (c = 0; c < MAX_CHANNELS; c++)
+			packages[p].channel[c].initial = 1;
+	}
+}
+
+static void on_signal (int sig)
+{
+	stop = sig;
+}
+
+static void usage (const char *name)
+{
+	fprintf (stderr, "usage: %s -i ifname [-p package_mask] [-c channels] [-d delay_ms]\n"
+		"          [-l drop_percent] [-n] [-v]\n"
+		"  -n  packages do not support hardware arbitration\n", name);
+	exit (2);
+}
+
+int main (int argc, char *argv[])
+{
+	unsigned char frame[MAX_FRAME];
+	struct sockaddr_ll addr;
+	struct pollfd pfd;
+	const char *ifname = NULL;
+	int fd, opt, len, timeout;
+
+	while ((opt = getopt (argc, argv, "i:p:c:d:l:nv")) != -1)
+	{
+		switch (opt)
+		{
+			case 'i': ifname = optarg; break;
+			case 'p': package_mask = strtoul (optarg, NULL, 0) & 0xFF; break;
+			case 'c': channels = atoi (optarg); break;
+			case 'd': delay_ms = atoi (optarg); break;
+			case 'l': drop_pct = atoi (optarg); break;
+			case 'n': hw_arbitration = 0; break;
+			case 'v': verbose = 1; break;
+			default: usage (argv[0]);
+		}
+	}
+	if (ifname == NULL || channels < 1 || channels > MAX_CHANNELS || delay_ms < 0 ||
+	    drop_pct < 0 || drop_pct > 100)
+		usage (argv[0]);
+
+	fd = socket (AF_PACKET, SOCK_RAW, htons (NCSI_ETHER_TYPE));
+	if (fd < 0)
+		FAIL ("socket: %s", strerror (errno));
+
+	memset (&addr, 0, sizeof (addr));
+	addr.sll_family = AF_PACKET;
+	addr.sll_protocol = htons (NCSI_ETHER_TYPE);
+	addr.sll_ifindex = if_nametoindex (ifname);
+	if (addr.sll_ifindex == 0)
+		FAIL ("%s: %s", ifname, strerror (errno));
+	if (bind (fd, (struct sockaddr *)&addr, sizeof (addr)) < 0)
+		FAIL ("bind %s: %s", ifname, strerror (errno));
+
+	signal (SIGINT, on_signal);
+	signal (SIGTERM, on_signal);
+	srand (time (NULL));
+	reset_state ();
+
+	printf ("ncsi_sim: %s, packages 0x%02x, %d channels, %d ms delay, %d%% dropped%s\n", ifname,
+		package_mask, channels, delay_ms, drop_pct, hw_arbitration ? "" : ", no arbitration");
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	while (!stop)
+	{
+		timeout = send_due (fd, &addr);
+		if (poll (&pfd, 1, timeout) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			FAIL ("poll: %s", strerror (errno));
+		}
+		if (!(pfd.revents & POLLIN))
+			continue;
+
+		len = recv (fd, frame, sizeof (frame), 0);
+		if (len < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			FAIL ("recv: %s", strerror (errno));
+		}
+		handle_request (frame, len);
+	}
+
+	print_stats ();
+	close (fd);
+	return 0;
+}
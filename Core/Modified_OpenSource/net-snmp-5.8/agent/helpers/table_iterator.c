@@ -83,6 +83,16 @@
         then the free_loop_context_at_end pointer should be set, which
         is more efficient since a malloc/free will only be performed
         once for every iteration.
+
+    GETBULK requests are normally turned into one GETNEXT pass per
+    repetition, each of which walks the whole row set.  Tables that
+    set NETSNMP_ITERATOR_FLAG_BULK_PREFETCH have the first pass for a
+    repeating varbind collect up to max-repetitions successors in the
+    same walk; the following passes are then answered from that list
+    without calling the get_*_data_point hooks again.  The list is
+    kept for the life of the PDU only, and is only used when neither
+    make_data_context nor free_data_context is set, since the data
+    contexts of the collected rows must stay valid until then.
  *
  *  @{
  */
@@ -372,6 +382,13 @@ netsnmp_insert_iterator_context(netsnmp_request_info *request, void *data)
 #endif /* NETSNMP_FEATURE_REMOVE_TABLE_ITERATOR_INSERT_CONTEXT */
 
 #define TI_REQUEST_CACHE "ti_cache"
+#define TI_BULK_CACHE    "ti_bulk_cache"
+
+/* one row collected for a later GETBULK repetition */
+typedef struct ti_bulk_row_s {
+   netsnmp_variable_list *indexes;    /* name holds the full column oid */
+   void *data_context;
+} ti_bulk_row;
 
 typedef struct ti_cache_info_s {
    oid best_match[MAX_OID_LEN];
@@ -380,8 +397,37 @@ typedef struct ti_cache_info_s {
    Netsnmp_Free_Data_Context *free_context;
    netsnmp_iterator_info *iinfo;
    netsnmp_variable_list *results;
+   /* GETBULK prefetch: the bulk_max best successors seen this pass */
+   ti_bulk_row *bulk;
+   int bulk_count;
+   int bulk_max;
+   int bulk_served;
 } ti_cache_info;
 
+/* prefetched rows for one repeating varbind, kept in the agent request */
+typedef struct ti_bulk_cache_s {
+   netsnmp_iterator_info *iinfo;
+   int index;                          /* request->index */
+   oid served[MAX_OID_LEN];            /* last oid handed out */
+   size_t served_len;
+   ti_bulk_row *rows;
+   int count;
+   int pos;
+   struct ti_bulk_cache_s *next;
+} ti_bulk_cache;
+
+static void
+_ti_bulk_free_rows(ti_bulk_row *rows, int count)
+{
+    int i;
+
+    if (!rows)
+        return;
+    for (i = 0; i < count; i++)
+        snmp_free_varbind(rows[i].indexes);
+    free(rows);
+}
+
 static void
 netsnmp_free_ti_cache(void *it) {
     ti_cache_info *beer = (ti_cache_info*)it;
@@ -392,9 +438,22 @@ netsnmp_free_ti_cache(void *it) {
     if (beer->results) {
         snmp_free_varbind(beer->results);
     }
+    _ti_bulk_free_rows(beer->bulk, beer->bulk_count);
     free(beer);
 }
 
+static void
+netsnmp_free_ti_bulk_cache(void *it)
+{
+    ti_bulk_cache *cache = (ti_bulk_cache *)it, *next;
+
+    for (; cache; cache = next) {
+        next = cache->next;
+        _ti_bulk_free_rows(cache->rows, cache->count);
+        free(cache);
+    }
+}
+
 /* caches information (in the request) we'll need at a later point in time */
 static ti_cache_info *
 netsnmp_iterator_remember(netsnmp_request_info *request,
@@ -446,6 +505,173 @@ netsnmp_iterator_remember(netsnmp_request_info *request,
     return ti_info;
 }    
 
+/*
+ * GETBULK prefetch: during the row walk, keep the ti_info->bulk_max
+ * smallest column oids greater than the request, in order.  Returns 1
+ * when the list has just become full.
+ */
+static int
+_ti_bulk_collect(netsnmp_request_info *request, ti_cache_info *ti_info,
+                 oid *prefix, size_t prefix_len,
+                 netsnmp_variable_list *indexes, void *data_context)
+{
+    oid             myname[MAX_OID_LEN];
+    size_t          myname_len;
+    netsnmp_variable_list *vb, *last;
+    int             lo = 0, hi = ti_info->bulk_count, mid, cmp;
+
+    build_oid_noalloc(myname, MAX_OID_LEN, &myname_len,
+                      prefix, prefix_len, indexes);
+    if (snmp_oid_compare(myname, myname_len,
+                         request->requestvb->name,
+                         request->requestvb->name_length) <= 0)
+        return 0;
+
+    if (ti_info->bulk_count == ti_info->bulk_max) {
+        last = ti_info->bulk[ti_info->bulk_count - 1].indexes;
+        if (snmp_oid_compare(myname, myname_len,
+                             last->name, last->name_length) >= 0)
+            return 0;
+    }
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        vb = ti_info->bulk[mid].indexes;
+        cmp = snmp_oid_compare(vb->name, vb->name_length,
+                               myname, myname_len);
+        if (cmp == 0)
+            return 0;           /* seen again on a column restart */
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    vb = snmp_clone_varbind(indexes);
+    if (!vb)
+        return 0;
+    snmp_set_var_objid(vb, myname, myname_len);
+
+    if (ti_info->bulk_count == ti_info->bulk_max)
+        snmp_free_varbind(ti_info->bulk[--ti_info->bulk_count].indexes);
+    memmove(&ti_info->bulk[lo + 1], &ti_info->bulk[lo],
+            (ti_info->bulk_count - lo) * sizeof(ti_bulk_row));
+    ti_info->bulk[lo].indexes = vb;
+    ti_info->bulk[lo].data_context = data_context;
+
+    return ++ti_info->bulk_count == ti_info->bulk_max;
+}
+
+/* the first collected row is this pass's GETNEXT answer */
+static ti_cache_info *
+_ti_bulk_best(netsnmp_request_info *request, netsnmp_iterator_info *iinfo,
+              ti_cache_info *ti_info)
+{
+    ti_bulk_row *row = &ti_info->bulk[0];
+
+    ti_info->results = snmp_clone_varbind(row->indexes);
+    if (!ti_info->results)
+        return NULL;
+    return netsnmp_iterator_remember(request, row->indexes->name,
+                                     row->indexes->name_length,
+                                     row->data_context, NULL, iinfo);
+}
+
+static ti_bulk_cache *
+_ti_bulk_find(netsnmp_agent_request_info *reqinfo,
+              netsnmp_request_info *request, netsnmp_iterator_info *iinfo)
+{
+    ti_bulk_cache *cache;
+
+    cache = (ti_bulk_cache *)netsnmp_agent_get_list_data(reqinfo,
+                                                         TI_BULK_CACHE);
+    for (; cache; cache = cache->next)
+        if (cache->iinfo == iinfo && cache->index == request->index)
+            return cache;
+    return NULL;
+}
+
+/*
+ * After the walk: everything collected beyond the best match is kept
+ * for the following repetitions of this varbind.
+ */
+static void
+_ti_bulk_store(netsnmp_agent_request_info *reqinfo,
+               netsnmp_request_info *request, netsnmp_iterator_info *iinfo,
+               ti_cache_info *ti_info)
+{
+    ti_bulk_cache *cache, *head;
+    netsnmp_variable_list *first = ti_info->bulk[0].indexes;
+
+    if (snmp_oid_compare(first->name, first->name_length,
+                         ti_info->best_match, ti_info->best_match_len) != 0)
+        return;
+
+    cache = _ti_bulk_find(reqinfo, request, iinfo);
+    if (!cache) {
+        cache = SNMP_MALLOC_TYPEDEF(ti_bulk_cache);
+        if (!cache)
+            return;
+        cache->iinfo = iinfo;
+        cache->index = request->index;
+        head = (ti_bulk_cache *)netsnmp_agent_get_list_data(reqinfo,
+                                                            TI_BULK_CACHE);
+        if (head) {
+            cache->next = head->next;
+            head->next = cache;
+        } else
+            netsnmp_agent_add_list_data(reqinfo,
+                                        netsnmp_create_data_list
+                                        (TI_BULK_CACHE, cache,
+                                         netsnmp_free_ti_bulk_cache));
+    } else
+        _ti_bulk_free_rows(cache->rows, cache->count);
+
+    memcpy(cache->served, ti_info->best_match,
+           ti_info->best_match_len * sizeof(oid));
+    cache->served_len = ti_info->best_match_len;
+    cache->rows = ti_info->bulk;
+    cache->count = ti_info->bulk_count;
+    cache->pos = 1;             /* [0] is being returned right now */
+    ti_info->bulk = NULL;
+    ti_info->bulk_count = 0;
+}
+
+/*
+ * Answer a GETNEXT pass from the prefetched rows, if the request
+ * continues exactly where the previous repetition left off.
+ */
+static int
+_ti_bulk_serve(netsnmp_agent_request_info *reqinfo,
+               netsnmp_request_info *request, netsnmp_iterator_info *iinfo,
+               ti_cache_info *ti_info)
+{
+    ti_bulk_cache *cache;
+    ti_bulk_row   *row;
+
+    cache = _ti_bulk_find(reqinfo, request, iinfo);
+    if (!cache || cache->pos >= cache->count ||
+        snmp_oid_compare(cache->served, cache->served_len,
+                         request->requestvb->name,
+                         request->requestvb->name_length) != 0)
+        return 0;
+
+    row = &cache->rows[cache->pos++];
+    if (netsnmp_iterator_remember(request, row->indexes->name,
+                                  row->indexes->name_length,
+                                  row->data_context, NULL, iinfo) == NULL)
+        return 0;
+    memcpy(cache->served, row->indexes->name,
+           row->indexes->name_length * sizeof(oid));
+    cache->served_len = row->indexes->name_length;
+    if (ti_info->results)
+        snmp_free_varbind(ti_info->results);
+    ti_info->results = row->indexes;
+    row->indexes = NULL;
+    ti_info->bulk_served = 1;
+    return 1;
+}
+
 #define TABLE_ITERATOR_NOTAGAIN 255
 /* implements the table_iterator helper */
 int
@@ -472,6 +698,7 @@ netsnmp_table_iterator_helper_handler(netsnmp_mib_handler *handler,
     void           *callback_data_context = NULL;
     ti_cache_info  *ti_info = NULL;
     int             request_count = 0;
+    int             bulk_ok, bulk_served = 0;
 #ifndef NETSNMP_FEATURE_REMOVE_STASH_CACHE
     netsnmp_oid_stash_node **cinfo = NULL;
     netsnmp_variable_list *old_indexes = NULL, *vb;
@@ -485,6 +712,8 @@ netsnmp_table_iterator_helper_handler(netsnmp_mib_handler *handler,
         return SNMP_ERR_GENERR;
 
     tbl_info = iinfo->table_reginfo;
+    bulk_ok = (iinfo->flags & NETSNMP_ITERATOR_FLAG_BULK_PREFETCH) &&
+        !iinfo->make_data_context && !iinfo->free_data_context;
 
     /*
      * copy in the table registration oid for later use 
@@ -568,6 +797,19 @@ netsnmp_table_iterator_helper_handler(netsnmp_mib_handler *handler,
                                                netsnmp_free_ti_cache));
             }
 
+            if (bulk_ok && !request->processed && !request->inclusive) {
+                if (_ti_bulk_serve(reqinfo, request, iinfo, ti_info)) {
+                    bulk_served++;
+                    continue;
+                }
+                if (request->repeat > 0 && !ti_info->bulk) {
+                    ti_info->bulk = (ti_bulk_row *)
+                        calloc(request->repeat + 1, sizeof(ti_bulk_row));
+                    if (ti_info->bulk)
+                        ti_info->bulk_max = request->repeat + 1;
+                }
+            }
+
             /* XXX: if no valid requests, don't even loop below */
         }
         break;
@@ -590,7 +832,9 @@ netsnmp_table_iterator_helper_handler(netsnmp_mib_handler *handler,
         for(request = requests ; request; request = request->next)
           if (!request->processed)
             request_count++;
-        notdone = 1;
+        /* nothing to walk for if every request was prefetched */
+        request_count -= bulk_served;
+        notdone = !bulk_served || request_count > 0;
         hintok = 1;
         while(notdone) {
             notdone = 0;
@@ -764,6 +1008,18 @@ netsnmp_table_iterator_helper_handler(netsnmp_mib_handler *handler,
 #endif  /* NETSNMP_FEATURE_REMOVE_STASH_CACHE */
 
                     case MODE_GETNEXT:
+                        if (ti_info->bulk_served)
+                            break;
+                        if (ti_info->bulk_max) {
+                            /* best match is picked from the list later */
+                            if (_ti_bulk_collect(request, ti_info,
+                                                 coloid, coloid_len,
+                                                 index_search,
+                                                 callback_data_context) &&
+                                (iinfo->flags & NETSNMP_ITERATOR_FLAG_SORTED))
+                                request_count--;
+                            break;
+                        }
                         /* looking for "next" matches */
                         if (netsnmp_check_getnext_reply
                             (request, coloid, coloid_len, index_search,
@@ -841,6 +1097,23 @@ netsnmp_table_iterator_helper_handler(netsnmp_mib_handler *handler,
                 callback_loop_context = NULL;
             }
 
+            /* prefetching requests take their best match from the list */
+            if (reqinfo->mode == MODE_GETNEXT && bulk_ok) {
+                for(request = requests ; request; request = request->next) {
+                    if (request->processed)
+                        continue;
+                    ti_info = (ti_cache_info*)
+                        netsnmp_request_get_list_data(request,
+                                                      TI_REQUEST_CACHE);
+                    if (!ti_info->results && ti_info->bulk_count &&
+                        _ti_bulk_best(request, iinfo, ti_info) == NULL) {
+                        if (free_this_index_search)
+                            snmp_free_varbind(free_this_index_search);
+                        return SNMP_ERR_GENERR;
+                    }
+                }
+            }
+
             /* decide which (GETNEXT) requests are not yet filled */
             if (reqinfo->mode == MODE_GETNEXT) {
                 for(request = requests ; request; request = request->next) {
@@ -906,6 +1179,8 @@ netsnmp_table_iterator_helper_handler(netsnmp_mib_handler *handler,
                                        coloid, reginfo->rootoid_len+2);
                     request->processed = 1;
                 }
+                if (ti_info->bulk_count > 1 && ti_info->best_match_len)
+                    _ti_bulk_store(reqinfo, request, iinfo, ti_info);
                 snmp_free_varbind(table_info->indexes);
                 table_info->indexes = snmp_clone_varbind(ti_info->results);
                 /* FALL THROUGH */
@@ -50,6 +50,7 @@
 #include "snmpd.h"
 #include "agentx/protocol.h"
 #include "agentx/master_admin.h"
+#include "agentx/master.h"
 
 netsnmp_feature_require(handler_mark_requests_as_delegated)
 netsnmp_feature_require(unix_socket_paths)
@@ -199,6 +200,176 @@ real_init_master(void)
     DEBUGMSGTL(("agentx/master", "initializing...   DONE\n"));
 }
 
+/*
+ * An AgentX request in flight: the delegated cache waiting for the
+ * answer and when the request was sent.  All the varbinds a request
+ * has for one subagent session already arrive here together (the
+ * session's registrations share a global cache id, so the agent calls
+ * this handler once per session and pass), and nothing limits how many
+ * requests may be outstanding on a session at once.
+ */
+typedef struct agentx_request_s {
+    netsnmp_delegated_cache *cache;
+    netsnmp_session *ax_session;
+    int             nvarbinds;
+    int             sending;
+    int             failed;
+    struct timeval  sent;
+} agentx_request;
+
+/*
+ * Response times per subagent session, as a histogram with these upper
+ * bounds (in microseconds) and an unbounded last bucket.  They are
+ * logged under the agentx/latency debug token every
+ * AGENTX_LATENCY_DUMP_EVERY responses and when the session closes.
+ */
+static const u_long agentx_latency_bounds[] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000,
+    250000, 500000, 1000000
+};
+#define AGENTX_LATENCY_BUCKETS \
+    (sizeof(agentx_latency_bounds) / sizeof(agentx_latency_bounds[0]) + 1)
+#define AGENTX_LATENCY_DUMP_EVERY 1000
+
+typedef struct agentx_latency_s {
+    netsnmp_session *ax_session;
+    u_long          responses;
+    u_long          varbinds;
+    u_long          timeouts;
+    double          total_us;
+    u_long          max_us;
+    int             outstanding;
+    int             max_outstanding;
+    u_long          buckets[AGENTX_LATENCY_BUCKETS];
+    struct agentx_latency_s *next;
+} agentx_latency;
+
+static agentx_latency *agentx_latencies = NULL;
+
+static agentx_latency *
+agentx_latency_find(netsnmp_session *ax_session, int create)
+{
+    agentx_latency *stats;
+
+    for (stats = agentx_latencies; stats; stats = stats->next)
+        if (stats->ax_session == ax_session)
+            return stats;
+    if (!create)
+        return NULL;
+
+    stats = SNMP_MALLOC_TYPEDEF(agentx_latency);
+    if (stats) {
+        stats->ax_session = ax_session;
+        stats->next = agentx_latencies;
+        agentx_latencies = stats;
+    }
+    return stats;
+}
+
+static void
+agentx_latency_dump(agentx_latency *stats)
+{
+    size_t          i;
+
+    DEBUGIF("agentx/latency") {
+        DEBUGMSGTL(("agentx/latency",
+                    "session %8p: %lu responses (%lu varbinds), "
+                    "%lu timeouts, avg %.0f us, max %lu us, "
+                    "%d outstanding (max %d)\n", stats->ax_session,
+                    stats->responses, stats->varbinds, stats->timeouts,
+                    stats->responses ? stats->total_us / stats->responses
+                    : 0.0, stats->max_us, stats->outstanding,
+                    stats->max_outstanding));
+        DEBUGMSGTL(("agentx/latency", "session %8p:", stats->ax_session));
+        for (i = 0; i < AGENTX_LATENCY_BUCKETS - 1; i++)
+            DEBUGMSG(("agentx/latency", " <=%luus:%lu",
+                      agentx_latency_bounds[i], stats->buckets[i]));
+        DEBUGMSG(("agentx/latency", " >%luus:%lu\n",
+                  agentx_latency_bounds[i - 1], stats->buckets[i]));
+    }
+}
+
+static void
+agentx_latency_sent(agentx_request *axr)
+{
+    agentx_latency *stats = agentx_latency_find(axr->ax_session, 1);
+
+    if (stats && ++stats->outstanding > stats->max_outstanding)
+        stats->max_outstanding = stats->outstanding;
+}
+
+static void
+agentx_latency_done(agentx_request *axr, int operation)
+{
+    agentx_latency *stats = agentx_latency_find(axr->ax_session, 0);
+    struct timeval  now;
+    u_long          us;
+    size_t          i;
+
+    if (!stats || axr->sending)
+        return;
+    if (stats->outstanding > 0)
+        stats->outstanding--;
+    if (operation == NETSNMP_CALLBACK_OP_TIMED_OUT) {
+        stats->timeouts++;
+        return;
+    }
+    if (operation != NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE)
+        return;
+
+    netsnmp_get_monotonic_clock(&now);
+    us = (now.tv_sec - axr->sent.tv_sec) * 1000000L +
+        (now.tv_usec - axr->sent.tv_usec);
+    for (i = 0; i < AGENTX_LATENCY_BUCKETS - 1 &&
+         us > agentx_latency_bounds[i]; i++)
+        ;
+    stats->buckets[i]++;
+    stats->responses++;
+    stats->varbinds += axr->nvarbinds;
+    stats->total_us += us;
+    if (us > stats->max_us)
+        stats->max_us = us;
+    if (stats->responses % AGENTX_LATENCY_DUMP_EVERY == 0)
+        agentx_latency_dump(stats);
+}
+
+/*
+ * Log and forget the response times of an AgentX session that has
+ * gone away.
+ */
+void
+agentx_master_session_closed(netsnmp_session *ax_session)
+{
+    agentx_latency *stats, **prevNext;
+
+    for (prevNext = &agentx_latencies; (stats = *prevNext) != NULL;
+         prevNext = &stats->next) {
+        if (stats->ax_session == ax_session) {
+            agentx_latency_dump(stats);
+            *prevNext = stats->next;
+            free(stats);
+            return;
+        }
+    }
+}
+
+/*
+ * Done with a request: a failed send calls back before snmp_async_send()
+ * returns, so while it's being sent only the cache goes and the sender
+ * frees the rest.
+ */
+static void
+agentx_request_free(agentx_request *axr)
+{
+    if (axr->cache)
+        netsnmp_free_delegated_cache(axr->cache);
+    axr->cache = NULL;
+    if (axr->sending)
+        axr->failed = 1;
+    else
+        free(axr);
+}
+
         /*
          * Handle the response from an AgentX subagent,
          *   merging the answers back into the original query
@@ -208,19 +379,22 @@ agentx_got_response(int operation,
                     netsnmp_session * session,
                     int reqid, netsnmp_pdu *pdu, void *magic)
 {
-    netsnmp_delegated_cache *cache = (netsnmp_delegated_cache *) magic;
+    agentx_request *axr = (agentx_request *) magic;
+    netsnmp_delegated_cache *cache;
     int             i, ret;
     netsnmp_request_info *requests, *request;
     netsnmp_variable_list *var;
     netsnmp_session *ax_session;
 
-    cache = netsnmp_handler_check_cache(cache);
+    cache = axr ? netsnmp_handler_check_cache(axr->cache) : NULL;
+    if (axr)
+        agentx_latency_done(axr, operation);
     if (!cache) {
         DEBUGMSGTL(("agentx/master", "response too late on session %8p\n",
                     session));
         /* response is too late, free the cache */
-        if (magic)
-            netsnmp_free_delegated_cache((netsnmp_delegated_cache*) magic);
+        if (axr)
+            agentx_request_free(axr);
         return 0;
     }
     requests = cache->requests;
@@ -259,7 +433,7 @@ agentx_got_response(int operation,
             }
             ax_session = (netsnmp_session *) cache->localinfo;
             netsnmp_free_agent_snmp_session_by_session(ax_session, NULL);
-            netsnmp_free_delegated_cache(cache);
+            agentx_request_free(axr);
             return 0;
         }
 
@@ -277,7 +451,7 @@ agentx_got_response(int operation,
                                                    REQUEST_IS_NOT_DELEGATED);
         netsnmp_set_request_error(cache->reqinfo, requests,     /* XXXWWW: should be index=0 */
                                   SNMP_ERR_GENERR);
-        netsnmp_free_delegated_cache(cache);
+        agentx_request_free(axr);
         return 0;
 
     case NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE:
@@ -289,7 +463,7 @@ agentx_got_response(int operation,
     default:
         snmp_log(LOG_ERR, "Unknown operation %d in agentx_got_response\n",
                  operation);
-        netsnmp_free_delegated_cache(cache);
+        agentx_request_free(axr);
         return 0;
     }
 
@@ -352,7 +526,7 @@ agentx_got_response(int operation,
             netsnmp_set_request_error(cache->reqinfo, requests,
                                       SNMP_ERR_GENERR);
         }
-        netsnmp_free_delegated_cache(cache);
+        agentx_request_free(axr);
         DEBUGMSGTL(("agentx/master", "end error branch\n"));
         return 1;
     } else if (cache->reqinfo->mode == MODE_GET ||
@@ -413,7 +587,7 @@ agentx_got_response(int operation,
     }
     DEBUGMSGTL(("agentx/master",
                 "handle_agentx_response() finishing...\n"));
-    netsnmp_free_delegated_cache(cache);
+    agentx_request_free(axr);
     return 1;
 }
 
@@ -439,7 +613,7 @@ agentx_master_handler(netsnmp_mib_handler *handler,
     netsnmp_session *ax_session = (netsnmp_session *) handler->myvoid;
     netsnmp_request_info *request = requests;
     netsnmp_pdu    *pdu;
-    void           *cb_data;
+    agentx_request *axr = NULL;
     int             result;
 
     DEBUGMSGTL(("agentx/master",
@@ -593,24 +767,46 @@ agentx_master_handler(netsnmp_mib_handler *handler,
      * back from the subagent. So we shouldn't allocate the
      * netsnmp_delegated_cache structure in this case.
      */
-    if (pdu->command != AGENTX_MSG_CLEANUPSET)
-        cb_data = netsnmp_create_delegated_cache(handler, reginfo,
-                                                 reqinfo, requests,
-                                                 (void *) ax_session);
-    else
-        cb_data = NULL;
+    if (pdu->command != AGENTX_MSG_CLEANUPSET) {
+        axr = SNMP_MALLOC_TYPEDEF(agentx_request);
+        if (axr)
+            axr->cache = netsnmp_create_delegated_cache(handler, reginfo,
+                                                        reqinfo, requests,
+                                                        (void *) ax_session);
+        if (!axr || !axr->cache) {
+            SNMP_FREE(axr);
+            snmp_free_pdu(pdu);
+            netsnmp_handler_mark_requests_as_delegated(requests,
+                                                   REQUEST_IS_NOT_DELEGATED);
+            netsnmp_set_request_error(reqinfo, requests, SNMP_ERR_GENERR);
+            return SNMP_ERR_NOERROR;
+        }
+        axr->ax_session = ax_session;
+        for (request = requests; request; request = request->next)
+            axr->nvarbinds++;
+        netsnmp_get_monotonic_clock(&axr->sent);
+        axr->sending = 1;
+    }
 
     /*
      * send the requests out.
      */
-    DEBUGMSGTL(("agentx/master", "sending pdu (req=0x%x,trans=0x%x,sess=0x%x)\n",
-                (unsigned)pdu->reqid, (unsigned)pdu->transid, (unsigned)pdu->sessid));
-    result = snmp_async_send(ax_session, pdu, agentx_got_response, cb_data);
-    if (result == 0) {
-        snmp_free_pdu(pdu);
-        if (cb_data)
-            netsnmp_free_delegated_cache((netsnmp_delegated_cache*) cb_data);
+    DEBUGMSGTL(("agentx/master", "sending pdu (req=0x%x,trans=0x%x,sess=0x%x)"
+                " with %d varbinds\n",
+                (unsigned)pdu->reqid, (unsigned)pdu->transid,
+                (unsigned)pdu->sessid, axr ? axr->nvarbinds : 0));
+    result = snmp_async_send(ax_session, pdu, agentx_got_response, axr);
+    if (axr) {
+        axr->sending = 0;
+        if (result == 0) {
+            if (!axr->failed)
+                netsnmp_free_delegated_cache(axr->cache);
+            free(axr);
+        } else
+            agentx_latency_sent(axr);
     }
+    if (result == 0)
+        snmp_free_pdu(pdu);
 
     return SNMP_ERR_NOERROR;
 }
@@ -152,6 +152,7 @@ close_agentx_session(netsnmp_session * session, int sessid)
         unregister_mibs_by_session(session);
         unregister_index_by_session(session);
         unregister_sysORTable_by_session(session);
+        agentx_master_session_closed(session);
 	SNMP_FREE(session->myvoid);
         return AGENTX_ERR_NOERROR;
     }
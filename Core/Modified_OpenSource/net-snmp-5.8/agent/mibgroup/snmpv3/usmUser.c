@@ -922,6 +922,7 @@ write_usmUserAuthKeyChange(int action,
         }
         uptr->authKeyLen = buflen;
     } else if (action == COMMIT) {
+        sc_key_cache_forget(oldkey, oldkeylen);
         SNMP_FREE(oldkey);
     } else if (action == UNDO) {
         if ((uptr = usm_parse_user(name, name_len)) != NULL && resetOnFail) {
@@ -1215,6 +1216,7 @@ write_usmUserPrivKeyChange(int action,
         }
         uptr->privKeyLen = buflen;
     } else if (action == COMMIT) {
+        sc_key_cache_forget(oldkey, oldkeylen);
         SNMP_FREE(oldkey);
     } else if (action == UNDO) {
         if ((uptr = usm_parse_user(name, name_len)) != NULL && resetOnFail) {
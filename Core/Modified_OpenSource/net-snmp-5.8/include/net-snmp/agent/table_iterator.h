@@ -98,6 +98,9 @@ extern          "C" {
         int             flags;
 #define NETSNMP_ITERATOR_FLAG_SORTED	0x01
 #define NETSNMP_HANDLER_OWNS_IINFO	0x02
+    /** serve GETBULK repetitions from a single row traversal; the data
+        contexts must stay valid for the whole PDU (no make/free hooks) */
+#define NETSNMP_ITERATOR_FLAG_BULK_PREFETCH	0x04
 
        /** A pointer to the netsnmp_table_registration_info object
            this iterator is registered along with. */
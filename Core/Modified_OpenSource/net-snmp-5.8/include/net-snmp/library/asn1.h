@@ -256,6 +256,23 @@ SOFTWARE.
     u_char         *asn_parse_double(u_char *, size_t *, u_char *,
                                      double *, size_t);
 
+    /*
+     * Encoded length helpers: return the exact number of bytes the
+     * builders above (and their reverse counterparts) emit for a value,
+     * header included, so that callers can size packet buffers up front.
+     */
+    NETSNMP_IMPORT
+    size_t          asn_header_encoded_len(size_t);
+    NETSNMP_IMPORT
+    size_t          asn_int_encoded_len(long);
+    NETSNMP_IMPORT
+    size_t          asn_unsigned_int_encoded_len(u_long);
+    NETSNMP_IMPORT
+    size_t          asn_unsigned_int64_encoded_len(u_char,
+                                                   const struct counter64 *);
+    NETSNMP_IMPORT
+    size_t          asn_objid_encoded_len(const oid *, size_t);
+
 #ifdef NETSNMP_USE_REVERSE_ASNENCODING
 
     /*
@@ -0,0 +1,32 @@
+/*
+ * container_skiplist.h
+ * $Id$
+ *
+ * A sorted container kept as a skip list: O(log n) insert, remove,
+ * find and find_next, without the memmove/qsort cost the binary array
+ * pays when rows come and go in the middle of a large table.
+ */
+#ifndef NETSNMP_CONTAINER_SKIPLIST_H
+#define NETSNMP_CONTAINER_SKIPLIST_H
+
+
+#include <net-snmp/library/container.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+    NETSNMP_IMPORT
+    netsnmp_container *netsnmp_container_get_skiplist(void);
+    NETSNMP_IMPORT
+    netsnmp_factory *netsnmp_container_get_skiplist_factory(void);
+
+    NETSNMP_IMPORT
+    void netsnmp_container_skiplist_init(void);
+
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /** NETSNMP_CONTAINER_SKIPLIST_H */
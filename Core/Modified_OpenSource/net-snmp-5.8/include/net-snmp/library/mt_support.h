@@ -38,8 +38,9 @@ extern          "C" {
 #define MT_LIB_MESSAGEID   3
 #define MT_LIB_SESSIONID   4
 #define MT_LIB_TRANSID     5
+#define MT_LIB_KEYCACHE    6
 
-#define MT_LIB_MAXIMUM     6    /* must be one greater than the last one */
+#define MT_LIB_MAXIMUM     7    /* must be one greater than the last one */
 
 
 #if defined(NETSNMP_REENTRANT) || defined(WIN32)
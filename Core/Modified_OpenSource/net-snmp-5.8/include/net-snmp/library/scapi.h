@@ -131,6 +131,11 @@ typedef struct netsnmp_priv_alg_info_s {
     NETSNMP_IMPORT
     int             sc_random(u_char * buf, size_t * buflen);
 
+    NETSNMP_IMPORT
+    void            sc_key_cache_forget(const u_char * key, u_int keylen);
+    NETSNMP_IMPORT
+    void            sc_key_cache_flush(void);
+
     NETSNMP_IMPORT
     int             sc_generate_keyed_hash(const oid * authtype,
                                            size_t authtypelen,
@@ -352,6 +352,11 @@ SOFTWARE.
     NETSNMP_IMPORT
     u_char         *snmp_build_var_op(u_char *, oid *, size_t *, u_char,
                                       size_t, u_char *, size_t *);
+    NETSNMP_IMPORT
+    size_t          snmp_var_op_encoded_len(const oid *, size_t, u_char,
+                                            const u_char *, size_t);
+    NETSNMP_IMPORT
+    size_t          snmp_varbind_list_encoded_len(struct variable_list *);
 
 
 #ifdef NETSNMP_USE_REVERSE_ASNENCODING
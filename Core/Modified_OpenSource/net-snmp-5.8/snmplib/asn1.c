@@ -2830,6 +2830,188 @@ asn_build_double(u_char * data,
 #endif                          /* NETSNMP_WITH_OPAQUE_SPECIAL_TYPES */
 
 
+/**
+ * @internal
+ * computes the number of bytes needed to encode an ASN header (type
+ * byte plus length octets) for an object whose contents are length
+ * bytes long.  Matches asn_build_header() and asn_realloc_rbuild_header().
+ *
+ * @param length  IN - length of the object contents
+ *
+ * @return number of bytes the header occupies
+ */
+size_t
+asn_header_encoded_len(size_t length)
+{
+    size_t          len = 2;
+
+    if (length > 0x7f) {
+        while (length != 0) {
+            len++;
+            length >>= 8;
+        }
+    }
+    return len;
+}
+
+/**
+ * @internal
+ * computes the number of bytes needed to BER encode an integer,
+ * including its header.
+ *
+ * @see asn_build_int
+ *
+ * @param integer IN - value to encode
+ *
+ * @return encoded length in bytes
+ */
+size_t
+asn_int_encoded_len(long integer)
+{
+    long            testvalue;
+    u_char          last;
+    size_t          len = 1;
+
+    CHECK_OVERFLOW_S(integer,14);
+    testvalue = (integer < 0) ? -1 : 0;
+
+    last = (u_char) integer;
+    integer >>= 8;
+    while (integer != testvalue) {
+        last = (u_char) integer;
+        integer >>= 8;
+        len++;
+    }
+    if ((last & 0x80) != (testvalue & 0x80))
+        len++;
+
+    return asn_header_encoded_len(len) + len;
+}
+
+/**
+ * @internal
+ * computes the number of bytes needed to BER encode an unsigned integer
+ * (Counter32, Gauge32, TimeTicks, UInteger32), including its header.
+ *
+ * @see asn_build_unsigned_int
+ *
+ * @param integer IN - value to encode
+ *
+ * @return encoded length in bytes
+ */
+size_t
+asn_unsigned_int_encoded_len(u_long integer)
+{
+    u_char          last;
+    size_t          len = 1;
+
+    CHECK_OVERFLOW_U(integer,15);
+
+    last = (u_char) integer;
+    integer >>= 8;
+    while (integer != 0) {
+        last = (u_char) integer;
+        integer >>= 8;
+        len++;
+    }
+    if (last & 0x80)
+        len++;
+
+    return asn_header_encoded_len(len) + len;
+}
+
+/**
+ * @internal
+ * computes the number of bytes needed to BER encode a Counter64,
+ * including its header (and the Opaque wrapper for the opaque
+ * 64 bit types).
+ *
+ * @see asn_build_unsigned_int64
+ *
+ * @param type    IN - type of object
+ * @param cp      IN - pointer to counter struct
+ *
+ * @return encoded length in bytes
+ */
+size_t
+asn_unsigned_int64_encoded_len(u_char type, const struct counter64 *cp)
+{
+    u_long          low = cp->low, high = cp->high;
+    u_char          last;
+    size_t          len = 1;
+
+    CHECK_OVERFLOW_U(high,16);
+    CHECK_OVERFLOW_U(low,16);
+
+    last = (u_char) low;
+    low >>= 8;
+    while (low != 0) {
+        last = (u_char) low;
+        low >>= 8;
+        len++;
+    }
+    if (high) {
+        len = 5;
+        last = (u_char) high;
+        high >>= 8;
+        while (high != 0) {
+            last = (u_char) high;
+            high >>= 8;
+            len++;
+        }
+    }
+    if (last & 0x80)
+        len++;
+
+#ifdef NETSNMP_WITH_OPAQUE_SPECIAL_TYPES
+    if (type == ASN_OPAQUE_COUNTER64 || type == ASN_OPAQUE_U64)
+        return asn_header_encoded_len(len + 3) + len + 3;
+#endif                          /* NETSNMP_WITH_OPAQUE_SPECIAL_TYPES */
+
+    return asn_header_encoded_len(len) + len;
+}
+
+/**
+ * @internal
+ * computes the number of bytes needed to BER encode an object
+ * identifier, including its header.
+ *
+ * @see asn_build_objid
+ *
+ * @param objid       IN - pointer to the object id
+ * @param objidlength IN - number of sub-identifiers
+ *
+ * @return encoded length in bytes
+ */
+size_t
+asn_objid_encoded_len(const oid * objid, size_t objidlength)
+{
+    size_t          i, len;
+    u_long          subid;
+
+    if (objidlength == 0) {
+        len = 2;
+    } else if (objidlength == 1) {
+        len = 1;
+    } else {
+        len = 0;
+        for (i = 1; i < objidlength; i++) {
+            if (i == 1) {
+                subid = (objid[0] * 40) + objid[1];
+            } else {
+                subid = objid[i];
+                CHECK_OVERFLOW_U(subid,17);
+            }
+            do {
+                len++;
+                subid >>= 7;
+            } while (subid > 0);
+        }
+    }
+
+    return asn_header_encoded_len(len) + len;
+}
+
 /**
  * @internal
  * This function increases the size of the buffer pointed to by *pkt, which
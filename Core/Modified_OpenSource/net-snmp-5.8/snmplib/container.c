@@ -19,6 +19,7 @@
 #include <net-snmp/library/container.h>
 #include <net-snmp/library/container_binary_array.h>
 #include <net-snmp/library/container_list_ssll.h>
+#include <net-snmp/library/container_skiplist.h>
 #include <net-snmp/library/container_null.h>
 
 netsnmp_feature_child_of(container_all, libnetsnmp)
@@ -95,6 +96,9 @@ netsnmp_container_init_list(void)
 #ifndef NETSNMP_FEATURE_REMOVE_CONTAINER_LINKED_LIST
     netsnmp_container_ssll_init();
 #endif /* NETSNMP_FEATURE_REMOVE_CONTAINER_LINKED_LIST */
+#ifndef NETSNMP_FEATURE_REMOVE_CONTAINER_SKIPLIST
+    netsnmp_container_skiplist_init();
+#endif /* NETSNMP_FEATURE_REMOVE_CONTAINER_SKIPLIST */
 #ifndef NETSNMP_FEATURE_REMOVE_CONTAINER_NULL
     netsnmp_container_null_init();
 #endif /* NETSNMP_FEATURE_REMOVE_CONTAINER_NULL */
@@ -0,0 +1,619 @@
+/*
+ * container_skiplist.c
+ * $Id$
+ *
+ * A sorted container kept as a skip list.  Every node sits on level 0
+ * (an ordinary sorted singly linked list); each node is also linked
+ * into levels 1..n-1 with probability 1/4 per level, so a search can
+ * skip over most of the list from the top level down.  Insert, remove,
+ * find and find_next are O(log n) expected, and nothing is ever moved:
+ * rows can come and go anywhere in the table without the memmove of
+ * the binary array, and unsorted bulk loads never need a qsort.
+ */
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-features.h>
+
+#include <stdio.h>
+#if HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#if HAVE_MALLOC_H
+#include <malloc.h>
+#endif
+#include <sys/types.h>
+#if HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+
+#include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/types.h>
+#include <net-snmp/library/snmp_api.h>
+#include <net-snmp/library/container.h>
+#include <net-snmp/library/tools.h>
+#include <net-snmp/library/snmp_assert.h>
+
+#include <net-snmp/library/container_skiplist.h>
+
+netsnmp_feature_child_of(container_skiplist, container_types)
+
+#ifndef NETSNMP_FEATURE_REMOVE_CONTAINER_SKIPLIST
+/*
+ * 16 levels at p = 1/4 keep searches logarithmic well past 4^16 rows.
+ */
+#define SKIPLIST_MAX_LEVEL 16
+
+typedef struct skiplist_node_s {
+    void                    *data;
+    int                      level;     /* number of next pointers */
+    struct skiplist_node_s  *next[1];   /* really next[level] */
+} skiplist_node;
+
+typedef struct skiplist_container_s {
+    netsnmp_container          c;
+
+    size_t                     count;   /* number of nodes */
+    int                        level;   /* highest level in use */
+    u_int                      seed;    /* level generator state */
+    skiplist_node             *head;    /* SKIPLIST_MAX_LEVEL sentinel */
+} skiplist_container;
+
+typedef struct skiplist_iterator_s {
+    netsnmp_iterator base;
+
+    skiplist_node   *pos;
+} skiplist_iterator;
+
+static netsnmp_iterator *_skiplist_iterator_get(netsnmp_container *c);
+
+
+static skiplist_node *
+_skiplist_node_new(int level, const void *data)
+{
+    skiplist_node *n;
+
+    n = (skiplist_node *)calloc(1, sizeof(skiplist_node) +
+                                (level - 1) * sizeof(skiplist_node *));
+    if (NULL == n)
+        return NULL;
+    n->data = NETSNMP_REMOVE_CONST(void *, data);
+    n->level = level;
+
+    return n;
+}
+
+/*
+ * pick a level for a new node: xorshift32, two bits per level.
+ */
+static int
+_skiplist_random_level(skiplist_container *sl)
+{
+    u_int r;
+    int   level = 1;
+
+    sl->seed ^= sl->seed << 13;
+    sl->seed ^= sl->seed >> 17;
+    sl->seed ^= sl->seed << 5;
+
+    for (r = sl->seed; (0 == (r & 3)) && (level < SKIPLIST_MAX_LEVEL);
+         r >>= 2)
+        ++level;
+
+    return level;
+}
+
+/*
+ * walk down from the top level, returning the first node whose data
+ * compares > key (after != 0) or >= key (after == 0). If update is not
+ * NULL, update[i] is left pointing at that node's predecessor on each
+ * level in use.
+ */
+static skiplist_node *
+_skiplist_search(skiplist_container *sl, const void *key,
+                 netsnmp_container_compare *cmp, int after,
+                 skiplist_node **update)
+{
+    skiplist_node *x = sl->head;
+    int            i;
+
+    for (i = sl->level - 1; i >= 0; --i) {
+        while (x->next[i] && (cmp(x->next[i]->data, key) < after))
+            x = x->next[i];
+        if (update)
+            update[i] = x;
+    }
+
+    return x->next[0];
+}
+
+/**********************************************************************
+ *
+ *
+ *
+ **********************************************************************/
+static void
+_skiplist_clear(netsnmp_container *c, netsnmp_container_obj_func *f,
+                void *context)
+{
+    skiplist_container *sl = (skiplist_container*)c;
+    skiplist_node      *curr, *next;
+    int                 i;
+
+    if(NULL == c)
+        return;
+
+    for(curr = sl->head->next[0]; curr; curr = next) {
+        next = curr->next[0];
+
+        if( NULL != f )
+            (*f) ((void *)curr->data, context);
+
+        /*
+         * free our node structure, but not the data
+         */
+        free(curr);
+    }
+    for (i = 0; i < SKIPLIST_MAX_LEVEL; ++i)
+        sl->head->next[i] = NULL;
+    sl->level = 1;
+    sl->count = 0;
+    ++c->sync;
+}
+
+static int
+_skiplist_free(netsnmp_container *c)
+{
+    skiplist_container *sl = (skiplist_container*)c;
+
+    if(c) {
+        _skiplist_clear(c, NULL, NULL);
+        free(sl->head);
+        free(c);
+    }
+    return 0;
+}
+
+static void *
+_skiplist_find(netsnmp_container *c, const void *data)
+{
+    skiplist_container *sl = (skiplist_container*)c;
+    skiplist_node      *n;
+
+    if((NULL == c) || (NULL == data))
+        return NULL;
+
+    n = _skiplist_search(sl, data, c->compare, 0, NULL);
+    if ((NULL == n) || (c->compare(n->data, data) != 0))
+        return NULL;
+
+    return n->data;
+}
+
+static void *
+_skiplist_find_next(netsnmp_container *c, const void *data)
+{
+    skiplist_container *sl = (skiplist_container*)c;
+    skiplist_node      *n;
+
+    if(NULL == c)
+        return NULL;
+
+    /*
+     * NULL key: return the first entry
+     */
+    if (NULL == data)
+        n = sl->head->next[0];
+    else
+        n = _skiplist_search(sl, data, c->compare, 1, NULL);
+
+    return n ? n->data : NULL;
+}
+
+static int
+_skiplist_insert(netsnmp_container *c, const void *data)
+{
+    skiplist_container *sl = (skiplist_container*)c;
+    skiplist_node      *update[SKIPLIST_MAX_LEVEL], *n;
+    int                 i, level;
+
+    if ((NULL == c) || (NULL == data))
+        return -1;
+
+    /*
+     * search past any equal keys, so duplicates (if allowed) keep their
+     * insertion order, and the node before the gap tells us if the key
+     * is already there.
+     */
+    _skiplist_search(sl, data, c->compare, 1, update);
+    if (!(c->flags & CONTAINER_KEY_ALLOW_DUPLICATES) &&
+        (update[0] != sl->head) &&
+        (c->compare(update[0]->data, data) == 0)) {
+        DEBUGMSGTL(("container","not inserting duplicate key\n"));
+        return -1;
+    }
+
+    level = _skiplist_random_level(sl);
+    n = _skiplist_node_new(level, data);
+    if (NULL == n)
+        return -1;
+
+    if (level > sl->level) {
+        for (i = sl->level; i < level; ++i)
+            update[i] = sl->head;
+        sl->level = level;
+    }
+
+    for (i = 0; i < level; ++i) {
+        n->next[i] = update[i]->next[i];
+        update[i]->next[i] = n;
+    }
+
+    ++sl->count;
+    ++c->sync;
+
+    return 0;
+}
+
+static int
+_skiplist_remove(netsnmp_container *c, const void *data)
+{
+    skiplist_container *sl = (skiplist_container*)c;
+    skiplist_node      *update[SKIPLIST_MAX_LEVEL], *n;
+    int                 i;
+
+    if ((NULL == c) || (NULL == data))
+        return -1;
+
+    n = _skiplist_search(sl, data, c->compare, 0, update);
+    if ((NULL == n) || (c->compare(n->data, data) != 0))
+        return -1;
+
+    for (i = 0; i < n->level; ++i)
+        update[i]->next[i] = n->next[i];
+    while ((sl->level > 1) && (NULL == sl->head->next[sl->level - 1]))
+        --sl->level;
+
+    /*
+     * free our node structure, but not the data
+     */
+    free(n);
+    --sl->count;
+    ++c->sync;
+
+    return 0;
+}
+
+static size_t
+_skiplist_size(netsnmp_container *c)
+{
+    skiplist_container *sl = (skiplist_container*)c;
+
+    if(NULL == c)
+        return 0;
+
+    return sl->count;
+}
+
+static void
+_skiplist_for_each(netsnmp_container *c, netsnmp_container_obj_func *f,
+                   void *context)
+{
+    skiplist_container *sl = (skiplist_container*)c;
+    skiplist_node      *curr;
+
+    if(NULL == c)
+        return;
+
+    for(curr = sl->head->next[0]; curr; curr = curr->next[0])
+        (*f) ((void *)curr->data, context);
+}
+
+static netsnmp_void_array *
+_skiplist_get_subset(netsnmp_container *c, void *key)
+{
+    skiplist_container *sl = (skiplist_container*)c;
+    skiplist_node      *start, *n;
+    netsnmp_void_array *va;
+    size_t              len, i;
+
+    if ((NULL == c) || (NULL == key))
+        return NULL;
+    netsnmp_assert(c->ncompare);
+    if (NULL == c->ncompare)
+        return NULL;
+
+    /*
+     * matching entries are contiguous on level 0
+     */
+    start = _skiplist_search(sl, key, c->ncompare, 0, NULL);
+    for (len = 0, n = start; n && (0 == c->ncompare(n->data, key));
+         n = n->next[0])
+        ++len;
+    if (0 == len)
+        return NULL;
+
+    va = SNMP_MALLOC_TYPEDEF(netsnmp_void_array);
+    if (NULL == va)
+        return NULL;
+    va->array = (void **)malloc(len * sizeof(void*));
+    if (NULL == va->array) {
+        free(va);
+        return NULL;
+    }
+    for (i = 0, n = start; i < len; ++i, n = n->next[0])
+        va->array[i] = n->data;
+    va->size = len;
+
+    return va;
+}
+
+static int
+_skiplist_options(netsnmp_container *c, int set, u_int flags)
+{
+    /*
+     * always sorted; only duplicate keys are optional
+     */
+    if (set) {
+        if ((flags & CONTAINER_KEY_ALLOW_DUPLICATES) == flags)
+            c->flags = flags;
+        else
+            flags = (u_int)-1; /* unsupported flag */
+    }
+    else
+        return ((c->flags & flags) == flags);
+    return flags;
+}
+
+static netsnmp_container *
+_skiplist_duplicate(netsnmp_container *c, void *ctx, u_int flags)
+{
+    skiplist_container *sl = (skiplist_container*)c, *dupsl;
+    skiplist_node      *tail[SKIPLIST_MAX_LEVEL], *n, *dn;
+    netsnmp_container  *dup;
+    int                 i;
+
+    if (flags) {
+        snmp_log(LOG_ERR, "skiplist duplicate does not support flags yet\n");
+        return NULL;
+    }
+
+    dup = netsnmp_container_get_skiplist();
+    if (NULL == dup) {
+        snmp_log(LOG_ERR," no memory for skiplist duplicate\n");
+        return NULL;
+    }
+    /*
+     * deal with container stuff
+     */
+    if (netsnmp_container_data_dup(dup, c) != 0) {
+        _skiplist_free(dup);
+        return NULL;
+    }
+
+    /*
+     * shallow copy: the source is already in order, so append each node
+     * to the tail of every level it lands on.
+     */
+    dupsl = (skiplist_container*)dup;
+    for (i = 0; i < SKIPLIST_MAX_LEVEL; ++i)
+        tail[i] = dupsl->head;
+    for (n = sl->head->next[0]; n; n = n->next[0]) {
+        dn = _skiplist_node_new(_skiplist_random_level(dupsl), n->data);
+        if (NULL == dn) {
+            snmp_log(LOG_ERR, "no memory for skiplist duplicate\n");
+            _skiplist_free(dup);
+            return NULL;
+        }
+        for (i = 0; i < dn->level; ++i) {
+            tail[i]->next[i] = dn;
+            tail[i] = dn;
+        }
+        if (dn->level > dupsl->level)
+            dupsl->level = dn->level;
+        ++dupsl->count;
+    }
+
+    return dup;
+}
+
+/**********************************************************************
+ *
+ *
+ *
+ **********************************************************************/
+netsnmp_container *
+netsnmp_container_get_skiplist(void)
+{
+    /*
+     * allocate memory
+     */
+    skiplist_container *sl = SNMP_MALLOC_TYPEDEF(skiplist_container);
+    if (NULL==sl) {
+        snmp_log(LOG_ERR, "couldn't allocate memory\n");
+        return NULL;
+    }
+    sl->head = _skiplist_node_new(SKIPLIST_MAX_LEVEL, NULL);
+    if (NULL==sl->head) {
+        snmp_log(LOG_ERR, "couldn't allocate memory\n");
+        free(sl);
+        return NULL;
+    }
+    sl->level = 1;
+    sl->seed = 0x9e3779b9;
+
+    /*
+     * NOTE: CHANGES HERE MUST BE DUPLICATED IN duplicate AS WELL!!
+     */
+    netsnmp_init_container((netsnmp_container *)sl, NULL, _skiplist_free,
+                           _skiplist_size, NULL, _skiplist_insert,
+                           _skiplist_remove, _skiplist_find);
+    sl->c.find_next = _skiplist_find_next;
+    sl->c.get_subset = _skiplist_get_subset;
+    sl->c.get_iterator = _skiplist_iterator_get;
+    sl->c.for_each = _skiplist_for_each;
+    sl->c.clear = _skiplist_clear;
+    sl->c.options = _skiplist_options;
+    sl->c.duplicate = _skiplist_duplicate;
+
+    return (netsnmp_container*)sl;
+}
+
+netsnmp_factory *
+netsnmp_container_get_skiplist_factory(void)
+{
+    static netsnmp_factory f = {"skiplist",
+                                (netsnmp_factory_produce_f*)
+                                netsnmp_container_get_skiplist };
+
+    return &f;
+}
+
+void
+netsnmp_container_skiplist_init(void)
+{
+    netsnmp_container_register("skiplist",
+                               netsnmp_container_get_skiplist_factory());
+}
+
+
+/**********************************************************************
+ *
+ * iterator
+ *
+ */
+NETSNMP_STATIC_INLINE skiplist_container *
+_skiplist_it2cont(skiplist_iterator *it)
+{
+    if(NULL == it) {
+        netsnmp_assert(NULL != it);
+        return NULL;
+    }
+
+    if(NULL == it->base.container) {
+        netsnmp_assert(NULL != it->base.container);
+        return NULL;
+    }
+
+    if(it->base.container->sync != it->base.sync) {
+        DEBUGMSGTL(("container:iterator", "out of sync\n"));
+        return NULL;
+    }
+
+    return (skiplist_container *)it->base.container;
+}
+
+static void *
+_skiplist_iterator_curr(skiplist_iterator *it)
+{
+    skiplist_container *t = _skiplist_it2cont(it);
+    if ((NULL == t) || (NULL == it->pos))
+        return NULL;
+
+    return it->pos->data;
+}
+
+static void *
+_skiplist_iterator_first(skiplist_iterator *it)
+{
+    skiplist_container *t = _skiplist_it2cont(it);
+    if (NULL == t)
+        return NULL;
+
+    it->pos = t->head->next[0];
+
+    return it->pos ? it->pos->data : NULL;
+}
+
+static void *
+_skiplist_iterator_next(skiplist_iterator *it)
+{
+    skiplist_container *t = _skiplist_it2cont(it);
+    if ((NULL == t) || (NULL == it->pos))
+        return NULL;
+
+    it->pos = it->pos->next[0];
+
+    return it->pos ? it->pos->data : NULL;
+}
+
+static void *
+_skiplist_iterator_last(skiplist_iterator *it)
+{
+    skiplist_node      *n;
+    int                 i;
+    skiplist_container *t = _skiplist_it2cont(it);
+    if(NULL == t)
+        return NULL;
+
+    for (n = t->head, i = t->level - 1; i >= 0; --i)
+        while (n->next[i])
+            n = n->next[i];
+
+    return (n == t->head) ? NULL : n->data;
+}
+
+static int
+_skiplist_iterator_reset(skiplist_iterator *it)
+{
+    skiplist_container *t;
+
+    /** can't use it2conf cuz we might be out of sync */
+    if(NULL == it) {
+        netsnmp_assert(NULL != it);
+        return 0;
+    }
+
+    if(NULL == it->base.container) {
+        netsnmp_assert(NULL != it->base.container);
+        return 0;
+    }
+    t = (skiplist_container *)it->base.container;
+
+    it->pos = t->head->next[0];
+
+    /*
+     * save sync count, to make sure container doesn't change while
+     * iterator is in use.
+     */
+    it->base.sync = it->base.container->sync;
+
+    return 0;
+}
+
+static int
+_skiplist_iterator_release(netsnmp_iterator *it)
+{
+    free(it);
+
+    return 0;
+}
+
+static netsnmp_iterator *
+_skiplist_iterator_get(netsnmp_container *c)
+{
+    skiplist_iterator* it;
+
+    if(NULL == c)
+        return NULL;
+
+    it = SNMP_MALLOC_TYPEDEF(skiplist_iterator);
+    if(NULL == it)
+        return NULL;
+
+    it->base.container = c;
+
+    it->base.first = (netsnmp_iterator_rtn*)_skiplist_iterator_first;
+    it->base.next = (netsnmp_iterator_rtn*)_skiplist_iterator_next;
+    it->base.curr = (netsnmp_iterator_rtn*)_skiplist_iterator_curr;
+    it->base.last = (netsnmp_iterator_rtn*)_skiplist_iterator_last;
+    it->base.reset = (netsnmp_iterator_rc*)_skiplist_iterator_reset;
+    it->base.release = (netsnmp_iterator_rc*)_skiplist_iterator_release;
+
+    (void)_skiplist_iterator_reset(it);
+
+    return (netsnmp_iterator *)it;
+}
+#else /* NETSNMP_FEATURE_REMOVE_CONTAINER_SKIPLIST */
+netsnmp_feature_unused(container_skiplist);
+#endif /* NETSNMP_FEATURE_REMOVE_CONTAINER_SKIPLIST */
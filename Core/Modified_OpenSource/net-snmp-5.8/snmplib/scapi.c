@@ -65,6 +65,8 @@ netsnmp_feature_child_of(usm_scapi, usm_support)
 #include <net-snmp/library/md5.h>
 #endif
 #include <net-snmp/library/snmp_api.h>
+#include <net-snmp/library/default_store.h>
+#include <net-snmp/library/mt_support.h>
 #include <net-snmp/library/callback.h>
 #include <net-snmp/library/snmp_secmod.h>
 #include <net-snmp/library/snmpusm.h>
@@ -688,8 +690,305 @@ sc_get_openssl_privfn(int priv_type)
 
     return fn;
 }
+
+/*
+ * keyed transform cache
+ *
+ * Every HMAC costs two extra hash compressions to absorb key^ipad and
+ * key^opad, and every AES operation a context allocation and key
+ * schedule, although a user's localized keys only change on a key
+ * change.  The keyed state is therefore kept here, one entry per
+ * (transform, key), looked up by the key bytes themselves: a changed
+ * key simply misses and its old entry ages out, or is dropped at once
+ * by sc_key_cache_forget() when the user goes away.
+ */
+#define SC_KEY_CACHE_SIZE    32
+#define SC_KEY_CACHE_MAXKEY  64     /* longest localized key (SHA-512) */
+#define SC_HMAC_MAX_BLOCK   128     /* SHA-384/512 block size */
+
+#define SC_KEY_CACHE_HMAC     1
+#define SC_KEY_CACHE_ENCRYPT  2
+#define SC_KEY_CACHE_DECRYPT  3
+
+typedef struct sc_key_cache_s {
+    int             kind;           /* SC_KEY_CACHE_*, 0 if unused */
+    int             type;           /* auth or priv type */
+    u_char          key[SC_KEY_CACHE_MAXKEY];
+    u_int           keylen;
+    u_int           used;           /* for LRU replacement */
+    EVP_MD_CTX     *ictx;           /* hmac: key^ipad absorbed */
+    EVP_MD_CTX     *octx;           /* hmac: key^opad absorbed */
+    EVP_MD_CTX     *mctx;           /* hmac: per message scratch */
+    EVP_CIPHER_CTX *cctx;           /* cipher: key schedule */
+} sc_key_cache;
+
+static sc_key_cache _sc_key_cache[SC_KEY_CACHE_SIZE];
+static u_int        _sc_key_cache_clock;
+
+static EVP_MD_CTX *
+_sc_md_ctx_new(void)
+{
+    EVP_MD_CTX     *cptr;
+
+#if defined(HAVE_EVP_MD_CTX_NEW)
+    cptr = EVP_MD_CTX_new();
+#elif defined(HAVE_EVP_MD_CTX_CREATE)
+    cptr = EVP_MD_CTX_create();
+#else
+    cptr = malloc(sizeof(*cptr));
+    if (cptr)
+#if defined(OLD_DES)
+        memset(cptr, 0, sizeof(*cptr));
+#else
+        EVP_MD_CTX_init(cptr);
+#endif
+#endif
+    return cptr;
+}
+
+static void
+_sc_md_ctx_free(EVP_MD_CTX *cptr)
+{
+    if (NULL == cptr)
+        return;
+#if defined(HAVE_EVP_MD_CTX_FREE)
+    EVP_MD_CTX_free(cptr);
+#elif defined(HAVE_EVP_MD_CTX_DESTROY)
+    EVP_MD_CTX_destroy(cptr);
+#else
+#if !defined(OLD_DES)
+    EVP_MD_CTX_cleanup(cptr);
+#endif
+    free(cptr);
+#endif
+}
+
+static void
+_sc_key_cache_release(sc_key_cache *e)
+{
+    _sc_md_ctx_free(e->ictx);
+    _sc_md_ctx_free(e->octx);
+    _sc_md_ctx_free(e->mctx);
+    if (e->cctx)
+        EVP_CIPHER_CTX_free(e->cctx);
+    memset(e, 0, sizeof(*e));
+}
+
+/*
+ * absorb the padded key into the inner and outer digest states
+ * (RFC 2104), so each message only hashes itself and the inner digest.
+ */
+static int
+_sc_key_cache_hmac_setup(sc_key_cache *e, const EVP_MD *hashfn,
+                         const u_char *key, u_int keylen)
+{
+    u_char          pad[SC_HMAC_MAX_BLOCK];
+    u_char          hkey[EVP_MAX_MD_SIZE];
+    unsigned int    hkeylen;
+    int             block = EVP_MD_block_size(hashfn), i, rc = 0;
+
+    if (block <= 0 || block > (int)sizeof(pad))
+        return 0;
+    if (keylen > (u_int)block) {
+        if (!EVP_Digest(key, keylen, hkey, &hkeylen, hashfn, NULL))
+            return 0;
+        key = hkey;
+        keylen = hkeylen;
+    }
+
+    e->ictx = _sc_md_ctx_new();
+    e->octx = _sc_md_ctx_new();
+    e->mctx = _sc_md_ctx_new();
+    if (e->ictx && e->octx && e->mctx) {
+        memset(pad, 0x36, block);
+        for (i = 0; i < (int)keylen; i++)
+            pad[i] ^= key[i];
+        rc = EVP_DigestInit_ex(e->ictx, hashfn, NULL) &&
+            EVP_DigestUpdate(e->ictx, pad, block);
+        memset(pad, 0x5c, block);
+        for (i = 0; i < (int)keylen; i++)
+            pad[i] ^= key[i];
+        rc = rc && EVP_DigestInit_ex(e->octx, hashfn, NULL) &&
+            EVP_DigestUpdate(e->octx, pad, block);
+    }
+
+    memset(pad, 0, sizeof(pad));
+    memset(hkey, 0, sizeof(hkey));
+    return rc;
+}
+
+/*
+ * find (or build) the entry for kind/type/key. Must be called with the
+ * keycache lock held.
+ */
+static sc_key_cache *
+_sc_key_cache_get(int kind, int type, const void *fn,
+                  const u_char *key, u_int keylen)
+{
+    sc_key_cache   *e, *victim = NULL;
+    int             i;
+
+    if (netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
+                               NETSNMP_DS_LIB_NO_KEY_CACHE) ||
+        keylen > SC_KEY_CACHE_MAXKEY)
+        return NULL;
+
+    for (i = 0; i < SC_KEY_CACHE_SIZE; i++) {
+        e = &_sc_key_cache[i];
+        if (e->kind == kind && e->type == type && e->keylen == keylen &&
+            memcmp(e->key, key, keylen) == 0) {
+            e->used = ++_sc_key_cache_clock;
+            return e;
+        }
+        if (NULL == victim || e->kind == 0 ||
+            (victim->kind != 0 && e->used < victim->used))
+            victim = e;
+    }
+
+    DEBUGMSGTL(("scapi:keycache", "new %s entry for type %d\n",
+                kind == SC_KEY_CACHE_HMAC ? "hmac" : "cipher", type));
+    e = victim;
+    _sc_key_cache_release(e);
+    if (SC_KEY_CACHE_HMAC == kind) {
+        if (!_sc_key_cache_hmac_setup(e, (const EVP_MD *)fn, key, keylen)) {
+            _sc_key_cache_release(e);
+            return NULL;
+        }
+    } else {
+        e->cctx = EVP_CIPHER_CTX_new();
+        if (NULL == e->cctx ||
+            1 != EVP_CipherInit_ex(e->cctx, (const EVP_CIPHER *)fn, NULL,
+                                   key, NULL,
+                                   kind == SC_KEY_CACHE_ENCRYPT)) {
+            _sc_key_cache_release(e);
+            return NULL;
+        }
+    }
+    e->kind = kind;
+    e->type = type;
+    memcpy(e->key, key, keylen);
+    e->keylen = keylen;
+    e->used = ++_sc_key_cache_clock;
+
+    return e;
+}
+
+/*
+ * HMAC of message with a cached keyed state. Returns SNMPERR_GENERR if
+ * the key can't be cached; the caller then does a one-shot HMAC.
+ */
+static int
+_sc_key_cache_hmac(int auth_type, const EVP_MD *hashfn,
+                   const u_char *key, u_int keylen,
+                   const u_char *message, u_int msglen,
+                   u_char *MAC, unsigned int *maclen)
+{
+    sc_key_cache   *e;
+    u_char          inner[EVP_MAX_MD_SIZE];
+    unsigned int    inner_len;
+    int             rc;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+    e = _sc_key_cache_get(SC_KEY_CACHE_HMAC, auth_type, hashfn, key, keylen);
+    rc = e &&
+        EVP_MD_CTX_copy_ex(e->mctx, e->ictx) &&
+        EVP_DigestUpdate(e->mctx, message, msglen) &&
+        EVP_DigestFinal_ex(e->mctx, inner, &inner_len) &&
+        EVP_MD_CTX_copy_ex(e->mctx, e->octx) &&
+        EVP_DigestUpdate(e->mctx, inner, inner_len) &&
+        EVP_DigestFinal_ex(e->mctx, MAC, maclen);
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+
+    memset(inner, 0, sizeof(inner));
+    return rc ? SNMPERR_SUCCESS : SNMPERR_GENERR;
+}
+
+/*
+ * en/decrypt with a cached key schedule; only the IV is set per call.
+ * Returns SNMPERR_GENERR if the key can't be cached (or the cipher
+ * fails); the caller then sets up a context of its own.
+ */
+static int
+_sc_key_cache_crypt(int kind, int priv_type, const EVP_CIPHER *cipher,
+                    const u_char *key, u_int keylen, const u_char *iv,
+                    const u_char *in, u_int inlen, u_char *out)
+{
+    sc_key_cache   *e;
+    int             len, rc;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+    e = _sc_key_cache_get(kind, priv_type, cipher, key, keylen);
+    rc = e &&
+        1 == EVP_CipherInit_ex(e->cctx, NULL, NULL, NULL, iv, -1) &&
+        1 == EVP_CipherUpdate(e->cctx, out, &len, in, inlen) &&
+        1 == EVP_CipherFinal_ex(e->cctx, out + len, &len);
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+
+    return rc ? SNMPERR_SUCCESS : SNMPERR_GENERR;
+}
 #endif /* openssl */
 
+/*******************************************************************-o-******
+ * sc_key_cache_forget
+ *
+ * Parameters:
+ *	*key		Key bits no longer in use.
+ *	 keylen		Length of key in bytes.
+ *
+ * Drops (and clears) every cached keyed transform built from key.
+ */
+void
+sc_key_cache_forget(const u_char * key, u_int keylen)
+{
+#ifdef NETSNMP_USE_OPENSSL
+    int             i;
+
+    if (NULL == key)
+        return;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+    for (i = 0; i < SC_KEY_CACHE_SIZE; i++)
+        if (_sc_key_cache[i].kind && _sc_key_cache[i].keylen == keylen &&
+            memcmp(_sc_key_cache[i].key, key, keylen) == 0)
+            _sc_key_cache_release(&_sc_key_cache[i]);
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+#endif
+}
+
+/*******************************************************************-o-******
+ * sc_key_cache_flush
+ *
+ * Drops (and clears) every cached keyed transform.
+ */
+void
+sc_key_cache_flush(void)
+{
+#ifdef NETSNMP_USE_OPENSSL
+    int             i;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+    for (i = 0; i < SC_KEY_CACHE_SIZE; i++)
+        if (_sc_key_cache[i].kind)
+            _sc_key_cache_release(&_sc_key_cache[i]);
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+#endif
+}
+
+/*******************************************************************-o-******
+ * sc_shutdown
+ *
+ * Returns:
+ *	SNMPERR_SUCCESS			Success.
+ *
+ * SNMP_CALLBACK_SHUTDOWN callback: clears the keyed transform cache.
+ */
+int
+sc_shutdown(int majorID, int minorID, void *serverarg, void *clientarg)
+{
+    sc_key_cache_flush();
+    return SNMPERR_SUCCESS;
+}
+
 
 /*******************************************************************-o-******
  * sc_generate_keyed_hash
@@ -778,7 +1077,11 @@ sc_generate_keyed_hash(const oid * authtypeOID, size_t authtypeOIDlen,
         QUITFUN(SNMPERR_GENERR, sc_generate_keyed_hash_quit);
     }
 
-    HMAC(hashfn, key, keylen, message, msglen, buf, &buf_len);
+    if (_sc_key_cache_hmac(auth_type, hashfn, key, keylen, message, msglen,
+                           buf, &buf_len) != SNMPERR_SUCCESS) {
+        buf_len = sizeof(buf);
+        HMAC(hashfn, key, keylen, message, msglen, buf, &buf_len);
+    }
     if (buf_len != properlength) {
         QUITFUN(rval, sc_generate_keyed_hash_quit);
     }
@@ -1308,6 +1611,13 @@ sc_encrypt(const oid * privtype, size_t privtypelen,
         }
 
         memcpy(my_iv, iv, ivlen);
+        if (_sc_key_cache_crypt(SC_KEY_CACHE_ENCRYPT, pai->type, cipher,
+                                key, keylen, my_iv, plaintext, ptlen,
+                                ciphertext) == SNMPERR_SUCCESS) {
+            /* CFB: ciphertext is as long as the plaintext */
+            *ctlen = ptlen;
+            goto sc_encrypt_quit;
+        }
         /*
          * encrypt the data 
          */
@@ -1530,6 +1840,12 @@ sc_decrypt(const oid * privtype, size_t privtypelen,
             QUITFUN(SNMPERR_GENERR, sc_decrypt_quit);
 
         memcpy(my_iv, iv, ivlen);
+        if (_sc_key_cache_crypt(SC_KEY_CACHE_DECRYPT, pai->type, cipher,
+                                key, keylen, my_iv, ciphertext, ctlen,
+                                plaintext) == SNMPERR_SUCCESS) {
+            *ptlen = ctlen;
+            goto sc_decrypt_quit;
+        }
         /*
          * decrypt the data
          */
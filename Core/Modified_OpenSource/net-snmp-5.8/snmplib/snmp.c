@@ -327,6 +327,116 @@ snmp_build_var_op(u_char * data,
     return data;
 }
 
+/**
+ * Computes the number of bytes snmp_build_var_op() or
+ * snmp_realloc_rbuild_var_op() will emit for a single varbind,
+ * including the enclosing SEQUENCE header.  The result is exact for
+ * all standard SMI types; the opaque special types are given their
+ * maximum encoded size.
+ *
+ * @param var_name      the OID of the varbind
+ * @param var_name_len  number of sub-identifiers in var_name
+ * @param var_val_type  ASN type of the value
+ * @param var_val       pointer to the value
+ * @param var_val_len   length of the value in bytes
+ *
+ * @return encoded length in bytes, or 0 if the type is unknown
+ */
+size_t
+snmp_var_op_encoded_len(const oid * var_name, size_t var_name_len,
+                        u_char var_val_type, const u_char * var_val,
+                        size_t var_val_len)
+{
+    size_t          len;
+
+    switch (var_val_type) {
+    case ASN_INTEGER:
+        len = asn_int_encoded_len(*(const long *) var_val);
+        break;
+
+    case ASN_GAUGE:
+    case ASN_COUNTER:
+    case ASN_TIMETICKS:
+    case ASN_UINTEGER:
+        len = asn_unsigned_int_encoded_len(*(const u_long *) var_val);
+        break;
+
+#ifdef NETSNMP_WITH_OPAQUE_SPECIAL_TYPES
+    case ASN_OPAQUE_COUNTER64:
+    case ASN_OPAQUE_U64:
+#endif
+    case ASN_COUNTER64:
+        len = asn_unsigned_int64_encoded_len(var_val_type,
+                                             (const struct counter64 *)
+                                             var_val);
+        break;
+
+    case ASN_OCTET_STR:
+    case ASN_IPADDRESS:
+    case ASN_OPAQUE:
+    case ASN_NSAP:
+    case ASN_BIT_STR:
+        len = asn_header_encoded_len(var_val_len) + var_val_len;
+        break;
+
+    case ASN_OBJECT_ID:
+        len = asn_objid_encoded_len((const oid *) var_val,
+                                    var_val_len / sizeof(oid));
+        break;
+
+    case ASN_NULL:
+    case SNMP_NOSUCHOBJECT:
+    case SNMP_NOSUCHINSTANCE:
+    case SNMP_ENDOFMIBVIEW:
+        len = 2;
+        break;
+
+#ifdef NETSNMP_WITH_OPAQUE_SPECIAL_TYPES
+    case ASN_OPAQUE_FLOAT:
+        len = ASN_OPAQUE_FLOAT_BER_LEN + 2;
+        break;
+
+    case ASN_OPAQUE_DOUBLE:
+        len = ASN_OPAQUE_DOUBLE_BER_LEN + 2;
+        break;
+
+    case ASN_OPAQUE_I64:
+        len = ASN_OPAQUE_I64_MX_BER_LEN + 2;
+        break;
+#endif                          /* NETSNMP_WITH_OPAQUE_SPECIAL_TYPES */
+    default:
+        return 0;
+    }
+
+    len += asn_objid_encoded_len(var_name, var_name_len);
+    return asn_header_encoded_len(len) + len;
+}
+
+/**
+ * Computes the number of bytes the varbind list of a PDU occupies once
+ * encoded, including the enclosing SEQUENCE header.  Used to size the
+ * packet buffer before a PDU is built.
+ *
+ * @param vars  the varbind list
+ *
+ * @return encoded length in bytes, or 0 if a varbind has an unknown type
+ */
+size_t
+snmp_varbind_list_encoded_len(netsnmp_variable_list * vars)
+{
+    size_t          len = 0, vb_len;
+
+    for (; vars; vars = vars->next_variable) {
+        vb_len = snmp_var_op_encoded_len(vars->name, vars->name_length,
+                                         vars->type, vars->val.string,
+                                         vars->val_len);
+        if (vb_len == 0)
+            return 0;
+        len += vb_len;
+    }
+    return asn_header_encoded_len(len) + len;
+}
+
 #ifdef NETSNMP_USE_REVERSE_ASNENCODING
 int
 snmp_realloc_rbuild_var_op(u_char ** pkt, size_t * pkt_len,
@@ -219,8 +219,24 @@ struct snmp_internal_session {
     size_t        obuf_size;    /* size of buffer for packet data */
     u_char       *opacket;      /* send packet data (within obuf) */
     size_t        opacket_len;  /* length of data */
+
+    u_char       *obuf_pool;    /* send buffer kept for the next PDU */
+    size_t        obuf_pool_size; /* size of pooled send buffer */
 };
 
+/*
+ * Send buffers larger than this are released instead of being kept
+ * in the per-session pool.
+ */
+#define SNMP_OBUF_POOL_MAX  (128 * 1024)
+
+/*
+ * Room reserved for the message envelope (version, community or v3
+ * header and security parameters, PDU header) on top of the exact
+ * size of the varbind list when sizing a send buffer.
+ */
+#define SNMP_ENVELOPE_RESERVE 160
+
 /*
  * information about received packet
  */
@@ -787,6 +803,8 @@ register_default_handlers(void)
     netsnmp_ds_register_config(ASN_BOOLEAN, "snmp", "disableSNMPv3",
                       NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_DISABLE_V3);
 #endif /* NETSNMP_FEATURE_REMOVE_RUNTIME_DISABLE_VERSION */
+    netsnmp_ds_register_config(ASN_BOOLEAN, "snmp", "noKeyCache",
+                      NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_NO_KEY_CACHE);
 #if !defined(NETSNMP_DISABLE_SNMPV1) || !defined(NETSNMP_DISABLE_SNMPV2C)
 #ifndef NETSNMP_FEATURE_REMOVE_RUNTIME_DISABLE_VERSION
 #if !defined(NETSNMP_DISABLE_SNMPV1)
@@ -1963,6 +1981,8 @@ snmp_sess_close(void *sessp)
         netsnmp_request_list *rp, *orp;
 
         SNMP_FREE(isp->packet);
+        SNMP_FREE(isp->obuf);
+        SNMP_FREE(isp->obuf_pool);
 
         /*
          * Free each element in the input request list.  
@@ -4959,6 +4979,63 @@ netsnmp_build_packet(struct snmp_internal_session *isp, netsnmp_session *sp,
     return result;
 }
 
+/*
+ * take a send buffer of at least *len bytes from the session pool,
+ * falling back to malloc. On return *len holds the real buffer size.
+ */
+static u_char *
+_sess_obuf_get(struct snmp_internal_session *isp, size_t *len)
+{
+    u_char *buf = isp->obuf_pool;
+
+    if (buf != NULL) {
+        isp->obuf_pool = NULL;
+        if (isp->obuf_pool_size >= *len) {
+            *len = isp->obuf_pool_size;
+            return buf;
+        }
+        free(buf);
+    }
+    return (u_char *)malloc(*len);
+}
+
+/*
+ * return a send buffer to the session pool, or free it if the pool is
+ * occupied or the buffer is too big to keep around.
+ */
+static void
+_sess_obuf_put(struct snmp_internal_session *isp, u_char *buf, size_t len)
+{
+    if (buf == NULL)
+        return;
+    if (isp->obuf_pool == NULL && len <= SNMP_OBUF_POOL_MAX) {
+        isp->obuf_pool = buf;
+        isp->obuf_pool_size = len;
+    } else
+        free(buf);
+}
+
+/*
+ * size the send buffer for a PDU: the exact encoded size of the varbind
+ * list plus room for the envelope, so the encoder doesn't have to grow
+ * the buffer while building.
+ */
+static size_t
+_pdu_encoded_len_estimate(netsnmp_session *session, netsnmp_pdu *pdu,
+                          size_t vb_len)
+{
+    size_t len = vb_len + SNMP_ENVELOPE_RESERVE;
+
+    if (pdu->version == SNMP_VERSION_3)
+        len += pdu->securityEngineIDLen + pdu->securityNameLen +
+            pdu->contextEngineIDLen + pdu->contextNameLen;
+    else
+        len += pdu->community_len ? pdu->community_len :
+            session->community_len;
+
+    return (len < SNMP_MIN_MAX_LEN) ? SNMP_MIN_MAX_LEN : len;
+}
+
 int
 _build_initial_pdu_packet(struct session_list *slp, netsnmp_pdu *pdu, int bulk)
 {
@@ -4967,6 +5044,7 @@ _build_initial_pdu_packet(struct session_list *slp, netsnmp_pdu *pdu, int bulk)
     netsnmp_transport *transport = NULL;
     u_char         *pktbuf = NULL, *packet = NULL;
     size_t          pktbuf_len = 0, offset = 0, length = 0, orig_length = 0;
+    size_t          pktbuf_size, vb_len;
     int             result, orig_count = 0, curr_count = 0;
 
     if (slp == NULL) {
@@ -5063,16 +5141,39 @@ _build_initial_pdu_packet(struct session_list *slp, netsnmp_pdu *pdu, int bulk)
     netsnmp_assert(pdu->msgMaxSize > 0);
 
     /*
-     * allocate initial packet buffer. Buffer will be grown as needed
-     * while building the packet.
+     * take the initial packet buffer from the session pool. A fresh
+     * buffer is sized from the exact encoded length of the varbind list;
+     * bulk responses always need that length to decide how to encode.
+     * Buffer will still be grown as needed while building the packet.
      */
+    vb_len = 0;
     pktbuf_len = SNMP_MIN_MAX_LEN;
-    if ((pktbuf = (u_char *)malloc(pktbuf_len)) == NULL) {
+    if (bulk || NULL == isp->obuf_pool) {
+        vb_len = snmp_varbind_list_encoded_len(pdu->variables);
+        pktbuf_len = _pdu_encoded_len_estimate(session, pdu, vb_len);
+    }
+    if ((pktbuf = _sess_obuf_get(isp, &pktbuf_len)) == NULL) {
         DEBUGMSGTL(("sess_async_send",
                     "couldn't malloc initial packet buffer\n"));
         session->s_snmp_errno = SNMPERR_MALLOC;
         return SNMPERR_MALLOC;
     }
+    pktbuf_size = pktbuf_len;
+    DEBUGMSGTL(("sess_async_send",
+                "varbind list length %" NETSNMP_PRIz "u, packet buffer %"
+                NETSNMP_PRIz "u\n", vb_len, pktbuf_len));
+
+    /*
+     * a bulk response whose varbinds alone exceed the maximum message
+     * size will need truncating anyway, so skip the full-size build and
+     * go straight to the forward encoder with a fixed size buffer.
+     */
+    if (bulk && vb_len > pdu->msgMaxSize && pktbuf_size >= pdu->msgMaxSize) {
+        pdu->flags |= UCD_MSG_FLAG_FORWARD_ENCODE | UCD_MSG_FLAG_BULK_TOOBIG;
+        pktbuf_len = pdu->msgMaxSize;
+        orig_count = curr_count = count_varbinds(pdu->variables);
+        orig_length = vb_len;
+    }
 
 #if TEMPORARILY_DISABLED
     /*
@@ -5113,6 +5214,8 @@ _build_initial_pdu_packet(struct session_list *slp, netsnmp_pdu *pdu, int bulk)
         length = offset = 0;
         result = netsnmp_build_packet(isp, session, pdu, &pktbuf, &pktbuf_len,
                                       &packet, &length);
+        if (pktbuf_len > pktbuf_size)
+            pktbuf_size = pktbuf_len;
         if (0 != result)
             break;
 
@@ -5163,12 +5266,12 @@ _build_initial_pdu_packet(struct session_list *slp, netsnmp_pdu *pdu, int bulk)
 
     if ((SNMPERR_TOO_LONG == session->s_snmp_errno) || (result < 0)) {
         DEBUGMSGTL(("sess_async_send", "encoding failure\n"));
-        SNMP_FREE(pktbuf);
+        _sess_obuf_put(isp, pktbuf, pktbuf_size);
         return SNMPERR_GENERR;
     }
 
     isp->obuf = pktbuf;
-    isp->obuf_size = pktbuf_len;
+    isp->obuf_size = pktbuf_size;
     isp->opacket = packet;
     isp->opacket_len = length;
 
@@ -5290,7 +5393,8 @@ _sess_async_send(void *sessp,
                                     &(pdu->transport_data),
                                     &(pdu->transport_data_length));
 
-    SNMP_FREE(isp->obuf);
+    _sess_obuf_put(isp, isp->obuf, isp->obuf_size);
+    isp->obuf = NULL;
     isp->opacket = NULL; /* opacket was in obuf, so no free needed */
     isp->opacket_len = 0;
 
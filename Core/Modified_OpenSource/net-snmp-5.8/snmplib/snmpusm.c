@@ -3368,6 +3368,10 @@ init_usm(void)
                            SNMP_CALLBACK_SHUTDOWN,
                            free_engineID, NULL);
 
+    snmp_register_callback(SNMP_CALLBACK_LIBRARY,
+                           SNMP_CALLBACK_SHUTDOWN,
+                           sc_shutdown, NULL);
+
     register_config_handler("snmp", "defAuthType", snmpv3_authtype_conf,
                             NULL, "MD5|SHA|SHA-512|SHA-384|SHA-256|SHA-224");
     register_config_handler("snmp", "defPrivType", snmpv3_privtype_conf,
@@ -3964,11 +3968,13 @@ usm_free_user(struct usmUser *user)
     SNMP_FREE(user->privProtocol);
 
     if (user->authKey != NULL) {
+        sc_key_cache_forget(user->authKey, user->authKeyLen);
         SNMP_ZERO(user->authKey, user->authKeyLen);
         SNMP_FREE(user->authKey);
     }
 
     if (user->privKey != NULL) {
+        sc_key_cache_forget(user->privKey, user->privKeyLen);
         SNMP_ZERO(user->privKey, user->privKeyLen);
         SNMP_FREE(user->privKey);
     }
@@ -0,0 +1,177 @@
+/* HEADER snmp_build throughput for large responses */
+
+/*
+ * Measures PDUs/s for building GETBULK-style responses of 10, 100 and
+ * 1000 varbinds:
+ *
+ *   realloc  - fresh SNMP_MIN_MAX_LEN buffer per PDU, grown by the
+ *              reverse encoder (the old send path)
+ *   presized - fresh buffer sized from snmp_varbind_list_encoded_len()
+ *   pooled   - one buffer reused between PDUs (the session pool)
+ *
+ * and, for responses that exceed the maximum message size, the old
+ * two-pass build (full reverse encode, then truncating forward encode)
+ * against the single forward pass chosen from the precomputed length.
+ */
+
+static const int vbcounts[] = { 10, 100, 1000 };
+oid ifcol[] = { 1, 3, 6, 1, 2, 1, 2, 2, 1, 0, 0 };
+netsnmp_session session, *ss;
+netsnmp_pdu *pdu, *clone;
+struct timeval start, end;
+u_char *pool = NULL, *pkt;
+size_t pool_size = 0, pkt_len, offset, vb_len;
+size_t len_realloc = 0, len_presized = 0, len_pooled = 0;
+size_t len_twopass = 0, len_onepass = 0;
+double secs_realloc, secs_presized, secs_pooled, secs_twopass, secs_onepass;
+long counter;
+char descr[] = "GigabitEthernet0/0/1";
+int i, n, iter, iterations;
+
+#define BENCH_START() netsnmp_get_monotonic_clock(&start)
+#define BENCH_STOP(secs) do {                                   \
+        netsnmp_get_monotonic_clock(&end);                      \
+        secs = (end.tv_sec - start.tv_sec) +                    \
+            (end.tv_usec - start.tv_usec) / 1e6;                \
+    } while (0)
+
+SOCK_STARTUP;
+
+init_snmp("testing");
+snmp_sess_init(&session);
+session.version = SNMP_VERSION_2c;
+session.peername = strdup("udp:127.0.0.1"); /* we won't actually connect */
+session.community = (u_char *) strdup("public");
+session.community_len = strlen((char *) session.community);
+ss = snmp_open(&session);
+
+OKF((ss != NULL), ("Creating a session failed"));
+
+for (n = 0; ss && n < sizeof(vbcounts)/sizeof(vbcounts[0]); n++) {
+    pdu = snmp_pdu_create(SNMP_MSG_RESPONSE);
+    pdu->version = session.version;
+    pdu->reqid = 1;
+    for (i = 0; i < vbcounts[n]; i++) {
+        ifcol[9] = 2 + (i % 20);
+        ifcol[10] = 1 + i / 20;
+        counter = 1000000L * i;
+        if (ifcol[9] == 2)
+            snmp_pdu_add_variable(pdu, ifcol, OID_LENGTH(ifcol),
+                                  ASN_OCTET_STR, descr, strlen(descr));
+        else if (ifcol[9] < 10)
+            snmp_pdu_add_variable(pdu, ifcol, OID_LENGTH(ifcol),
+                                  ASN_INTEGER, &counter, sizeof(counter));
+        else
+            snmp_pdu_add_variable(pdu, ifcol, OID_LENGTH(ifcol),
+                                  ASN_COUNTER, &counter, sizeof(counter));
+    }
+
+    iterations = 100000 / vbcounts[n];
+
+    BENCH_START();
+    for (iter = 0; iter < iterations; iter++) {
+        pkt_len = SNMP_MIN_MAX_LEN;
+        pkt = (u_char *) malloc(pkt_len);
+        offset = 0;
+        if (snmp_build(&pkt, &pkt_len, &offset, ss, pdu) != SNMPERR_SUCCESS)
+            break;
+        len_realloc = offset;
+        free(pkt);
+    }
+    BENCH_STOP(secs_realloc);
+
+    BENCH_START();
+    for (iter = 0; iter < iterations; iter++) {
+        pkt_len = snmp_varbind_list_encoded_len(pdu->variables) +
+            SNMP_MIN_MAX_LEN;
+        pkt = (u_char *) malloc(pkt_len);
+        offset = 0;
+        if (snmp_build(&pkt, &pkt_len, &offset, ss, pdu) != SNMPERR_SUCCESS)
+            break;
+        len_presized = offset;
+        free(pkt);
+    }
+    BENCH_STOP(secs_presized);
+
+    BENCH_START();
+    for (iter = 0; iter < iterations; iter++) {
+        if (pool == NULL) {
+            pool_size = SNMP_MIN_MAX_LEN;
+            pool = (u_char *) malloc(pool_size);
+        }
+        offset = 0;
+        if (snmp_build(&pool, &pool_size, &offset, ss, pdu) !=
+            SNMPERR_SUCCESS)
+            break;
+        len_pooled = offset;
+    }
+    BENCH_STOP(secs_pooled);
+    SNMP_FREE(pool);
+
+    OKF(len_realloc != 0 && len_realloc == len_presized &&
+        len_realloc == len_pooled,
+        ("%d varbinds: %" NETSNMP_PRIz "u/%" NETSNMP_PRIz "u/%" NETSNMP_PRIz
+         "u bytes", vbcounts[n], len_realloc, len_presized, len_pooled));
+    printf("# %4d varbinds: realloc %8.0f, presized %8.0f, pooled %8.0f"
+           " PDUs/s\n", vbcounts[n], iterations / secs_realloc,
+           iterations / secs_presized, iterations / secs_pooled);
+
+    /*
+     * responses too big for a 1472 byte message: the old path encodes
+     * everything, finds it too long and re-encodes forward with
+     * truncation; the precomputed length lets the build go forward
+     * straight away.
+     */
+    pdu->msgMaxSize = 1472;
+    if (snmp_varbind_list_encoded_len(pdu->variables) > pdu->msgMaxSize) {
+        BENCH_START();
+        for (iter = 0; iter < iterations; iter++) {
+            clone = snmp_clone_pdu(pdu);
+            pkt_len = SNMP_MIN_MAX_LEN;
+            pkt = (u_char *) malloc(pkt_len);
+            offset = 0;
+            snmp_build(&pkt, &pkt_len, &offset, ss, clone);
+            clone->flags |= UCD_MSG_FLAG_FORWARD_ENCODE |
+                UCD_MSG_FLAG_BULK_TOOBIG;
+            pkt_len = clone->msgMaxSize;
+            offset = 0;
+            snmp_build(&pkt, &pkt_len, &offset, ss, clone);
+            len_twopass = pkt_len;
+            free(pkt);
+            snmp_free_pdu(clone);
+        }
+        BENCH_STOP(secs_twopass);
+
+        BENCH_START();
+        for (iter = 0; iter < iterations; iter++) {
+            clone = snmp_clone_pdu(pdu);
+            vb_len = snmp_varbind_list_encoded_len(clone->variables);
+            if (vb_len > clone->msgMaxSize)
+                clone->flags |= UCD_MSG_FLAG_FORWARD_ENCODE |
+                    UCD_MSG_FLAG_BULK_TOOBIG;
+            pkt_len = clone->msgMaxSize;
+            pkt = (u_char *) malloc(pkt_len);
+            offset = 0;
+            snmp_build(&pkt, &pkt_len, &offset, ss, clone);
+            len_onepass = pkt_len;
+            free(pkt);
+            snmp_free_pdu(clone);
+        }
+        BENCH_STOP(secs_onepass);
+
+        OKF(len_twopass != 0 && len_twopass == len_onepass &&
+            len_onepass <= 1472,
+            ("%d varbinds truncated: %" NETSNMP_PRIz "u/%" NETSNMP_PRIz
+             "u bytes", vbcounts[n], len_twopass, len_onepass));
+        printf("# %4d varbinds truncated to 1472 bytes: two-pass %8.0f,"
+               " one-pass %8.0f PDUs/s\n", vbcounts[n],
+               iterations / secs_twopass, iterations / secs_onepass);
+    }
+
+    snmp_free_pdu(pdu);
+}
+
+if (ss)
+    snmp_close(ss);
+
+SOCK_CLEANUP;
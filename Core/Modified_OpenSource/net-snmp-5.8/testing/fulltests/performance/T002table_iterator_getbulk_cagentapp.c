@@ -0,0 +1,273 @@
+/*
+ * HEADER table_iterator GETBULK walk of a 10000 row table
+ */
+
+/*
+ * Times a full GETBULK walk of a 10000 row iterator table (two columns
+ * plus one non-repeater, unsorted rows) through the agent's callback
+ * transport, for several max-repetitions values:
+ *
+ *   bulk_to_next - one GETNEXT pass, and one walk of all rows, per
+ *                  repetition
+ *   prefetch     - NETSNMP_ITERATOR_FLAG_BULK_PREFETCH: one walk of all
+ *                  rows per GETBULK PDU
+ *
+ * and reports the number of get_*_data_point calls made by each.
+ */
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/agent/net-snmp-agent-includes.h>
+#include <net-snmp/library/testing.h>
+
+#include <stdio.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#if HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+
+extern int      callback_master_num;
+
+#define NROWS 10000
+
+static long     rows[NROWS + 1];
+static long     data_points;
+
+static oid      plain_oid[] = { 1, 3, 6, 1, 3, 329, 1 };
+static oid      prefetch_oid[] = { 1, 3, 6, 1, 3, 329, 2 };
+
+/* rows are a zero terminated array of index values; the row is the data */
+static netsnmp_variable_list *
+get_next_row(void **loop_context, void **data_context,
+             netsnmp_variable_list *put_index_data,
+             netsnmp_iterator_info *iinfo)
+{
+    long           *row = (long *) *loop_context;
+
+    data_points++;
+    if (!*row)
+        return NULL;
+    snmp_set_var_typed_integer(put_index_data, ASN_INTEGER, *row);
+    *data_context = row;
+    *loop_context = row + 1;
+    return put_index_data;
+}
+
+static netsnmp_variable_list *
+get_first_row(void **loop_context, void **data_context,
+              netsnmp_variable_list *put_index_data,
+              netsnmp_iterator_info *iinfo)
+{
+    *loop_context = iinfo->myvoid;
+    return get_next_row(loop_context, data_context, put_index_data, iinfo);
+}
+
+static int
+handle_rows(netsnmp_mib_handler *handler,
+            netsnmp_handler_registration *reginfo,
+            netsnmp_agent_request_info *reqinfo,
+            netsnmp_request_info *requests)
+{
+    netsnmp_request_info *request;
+    netsnmp_table_request_info *table_info;
+    long           *row;
+
+    for (request = requests; request; request = request->next) {
+        if (request->processed)
+            continue;
+        row = (long *) netsnmp_extract_iterator_context(request);
+        table_info = netsnmp_extract_table_info(request);
+        if (!row || !table_info) {
+            netsnmp_set_request_error(reqinfo, request, SNMP_NOSUCHINSTANCE);
+            continue;
+        }
+        if (table_info->colnum == 2)
+            snmp_set_var_typed_integer(request->requestvb, ASN_INTEGER,
+                                       *row * 3);
+        else
+            snmp_set_var_typed_integer(request->requestvb, ASN_COUNTER,
+                                       *row * *row);
+    }
+    return SNMP_ERR_NOERROR;
+}
+
+static int
+register_rows(oid *root, size_t root_len, long *rows, int flags)
+{
+    netsnmp_handler_registration *reg;
+    netsnmp_table_registration_info *table_info;
+    netsnmp_iterator_info *iinfo;
+
+    reg = netsnmp_create_handler_registration("getbulk-bench", handle_rows,
+                                              root, root_len,
+                                              HANDLER_CAN_RONLY);
+    table_info = SNMP_MALLOC_TYPEDEF(netsnmp_table_registration_info);
+    iinfo = SNMP_MALLOC_TYPEDEF(netsnmp_iterator_info);
+    if (!reg || !table_info || !iinfo)
+        return SNMP_ERR_GENERR;
+    netsnmp_table_helper_add_indexes(table_info, ASN_INTEGER, 0);
+    table_info->min_column = 2;
+    table_info->max_column = 3;
+    iinfo->get_first_data_point = get_first_row;
+    iinfo->get_next_data_point = get_next_row;
+    iinfo->myvoid = rows;
+    iinfo->flags = flags | NETSNMP_HANDLER_OWNS_IINFO;
+    iinfo->table_reginfo = table_info;
+    return netsnmp_register_table_iterator(reg, iinfo);
+}
+
+/*
+ * GETBULK walk of both columns (plus one non-repeater) below root,
+ * collecting every varbind still inside the table, until one of the
+ * repeaters runs off its end.
+ */
+static netsnmp_variable_list *
+bulk_walk(netsnmp_session *ss, oid *root, size_t root_len, long reps)
+{
+    netsnmp_variable_list *collected = NULL, *tail = NULL, *added;
+    netsnmp_variable_list *vp, *last[2];
+    netsnmp_pdu    *pdu, *response;
+    oid             name[2][MAX_OID_LEN], col[MAX_OID_LEN];
+    size_t          name_len[2];
+    int             i, more = 1;
+
+    memcpy(col, root, root_len * sizeof(oid));
+    col[root_len] = 1;
+    for (i = 0; i < 2; i++) {
+        memcpy(name[i], col, (root_len + 1) * sizeof(oid));
+        name[i][root_len + 1] = 2 + i;
+        name_len[i] = root_len + 2;
+    }
+
+    while (more) {
+        pdu = snmp_pdu_create(SNMP_MSG_GETBULK);
+        pdu->non_repeaters = 1;
+        pdu->max_repetitions = reps;
+        pdu->flags |= UCD_MSG_FLAG_ALWAYS_IN_VIEW;  /* no VACM configured */
+        snmp_add_null_var(pdu, name[1], name_len[1]);
+        snmp_add_null_var(pdu, name[0], name_len[0]);
+        snmp_add_null_var(pdu, name[1], name_len[1]);
+        if (snmp_synch_response(ss, pdu, &response) != STAT_SUCCESS ||
+            response->errstat != SNMP_ERR_NOERROR) {
+            if (response)
+                snmp_free_pdu(response);
+            break;
+        }
+
+        last[0] = last[1] = NULL;
+        for (vp = response->variables, i = 0; vp;
+             vp = vp->next_variable, i++) {
+            if (i > 0)
+                last[(i - 1) % 2] = vp;
+            if (vp->type == SNMP_ENDOFMIBVIEW ||
+                snmp_oidtree_compare(root, root_len,
+                                     vp->name, vp->name_length) != 0)
+                continue;
+            added = snmp_varlist_add_variable(tail ? &tail : &collected,
+                                              vp->name, vp->name_length,
+                                              vp->type, vp->val.string,
+                                              vp->val_len);
+            if (added)
+                tail = added;
+        }
+
+        /* stop as soon as either repeater has left the table */
+        for (i = 0; i < 2; i++) {
+            if (!last[i] || last[i]->type == SNMP_ENDOFMIBVIEW ||
+                snmp_oidtree_compare(root, root_len, last[i]->name,
+                                     last[i]->name_length) != 0) {
+                more = 0;
+                break;
+            }
+            memcpy(name[i], last[i]->name,
+                   last[i]->name_length * sizeof(oid));
+            name_len[i] = last[i]->name_length;
+        }
+        snmp_free_pdu(response);
+    }
+    return collected;
+}
+
+static double
+timed_walk(netsnmp_session *ss, oid *root, size_t root_len, long reps,
+           long *points, int *varbinds)
+{
+    struct timeval  start, end;
+    netsnmp_variable_list *vp, *collected;
+
+    data_points = 0;
+    netsnmp_get_monotonic_clock(&start);
+    collected = bulk_walk(ss, root, root_len, reps);
+    netsnmp_get_monotonic_clock(&end);
+    *points = data_points;
+    for (*varbinds = 0, vp = collected; vp; vp = vp->next_variable)
+        (*varbinds)++;
+    snmp_free_varbind(collected);
+    return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+}
+
+int
+main(int argc, char *argv[])
+{
+    static const long reps[] = { 10, 50 };
+    netsnmp_session *ss;
+    double          secs_plain, secs_prefetch;
+    long            points_plain, points_prefetch;
+    int             i, vbs_plain, vbs_prefetch;
+
+    for (i = 0; i < NROWS; i++)
+        rows[i] = 2 * ((i * 7919L) % NROWS) + 1;
+
+    SOCK_STARTUP;
+
+    init_agent("getbulk-bench");
+    init_snmp("getbulk-bench");
+
+    OK(register_rows(plain_oid, OID_LENGTH(plain_oid), rows, 0) ==
+       MIB_REGISTERED_OK, "plain iterator table registration");
+    OK(register_rows(prefetch_oid, OID_LENGTH(prefetch_oid), rows,
+                     NETSNMP_ITERATOR_FLAG_BULK_PREFETCH) ==
+       MIB_REGISTERED_OK, "prefetching iterator table registration");
+
+    ss = netsnmp_callback_open(callback_master_num, NULL, NULL, NULL);
+    OK(ss != NULL, "callback session to the agent");
+    if (ss) {
+        ss->version = SNMP_VERSION_2c;
+        ss->community = (u_char *) strdup("public");
+        ss->community_len = strlen("public");
+        ss->myvoid = netsnmp_check_outstanding_agent_requests;
+        ss->flags |= SNMP_FLAGS_RESP_CALLBACK | SNMP_FLAGS_DONT_PROBE;
+    }
+
+    for (i = 0; ss && i < sizeof(reps) / sizeof(reps[0]); i++) {
+        secs_plain = timed_walk(ss, plain_oid, OID_LENGTH(plain_oid),
+                                reps[i], &points_plain, &vbs_plain);
+        secs_prefetch = timed_walk(ss, prefetch_oid, OID_LENGTH(prefetch_oid),
+                                   reps[i], &points_prefetch, &vbs_prefetch);
+
+        OKF(vbs_plain >= 2 * NROWS && vbs_plain == vbs_prefetch,
+            ("max-repetitions %ld: %d/%d varbinds", reps[i], vbs_plain,
+             vbs_prefetch));
+        printf("# %d rows, max-repetitions %3ld: bulk_to_next %7.3fs"
+               " (%ld data points), prefetch %7.3fs (%ld data points)\n",
+               NROWS, reps[i], secs_plain, points_plain, secs_prefetch,
+               points_prefetch);
+    }
+
+    if (ss)
+        snmp_close(ss);
+
+    snmp_shutdown("getbulk-bench");
+    shutdown_agent();
+
+    SOCK_CLEANUP;
+
+    if (__did_plan == 0) {
+        PLAN(__test_counter);
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+/* HEADER Container insert/find/next/remove throughput */
+
+/*
+ * Measures operations/s for the sorted container types on tables of
+ * 1k, 10k and 100k two sub-identifier rows, inserted, looked up and
+ * removed in random order (row churn), and walked with find_next:
+ *
+ *   binary_array - sorted array, memmove on insert/remove
+ *   ssll         - sorted singly linked list (only up to 10k rows;
+ *                  every operation is a linear walk)
+ *   skiplist     - skip list
+ */
+
+static const char *types[] = { "binary_array", "sorted_singly_linked_list",
+                               "skiplist" };
+static const char *labels[] = { "binary_array", "ssll", "skiplist" };
+static const int rowcounts[] = { 1000, 10000, 100000 };
+netsnmp_container *c;
+netsnmp_index *keys, **order, *tmp, *ip;
+oid *oids;
+struct timeval start, end;
+double secs_insert, secs_find, secs_next, secs_remove;
+unsigned long seed = 1;
+int i, j, t, n, nrows, found, walked;
+
+#define BENCH_START() netsnmp_get_monotonic_clock(&start)
+#define BENCH_STOP(secs) do {                                   \
+        netsnmp_get_monotonic_clock(&end);                      \
+        secs = (end.tv_sec - start.tv_sec) +                    \
+            (end.tv_usec - start.tv_usec) / 1e6;                \
+    } while (0)
+
+init_snmp("testing");
+
+nrows = rowcounts[sizeof(rowcounts)/sizeof(rowcounts[0]) - 1];
+keys = (netsnmp_index *) malloc(nrows * sizeof(netsnmp_index));
+order = (netsnmp_index **) malloc(nrows * sizeof(netsnmp_index *));
+oids = (oid *) malloc(nrows * 2 * sizeof(oid));
+OK(keys && order && oids, "allocating rows");
+
+for (n = 0; keys && order && oids &&
+         n < sizeof(rowcounts)/sizeof(rowcounts[0]); n++) {
+    nrows = rowcounts[n];
+    for (i = 0; i < nrows; i++) {
+        oids[2 * i] = 1 + i / 256;
+        oids[2 * i + 1] = i % 256;
+        keys[i].oids = &oids[2 * i];
+        keys[i].len = 2;
+        order[i] = &keys[i];
+    }
+    /* shuffle: rows arrive and leave in no particular order */
+    for (i = nrows - 1; i > 0; i--) {
+        seed = seed * 1103515245 + 12345;
+        j = (seed >> 8) % (i + 1);
+        tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    for (t = 0; t < sizeof(types)/sizeof(types[0]); t++) {
+        if (nrows > 10000 && strcmp(labels[t], "ssll") == 0)
+            continue;
+        c = netsnmp_container_find(types[t]);
+        if (!c)
+            continue;
+        c->compare = netsnmp_compare_netsnmp_index;
+
+        BENCH_START();
+        for (i = 0; i < nrows; i++)
+            CONTAINER_INSERT(c, order[i]);
+        BENCH_STOP(secs_insert);
+
+        BENCH_START();
+        for (i = 0, found = 0; i < nrows; i++)
+            if (CONTAINER_FIND(c, order[i]))
+                found++;
+        BENCH_STOP(secs_find);
+
+        BENCH_START();
+        for (i = 0, walked = 0; i < nrows; i++)
+            if (CONTAINER_NEXT(c, order[i]))
+                walked++;
+        BENCH_STOP(secs_next);
+
+        OKF(CONTAINER_SIZE(c) == nrows && found == nrows &&
+            walked == nrows - 1,
+            ("%s, %d rows: %" NETSNMP_PRIz "u stored, %d found, %d next",
+             labels[t], nrows, CONTAINER_SIZE(c), found, walked));
+
+        BENCH_START();
+        for (i = 0; i < nrows; i++)
+            CONTAINER_REMOVE(c, order[i]);
+        BENCH_STOP(secs_remove);
+
+        ip = CONTAINER_FIRST(c);
+        OKF(CONTAINER_SIZE(c) == 0 && ip == NULL,
+            ("%s, %d rows: empty after removing every row", labels[t],
+             nrows));
+        printf("# %6d rows %-12s insert %10.0f, find %10.0f, next %10.0f,"
+               " remove %10.0f ops/s\n", nrows, labels[t],
+               nrows / secs_insert, nrows / secs_find, nrows / secs_next,
+               nrows / secs_remove);
+
+        CONTAINER_FREE(c);
+    }
+}
+
+SNMP_FREE(keys);
+SNMP_FREE(order);
+SNMP_FREE(oids);
+
+snmp_shutdown("testing");
@@ -0,0 +1,160 @@
+/*
+ * HEADER SNMPv3 authPriv (SHA/AES) GET throughput against a local agent
+ */
+
+/*
+ * Runs an agent listening on a loopback UDP port in this process and
+ * times SNMPv3 authPriv GET requests of 1 and 40 varbinds sent to it by
+ * a client session for the same user, with the scapi keyed HMAC/cipher
+ * cache enabled and with noKeyCache set.  Every request costs four HMAC
+ * and two AES operations (client and agent, each way).
+ */
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/agent/net-snmp-agent-includes.h>
+#include <net-snmp/library/testing.h>
+
+#include <stdio.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+
+#define REQUESTS 2000
+
+static oid      counter_oid[] = { 1, 3, 6, 1, 3, 330, 1, 0 };
+static u_long   counter = 4242;
+
+/* REQUESTS GETs of nvbs varbinds; returns the time taken, 0 on failure */
+static double
+timed_gets(netsnmp_session *ss, int nvbs)
+{
+    struct timeval  start, end;
+    netsnmp_pdu    *pdu, *response;
+    int             i, j, status;
+
+    netsnmp_get_monotonic_clock(&start);
+    for (i = 0; i < REQUESTS; i++) {
+        pdu = snmp_pdu_create(SNMP_MSG_GET);
+        for (j = 0; j < nvbs; j++)
+            snmp_add_null_var(pdu, counter_oid, OID_LENGTH(counter_oid));
+        response = NULL;
+        status = snmp_synch_response(ss, pdu, &response);
+        if (status != STAT_SUCCESS || !response ||
+            response->errstat != SNMP_ERR_NOERROR ||
+            !response->variables || response->variables->type != ASN_UNSIGNED
+            || *response->variables->val.integer != counter) {
+            if (response)
+                snmp_free_pdu(response);
+            return 0;
+        }
+        snmp_free_pdu(response);
+    }
+    netsnmp_get_monotonic_clock(&end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+}
+
+int
+main(int argc, char *argv[])
+{
+    static const int nvbs[] = { 1, 40 };
+    static const char *passphrase = "bench-passphrase";
+    netsnmp_session session, *ss = NULL;
+    u_char          engineID[SNMP_MAXBUF_SMALL];
+    char            ports[64], user[128];
+    double          secs_cached, secs_uncached;
+    size_t          engineID_len;
+    int             i;
+
+    SOCK_STARTUP;
+
+    snprintf(ports, sizeof(ports), "udp:127.0.0.1:%d",
+             20000 + (int) (getpid() % 20000));
+    netsnmp_ds_set_string(NETSNMP_DS_APPLICATION_ID, NETSNMP_DS_AGENT_PORTS,
+                          ports);
+    netsnmp_ds_set_boolean(NETSNMP_DS_LIBRARY_ID,
+                           NETSNMP_DS_LIB_DONT_PERSIST_STATE, 1);
+    init_agent("authpriv-bench");
+    init_snmp("authpriv-bench");
+    OK(init_master_agent() == 0, "agent listening on loopback");
+    OK(netsnmp_register_read_only_ulong_instance("authpriv-bench",
+                                                 counter_oid,
+                                                 OID_LENGTH(counter_oid),
+                                                 &counter, NULL) ==
+       MIB_REGISTERED_OK, "counter registration");
+
+    /* the agent's user; the client shares the engine, so skip discovery */
+    snprintf(user, sizeof(user), "bench SHA %s AES %s", passphrase,
+             passphrase);
+    usm_parse_create_usmUser("createUser", user);
+    netsnmp_config("rouser bench priv");
+    engineID_len = snmpv3_get_engineID(engineID, sizeof(engineID));
+
+    snmp_sess_init(&session);
+    session.version = SNMP_VERSION_3;
+    session.peername = ports;
+    session.securityName = strdup("bench");
+    session.securityNameLen = strlen(session.securityName);
+    session.securityLevel = SNMP_SEC_LEVEL_AUTHPRIV;
+    session.securityEngineID = netsnmp_memdup(engineID, engineID_len);
+    session.securityEngineIDLen = engineID_len;
+    session.contextEngineID = netsnmp_memdup(engineID, engineID_len);
+    session.contextEngineIDLen = engineID_len;
+    session.securityAuthProto = snmp_duplicate_objid(usmHMACSHA1AuthProtocol,
+                                       OID_LENGTH(usmHMACSHA1AuthProtocol));
+    session.securityAuthProtoLen = OID_LENGTH(usmHMACSHA1AuthProtocol);
+    session.securityAuthKeyLen = USM_AUTH_KU_LEN;
+    session.securityPrivProto = snmp_duplicate_objid(usmAESPrivProtocol,
+                                       OID_LENGTH(usmAESPrivProtocol));
+    session.securityPrivProtoLen = OID_LENGTH(usmAESPrivProtocol);
+    session.securityPrivKeyLen = USM_PRIV_KU_LEN;
+    session.flags |= SNMP_FLAGS_DONT_PROBE;
+    if (generate_Ku(session.securityAuthProto, session.securityAuthProtoLen,
+                    (const u_char *) passphrase, strlen(passphrase),
+                    session.securityAuthKey, &session.securityAuthKeyLen) ==
+        SNMPERR_SUCCESS &&
+        generate_Ku(session.securityAuthProto, session.securityAuthProtoLen,
+                    (const u_char *) passphrase, strlen(passphrase),
+                    session.securityPrivKey, &session.securityPrivKeyLen) ==
+        SNMPERR_SUCCESS)
+        ss = snmp_open(&session);
+    OK(ss != NULL, "SNMPv3 authPriv session to the agent");
+
+    for (i = 0; ss && i < sizeof(nvbs) / sizeof(nvbs[0]); i++) {
+        netsnmp_ds_set_boolean(NETSNMP_DS_LIBRARY_ID,
+                               NETSNMP_DS_LIB_NO_KEY_CACHE, 1);
+        secs_uncached = timed_gets(ss, nvbs[i]);
+        netsnmp_ds_set_boolean(NETSNMP_DS_LIBRARY_ID,
+                               NETSNMP_DS_LIB_NO_KEY_CACHE, 0);
+        sc_key_cache_flush();
+        secs_cached = timed_gets(ss, nvbs[i]);
+
+        OKF(secs_uncached > 0 && secs_cached > 0,
+            ("%d varbind GETs answered", nvbs[i]));
+        if (secs_uncached > 0 && secs_cached > 0)
+            printf("# %2d varbinds: uncached %8.0f, cached %8.0f"
+                   " requests/s\n", nvbs[i], REQUESTS / secs_uncached,
+                   REQUESTS / secs_cached);
+    }
+
+    if (ss)
+        snmp_close(ss);
+
+    snmp_shutdown("authpriv-bench");
+    shutdown_agent();
+
+    SOCK_CLEANUP;
+
+    if (__did_plan == 0) {
+        PLAN(__test_counter);
+    }
+    return 0;
+}
@@ -0,0 +1,161 @@
+/* HEADER Testing the skiplist container against the binary array */
+
+static const char test_name[] = "skiplist-container-test";
+#define NKEYS 600
+oid oids[NKEYS][2];
+netsnmp_index keys[NKEYS], prefix, *ip, *rp, *lp;
+netsnmp_container *sl, *ba, *dup;
+netsnmp_void_array *slsub, *basub;
+netsnmp_iterator *it;
+unsigned long seed = 1;
+int i, j, k, op, rc, round, bad, present;
+size_t n;
+
+init_snmp(test_name);
+
+sl = netsnmp_container_find("skiplist");
+OK(sl != NULL, "skiplist container is registered");
+ba = netsnmp_container_get_binary_array();
+sl->compare = ba->compare = netsnmp_compare_netsnmp_index;
+sl->ncompare = ba->ncompare = netsnmp_ncompare_netsnmp_index;
+
+/* keys {a, b}: 20 prefixes of 30 rows each */
+for (i = 0; i < NKEYS; ++i) {
+    oids[i][0] = i / 30;
+    oids[i][1] = i % 30;
+    keys[i].oids = oids[i];
+    keys[i].len = 2;
+}
+prefix.len = 1;
+
+/*
+ * random churn, mirrored into the binary array; after every round the
+ * two containers must agree on everything.
+ */
+for (round = 0; round < 10; ++round) {
+    bad = 0;
+    for (j = 0; j < 1000; ++j) {
+        seed = seed * 1103515245 + 12345;
+        k = (seed >> 8) % NKEYS;
+        op = (seed >> 24) & 3;
+        present = (CONTAINER_FIND(ba, &keys[k]) != NULL);
+        /* raw ops: expected failures shouldn't be logged */
+        if (op == 3 || (round < 3 && op)) {
+            if ((sl->insert(sl, &keys[k]) == 0) == present)
+                ++bad;
+            if (!present)
+                CONTAINER_INSERT(ba, &keys[k]);
+        } else {
+            if ((sl->remove(sl, &keys[k]) == 0) != present)
+                ++bad;
+            if (present)
+                CONTAINER_REMOVE(ba, &keys[k]);
+        }
+    }
+    OKF(bad == 0, ("round %d: insert/remove results match", round));
+    OKF(CONTAINER_SIZE(sl) == CONTAINER_SIZE(ba),
+        ("round %d: size %" NETSNMP_PRIz "u", round, CONTAINER_SIZE(sl)));
+
+    /* ordered walk with find_next */
+    bad = 0;
+    for (ip = CONTAINER_FIRST(sl), rp = CONTAINER_FIRST(ba); ip && rp;
+         ip = CONTAINER_NEXT(sl, ip), rp = CONTAINER_NEXT(ba, rp))
+        if (ip != rp)
+            ++bad;
+    OKF(bad == 0 && ip == rp, ("round %d: find_next walk matches", round));
+
+    /* find and find_next for every possible key, present or not */
+    bad = 0;
+    for (k = 0; k < NKEYS; ++k)
+        if (CONTAINER_FIND(sl, &keys[k]) != CONTAINER_FIND(ba, &keys[k]) ||
+            CONTAINER_NEXT(sl, &keys[k]) != CONTAINER_NEXT(ba, &keys[k]))
+            ++bad;
+    OKF(bad == 0, ("round %d: find/find_next match", round));
+
+    /* get_subset on every prefix */
+    bad = 0;
+    for (k = 0; k < NKEYS / 30; ++k) {
+        prefix.oids = oids[k * 30];
+        slsub = CONTAINER_GET_SUBSET(sl, &prefix);
+        basub = CONTAINER_GET_SUBSET(ba, &prefix);
+        if (!slsub || !basub) {
+            if (slsub != basub)
+                ++bad;
+        } else if (slsub->size != basub->size ||
+                   memcmp(slsub->array, basub->array,
+                          slsub->size * sizeof(void *)) != 0)
+            ++bad;
+        if (slsub) {
+            free(slsub->array);
+            free(slsub);
+        }
+        if (basub) {
+            free(basub->array);
+            free(basub);
+        }
+    }
+    OKF(bad == 0, ("round %d: get_subset matches", round));
+
+    /* iterator */
+    it = CONTAINER_ITERATOR(sl);
+    n = 0;
+    bad = 0;
+    lp = NULL;
+    for (ip = ITERATOR_FIRST(it), rp = CONTAINER_FIRST(ba); ip;
+         lp = ip, ip = ITERATOR_NEXT(it), rp = CONTAINER_NEXT(ba, rp), ++n)
+        if (ip != rp)
+            ++bad;
+    OKF(bad == 0 && n == CONTAINER_SIZE(ba),
+        ("round %d: iterator walk matches", round));
+    ip = ITERATOR_LAST(it);
+    OKF(ip == lp, ("round %d: iterator last", round));
+    ITERATOR_RELEASE(it);
+}
+
+/* a shallow duplicate has the same entries in the same order */
+dup = CONTAINER_DUP(sl, NULL, 0);
+OK(dup != NULL, "skiplist duplicate");
+if (dup) {
+    bad = 0;
+    for (ip = CONTAINER_FIRST(dup), rp = CONTAINER_FIRST(sl); ip && rp;
+         ip = CONTAINER_NEXT(dup, ip), rp = CONTAINER_NEXT(sl, rp))
+        if (ip != rp)
+            ++bad;
+    OK(bad == 0 && ip == rp && CONTAINER_SIZE(dup) == CONTAINER_SIZE(sl),
+       "duplicate walk matches");
+    CONTAINER_FREE(dup);
+}
+
+/* duplicate keys */
+CONTAINER_CLEAR(sl, NULL, NULL);
+OK(CONTAINER_SIZE(sl) == 0 && CONTAINER_FIRST(sl) == NULL,
+   "clear empties the skiplist");
+CONTAINER_SET_OPTIONS(sl, CONTAINER_KEY_UNSORTED, rc);
+OK(rc == -1, "skiplist can't be unsorted");
+OK(CONTAINER_INSERT(sl, &keys[5]) == 0 && sl->insert(sl, &keys[5]) != 0,
+   "duplicate key rejected by default");
+CONTAINER_SET_OPTIONS(sl, CONTAINER_KEY_ALLOW_DUPLICATES, rc);
+OK(rc != -1, "allow duplicates");
+CONTAINER_INSERT(sl, &keys[5]);
+CONTAINER_INSERT(sl, &keys[5]);
+CONTAINER_INSERT(sl, &keys[6]);
+CONTAINER_INSERT(sl, &keys[4]);
+OK(CONTAINER_SIZE(sl) == 5, "duplicates inserted");
+OK(CONTAINER_NEXT(sl, &keys[5]) == &keys[6],
+   "find_next skips over every duplicate");
+OK(CONTAINER_NEXT(sl, &keys[4]) == &keys[5], "find_next onto duplicates");
+prefix.oids = oids[0];
+slsub = CONTAINER_GET_SUBSET(sl, &prefix);
+OK(slsub && slsub->size == 5, "get_subset returns the duplicates");
+if (slsub) {
+    free(slsub->array);
+    free(slsub);
+}
+
+while ((ip = CONTAINER_FIRST(sl)))
+    CONTAINER_REMOVE(sl, ip);
+OK(CONTAINER_SIZE(sl) == 0, "skiplist emptied by removing first");
+CONTAINER_FREE(sl);
+CONTAINER_FREE(ba);
+
+snmp_shutdown(test_name);
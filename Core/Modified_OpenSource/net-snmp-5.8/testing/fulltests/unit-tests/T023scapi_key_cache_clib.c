@@ -0,0 +1,146 @@
+/* HEADER Testing the scapi keyed HMAC/cipher cache */
+
+static const char test_name[] = "scapi-key-cache-test";
+/* RFC 2202 test cases 1 and 6 */
+static const u_char hmac_sha1_1[] = {
+    0xb6, 0x17, 0x31, 0x86, 0x55, 0x05, 0x72, 0x64, 0xe2, 0x8b,
+    0xc0, 0xb6, 0xfb, 0x37, 0x8c, 0x8e, 0xf1, 0x46, 0xbe, 0x00 };
+static const u_char hmac_sha1_6[] = {
+    0xaa, 0x4a, 0xe5, 0xe1, 0x52, 0x72, 0xd0, 0x0e, 0x95, 0x70,
+    0x56, 0x37, 0xce, 0x8a, 0x3b, 0x55, 0xed, 0x40, 0x21, 0x12 };
+static const char msg_1[] = "Hi There";
+static const char msg_6[] =
+    "Test Using Larger Than Block-Size Key - Hash Key First";
+/* NIST SP 800-38A F.3.13, CFB128-AES128 encrypt, first block */
+static const u_char aes_key[] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+static const u_char aes_iv[] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+static const u_char aes_pt[] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+    0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a };
+static const u_char aes_ct[] = {
+    0x3b, 0x3f, 0xd9, 0x2e, 0xb7, 0x2d, 0xad, 0x20,
+    0x33, 0x34, 0x49, 0xf8, 0xe8, 0x3c, 0xfb, 0x4a };
+u_char key[80], iv[16], msg[300], mac[64], ref[64], buf[300], out[300];
+size_t maclen, reflen, len, outlen;
+int i, k, rc, bad, round;
+
+init_snmp(test_name);
+
+#if defined(NETSNMP_USE_OPENSSL) && defined(HAVE_AES)
+/* each vector twice: the first call fills the cache, the second hits it */
+memset(key, 0x0b, 20);
+for (i = 0; i < 2; ++i) {
+    maclen = sizeof(mac);
+    rc = sc_generate_keyed_hash(usmHMACSHA1AuthProtocol,
+                                OID_LENGTH(usmHMACSHA1AuthProtocol), key, 20,
+                                (const u_char *) msg_1, strlen(msg_1),
+                                mac, &maclen);
+    OKF(rc == SNMPERR_SUCCESS && maclen == sizeof(hmac_sha1_1) &&
+        memcmp(mac, hmac_sha1_1, maclen) == 0,
+        ("HMAC-SHA-1 RFC 2202 case 1, call %d", i + 1));
+}
+memset(key, 0xaa, 80);
+for (i = 0; i < 2; ++i) {
+    maclen = sizeof(mac);
+    rc = sc_generate_keyed_hash(usmHMACSHA1AuthProtocol,
+                                OID_LENGTH(usmHMACSHA1AuthProtocol), key, 80,
+                                (const u_char *) msg_6, strlen(msg_6),
+                                mac, &maclen);
+    OKF(rc == SNMPERR_SUCCESS && maclen == sizeof(hmac_sha1_6) &&
+        memcmp(mac, hmac_sha1_6, maclen) == 0,
+        ("HMAC-SHA-1 RFC 2202 case 6 (key longer than a block), call %d",
+         i + 1));
+}
+
+/*
+ * the cached and the uncached path must agree, for more keys than the
+ * cache holds, with keys changing in place between rounds.
+ */
+for (i = 0; i < sizeof(msg); ++i)
+    msg[i] = i * 7;
+bad = 0;
+for (round = 0; round < 3; ++round) {
+    for (k = 0; k < 40; ++k) {
+        memset(key, k, 32);
+        key[31] = round;
+        netsnmp_ds_set_boolean(NETSNMP_DS_LIBRARY_ID,
+                               NETSNMP_DS_LIB_NO_KEY_CACHE, 1);
+        reflen = sizeof(ref);
+        sc_generate_keyed_hash(usmHMAC192SHA256AuthProtocol,
+                               OID_LENGTH(usmHMAC192SHA256AuthProtocol),
+                               key, 32, msg, sizeof(msg), ref, &reflen);
+        netsnmp_ds_set_boolean(NETSNMP_DS_LIBRARY_ID,
+                               NETSNMP_DS_LIB_NO_KEY_CACHE, 0);
+        for (i = 0; i < 2; ++i) {
+            maclen = sizeof(mac);
+            rc = sc_generate_keyed_hash(usmHMAC192SHA256AuthProtocol,
+                                    OID_LENGTH(usmHMAC192SHA256AuthProtocol),
+                                    key, 32, msg, sizeof(msg), mac, &maclen);
+            if (rc != SNMPERR_SUCCESS || maclen != reflen ||
+                memcmp(mac, ref, maclen) != 0)
+                ++bad;
+        }
+    }
+}
+OKF(bad == 0, ("HMAC-SHA-256 cached and uncached agree (%d mismatches)",
+               bad));
+
+sc_key_cache_forget(key, 32);
+maclen = sizeof(mac);
+rc = sc_generate_keyed_hash(usmHMAC192SHA256AuthProtocol,
+                            OID_LENGTH(usmHMAC192SHA256AuthProtocol),
+                            key, 32, msg, sizeof(msg), mac, &maclen);
+OK(rc == SNMPERR_SUCCESS && memcmp(mac, ref, reflen) == 0,
+   "HMAC after forgetting the key");
+
+/* AES-CFB128, with the IV rewound for each call */
+for (i = 0; i < 3; ++i) {
+    memcpy(key, aes_key, sizeof(aes_key));
+    memcpy(iv, aes_iv, sizeof(aes_iv));
+    len = sizeof(buf);
+    rc = sc_encrypt(usmAESPrivProtocol, OID_LENGTH(usmAESPrivProtocol),
+                    key, sizeof(aes_key), iv, sizeof(iv),
+                    aes_pt, sizeof(aes_pt), buf, &len);
+    OKF(rc == SNMPERR_SUCCESS && len == sizeof(aes_ct) &&
+        memcmp(buf, aes_ct, len) == 0,
+        ("AES-CFB128 SP 800-38A vector, call %d", i + 1));
+    memcpy(iv, aes_iv, sizeof(aes_iv));
+    outlen = sizeof(out);
+    rc = sc_decrypt(usmAESPrivProtocol, OID_LENGTH(usmAESPrivProtocol),
+                    key, sizeof(aes_key), iv, sizeof(iv),
+                    buf, len, out, &outlen);
+    OKF(rc == SNMPERR_SUCCESS && outlen == sizeof(aes_pt) &&
+        memcmp(out, aes_pt, outlen) == 0,
+        ("AES-CFB128 decrypt, call %d", i + 1));
+    if (i == 1)
+        sc_key_cache_flush();
+}
+
+/* odd-length round trips, changing key and IV every time */
+bad = 0;
+for (k = 0; k < 50; ++k) {
+    memset(key, k, sizeof(aes_key));
+    memset(iv, 255 - k, sizeof(iv));
+    len = sizeof(buf);
+    rc = sc_encrypt(usmAESPrivProtocol, OID_LENGTH(usmAESPrivProtocol),
+                    key, sizeof(aes_key), iv, sizeof(iv),
+                    msg, 37 + k, buf, &len);
+    outlen = sizeof(out);
+    if (rc == SNMPERR_SUCCESS)
+        rc = sc_decrypt(usmAESPrivProtocol, OID_LENGTH(usmAESPrivProtocol),
+                        key, sizeof(aes_key), iv, sizeof(iv),
+                        buf, len, out, &outlen);
+    if (rc != SNMPERR_SUCCESS || outlen != 37 + k ||
+        memcmp(out, msg, outlen) != 0)
+        ++bad;
+}
+OKF(bad == 0, ("AES round trips (%d failures)", bad));
+#else
+OKF(1, ("Skipped: no OpenSSL AES"));
+#endif
+
+snmp_shutdown(test_name);
@@ -0,0 +1,93 @@
+/* HEADER Precomputed varbind encoding lengths */
+
+int i;
+netsnmp_variable_list *vars = NULL, *vp;
+u_char *pkt = NULL;
+size_t pkt_len = 0, offset = 0, vb_offset;
+static const long intval[] = {
+    -0x80000000L, -0x8000L, -129, -128, -1, 0, 1, 127, 128, 0xffff,
+    0x7fffffffL,
+};
+static const u_long uintval[] = {
+    0, 1, 0x7f, 0x80, 0xff, 0x100, 0x7fffffffUL, 0x80000000UL,
+    0xffffffffUL,
+};
+static const u_char uinttype[] = {
+    ASN_COUNTER, ASN_GAUGE, ASN_TIMETICKS, ASN_UINTEGER,
+};
+static const struct counter64 c64val[] = {
+    { 0, 0 }, { 0, 0x7f }, { 0, 0x80 }, { 0, 0xffffffffUL },
+    { 1, 0 }, { 0x7f, 5 }, { 0x80000000UL, 5 },
+    { 0xffffffffUL, 0xffffffffUL },
+};
+static const size_t strlens[] = { 0, 1, 127, 128, 255, 256, 4000 };
+static const oid oidval[] = { 1, 3, 6, 1, 4, 1, 8072, 127, 128, 16383,
+                              16384, 0xffffffffUL };
+static const oid objname[] = { 1, 3, 6, 1, 2, 1, 2, 2, 1, 10, 1 };
+static const u_char nulltype[] = {
+    ASN_NULL, SNMP_NOSUCHOBJECT, SNMP_NOSUCHINSTANCE, SNMP_ENDOFMIBVIEW,
+};
+u_char strval[4000];
+u_char ipval[4] = { 192, 168, 0, 1 };
+
+memset(strval, 'x', sizeof(strval));
+
+for (i = 0; i < sizeof(intval)/sizeof(intval[0]); ++i)
+    snmp_varlist_add_variable(&vars, objname, OID_LENGTH(objname),
+                              ASN_INTEGER, &intval[i], sizeof(intval[i]));
+for (i = 0; i < sizeof(uintval)/sizeof(uintval[0]); ++i)
+    snmp_varlist_add_variable(&vars, objname, OID_LENGTH(objname),
+                              uinttype[i % sizeof(uinttype)], &uintval[i],
+                              sizeof(uintval[i]));
+for (i = 0; i < sizeof(c64val)/sizeof(c64val[0]); ++i)
+    snmp_varlist_add_variable(&vars, objname, OID_LENGTH(objname),
+                              ASN_COUNTER64, &c64val[i], sizeof(c64val[i]));
+for (i = 0; i < sizeof(strlens)/sizeof(strlens[0]); ++i)
+    snmp_varlist_add_variable(&vars, objname, OID_LENGTH(objname),
+                              ASN_OCTET_STR, strval, strlens[i]);
+for (i = 0; i <= OID_LENGTH(oidval); ++i)
+    snmp_varlist_add_variable(&vars, oidval, OID_LENGTH(oidval),
+                              ASN_OBJECT_ID, oidval, i * sizeof(oid));
+for (i = 0; i < sizeof(nulltype); ++i)
+    snmp_varlist_add_variable(&vars, objname, i + 1, nulltype[i], NULL, 0);
+snmp_varlist_add_variable(&vars, objname, OID_LENGTH(objname),
+                          ASN_IPADDRESS, ipval, sizeof(ipval));
+snmp_varlist_add_variable(&vars, objname, OID_LENGTH(objname),
+                          ASN_OPAQUE, strval, 200);
+
+/*
+ * each varbind: the precomputed length must match what the reverse
+ * encoder actually emits.
+ */
+for (vp = vars, i = 0; vp; vp = vp->next_variable, ++i) {
+    vb_offset = offset;
+    OKF(snmp_realloc_rbuild_var_op(&pkt, &pkt_len, &offset, 1, vp->name,
+                                   &vp->name_length, vp->type,
+                                   vp->val.string, vp->val_len),
+        ("snmp_realloc_rbuild_var_op(#%d, type 0x%02x)", i, vp->type));
+    OKF(snmp_var_op_encoded_len(vp->name, vp->name_length, vp->type,
+                                vp->val.string, vp->val_len)
+        == offset - vb_offset,
+        ("varbind #%d (type 0x%02x): precomputed %" NETSNMP_PRIz "u,"
+         " encoded %" NETSNMP_PRIz "u", i, vp->type,
+         snmp_var_op_encoded_len(vp->name, vp->name_length, vp->type,
+                                 vp->val.string, vp->val_len),
+         offset - vb_offset));
+}
+
+/*
+ * the whole list, including the enclosing sequence header.
+ */
+OKF(asn_realloc_rbuild_sequence(&pkt, &pkt_len, &offset, 1,
+                                (u_char) (ASN_SEQUENCE | ASN_CONSTRUCTOR),
+                                offset),
+    ("asn_realloc_rbuild_sequence"));
+OKF(snmp_varbind_list_encoded_len(vars) == offset,
+    ("varbind list: precomputed %" NETSNMP_PRIz "u, encoded %"
+     NETSNMP_PRIz "u", snmp_varbind_list_encoded_len(vars), offset));
+
+OKF(snmp_varbind_list_encoded_len(NULL) == 2,
+    ("empty varbind list"));
+
+free(pkt);
+snmp_free_varbind(vars);
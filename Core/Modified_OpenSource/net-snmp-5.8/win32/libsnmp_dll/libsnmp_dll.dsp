@@ -128,6 +128,10 @@ SOURCE=..\..\snmplib\container_null.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\snmplib\container_skiplist.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\snmplib\data_list.c
 # End Source File
 # Begin Source File
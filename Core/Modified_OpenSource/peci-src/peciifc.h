@@ -30,6 +30,8 @@
 /* IOCTL Command and structure */
 #define PECI_ISSUE_CMD		_IOR('p', 0, int)
 #define PECI_ISSUE_CMD_WITH_RETRIES	_IOR('p', 1, int)
+#define PECI_ISSUE_BATCH		_IOR('p', 2, int)
+#define PECI_CONFIGURE_SAMPLER		_IOR('p', 3, int)
 
 #define PECI_DATA_BUF_SIZE	32 
 
@@ -47,6 +49,24 @@ typedef struct
     int status;
 }__attribute__((packed)) peci_cmd_t;
 
+#define PECI_MAX_BATCH_CMDS	8
+
+/*
+ * PECI_ISSUE_BATCH: cmd[0..count-1] are issued in order, filling each
+ * cmd[].status, read_buffer and timestamp[] (ns).
+ * PECI_CONFIGURE_SAMPLER: the helper sampler issues cmd[0..count-1] every
+ * period, count 0 stops it. The sampled value is up to 4 bytes of the
+ * response from value_offset[], little endian.
+ */
+typedef struct
+{
+    unsigned long long timestamp[PECI_MAX_BATCH_CMDS];
+    unsigned char count;
+    unsigned char retry;		/* as PECI_ISSUE_CMD_WITH_RETRIES */
+    unsigned char value_offset[PECI_MAX_BATCH_CMDS];
+    peci_cmd_t cmd[PECI_MAX_BATCH_CMDS];
+}__attribute__((packed)) peci_batch_t;
+
 union peci_data
 {
     unsigned char peci_byte;         /*!< Byte data */
@@ -39,7 +39,9 @@
 #include <linux/notifier.h>
 #include <linux/reboot.h>
 #include <asm/uaccess.h>
+#include <linux/ktime.h>
 #include "peci.h"
+#include "sensor_sampler.h"
 #include "driver_hal.h"
 #include "dbgout.h"	
 #include "helper.h"
@@ -73,6 +75,8 @@ MODULE_LICENSE ( DRIVER_LICENSE );
 struct peci_hal
 {
 	peci_hal_operations_t *ppeci_hal_ops;
+	struct sensor_sampler_source sampler;
+	peci_batch_t sampler_cmds;		/* commands issued by the sampler */
 };
 
 struct peci_dev
@@ -124,6 +128,7 @@ static int peci_ioctl(struct inode *inode, struct file *file,unsigned int cmd, u
 static long peci_ioctlUnlocked(struct file *file,unsigned int cmd, unsigned long arg);
 static int register_peci_hal_module(unsigned char num_instances, void *phal_ops, void **phw_data);
 static int unregister_peci_hal_module(void *phw_data);
+static int peci_sampler_read(void *priv, sensor_sample_t *sample, int count);
 
 #ifdef CONFIG_SPX_FEATURE_ENABLE_PECI_LOG
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,4,11))
@@ -234,6 +239,14 @@ int register_peci_hal_module(unsigned char num_instances, void *phal_ops, void *
 
 	ppeci_hal->ppeci_hal_ops = (peci_hal_operations_t *) phal_ops;
 
+	/* Commands are added to the sampler with PECI_CONFIGURE_SAMPLER */
+	ppeci_hal->sampler_cmds.count = 0;
+	ppeci_hal->sampler.name = "peci";
+	ppeci_hal->sampler.type = SENSOR_SOURCE_PECI;
+	ppeci_hal->sampler.read = peci_sampler_read;
+	ppeci_hal->sampler.priv = ppeci_hal;
+	sensor_sampler_register (&ppeci_hal->sampler);
+
 	*phw_data = (void *)ppeci_hal;
 	dbgprint ("private data: %p, %p\n", ppeci_hal, *phw_data);
 
@@ -251,6 +264,7 @@ int unregister_peci_hal_module(void *phw_data)
 	
 	dbgprint ("unregister hal addr : %p\n", ppeci_hal);
 
+	sensor_sampler_unregister (&ppeci_hal->sampler);
 	kfree (ppeci_hal);
 
 	return 0;
@@ -423,6 +437,124 @@ peci_process_cmd(peci_cmd_t *pecicmd, struct peci_dev *pdev, int do_retry)
 	return retval;
 }
 
+/* Up to 4 bytes of the response from offset, little endian */
+static uint32_t
+peci_sample_value(peci_cmd_t *pecicmd, unsigned char offset)
+{
+	uint32_t value = 0;
+	int i;
+
+	for (i = 3; i >= 0; i--)
+	{
+		if ((offset + i) < pecicmd->read_len)
+			value = (value << 8) | pecicmd->read_buffer[offset + i];
+	}
+	return value;
+}
+
+static int
+peci_sampler_read(void *priv, sensor_sample_t *sample, int count)
+{
+	struct peci_hal *ppeci_hal = (struct peci_hal *)priv;
+	peci_batch_t *cmds = &ppeci_hal->sampler_cmds;
+	struct peci_dev dev;
+	peci_cmd_t pecicmd;
+	unsigned char idx;
+	int i, ret;
+
+	dev.ppeci_hal = ppeci_hal;
+	dev.ch_num = 0;
+
+	down (&mutex);
+	for (i = 0; i < count; i++)
+	{
+		idx = sample[i].channel;
+		sample[i].value = 0;
+		if (idx >= cmds->count)
+		{
+			/* PECI_CONFIGURE_SAMPLER is replacing the commands */
+			sample[i].status = -EINVAL;
+			sample[i].timestamp = ktime_get_ns ();
+			continue;
+		}
+
+		/* A retry rewrites the command, keep the template */
+		pecicmd = cmds->cmd[idx];
+		ret = peci_process_cmd (&pecicmd, &dev, cmds->retry);
+		sample[i].timestamp = ktime_get_ns ();
+		if (ret < 0)
+			sample[i].status = ret;
+		else if (pecicmd.status != 0)
+			sample[i].status = -EIO;
+		else
+		{
+			sample[i].status = 0;
+			sample[i].value = peci_sample_value (&pecicmd, cmds->value_offset[idx]);
+		}
+	}
+	up (&mutex);
+	return 0;
+}
+
+static long
+peci_batch_ioctl(struct peci_dev *pdev, unsigned int cmd, unsigned long arg)
+{
+	peci_batch_t *batch;
+	uint8_t channel[PECI_MAX_BATCH_CMDS];
+	long retval = 0;
+	int i, ret;
+
+	if (!pdev->ppeci_hal)
+		return -ENXIO;
+
+	batch = kmalloc (sizeof (peci_batch_t), GFP_KERNEL);
+	if (!batch)
+		return -ENOMEM;
+
+	if (copy_from_user ((void *)batch, (void *)arg, sizeof (peci_batch_t)))
+	{
+		retval = -EFAULT;
+		goto out;
+	}
+
+	if (batch->count > PECI_MAX_BATCH_CMDS)
+	{
+		retval = -EINVAL;
+		goto out;
+	}
+
+	if (cmd == PECI_CONFIGURE_SAMPLER)
+	{
+		down (&mutex);
+		memcpy (&pdev->ppeci_hal->sampler_cmds, batch, sizeof (peci_batch_t));
+		up (&mutex);
+
+		/* Not under the mutex, a sweep holds the sampler lock while it waits for it */
+		for (i = 0; i < batch->count; i++)
+			channel[i] = i;
+		retval = sensor_sampler_set_channels (&pdev->ppeci_hal->sampler, channel, batch->count);
+		goto out;
+	}
+
+	/* One lock and one copy each way for the whole batch */
+	down (&mutex);
+	for (i = 0; i < batch->count; i++)
+	{
+		ret = peci_process_cmd (&batch->cmd[i], pdev, batch->retry);
+		batch->timestamp[i] = ktime_get_ns ();
+		if (ret < 0)
+			batch->cmd[i].status = ret;
+	}
+	up (&mutex);
+
+	if (copy_to_user ((void *)arg, (void *)batch, sizeof (peci_batch_t)))
+		retval = -EFAULT;
+
+out:
+	kfree (batch);
+	return retval;
+}
+
 static long 
 peci_ioctlUnlocked(struct file *file,
 		     unsigned int cmd, unsigned long arg)
@@ -440,6 +572,10 @@ peci_ioctlUnlocked(struct file *file,
 		dbgprint("ERROR: PECI Argument is NULL \n");
 		return -EINVAL;
 	}
+
+	if ((cmd == PECI_ISSUE_BATCH) || (cmd == PECI_CONFIGURE_SAMPLER))
+		return peci_batch_ioctl(pdev, cmd, arg);
+
   	down (&mutex);
 
 	if (__copy_from_user((void *)&pecicmd ,(void *)arg,sizeof(peci_cmd_t)))
@@ -0,0 +1,349 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+
+/*
+ * Closed loop fan control, see fanctrl.h
+ *
+ * Integer arithmetic only: temperatures in milli-degrees C, times in ms and
+ * duty cycles in milli-duty (1000 per step of the 0-255 register value).
+ */
+
+#ifdef __KERNEL__
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+#else
+#include <errno.h>
+#include <string.h>
+#endif
+
+#include "fanctrl.h"
+
+#define MS_NS		1000000LL
+#define RATE_FILTER	750		/* ms, time constant of the derivative filter, three sampler sweeps */
+
+static void
+clear_stats (fanctrl_zone_stats_t *stats)
+{
+	stats->min_error = 0;
+	stats->max_error = 0;
+	stats->ticks = 0;
+	stats->saturated = 0;
+	stats->failsafe_ticks = 0;
+	stats->duty_changes = 0;
+	stats->abs_error_sum = 0;
+	stats->duty_sum = 0;
+}
+
+int
+fanctrl_configure_zone (struct fanctrl *fc, const fanctrl_zone_config_t *cfg)
+{
+	struct fanctrl_zone *zone;
+	int i, owner;
+
+	if (cfg->zone >= FANCTRL_MAX_ZONES)
+		return -EINVAL;
+	zone = &fc->zone[cfg->zone];
+
+	if (cfg->mode != FANCTRL_MODE_OFF)
+	{
+		if (cfg->mode != FANCTRL_MODE_PID && cfg->mode != FANCTRL_MODE_STEP)
+			return -EINVAL;
+		if (cfg->num_pwms == 0 || cfg->num_pwms > FANCTRL_MAX_ZONE_PWMS)
+			return -EINVAL;
+		if (cfg->num_inputs == 0 || cfg->num_inputs > FANCTRL_MAX_ZONE_INPUTS)
+			return -EINVAL;
+		if (cfg->min_duty > cfg->max_duty || cfg->stale_ms == 0)
+			return -EINVAL;
+		for (i = 0; i < cfg->num_inputs; i++)
+		{
+			if (cfg->input[i] >= FANCTRL_MAX_INPUTS)
+				return -EINVAL;
+		}
+		for (i = 0; i < cfg->num_pwms; i++)
+		{
+			owner = fanctrl_pwm_zone (fc, cfg->pwm[i]);
+			if (owner >= 0 && owner != cfg->zone)
+				return -EBUSY;
+		}
+		if (cfg->mode == FANCTRL_MODE_PID)
+		{
+			/* Keeps kp * error and ki * integral well inside 64 bits */
+			if (cfg->kp < 0 || cfg->kp > 1000000 || cfg->ki < 0 || cfg->ki > 1000000 ||
+			    cfg->kd < 0 || cfg->kd > 1000000)
+				return -EINVAL;
+		}
+		else
+		{
+			if (cfg->num_steps == 0 || cfg->num_steps > FANCTRL_MAX_STEPS || cfg->hysteresis < 0)
+				return -EINVAL;
+			for (i = 1; i < cfg->num_steps; i++)
+			{
+				if (cfg->step[i].temp <= cfg->step[i - 1].temp)
+					return -EINVAL;
+			}
+		}
+	}
+
+	memset (zone, 0, sizeof (*zone));
+	zone->cfg = *cfg;
+	zone->duty = -1;
+	zone->output = -1;
+	zone->step = -1;
+	zone->stats.zone = cfg->zone;
+	zone->stats.mode = cfg->mode;
+	return 0;
+}
+
+int
+fanctrl_set_temp (struct fanctrl *fc, unsigned int input, int temp, uint64_t now)
+{
+	if (input >= FANCTRL_MAX_INPUTS)
+		return -EINVAL;
+	fc->input[input].temp = temp;
+	fc->input[input].stamp = now ? now : 1;
+	return 0;
+}
+
+void
+fanctrl_start (struct fanctrl *fc, unsigned int period)
+{
+	int z;
+
+	/* The first tick after a pause must not see the pause as dt */
+	fc->period = period;
+	for (z = 0; z < FANCTRL_MAX_ZONES; z++)
+	{
+		fc->zone[z].last_tick = 0;
+		fc->zone[z].have_last = 0;
+	}
+}
+
+/* Zone whose PWMs include pwm, or -1 */
+int
+fanctrl_pwm_zone (const struct fanctrl *fc, unsigned int pwm)
+{
+	int z, i;
+
+	for (z = 0; z < FANCTRL_MAX_ZONES; z++)
+	{
+		if (fc->zone[z].cfg.mode == FANCTRL_MODE_OFF)
+			continue;
+		for (i = 0; i < fc->zone[z].cfg.num_pwms; i++)
+		{
+			if (fc->zone[z].cfg.pwm[i] == pwm)
+				return z;
+		}
+	}
+	return -1;
+}
+
+/* Hottest input of the zone pushed within stale_ms, 0 when there is none */
+static int
+hottest_input (struct fanctrl *fc, struct fanctrl_zone *zone, uint64_t now, int *temp, uint64_t *stamp)
+{
+	uint64_t stale = (uint64_t)zone->cfg.stale_ms * MS_NS;
+	struct fanctrl_input *in;
+	int found = 0;
+	int i;
+
+	for (i = 0; i < zone->cfg.num_inputs; i++)
+	{
+		in = &fc->input[zone->cfg.input[i]];
+		if (in->stamp == 0 || (now > in->stamp && now - in->stamp > stale))
+			continue;
+		if (!found || in->temp > *temp)
+		{
+			*temp = in->temp;
+			*stamp = in->stamp;
+		}
+		found = 1;
+	}
+	return found;
+}
+
+/*
+ * Rate of change of the zone temperature. Inputs arrive less often than the
+ * ticks and in sensor counts, so the rate is only taken when a new reading
+ * comes in, over the time since the last one, and low pass filtered.
+ */
+static void
+update_rate (struct fanctrl_zone *zone, int temp, uint64_t stamp)
+{
+	int64_t dt, rate;
+
+	if (zone->have_last && stamp == zone->last_stamp)
+		return;
+	if (zone->have_last && stamp > zone->last_stamp)
+	{
+		dt = fanctrl_div ((int64_t)(stamp - zone->last_stamp), (int)MS_NS);
+		if (dt <= 0)
+			dt = 1;
+		rate = fanctrl_div ((int64_t)(temp - zone->last_temp) * 1000, (int)dt);
+		zone->rate += (int)fanctrl_div ((rate - zone->rate) * dt, (int)(RATE_FILTER + dt));
+	}
+	else
+	{
+		zone->rate = 0;
+	}
+	zone->last_temp = temp;
+	zone->last_stamp = stamp;
+	zone->have_last = 1;
+}
+
+/*
+ * PID on temp - setpoint. The derivative is taken on the measurement so a
+ * new setpoint doesn't kick the output, and the integral stops growing while
+ * the output is saturated in the direction of the error (conditional
+ * integration), so the fans come down as soon as the load does.
+ */
+static int64_t
+pid_output (struct fanctrl_zone *zone, int temp, int64_t dt)
+{
+	fanctrl_zone_config_t *cfg = &zone->cfg;
+	int error = temp - cfg->setpoint;
+	int64_t integral = zone->integral + (int64_t)error * dt;
+	int64_t p, i, d, out;
+
+	p = fanctrl_div ((int64_t)cfg->kp * error, 1000);
+	i = fanctrl_div ((int64_t)cfg->ki * integral, 1000000);
+	d = fanctrl_div ((int64_t)cfg->kd * zone->rate, 1000);
+
+	out = p + i + d;
+	if ((out > cfg->max_duty * 1000 && error > 0) || (out < cfg->min_duty * 1000 && error < 0))
+	{
+		i = fanctrl_div ((int64_t)cfg->ki * zone->integral, 1000000);
+		out = p + i + d;
+	}
+	else
+	{
+		zone->integral = integral;
+	}
+	zone->stats.integral = (int)i;
+	return out;
+}
+
+/* Steps up as soon as temp reaches a step and down once it is hysteresis below it */
+static int64_t
+step_output (struct fanctrl_zone *zone, int temp)
+{
+	fanctrl_zone_config_t *cfg = &zone->cfg;
+	int s = zone->step;
+
+	while (s + 1 < cfg->num_steps && temp >= cfg->step[s + 1].temp)
+		s++;
+	while (s >= 0 && temp < cfg->step[s].temp - cfg->hysteresis)
+		s--;
+	zone->step = s;
+
+	return (s < 0 ? cfg->min_duty : cfg->step[s].duty) * 1000;
+}
+
+/*
+ * Runs the controller of one zone. Returns its duty cycle, 0-255, or -1
+ * when the zone is off.
+ */
+int
+fanctrl_tick (struct fanctrl *fc, unsigned int z, uint64_t now)
+{
+	struct fanctrl_zone *zone = &fc->zone[z];
+	fanctrl_zone_config_t *cfg = &zone->cfg;
+	fanctrl_zone_stats_t *stats = &zone->stats;
+	int64_t dt, out, lo, hi, slew;
+	uint64_t stamp = 0;
+	int temp = 0;
+	int duty, error;
+
+	if (cfg->mode == FANCTRL_MODE_OFF)
+		return -1;
+
+	dt = fc->period;
+	if (zone->last_tick != 0 && now > zone->last_tick)
+		dt = fanctrl_div ((int64_t)(now - zone->last_tick), (int)MS_NS);
+	if (dt <= 0)
+		dt = 1;
+	zone->last_tick = now;
+
+	if (!hottest_input (fc, zone, now, &temp, &stamp))
+	{
+		/* Nothing to control on, the integral is kept for when the inputs return */
+		zone->have_last = 0;
+		zone->duty = cfg->failsafe_duty * 1000;
+		stats->failsafe = 1;
+		stats->failsafe_ticks++;
+	}
+	else
+	{
+		update_rate (zone, temp, stamp);
+		if (cfg->mode == FANCTRL_MODE_PID)
+			out = pid_output (zone, temp, dt);
+		else
+			out = step_output (zone, temp);
+
+		lo = cfg->min_duty * 1000;
+		hi = cfg->max_duty * 1000;
+		if (out < lo || out > hi)
+		{
+			out = (out < lo) ? lo : hi;
+			stats->saturated++;
+		}
+
+		slew = cfg->max_slew * 1000;
+		if (slew != 0 && zone->duty >= 0)
+		{
+			if (out > zone->duty + slew)
+				out = zone->duty + slew;
+			else if (out < zone->duty - slew)
+				out = zone->duty - slew;
+		}
+		zone->duty = (int)out;
+
+		error = temp - cfg->setpoint;
+		if (stats->ticks == stats->failsafe_ticks)
+		{
+			stats->min_error = error;
+			stats->max_error = error;
+		}
+		else if (error < stats->min_error)
+			stats->min_error = error;
+		else if (error > stats->max_error)
+			stats->max_error = error;
+		stats->abs_error_sum += (error < 0) ? -error : error;
+		stats->temp = temp;
+		stats->error = error;
+		stats->failsafe = 0;
+	}
+
+	duty = (zone->duty + 500) / 1000;
+	if (duty > 255)
+		duty = 255;
+	if (zone->output >= 0 && duty != zone->output)
+		stats->duty_changes++;
+	zone->output = duty;
+
+	stats->duty = duty;
+	stats->duty_sum += duty;
+	stats->ticks++;
+	return duty;
+}
+
+void
+fanctrl_get_stats (struct fanctrl *fc, unsigned int z, fanctrl_zone_stats_t *stats, int reset)
+{
+	struct fanctrl_zone *zone = &fc->zone[z];
+
+	*stats = zone->stats;
+	if (reset)
+		clear_stats (&zone->stats);
+}
@@ -0,0 +1,73 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+
+/*
+ * Closed loop fan control
+ *
+ * The controller of CONFIGURE_FAN_ZONE zones, see pwmtach_ioctl.h. It has
+ * no locking and no timer of its own: pwmtachmain.c calls fanctrl_tick()
+ * for every zone from its hrtimer and applies the returned duty cycles.
+ * The same code is built off target by tools/fanctrl_sim.c.
+ */
+
+#ifndef __FANCTRL_H__
+#define __FANCTRL_H__
+
+#include "pwmtach_ioctl.h"
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#include <linux/math64.h>
+#define fanctrl_div(a, b)	div_s64 ((a), (b))
+#else
+#include <stdint.h>
+#define fanctrl_div(a, b)	((a) / (b))
+#endif
+
+struct fanctrl_input
+{
+	int temp;			/* milli-degrees C */
+	uint64_t stamp;			/* ns it was pushed, 0 for never */
+};
+
+struct fanctrl_zone
+{
+	fanctrl_zone_config_t cfg;
+	int64_t integral;		/* error integral, milli-degrees C ms */
+	int duty;			/* last output, milli-duty, -1 for none yet */
+	int output;			/* last output, 0-255, -1 for none yet */
+	int last_temp;			/* input the derivative was last taken on */
+	uint64_t last_stamp;
+	int have_last;
+	int rate;			/* filtered derivative, milli-degrees C per s */
+	int step;			/* current step, -1 below the first */
+	uint64_t last_tick;		/* ns, 0 for none yet */
+	fanctrl_zone_stats_t stats;
+};
+
+struct fanctrl
+{
+	unsigned int period;		/* ms between ticks */
+	struct fanctrl_input input[FANCTRL_MAX_INPUTS];
+	struct fanctrl_zone zone[FANCTRL_MAX_ZONES];
+};
+
+int fanctrl_configure_zone (struct fanctrl *fc, const fanctrl_zone_config_t *cfg);
+int fanctrl_set_temp (struct fanctrl *fc, unsigned int input, int temp, uint64_t now);
+void fanctrl_start (struct fanctrl *fc, unsigned int period);
+int fanctrl_tick (struct fanctrl *fc, unsigned int zone, uint64_t now);
+int fanctrl_pwm_zone (const struct fanctrl *fc, unsigned int pwm);
+void fanctrl_get_stats (struct fanctrl *fc, unsigned int zone, fanctrl_zone_stats_t *stats, int reset);
+
+#endif /* __FANCTRL_H__ */
@@ -24,6 +24,8 @@
 #ifndef __PWMTACH_H__
 #define __PWMTACH_H__
 
+#include "sensor_sampler.h"
+
 #define MAX_PWMTACH_DEVICES     255
 
 typedef struct 
@@ -64,6 +66,8 @@ typedef struct
 {
 } pwmtach_core_funcs_t;
 
+struct fanctrl_dev;
+
 
 struct pwmtach_hal
 {
@@ -75,6 +79,8 @@ struct pwmtach_hal
         struct fan_map_entry_t* fan_map_table;                  // Mapping Table for Fan number, PWM number and Tach number
         struct fan_property_t* fan_property_table;              // Fan Properties
         pwmtach_hal_operations_t *ppwmtach_hal_ops;
+        struct sensor_sampler_source sampler;                   // Tachs read by the helper sampler
+        struct fanctrl_dev *fanctrl;                            // Fan zones, allocated on first use
 };
 
 int pwmtach_read_device_list ( char *buf, char **start, off_t offset, int count, int *eof, void *data );
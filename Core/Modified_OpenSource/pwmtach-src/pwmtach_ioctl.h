@@ -15,6 +15,7 @@
 #ifndef __PWMTACH_IOCTL_H__
 #define __PWMTACH_IOCTL_H__
 
+#include "sensor_sampler.h"
 
 typedef struct
 {
@@ -43,6 +44,117 @@ typedef struct
 	void* fanmap_dataptr;
 }  __attribute__((packed)) pwmtach_data_t;
 
+#define PWMTACH_MAX_BATCH_TACHS		16
+
+/* GET_TACH_VALUES_BY_TACH_CHANNEL: sample[].channel is the tach number in, value the RPM out */
+typedef struct
+{
+	unsigned int dev_id;
+	unsigned int num_tachs;
+	sensor_sample_t sample[PWMTACH_MAX_BATCH_TACHS];
+} pwmtach_batch_t;
+
+/* CONFIGURE_TACH_SAMPLER: tachs read by the helper sampler, none to stop */
+typedef struct
+{
+	unsigned int dev_id;
+	unsigned int num_tachs;
+	unsigned char tachnumber[PWMTACH_MAX_BATCH_TACHS];
+} __attribute__((packed)) pwmtach_sampler_config_t;
+
+/*
+ * Closed loop fan control. A zone drives its PWMs from the hottest of its
+ * temperature inputs, either with a PID controller or a step curve. User
+ * space pushes the temperatures with SET_FAN_ZONE_TEMPS and the driver
+ * updates the duty cycles every period_ms of CONTROL_FAN_ZONES. The PWMs of
+ * a configured zone belong to the controller, setting their duty cycle
+ * otherwise fails with EBUSY until the zone is set to FANCTRL_MODE_OFF.
+ * Temperatures are in milli-degrees C and duty cycles are 0-255.
+ */
+#define FANCTRL_MAX_ZONES		8
+#define FANCTRL_MAX_INPUTS		32
+#define FANCTRL_MAX_ZONE_PWMS		8
+#define FANCTRL_MAX_ZONE_INPUTS		8
+#define FANCTRL_MAX_STEPS		16
+#define FANCTRL_MIN_PERIOD		10	/* ms */
+
+#define FANCTRL_MODE_OFF		0
+#define FANCTRL_MODE_PID		1
+#define FANCTRL_MODE_STEP		2
+
+typedef struct
+{
+	int temp;			/* step applies from this temperature up */
+	unsigned char duty;
+} __attribute__((packed)) fanctrl_step_t;
+
+/* CONFIGURE_FAN_ZONE: replaces the zone and restarts its controller */
+typedef struct
+{
+	unsigned int dev_id;
+	unsigned char zone;
+	unsigned char mode;			/* FANCTRL_MODE_xxx */
+	unsigned char num_pwms;
+	unsigned char pwm[FANCTRL_MAX_ZONE_PWMS];
+	unsigned char num_inputs;
+	unsigned char input[FANCTRL_MAX_ZONE_INPUTS];	/* indexes into SET_FAN_ZONE_TEMPS inputs */
+	unsigned char min_duty;
+	unsigned char max_duty;
+	unsigned char failsafe_duty;		/* while none of the inputs is fresh */
+	unsigned char max_slew;			/* duty change per period, 0 for no limit */
+	unsigned int stale_ms;			/* inputs older than this are ignored */
+	int setpoint;				/* PID target, statistics only for a step curve */
+	int kp;					/* milli-duty per degree C */
+	int ki;					/* milli-duty per degree C and second */
+	int kd;					/* milli-duty per degree C per second */
+	int hysteresis;				/* step down this far below the step temperature */
+	unsigned char num_steps;
+	fanctrl_step_t step[FANCTRL_MAX_STEPS];	/* ascending temperatures */
+} __attribute__((packed)) fanctrl_zone_config_t;
+
+typedef struct
+{
+	unsigned char input;
+	int temp;
+} __attribute__((packed)) fanctrl_temp_t;
+
+/* SET_FAN_ZONE_TEMPS */
+typedef struct
+{
+	unsigned int dev_id;
+	unsigned int count;
+	fanctrl_temp_t temp[FANCTRL_MAX_INPUTS];
+} __attribute__((packed)) fanctrl_temps_t;
+
+/* CONTROL_FAN_ZONES: starts the controller every period_ms, 0 stops it */
+typedef struct
+{
+	unsigned int dev_id;
+	unsigned int period_ms;
+} __attribute__((packed)) fanctrl_control_t;
+
+/* GET_FAN_ZONE_STATS: counters since the zone was configured or last reset */
+typedef struct
+{
+	unsigned int dev_id;
+	unsigned char zone;
+	unsigned char reset;			/* in: clear the counters once read */
+	unsigned char mode;
+	unsigned char duty;			/* last output */
+	unsigned char failsafe;			/* last output was failsafe_duty */
+	int temp;				/* last hottest fresh input */
+	int error;				/* last temp - setpoint */
+	int min_error;
+	int max_error;
+	int integral;				/* PID integral term, milli-duty */
+	unsigned int ticks;
+	unsigned int saturated;			/* ticks clamped to min_duty or max_duty */
+	unsigned int failsafe_ticks;
+	unsigned int duty_changes;
+	unsigned long long abs_error_sum;	/* over the ticks that had an input */
+	unsigned long long duty_sum;
+} __attribute__((packed)) fanctrl_zone_stats_t;
+
 #define ENABLE_PWM_CHANNEL                     _IOW('P', 0, int)
 #define DISABLE_PWM_CHANNEL                    _IOW('P', 1, int)
 #define ENABLE_TACH_CHANNEL                    _IOW('P', 2, int)
@@ -76,7 +188,13 @@ typedef struct
 #define GET_PWM_PROPERTY                       _IOR('P', 30, int)
 #define CLEAR_TACH_ERROR                       _IOW('P', 31, int)
 #define CLEAR_PWM_ERRORS                       _IOW('P', 32, int)
-#define END_OF_FUNC_TABLE                      _IOW('P', 33, int)
+#define GET_TACH_VALUES_BY_TACH_CHANNEL        _IOR('P', 33, int)
+#define CONFIGURE_TACH_SAMPLER                 _IOW('P', 34, int)
+#define CONFIGURE_FAN_ZONE                     _IOW('P', 35, int)
+#define SET_FAN_ZONE_TEMPS                     _IOW('P', 36, int)
+#define CONTROL_FAN_ZONES                      _IOW('P', 37, int)
+#define GET_FAN_ZONE_STATS                     _IOR('P', 38, int)
+#define END_OF_FUNC_TABLE                      _IOW('P', 39, int)
 
 typedef pwmtach_data_t pwmtach_ioctl_data;
 
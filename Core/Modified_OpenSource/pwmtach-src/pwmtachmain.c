@@ -31,6 +31,10 @@
 #include <linux/init.h>
 #include <linux/wait.h>
 #include <linux/sched.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/hrtimer.h>
+#include <linux/spinlock.h>
 
 #include "helper.h"
 #include "dbgout.h"
@@ -38,6 +42,7 @@
 #include "fan_structs.h"
 #include "pwmtach_ioctl.h"
 #include "driver_hal.h"
+#include "fanctrl.h"
 
 MODULE_AUTHOR("American Megatrends Inc");
 MODULE_DESCRIPTION("PwmTach Common driver");
@@ -95,6 +100,27 @@ static int show_fanmap_table (struct pwmtach_dev* pdev);
 static int show_fanproperty_table (struct pwmtach_dev* pdev);
 static int init_pwmtach (struct pwmtach_dev* pdev, pwmtach_data_t* in_data);
 static int get_pwmvalue (struct pwmtach_dev* pdev, unsigned int pwm_number, unsigned char* dutycycle);
+static int get_tachvalues (struct pwmtach_dev* pdev, sensor_sample_t* sample, int count);
+static int tach_sampler_read (void *priv, sensor_sample_t* sample, int count);
+static long pwmtach_batch_ioctl (uint cmd, ulong arg);
+static long pwmtach_fanctrl_ioctl (uint cmd, ulong arg);
+static int set_pwm_dutycycle (struct pwmtach_dev* pdev, unsigned int pwm_number, int dutycycle);
+static void fanctrl_release (struct pwmtach_hal *ppwmtach_hal);
+
+/* The tach engine measures one tach at a time, for ioctls and the sampler alike */
+static DEFINE_MUTEX(tach_read_lock);
+
+struct fanctrl_dev
+{
+	struct fanctrl fc;
+	spinlock_t lock;			/* fc, and the duty registers shared by PWM pairs */
+	struct hrtimer timer;
+	ktime_t period;
+	struct pwmtach_hal *ppwmtach_hal;
+};
+
+/* Allocating, starting and stopping the fan controllers */
+static DEFINE_MUTEX(fanctrl_lock);
 
 static int g_dev_id = 0;
 static struct cdev *pwmtach_cdev;
@@ -153,6 +179,14 @@ register_pwmtach_hal_module (unsigned char num_instances, void *phal_ops, void *
 	ppwmtach_hal->num_tachs = 0;	
 	ppwmtach_hal->ppwmtach_hal_ops = (pwmtach_hal_operations_t *) phal_ops;
 
+	/* Tachs are added to the sampler with CONFIGURE_TACH_SAMPLER */
+	ppwmtach_hal->sampler.name = PWMTACH_DEV_NAME;
+	ppwmtach_hal->sampler.type = SENSOR_SOURCE_TACH;
+	ppwmtach_hal->sampler.read = tach_sampler_read;
+	ppwmtach_hal->sampler.priv = ppwmtach_hal;
+	sensor_sampler_register (&ppwmtach_hal->sampler);
+	ppwmtach_hal->fanctrl = NULL;
+
 	*phw_data = (void *) ppwmtach_hal;
         dbgprint ("private data: %p, %p\n", ppwmtach_hal, *phw_data);
 	return 0;
@@ -162,6 +196,8 @@ int unregister_pwmtach_hal_module (void *phw_data)
 {
 	struct pwmtach_hal *ppwmtach_hal = (struct pwmtach_hal *)phw_data;
         dbgprint ("unregister hal addr : %p\n", ppwmtach_hal);
+	sensor_sampler_unregister (&ppwmtach_hal->sampler);
+	fanctrl_release (ppwmtach_hal);
 	kfree (ppwmtach_hal->fan_property_table);
 	kfree (ppwmtach_hal->fan_map_table);
 	kfree (ppwmtach_hal);
@@ -223,9 +259,17 @@ pwmtach_ioctlUnlocked (struct file *file, uint cmd, ulong arg)
 	//struct pwmtach_dev * pdev = (struct pwmtach_dev*) file->private_data;
 	unsigned int pwmnumber = 0;
 	unsigned int tachnumber = 0;
+	int ret;
 	struct pwmtach_hal * ppwmtach_hal;
 	struct pwmtach_dev dev;
 	struct pwmtach_dev * pdev = &dev;
+
+	/* These take their own argument structures */
+	if ((cmd == GET_TACH_VALUES_BY_TACH_CHANNEL) || (cmd == CONFIGURE_TACH_SAMPLER))
+		return pwmtach_batch_ioctl (cmd, arg);
+	if ((cmd == CONFIGURE_FAN_ZONE) || (cmd == SET_FAN_ZONE_TEMPS) ||
+	    (cmd == CONTROL_FAN_ZONES) || (cmd == GET_FAN_ZONE_STATS))
+		return pwmtach_fanctrl_ioctl (cmd, arg);
 	
 	if ( copy_from_user((void*)&in_data, (void*)arg, sizeof(pwmtach_data_t)) )
 		return -EFAULT;
@@ -280,7 +324,8 @@ pwmtach_ioctlUnlocked (struct file *file, uint cmd, ulong arg)
 				return -1;
 			}
 			in_data.dutycycle = (in_data.dutycycle*255)/100;
-			pdev->ppwmtach_hal->ppwmtach_hal_ops->set_dutycycle(in_data.pwmnumber, in_data.dutycycle);
+			if (0 != set_pwm_dutycycle (pdev, in_data.pwmnumber, in_data.dutycycle))
+				return -EBUSY;
 			break;
 		case SET_DUTY_CYCLE_VALUE_BY_PWM_CHANNEL:
 			if (in_data.pwmnumber < 0)
@@ -290,7 +335,8 @@ pwmtach_ioctlUnlocked (struct file *file, uint cmd, ulong arg)
 				printk("Dutycycle value should be between 0 to 255.\n");
 				return -1;
 			}
-			pdev->ppwmtach_hal->ppwmtach_hal_ops->set_dutycycle(in_data.pwmnumber, in_data.dutycycle);
+			if (0 != set_pwm_dutycycle (pdev, in_data.pwmnumber, in_data.dutycycle))
+				return -EBUSY;
 			break;
 		case GET_TACH_VALUE_BY_TACH_CHANNEL:
 			if (in_data.tachnumber < 0)
@@ -360,10 +406,14 @@ pwmtach_ioctlUnlocked (struct file *file, uint cmd, ulong arg)
 			pwmnumber = get_pwm_number (pdev, in_data.fannumber);
 			if (pwmnumber == -1)
 				return -1;
-			pdev->ppwmtach_hal->ppwmtach_hal_ops->set_dutycycle(pwmnumber, in_data.dutycycle);			
+			if (0 != set_pwm_dutycycle (pdev, pwmnumber, in_data.dutycycle))
+				return -EBUSY;
 			break;
 		case INIT_PWMTACH:
-			if (0 != init_pwmtach (pdev, &in_data))
+			ret = init_pwmtach (pdev, &in_data);
+			if (-EBUSY == ret)
+				return -EBUSY;
+			if (0 != ret)
 				return -1;		
 			break;
 		case CONFIGURE_FANMAP_TABLE:
@@ -458,12 +508,12 @@ init_pwmtach (struct pwmtach_dev* pdev, pwmtach_data_t* in_data)
 	int clock_val =  pdev->ppwmtach_hal->ppwmtach_hal_ops->get_pwm_clk();
 	int pulses_rev = pdev->ppwmtach_hal->fan_property_table[in_data->fannumber].pulses_per_revolution;
 	unsigned int all_done = 0;
+	struct fanctrl_dev *fd = pdev->ppwmtach_hal->fanctrl;
+	unsigned long flags = 0;
 
 	in_data->pwmnumber = get_pwm_number (pdev, in_data->fannumber);
 	if (in_data->pwmnumber < 0)
 		return -1;
-	pdev->ppwmtach_hal->ppwmtach_hal_ops->disable_pwm_control (in_data->pwmnumber);	
-	pdev->ppwmtach_hal->ppwmtach_hal_ops->disable_counterresolution (in_data->pwmnumber);
 
 	//initialize prescale, dutycycle, counter resolution
         in_data->prescalervalue = pdev->ppwmtach_hal->ppwmtach_hal_ops->get_prescale(in_data->pwmnumber);
@@ -481,23 +531,285 @@ init_pwmtach (struct pwmtach_dev* pdev, pwmtach_data_t* in_data)
                 }
         }
         in_data->prevdutycycle = in_data->dutycycle;
-	
+
+	/* Same rules as set_pwm_dutycycle(), the fan zone timer shares these registers */
+	if (NULL != fd)
+	{
+		spin_lock_irqsave (&fd->lock, flags);
+		if (fanctrl_pwm_zone (&fd->fc, in_data->pwmnumber) >= 0)
+		{
+			spin_unlock_irqrestore (&fd->lock, flags);
+			return -EBUSY;
+		}
+	}
+	pdev->ppwmtach_hal->ppwmtach_hal_ops->disable_pwm_control (in_data->pwmnumber);	
+	pdev->ppwmtach_hal->ppwmtach_hal_ops->disable_counterresolution (in_data->pwmnumber);
 	pdev->ppwmtach_hal->ppwmtach_hal_ops->set_counterresolution (in_data->pwmnumber, in_data->counterresvalue);
 	pdev->ppwmtach_hal->ppwmtach_hal_ops->set_prescale (in_data->pwmnumber, in_data->prescalervalue);
 	pdev->ppwmtach_hal->ppwmtach_hal_ops->set_dutycycle (in_data->pwmnumber, in_data->dutycycle);		
 	pdev->ppwmtach_hal->ppwmtach_hal_ops->enable_counterresolution (in_data->pwmnumber);
 	pdev->ppwmtach_hal->ppwmtach_hal_ops->enable_pwm_control (in_data->pwmnumber);
+	if (NULL != fd)
+		spin_unlock_irqrestore (&fd->lock, flags);
 	return 0;
 #endif
 }
 
 
+static long
+pwmtach_batch_ioctl (uint cmd, ulong arg)
+{
+	pwmtach_batch_t batch;
+	pwmtach_sampler_config_t config;
+	struct pwmtach_dev dev;
+
+	switch (cmd)
+	{
+		case GET_TACH_VALUES_BY_TACH_CHANNEL:
+			if ( copy_from_user((void*)&batch, (void*)arg, sizeof(pwmtach_batch_t)) )
+				return -EFAULT;
+			if (batch.num_tachs > PWMTACH_MAX_BATCH_TACHS)
+				return -EINVAL;
+			dev.ppwmtach_hal = (struct pwmtach_hal *) hw_intr (EDEV_TYPE_PWMTACH, batch.dev_id);
+			if (NULL == dev.ppwmtach_hal)
+				return -ENXIO;
+			get_tachvalues (&dev, batch.sample, batch.num_tachs);
+			if ( copy_to_user((void*)arg, &batch, sizeof(pwmtach_batch_t)) )
+				return -EFAULT;
+			return 0;
+
+		case CONFIGURE_TACH_SAMPLER:
+			if ( copy_from_user((void*)&config, (void*)arg, sizeof(pwmtach_sampler_config_t)) )
+				return -EFAULT;
+			if (config.num_tachs > PWMTACH_MAX_BATCH_TACHS)
+				return -EINVAL;
+			dev.ppwmtach_hal = (struct pwmtach_hal *) hw_intr (EDEV_TYPE_PWMTACH, config.dev_id);
+			if (NULL == dev.ppwmtach_hal)
+				return -ENXIO;
+			return sensor_sampler_set_channels (&dev.ppwmtach_hal->sampler, config.tachnumber, config.num_tachs);
+	}
+	return -EINVAL;
+}
+
+/* ----- Fan control ------------------------------------------------------ */
+
+/* Sets a duty cycle from an ioctl, unless the PWM belongs to a fan zone */
+static int
+set_pwm_dutycycle (struct pwmtach_dev* pdev, unsigned int pwm_number, int dutycycle)
+{
+	struct fanctrl_dev *fd = pdev->ppwmtach_hal->fanctrl;
+	unsigned long flags;
+
+	if (NULL == fd)
+	{
+		pdev->ppwmtach_hal->ppwmtach_hal_ops->set_dutycycle (pwm_number, dutycycle);
+		return 0;
+	}
+
+	spin_lock_irqsave (&fd->lock, flags);
+	if (fanctrl_pwm_zone (&fd->fc, pwm_number) >= 0)
+	{
+		spin_unlock_irqrestore (&fd->lock, flags);
+		return -EBUSY;
+	}
+	pdev->ppwmtach_hal->ppwmtach_hal_ops->set_dutycycle (pwm_number, dutycycle);
+	spin_unlock_irqrestore (&fd->lock, flags);
+	return 0;
+}
+
+/* Runs every zone once a period. Setting a duty cycle only writes a register. */
+static enum hrtimer_restart
+fanctrl_timer (struct hrtimer *timer)
+{
+	struct fanctrl_dev *fd = container_of (timer, struct fanctrl_dev, timer);
+	pwmtach_hal_operations_t *ops = fd->ppwmtach_hal->ppwmtach_hal_ops;
+	struct fanctrl_zone *zone;
+	int z, i, last, duty;
+
+	spin_lock (&fd->lock);
+	for (z = 0; z < FANCTRL_MAX_ZONES; z++)
+	{
+		zone = &fd->fc.zone[z];
+		last = zone->output;
+		duty = fanctrl_tick (&fd->fc, z, ktime_get_ns ());
+		if (duty < 0 || duty == last)
+			continue;
+		for (i = 0; i < zone->cfg.num_pwms; i++)
+			ops->set_dutycycle (zone->cfg.pwm[i], duty);
+	}
+	spin_unlock (&fd->lock);
+
+	hrtimer_forward_now (timer, fd->period);
+	return HRTIMER_RESTART;
+}
+
+static struct fanctrl_dev *
+fanctrl_get (struct pwmtach_hal *ppwmtach_hal)
+{
+	struct fanctrl_dev *fd;
+
+	mutex_lock (&fanctrl_lock);
+	fd = ppwmtach_hal->fanctrl;
+	if (NULL == fd)
+	{
+		fd = (struct fanctrl_dev *) kzalloc (sizeof(struct fanctrl_dev), GFP_KERNEL);
+		if (NULL != fd)
+		{
+			spin_lock_init (&fd->lock);
+			hrtimer_init (&fd->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+			fd->timer.function = fanctrl_timer;
+			fd->ppwmtach_hal = ppwmtach_hal;
+			ppwmtach_hal->fanctrl = fd;
+		}
+	}
+	mutex_unlock (&fanctrl_lock);
+	return fd;
+}
+
+static void
+fanctrl_release (struct pwmtach_hal *ppwmtach_hal)
+{
+	if (NULL == ppwmtach_hal->fanctrl)
+		return;
+	hrtimer_cancel (&ppwmtach_hal->fanctrl->timer);
+	kfree (ppwmtach_hal->fanctrl);
+	ppwmtach_hal->fanctrl = NULL;
+}
+
+static long
+pwmtach_fanctrl_ioctl (uint cmd, ulong arg)
+{
+	fanctrl_zone_config_t config;
+	fanctrl_temps_t temps;
+	fanctrl_control_t control;
+	fanctrl_zone_stats_t stats;
+	struct pwmtach_hal *ppwmtach_hal;
+	struct fanctrl_dev *fd;
+	unsigned long flags;
+	unsigned int dev_id;
+	u64 now;
+	int i, ret;
+
+	/* Every argument structure starts with dev_id */
+	if ( copy_from_user((void*)&dev_id, (void*)arg, sizeof(unsigned int)) )
+		return -EFAULT;
+	ppwmtach_hal = (struct pwmtach_hal *) hw_intr (EDEV_TYPE_PWMTACH, dev_id);
+	if (NULL == ppwmtach_hal)
+		return -ENXIO;
+	fd = fanctrl_get (ppwmtach_hal);
+	if (NULL == fd)
+		return -ENOMEM;
+
+	switch (cmd)
+	{
+		case CONFIGURE_FAN_ZONE:
+			if ( copy_from_user((void*)&config, (void*)arg, sizeof(fanctrl_zone_config_t)) )
+				return -EFAULT;
+			if (config.mode != FANCTRL_MODE_OFF)
+			{
+				if (config.num_pwms > FANCTRL_MAX_ZONE_PWMS)
+					return -EINVAL;
+				for (i = 0; i < config.num_pwms; i++)
+				{
+					if (config.pwm[i] >= ppwmtach_hal->ppwmtach_hal_ops->get_num_of_pwms ())
+						return -EINVAL;
+				}
+			}
+			spin_lock_irqsave (&fd->lock, flags);
+			ret = fanctrl_configure_zone (&fd->fc, &config);
+			spin_unlock_irqrestore (&fd->lock, flags);
+			return ret;
+
+		case SET_FAN_ZONE_TEMPS:
+			if ( copy_from_user((void*)&temps, (void*)arg, sizeof(fanctrl_temps_t)) )
+				return -EFAULT;
+			if (temps.count > FANCTRL_MAX_INPUTS)
+				return -EINVAL;
+			for (i = 0; i < temps.count; i++)
+			{
+				if (temps.temp[i].input >= FANCTRL_MAX_INPUTS)
+					return -EINVAL;
+			}
+			now = ktime_get_ns ();
+			spin_lock_irqsave (&fd->lock, flags);
+			for (i = 0; i < temps.count; i++)
+				fanctrl_set_temp (&fd->fc, temps.temp[i].input, temps.temp[i].temp, now);
+			spin_unlock_irqrestore (&fd->lock, flags);
+			return 0;
+
+		case CONTROL_FAN_ZONES:
+			if ( copy_from_user((void*)&control, (void*)arg, sizeof(fanctrl_control_t)) )
+				return -EFAULT;
+			if (control.period_ms != 0 && control.period_ms < FANCTRL_MIN_PERIOD)
+				return -EINVAL;
+			mutex_lock (&fanctrl_lock);
+			hrtimer_cancel (&fd->timer);
+			if (control.period_ms != 0)
+			{
+				spin_lock_irqsave (&fd->lock, flags);
+				fanctrl_start (&fd->fc, control.period_ms);
+				spin_unlock_irqrestore (&fd->lock, flags);
+				fd->period = ms_to_ktime (control.period_ms);
+				hrtimer_start (&fd->timer, fd->period, HRTIMER_MODE_REL);
+			}
+			mutex_unlock (&fanctrl_lock);
+			return 0;
+
+		case GET_FAN_ZONE_STATS:
+			if ( copy_from_user((void*)&stats, (void*)arg, sizeof(fanctrl_zone_stats_t)) )
+				return -EFAULT;
+			if (stats.zone >= FANCTRL_MAX_ZONES)
+				return -EINVAL;
+			spin_lock_irqsave (&fd->lock, flags);
+			fanctrl_get_stats (&fd->fc, stats.zone, &stats, stats.reset);
+			spin_unlock_irqrestore (&fd->lock, flags);
+			stats.dev_id = dev_id;
+			stats.reset = 0;
+			if ( copy_to_user((void*)arg, &stats, sizeof(fanctrl_zone_stats_t)) )
+				return -EFAULT;
+			return 0;
+	}
+	return -EINVAL;
+}
+
+/*
+ * Reads sample[].channel tachs into sample[].value, stamping each with the
+ * time it was read. A tach that can't be read gets -EIO and value 0.
+ */
+static int
+get_tachvalues (struct pwmtach_dev* pdev, sensor_sample_t* sample, int count)
+{
+	unsigned int rpmvalue;
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		rpmvalue = 0;
+		sample[i].source = SENSOR_SOURCE_TACH;
+		sample[i].status = (get_tachvalue (pdev, sample[i].channel, &rpmvalue) == 0) ? 0 : -EIO;
+		sample[i].value = rpmvalue;
+		sample[i].timestamp = ktime_get_ns ();
+	}
+	return 0;
+}
+
+static int
+tach_sampler_read (void *priv, sensor_sample_t* sample, int count)
+{
+	struct pwmtach_dev dev;
+
+	dev.ppwmtach_hal = (struct pwmtach_hal *) priv;
+	return get_tachvalues (&dev, sample, count);
+}
+
 static int 
 get_tachvalue (struct pwmtach_dev* pdev, unsigned int tachnumber, unsigned int* rpmvalue)
 {
 	unsigned int retries = 1; //avoid spinning 2.5 seconds within kernel waiting for timeout 
 
+	mutex_lock (&tach_read_lock);
 	if (pdev->ppwmtach_hal->ppwmtach_hal_ops->trigger_read_fanspeed(tachnumber) < 0) {
+		mutex_unlock (&tach_read_lock);
 		printk("trigger read fan speed failed\n");
 		return -1;
 	}
@@ -509,11 +821,13 @@ get_tachvalue (struct pwmtach_dev* pdev, unsigned int tachnumber, unsigned int*
 	}
 	if (retries == 0)
 	{
+		mutex_unlock (&tach_read_lock);
 		//printk("ran out of retries in gettachvalue(tach %d)...returning -1\n",tachnumber & 0x7F);
 		return -1;
 	}
 
 	*rpmvalue = pdev->ppwmtach_hal->ppwmtach_hal_ops->get_current_speed (tachnumber);
+	mutex_unlock (&tach_read_lock);
 	return 0;
 }
 
@@ -0,0 +1,467 @@
+/*
+ ****************************************************************
+ **                                                            **
+ **    (C)Copyright 2009-2015, American Megatrends Inc.        **
+ **                                                            **
+ **            All Rights Reserved.                            **
+ **                                                            **
+ **        5555 Oakbrook Pkwy Suite 200, Norcross,             **
+ **                                                            **
+ **        Georgia - 30093, USA. Phone-(770)-246-8600.         **
+ **                                                            **
+ ****************************************************************
+ */
+
+/*
+ * Fan control simulator
+ *
+ * Runs fanctrl.c against a thermal model of one CPU cooled by one fan
+ * zone: a heat capacity with a load step, cooled to ambient through a
+ * conductance that grows with the airflow, and an airflow that follows the
+ * duty cycle with the spin up lag of the fan. Temperatures reach the
+ * controller as a sensor reads them, quantized and late.
+ *
+ * The PID zone is run as the driver runs it, ticked by the timer with the
+ * temperatures pushed by the sensor sampler, and as a user space fan loop
+ * would run it, reading and ticking once a second with scheduling jitter.
+ * Each is given the gains tuned for its own period, and the timer has to
+ * beat the loop on overshoot, settling time and tracking error.
+ * The step curve, failsafe, slew limit, configuration checks and statistics
+ * are checked on their own.
+ *
+ * Build and run from pwmtach-src:
+ *   gcc -O2 -Wall -I. -I../helper-src tools/fanctrl_sim.c fanctrl.c -o fanctrl_sim -lm
+ *   ./fanctrl_sim [-v]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include "fanctrl.h"
+
+#define FAIL(fmt, args...) \
+	do { fprintf (stderr, "FAIL %s:%d: " fmt "\n", __FUNCTION__, __LINE__, ##args); exit (1); } while (0)
+
+#define MS		1000000ULL	/* ns */
+#define SETPOINT	70000		/* milli-degrees C */
+
+static int verbose;
+
+/* ------------------------------------------------------------------ */
+/* thermal model */
+
+struct plant
+{
+	double temp;		/* degrees C */
+	double airflow;		/* 0-1 of full speed */
+	double power;		/* W */
+};
+
+#define AMBIENT		25.0
+#define HEAT_CAPACITY	60.0	/* J per degree C */
+#define G_STILL		1.0	/* W per degree C with the fans stopped */
+#define G_FAN		9.0	/* W per degree C added at full speed */
+#define FAN_LAG		3.0	/* s, time constant of the fan speed */
+#define SENSOR_STEP	0.5	/* degrees C per count */
+
+static void plant_init (struct plant *p, double power, int duty)
+{
+	p->power = power;
+	p->airflow = duty / 255.0;
+	p->temp = AMBIENT + power / (G_STILL + G_FAN * p->airflow);
+}
+
+static void plant_step (struct plant *p, int duty, double dt)
+{
+	double g = G_STILL + G_FAN * p->airflow;
+
+	p->airflow += (duty / 255.0 - p->airflow) * dt / FAN_LAG;
+	p->temp += (p->power - g * (p->temp - AMBIENT)) * dt / HEAT_CAPACITY;
+}
+
+static int sensor (const struct plant *p)
+{
+	return (int)(floor (p->temp / SENSOR_STEP) * SENSOR_STEP * 1000);
+}
+
+/* ------------------------------------------------------------------ */
+/* closed loop runs */
+
+struct schedule
+{
+	const char *name;
+	unsigned int tick_ms;	/* controller timer, 0 to tick after every push */
+	unsigned int push_ms;	/* temperatures pushed this often */
+	unsigned int jitter_ms;	/* plus up to this much late */
+	unsigned int delay_ms;	/* age of the reading when it is pushed */
+};
+
+struct result
+{
+	double overshoot;	/* degrees C above the setpoint after the load step */
+	double settle;		/* s from the load step to staying within 1 degree C */
+	double mean_error;	/* degrees C, absolute, over the second half of the load */
+	double release;		/* s from the end of the 600 W load to leaving max_duty */
+	unsigned int duty_changes;
+	unsigned int saturated;
+};
+
+static unsigned int rng = 12345;
+
+static unsigned int jitter (unsigned int max)
+{
+	rng = rng * 1103515245 + 12345;
+	return max ? (rng >> 8) % (max + 1) : 0;
+}
+
+static void pid_zone (fanctrl_zone_config_t *cfg)
+{
+	memset (cfg, 0, sizeof (*cfg));
+	cfg->zone = 0;
+	cfg->mode = FANCTRL_MODE_PID;
+	cfg->num_pwms = 2;
+	cfg->pwm[0] = 0;
+	cfg->pwm[1] = 1;
+	cfg->num_inputs = 2;
+	cfg->input[0] = 0;
+	cfg->input[1] = 1;
+	cfg->min_duty = 50;
+	cfg->max_duty = 255;
+	cfg->failsafe_duty = 255;
+	cfg->stale_ms = 5000;
+	cfg->setpoint = SETPOINT;
+	/* Tuned for the 100 ms timer and 250 ms sampler sweeps */
+	cfg->kp = 60000;
+	cfg->ki = 15000;
+	cfg->kd = 120000;
+}
+
+/* The same zone with the gains tuned for a 1 s loop, higher ones oscillate */
+static void pid_zone_1s (fanctrl_zone_config_t *cfg)
+{
+	pid_zone (cfg);
+	cfg->kp = 45000;
+	cfg->ki = 4000;
+	cfg->kd = 60000;
+}
+
+/*
+ * Idle, a load step, a load the fans can't hold and idle again:
+ *   0-60 s 40 W, 60-240 s 200 W, 240-300 s 600 W, 300-400 s 40 W
+ */
+static double load (double t)
+{
+	if (t < 60)
+		return 40;
+	if (t < 240)
+		return 200;
+	if (t < 300)
+		return 600;
+	return 40;
+}
+
+static void run (const struct schedule *s, const fanctrl_zone_config_t *cfg, struct result *r)
+{
+	static int history [400 * 1000];	/* sensor reading of every ms */
+	struct fanctrl fc;
+	struct plant p;
+	fanctrl_zone_stats_t stats;
+	uint64_t now;
+	unsigned int ms, next_tick, next_push;
+	double t, err, sum = 0;
+	int duty = cfg->min_duty, d, n = 0;
+	int settled_at = -1, released_at = -1;
+
+	memset (&fc, 0, sizeof (fc));
+	memset (r, 0, sizeof (*r));
+	if (fanctrl_configure_zone (&fc, cfg) != 0)
+		FAIL ("%s: zone rejected", s->name);
+	fanctrl_start (&fc, s->tick_ms ? s->tick_ms : s->push_ms);
+	plant_init (&p, load (0), duty);
+
+	next_tick = s->tick_ms;
+	next_push = 0;
+	for (ms = 0; ms < 400 * 1000; ms++) {
+		t = ms / 1000.0;
+		now = (uint64_t)(ms + 1) * MS;
+		p.power = load (t);
+		history [ms] = sensor (&p);
+
+		if (ms == next_push) {
+			int reading = history [ms >= s->delay_ms ? ms - s->delay_ms : 0];
+
+			fanctrl_set_temp (&fc, 0, reading, now);
+			fanctrl_set_temp (&fc, 1, reading - 3000, now);	/* a cooler second CPU */
+			next_push += s->push_ms + jitter (s->jitter_ms);
+			if (s->tick_ms == 0)
+				next_tick = ms;
+		}
+		if (ms == next_tick) {
+			d = fanctrl_tick (&fc, 0, now);
+			if (d < 0)
+				FAIL ("%s: zone off", s->name);
+			duty = d;
+			if (s->tick_ms)
+				next_tick += s->tick_ms;
+		}
+		plant_step (&p, duty, 0.001);
+
+		err = p.temp - SETPOINT / 1000.0;
+		if (t >= 60 && t < 240) {
+			if (err > r->overshoot)
+				r->overshoot = err;
+			if (fabs (err) > 1.0)
+				settled_at = -1;
+			else if (settled_at < 0)
+				settled_at = ms;
+			if (t >= 150) {
+				sum += fabs (err);
+				n++;
+			}
+		}
+		if (t >= 300 && released_at < 0 && duty < cfg->max_duty)
+			released_at = ms;
+		if (verbose && ms % 5000 == 0)
+			printf ("    %-14s %5.0f s %5.0f W  %6.2f C  duty %3d  airflow %3.0f%%\n",
+				s->name, t, p.power, p.temp, duty, p.airflow * 100);
+	}
+
+	fanctrl_get_stats (&fc, 0, &stats, 0);
+	r->settle = settled_at < 0 ? 999 : settled_at / 1000.0 - 60;
+	r->mean_error = sum / n;
+	r->release = released_at < 0 ? 999 : released_at / 1000.0 - 300;
+	r->duty_changes = stats.duty_changes;
+	r->saturated = stats.saturated;
+}
+
+static void report (const char *name, const struct result *r)
+{
+	printf ("  %-22s overshoot %5.2f C  settled %6.1f s  mean error %4.2f C  released %5.1f s  %5u duty changes\n",
+		name, r->overshoot, r->settle, r->mean_error, r->release, r->duty_changes);
+}
+
+static void test_pid (void)
+{
+	/* The driver: 100 ms timer, sampler sweeps every 250 ms */
+	static const struct schedule timer = { "timer", 100, 250, 0, 20 };
+	/* The same with sweeps late by up to 45 ms and readings 50 ms old */
+	static const struct schedule late = { "late sampler", 100, 250, 45, 50 };
+	/* A user space loop: read and set once a second, late by up to 800 ms under load */
+	static const struct schedule loop = { "user space loop", 0, 1000, 800, 20 };
+	const struct schedule *timers [] = { &timer, &late };
+	fanctrl_zone_config_t cfg, cfg_1s;
+	struct result rt, rl;
+	unsigned int i;
+
+	pid_zone (&cfg);
+	pid_zone_1s (&cfg_1s);
+	run (&loop, &cfg_1s, &rl);
+	report ("pid, 1 s user loop", &rl);
+
+	for (i = 0; i < sizeof (timers) / sizeof (timers [0]); i++) {
+		run (timers [i], &cfg, &rt);
+		report (i ? "pid, timer, late" : "pid, 100 ms timer", &rt);
+
+		if (rt.overshoot > 2.0 || rt.settle > 35 || rt.mean_error > 0.15)
+			FAIL ("%s: overshoot %.2f settled %.1f mean error %.2f",
+				timers [i]->name, rt.overshoot, rt.settle, rt.mean_error);
+		/* Conditional integration: no wound up integral to unwind once the load goes */
+		if (rt.release > 2.0)
+			FAIL ("%s: max duty held %.1f s after the load", timers [i]->name, rt.release);
+		if (rt.saturated == 0)
+			FAIL ("600 W never saturated the zone");
+		/* The point of running the loop in the driver */
+		if (rt.overshoot >= rl.overshoot || rt.settle >= rl.settle || rt.mean_error >= rl.mean_error)
+			FAIL ("%s no better than the loop: overshoot %.2f/%.2f settled %.1f/%.1f mean error %.2f/%.2f",
+				timers [i]->name, rt.overshoot, rl.overshoot, rt.settle, rl.settle,
+				rt.mean_error, rl.mean_error);
+	}
+}
+
+/* ------------------------------------------------------------------ */
+/* controller details, with the temperatures set directly */
+
+static uint64_t clock_ns;
+
+static int tick (struct fanctrl *fc, unsigned int zone, unsigned int ms)
+{
+	clock_ns += (uint64_t)ms * MS;
+	return fanctrl_tick (fc, zone, clock_ns);
+}
+
+static void push (struct fanctrl *fc, unsigned int input, int temp)
+{
+	fanctrl_set_temp (fc, input, temp, clock_ns);
+}
+
+static void test_step_curve (void)
+{
+	static const int temps [] = { 30000, 50000, 60000, 59000, 58500, 57900, 72000, 80000, 68500, 50000 };
+	static const int duties [] = {    60,    60,   120,   120,   120,    60,   180,   255,   180,   60 };
+	fanctrl_zone_config_t cfg;
+	struct fanctrl fc;
+	unsigned int i;
+	int d;
+
+	memset (&fc, 0, sizeof (fc));
+	memset (&cfg, 0, sizeof (cfg));
+	cfg.mode = FANCTRL_MODE_STEP;
+	cfg.num_pwms = 1;
+	cfg.pwm[0] = 3;
+	cfg.num_inputs = 1;
+	cfg.input[0] = 7;
+	cfg.min_duty = 60;
+	cfg.max_duty = 255;
+	cfg.failsafe_duty = 200;
+	cfg.stale_ms = 2000;
+	cfg.hysteresis = 2000;
+	cfg.num_steps = 3;
+	cfg.step[0].temp = 60000;
+	cfg.step[0].duty = 120;
+	cfg.step[1].temp = 70000;
+	cfg.step[1].duty = 180;
+	cfg.step[2].temp = 80000;
+	cfg.step[2].duty = 255;
+	if (fanctrl_configure_zone (&fc, &cfg) != 0)
+		FAIL ("step zone rejected");
+	fanctrl_start (&fc, 100);
+
+	for (i = 0; i < sizeof (temps) / sizeof (temps [0]); i++) {
+		push (&fc, 7, temps [i]);
+		d = tick (&fc, 0, 100);
+		if (d != duties [i])
+			FAIL ("%d mC: duty %d, expected %d", temps [i], d, duties [i]);
+	}
+	printf ("  step curve             OK\n");
+}
+
+static void test_failsafe (void)
+{
+	fanctrl_zone_config_t cfg;
+	fanctrl_zone_stats_t stats;
+	struct fanctrl fc;
+	int d, i;
+
+	memset (&fc, 0, sizeof (fc));
+	pid_zone (&cfg);
+	cfg.max_slew = 10;
+	cfg.failsafe_duty = 230;
+	if (fanctrl_configure_zone (&fc, &cfg) != 0)
+		FAIL ("zone rejected");
+	fanctrl_start (&fc, 100);
+
+	/* No input yet */
+	if ((d = tick (&fc, 0, 100)) != 230)
+		FAIL ("duty %d with no input", d);
+
+	/* Cool: slews down from the failsafe duty, 10 per tick */
+	for (i = 1; i <= 5; i++) {
+		push (&fc, 0, 40000);
+		if ((d = tick (&fc, 0, 100)) != 230 - 10 * i)
+			FAIL ("tick %d: duty %d, slew not applied", i, d);
+	}
+	for (i = 0; i < 30; i++) {
+		push (&fc, 0, 40000);
+		d = tick (&fc, 0, 100);
+	}
+	if (d != cfg.min_duty)
+		FAIL ("duty %d, expected min_duty", d);
+
+	/* The pushes stop: failsafe once stale_ms has passed, straight away */
+	for (i = 0; i < 49; i++)
+		if ((d = tick (&fc, 0, 100)) != cfg.min_duty)
+			FAIL ("failsafe after %d ms", (i + 1) * 100);
+	if ((d = tick (&fc, 0, 200)) != 230)
+		FAIL ("duty %d with a stale input", d);
+
+	/* The second input alone keeps the zone out of failsafe */
+	push (&fc, 1, 40000);
+	if ((d = tick (&fc, 0, 100)) != 220)
+		FAIL ("duty %d with one fresh input", d);
+
+	fanctrl_get_stats (&fc, 0, &stats, 1);
+	if (stats.failsafe_ticks != 2 || stats.failsafe || stats.ticks != 87 || stats.mode != FANCTRL_MODE_PID)
+		FAIL ("stats: %u failsafe ticks, failsafe %u, %u ticks", stats.failsafe_ticks, stats.failsafe, stats.ticks);
+	fanctrl_get_stats (&fc, 0, &stats, 0);
+	if (stats.ticks != 0 || stats.duty_sum != 0 || stats.duty != 220)
+		FAIL ("stats not reset");
+	printf ("  failsafe and slew      OK\n");
+}
+
+static void test_configure (void)
+{
+	fanctrl_zone_config_t cfg, other;
+	struct fanctrl fc;
+
+	memset (&fc, 0, sizeof (fc));
+	pid_zone (&cfg);
+	if (fanctrl_configure_zone (&fc, &cfg) != 0)
+		FAIL ("zone 0 rejected");
+	if (fanctrl_pwm_zone (&fc, 1) != 0 || fanctrl_pwm_zone (&fc, 2) != -1)
+		FAIL ("pwm owners");
+
+	/* PWMs belong to one zone */
+	other = cfg;
+	other.zone = 1;
+	if (fanctrl_configure_zone (&fc, &other) != -EBUSY)
+		FAIL ("pwm 0 in two zones");
+	other.pwm[0] = 2;
+	other.pwm[1] = 3;
+	if (fanctrl_configure_zone (&fc, &other) != 0)
+		FAIL ("zone 1 rejected");
+	/* Reconfiguring a zone keeps its own PWMs */
+	if (fanctrl_configure_zone (&fc, &cfg) != 0)
+		FAIL ("zone 0 not reconfigured");
+
+	other.min_duty = 200;
+	other.max_duty = 100;
+	if (fanctrl_configure_zone (&fc, &other) != -EINVAL)
+		FAIL ("min_duty above max_duty");
+	other = cfg;
+	other.input[1] = FANCTRL_MAX_INPUTS;
+	if (fanctrl_configure_zone (&fc, &other) != -EINVAL)
+		FAIL ("input out of range");
+	other = cfg;
+	other.zone = FANCTRL_MAX_ZONES;
+	if (fanctrl_configure_zone (&fc, &other) != -EINVAL)
+		FAIL ("zone out of range");
+	other = cfg;
+	other.mode = FANCTRL_MODE_STEP;
+	other.num_steps = 2;
+	other.step[0].temp = 50000;
+	other.step[1].temp = 50000;
+	if (fanctrl_configure_zone (&fc, &other) != -EINVAL)
+		FAIL ("steps not ascending");
+
+	/* Off releases the PWMs */
+	cfg.mode = FANCTRL_MODE_OFF;
+	if (fanctrl_configure_zone (&fc, &cfg) != 0 || fanctrl_pwm_zone (&fc, 0) != -1)
+		FAIL ("zone 0 not released");
+	if (tick (&fc, 0, 100) != -1)
+		FAIL ("off zone ticked");
+	printf ("  configuration          OK\n");
+}
+
+int main (int argc, char *argv [])
+{
+	int opt;
+
+	while ((opt = getopt (argc, argv, "v")) != -1) {
+		switch (opt) {
+			case 'v': verbose = 1; break;
+			default:
+				fprintf (stderr, "usage: %s [-v]\n", argv [0]);
+				return 2;
+		}
+	}
+
+	test_configure ();
+	test_step_curve ();
+	test_failsafe ();
+	test_pid ();
+	printf ("all tests OK\n");
+	return 0;
+}
@@ -24,6 +24,8 @@ typedef struct
 typedef struct
 {
 	void (*get_snoop_core_data) (struct kfifo ** pcurrent_codes, struct kfifo ** pprevious_codes, int dev_id, int ch_num);
+	/* Called from the interrupt handler for every code written to the port */
+	void (*put_snoop_code) (int dev_id, int ch_num, unsigned char code);
 } snoop_core_funcs_t;
 
 
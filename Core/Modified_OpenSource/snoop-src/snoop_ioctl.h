@@ -13,9 +13,95 @@
 #ifndef __SNOOP_IOCTL_H__
 #define __SNOOP_IOCTL_H__
 
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#endif
+
 #define READ_PREVIOUS_CODES  _IOR('s', 0, int)
 #define READ_CURRENT_CODES   _IOR('s', 1, int)
 #define ENABLE_SNOOP_IRQ     _IOR('s', 2, int)
 #define DISABLE_SNOOP_IRQ    _IOR('s', 3, int)
+#define GET_SNOOP_HISTORY    _IOR('s', 4, int)
+#define SET_SNOOP_READ_POS   _IOW('s', 5, int)
+
+/*
+ * POST code history
+ *
+ * Besides the 512 byte current/previous buffers of READ_CURRENT_CODES and
+ * READ_PREVIOUS_CODES, every code is kept with its time in a per channel
+ * ring of HistorySize codes (module parameter, a power of two).
+ *
+ * read() on the snoop device returns whole snoop_code_t records, starting
+ * with the oldest code still in the ring, and blocks for new codes unless
+ * O_NONBLOCK is set. poll() reports POLLIN while there are unread codes.
+ * Codes overwritten before a reader got to them are skipped and counted in
+ * its dropped count. SET_SNOOP_READ_POS moves the read position to a code
+ * number, e.g. head of GET_SNOOP_HISTORY to read new codes only.
+ *
+ * mmap() of the device maps the ring read only, see snoop_history_code().
+ */
+
+typedef struct
+{
+	uint64_t timestamp;	/* CLOCK_MONOTONIC us at which the code was written */
+	uint32_t seq;		/* code number */
+	uint16_t boot;		/* host resets seen before the code */
+	uint8_t  code;
+	uint8_t  reserved;
+} snoop_code_t;
+
+#define SNOOP_HISTORY_MAGIC	0x534E4F50	/* "SNOP" */
+#define SNOOP_HISTORY_VERSION	1
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;		/* codes in the ring, a power of two */
+	uint32_t head;		/* codes written, code n is in code[n % size] */
+	uint32_t boot;		/* host resets seen */
+	uint32_t boot_start;	/* number of the first code since the last host reset */
+	uint32_t dropped;	/* codes overwritten before a reader got them, all readers */
+	uint32_t reserved;
+	snoop_code_t code[0];
+} snoop_history_t;
+
+/* GET_SNOOP_HISTORY */
+typedef struct
+{
+	uint32_t size;
+	uint32_t head;
+	uint32_t boot;
+	uint32_t boot_start;
+	uint32_t dropped;
+	uint32_t read_pos;	/* next code read() returns */
+	uint32_t read_dropped;	/* codes this reader lost */
+} snoop_history_info_t;
+
+#ifndef __KERNEL__
+
+/*
+ * Copies code n out of the mapped ring. Returns 0, or -1 when code n has
+ * not been written yet or was overwritten.
+ */
+static inline int
+snoop_history_code (const volatile snoop_history_t *ring, uint32_t n, snoop_code_t *out)
+{
+	const volatile snoop_code_t *c = &ring->code[n & (ring->size - 1)];
+
+	if ((uint32_t)(ring->head - n - 1) >= ring->size)
+		return -1;
+	__sync_synchronize ();
+	if (c->seq != n)
+		return -1;
+	__sync_synchronize ();
+	*out = *(const snoop_code_t *)c;
+	__sync_synchronize ();
+	return (c->seq == n && out->seq == n) ? 0 : -1;
+}
+
+#endif
 
 #endif
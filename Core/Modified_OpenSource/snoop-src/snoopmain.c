@@ -27,6 +27,12 @@
 #include <linux/version.h>
 #include <linux/cdev.h>
 #include <linux/kfifo.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/uaccess.h>
 
 #include "snoop.h"
 #include "snoop_ioctl.h"
@@ -59,6 +65,21 @@ MODULE_LICENSE ( DRIVER_LICENSE );
 #define SNOOP_MAX_DEVICES	255
 #define SNOOP_DEV_NAME		"snoop"
 #define SNOOP_BUFSIZE		512
+#define SNOOP_HISTORY_MAX	(1 << 20)
+#define SNOOP_READ_BATCH	16
+
+/* Codes kept per channel with their time, rounded up to a power of two */
+static int HistorySize = 8192;
+module_param (HistorySize, int, S_IRUGO);
+MODULE_PARM_DESC (HistorySize, "POST codes kept per channel");
+
+struct snoop_history
+{
+	snoop_history_t *ring;		/* written by the interrupt handler, mapped by readers */
+	unsigned long ring_size;
+	wait_queue_head_t wait;
+	atomic_t dropped;
+};
 
 struct snoop_hal
 {
@@ -70,6 +91,7 @@ struct snoop_hal
     struct kfifo* current_codes[SNOOP_MAX_DEVICES];
     struct kfifo* previous_codes[SNOOP_MAX_DEVICES];
 #endif
+    struct snoop_history history[SNOOP_MAX_DEVICES];
     snoop_hal_operations_t* psnoop_hal_ops;
 };
 
@@ -77,6 +99,9 @@ struct snoop_dev
 {
 	struct snoop_hal* psnoop_hal;
 	unsigned char instance_num;
+	struct mutex read_lock;
+	u32 read_pos;			/* next code read() returns */
+	u32 read_dropped;
 };
 
 static int __init snoop_init(void);
@@ -89,6 +114,9 @@ static long snoop_ioctlUnlocked(struct file *file, unsigned int cmd, unsigned lo
 static int snoop_ioctl (struct inode *inode, struct file *file, unsigned int cmd, unsigned long arg);
 #endif
 static int snoop_release (struct inode *inode, struct file *file);
+static ssize_t snoop_read (struct file *file, char __user *buf, size_t count, loff_t *ppos);
+static unsigned int snoop_poll (struct file *file, poll_table *wait);
+static int snoop_mmap (struct file *file, struct vm_area_struct *vma);
 
 static int handle_snoop_reset (void);
 static inline void snoop_kfifo_get (struct kfifo *fifo, unsigned char *buffer, unsigned int len);
@@ -98,6 +126,9 @@ static struct file_operations snoop_fops =
 	owner:		THIS_MODULE,
 	open:		snoop_open,
 	release:	snoop_release,
+	read:		snoop_read,
+	poll:		snoop_poll,
+	mmap:		snoop_mmap,
 #ifdef USE_UNLOCKED_IOCTL
 	unlocked_ioctl:    snoop_ioctlUnlocked,
 #else 
@@ -113,6 +144,51 @@ static char banner[] __initdata = KERN_INFO "Snoop Common Driver, (c) 2009-2015
 
 /*********************************************************************************************/
 
+static int
+snoop_history_alloc (struct snoop_history *hist)
+{
+	unsigned int size = roundup_pow_of_two (clamp (HistorySize, SNOOP_BUFSIZE, SNOOP_HISTORY_MAX));
+
+	hist->ring_size = PAGE_ALIGN (sizeof (snoop_history_t) + size * sizeof (snoop_code_t));
+	hist->ring = vmalloc_user (hist->ring_size);
+	if (!hist->ring)
+		return -ENOMEM;
+
+	hist->ring->magic = SNOOP_HISTORY_MAGIC;
+	hist->ring->version = SNOOP_HISTORY_VERSION;
+	hist->ring->size = size;
+	init_waitqueue_head (&hist->wait);
+	atomic_set (&hist->dropped, 0);
+	return 0;
+}
+
+/* Number of the oldest code still in the ring */
+static u32
+snoop_history_oldest (snoop_history_t *ring)
+{
+	u32 head = READ_ONCE (ring->head);
+
+	return (head > ring->size) ? head - ring->size : 0;
+}
+
+static void
+snoop_free_instances (struct snoop_hal *psnoop_hal, int num_instances)
+{
+	int i;
+
+	for (i = 0; i < num_instances; i++)
+	{
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,4,11))
+		kfifo_free (&psnoop_hal->previous_codes[i]);
+		kfifo_free (&psnoop_hal->current_codes[i]);
+#else
+		kfifo_free (psnoop_hal->previous_codes[i]);
+		kfifo_free (psnoop_hal->current_codes[i]);
+#endif
+		vfree (psnoop_hal->history[i].ring);
+	}
+}
+
 static void __exit
 snoop_exit(void)
 {
@@ -148,6 +224,7 @@ register_snoop_hal_module (unsigned char num_instances, void *phal_ops, void **p
         if (!psnoop_hal->current_codes[i])
 #endif
         {
+            snoop_free_instances (psnoop_hal, i);
             kfree (psnoop_hal);
             return -ENOMEM;
         }
@@ -162,10 +239,19 @@ register_snoop_hal_module (unsigned char num_instances, void *phal_ops, void **p
         {
 			kfifo_free (psnoop_hal->current_codes[i]);
 #endif
+			snoop_free_instances (psnoop_hal, i);
 			kfree (psnoop_hal);
             return -ENOMEM;
         }
 
+		if ( snoop_history_alloc (&psnoop_hal->history[i]) )
+		{
+			psnoop_hal->history[i].ring = NULL;
+			snoop_free_instances (psnoop_hal, i + 1);
+			kfree (psnoop_hal);
+			return -ENOMEM;
+		}
+
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,4,11))
 		psnoop_hal->current_codes[i].kfifo.mask = 0;
 		psnoop_hal->previous_codes[i].kfifo.mask = 0;
@@ -191,20 +277,11 @@ int
 unregister_snoop_hal_module (void *phw_data)
 {
 	struct snoop_hal *psnoop_hal = (struct snoop_hal *)phw_data;
-    int i=0;
 
 	dbgprint ("unregister hal addr : %p\n", psnoop_hal);
 
 	uninstall_reset_handler (handle_snoop_reset);
-    for(i=0;i<psnoop_hal->num_instances;i++) {
-#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,4,11))
-		kfifo_free (&psnoop_hal->previous_codes[i]);
-		kfifo_free (&psnoop_hal->current_codes[i]);
-#else
-		kfifo_free (psnoop_hal->previous_codes[i]);
-		kfifo_free (psnoop_hal->current_codes[i]);
-#endif
-	}
+	snoop_free_instances (psnoop_hal, psnoop_hal->num_instances);
 	kfree (psnoop_hal);
 	return 0;
 }
@@ -236,6 +313,10 @@ snoop_open (struct inode * inode, struct file * file)
 
 	pdev->psnoop_hal = psnoop_hal;
 	pdev->instance_num = snoop_hw_info.inst_num;
+	mutex_init (&pdev->read_lock);
+	pdev->read_dropped = 0;
+	/* Start with the oldest code still in the ring */
+	pdev->read_pos = snoop_history_oldest (psnoop_hal->history[pdev->instance_num].ring);
 	file->private_data = pdev;
 	dbgprint ("%d, snoop_open priv data addr : %p\n", minor, &file->private_data);
 	return nonseekable_open (inode, file);
@@ -315,6 +396,44 @@ snoop_ioctlUnlocked (struct file *file, unsigned int cmd, unsigned long arg)
 			}
 			break;
 			
+		case GET_SNOOP_HISTORY:
+		{
+			snoop_history_t *ring = pdev->psnoop_hal->history[pdev->instance_num].ring;
+			snoop_history_info_t info;
+
+			info.size = ring->size;
+			info.head = READ_ONCE (ring->head);
+			info.boot = ring->boot;
+			info.boot_start = ring->boot_start;
+			info.dropped = ring->dropped;
+			mutex_lock (&pdev->read_lock);
+			info.read_pos = pdev->read_pos;
+			info.read_dropped = pdev->read_dropped;
+			mutex_unlock (&pdev->read_lock);
+			if (copy_to_user ((void *)arg, &info, sizeof (info)))
+				return -EFAULT;
+			return 0;
+		}
+
+		case SET_SNOOP_READ_POS:
+		{
+			snoop_history_t *ring = pdev->psnoop_hal->history[pdev->instance_num].ring;
+			u32 pos, head;
+
+			if (get_user (pos, (u32 __user *)arg))
+				return -EFAULT;
+			head = READ_ONCE (ring->head);
+			/* Past the head waits for the next code, before the oldest starts there */
+			if ((s32)(pos - head) > 0)
+				pos = head;
+			else if (head - pos > head - snoop_history_oldest (ring))
+				pos = snoop_history_oldest (ring);
+			mutex_lock (&pdev->read_lock);
+			pdev->read_pos = pos;
+			mutex_unlock (&pdev->read_lock);
+			return 0;
+		}
+
 		//Allow user space programs to Enable/Disable the snoop interrupts
 		case ENABLE_SNOOP_IRQ:
 			pdev->psnoop_hal->psnoop_hal_ops->enable_snoop_interrupt((int)arg);
@@ -374,6 +493,8 @@ handle_snoop_reset (void)
             psnoop_hal->current_codes[j]->in = 0;
             psnoop_hal->current_codes[j]->out = 0;
 #endif
+            psnoop_hal->history[j].ring->boot++;
+            psnoop_hal->history[j].ring->boot_start = psnoop_hal->history[j].ring->head;
             psnoop_hal->psnoop_hal_ops->reset_snoop(j);
         }
 	}
@@ -397,6 +518,200 @@ get_snoop_core_data ( struct kfifo ** pcurrent_codes, struct kfifo ** pprevious_
 }
 
 
+/* Appends a code to the 512 byte buffer of READ_CURRENT_CODES, dropping the oldest when full */
+static void
+snoop_kfifo_put (struct kfifo *fifo, unsigned char code)
+{
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,4,11))
+	((unsigned char *)fifo->kfifo.data)[fifo->kfifo.in] = code;
+	fifo->kfifo.in = (fifo->kfifo.in + 1) % SNOOP_BUFSIZE;
+
+	if (fifo->kfifo.mask == (SNOOP_BUFSIZE - 1))
+	{
+		fifo->kfifo.mask++;
+		fifo->kfifo.out = (fifo->kfifo.out + 1) % SNOOP_BUFSIZE;
+	}
+	else if (fifo->kfifo.mask == SNOOP_BUFSIZE)
+		fifo->kfifo.out = (fifo->kfifo.out + 1) % SNOOP_BUFSIZE;
+	else
+		fifo->kfifo.mask++;
+#else
+	fifo->buffer[fifo->in] = code;
+	fifo->in = (fifo->in + 1) % SNOOP_BUFSIZE;
+
+	if (fifo->size == (SNOOP_BUFSIZE - 1))
+	{
+		fifo->size++;
+		fifo->out = (fifo->out + 1) % SNOOP_BUFSIZE;
+	}
+	else if (fifo->size == SNOOP_BUFSIZE)
+		fifo->out = (fifo->out + 1) % SNOOP_BUFSIZE;
+	else
+		fifo->size++;
+#endif
+}
+
+/*
+ * The interrupt handler is the only writer of a ring. A slot is marked
+ * invalid before it is rewritten and gets its code number back once the
+ * code is in, so readers that find any other number in it know the code
+ * they wanted was overwritten.
+ */
+static void
+snoop_history_put (struct snoop_history *hist, unsigned char code)
+{
+	snoop_history_t *ring = hist->ring;
+	u32 n = ring->head;
+	snoop_code_t *c = &ring->code[n & (ring->size - 1)];
+
+	c->seq = ~n;
+	smp_wmb ();
+	c->timestamp = ktime_to_us (ktime_get ());
+	c->boot = ring->boot;
+	c->code = code;
+	smp_wmb ();
+	c->seq = n;
+	smp_wmb ();
+	ring->head = n + 1;
+
+	wake_up_interruptible (&hist->wait);
+}
+
+/*
+ * Copies the code at *pos for a reader and moves *pos on. Codes the writer
+ * got to first are skipped and added to *dropped. Returns 0 at the head.
+ */
+static int
+snoop_history_get (struct snoop_history *hist, u32 *pos, u32 *dropped, snoop_code_t *out)
+{
+	snoop_history_t *ring = hist->ring;
+	const snoop_code_t *c;
+	u32 oldest, lost = 0;
+	int got = 0;
+
+	while (!got && *pos != READ_ONCE (ring->head))
+	{
+		smp_rmb ();
+		oldest = snoop_history_oldest (ring);
+		if ((s32)(*pos - oldest) < 0)
+		{
+			lost += oldest - *pos;
+			*pos = oldest;
+		}
+
+		c = &ring->code[*pos & (ring->size - 1)];
+		if (READ_ONCE (c->seq) == *pos)
+		{
+			smp_rmb ();
+			*out = *c;
+			smp_rmb ();
+			got = (READ_ONCE (c->seq) == *pos);
+		}
+		if (!got)
+			lost++;
+		(*pos)++;
+	}
+
+	if (lost)
+	{
+		*dropped += lost;
+		ring->dropped = atomic_add_return (lost, &hist->dropped);
+	}
+	return got;
+}
+
+void
+put_snoop_code (int dev_id, int ch_num, unsigned char code)
+{
+	struct snoop_hal *psnoop_hal = hw_intr (EDEV_TYPE_SNOOP, dev_id);
+
+	if (!psnoop_hal || ch_num >= psnoop_hal->num_instances)
+		return;
+
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,4,11))
+	snoop_kfifo_put (&psnoop_hal->current_codes[ch_num], code);
+#else
+	snoop_kfifo_put (psnoop_hal->current_codes[ch_num], code);
+#endif
+	snoop_history_put (&psnoop_hal->history[ch_num], code);
+}
+
+static ssize_t
+snoop_read (struct file *file, char __user *buf, size_t count, loff_t *ppos)
+{
+	struct snoop_dev *pdev = (struct snoop_dev*) file->private_data;
+	struct snoop_history *hist = &pdev->psnoop_hal->history[pdev->instance_num];
+	snoop_code_t codes[SNOOP_READ_BATCH];
+	size_t max = count / sizeof (snoop_code_t);
+	size_t done = 0;
+	int n;
+
+	if (max == 0)
+		return -EINVAL;
+
+	if (mutex_lock_interruptible (&pdev->read_lock))
+		return -ERESTARTSYS;
+
+	while (done < max)
+	{
+		for (n = 0; n < SNOOP_READ_BATCH && done + n < max; n++)
+		{
+			if (!snoop_history_get (hist, &pdev->read_pos, &pdev->read_dropped, &codes[n]))
+				break;
+		}
+		if (n > 0)
+		{
+			if (copy_to_user (buf + done * sizeof (snoop_code_t), codes, n * sizeof (snoop_code_t)))
+			{
+				mutex_unlock (&pdev->read_lock);
+				return done ? done * sizeof (snoop_code_t) : -EFAULT;
+			}
+			done += n;
+			continue;
+		}
+		if (done > 0)
+			break;
+
+		/* Nothing to return yet, also when every code up to the head was overwritten */
+		mutex_unlock (&pdev->read_lock);
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+		if (wait_event_interruptible (hist->wait, pdev->read_pos != READ_ONCE (hist->ring->head)))
+			return -ERESTARTSYS;
+		if (mutex_lock_interruptible (&pdev->read_lock))
+			return -ERESTARTSYS;
+	}
+	mutex_unlock (&pdev->read_lock);
+
+	return done * sizeof (snoop_code_t);
+}
+
+static unsigned int
+snoop_poll (struct file *file, poll_table *wait)
+{
+	struct snoop_dev *pdev = (struct snoop_dev*) file->private_data;
+	struct snoop_history *hist = &pdev->psnoop_hal->history[pdev->instance_num];
+
+	poll_wait (file, &hist->wait, wait);
+	if (pdev->read_pos != READ_ONCE (hist->ring->head))
+		return POLLIN | POLLRDNORM;
+	return 0;
+}
+
+static int
+snoop_mmap (struct file *file, struct vm_area_struct *vma)
+{
+	struct snoop_dev *pdev = (struct snoop_dev*) file->private_data;
+
+	/* The ring is written by the interrupt handler only */
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_vmalloc_range (vma, pdev->psnoop_hal->history[pdev->instance_num].ring, vma->vm_pgoff);
+}
+
+
 static void
 snoop_kfifo_get (struct kfifo *fifo, unsigned char *buffer, unsigned int length)
 {
@@ -427,6 +742,7 @@ snoop_kfifo_get (struct kfifo *fifo, unsigned char *buffer, unsigned int length)
 
 static snoop_core_funcs_t snoop_core_funcs = {
 	.get_snoop_core_data = get_snoop_core_data,
+	.put_snoop_code = put_snoop_code,
 };
 
 static core_hal_t snoop_core_hal = {
@@ -60,9 +60,6 @@ static snoop_core_funcs_t *snoop_core_ops;
 static int ast_snoop_hal_id;
 static int snoop_irq;
 
-struct kfifo *cur_codes[AST_SNOOP_PORT_NUM];
-struct kfifo *pre_codes[AST_SNOOP_PORT_NUM];
-
 inline uint32_t ast_snoop_read_reg(int ch_num, uint32_t reg)
 {
 	return ioread32((void * __iomem)snoop_as_io_base[ch_num] + reg);
@@ -243,40 +240,8 @@ static irqreturn_t ast_snoop_irq_handler(int irq, void *dev_id)
 		/* read port data */
 		data = (uint8_t) ast_snoop_read_data(ch);
 
-		/* put data into FIFO in snoop core */
-#if (LINUX_VERSION_CODE >=  KERNEL_VERSION(3,4,11))
-        memcpy (cur_codes[ch]->kfifo.data+cur_codes[ch]->kfifo.in,(void *)&data,1);
-
-        cur_codes[ch]->kfifo.in = (cur_codes[ch]->kfifo.in + 1) % 512;
-
-
-        if ( cur_codes[ch]->kfifo.mask == (512-1))
-        {
-            cur_codes[ch]->kfifo.mask++;
-            cur_codes[ch]->kfifo.out = (cur_codes[ch]->kfifo.out + 1) % 512;
-
-        }
-        else if ( cur_codes[ch]->kfifo.mask == 512)
-            cur_codes[ch]->kfifo.out = (cur_codes[ch]->kfifo.out + 1) % 512;
-        else
-            cur_codes[ch]->kfifo.mask++;
-#else
-		cur_codes[ch]->buffer[ cur_codes[ch]->in ] = data;
-
-        cur_codes[ch]->in = (cur_codes[ch]->in + 1) % 512;
-
-
-        if ( cur_codes[ch]->size == (512-1))
-        {
-            cur_codes[ch]->size++;
-            cur_codes[ch]->out = (cur_codes[ch]->out + 1) % 512;
-
-        }
-        else if ( cur_codes[ch]->size == 512)
-            cur_codes[ch]->out = (cur_codes[ch]->out + 1) % 512;
-        else
-            cur_codes[ch]->size ++;
-#endif
+		/* hand the code to the snoop core */
+		snoop_core_ops->put_snoop_code(ast_snoop_hal_id, ch, data);
 
 		return IRQ_HANDLED;
 	}
@@ -365,7 +330,6 @@ static int ast_snoop_module_init(void)
             goto out_register_hal;
         }
 
-        snoop_core_ops->get_snoop_core_data(&cur_codes[ch], &pre_codes[ch], ast_snoop_hal_id, ch);
         ast_snoop_init_hw(ch);
     }
 
@@ -10,6 +10,8 @@
  **                                                            **
 ****************************************************************/
 
+#include <linux/ktime.h>
+#include <linux/math64.h>
 #include "header.h"
 #include "coreusb.h"
 #include "descriptors.h"
@@ -38,6 +40,24 @@ static int  BotInquiry 		   (uint8 DevNo, uint8 ifnum, uint8 epnum, uint32 *Rema
 static int  BotSense		   (uint8 DevNo, uint8 ifnum, uint8 epnum, uint32 *RemainLen);
 static void	BotGetScsiErrorCode(uint8 DevNo, uint8 ifnum, uint8 *Key, uint8 *Code, uint8 *CodeQ);
 
+/* Folds a transfer into the rate window, which is closed about once a second */
+static void
+BotAccount(BOT_IF_DATA *MassData, uint32 Bytes)
+{
+	BOT_STATS *Stats = &MassData->Stats;
+	unsigned long Elapsed = jiffies - Stats->WindowStart;
+
+	Stats->WindowBytes += Bytes;
+	if (Elapsed < HZ)
+		return;
+
+	Stats->RateKBps = (uint32)div_u64(Stats->WindowBytes * HZ, Elapsed * 1024);
+	if (Stats->RateKBps > Stats->PeakKBps)
+		Stats->PeakKBps = Stats->RateKBps;
+	Stats->WindowStart 	= jiffies;
+	Stats->WindowBytes 	= 0;
+}
+
 
 static int IsCDROM(uint8 DevNo,uint8 ifnum,uint8 LunNo )
 {
@@ -227,6 +247,14 @@ BotSendCSW(uint8 DevNo, uint8 ifnum,uint32 Tag,uint8 status,uint32 remain)
 		}
 	}
 	
+	MassData =(BOT_IF_DATA *)GetInterfaceData(DevNo,ifnum);
+	if (MassData != NULL)
+	{
+		MassData->Stats.Commands++;
+		if (status != CSW_PASSED)
+			MassData->Stats.Failed++;
+	}
+
 	/* Form the CSW packet*/	
 	csw.dCSWSignature 	= usb_long(CSW_SIGNATURE);
 	csw.dCSWDataResidue	= usb_long(remain);	
@@ -250,13 +278,24 @@ int
 BotSendData(uint8 DevNo, uint8 ifnum, uint8 *DataPkt, uint32 SendSize, uint32 *RemainLen)
 { 
 	uint8 epDataIn;
+	BOT_IF_DATA *MassData;
+	ktime_t Start;
 	
 	/* Get the Endpoint to be used for Data In (Transfer to HOST) */	
 	epDataIn = GetDataInEp(DevNo,ifnum);	
 
 	/* Send the Packet */		
+	Start = ktime_get();
 	if (UsbWriteData(DevNo,epDataIn,DataPkt,SendSize,NO_ZERO_LEN_PKT) != 0)
 			return 1;
+
+	MassData =(BOT_IF_DATA *)GetInterfaceData(DevNo,ifnum);
+	if (MassData != NULL)
+	{
+		MassData->Stats.BytesIn += SendSize;
+		MassData->Stats.SendUs 	+= ktime_us_delta(ktime_get(), Start);
+		BotAccount(MassData, SendSize);
+	}
 			
 	/*Compute Remaining Length */
 	if (*RemainLen > SendSize)
@@ -646,6 +685,13 @@ BotProcessHandler(uint8 DevNo, uint8 ifnum)
 	
 	/* Get the length to be transfered */
 	DataTransferLen=usb_long(cbw->dCBWDataTransferLength);
+
+	/* Data from the host has been collected by BotRxHandler() by now */
+	if (!(cbw->bmCBWFlags & 0x80) && DataTransferLen)
+	{
+		MassData->Stats.BytesOut += MassData->ScsiDataLen;
+		BotAccount(MassData, MassData->ScsiDataLen);
+	}
 	
 	/* Switch according to SCSI Opcode */
 	switch (ScsiPkt->OpCode)
@@ -26,7 +26,25 @@
 
 /* Maximum SCSI Data that can be communicated */
 /*This should match CD_MAX_READ_SIZE and HD_MAX_READ_SIZE in apphead.h (cdserver/hdserver)*/
-#define MAX_SCSI_DATA 	(64*2048)				
+#define MAX_SCSI_DATA 	(64*2048)
+
+/* Transfer statistics of a Bulk Only interface, shown in /proc/ractrends/usbe/bot */
+typedef struct
+{
+	uint32	Commands;				/* CSWs sent */
+	uint32	Failed;					/* CSWs sent with a status other than passed */
+	uint64	BytesIn;				/* Device to host */
+	uint64	BytesOut;				/* Host to device */
+	uint64	SendUs;					/* Time spent in BotSendData() */
+	unsigned long WindowStart;		/* jiffies when the current rate window opened */
+	uint64	WindowBytes;
+	uint32	RateKBps;				/* Both directions, over the last closed window */
+	uint32	PeakKBps;
+	uint32	QueueDepth;				/* Read-ahead responses queued by iUSB */
+	uint32	MaxQueueDepth;
+	uint32	QueueHits;				/* READs answered from the read-ahead queue */
+	uint32	QueueDrops;				/* Read-ahead responses discarded unused */
+} BOT_STATS;
 
 typedef struct
 {
@@ -45,6 +63,7 @@ typedef struct
 #endif
 	uint32	ScsiDataOutLen;
 	uint32	volatile LastSeqNo;
+	BOT_STATS Stats;
 } BOT_IF_DATA;
 
 #endif /* __BOT_IF_H__ */
@@ -45,6 +45,7 @@ static ssize_t UsbDriverRead  (struct file *, char *, size_t, loff_t *);
 static ssize_t UsbDriverWrite(struct file * file , const char __user *buf, size_t count, loff_t *ppos);
 static int 	   UsbDriverOpen (struct inode *inode, struct file *file);
 static int	   UsbDriverRelease (struct inode *inode, struct file *file);
+static int	   UsbDriverMmap (struct file *file, struct vm_area_struct *vma);
 #ifdef CONFIG_SPX_FEATURE_POWER_CONSUMPTION_SUPPORT
 extern int VirtualDeviceStatus;
 #endif
@@ -61,6 +62,7 @@ struct file_operations usb_fops =
 #endif
 	.open   =	UsbDriverOpen,
 	.release =  UsbDriverRelease,
+	.mmap	=	UsbDriverMmap,
 };
 
 /*************************** Driver Entry Point *****************************/
@@ -108,6 +110,21 @@ UsbDriverRelease (struct inode *inode, struct file *file)
 	return 0;
 }
 
+/* The page offset selects what is mapped, see USB_CDROM_RING_PGOFF */
+static int
+UsbDriverMmap (struct file *file, struct vm_area_struct *vma)
+{
+	int RetVal;
+	int DevNo;
+
+	for (DevNo = 0; DevNo < MAX_USB_HW; DevNo++)
+	{
+		if (!DevInfo[DevNo].UsbCoreDev.DevUsbMmap) continue;
+		if (0 == DevInfo[DevNo].UsbCoreDev.DevUsbMmap (vma->vm_pgoff, vma, &RetVal))
+			return RetVal;
+	}
+	return -EINVAL;
+}
 
 /******************* Driver IOCTL Entry Point ************************/
 static 
@@ -256,6 +256,40 @@ typedef struct
 #define READ_DEVICE		0x01
 #define WRITE_DEVICE	0x02
 
+/************* Virtual Media Response Ring shared with the Media Server *************/
+/*
+   The ring of an instance is mmap'd from the usb device at USB_CDROM_RING_PGOFF or
+   USB_HDISK_RING_PGOFF. It starts with IUSB_RING_HEADER and holds NumSlots slots of
+   SlotSize bytes, each an IUSB_SCSI_PACKET followed by its data. A slot the kernel
+   reports as IUSB_SLOT_FREE belongs to the server, which builds a response in it and
+   passes it with USB_xxx_RES_SLOT (answer the pending request) or USB_xxx_QUEUE_SLOT
+   (a read-ahead READ(10) response, sent when the host asks for exactly that range).
+*/
+#define IUSB_RING_MAGIC		0x474E5249	/* "IRNG" */
+#define IUSB_RING_SLOTS		4
+
+#define IUSB_SLOT_FREE		0x00		/* Owned by the server */
+#define IUSB_SLOT_QUEUED	0x01		/* Read-ahead waiting for a matching READ(10) */
+#define IUSB_SLOT_BUSY		0x02		/* Being sent to the host */
+
+/* USB_xxx_REQ returns this instead of a request when only queued slots were freed */
+#define IUSB_RING_REFILL	1
+
+typedef struct
+{
+	uint32	Magic;
+	uint32	NumSlots;
+	uint32	SlotSize;
+	uint32	SlotOffset;						/* Offset of the first slot in the ring */
+	uint8	volatile SlotState[IUSB_RING_SLOTS];	/* Copy of the kernel's slot states, writes are ignored */
+} PACKED IUSB_RING_HEADER;
+
+typedef struct
+{
+	IUSB_HEADER	Header;						/* Key and Instance as in the request */
+	uint8	Slot;
+} PACKED IUSB_RING_SLOT_REQ;
+
 
 
 
@@ -24,6 +24,7 @@ TDBG_DECLARE_DBGVAR(usbe);
 
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(3,4,11))
 struct proc_info *usbproc;
+struct proc_info *botproc;
 #endif
 
 static int 	usbe_notify_sys(struct notifier_block *this, unsigned long code, void *unused);
@@ -69,6 +70,10 @@ init_module(void)
 		usbproc =
 #endif
 		AddProcEntry(moduledir,"status",ReadUsbeStatus,NULL,NULL);
+#if (LINUX_VERSION_CODE > KERNEL_VERSION(3,4,11))
+		botproc =
+#endif
+		AddProcEntry(moduledir,"bot",ReadUsbeBotStats,NULL,NULL);
  		my_sys = AddSysctlTable("usbe",&usbectlTable[0]);
 	}
 	return rc;
@@ -83,9 +88,14 @@ cleanup_module(void)
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(3,4,11))
 	if (usbproc)
 		RemoveProcEntry(usbproc);
+	if (botproc)
+		RemoveProcEntry(botproc);
 #else
 	if (moduledir)
+	{
 		RemoveProcEntry(moduledir,"status");
+		RemoveProcEntry(moduledir,"bot");
+	}
 #endif
 	remove_proc_entry("usbe",rootdir);
 	if (my_sys) RemoveSysctlTable(my_sys);
@@ -12,6 +12,7 @@
 
 #include <linux/uaccess.h>
 #include <linux/slab.h>
+#include <linux/math64.h>
 #include "header.h"
 #include "descriptors.h"
 #include "arch.h"
@@ -134,3 +135,77 @@ ReadUsbeStatus(struct file *file,  char __user *inbuf, size_t count, loff_t *off
 }
 
 
+
+int
+ReadUsbeBotStats(struct file *file,  char __user *inbuf, size_t count, loff_t *offset)
+{
+	int len=0;
+	int DevNo;
+	int NumInterfaces;
+	uint8 InterfaceNum;
+	uint8 CfgIndex;
+	USB_INTERFACE_DESC *IfaceDesc;
+	BOT_IF_DATA *MassData;
+	BOT_STATS *Stats;
+	uint32 RateKBps;
+	uint32 SendKBps;
+	char *buf;
+
+	if (*offset != 0)
+		return 0;
+
+	buf=kmalloc(PAGE_SIZE,GFP_KERNEL);
+	if (buf == NULL)
+	{
+		return -ENOMEM;
+	}
+
+	for (DevNo = 0; DevNo < MAX_USB_HW; DevNo++)
+	{
+		if (!DevInfo[DevNo].Valid) continue;
+		CfgIndex = DevInfo[DevNo].CfgIndex;
+		if (CfgIndex == 0) continue;
+		NumInterfaces = GetNumInterfaces(DevNo, CfgIndex);
+		for (InterfaceNum = 0; InterfaceNum < NumInterfaces; InterfaceNum++)
+		{
+			IfaceDesc = GetInterfaceDesc(DevNo, CfgIndex, InterfaceNum);
+			if ((IfaceDesc == NULL) || (IfaceDesc->bInterfaceClass != MASS_INTERFACE) ||
+				(IfaceDesc->bInterfaceProtocol != MASS_BULK_ONLY_PROTOCOL))
+				continue;
+			MassData = (BOT_IF_DATA *)GetInterfaceData(DevNo, InterfaceNum);
+			if (MassData == NULL) continue;
+			Stats = &MassData->Stats;
+
+			/* A window that has not been closed for a while means the interface is idle */
+			RateKBps = Stats->RateKBps;
+			if (time_after(jiffies, Stats->WindowStart + 2*HZ))
+				RateKBps = 0;
+			SendKBps = 0;
+			if (Stats->SendUs)
+				SendKBps = (uint32)div64_u64(Stats->BytesIn * 1000000, Stats->SendUs * 1024);
+
+			len += sprintf(buf+len,"USB Device %d Interface %d\n", DevNo+1, InterfaceNum+1);
+			len += sprintf(buf+len,"\tCommands = %u (%u failed)\n", Stats->Commands, Stats->Failed);
+			len += sprintf(buf+len,"\tBytes to host = %llu, from host = %llu\n",
+							(unsigned long long)Stats->BytesIn, (unsigned long long)Stats->BytesOut);
+			len += sprintf(buf+len,"\tRate = %u.%02u MB/s (peak %u.%02u MB/s)\n",
+							RateKBps / 1024, (RateKBps % 1024) * 100 / 1024,
+							Stats->PeakKBps / 1024, (Stats->PeakKBps % 1024) * 100 / 1024);
+			len += sprintf(buf+len,"\tBulk IN rate while sending = %u.%02u MB/s\n",
+							SendKBps / 1024, (SendKBps % 1024) * 100 / 1024);
+			len += sprintf(buf+len,"\tRead-ahead queue depth = %u (max %u), hits = %u, drops = %u\n",
+							Stats->QueueDepth, Stats->MaxQueueDepth, Stats->QueueHits, Stats->QueueDrops);
+		}
+	}
+
+ 	len = (len > count)? count:len;
+    if (copy_to_user(inbuf,buf,len))
+    {
+            kfree(buf);
+            return -EFAULT;
+    }
+
+    *offset+=len;
+    kfree(buf);
+    return len;
+}
@@ -16,8 +16,10 @@
 
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(3,4,11))
 extern int ReadUsbeStatus(struct file *file,  char __user *buf, size_t count, loff_t *offset);
+extern int ReadUsbeBotStats(struct file *file,  char __user *buf, size_t count, loff_t *offset);
 #else
 extern int ReadUsbeStatus(char *buf, char **start, off_t offset, int count, int *eof, void *data);
+extern int ReadUsbeBotStats(char *buf, char **start, off_t offset, int count, int *eof, void *data);
 #endif
 
 #endif /* _USB_PROC_H_ */
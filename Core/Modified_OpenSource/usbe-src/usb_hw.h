@@ -15,6 +15,7 @@
 
 #include <linux/workqueue.h>
 #include <linux/semaphore.h>
+#include <linux/mm_types.h>
 #include "setup.h"
 #include "bot_if.h"
 #include "iusb.h"
@@ -92,6 +93,7 @@ typedef struct
 	int 	(*DevUsbClearInterfaceAuthKey) (uint8 DevNo, uint8 IfNum);	
 	ssize_t (*DevUsbRead)  (struct file *, char *, size_t, loff_t *);
 	ssize_t (*DevUsbWrite) (struct file * file , const char __user *buf, size_t count, loff_t *ppos);
+	int		(*DevUsbMmap) (unsigned long PgOff, struct vm_area_struct *vma, int* RetVal);
 
 } USB_DEV;
 
@@ -117,6 +119,9 @@ typedef struct
 	int (*iUSBGetCdromInstanceIndex) (void);
 	int (*iUSBReleaseHdiskInstanceIndex) (uint8 Instance);
 	int (*iUSBReleaseCdromInstanceIndex) (uint8 Instance);
+	int (*iUSBScsiSlotResponse) (uint8 DeviceType, uint8 Instance, uint8 Slot);
+	int (*iUSBScsiQueueSlot) (uint8 DeviceType, uint8 Instance, uint8 Slot);
+	int (*iUSBScsiRingMmap) (uint8 DeviceType, uint8 Instance, struct vm_area_struct *vma);
 	
 } USB_IUSB;
 
@@ -32,6 +32,8 @@
 #define USB_CDROM_RES		_IOC(_IOC_WRITE,'U',0x32,0x3FFF)
 #define USB_CDROM_EXIT		_IOC(_IOC_WRITE,'U',0x33,0x3FFF)
 #define USB_CDROM_ACTIVATE	_IOC(_IOC_WRITE,'U',0x34,0x3FFF)
+#define USB_CDROM_RES_SLOT	_IOC(_IOC_WRITE,'U',0x35,0x3FFF)
+#define USB_CDROM_QUEUE_SLOT	_IOC(_IOC_WRITE,'U',0x36,0x3FFF)
 
 
 #define USB_HDISK_REQ		_IOC(_IOC_READ, 'U',0x41,0x3FFF)
@@ -40,6 +42,8 @@
 #define USB_HDISK_ACTIVATE	_IOC(_IOC_WRITE,'U',0x44,0x3FFF)
 #define USB_HDISK_SET_TYPE	_IOC(_IOC_WRITE,'U',0x45,0x3FFF)
 #define USB_HDISK_GET_TYPE	_IOC(_IOC_READ, 'U',0x46,0x3FFF)
+#define USB_HDISK_RES_SLOT	_IOC(_IOC_WRITE,'U',0x47,0x3FFF)
+#define USB_HDISK_QUEUE_SLOT	_IOC(_IOC_WRITE,'U',0x48,0x3FFF)
 
 #define USB_FLOPPY_REQ		_IOC(_IOC_READ, 'U',0x51,0x3FFF)
 #define USB_FLOPPY_RES		_IOC(_IOC_WRITE,'U',0x52,0x3FFF)
@@ -78,6 +82,11 @@
 #define USB_DISABLE_MEDIA_DEVICE _IOC(_IOC_WRITE,'U',0xF7,0x3FFF)
 #define USB_ENABLE_MEDIA_DEVICE _IOC(_IOC_WRITE,'U',0xF8,0x3FFF)
 
+/* mmap page offsets of the virtual media response rings (IUSB_RING_HEADER), by instance */
+#define USB_RING_PGOFF_SHIFT		8
+#define USB_CDROM_RING_PGOFF(Instance)	(0x1000 + ((Instance) << USB_RING_PGOFF_SHIFT))
+#define USB_HDISK_RING_PGOFF(Instance)	(0x2000 + ((Instance) << USB_RING_PGOFF_SHIFT))
+
 #endif  /* USB_IOCTL_H */
 
 /****************************************************************************/